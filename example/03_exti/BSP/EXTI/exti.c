@@ -14,38 +14,32 @@
  * change logs	:
  * version		data		notes
  * V1.0			20240222	the first version
+ * V1.1			20261019	the edges only wake the key sampling up, no delay in the interrupt
  *
  ****************************************************************************************************
  */
 
 
 #include "../EXTI/exti.h"
-#include "../KEY/key.h"
-#include "../LED/led.h"
-#include "../../SYSTEM/delay/delay.h"
+#include "../KEY/key_event.h"
+#include "tim.h"
 
 
 /**
   * @brief  EXTI line rising detection callback.
+  * @note   A key edge only wakes the sampling timer up (TIM6, same preemption priority), the
+  *         debounce and the events are done by key_event_tick. Nothing waits in the interrupt.
   * @param  GPIO_Pin: Specifies the port pin connected to corresponding EXTI line.
   * @retval None
   */
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
-    delay_ms(20);              /* delay 20ms to eliminate chattering */
     switch (GPIO_Pin)
     {
         case KEY0_Pin:
-            if (KEY0 == 1)
-            {
-                LED1_TOGGLE(); /* LED1 state is flipped */
-            }
-            break;
         case WK_UP_Pin:
-            if (WK_UP == 1)
-            {
-                LED0_TOGGLE(); /* LED0 state is flipped */
-            }
+            key_event_wake();
+            HAL_TIM_Base_Start_IT(&htim6);  /* HAL_ERROR if it is already running */
             break;
     }
 }
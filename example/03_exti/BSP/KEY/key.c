@@ -14,6 +14,7 @@
  * change logs  :
  * version      data        notes
  * V1.0	        20240222    the first version
+ * V1.1         20261019    key_read: levels of all the keys for the key event engine
  *
  ****************************************************************************************************
  */
@@ -64,3 +65,25 @@ uint8_t key_scan(uint8_t mode)
 
     return keyval;                            /* return key value */
 }
+
+/**
+ * @brief       Levels of all the keys, no debounce
+ * @param       None
+ * @retval      bit 0: KEY0 pressed, bit 1: WKUP pressed (key numbers of key_event)
+ */
+uint8_t key_read(void)
+{
+    uint8_t raw = 0;
+
+    if (KEY0 == 1)
+    {
+        raw |= 1 << KEY0_NUM;
+    }
+
+    if (WK_UP == 1)
+    {
+        raw |= 1 << WKUP_NUM;
+    }
+
+    return raw;
+}
@@ -14,6 +14,7 @@
  * change logs  :
  * version      data        notes
  * V1.0	        20240222    the first version
+ * V1.1         20261019    key_read: levels of all the keys for the key event engine
  *
  ****************************************************************************************************
  */
@@ -30,7 +31,11 @@
 #define KEY0_PRES    1                                              /* KEY0 is pressed */
 #define WKUP_PRES    2                                              /* KEY_UP is pressed */
 
+#define KEY0_NUM     0                                              /* Key numbers of key_read and key_event */
+#define WKUP_NUM     1
+
 
 uint8_t key_scan(uint8_t mode);                                     /* key scan function */
+uint8_t key_read(void);                                             /* levels of all the keys, bit KEYx_NUM */
 
 #endif                                                              /* BSP_KEY_KEY_H_ */
@@ -0,0 +1,220 @@
+/**
+ ****************************************************************************************************
+ * @file        key_event.c
+ * @author      ALIENTEK
+ * @brief       Timer sampled keys: integrator debounce, press/release/long/repeat/multi-click events
+ *
+ *              A timer calls key_event_tick every KEY_EVT_TICK_MS with the levels of all the keys.
+ *              Each key has an integrator that counts up while the key reads pressed and down while
+ *              it reads released; the key changes state when it reaches KEY_EVT_DEBOUNCE or 0, so a
+ *              bounce only delays the change, and noise shorter than the debounce never makes one.
+ *              The events are put in a queue that the main loop empties with key_event_get.
+ *
+ *              The EXTI lines of the keys only wake the sampling up: key_event_tick returns 0 once
+ *              all the keys are released and settled, the timer is then stopped until the next edge.
+ *
+ *              The queue has one producer (the timer interrupt) and one consumer (the main loop), each
+ *              side only writes its own index, so no interrupt has to be disabled. Nothing here reads
+ *              the hardware, so the engine can be fed with recorded or scripted levels; the time stamp
+ *              of the events comes from KEY_EVT_TIME, which a script can define.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     events stamped with KEY_EVT_TIME (HAL_GetTick), the TIM6 ticks stop when idle
+ *
+ ****************************************************************************************************
+ */
+
+#include "key_event.h"
+
+
+#define KEY_EVT_TICKS(ms)               (((ms) + KEY_EVT_TICK_MS - 1) / KEY_EVT_TICK_MS)
+
+typedef struct
+{
+    uint8_t integ;                      /* Integrator, 0 ~ KEY_EVT_DEBOUNCE */
+    uint8_t down;                       /* Debounced state */
+    uint8_t held;                       /* LONG sent for this press */
+    uint8_t clicks;                     /* Short presses waiting for their CLICK */
+    uint8_t repeats;
+    uint16_t time;                      /* Ticks since the last change (or LONG/REPEAT while held) */
+} key_state_t;
+
+static key_state_t g_key_state[KEY_EVT_NUM];
+static volatile uint8_t g_key_wake = 0;         /* Ticks of sampling left after an EXTI edge */
+
+static key_event_t g_key_evt_queue[KEY_EVT_QUEUE_SIZE];
+static volatile uint16_t g_key_evt_head = 0;    /* Written by the producer only */
+static volatile uint16_t g_key_evt_tail = 0;    /* Written by the consumer only */
+volatile uint32_t g_key_evt_lost = 0;
+
+/**
+ * @brief   Puts an event in the queue
+ * @param   key  : key number
+ * @param   type : event type
+ * @param   count: clicks or repeats
+ * @retval  None
+ */
+static void key_event_push(uint8_t key, uint8_t type, uint8_t count)
+{
+    uint16_t head = g_key_evt_head;
+    key_event_t *evt;
+
+    if ((uint16_t)(head - g_key_evt_tail) >= KEY_EVT_QUEUE_SIZE)
+    {
+        g_key_evt_lost++;
+        return;
+    }
+
+    evt = &g_key_evt_queue[head & (KEY_EVT_QUEUE_SIZE - 1)];
+    evt->time = KEY_EVT_TIME();
+    evt->key = key;
+    evt->type = type;
+    evt->count = count;
+
+    __DMB();                        /* The event is complete before the consumer can see it */
+    g_key_evt_head = head + 1;
+}
+
+/**
+ * @brief   Clears the keys and the queue
+ * @param   None
+ * @retval  None
+ */
+void key_event_init(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < KEY_EVT_NUM; i++)
+    {
+        g_key_state[i].integ = 0;
+        g_key_state[i].down = 0;
+        g_key_state[i].held = 0;
+        g_key_state[i].clicks = 0;
+        g_key_state[i].repeats = 0;
+        g_key_state[i].time = 0;
+    }
+
+    g_key_wake = KEY_EVT_TICKS(KEY_EVT_WAKE_MS);
+    g_key_evt_head = 0;
+    g_key_evt_tail = 0;
+    g_key_evt_lost = 0;
+}
+
+/**
+ * @brief   One sample of all the keys, called every KEY_EVT_TICK_MS
+ * @param   raw: levels, bit i set: key i reads pressed
+ * @retval  1, a key is pressed, settling or waiting for its CLICK: keep sampling; 0, all idle
+ */
+uint8_t key_event_tick(uint8_t raw)
+{
+    key_state_t *k;
+    uint8_t busy = 0;
+    uint8_t i;
+
+    for (i = 0; i < KEY_EVT_NUM; i++)
+    {
+        k = &g_key_state[i];
+
+        if (raw & (1 << i))
+        {
+            if (k->integ < KEY_EVT_DEBOUNCE)k->integ++;
+        }
+        else if (k->integ)
+        {
+            k->integ--;
+        }
+
+        if (k->time < 0xFFFF)k->time++;
+
+        if (k->down == 0 && k->integ == KEY_EVT_DEBOUNCE)
+        {
+            k->down = 1;
+            k->held = 0;
+            k->time = 0;
+            key_event_push(i, KEY_EVT_PRESS, 0);
+        }
+        else if (k->down && k->integ == 0)
+        {
+            k->down = 0;
+            k->time = 0;
+
+            if (k->held == 0 && k->clicks < 0xFF)k->clicks++;
+
+            key_event_push(i, KEY_EVT_RELEASE, 0);
+        }
+        else if (k->down)
+        {
+            if (k->held == 0 && k->time >= KEY_EVT_TICKS(KEY_EVT_LONG_MS))
+            {
+                k->held = 1;
+                k->clicks = 0;      /* A long press ends the clicks before it */
+                k->repeats = 0;
+                k->time = 0;
+                key_event_push(i, KEY_EVT_LONG, 0);
+            }
+            else if (k->held && k->time >= KEY_EVT_TICKS(KEY_EVT_REPEAT_MS))
+            {
+                k->time = 0;
+
+                if (k->repeats < 0xFF)k->repeats++;
+
+                key_event_push(i, KEY_EVT_REPEAT, k->repeats);
+            }
+        }
+        else if (k->clicks && k->time >= KEY_EVT_TICKS(KEY_EVT_CLICK_MS))
+        {
+            key_event_push(i, KEY_EVT_CLICK, k->clicks);
+            k->clicks = 0;
+        }
+
+        if (k->integ || k->down || k->clicks)busy = 1;
+    }
+
+    if (g_key_wake)
+    {
+        g_key_wake--;
+        busy = 1;
+    }
+
+    return busy;
+}
+
+/**
+ * @brief   Keeps the sampling running for KEY_EVT_WAKE_MS
+ * @note    Call it from the EXTI interrupt of the keys, at the same preemption priority as the timer
+ * @param   None
+ * @retval  None
+ */
+void key_event_wake(void)
+{
+    g_key_wake = KEY_EVT_TICKS(KEY_EVT_WAKE_MS);
+}
+
+/**
+ * @brief   Takes the oldest event
+ * @param   evt: event
+ * @retval  0, an event was taken; 1, the queue is empty
+ */
+uint8_t key_event_get(key_event_t *evt)
+{
+    uint16_t tail = g_key_evt_tail;
+
+    if (tail == g_key_evt_head)return 1;
+
+    __DMB();                        /* Read the event after the index that published it */
+    *evt = g_key_evt_queue[tail & (KEY_EVT_QUEUE_SIZE - 1)];
+    __DMB();
+    g_key_evt_tail = tail + 1;
+
+    return 0;
+}
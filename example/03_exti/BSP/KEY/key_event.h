@@ -0,0 +1,64 @@
+/**
+ ****************************************************************************************************
+ * @file        key_event.h
+ * @author      ALIENTEK
+ * @brief       Timer sampled keys: integrator debounce, press/release/long/repeat/multi-click events
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     events stamped with KEY_EVT_TIME (HAL_GetTick), the TIM6 ticks stop when idle
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __KEY_EVENT_H
+#define __KEY_EVENT_H
+
+#include "main.h"
+
+
+#define KEY_EVT_NUM                     2       /* Keys, bit i of the samples is key i (key_read) */
+#define KEY_EVT_TICK_MS                 5       /* Sampling period */
+#define KEY_EVT_DEBOUNCE                4       /* Integrator: 4 samples (20ms) more pressed than released to change state */
+#define KEY_EVT_WAKE_MS                 50      /* Sampling kept after an EXTI edge, the key may still bounce */
+#define KEY_EVT_LONG_MS                 800     /* Held this long: LONG */
+#define KEY_EVT_REPEAT_MS               100     /* Then one REPEAT every period while held */
+#define KEY_EVT_CLICK_MS                300     /* Longest gap between the clicks of a multi-click */
+#define KEY_EVT_QUEUE_SIZE              16      /* Events, must be a power of 2 */
+
+/* Time stamp of the events in ms. Not the sampling ticks: TIM6 stops while the keys are idle */
+#ifndef KEY_EVT_TIME
+#define KEY_EVT_TIME()                  HAL_GetTick()
+#endif
+
+/* Event types */
+#define KEY_EVT_PRESS                   0       /* Debounced press */
+#define KEY_EVT_RELEASE                 1       /* Debounced release */
+#define KEY_EVT_LONG                    2       /* Held for KEY_EVT_LONG_MS, no CLICK for this press */
+#define KEY_EVT_REPEAT                  3       /* Every KEY_EVT_REPEAT_MS after LONG */
+#define KEY_EVT_CLICK                   4       /* KEY_EVT_CLICK_MS after the last short press, count: clicks in a row */
+
+typedef struct
+{
+    uint32_t time;                      /* KEY_EVT_TIME() at the sample that made the event, ms since reset */
+    uint8_t key;                        /* 0 ~ KEY_EVT_NUM - 1 */
+    uint8_t type;                       /* KEY_EVT_PRESS ~ KEY_EVT_CLICK */
+    uint8_t count;                      /* KEY_EVT_CLICK: 1 single, 2 double...; KEY_EVT_REPEAT: repeats so far */
+} key_event_t;
+
+extern volatile uint32_t g_key_evt_lost;                /* Events dropped because the queue was full */
+
+void key_event_init(void);
+uint8_t key_event_tick(uint8_t raw);                    /* One sample of all the keys; 1: sample again, 0: idle */
+void key_event_wake(void);                              /* From the EXTI interrupt of a key */
+uint8_t key_event_get(key_event_t *evt);                /* Takes the oldest event, 0: taken; 1: empty */
+
+#endif
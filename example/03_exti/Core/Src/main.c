@@ -15,18 +15,21 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     keys sampled by TIM6, debounced events from a queue, EXTI as wake-up
  *
  ****************************************************************************************************
  */
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "tim.h"
 #include "gpio.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "../../BSP/LED/led.h"
 #include "../../BSP/KEY/key.h"
+#include "../../BSP/KEY/key_event.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -59,6 +62,48 @@ void SystemClock_Config(void);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+/**
+ * @brief       Acts on a key event
+ * @param       evt : event
+ * @retval      None
+ */
+static void key_action(const key_event_t *evt)
+{
+    if (evt->key == WKUP_NUM)
+    {
+        if (evt->type == KEY_EVT_PRESS)
+        {
+            LED0_TOGGLE();              /* WKUP: LED0 flips at once */
+        }
+    }
+    else if (evt->key == KEY0_NUM)
+    {
+        switch (evt->type)
+        {
+            case KEY_EVT_CLICK:
+                if (evt->count == 1)
+                {
+                    LED1_TOGGLE();      /* Single click: LED1 flips */
+                }
+                else
+                {
+                    LED0(1);            /* Double (or more) click: both off */
+                    LED1(1);
+                }
+                break;
+
+            case KEY_EVT_LONG:
+                LED0(0);                /* Long press: both on */
+                LED1(0);
+                break;
+
+            case KEY_EVT_REPEAT:
+                LED1_TOGGLE();          /* Still held: LED1 blinks */
+                break;
+        }
+    }
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -68,7 +113,7 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-
+    key_event_t evt;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -89,6 +134,7 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_TIM6_Init();
   /* USER CODE BEGIN 2 */
 
   /* USER CODE END 2 */
@@ -98,6 +144,11 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
+    while (key_event_get(&evt) == 0)      /* The events wait in the queue while the loop is busy */
+    {
+      key_action(&evt);
+    }
+
     HAL_Delay(10);     /* delay 10ms */
     /* USER CODE BEGIN 3 */
   }
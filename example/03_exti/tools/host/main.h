@@ -0,0 +1,33 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host build (tools/key_event_check.c): the clock of the scripts for
+ *              KEY_EVT_TIME, nothing of the HAL
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+extern uint32_t g_sim_ms;                       /* ms of the sample being run, tools/key_event_check.c */
+
+#define KEY_EVT_TIME()                  g_sim_ms
+#define __DMB()                         ((void)0)
+
+#endif
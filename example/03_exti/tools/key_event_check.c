@@ -0,0 +1,417 @@
+/**
+ ****************************************************************************************************
+ * @file        key_event_check.c
+ * @author      ALIENTEK
+ * @brief       Host check of BSP/KEY/key_event.c: scripted key levels, exact events and time stamps
+ *
+ *              key_event_tick is called once per sample of a script, the clock of KEY_EVT_TIME
+ *              (tools/host/main.h) moving KEY_EVT_TICK_MS per sample, and the events taken with
+ *              key_event_get are compared with the ones the script expects: type, key, count and the
+ *              sample they come at. The fixed scripts cover bounced presses and releases, noise shorter
+ *              than the debounce, single/double clicks, long presses with repeats, a click followed by
+ *              a long press, two keys at once, the return to idle, key_event_wake and a full queue.
+ *              The random part chains clicks with bounces of random length (seed -s).
+ *
+ *              Build, from example/03_exti:
+ *                  gcc -O2 -Wall -Itools/host -IBSP/KEY -o key_event_check tools/key_event_check.c
+ *
+ *              Run:
+ *                  ./key_event_check [-s seed] [-v]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "main.h"
+#include "../BSP/KEY/key_event.c"
+
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+#define SIM_MAX         2000                    /* Samples of a script */
+#define SIM_T0          0xFFFFF000              /* First time stamp, the ms clock wraps in the long scripts */
+
+typedef struct
+{
+    uint16_t at;                                /* Sample of the event */
+    uint8_t key;
+    uint8_t type;
+    uint8_t count;
+} sim_evt_t;
+
+typedef struct
+{
+    const char *name;
+    const char *key[KEY_EVT_NUM];               /* Levels: "c*n" is n samples of c, other characters one sample each */
+    sim_evt_t evt[32];
+    uint8_t nevt;
+    uint16_t idle;                              /* First sample from which key_event_tick returns 0 */
+} sim_case_t;
+
+uint32_t g_sim_ms;
+static int g_fails = 0;
+static int g_verbose = 0;
+static uint32_t g_seed = 1;
+
+static uint8_t g_raw[SIM_MAX];
+static uint16_t g_len;
+
+static const char *const g_type_name[] = {"PRESS", "RELEASE", "LONG", "REPEAT", "CLICK"};
+
+#define E(at, key, type, count)     {at, key, KEY_EVT_##type, count}
+
+/*
+ * Sample numbers: from idle, n samples of 1 reach the debounce at the nth, so a press starting at s
+ * comes at s + 3; "1101" leaves the integrator at 2 and "0101" after a press at 3. CLICK comes
+ * KEY_EVT_CLICK_MS (60 samples) after the last RELEASE, LONG 160 samples after the PRESS and the
+ * REPEATs every 20 samples after the LONG.
+ */
+static const sim_case_t g_cases[] =
+{
+    {
+        "click, bounced press and release",
+        {"0*5 1101 1*30 0101 0*100", ""},
+        {E(10, 0, PRESS, 0), E(46, 0, RELEASE, 0), E(106, 0, CLICK, 1)}, 3, 106
+    },
+    {
+        "noise shorter than the debounce",
+        {"000 1 000 111 0*5 1101 0*10", ""},
+        {{0}}, 0, 20
+    },
+    {
+        "double click on key 1",
+        {"", "00 1*10 0*20 1*10 0*100"},
+        {E(5, 1, PRESS, 0), E(15, 1, RELEASE, 0), E(35, 1, PRESS, 0), E(45, 1, RELEASE, 0), E(105, 1, CLICK, 2)}, 5, 105
+    },
+    {
+        "clicks too far apart",
+        {"1*4 0*70 1*4 0*70", ""},
+        {E(3, 0, PRESS, 0), E(7, 0, RELEASE, 0), E(67, 0, CLICK, 1),
+         E(77, 0, PRESS, 0), E(81, 0, RELEASE, 0), E(141, 0, CLICK, 1)}, 6, 141
+    },
+    {
+        "long presses with repeats",
+        {"0 1*230 0*10 1*190 0*100", ""},
+        {E(4, 0, PRESS, 0), E(164, 0, LONG, 0), E(184, 0, REPEAT, 1), E(204, 0, REPEAT, 2),
+         E(224, 0, REPEAT, 3), E(234, 0, RELEASE, 0),
+         E(244, 0, PRESS, 0), E(404, 0, LONG, 0), E(424, 0, REPEAT, 1), E(434, 0, RELEASE, 0)}, 10, 434
+    },
+    {
+        "click then long press",
+        {"1*6 0*10 1*200 0*80", ""},
+        {E(3, 0, PRESS, 0), E(9, 0, RELEASE, 0), E(19, 0, PRESS, 0), E(179, 0, LONG, 0),
+         E(199, 0, REPEAT, 1), E(219, 0, RELEASE, 0)}, 6, 219
+    },
+    {
+        "release just before the long time",
+        {"1*158 0*70", ""},
+        {E(3, 0, PRESS, 0), E(161, 0, RELEASE, 0), E(221, 0, CLICK, 1)}, 3, 221
+    },
+    {
+        "two keys at once",
+        {"1*8 0*100", "00 1*170 0*10"},
+        {E(3, 0, PRESS, 0), E(5, 1, PRESS, 0), E(11, 0, RELEASE, 0), E(71, 0, CLICK, 1),
+         E(165, 1, LONG, 0), E(175, 1, RELEASE, 0)}, 6, 175
+    },
+};
+
+/******************************************************************************************/
+/* scripts */
+
+static uint32_t sim_rand(void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return g_seed >> 8;
+}
+
+/**
+ * @brief   Adds the levels of a script to g_raw
+ * @param   key : key number
+ * @param   text: levels
+ * @retval  None
+ */
+static void sim_parse(uint8_t key, const char *text)
+{
+    uint16_t at = 0;
+    uint16_t n;
+    char c;
+
+    while (*text)
+    {
+        c = *text++;
+
+        if (c == ' ')continue;
+
+        n = 1;
+
+        if (*text == '*')
+        {
+            n = (uint16_t)strtoul(text + 1, (char **)&text, 10);
+        }
+
+        while (n--)
+        {
+            if (at >= SIM_MAX)break;
+
+            if (c == '1')g_raw[at] |= 1 << key;
+
+            at++;
+        }
+    }
+
+    if (at > g_len)g_len = at;
+}
+
+/**
+ * @brief   Runs g_raw and compares the events
+ * @param   name: script name
+ * @param   evt : events expected
+ * @param   nevt: number of events
+ * @param   idle: first sample from which key_event_tick returns 0
+ * @retval  None
+ */
+static void sim_run(const char *name, const sim_evt_t *evt, uint16_t nevt, uint16_t idle)
+{
+    key_event_t got;
+    uint16_t last_busy = 0;
+    uint16_t n = 0;
+    uint16_t i;
+
+    key_event_init();
+
+    for (i = 0; i < g_len; i++)
+    {
+        g_sim_ms = SIM_T0 + i * KEY_EVT_TICK_MS;
+
+        if (key_event_tick(g_raw[i]))last_busy = i + 1;
+
+        while (key_event_get(&got) == 0)
+        {
+            if (g_verbose)printf("  %5u key%u %-7s %u\n", i, got.key, g_type_name[got.type], got.count);
+
+            if (n < nevt)
+            {
+                CHECK(got.type == evt[n].type && got.key == evt[n].key && got.count == evt[n].count,
+                      "%s: event %u is key%u %s %u, expected key%u %s %u", name, n,
+                      got.key, g_type_name[got.type], got.count, evt[n].key, g_type_name[evt[n].type], evt[n].count);
+                CHECK(i == evt[n].at, "%s: event %u at sample %u, expected %u", name, n, i, evt[n].at);
+                CHECK(got.time == SIM_T0 + evt[n].at * KEY_EVT_TICK_MS, "%s: event %u stamped %u", name, n, (unsigned)got.time);
+            }
+
+            n++;
+        }
+    }
+
+    CHECK(n == nevt, "%s: %u events, expected %u", name, n, nevt);
+    CHECK(last_busy == idle, "%s: idle from sample %u, expected %u", name, last_busy, idle);
+    CHECK(g_key_evt_lost == 0, "%s: %u events lost", name, (unsigned)g_key_evt_lost);
+}
+
+/******************************************************************************************/
+/* checks */
+
+/**
+ * @brief   The fixed scripts
+ * @param   None
+ * @retval  None
+ */
+static void check_cases(void)
+{
+    uint8_t c, k;
+
+    for (c = 0; c < sizeof(g_cases) / sizeof(g_cases[0]); c++)
+    {
+        if (g_verbose)printf("%s\n", g_cases[c].name);
+
+        memset(g_raw, 0, sizeof(g_raw));
+        g_len = 0;
+
+        for (k = 0; k < KEY_EVT_NUM; k++)
+        {
+            sim_parse(k, g_cases[c].key[k]);
+        }
+
+        sim_run(g_cases[c].name, g_cases[c].evt, g_cases[c].nevt, g_cases[c].idle);
+    }
+}
+
+/**
+ * @brief   key_event_wake keeps the sampling for KEY_EVT_WAKE_MS without events
+ * @param   None
+ * @retval  None
+ */
+static void check_wake(void)
+{
+    key_event_t got;
+    uint8_t i;
+
+    key_event_init();
+
+    for (i = 0; i < KEY_EVT_TICKS(KEY_EVT_WAKE_MS); i++)
+    {
+        CHECK(key_event_tick(0) == 1, "wake: init, tick %u idle", i);
+    }
+
+    CHECK(key_event_tick(0) == 0, "wake: init, busy after %u ticks", i);
+
+    key_event_wake();
+
+    for (i = 0; i < KEY_EVT_TICKS(KEY_EVT_WAKE_MS); i++)
+    {
+        CHECK(key_event_tick(0) == 1, "wake: tick %u idle", i);
+    }
+
+    CHECK(key_event_tick(0) == 0, "wake: busy after %u ticks", i);
+    CHECK(key_event_get(&got) == 1, "wake: event without a key");
+}
+
+/**
+ * @brief   A press held without reading the queue: the first KEY_EVT_QUEUE_SIZE events are kept, the
+ *          others counted in g_key_evt_lost, the repeat count goes on
+ * @param   None
+ * @retval  None
+ */
+static void check_overflow(void)
+{
+    key_event_t got;
+    uint16_t n = 0;
+    uint16_t i;
+
+    key_event_init();
+
+    for (i = 0; i < 610; i++)
+    {
+        g_sim_ms = i;
+        key_event_tick(i < 600);        /* PRESS at 3, LONG at 163, REPEAT 1 ~ 21 at 183 ~ 583, RELEASE at 603 */
+    }
+
+    CHECK(g_key_evt_lost == 24 - KEY_EVT_QUEUE_SIZE, "overflow: %u lost", (unsigned)g_key_evt_lost);
+
+    while (key_event_get(&got) == 0)
+    {
+        if (n == 0)CHECK(got.type == KEY_EVT_PRESS && got.time == 3, "overflow: first %s at %u", g_type_name[got.type], (unsigned)got.time);
+        else if (n == 1)CHECK(got.type == KEY_EVT_LONG && got.time == 163, "overflow: second %s at %u", g_type_name[got.type], (unsigned)got.time);
+        else CHECK(got.type == KEY_EVT_REPEAT && got.count == n - 1 && got.time == 183 + (n - 2) * 20,
+                   "overflow: event %u %s %u at %u", n, g_type_name[got.type], got.count, (unsigned)got.time);
+
+        n++;
+    }
+
+    CHECK(n == KEY_EVT_QUEUE_SIZE, "overflow: %u events", n);
+    CHECK(g_key_state[0].repeats == 21, "overflow: %u repeats", g_key_state[0].repeats);
+
+    /* the queue works again once emptied */
+    key_event_tick(1);
+    for (i = 0; i < 4; i++)key_event_tick(1);
+    CHECK(key_event_get(&got) == 0 && got.type == KEY_EVT_PRESS, "overflow: no PRESS after the queue is emptied");
+}
+
+/**
+ * @brief   Random chains of clicks on both keys: bounces of random length on each edge, presses
+ *          shorter than the long time, gaps shorter or longer than the click time
+ * @param   None
+ * @retval  None
+ */
+static void check_random(void)
+{
+    sim_evt_t evt[64];
+    uint16_t nevt;
+    uint16_t at, idle;
+    uint16_t edge;
+    uint8_t clicks;
+    uint8_t run, key, n, i;
+    int fails = g_fails;
+
+    for (run = 0; run < 200; run++)
+    {
+        memset(g_raw, 0, sizeof(g_raw));
+        key = sim_rand() % KEY_EVT_NUM;
+        nevt = 0;
+        clicks = 0;
+        at = sim_rand() % 20;
+
+        for (n = 1 + sim_rand() % 8; n; n--)
+        {
+            for (i = sim_rand() % 4; i; i--)            /* "10" pairs: the integrator stays at 0 or 1 */
+            {
+                g_raw[at++] = 1 << key;
+                at++;
+            }
+
+            edge = at + 3;
+            evt[nevt++] = (sim_evt_t){edge, key, KEY_EVT_PRESS, 0};
+
+            for (i = 4 + sim_rand() % 140; i; i--)      /* shorter than the long time from edge */
+            {
+                g_raw[at++] = 1 << key;
+            }
+
+            for (i = sim_rand() % 4; i; i--)            /* "01" pairs: the integrator stays at 3 or 4 */
+            {
+                at++;
+                g_raw[at++] = 1 << key;
+            }
+
+            edge = at + 3;
+            evt[nevt++] = (sim_evt_t){edge, key, KEY_EVT_RELEASE, 0};
+            clicks++;
+
+            /* the next press reaches the debounce before the CLICK or well after it */
+            if (n > 1 && sim_rand() % 3)
+            {
+                at = edge + 1 + sim_rand() % 40;
+            }
+            else
+            {
+                evt[nevt++] = (sim_evt_t){edge + 60, key, KEY_EVT_CLICK, clicks};
+                clicks = 0;
+                at = edge + 61 + sim_rand() % 40;
+            }
+        }
+
+        idle = evt[nevt - 1].at;
+        g_len = at + 10;
+
+        if (g_verbose)printf("random %u\n", run);
+
+        sim_run("random", evt, nevt, idle);
+
+        if (g_fails != fails)
+        {
+            printf("  random run %u, seed %u\n", run, (unsigned)g_seed);
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)g_seed = (uint32_t)strtoul(argv[++i], 0, 0);
+        else if (strcmp(argv[i], "-v") == 0)g_verbose = 1;
+    }
+
+    check_cases();
+    check_wake();
+    check_overflow();
+    check_random();
+
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+    return g_fails ? 1 : 0;
+}
@@ -29,13 +29,16 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "../../ATK_Middlewares/ICAP/icap.h"
 /* USER CODE END Includes */
 
 extern TIM_HandleTypeDef htim5;
 
 /* USER CODE BEGIN Private defines */
 
+extern icap_stream_t g_icap_rise;
+extern icap_stream_t g_icap_fall;
+
 /* USER CODE END Private defines */
 
 void MX_TIM5_Init(void);
@@ -15,12 +15,14 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     DMA capture of both edges, 32-bit timestamps and batch statistics
  *
  ****************************************************************************************************
  */
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "tim.h"
 #include "usart.h"
 #include "gpio.h"
@@ -33,8 +35,7 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
-extern uint8_t  g_timxchy_cap_sta;  /* Input capture state. */
-extern uint16_t g_timxchy_cap_val;  /* Input capture value. */
+
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
@@ -71,8 +72,15 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-  uint32_t temp = 0;
+  static uint32_t rise[ICAP_TS_LEN];
+  static uint32_t fall[ICAP_TS_LEN];
+  icap_stat_t st;
+  uint32_t tick_hz, freq;
+  uint32_t last_rise = 0;
+  uint8_t have_rise = 0;
+  uint16_t nr, nf, i, j;
   uint8_t t = 0;
+  uint8_t s = 0;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -93,10 +101,11 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_TIM5_Init();
   /* USER CODE BEGIN 2 */
-
+  tick_hz = icap_tick_hz(&htim5);       /* 72MHz, 13.9ns per tick */
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -104,13 +113,45 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-    if (g_timxchy_cap_sta & 0X80)
+    nr = icap_read(&g_icap_rise, rise, ICAP_TS_LEN);
+    nf = icap_read(&g_icap_fall, fall, ICAP_TS_LEN);
+    j = 0;
+
+    for (i = 0; i < nf; i++)            /* Pairs each falling edge with the rising edge before it */
+    {
+      while (j < nr && (int32_t)(rise[j] - fall[i]) < 0)
+      {
+        last_rise = rise[j++];
+        have_rise = 1;
+      }
+
+      if (have_rise && nf <= 4)         /* Slow pulses such as a WKUP press, a fast signal gets the statistics */
+      {
+        printf("HIGH:%lu us\r\n", (unsigned long)((uint64_t)(fall[i] - last_rise) * 1000000 / tick_hz));
+      }
+
+      have_rise = 0;
+    }
+
+    while (j < nr)
+    {
+      last_rise = rise[j++];
+      have_rise = 1;
+    }
+
+    if (++s >= 100)                     /* Statistics of the rising edges every second */
     {
-      temp = g_timxchy_cap_sta & 0X3F;
-      temp *= 65536;
-      temp += g_timxchy_cap_val;
-      printf("HIGH:%d us\r\n", (unsigned int)temp);
-      g_timxchy_cap_sta = 0;
+      s = 0;
+      icap_stat(&g_icap_rise, &st);
+
+      if (st.count >= 10)
+      {
+        freq = icap_freq(&st, tick_hz);
+        printf("FREQ:%lu.%03lu Hz PERIOD:%lu ns JITTER:%lu ns MIN:%lu MAX:%lu ticks\r\n",
+               (unsigned long)(freq / 1000), (unsigned long)(freq % 1000),
+               (unsigned long)icap_mean(&st, tick_hz), (unsigned long)icap_jitter(&st, tick_hz),
+               (unsigned long)st.min, (unsigned long)st.max);
+      }
     }
 
     t++;
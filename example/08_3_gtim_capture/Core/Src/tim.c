@@ -22,9 +22,14 @@
 
 /* USER CODE BEGIN 0 */
 
+icap_stream_t g_icap_rise;      /* PA0 rising edges, TIM5 channel 1 */
+icap_stream_t g_icap_fall;      /* PA0 falling edges, TIM5 channel 2 */
+
 /* USER CODE END 0 */
 
 TIM_HandleTypeDef htim5;
+DMA_HandleTypeDef hdma_tim5_ch1;
+DMA_HandleTypeDef hdma_tim5_ch2;
 
 /* TIM5 init function */
 void MX_TIM5_Init(void)
@@ -42,7 +47,7 @@ void MX_TIM5_Init(void)
 
   /* USER CODE END TIM5_Init 1 */
   htim5.Instance = TIM5;
-  htim5.Init.Prescaler = 72 - 1;
+  htim5.Init.Prescaler = 0;
   htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
   htim5.Init.Period = 65535;
   htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
@@ -74,9 +79,16 @@ void MX_TIM5_Init(void)
   {
     Error_Handler();
   }
+  sConfigIC.ICPolarity = TIM_INPUTCHANNELPOLARITY_FALLING;
+  sConfigIC.ICSelection = TIM_ICSELECTION_INDIRECTTI;
+  if (HAL_TIM_IC_ConfigChannel(&htim5, &sConfigIC, TIM_CHANNEL_2) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE BEGIN TIM5_Init 2 */
-  __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_UPDATE);     	/* Enable update interrupts */
-   HAL_TIM_IC_Start_IT(&htim5, TIM_CHANNEL_1);    	/* Start capturing channel 1 of TIM5 */
+  icap_init(&g_icap_rise, &htim5, TIM_CHANNEL_1, &hdma_tim5_ch1, ICAP_EDGE);
+  icap_init(&g_icap_fall, &htim5, TIM_CHANNEL_2, &hdma_tim5_ch2, ICAP_EDGE);
+  icap_start(&htim5);                               /* Channel 3 interrupts at half the counter period */
   /* USER CODE END TIM5_Init 2 */
 
 }
@@ -102,6 +114,39 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* tim_baseHandle)
     GPIO_InitStruct.Pull = GPIO_PULLDOWN;
     HAL_GPIO_Init(WK_UP_GPIO_Port, &GPIO_InitStruct);
 
+    /* TIM5 DMA Init */
+    /* TIM5_CH1 Init */
+    hdma_tim5_ch1.Instance = DMA2_Channel5;
+    hdma_tim5_ch1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_tim5_ch1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim5_ch1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim5_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim5_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim5_ch1.Init.Mode = DMA_CIRCULAR;
+    hdma_tim5_ch1.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_tim5_ch1) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(tim_baseHandle,hdma[TIM_DMA_ID_CC1],hdma_tim5_ch1);
+
+    /* TIM5_CH2 Init */
+    hdma_tim5_ch2.Instance = DMA2_Channel4;
+    hdma_tim5_ch2.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_tim5_ch2.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim5_ch2.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim5_ch2.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim5_ch2.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim5_ch2.Init.Mode = DMA_CIRCULAR;
+    hdma_tim5_ch2.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_tim5_ch2) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(tim_baseHandle,hdma[TIM_DMA_ID_CC2],hdma_tim5_ch2);
+
     /* TIM5 interrupt Init */
     HAL_NVIC_SetPriority(TIM5_IRQn, 2, 1);
     HAL_NVIC_EnableIRQ(TIM5_IRQn);
@@ -127,6 +172,10 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* tim_baseHandle)
     */
     HAL_GPIO_DeInit(WK_UP_GPIO_Port, WK_UP_Pin);
 
+    /* TIM5 DMA DeInit */
+    HAL_DMA_DeInit(tim_baseHandle->hdma[TIM_DMA_ID_CC1]);
+    HAL_DMA_DeInit(tim_baseHandle->hdma[TIM_DMA_ID_CC2]);
+
     /* TIM5 interrupt Deinit */
     HAL_NVIC_DisableIRQ(TIM5_IRQn);
   /* USER CODE BEGIN TIM5_MspDeInit 1 */
@@ -137,77 +186,29 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* tim_baseHandle)
 
 /* USER CODE BEGIN 1 */
 
-/* Input captured state (g_timxchy_cap_sta)
- * [7] :0, no capture was successful; 1, one successful capture.
- * [6] :0, the high level has not been captured yet; 1, the high level has been captured.
- * [5:0]: The number of overflows after capturing high levels. The maximum number of overflows is 63, so the maximum captured value is = 63*65536 + 65535 = 4194303
- * Note: For generality, we default ARR and CCRy to 16-bit registers, and only use 16-bit for 32-bit timers like TIM5
- * The maximum overflow time at 1us counting frequency is :4194303 us, about 4.19 seconds
- *
- * (Note: For normal 32-bit timers,1us counter incrementing by 1, overflow time :4294 seconds)
- */
-uint8_t g_timxchy_cap_sta = 0;    /* Input capture state. */
-uint16_t g_timxchy_cap_val = 0;   /* Input capture value. */
-
 /**
-  * @brief  Input Capture callback in non-blocking mode
-  * @param  htim TIM IC handle
+  * @brief  Period elapsed callback in non-blocking mode
+  * @param  htim TIM handle
   * @retval None
   */
-void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
     if (htim->Instance == TIM5)
     {
-        if ((g_timxchy_cap_sta & 0X80) == 0)                  /* No capture yet. */
-        {
-            if (g_timxchy_cap_sta & 0X40)                     /* A falling edge is captured. */
-            {
-                g_timxchy_cap_sta |= 0X80;                    /* The marker successfully captured one high level pulse width. */
-                g_timxchy_cap_val = HAL_TIM_ReadCapturedValue(&htim5, TIM_CHANNEL_1);  /* Gets the current capture value. */
-                TIM_RESET_CAPTUREPOLARITY(&htim5, TIM_CHANNEL_1); /* Be sure to clear the original Settings first */
-                __HAL_TIM_SET_CAPTUREPOLARITY(&htim5, TIM_CHANNEL_1, TIM_INPUTCHANNELPOLARITY_RISING);/* Configure TIM5 channel 1 rising edge capture. */
-            }
-            else /* Not yet started, first capture rising edge */
-            {
-                g_timxchy_cap_sta = 0;                      /* clear */
-                g_timxchy_cap_val = 0;
-                g_timxchy_cap_sta |= 0X40;                  /* The marker has captured the rising edge. */
-                __HAL_TIM_DISABLE(&htim5);                  /* Turn off timer 5 */
-                __HAL_TIM_SET_COUNTER(&htim5, 0);           /* Timer 5 The counter is cleared */
-                TIM_RESET_CAPTUREPOLARITY(&htim5, TIM_CHANNEL_1); /* Be sure to clear the original Settings first */
-                __HAL_TIM_SET_CAPTUREPOLARITY(&htim5, TIM_CHANNEL_1, TIM_INPUTCHANNELPOLARITY_FALLING);/* Timer 5 Channel 1 is set to falling edge capture */
-                __HAL_TIM_ENABLE(&htim5);                   /* Enable timer 5 */
-            }
-        }
+        icap_update(htim);                          /* Extends the timestamps past the 16-bit counter */
     }
 }
 
 /**
-  * @brief  Period elapsed callback in non-blocking mode
-  * @param  htim TIM handle
+  * @brief  Output Compare callback in non-blocking mode
+  * @param  htim TIM OC handle
   * @retval None
   */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
 {
     if (htim->Instance == TIM5)
     {
-        if ((g_timxchy_cap_sta & 0X80) == 0)            /* No capture yet */
-        {
-            if (g_timxchy_cap_sta & 0X40)               /* High levels have been captured */
-            {
-                if ((g_timxchy_cap_sta & 0X3F) == 0X3F) /* The high level is too long */
-                {
-                	TIM_RESET_CAPTUREPOLARITY(&htim5, TIM_CHANNEL_1); /* Be sure to clear the original Settings first */
-                	__HAL_TIM_SET_CAPTUREPOLARITY(&htim5, TIM_CHANNEL_1, TIM_INPUTCHANNELPOLARITY_RISING);/* Configure TIM5 channel 1 rising edge capture */
-                    g_timxchy_cap_sta |= 0X80;          /* The tag was successfully captured once */
-                    g_timxchy_cap_val = 0XFFFF;
-                }
-                else      /* Accumulate the number of timer overflows */
-                {
-                    g_timxchy_cap_sta++;
-                }
-            }
-        }
+        icap_half(htim);                            /* Half of the counter period */
     }
 }
 
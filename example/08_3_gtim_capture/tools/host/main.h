@@ -0,0 +1,128 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host build (tools/icap_sim.c): the TIM and DMA parts of the HAL that
+ *              icap.c uses, with the register layout of the STM32F1
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR = 1
+} HAL_StatusTypeDef;
+
+/* General purpose and advanced timers, offsets 0x00 ~ 0x4C */
+typedef struct
+{
+    volatile uint32_t CR1;
+    volatile uint32_t CR2;
+    volatile uint32_t SMCR;
+    volatile uint32_t DIER;
+    volatile uint32_t SR;
+    volatile uint32_t EGR;
+    volatile uint32_t CCMR1;
+    volatile uint32_t CCMR2;
+    volatile uint32_t CCER;
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+    volatile uint32_t RCR;
+    volatile uint32_t CCR1;
+    volatile uint32_t CCR2;
+    volatile uint32_t CCR3;
+    volatile uint32_t CCR4;
+    volatile uint32_t BDTR;
+    volatile uint32_t DCR;
+    volatile uint32_t DMAR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uint32_t CPAR;
+    volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+    DMA_Channel_TypeDef *Instance;
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t OCMode;
+    uint32_t Pulse;
+    uint32_t OCPolarity;
+    uint32_t OCNPolarity;
+    uint32_t OCFastMode;
+    uint32_t OCIdleState;
+    uint32_t OCNIdleState;
+} TIM_OC_InitTypeDef;
+
+#define TIM_CR1_CEN                     0x0001
+#define TIM_CR1_URS                     0x0004
+#define TIM_CHANNEL_1                   0x0000
+#define TIM_CHANNEL_2                   0x0004
+#define TIM_CHANNEL_3                   0x0008
+#define TIM_CHANNEL_4                   0x000C
+#define TIM_CCx_ENABLE                  0x0001
+#define TIM_CCx_DISABLE                 0x0000
+#define TIM_OCMODE_TIMING               0x0000
+#define TIM_FLAG_UPDATE                 0x0001
+#define TIM_FLAG_CC1                    0x0002
+#define TIM_IT_UPDATE                   0x0001
+#define TIM_IT_CC1                      0x0002
+#define TIM_DMA_CC1                     0x0200
+
+#define __HAL_TIM_GET_COUNTER(h)        ((h)->Instance->CNT)
+#define __HAL_TIM_SET_COUNTER(h, v)     ((h)->Instance->CNT = (v))
+#define __HAL_TIM_ENABLE(h)             ((h)->Instance->CR1 |= TIM_CR1_CEN)
+#define __HAL_TIM_DISABLE(h)            ((h)->Instance->CR1 &= ~TIM_CR1_CEN)
+#define __HAL_TIM_URS_ENABLE(h)         ((h)->Instance->CR1 |= TIM_CR1_URS)
+#define __HAL_TIM_ENABLE_IT(h, i)       ((h)->Instance->DIER |= (i))
+#define __HAL_TIM_DISABLE_IT(h, i)      ((h)->Instance->DIER &= ~(i))
+#define __HAL_TIM_ENABLE_DMA(h, d)      ((h)->Instance->DIER |= (d))
+#define __HAL_TIM_DISABLE_DMA(h, d)     ((h)->Instance->DIER &= ~(d))
+#define __HAL_TIM_CLEAR_FLAG(h, f)      ((h)->Instance->SR &= ~(f))     /* rc_w0 */
+#define __HAL_DMA_GET_COUNTER(h)        ((h)->Instance->CNDTR)
+
+/* The interrupts of the model run one at a time, to completion */
+#define __DMB()                         ((void)0)
+#define __disable_irq()                 ((void)0)
+#define __enable_irq()                  ((void)0)
+
+/* tools/icap_sim.c */
+void TIM_CCxChannelCmd(TIM_TypeDef *TIMx, uint32_t Channel, uint32_t ChannelState);
+HAL_StatusTypeDef HAL_TIM_OC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+
+#endif
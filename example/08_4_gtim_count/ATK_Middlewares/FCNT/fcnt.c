@@ -0,0 +1,466 @@
+/**
+ ****************************************************************************************************
+ * @file        fcnt.c
+ * @author      ALIENTEK
+ * @brief       Frequency counter: chained 32-bit counter, hardware gate and reciprocal counting
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     the high counter is read again when the low one has just overflowed
+ *
+ ****************************************************************************************************
+ */
+
+#include <stddef.h>
+#include "fcnt.h"
+
+
+/*
+ * The low counter is clocked by ETR (external clock mode 2), so its slave mode controller stays free:
+ * TS selects the gate timer as TRC and CH1 captures the count at each gate edge, with no CPU and no
+ * dead time. The high counter is clocked by the overflows of the low one. The count at a gate is
+ * rebuilt from the capture and a consistent read of both counters, as long as the capture interrupt
+ * comes within 65536 input cycles.
+ *
+ * In FCNT_RECIPROCAL the ARR of the low counter and the PSC of the gate timer are preloaded: values
+ * written at the end of a block are used from the end of the next one, hence the run/next pairs.
+ *
+ * The ETR input is sampled by the timer clock, the input frequency must stay below FCNT_TIM_CLK / 4.
+ */
+
+static fcnt_t *g_fcnt_dev;
+
+/**
+ * @brief       Reads the 32-bit count of the chained counters
+ * @note        The high counter counts an overflow of the low one FCNT_CHAIN_LAG timer clocks late at most.
+ *              The input edges are 4 timer clocks apart at least, so with a low count of FCNT_CHAIN_LAG / 4
+ *              or more the overflow has reached high. Below, high is read again until FCNT_CHAIN_LAG clocks
+ *              have passed since low was read: each access to a timer takes one APB1 clock, 2 timer clocks.
+ * @param       f : frequency counter
+ * @retval      Count
+ */
+static uint32_t fcnt_hw(fcnt_t *f)
+{
+    TIM_TypeDef *low = f->low->Instance;
+    TIM_TypeDef *high = f->high->Instance;
+    uint32_t l, h;
+    uint8_t i;
+
+    do
+    {
+        l = low->CNT;
+        h = high->CNT;
+
+        if (l < FCNT_CHAIN_LAG / 4)         /* The overflow may not have reached high yet */
+        {
+            for (i = 0; i < FCNT_CHAIN_LAG / 2; i++)
+            {
+                h = high->CNT;
+            }
+        }
+    } while (low->CNT < l);                 /* low overflowed in between */
+
+    return (h << 16) | l;
+}
+
+/**
+ * @brief       Adds the contents of the counters to the total before they are cleared
+ * @param       f : frequency counter
+ * @retval      None
+ */
+static void fcnt_fold(fcnt_t *f)
+{
+    if (f->mode == FCNT_COUNT)
+    {
+        f->base += fcnt_hw(f);
+    }
+    else
+    {
+        f->base += f->low->Instance->CNT;   /* The blocks are added at their end */
+    }
+}
+
+/**
+ * @brief       Publishes a reading
+ * @param       f : frequency counter
+ * @param       mode : FCNT_COUNT / FCNT_RECIPROCAL
+ * @param       cycles : input cycles
+ * @param       clk : their time, in periods of FCNT_TIM_CLK
+ * @param       ppm : resolution
+ * @retval      None
+ */
+static void fcnt_publish(fcnt_t *f, uint8_t mode, uint32_t cycles, uint32_t clk, uint32_t ppm)
+{
+    f->res.mode = mode;
+    f->res.cycles = cycles;
+    f->res.clk = clk;
+    f->res.ppm = ppm;
+    f->seq++;
+}
+
+/**
+ * @brief       Prescaler of the gate timer for a block
+ * @param       f : frequency counter
+ * @param       blk : expected time of the block, in periods of FCNT_TIM_CLK
+ * @retval      Prescaler, the block lasts 16384 ~ 32768 ticks
+ */
+static uint16_t fcnt_psc(fcnt_t *f, uint64_t blk)
+{
+    blk /= 32768;
+
+    return (blk > f->psc_max) ? f->psc_max : (uint16_t)blk;
+}
+
+/**
+ * @brief       Restarts in FCNT_COUNT
+ * @param       f : frequency counter
+ * @retval      None
+ */
+static void fcnt_count_mode(fcnt_t *f)
+{
+    TIM_TypeDef *low = f->low->Instance;
+    TIM_TypeDef *gate = f->gate->Instance;
+
+    gate->DIER &= ~(TIM_DIER_CC1IE | TIM_DIER_UIE);
+    gate->CR1 &= ~TIM_CR1_CEN;
+    low->ARR = 0xFFFF;
+    low->EGR = TIM_EGR_UG;                  /* Loads ARR and clears the count */
+    gate->SMCR &= ~TIM_SMCR_SMS;            /* Runs freely */
+    gate->PSC = FCNT_GATE_PSC;
+    gate->ARR = f->gate_ms * 10 - 1;
+    f->high->Instance->CNT = 0;             /* After the overflow of the UG of low */
+
+    f->mode = FCNT_COUNT;
+    f->skip = 1;                            /* No count at the start of the first gate */
+    gate->EGR = TIM_EGR_UG;                 /* Loads PSC and ARR */
+    low->SR = ~TIM_SR_CC1IF;
+    low->DIER |= TIM_DIER_CC1IE;
+    gate->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief       Restarts in FCNT_RECIPROCAL
+ * @param       f : frequency counter
+ * @param       k : input cycles per block
+ * @param       psc : prescaler of the gate timer
+ * @retval      None
+ */
+static void fcnt_recip_mode(fcnt_t *f, uint16_t k, uint16_t psc)
+{
+    TIM_TypeDef *low = f->low->Instance;
+    TIM_TypeDef *gate = f->gate->Instance;
+
+    low->DIER &= ~TIM_DIER_CC1IE;
+    gate->CR1 &= ~TIM_CR1_CEN;
+    gate->SMCR = (gate->SMCR & ~TIM_SMCR_SMS) | TIM_SLAVEMODE_RESET;   /* Reset by the overflows of low */
+    gate->PSC = psc;
+    gate->ARR = 0xFFFF;
+    low->ARR = k - 1;
+    f->k_run = f->k_next = k;
+    f->psc_run = f->psc_next = psc;
+
+    f->mode = FCNT_RECIPROCAL;
+    f->skip = 2;                            /* The capture of the UG below, then a block started by it */
+    gate->SR = 0;
+    gate->DIER |= TIM_DIER_CC1IE | TIM_DIER_UIE;
+    gate->CR1 |= TIM_CR1_CEN;
+    low->EGR = TIM_EGR_UG;                  /* Loads ARR, clears the count and resets the gate timer */
+}
+
+/**
+ * @brief       End of a gate in FCNT_COUNT
+ * @param       f : frequency counter
+ * @retval      None
+ */
+static void fcnt_gate_count(fcnt_t *f)
+{
+    uint16_t c = f->low->Instance->CCR1;    /* Low half of the count at the gate */
+    uint32_t n, cycles;
+
+    n = fcnt_hw(f);
+    n -= (uint16_t)(n - c);                 /* Back to the gate, less than 65536 cycles ago */
+
+    if (f->skip)
+    {
+        f->skip = 0;
+        f->last = n;
+        return;
+    }
+
+    cycles = n - f->last;
+    f->last = n;
+    fcnt_publish(f, FCNT_COUNT, cycles, f->gate_clk, cycles ? 1000000 / cycles : 1000000);
+
+    if (cycles < FCNT_CYCLES_MAX / 2)      /* The reciprocal resolution is better */
+    {
+        fcnt_fold(f);
+        fcnt_recip_mode(f, cycles ? cycles : 1, fcnt_psc(f, f->gate_clk));
+    }
+}
+
+/**
+ * @brief       End of a block in FCNT_RECIPROCAL
+ * @param       f : frequency counter
+ * @retval      None
+ */
+static void fcnt_gate_recip(fcnt_t *f)
+{
+    TIM_TypeDef *gate = f->gate->Instance;
+    uint16_t k = f->k_run;                  /* The block that ended */
+    uint16_t psc = f->psc_run;
+    uint32_t ticks, clk, n;
+
+    ticks = gate->CCR1 + ((psc == 0) ? 2 : 1);  /* Reset by the slave mode takes a tick, and one more without prescaler */
+    f->k_run = f->k_next;
+    f->psc_run = f->psc_next;
+
+    if (f->skip)
+    {
+        if (--f->skip == 0)f->base += k;    /* The block started by the UG has k cycles too */
+
+        return;
+    }
+
+    f->base += k;
+    clk = ticks * (psc + 1);
+    fcnt_publish(f, FCNT_RECIPROCAL, k, clk, (1000000 + ticks - 1) / ticks);
+
+    n = ((uint64_t)k * f->gate_clk + clk / 2) / clk;   /* Cycles per gate */
+
+    if (n > FCNT_CYCLES_MAX)                /* The count resolution is better */
+    {
+        fcnt_fold(f);
+        fcnt_count_mode(f);
+        return;
+    }
+
+    if (n == 0)n = 1;                       /* Periods longer than the gate */
+
+    f->k_next = n;
+    f->psc_next = fcnt_psc(f, (uint64_t)clk * n / k);
+    f->low->Instance->ARR = n - 1;
+    gate->PSC = f->psc_next;
+}
+
+/**
+ * @brief       Sets the frequency counter up
+ * @param       f : frequency counter
+ * @param       low : counts the input on its ETR pin, TRGO to high and gate (FCNT_TS_xxx)
+ * @param       high : counts the overflows of low
+ * @param       gate : gate timer, TRGO to low
+ * @retval      None
+ */
+void fcnt_init(fcnt_t *f, TIM_HandleTypeDef *low, TIM_HandleTypeDef *high, TIM_HandleTypeDef *gate)
+{
+    f->low = low;
+    f->high = high;
+    f->gate = gate;
+    f->mode = FCNT_COUNT;
+    f->seq = f->seq_rd = 0;
+    g_fcnt_dev = f;
+}
+
+/**
+ * @brief       Starts counting, in FCNT_COUNT. The total is cleared.
+ * @param       f : frequency counter
+ * @param       gate_ms : gate, 1 ~ FCNT_GATE_MAX. There is one reading per gate, or per input
+ *                        period when it is longer.
+ * @retval      0, OK; 1, bad gate
+ */
+uint8_t fcnt_start(fcnt_t *f, uint16_t gate_ms)
+{
+    TIM_TypeDef *low = f->low->Instance;
+    TIM_TypeDef *high = f->high->Instance;
+    TIM_TypeDef *gate = f->gate->Instance;
+    uint32_t psc;
+
+    if (gate_ms == 0 || gate_ms > FCNT_GATE_MAX)return 1;
+
+    fcnt_stop(f);
+    f->gate_ms = gate_ms;
+    f->gate_clk = (uint32_t)gate_ms * (FCNT_TIM_CLK / 1000);
+    psc = (uint64_t)FCNT_PERIOD_MAX * (FCNT_TIM_CLK / 1000) / 65536;
+    f->psc_max = (psc > 0xFFFF) ? 0xFFFF : psc;
+    f->base = 0;
+
+    /* low: external clock mode 2, rising edges of ETR. TRGO on update, CH1 captures on TRC (the gate) */
+    low->SMCR = TIM_SMCR_ECE | FCNT_TS_GATE;
+    low->CR2 = (low->CR2 & ~TIM_CR2_MMS) | TIM_TRGO_UPDATE;
+    low->CCER &= ~(TIM_CCER_CC1E | TIM_CCER_CC1P);
+    low->CCMR1 = (low->CCMR1 & ~0xFF) | TIM_CCMR1_CC1S;
+    low->CCER |= TIM_CCER_CC1E;
+    low->PSC = 0;
+    low->CR1 |= TIM_CR1_ARPE | TIM_CR1_URS;
+
+    /* high: external clock mode 1 on the TRGO of low */
+    high->SMCR = FCNT_TS_LOW_HIGH | TIM_SLAVEMODE_EXTERNAL1;
+    high->PSC = 0;
+    high->ARR = 0xFFFF;
+    high->EGR = TIM_EGR_UG;
+    high->CR1 |= TIM_CR1_CEN;
+
+    /* gate: TRGO on update, CH1 captures on TRC (the overflows of low) */
+    gate->SMCR = FCNT_TS_LOW_GATE;
+    gate->CR2 = (gate->CR2 & ~TIM_CR2_MMS) | TIM_TRGO_UPDATE;
+    gate->CCER &= ~(TIM_CCER_CC1E | TIM_CCER_CC1P);
+    gate->CCMR1 = (gate->CCMR1 & ~0xFF) | TIM_CCMR1_CC1S;
+    gate->CCER |= TIM_CCER_CC1E;
+    gate->CR1 |= TIM_CR1_ARPE | TIM_CR1_URS;
+
+    low->CR1 |= TIM_CR1_CEN;
+    fcnt_count_mode(f);
+
+    return 0;
+}
+
+/**
+ * @brief       Stops counting
+ * @param       f : frequency counter
+ * @retval      None
+ */
+void fcnt_stop(fcnt_t *f)
+{
+    f->low->Instance->DIER &= ~TIM_DIER_CC1IE;
+    f->gate->Instance->DIER &= ~(TIM_DIER_CC1IE | TIM_DIER_UIE);
+    f->gate->Instance->CR1 &= ~TIM_CR1_CEN;
+    f->low->Instance->CR1 &= ~TIM_CR1_CEN;
+    f->high->Instance->CR1 &= ~TIM_CR1_CEN;
+}
+
+/**
+ * @brief       Capture interrupt: end of a gate or of a block
+ * @param       htim : timer handle
+ * @retval      None
+ */
+void fcnt_capture(TIM_HandleTypeDef *htim)
+{
+    fcnt_t *f = g_fcnt_dev;
+
+    if (f == NULL)return;
+
+    if (htim == f->low && f->mode == FCNT_COUNT)
+    {
+        fcnt_gate_count(f);
+    }
+    else if (htim == f->gate && f->mode == FCNT_RECIPROCAL)
+    {
+        fcnt_gate_recip(f);
+    }
+}
+
+/**
+ * @brief       Update interrupt of the gate timer in FCNT_RECIPROCAL: no block end for 65536 ticks
+ * @param       htim : timer handle
+ * @retval      None
+ */
+void fcnt_update(TIM_HandleTypeDef *htim)
+{
+    fcnt_t *f = g_fcnt_dev;
+    uint16_t k, psc;
+
+    if (f == NULL || htim != f->gate || f->mode != FCNT_RECIPROCAL)return;
+
+    k = f->k_run;
+    psc = f->psc_run;
+
+    if (k > 1)
+    {
+        k = 1;                              /* Fewer cycles than expected, one per block */
+    }
+    else if (psc < f->psc_max)
+    {
+        psc = (psc >= f->psc_max / 2) ? f->psc_max : psc * 2 + 1;
+    }
+    else
+    {
+        fcnt_publish(f, FCNT_RECIPROCAL, 0, 65536 * (psc + 1), 0);  /* No input */
+    }
+
+    fcnt_fold(f);
+    fcnt_recip_mode(f, k, psc);
+}
+
+/**
+ * @brief       Takes the last reading
+ * @param       f : frequency counter
+ * @param       res : reading
+ * @retval      1, a new reading since the last call; 0, the same one
+ */
+uint8_t fcnt_read(fcnt_t *f, fcnt_result_t *res)
+{
+    uint8_t ret;
+
+    __disable_irq();
+    *res = f->res;
+    ret = (f->seq != f->seq_rd);
+    f->seq_rd = f->seq;
+    __enable_irq();
+
+    return ret;
+}
+
+/**
+ * @brief       Input cycles since fcnt_start
+ * @param       f : frequency counter
+ * @retval      Cycles
+ */
+uint32_t fcnt_total(fcnt_t *f)
+{
+    TIM_TypeDef *low = f->low->Instance;
+    uint32_t total, l;
+
+    __disable_irq();
+
+    if (f->mode == FCNT_COUNT)
+    {
+        total = f->base + fcnt_hw(f);
+    }
+    else
+    {
+        l = low->CNT;
+
+        if (f->gate->Instance->SR & TIM_SR_CC1IF)
+        {
+            total = f->base + f->k_run + low->CNT;  /* A block ended, its interrupt is pending */
+        }
+        else
+        {
+            total = f->base + l;
+        }
+    }
+
+    __enable_irq();
+
+    return total;
+}
+
+/**
+ * @brief       Frequency of a reading
+ * @param       res : reading
+ * @param       mhz : thousandths of Hz, may be NULL
+ * @retval      Frequency, in Hz
+ */
+uint32_t fcnt_hz(const fcnt_result_t *res, uint16_t *mhz)
+{
+    uint64_t q;
+    uint32_t hz = 0, frac = 0;
+
+    if (res->cycles && res->clk)
+    {
+        q = (uint64_t)res->cycles * FCNT_TIM_CLK;
+        hz = q / res->clk;
+        frac = (q % res->clk) * 1000 / res->clk;
+    }
+
+    if (mhz)*mhz = frac;
+
+    return hz;
+}
@@ -0,0 +1,97 @@
+/**
+ ****************************************************************************************************
+ * @file        fcnt.h
+ * @author      ALIENTEK
+ * @brief       Frequency counter: chained 32-bit counter, hardware gate and reciprocal counting
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     add FCNT_CHAIN_LAG
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __FCNT_H
+#define __FCNT_H
+
+#include "main.h"
+
+
+#define FCNT_TIM_CLK        72000000    /* Clock of the timers */
+#define FCNT_GATE_PSC       (7200 - 1)  /* Gate timer in 0.1ms ticks for the COUNT mode */
+#define FCNT_GATE_MAX       6553        /* Longest gate, in ms */
+#define FCNT_CYCLES_MAX     32768       /* Cycles per gate above which the COUNT mode is used */
+#define FCNT_PERIOD_MAX     10000       /* Longest input period, in ms */
+#define FCNT_CHAIN_LAG      8           /* Timer clocks from an overflow of the low counter to the count of the
+                                         * high one (resynchronization of the trigger input), with margin */
+
+/*
+ * Internal triggers between the three timers (TIMx internal trigger connection table of RM0008).
+ * Input counter TIM2 (ETR), high half TIM3, gate TIM4.
+ */
+#define FCNT_TS_GATE        TIM_TS_ITR3 /* TIM2 <- TIM4 */
+#define FCNT_TS_LOW_HIGH    TIM_TS_ITR1 /* TIM3 <- TIM2 */
+#define FCNT_TS_LOW_GATE    TIM_TS_ITR1 /* TIM4 <- TIM2 */
+
+/*
+ * Modes, chosen by the counter itself from the last reading
+ * FCNT_COUNT      : the gate timer runs freely, its update is the gate. The low counter captures its
+ *                   count at each gate (CH1 on TRC), the high counter counts its overflows. Reading:
+ *                   the cycles of one gate, resolution +-1 cycle.
+ * FCNT_RECIPROCAL : the low counter overflows every K input cycles and resets the gate timer, which
+ *                   captures the time of the K cycles. K and the prescaler are chosen so that K
+ *                   cycles last about one gate. Reading: the time of K cycles, resolution +-1 tick
+ *                   of about 1/32768, whatever the frequency.
+ * The counters run all the time, the CPU only takes the reading once per gate.
+ */
+#define FCNT_COUNT          0
+#define FCNT_RECIPROCAL     1
+
+typedef struct
+{
+    uint32_t cycles;                    /* Input cycles, 0: no input */
+    uint32_t clk;                       /* Their time, in periods of FCNT_TIM_CLK */
+    uint32_t ppm;                       /* Resolution (one cycle or one tick), in ppm */
+    uint8_t mode;                       /* FCNT_COUNT / FCNT_RECIPROCAL */
+} fcnt_result_t;
+
+typedef struct
+{
+    TIM_HandleTypeDef *low;             /* Counts the input on ETR, 16 bits */
+    TIM_HandleTypeDef *high;            /* Counts the overflows of low */
+    TIM_HandleTypeDef *gate;            /* Gate and time base */
+    uint32_t gate_clk;                  /* Gate, in periods of FCNT_TIM_CLK */
+    uint16_t gate_ms;
+    uint16_t psc_max;                   /* FCNT_RECIPROCAL: prescaler for FCNT_PERIOD_MAX */
+    uint8_t mode;
+    uint8_t skip;                       /* Captures to ignore after a restart */
+    uint16_t k_run;                     /* FCNT_RECIPROCAL: K and prescaler of the running block */
+    uint16_t psc_run;
+    uint16_t k_next;                    /* Loaded at the end of the running block */
+    uint16_t psc_next;
+    uint32_t last;                      /* FCNT_COUNT: count at the last gate */
+    uint32_t base;                      /* Input cycles before the contents of the counters */
+    fcnt_result_t res;                  /* Last reading */
+    volatile uint32_t seq;              /* Readings published */
+    uint32_t seq_rd;                    /* Readings taken by fcnt_read */
+} fcnt_t;
+
+void fcnt_init(fcnt_t *f, TIM_HandleTypeDef *low, TIM_HandleTypeDef *high, TIM_HandleTypeDef *gate);
+uint8_t fcnt_start(fcnt_t *f, uint16_t gate_ms);                        /* One reading per gate_ms */
+void fcnt_stop(fcnt_t *f);
+void fcnt_capture(TIM_HandleTypeDef *htim);                             /* Call from HAL_TIM_IC_CaptureCallback */
+void fcnt_update(TIM_HandleTypeDef *htim);                              /* Call from HAL_TIM_PeriodElapsedCallback */
+
+uint8_t fcnt_read(fcnt_t *f, fcnt_result_t *res);                       /* 1: a new reading since the last call */
+uint32_t fcnt_total(fcnt_t *f);                                         /* Input cycles since the start */
+uint32_t fcnt_hz(const fcnt_result_t *res, uint16_t *mhz);              /* Frequency in Hz, mhz gets the thousandths */
+
+#endif
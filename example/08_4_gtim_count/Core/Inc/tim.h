@@ -29,22 +29,27 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "../../ATK_Middlewares/FCNT/fcnt.h"
 /* USER CODE END Includes */
 
 extern TIM_HandleTypeDef htim2;
 
+extern TIM_HandleTypeDef htim3;
+
+extern TIM_HandleTypeDef htim4;
+
 /* USER CODE BEGIN Private defines */
 
+extern fcnt_t g_fcnt;
+
 /* USER CODE END Private defines */
 
 void MX_TIM2_Init(void);
+void MX_TIM3_Init(void);
+void MX_TIM4_Init(void);
 
 /* USER CODE BEGIN Prototypes */
 
-void gtim_timx_cnt_chy_restart(void);
-uint32_t gtim_timx_cnt_chy_get_count(void);
-
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
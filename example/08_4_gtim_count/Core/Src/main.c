@@ -3,7 +3,7 @@
  ****************************************************************************************************
  * @file        main.c
  * @author      ALIENTEK
- * @brief       general-purpose timers pulse count code
+ * @brief       general-purpose timers pulse count and frequency counter code
  * @license     Copyright (C) 2012-2024, ALIENTEK
  ****************************************************************************************************
  * @attention
@@ -15,6 +15,7 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     frequency counter: TIM2 + TIM3 32-bit count, TIM4 gate, reciprocal mode
  *
  ****************************************************************************************************
  */
@@ -39,6 +40,8 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 
+#define GATE_MS     1000                    /* One frequency reading per second */
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -70,8 +73,11 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
+  fcnt_result_t res;
   uint32_t curcnt = 0;
   uint32_t oldcnt = 0;
+  uint32_t hz;
+  uint16_t mhz;
   uint8_t key = 0;
   uint8_t t = 0;
   /* USER CODE END 1 */
@@ -96,9 +102,11 @@ int main(void)
   MX_GPIO_Init();
   MX_USART1_UART_Init();
   MX_TIM2_Init();
+  MX_TIM3_Init();
+  MX_TIM4_Init();
   /* USER CODE BEGIN 2 */
 
-  gtim_timx_cnt_chy_restart();            /* Restart counting. */
+  fcnt_start(&g_fcnt, GATE_MS);           /* Start counting. */
 
   /* USER CODE END 2 */
 
@@ -111,15 +119,13 @@ int main(void)
 
     if (key == KEY0_PRES)                   /* KEY0 is pressed to restart the count */
     {
-      gtim_timx_cnt_chy_restart();          /* Restart counting. */
+      fcnt_start(&g_fcnt, GATE_MS);         /* Restart counting, the total is cleared. */
     }
 
-    curcnt = gtim_timx_cnt_chy_get_count(); /* Getting the count. */
-
-    if (oldcnt != curcnt)
+    if (fcnt_read(&g_fcnt, &res))           /* A new frequency reading. */
     {
-      oldcnt = curcnt;
-      printf("CNT:%lu\r\n", oldcnt);        /* Print the number of pulses. */
+      hz = fcnt_hz(&res, &mhz);
+      printf("FREQ:%lu.%03uHz RES:%luppm %s\r\n", hz, mhz, res.ppm, (res.mode == FCNT_COUNT) ? "COUNT" : "RECIPROCAL");
     }
 
     t++;
@@ -127,6 +133,14 @@ int main(void)
     if (t > 20)                             /* Enter once in 200ms. */
     {
       t = 0;
+      curcnt = fcnt_total(&g_fcnt);         /* Getting the count. */
+
+      if (oldcnt != curcnt)
+      {
+        oldcnt = curcnt;
+        printf("CNT:%lu\r\n", oldcnt);      /* Print the number of pulses. */
+      }
+
       LED0_TOGGLE();                        /* LED blinks to prompt the program to run */
     }
 
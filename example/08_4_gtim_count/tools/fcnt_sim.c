@@ -0,0 +1,192 @@
+/**
+ ****************************************************************************************************
+ * @file        fcnt_sim.c
+ * @author      ALIENTEK
+ * @brief       The chained counters of fcnt.c on a Linux host: TIM2 counting the input, TIM3 counting
+ *              the overflows of TIM2 some timer clocks late
+ *
+ *              Each access to CNT takes 2 ~ 4 timer clocks (one APB1 clock or more). The input edges are
+ *              4 timer clocks apart or more: fast inputs, and slow ones that leave the low count at 0 for
+ *              a long time. An overflow of the low counter reaches the high one 1 ~ lag clocks later.
+ *              Before each round the low counter is moved on to a few counts before its overflow.
+ *
+ *              Checks:
+ *              - fcnt_total (the FCNT_COUNT mode) is not less than the input cycles at its call and not
+ *                more than the input cycles at its return, also around the overflows of the low counter
+ *
+ *              Build, from example/08_4_gtim_count:
+ *              gcc -O2 -Wall -Itools/host -IATK_Middlewares/FCNT tools/fcnt_sim.c ATK_Middlewares/FCNT/fcnt.c -o fcnt_sim
+ *              Run:
+ *              ./fcnt_sim [-n rounds] [-s seed] [-d lag]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "fcnt.h"
+
+#define CHECK(c, ...) do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+static TIM_TypeDef g_tim2, g_tim3, g_tim4;
+static TIM_HandleTypeDef g_htim2 = {&g_tim2}, g_htim3 = {&g_tim3}, g_htim4 = {&g_tim4};
+static fcnt_t g_fcnt;
+
+static uint64_t g_clk = 0;              /* Time, in timer clocks */
+static uint64_t g_edge;                 /* Time of the next input edge */
+static uint32_t g_period;               /* Input period, in timer clocks */
+static uint32_t g_cycles = 0;           /* Input cycles since fcnt_start */
+static uint32_t g_low = 0, g_high = 0;  /* Counts of TIM2 and TIM3 */
+static uint64_t g_carry[4];             /* Times at which overflows of TIM2 reach TIM3 */
+static uint32_t g_carries = 0;
+static uint32_t g_lag = FCNT_CHAIN_LAG;
+static uint32_t g_fails = 0;
+
+/******************************************************************************************/
+/* Host CPU */
+
+void __disable_irq(void)
+{
+}
+
+void __enable_irq(void)
+{
+}
+
+/******************************************************************************************/
+/* Counter chain */
+
+/**
+ * @brief     Moves the input and the counters on to g_clk
+ * @param     None
+ * @retval    None
+ */
+static void sim_run(void)
+{
+    uint32_t i;
+
+    while (g_edge <= g_clk)
+    {
+        g_cycles++;
+        g_low = (g_low + 1) & 0xFFFF;
+
+        if (g_low == 0)                 /* Update of TIM2, TRGO to TIM3 */
+        {
+            g_carry[g_carries++] = g_edge + 1 + rand() % g_lag;
+        }
+
+        g_edge += g_period + rand() % 2;
+    }
+
+    for (i = 0; i < g_carries; )
+    {
+        if (g_carry[i] <= g_clk)
+        {
+            g_high = (g_high + 1) & 0xFFFF;
+            g_carry[i] = g_carry[--g_carries];
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+/**
+ * @brief     An access to CNT: the time of the bus access passes, then the counts are those of its time
+ * @param     None
+ * @retval    0, index of the count
+ */
+uint32_t host_cnt_access(void)
+{
+    g_clk += 2 + rand() % 3;
+    sim_run();
+    g_tim2.cnt[0] = g_low;
+    g_tim3.cnt[0] = g_high;
+
+    return 0;
+}
+
+/**
+ * @brief     Input of the next round: fast or slow, low counter a few counts before its overflow
+ * @param     None
+ * @retval    None
+ */
+static void sim_round(void)
+{
+    uint32_t skip;
+
+    g_period = (rand() % 2) ? 4 + rand() % 3 : 50 + rand() % 500;
+
+    if (g_carries == 0)                 /* The cycles in between pass at once */
+    {
+        skip = 0xFFFF - g_low - rand() % 4;
+        g_low += skip;
+        g_cycles += skip;
+    }
+
+    g_edge = g_clk + 1 + rand() % g_period;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = 100000, k, t0, t1, total;
+    int opt, i;
+
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "n:s:d:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 's': srand(atoi(optarg)); break;
+            case 'd': g_lag = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n rounds] [-s seed] [-d lag]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (g_lag == 0)g_lag = 1;
+
+    fcnt_init(&g_fcnt, &g_htim2, &g_htim3, &g_htim4);
+    fcnt_start(&g_fcnt, 100);
+    g_low = g_high = g_cycles = 0;      /* The counters and the total are cleared from here */
+    g_edge = ~0ULL;
+
+    for (k = 0; k < n; k++)
+    {
+        sim_round();
+
+        for (i = rand() % 16 + 1; i > 0; i--)
+        {
+            t0 = g_cycles;
+            total = fcnt_total(&g_fcnt);
+            t1 = g_cycles;
+
+            CHECK(total - t0 <= t1 - t0, "round %u: total %u, input %u ~ %u", k, total, t0, t1);
+
+            g_clk += rand() % 8;
+        }
+
+        g_clk += 8 * g_period;          /* The round ends after its last overflow has reached TIM3 */
+        sim_run();
+    }
+
+    printf("%u rounds, %u cycles, %u failures\n", n, g_cycles, g_fails);
+
+    return g_fails ? 1 : 0;
+}
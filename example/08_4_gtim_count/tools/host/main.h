@@ -0,0 +1,82 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host build (tools/fcnt_sim.c): the timer definitions used by fcnt.c
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/******************************************************************************************/
+/* Timers */
+
+typedef struct
+{
+    uint32_t CR1;
+    uint32_t CR2;
+    uint32_t SMCR;
+    uint32_t DIER;
+    uint32_t SR;
+    uint32_t EGR;
+    uint32_t CCMR1;
+    uint32_t CCER;
+    uint32_t cnt[1];                    /* Count, set by the simulation before each access */
+    uint32_t PSC;
+    uint32_t ARR;
+    uint32_t CCR1;
+} TIM_TypeDef;
+
+/* Every access to CNT is a bus access that takes time: the simulation moves the input and the
+ * counters on to the time of the access, then the access reads or writes the count */
+uint32_t host_cnt_access(void);
+#define CNT                 cnt[host_cnt_access()]
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+#define TIM_CR1_CEN             0x0001u
+#define TIM_CR1_URS             0x0004u
+#define TIM_CR1_ARPE            0x0080u
+#define TIM_CR2_MMS             0x0070u
+#define TIM_TRGO_UPDATE         0x0020u
+#define TIM_SMCR_SMS            0x0007u
+#define TIM_SMCR_ECE            0x4000u
+#define TIM_SLAVEMODE_RESET     0x0004u
+#define TIM_SLAVEMODE_EXTERNAL1 0x0007u
+#define TIM_TS_ITR1             0x0010u
+#define TIM_TS_ITR3             0x0030u
+#define TIM_DIER_UIE            0x0001u
+#define TIM_DIER_CC1IE          0x0002u
+#define TIM_SR_CC1IF            0x0002u
+#define TIM_EGR_UG              0x0001u
+#define TIM_CCMR1_CC1S          0x0003u
+#define TIM_CCER_CC1E           0x0001u
+#define TIM_CCER_CC1P           0x0002u
+
+/******************************************************************************************/
+/* PRIMASK */
+
+void __disable_irq(void);
+void __enable_irq(void);
+
+#endif
@@ -0,0 +1,366 @@
+/**
+ ****************************************************************************************************
+ * @file        pseq.c
+ * @author      ALIENTEK
+ * @brief       Pulse sequence engine: DMA burst of ARR, RCR and CCR1 at each update event
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     the S-curve is computed without an intermediate truncation, which could
+ *                           lengthen a period by a tick near the top of a ramp (tools/pseq_sim.c)
+ *
+ ****************************************************************************************************
+ */
+
+#include <stddef.h>
+#include "pseq.h"
+
+
+/*
+ * ARR, RCR and CCR1 are preloaded: the values written by the burst of an update event are used from
+ * the next one. The first step is written by pseq_start before the UG that loads it, so the ring
+ * holds the steps from the second one and the burst of the UG writes it.
+ *
+ * When the DMA has used half h of the ring, it has written its last step to the preload registers
+ * and the step before is running. The sequence is over when both are idle steps: stop_half is the
+ * first half that ends with two of them, all the halves after it are idle.
+ */
+
+#define PSEQ_HALF           (PSEQ_RING_LEN / 2)
+#define PSEQ_NO_HALF        0xFFFFFFFF
+
+static pseq_t *g_pseq_dev;
+
+/**
+ * @brief       Fills the next half of the ring
+ * @param       p : pulse sequence
+ * @retval      None
+ */
+static void pseq_fill_half(pseq_t *p)
+{
+    pseq_step_t *step = &p->ring[(p->filled & 1) * PSEQ_HALF];
+    uint16_t n = 0;
+    uint16_t i;
+
+    if (p->source_done == 0)
+    {
+        n = p->fill(step, PSEQ_HALF, p->arg);
+
+        if (n < PSEQ_HALF)p->source_done = 1;
+
+        for (i = 0; i < n; i++)
+        {
+            p->pulses += step[i].rcr + 1;
+        }
+    }
+
+    for (i = n; i < PSEQ_HALF; i++)         /* Idle steps, the output stays low */
+    {
+        step[i].arr = PSEQ_STOP_ARR;
+        step[i].rcr = 0;
+        step[i].ccr = 0;
+    }
+
+    if (p->source_done && p->stop_half == PSEQ_NO_HALF && PSEQ_HALF - n >= 2)
+    {
+        p->stop_half = p->filled;
+    }
+
+    p->filled++;
+}
+
+/**
+ * @brief       DMA callback: a half of the ring has been used
+ * @param       hdma : DMA handle
+ * @retval      None
+ */
+static void pseq_dma_half(DMA_HandleTypeDef *hdma)
+{
+    pseq_t *p = g_pseq_dev;
+    uint32_t pos;
+
+    if (p == NULL || p->hdma != hdma || p->busy == 0)return;
+
+    if (p->used == p->stop_half)            /* The last step is over, an idle one is running */
+    {
+        pseq_stop(p);
+        return;
+    }
+
+    pos = PSEQ_RING_LEN * 3 - __HAL_DMA_GET_COUNTER(hdma);
+
+    if ((pos < PSEQ_HALF * 3) != (p->used & 1))
+    {
+        p->underrun++;                      /* The DMA has already come back to this half */
+    }
+
+    p->used++;
+    pseq_fill_half(p);
+}
+
+/**
+ * @brief       Sets a timer up for pulse sequences on CH1, the output is low
+ * @param       p : pulse sequence
+ * @param       htim : advanced timer (RCR), CH1 in PWM mode 1
+ * @param       hdma : DMA of the update request
+ * @retval      0, OK; 1, no DMA
+ */
+uint8_t pseq_init(pseq_t *p, TIM_HandleTypeDef *htim, DMA_HandleTypeDef *hdma)
+{
+    TIM_TypeDef *tim = htim->Instance;
+
+    if (hdma == NULL)return 1;
+
+    p->htim = htim;
+    p->hdma = hdma;
+    p->busy = 0;
+    g_pseq_dev = p;
+
+    tim->CR1 &= ~TIM_CR1_CEN;
+    tim->DIER &= ~TIM_DIER_UDE;
+    tim->DCR = TIM_DMABASE_ARR | TIM_DMABURSTLENGTH_3TRANSFERS;
+    tim->CR1 |= TIM_CR1_ARPE;
+    tim->CCMR1 |= TIM_CCMR1_OC1PE;
+    tim->CCR1 = 0;
+    tim->EGR = TIM_EGR_UG;
+    TIM_CCxChannelCmd(tim, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+    __HAL_TIM_MOE_ENABLE(htim);
+
+    return 0;
+}
+
+/**
+ * @brief       Starts a pulse sequence
+ * @param       p : pulse sequence
+ * @param       fill : gives the steps, first from here and then from the DMA interrupt
+ * @param       arg : argument of fill
+ * @retval      0, OK; 1, a sequence is running or fill gave no step
+ */
+uint8_t pseq_start(pseq_t *p, pseq_fill_t fill, void *arg)
+{
+    TIM_TypeDef *tim = p->htim->Instance;
+    pseq_step_t first;
+
+    if (p->busy)return 1;
+
+    p->fill = fill;
+    p->arg = arg;
+    p->source_done = 0;
+    p->filled = 0;
+    p->used = 0;
+    p->stop_half = PSEQ_NO_HALF;
+    p->underrun = 0;
+
+    if (fill(&first, 1, arg) == 0)return 1;
+
+    p->pulses = first.rcr + 1;
+    pseq_fill_half(p);
+    pseq_fill_half(p);
+
+    p->hdma->XferHalfCpltCallback = pseq_dma_half;
+    p->hdma->XferCpltCallback = pseq_dma_half;
+
+    if (HAL_DMA_Start_IT(p->hdma, (uint32_t)p->ring, (uint32_t)&tim->DMAR, PSEQ_RING_LEN * 3) != HAL_OK)return 1;
+
+    p->busy = 1;
+    tim->ARR = first.arr;
+    tim->RCR = first.rcr;
+    tim->CCR1 = first.ccr;
+    tim->DIER |= TIM_DIER_UDE;
+    tim->EGR = TIM_EGR_UG;                  /* Loads the first step, its burst writes the second one */
+    tim->CR1 |= TIM_CR1_CEN;
+
+    return 0;
+}
+
+/**
+ * @brief       Stops the pulse sequence, the output goes low
+ * @param       p : pulse sequence
+ * @retval      None
+ */
+void pseq_stop(pseq_t *p)
+{
+    TIM_TypeDef *tim = p->htim->Instance;
+
+    tim->DIER &= ~TIM_DIER_UDE;
+    tim->CR1 &= ~TIM_CR1_CEN;
+    HAL_DMA_Abort(p->hdma);
+    tim->CCR1 = 0;
+    tim->EGR = TIM_EGR_UG;                  /* CCR1 is preloaded */
+    p->busy = 0;
+}
+
+/**
+ * @brief       A sequence is running
+ * @param       p : pulse sequence
+ * @retval      1, running; 0, idle
+ */
+uint8_t pseq_busy(pseq_t *p)
+{
+    return p->busy;
+}
+
+/**
+ * @brief       Ticks per second of the timer
+ * @param       p : pulse sequence
+ * @retval      Frequency, in Hz
+ */
+uint32_t pseq_tick_hz(pseq_t *p)
+{
+    return PSEQ_TIM_CLK / (p->htim->Instance->PSC + 1);
+}
+
+/**
+ * @brief       Sets a table source up
+ * @param       tb : table source, the argument of pseq_table_fill
+ * @param       table : steps
+ * @param       num : number of steps
+ * @retval      None
+ */
+void pseq_table_init(pseq_table_t *tb, const pseq_step_t *table, uint32_t num)
+{
+    tb->table = table;
+    tb->num = num;
+    tb->pos = 0;
+}
+
+/**
+ * @brief       Fill function of a table source
+ * @param       step : steps to fill
+ * @param       num : number of steps asked
+ * @param       arg : table source
+ * @retval      Number of steps filled
+ */
+uint16_t pseq_table_fill(pseq_step_t *step, uint16_t num, void *arg)
+{
+    pseq_table_t *tb = arg;
+    uint16_t n = 0;
+
+    while (n < num && tb->pos < tb->num)
+    {
+        step[n++] = tb->table[tb->pos++];
+    }
+
+    return n;
+}
+
+/**
+ * @brief       Period of the S-curve at a time of the ramp
+ * @param       r : S-curve move
+ * @param       t : time from the start of the ramp, in ticks
+ * @retval      Period, in ticks
+ */
+static uint32_t pseq_scurve_iv(pseq_scurve_t *r, uint32_t t)
+{
+    uint32_t x, s, v, iv;
+
+    x = (t >= r->t_ramp) ? 65536 : (uint32_t)(((uint64_t)t << 16) / r->t_ramp);
+    s = (uint32_t)(((uint64_t)x * x * (3 * 65536 - 2 * x)) >> 32);             /* 3x^2 - 2x^3, 0 ~ 65536, never decreasing */
+    v = r->v0 + (uint32_t)(((uint64_t)(r->v1 - r->v0) * s) >> 16);
+    iv = r->tick_hz / v;
+
+    if (iv < PSEQ_TICKS_MIN)iv = PSEQ_TICKS_MIN;
+
+    if (iv > 65536)iv = 65536;
+
+    return iv;
+}
+
+/**
+ * @brief       Sets an S-curve move up
+ * @param       r : S-curve move, the argument of pseq_scurve_fill
+ * @param       tick_hz : ticks per second of the timer (pseq_tick_hz)
+ * @param       steps : steps of the move
+ * @param       v0 : start and stop rate, in steps/s
+ * @param       v1 : cruise rate, in steps/s
+ * @param       ramp_ms : time from v0 to v1. Short moves stop accelerating at half of the steps.
+ * @retval      0, OK; 1, bad parameters
+ */
+uint8_t pseq_scurve_init(pseq_scurve_t *r, uint32_t tick_hz, uint32_t steps, uint32_t v0, uint32_t v1, uint16_t ramp_ms)
+{
+    if (steps == 0 || v0 == 0 || v1 < v0 || ramp_ms == 0)return 1;
+
+    r->tick_hz = tick_hz;
+    r->steps = steps;
+    r->done = 0;
+    r->v0 = v0;
+    r->v1 = v1;
+    r->t_ramp = (uint32_t)((uint64_t)tick_hz * ramp_ms / 1000);
+    r->t = 0;
+    r->t_acc = 0;
+    r->ramp = 0;
+    r->iv = pseq_scurve_iv(r, 0);
+    r->phase = 0;
+
+    return 0;
+}
+
+/**
+ * @brief       Fill function of an S-curve move. The cruise is run-length coded in RCR.
+ * @param       step : steps to fill
+ * @param       num : number of steps asked
+ * @param       arg : S-curve move
+ * @retval      Number of steps filled
+ */
+uint16_t pseq_scurve_fill(pseq_step_t *step, uint16_t num, void *arg)
+{
+    pseq_scurve_t *r = arg;
+    uint32_t iv, rep;
+    uint16_t n = 0;
+
+    while (n < num && r->done < r->steps)
+    {
+        if (r->phase == 0)                  /* Acceleration */
+        {
+            if (r->t >= r->t_ramp || r->done >= r->steps / 2)
+            {
+                r->t_acc = r->t;
+                r->iv = pseq_scurve_iv(r, r->t);
+                r->phase = 1;
+                continue;
+            }
+
+            iv = pseq_scurve_iv(r, r->t);
+            r->t += iv;
+            r->ramp++;
+            rep = 1;
+        }
+        else if (r->phase == 1)             /* Cruise, up to 256 pulses per step */
+        {
+            if (r->steps - r->done <= r->ramp)
+            {
+                r->t = 0;
+                r->phase = 2;
+                continue;
+            }
+
+            iv = r->iv;
+            rep = r->steps - r->done - r->ramp;
+
+            if (rep > 256)rep = 256;
+        }
+        else                                /* Deceleration, the acceleration backwards */
+        {
+            iv = pseq_scurve_iv(r, (r->t + r->iv >= r->t_acc) ? 0 : r->t_acc - r->t - r->iv);
+            r->t += iv;
+            rep = 1;
+        }
+
+        r->iv = iv;
+        step[n].arr = iv - 1;
+        step[n].rcr = rep - 1;
+        step[n].ccr = iv / 2;
+        n++;
+        r->done += rep;
+    }
+
+    return n;
+}
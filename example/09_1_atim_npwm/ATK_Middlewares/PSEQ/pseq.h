@@ -0,0 +1,102 @@
+/**
+ ****************************************************************************************************
+ * @file        pseq.h
+ * @author      ALIENTEK
+ * @brief       Pulse sequence engine: DMA burst of ARR, RCR and CCR1 at each update event
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __PSEQ_H
+#define __PSEQ_H
+
+#include "main.h"
+
+
+#define PSEQ_TIM_CLK        72000000    /* Clock of the timer */
+#define PSEQ_RING_LEN       128         /* Steps in the DMA ring, two halves */
+#define PSEQ_STOP_ARR       127         /* Period of the idle steps that end a sequence, in ticks */
+#define PSEQ_TICKS_MIN      64          /* Shortest period: the DMA burst must be done before the next update */
+
+/*
+ * A step is (rcr + 1) pulses of (arr + 1) ticks, high for ccr ticks (PWM mode 1 on CH1). The update
+ * event that starts a step requests a DMA burst to DMAR (DBA = ARR, 3 transfers), which writes the
+ * preload registers with the next step, so the steps follow each other without the CPU.
+ *
+ * The steps come from a fill function, called for half of the ring at a time from the DMA interrupt.
+ * It returns fewer steps than asked at the end of the sequence, the engine then finishes with idle
+ * steps (ccr = 0) and stops the timer. A fill must be done before the DMA has used the other half.
+ */
+typedef struct
+{
+    uint16_t arr;                       /* Order of the registers from ARR: ARR, RCR, CCR1 */
+    uint16_t rcr;                       /* Pulses - 1, 0 ~ 255 */
+    uint16_t ccr;                       /* High time, in ticks */
+} pseq_step_t;
+
+typedef uint16_t (*pseq_fill_t)(pseq_step_t *step, uint16_t num, void *arg);
+
+typedef struct
+{
+    TIM_HandleTypeDef *htim;
+    DMA_HandleTypeDef *hdma;            /* TIMx_UP, circular, memory to peripheral, halfword */
+    pseq_fill_t fill;
+    void *arg;
+    uint8_t source_done;                /* fill has returned the last step */
+    volatile uint8_t busy;
+    uint32_t filled;                    /* Halves of the ring filled */
+    uint32_t used;                      /* Halves of the ring used by the DMA */
+    uint32_t stop_half;                 /* Half that ends with two idle steps */
+    volatile uint32_t pulses;           /* Pulses of the steps filled */
+    volatile uint32_t underrun;         /* Halves filled after the DMA had started to use them */
+    pseq_step_t ring[PSEQ_RING_LEN];
+} pseq_t;
+
+/* Steps of a table */
+typedef struct
+{
+    const pseq_step_t *table;
+    uint32_t num;
+    uint32_t pos;
+} pseq_table_t;
+
+/* Stepper move with S-curve ramps: the rate follows v0 + (v1 - v0) * (3x^2 - 2x^3), x = t / ramp */
+typedef struct
+{
+    uint32_t tick_hz;
+    uint32_t steps;                     /* Steps of the move */
+    uint32_t done;                      /* Steps filled */
+    uint32_t v0;                        /* Start and stop rate, in steps/s */
+    uint32_t v1;                        /* Cruise rate, in steps/s */
+    uint32_t t_ramp;                    /* Ramp time, in ticks */
+    uint32_t t;                         /* Time in the ramp, in ticks */
+    uint32_t t_acc;                     /* Length of the acceleration, in ticks */
+    uint32_t ramp;                      /* Steps of the acceleration */
+    uint32_t iv;                        /* Last period, in ticks */
+    uint8_t phase;                      /* 0, acceleration; 1, cruise; 2, deceleration */
+} pseq_scurve_t;
+
+uint8_t pseq_init(pseq_t *p, TIM_HandleTypeDef *htim, DMA_HandleTypeDef *hdma);
+uint8_t pseq_start(pseq_t *p, pseq_fill_t fill, void *arg);             /* 0, OK; 1, busy or no step */
+void pseq_stop(pseq_t *p);
+uint8_t pseq_busy(pseq_t *p);
+uint32_t pseq_tick_hz(pseq_t *p);
+
+void pseq_table_init(pseq_table_t *tb, const pseq_step_t *table, uint32_t num);
+uint16_t pseq_table_fill(pseq_step_t *step, uint16_t num, void *arg);
+
+uint8_t pseq_scurve_init(pseq_scurve_t *r, uint32_t tick_hz, uint32_t steps, uint32_t v0, uint32_t v1, uint16_t ramp_ms);
+uint16_t pseq_scurve_fill(pseq_step_t *step, uint16_t num, void *arg);
+
+#endif
@@ -29,13 +29,15 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "../../ATK_Middlewares/PSEQ/pseq.h"
 /* USER CODE END Includes */
 
 extern TIM_HandleTypeDef htim8;
 
 /* USER CODE BEGIN Private defines */
 
+extern pseq_t g_pseq;
+
 /* USER CODE END Private defines */
 
 void MX_TIM8_Init(void);
@@ -44,8 +46,6 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
 /* USER CODE BEGIN Prototypes */
 
-void atim_timx_npwm_chy_set(uint32_t npwm);
-
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
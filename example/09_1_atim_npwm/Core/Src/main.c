@@ -15,12 +15,14 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     pulse sequences through the DMA burst engine, S-curve stepper move
  *
  ****************************************************************************************************
  */
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "tim.h"
 #include "usart.h"
 #include "gpio.h"
@@ -50,6 +52,16 @@
 
 /* USER CODE BEGIN PV */
 
+/* KEY0: five pulses of 1ms to 5ms, half of the period high, in 8MHz ticks */
+static const pseq_step_t g_pulse_table[] =
+{
+    {8000 - 1, 0, 4000},
+    {16000 - 1, 0, 8000},
+    {24000 - 1, 0, 12000},
+    {32000 - 1, 0, 16000},
+    {40000 - 1, 0, 20000},
+};
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -70,8 +82,11 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-	  uint8_t key = 0;
-	  uint8_t t = 0;
+  pseq_table_t table;
+  pseq_scurve_t move;
+  uint8_t running = 0;
+  uint8_t key = 0;
+  uint8_t t = 0;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -92,6 +107,7 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_TIM8_Init();
   /* USER CODE BEGIN 2 */
@@ -103,23 +119,34 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  key = key_scan(0);             /* scan key */
-
-	  if (key == KEY0_PRES)          /* KEY0 is pressed */
-	  {
-	  	 atim_timx_npwm_chy_set(5);  /* Control TIM8_CH1 output 5 PWM pulses. */
-	  }
-
-	  if (t > 20)                    /* Enter once in 200ms. */
-	  {
-	  	 t = 0;
-	     LED0_TOGGLE();               /* LED blinks to prompt the program to run */
-	  }
-
-	  t++;
-
-	  HAL_Delay(10);                 /* delay 10ms */
-
+    key = key_scan(0);            /* scan key */
+
+    if (key == KEY0_PRES && pseq_busy(&g_pseq) == 0)        /* KEY0 is pressed: the five pulses of the table */
+    {
+      pseq_table_init(&table, g_pulse_table, sizeof(g_pulse_table) / sizeof(g_pulse_table[0]));
+      running = (pseq_start(&g_pseq, pseq_table_fill, &table) == 0);
+    }
+    else if (key == WKUP_PRES && pseq_busy(&g_pseq) == 0)   /* KEY_UP is pressed: 20000 steps, 500 to 50000 steps/s in 200ms */
+    {
+      pseq_scurve_init(&move, pseq_tick_hz(&g_pseq), 20000, 500, 50000, 200);
+      running = (pseq_start(&g_pseq, pseq_scurve_fill, &move) == 0);
+    }
+
+    if (running && pseq_busy(&g_pseq) == 0)                 /* The sequence is over */
+    {
+      running = 0;
+      printf("Pulses   :%lu\r\n", g_pseq.pulses);
+      printf("Underrun :%lu\r\n", g_pseq.underrun);
+    }
+
+    if (t > 20)                   /* Enter once in 200ms. */
+    {
+      t = 0;
+      LED0_TOGGLE();              /* LED blinks to prompt the program to run */
+    }
+
+    t++;
+    HAL_Delay(10);                /* delay 10ms */
     /* USER CODE BEGIN 3 */
   }
   /* USER CODE END 3 */
@@ -22,14 +22,12 @@
 
 /* USER CODE BEGIN 0 */
 
-/* g_npwm_remain indicates how many pulses are left to send
- * Send a maximum of 256 pulses at a time
- */
-volatile static uint32_t g_npwm_remain = 0;
+pseq_t g_pseq;                  /* PC6 pulse sequences, TIM8 channel 1 */
 
 /* USER CODE END 0 */
 
 TIM_HandleTypeDef htim8;
+DMA_HandleTypeDef hdma_tim8_up;
 
 /* TIM8 init function */
 void MX_TIM8_Init(void)
@@ -48,9 +46,9 @@ void MX_TIM8_Init(void)
 
   /* USER CODE END TIM8_Init 1 */
   htim8.Instance = TIM8;
-  htim8.Init.Prescaler = 7200 - 1;
+  htim8.Init.Prescaler = 9 - 1;
   htim8.Init.CounterMode = TIM_COUNTERMODE_UP;
-  htim8.Init.Period = 5000 - 1;
+  htim8.Init.Period = 128 - 1;
   htim8.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
   htim8.Init.RepetitionCounter = 0;
   htim8.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
@@ -74,7 +72,7 @@ void MX_TIM8_Init(void)
     Error_Handler();
   }
   sConfigOC.OCMode = TIM_OCMODE_PWM1;
-  sConfigOC.Pulse = 2500;
+  sConfigOC.Pulse = 0;
   sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
   sConfigOC.OCNPolarity = TIM_OCNPOLARITY_HIGH;
   sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
@@ -84,7 +82,6 @@ void MX_TIM8_Init(void)
   {
     Error_Handler();
   }
-  __HAL_TIM_DISABLE_OCxPRELOAD(&htim8, TIM_CHANNEL_1);
   sBreakDeadTimeConfig.OffStateRunMode = TIM_OSSR_DISABLE;
   sBreakDeadTimeConfig.OffStateIDLEMode = TIM_OSSI_DISABLE;
   sBreakDeadTimeConfig.LockLevel = TIM_LOCKLEVEL_OFF;
@@ -97,7 +94,7 @@ void MX_TIM8_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN TIM8_Init 2 */
-  HAL_TIM_PWM_Start(&htim8, TIM_CHANNEL_1);   /* Open the corresponding PWM channel. */
+  pseq_init(&g_pseq, &htim8, &hdma_tim8_up);
   /* USER CODE END TIM8_Init 2 */
   HAL_TIM_MspPostInit(&htim8);
 
@@ -114,9 +111,23 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* tim_baseHandle)
     /* TIM8 clock enable */
     __HAL_RCC_TIM8_CLK_ENABLE();
 
-    /* TIM8 interrupt Init */
-    HAL_NVIC_SetPriority(TIM8_UP_IRQn, 2, 1);
-    HAL_NVIC_EnableIRQ(TIM8_UP_IRQn);
+    /* TIM8 DMA Init */
+    /* TIM8_UP Init */
+    hdma_tim8_up.Instance = DMA2_Channel1;
+    hdma_tim8_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_tim8_up.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim8_up.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim8_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim8_up.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim8_up.Init.Mode = DMA_CIRCULAR;
+    hdma_tim8_up.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_tim8_up) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(tim_baseHandle,hdma[TIM_DMA_ID_UPDATE],hdma_tim8_up);
+
   /* USER CODE BEGIN TIM8_MspInit 1 */
 
   /* USER CODE END TIM8_MspInit 1 */
@@ -159,8 +170,8 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* tim_baseHandle)
     /* Peripheral clock disable */
     __HAL_RCC_TIM8_CLK_DISABLE();
 
-    /* TIM8 interrupt Deinit */
-    HAL_NVIC_DisableIRQ(TIM8_UP_IRQn);
+    /* TIM8 DMA DeInit */
+    HAL_DMA_DeInit(tim_baseHandle->hdma[TIM_DMA_ID_UPDATE]);
   /* USER CODE BEGIN TIM8_MspDeInit 1 */
 
   /* USER CODE END TIM8_MspDeInit 1 */
@@ -169,50 +180,4 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* tim_baseHandle)
 
 /* USER CODE BEGIN 1 */
 
-/**
- * @brief   The advanced timer TIMX NPWM sets the number of PWMS
- * @param   npwm:The number of PWMS, 1~2^32
- * @retval  None.
- */
-void atim_timx_npwm_chy_set(uint32_t npwm)
-{
-    if (npwm == 0) return;
-
-    g_npwm_remain = npwm;                                   /* Save the number of pulses */
-    __HAL_TIM_ENABLE_IT(&htim8, TIM_IT_UPDATE);             /* When the data is modified, the update is allowed to interrupt. */
-    HAL_TIM_GenerateEvent(&htim8, TIM_EVENTSOURCE_UPDATE);  /* An update event is generated and the pulse output is processed inside the interrupt. */
-    __HAL_TIM_ENABLE(&htim8);                               /* Enable TIMX */
-}
-
-/**
-  * @brief  Period elapsed callback in non-blocking mode
-  * @param  htim TIM handle
-  * @retval None
-  */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
-{
-  uint16_t npwm = 0;
-  if (g_npwm_remain >= 256)           /* There are also more than 256 pulses to be sent. */
-  {
-    g_npwm_remain = g_npwm_remain - 256;
-    npwm = 256;
-  }
-  else if (g_npwm_remain % 256)       /* There are still bits (less than 256) of pulses to send. */
-  {
-    npwm = g_npwm_remain % 256;
-    g_npwm_remain = 0;                /* There's no pulse. */
-  }
-
-  if (npwm)                           /* There's a pulse to send */
-  {
-    TIM8->RCR = npwm - 1;             /* The value of the repeat count register is set to npwm-1, which means npwm pulses */
-    HAL_TIM_GenerateEvent(&htim8, TIM_EVENTSOURCE_UPDATE); /* An update event is generated and the pulse output is processed inside the interrupt */
-    __HAL_TIM_ENABLE(&htim8);                              /* Enable TIMX */
-  }
-  else
-  {
-    TIM8->CR1 &= ~(1 << 0);          /* close TIM8 */
-  }
-}
-
 /* USER CODE END 1 */
@@ -0,0 +1,98 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host build (tools/pseq_sim.c): the TIM and DMA parts of the HAL that
+ *              pseq.c uses, with the register layout of the STM32F1
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR = 1
+} HAL_StatusTypeDef;
+
+/* TIM1/TIM8, offsets 0x00 ~ 0x4C: DBA counts the registers from CR1 */
+typedef struct
+{
+    volatile uint32_t CR1;
+    volatile uint32_t CR2;
+    volatile uint32_t SMCR;
+    volatile uint32_t DIER;
+    volatile uint32_t SR;
+    volatile uint32_t EGR;
+    volatile uint32_t CCMR1;
+    volatile uint32_t CCMR2;
+    volatile uint32_t CCER;
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+    volatile uint32_t RCR;
+    volatile uint32_t CCR1;
+    volatile uint32_t CCR2;
+    volatile uint32_t CCR3;
+    volatile uint32_t CCR4;
+    volatile uint32_t BDTR;
+    volatile uint32_t DCR;
+    volatile uint32_t DMAR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uint32_t CPAR;
+    volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+    DMA_Channel_TypeDef *Instance;
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+} DMA_HandleTypeDef;
+
+#define TIM_CR1_CEN                     0x0001
+#define TIM_CR1_ARPE                    0x0080
+#define TIM_DIER_UDE                    0x0100
+#define TIM_EGR_UG                      0x0001
+#define TIM_CCMR1_OC1PE                 0x0008
+#define TIM_BDTR_MOE                    0x8000
+#define TIM_DMABASE_ARR                 0x000B
+#define TIM_DMABURSTLENGTH_3TRANSFERS   0x0200
+#define TIM_CHANNEL_1                   0x0000
+#define TIM_CCx_ENABLE                  0x0001
+
+#define __HAL_TIM_MOE_ENABLE(h)         ((h)->Instance->BDTR |= TIM_BDTR_MOE)
+#define __HAL_DMA_GET_COUNTER(h)        ((h)->Instance->CNDTR)
+
+/* tools/pseq_sim.c */
+void TIM_CCxChannelCmd(TIM_TypeDef *TIMx, uint32_t Channel, uint32_t ChannelState);
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+
+#endif
@@ -0,0 +1,491 @@
+/**
+ ****************************************************************************************************
+ * @file        pseq_sim.c
+ * @author      ALIENTEK
+ * @brief       Runs ATK_Middlewares/PSEQ/pseq.c on a Linux host against a model of TIM8 and DMA2
+ *
+ *              The model works period by period at the tick of the timer (8MHz, as in main.c):
+ *              - ARR, RCR and CCR1 are preload registers, the counter, the repetition counter and the
+ *                compare use shadows loaded at the update event, which comes every RCR + 1 periods
+ *                or from UG. CH1 is in PWM mode 1: high while the counter is below CCR1.
+ *              - With UDE set, an update event requests a burst of DCR: 3 halfwords from the ring to
+ *                ARR, RCR and CCR1, done before the next period. CNDTR counts down and reloads
+ *                (circular), the half transfer and transfer complete interrupts call pseq_dma_half.
+ *              - The interrupts run in order, each one a random latency after its event.
+ *
+ *              Every period of the output is compared with the steps of a second copy of the source:
+ *              period and high time exact, nothing left out, nothing added, only idle periods after
+ *              the last step, then the timer stopped. pulses must match and underrun must stay 0.
+ *              Table sequences of 1 to 300 random steps and S-curve moves of 1 to 200000 steps run with
+ *              a latency of up to 250us, the moves are also checked for their step count and ramps.
+ *              Last, the shortest steps run with interrupts up to 7/4 of a half late: every wrong
+ *              output must be counted in underrun, and a run always more than a half late must count.
+ *
+ *              Build, from example/09_1_atim_npwm:
+ *              gcc -O2 -Wall -Wno-pointer-to-int-cast -Itools/host tools/pseq_sim.c ATK_Middlewares/PSEQ/pseq.c -o pseq_sim
+ *              Run:
+ *              ./pseq_sim [-s seed] [-v]               (-v: one line per sequence)
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "../ATK_Middlewares/PSEQ/pseq.h"
+
+#define SIM_PSC             (9 - 1)     /* htim8.Init.Prescaler, 8MHz */
+#define SIM_TICK_HZ         (PSEQ_TIM_CLK / (SIM_PSC + 1))
+#define SIM_LATENCY         (SIM_TICK_HZ / 4000)    /* 250us */
+#define SIM_QUEUE           8
+
+static TIM_TypeDef g_tim;
+static DMA_Channel_TypeDef g_dma_ch;
+static TIM_HandleTypeDef g_htim = {&g_tim};
+static DMA_HandleTypeDef g_hdma = {&g_dma_ch, NULL, NULL};
+static pseq_t g_pseq;
+
+/* Model state */
+static uint32_t g_arr_s, g_ccr_s, g_rep;    /* Shadows of ARR, CCR1, and the repetition counter */
+static uint16_t *g_dma_mem;                 /* Ring of the DMA */
+static uint32_t g_dma_len;
+static uint8_t g_dma_on;
+static uint64_t g_now;                      /* Ticks */
+static uint64_t g_queue[SIM_QUEUE];         /* Times the pending interrupts run */
+static uint8_t g_queue_tc[SIM_QUEUE];       /* 1, transfer complete; 0, half transfer */
+static uint32_t g_queue_head, g_queue_num;
+static uint64_t g_last_irq;
+static uint32_t g_latency, g_latency_min;  /* Ticks from an event to its interrupt */
+
+static int g_verbose = 0;
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+/******************************************************************************************/
+/* HAL of the model */
+
+void TIM_CCxChannelCmd(TIM_TypeDef *TIMx, uint32_t Channel, uint32_t ChannelState)
+{
+    TIMx->CCER = (TIMx->CCER & ~(1u << Channel)) | (ChannelState << Channel);
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+    (void)SrcAddress;                       /* 32-bit addresses: the model takes the ring of g_pseq */
+    (void)DstAddress;
+
+    if (g_dma_on)return HAL_ERROR;
+
+    g_dma_mem = (uint16_t *)g_pseq.ring;
+    g_dma_len = DataLength;
+    hdma->Instance->CNDTR = DataLength;
+    g_dma_on = 1;
+    g_queue_num = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+    (void)hdma;
+    g_dma_on = 0;
+    g_queue_num = 0;                        /* Flags cleared, nothing more is called */
+    return HAL_OK;
+}
+
+/******************************************************************************************/
+/* Model of TIM8 and DMA2 channel1 */
+
+/**
+ * @brief       Interrupt of the DMA, run a random latency after its event and after the previous one
+ */
+static void sim_irq_queue(uint8_t tc)
+{
+    uint64_t t = g_now + g_latency_min + rand() % (g_latency - g_latency_min + 1);
+
+    if (t < g_last_irq)t = g_last_irq;
+
+    g_last_irq = t;
+
+    if (g_queue_num < SIM_QUEUE)
+    {
+        g_queue[(g_queue_head + g_queue_num) % SIM_QUEUE] = t;
+        g_queue_tc[(g_queue_head + g_queue_num) % SIM_QUEUE] = tc;
+        g_queue_num++;
+    }
+}
+
+/**
+ * @brief       Update event: shadows loaded, then the DMA burst to the preload registers
+ */
+static void sim_update(void)
+{
+    uint32_t *reg = (uint32_t *)&g_tim;
+    uint32_t dba = g_tim.DCR & 0x1F, dbl = ((g_tim.DCR >> 8) & 0x1F) + 1, i;
+
+    g_arr_s = g_tim.ARR;
+    g_ccr_s = g_tim.CCR1;
+    g_rep = g_tim.RCR & 0xFF;
+
+    if ((g_tim.DIER & TIM_DIER_UDE) == 0 || g_dma_on == 0)return;
+
+    for (i = 0; i < dbl; i++)
+    {
+        reg[dba + i] = g_dma_mem[g_dma_len - g_dma_ch.CNDTR];
+
+        if (--g_dma_ch.CNDTR == g_dma_len / 2)sim_irq_queue(0);
+
+        if (g_dma_ch.CNDTR == 0)
+        {
+            g_dma_ch.CNDTR = g_dma_len;     /* Circular */
+            sim_irq_queue(1);
+        }
+    }
+}
+
+/**
+ * @brief       Register writes of the code that the model has to act on: UG
+ */
+static void sim_regs(void)
+{
+    if (g_tim.EGR & TIM_EGR_UG)
+    {
+        g_tim.EGR = 0;
+        sim_update();
+    }
+}
+
+/******************************************************************************************/
+/* Expected output */
+
+typedef struct
+{
+    pseq_fill_t fill;
+    void *arg;
+    pseq_step_t step;
+    uint32_t left;                          /* Pulses left of step */
+    uint8_t done;
+    uint32_t pulses;
+} sim_ref_t;
+
+/**
+ * @brief       Next expected pulse
+ * @retval      1, pulse in arr/ccr; 0, the source is over
+ */
+static uint8_t sim_ref_next(sim_ref_t *ref, uint32_t *period, uint32_t *high)
+{
+    if (ref->left == 0)
+    {
+        if (ref->done || ref->fill(&ref->step, 1, ref->arg) == 0)
+        {
+            ref->done = 1;
+            return 0;
+        }
+
+        ref->left = ref->step.rcr + 1;
+    }
+
+    ref->left--;
+    ref->pulses++;
+    *period = ref->step.arr + 1;
+    *high = (ref->step.ccr < *period) ? ref->step.ccr : *period;
+    return 1;
+}
+
+/**
+ * @brief       Runs a sequence through the model and compares every period with ref
+ * @param       late : 1, interrupts too late are expected, only underrun is checked
+ * @retval      Periods that differ from ref
+ */
+static uint32_t sim_run(const char *name, pseq_fill_t fill, void *arg, sim_ref_t *ref, uint8_t late)
+{
+    uint32_t period, high, exp_period, exp_high, bad = 0, idle = 0, n = 0;
+    uint64_t end, t0;
+    uint8_t tc, over = 0;
+
+    g_now = g_last_irq = 0;
+    g_dma_on = 0;
+    g_queue_num = 0;
+    pseq_init(&g_pseq, &g_htim, &g_hdma);
+    sim_regs();
+    CHECK(g_ccr_s == 0 && (g_tim.CR1 & TIM_CR1_CEN) == 0, "%s: output not low after pseq_init", name);
+    CHECK(pseq_tick_hz(&g_pseq) == SIM_TICK_HZ, "%s: pseq_tick_hz %u", name, pseq_tick_hz(&g_pseq));
+
+    if (pseq_start(&g_pseq, fill, arg) != 0)
+    {
+        CHECK(0, "%s: pseq_start failed", name);
+        return 1;
+    }
+
+    sim_regs();
+
+    while (g_tim.CR1 & TIM_CR1_CEN)
+    {
+        t0 = g_now;
+        period = g_arr_s + 1;
+        end = t0 + period;
+
+        /* Interrupts during the period: they can stop the timer */
+        while (g_queue_num && g_queue[g_queue_head] < end && (g_tim.CR1 & TIM_CR1_CEN))
+        {
+            g_now = (g_queue[g_queue_head] > t0) ? g_queue[g_queue_head] : t0;
+            tc = g_queue_tc[g_queue_head];
+            g_queue_head = (g_queue_head + 1) % SIM_QUEUE;
+            g_queue_num--;
+
+            if (tc)g_hdma.XferCpltCallback(&g_hdma);
+            else g_hdma.XferHalfCpltCallback(&g_hdma);
+        }
+
+        if ((g_tim.CR1 & TIM_CR1_CEN) == 0)
+        {
+            /* Stopped in the middle of the period: it must have been an idle one */
+            if (g_now - t0 > 0 && g_ccr_s != 0 && !late)
+            {
+                CHECK(0, "%s: stopped in a pulse of step ccr %u", name, g_ccr_s);
+                bad++;
+            }
+
+            sim_regs();
+            break;
+        }
+
+        g_now = end;
+        high = (g_ccr_s < period) ? g_ccr_s : period;
+        n++;
+
+        if (!over)
+        {
+            if (sim_ref_next(ref, &exp_period, &exp_high))
+            {
+                if (period != exp_period || high != exp_high)
+                {
+                    if (bad++ == 0 && !late)
+                    {
+                        printf("%s: period %u, pulse %u: %u/%u ticks, expected %u/%u\n", name, n, ref->pulses, period, high, exp_period, exp_high);
+                    }
+                }
+            }
+            else
+            {
+                over = 1;
+            }
+        }
+
+        if (over)
+        {
+            if (high != 0)bad++;                /* After the last step the output stays low */
+
+            if (++idle > 4 * PSEQ_RING_LEN)break;   /* The engine never stopped */
+        }
+
+        if (g_rep == 0)sim_update();
+        else g_rep--;
+    }
+
+    if (!over && sim_ref_next(ref, &exp_period, &exp_high))bad++;   /* Steps left out */
+
+    if (late)
+    {
+        /* A wrong output is always counted, a late interrupt too */
+        CHECK(bad == 0 || g_pseq.underrun > 0, "%s: %u periods differ, no underrun counted", name, bad);
+        CHECK(g_latency_min <= PSEQ_TICKS_MIN * PSEQ_RING_LEN / 2 || g_pseq.underrun > 0,
+              "%s: interrupts %u ticks late, no underrun counted", name, g_latency_min);
+    }
+    else
+    {
+        CHECK(bad == 0, "%s: %u periods differ from the steps", name, bad);
+        CHECK((g_tim.CR1 & TIM_CR1_CEN) == 0 && pseq_busy(&g_pseq) == 0, "%s: not stopped after %u idle periods", name, idle);
+        CHECK(g_pseq.pulses == ref->pulses, "%s: pulses %u, sent %u", name, g_pseq.pulses, ref->pulses);
+        CHECK(g_pseq.underrun == 0, "%s: underrun %u", name, g_pseq.underrun);
+        CHECK(g_ccr_s == 0, "%s: output not low after the stop", name);
+    }
+
+    if (g_verbose)
+    {
+        printf("%-32s %7u pulses, %5u idle periods, %9.3fms, underrun %u\n", name, ref->pulses, idle, g_now * 1000.0 / SIM_TICK_HZ, g_pseq.underrun);
+    }
+
+    return bad;
+}
+
+/******************************************************************************************/
+/* Sequences */
+
+static pseq_step_t g_table[300];
+
+/**
+ * @brief       Table sequences of 1 to 300 random steps
+ */
+static void sim_tables(uint32_t runs)
+{
+    pseq_table_t tb, tb_ref;
+    sim_ref_t ref;
+    char name[40];
+    uint32_t r, i, num;
+
+    for (r = 0; r < runs; r++)
+    {
+        num = (r < 3) ? r + 1 : 1 + (uint32_t)rand() % 300;
+
+        for (i = 0; i < num; i++)
+        {
+            g_table[i].arr = PSEQ_TICKS_MIN - 1 + ((rand() & 3) ? rand() % 2000 : rand() % (65536 - PSEQ_TICKS_MIN));
+            g_table[i].rcr = (rand() & 1) ? 0 : rand() % 256;
+            g_table[i].ccr = (rand() % 8 == 0) ? 0 : 1 + rand() % (g_table[i].arr + 1);
+        }
+
+        pseq_table_init(&tb, g_table, num);
+        pseq_table_init(&tb_ref, g_table, num);
+        memset(&ref, 0, sizeof(ref));
+        ref.fill = pseq_table_fill;
+        ref.arg = &tb_ref;
+        sprintf(name, "table of %u steps", num);
+        sim_run(name, pseq_table_fill, &tb, &ref, 0);
+    }
+}
+
+/**
+ * @brief       Steps and ramps of an S-curve move, from a copy of the move: the pulses make the
+ *              steps, the periods shorten in the acceleration and lengthen in the deceleration, which
+ *              has as many steps, and the cruise period is the one of v1
+ */
+static void sim_scurve_shape(const char *name, pseq_scurve_t *r, uint32_t v1)
+{
+    pseq_step_t s;
+    uint32_t pulses = 0, dec = 0, prev = 0, iv, iv_min = 0xFFFFFFFF;
+    uint8_t order = 1, phase = 0;
+
+    while (pseq_scurve_fill(&s, 1, r))      /* r->phase is the one of the step */
+    {
+        iv = s.arr + 1;
+        pulses += s.rcr + 1;
+
+        if (iv < iv_min)iv_min = iv;
+
+        if (r->phase != phase)prev = 0;
+
+        if (r->phase == 0 && prev && iv > prev)order = 0;
+
+        if (r->phase == 2)
+        {
+            if (prev && iv < prev)order = 0;
+
+            dec++;
+        }
+
+        phase = r->phase;
+        prev = iv;
+    }
+
+    CHECK(pulses == r->steps, "%s: %u pulses for %u steps", name, pulses, r->steps);
+    CHECK(order, "%s: ramp periods out of order", name);
+    CHECK(dec == r->ramp, "%s: deceleration of %u steps, acceleration %u", name, dec, r->ramp);
+    CHECK(iv_min >= PSEQ_TICKS_MIN && iv_min >= SIM_TICK_HZ / v1, "%s: shortest period %u ticks, cruise %u steps/s", name, iv_min, v1);
+}
+
+/**
+ * @brief       S-curve moves of 1 to 200000 steps, the move of main.c first
+ */
+static void sim_scurves(uint32_t runs)
+{
+    pseq_scurve_t mv, mv_ref, mv_shape;
+    sim_ref_t ref;
+    char name[40];
+    uint32_t r, steps, v0, v1;
+    uint16_t ramp;
+
+    for (r = 0; r < runs; r++)
+    {
+        if (r == 0)
+        {
+            steps = 20000, v0 = 500, v1 = 50000, ramp = 200;
+        }
+        else
+        {
+            steps = (r < 4) ? r : (rand() & 1) ? 1 + (uint32_t)rand() % 2000 : 1 + (uint32_t)rand() % 200000;
+            v0 = 200 + rand() % 2000;
+            v1 = v0 + rand() % (SIM_TICK_HZ / PSEQ_TICKS_MIN - v0);
+            ramp = 1 + rand() % 500;
+        }
+
+        CHECK(pseq_scurve_init(&mv, SIM_TICK_HZ, steps, v0, v1, ramp) == 0, "pseq_scurve_init");
+        mv_ref = mv_shape = mv;
+        sprintf(name, "move %u, %u~%u/s, %ums", steps, v0, v1, ramp);
+        sim_scurve_shape(name, &mv_shape, v1);
+        memset(&ref, 0, sizeof(ref));
+        ref.fill = pseq_scurve_fill;
+        ref.arg = &mv_ref;
+        sim_run(name, pseq_scurve_fill, &mv, &ref, 0);
+    }
+}
+
+/**
+ * @brief       Shortest steps with interrupts up to 7/4 of a half late (the detection works up to a
+ *              whole ring): a wrong output must be counted in underrun. The first run is always
+ *              more than a half late
+ */
+static void sim_late(uint32_t runs)
+{
+    pseq_table_t tb, tb_ref;
+    sim_ref_t ref;
+    uint32_t half = PSEQ_TICKS_MIN * PSEQ_RING_LEN / 2, i, r, bad = 0;
+
+    for (i = 0; i < 300; i++)
+    {
+        g_table[i].arr = PSEQ_TICKS_MIN - 1;
+        g_table[i].rcr = 0;
+        g_table[i].ccr = 1 + i % (PSEQ_TICKS_MIN - 1);
+    }
+
+    for (r = 0; r < runs; r++)
+    {
+        g_latency_min = (r == 0) ? half * 5 / 4 : 0;
+        g_latency = half * 7 / 4;
+        pseq_table_init(&tb, g_table, 300);
+        pseq_table_init(&tb_ref, g_table, 300);
+        memset(&ref, 0, sizeof(ref));
+        ref.fill = pseq_table_fill;
+        ref.arg = &tb_ref;
+        bad += (sim_run("late interrupts", pseq_table_fill, &tb, &ref, 1) != 0);
+    }
+
+    printf("late interrupts: %u of %u sequences wrong, all of them counted in underrun\n", bad, runs);
+    g_latency_min = 0;
+    g_latency = SIM_LATENCY;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned seed = 1;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)g_verbose = 1;
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)seed = strtoul(argv[++i], NULL, 0);
+    }
+
+    srand(seed);
+    g_tim.PSC = SIM_PSC;
+    g_latency = SIM_LATENCY;
+
+    sim_tables(300);
+    sim_scurves(200);
+    sim_late(100);
+
+    printf("seed %u: 300 tables, 200 moves, interrupt latency up to %uus\n", seed, SIM_LATENCY * 1000000 / SIM_TICK_HZ);
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+    return g_fails ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+/**
+ ****************************************************************************************************
+ * @file        svpwm.c
+ * @author      ALIENTEK
+ * @brief       Center-aligned three-phase space vector PWM, ADC sampling at the PWM center and control loop
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stddef.h>
+#include "svpwm.h"
+
+
+/*
+ * In sector k (1 ~ 6) the vector lies between the active vectors Vk and Vk+1, at the angle phi from Vk.
+ * For a length m (SVPWM_ONE = Vdc / sqrt(3)), their times in a period are
+ *     T1 = m * sin(60 - phi)      (Vk)
+ *     T2 = m * sin(phi)           (Vk+1)
+ * and the zero vectors share the rest, half at the valley (111) and half at the peak (000). The phase
+ * of the sector that is high in both vectors gets T1 + T2 + T0 / 2, the one high in one of them gets
+ * T1 or T2 + T0 / 2, and the last one T0 / 2.
+ */
+
+/* sin(x) for x from 0 to 60 degrees, Q15 */
+static const uint16_t g_svpwm_sin[(1 << SVPWM_SIN_BITS) + 1] =
+{
+        0,   268,   536,   804,  1072,  1340,  1608,  1876,
+     2143,  2411,  2678,  2945,  3212,  3479,  3745,  4011,
+     4277,  4543,  4808,  5073,  5338,  5602,  5866,  6130,
+     6393,  6655,  6918,  7180,  7441,  7702,  7962,  8222,
+     8481,  8740,  8998,  9255,  9512,  9768, 10024, 10279,
+    10533, 10786, 11039, 11291, 11543, 11793, 12043, 12292,
+    12540, 12787, 13033, 13279, 13524, 13767, 14010, 14252,
+    14493, 14733, 14972, 15210, 15447, 15683, 15917, 16151,
+    16384, 16616, 16846, 17075, 17304, 17531, 17757, 17981,
+    18205, 18427, 18648, 18868, 19087, 19304, 19520, 19735,
+    19948, 20160, 20371, 20580, 20788, 20994, 21199, 21403,
+    21605, 21806, 22006, 22204, 22400, 22595, 22788, 22980,
+    23170, 23359, 23546, 23732, 23916, 24099, 24279, 24459,
+    24636, 24812, 24986, 25159, 25330, 25499, 25667, 25833,
+    25997, 26159, 26320, 26478, 26635, 26791, 26944, 27096,
+    27246, 27394, 27540, 27684, 27827, 27967, 28106, 28243,
+    28378,
+};
+
+/* sin and cos of the angle of Vk, k = 1 ~ 6, Q15 */
+static const int32_t g_svpwm_vk_sin[6] = {0, 28378, 28378, 0, -28378, -28378};
+static const int32_t g_svpwm_vk_cos[6] = {32768, 16384, -16384, -32768, -16384, 16384};
+
+/* Phases of a sector: 0 = a, 1 = b, 2 = c. The middle phase gets T1 in the even sectors, T2 in the odd ones */
+static const uint8_t g_svpwm_max[6] = {0, 1, 1, 2, 2, 0};
+static const uint8_t g_svpwm_mid[6] = {1, 0, 2, 1, 0, 2};
+
+static svpwm_t *g_svpwm_dev;
+
+/**
+ * @brief       Sine in a sector
+ * @param       x : angle, 65536 is 60 degrees
+ * @retval      sin(x), Q15
+ */
+static uint32_t svpwm_sin60(uint32_t x)
+{
+    uint32_t i = x >> (16 - SVPWM_SIN_BITS);
+    uint32_t f = x & ((1 << (16 - SVPWM_SIN_BITS)) - 1);
+
+    if (i >= (1 << SVPWM_SIN_BITS))return g_svpwm_sin[1 << SVPWM_SIN_BITS];
+
+    return g_svpwm_sin[i] + (((g_svpwm_sin[i + 1] - g_svpwm_sin[i]) * f) >> (16 - SVPWM_SIN_BITS));
+}
+
+/**
+ * @brief       Duties of the three phases from the times of the two active vectors
+ * @param       sector : 1 ~ 6
+ * @param       t1 : time of Vk, Q15 of the period
+ * @param       t2 : time of Vk+1, Q15 of the period
+ * @param       d : duties
+ * @retval      None
+ */
+static void svpwm_phases(uint8_t sector, int32_t t1, int32_t t2, svpwm_duty_t *d)
+{
+    uint16_t duty[3];
+    uint32_t t0h;
+
+    if (t1 < 0)t1 = 0;                  /* Rounding at the edges of the sector */
+
+    if (t2 < 0)t2 = 0;
+
+    if (t1 + t2 > SVPWM_ONE)            /* Over the hexagon: same angle, length cut to the edge */
+    {
+        t1 = (int32_t)(((int64_t)t1 * SVPWM_ONE) / (t1 + t2));
+        t2 = SVPWM_ONE - t1;
+    }
+
+    t0h = (SVPWM_ONE - t1 - t2) >> 1;
+    duty[0] = duty[1] = duty[2] = t0h;
+    duty[g_svpwm_max[sector - 1]] = t1 + t2 + t0h;
+    duty[g_svpwm_mid[sector - 1]] = ((sector & 1) ? t2 : t1) + t0h;
+
+    d->a = duty[0];
+    d->b = duty[1];
+    d->c = duty[2];
+    d->sector = sector;
+}
+
+/**
+ * @brief       Space vector duties of a vector given by its angle and length
+ * @param       angle : 65536 per turn, 0 on phase a
+ * @param       m : length, SVPWM_ONE is the circle of the linear range, up to SVPWM_M_MAX (hexagon)
+ * @param       d : duties
+ * @retval      None
+ */
+void svpwm_polar(uint16_t angle, uint16_t m, svpwm_duty_t *d)
+{
+    uint32_t x = (uint32_t)angle * 6;
+    uint32_t phi = x & 0xFFFF;          /* Angle from Vk, 65536 is 60 degrees */
+
+    svpwm_phases((x >> 16) + 1, (int32_t)((m * svpwm_sin60(65536 - phi)) >> 15), (int32_t)((m * svpwm_sin60(phi)) >> 15), d);
+}
+
+/**
+ * @brief       Space vector duties of a vector given in the stationary frame (inverse Park output)
+ * @param       alpha : Q15, 32767 is the circle of the linear range
+ * @param       beta : Q15
+ * @param       d : duties
+ * @retval      None
+ */
+void svpwm_ab(int16_t alpha, int16_t beta, svpwm_duty_t *d)
+{
+    static const uint8_t sector_of[8] = {1, 2, 6, 1, 4, 3, 5, 1};  /* From the signs of the three line voltages */
+    int32_t a3 = 28378 * (int32_t)alpha;                            /* sqrt(3) / 2 * alpha, Q30 */
+    int32_t b2 = 16384 * (int32_t)beta;                             /* beta / 2, Q30 */
+    uint8_t n = 0;
+    uint8_t k, k1;
+
+    if (beta > 0)n |= 1;
+
+    if (a3 - b2 > 0)n |= 2;
+
+    if (-a3 - b2 > 0)n |= 4;
+
+    k = sector_of[n] - 1;
+    k1 = (k + 1) % 6;
+    svpwm_phases(k + 1,
+                 (alpha * g_svpwm_vk_sin[k1] - beta * g_svpwm_vk_cos[k1]) >> 15,
+                 (beta * g_svpwm_vk_cos[k] - alpha * g_svpwm_vk_sin[k]) >> 15, d);
+}
+
+/**
+ * @brief       Sets the timer and the ADC up, the outputs stay off
+ * @param       s : modulator
+ * @param       htim : advanced timer, center-aligned, RCR = 1 so that the update is at the valley
+ * @param       hadc : injected group triggered by TRGO = OC4REF of htim
+ * @retval      None
+ */
+void svpwm_init(svpwm_t *s, TIM_HandleTypeDef *htim, ADC_HandleTypeDef *hadc)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    svpwm_duty_t d = {SVPWM_ONE / 2, SVPWM_ONE / 2, SVPWM_ONE / 2, 1};
+
+    s->htim = htim;
+    s->hadc = hadc;
+    s->loop = NULL;
+    s->arg = NULL;
+    s->budget = tim->ARR * (tim->PSC + 1);  /* TIM1 runs at HCLK */
+    svpwm_reset_stat(s);
+    g_svpwm_dev = s;
+
+    SVPWM_CYCLES_INIT();
+    tim->CCR4 = tim->ARR - 1;               /* PWM mode 2: OC4REF rises one tick before the peak */
+    svpwm_set(s, &d);
+}
+
+/**
+ * @brief       Starts the PWM, the sampling and the control loop. The outputs stay off.
+ * @param       s : modulator
+ * @param       loop : control loop, called once per period from the ADC interrupt, NULL: none
+ * @param       arg : argument of loop
+ * @retval      None
+ */
+void svpwm_start(svpwm_t *s, svpwm_loop_t loop, void *arg)
+{
+    s->loop = loop;
+    s->arg = arg;
+
+    HAL_ADCEx_InjectedStart_IT(s->hadc);
+
+    /* Not HAL_TIM_PWM_Start, which sets MOE: with MOE = 0 and OSSI = 1 the six outputs are held off */
+    s->htim->Instance->CCER |= TIM_CCER_CC1E | TIM_CCER_CC1NE | TIM_CCER_CC2E | TIM_CCER_CC2NE |
+                               TIM_CCER_CC3E | TIM_CCER_CC3NE | TIM_CCER_CC4E;
+    __HAL_TIM_ENABLE(s->htim);
+}
+
+/**
+ * @brief       Drives or releases the outputs
+ * @param       s : modulator
+ * @param       on : 1, PWM on the six outputs; 0, all the switches off. A break also turns them off.
+ * @retval      None
+ */
+void svpwm_output(svpwm_t *s, uint8_t on)
+{
+    if (on)
+    {
+        __HAL_TIM_MOE_ENABLE(s->htim);
+    }
+    else
+    {
+        __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(s->htim);
+    }
+}
+
+/**
+ * @brief       Writes the duties, the timer loads them at the next valley
+ * @param       s : modulator
+ * @param       d : duties
+ * @retval      None
+ */
+void svpwm_set(svpwm_t *s, const svpwm_duty_t *d)
+{
+    TIM_TypeDef *tim = s->htim->Instance;
+    uint32_t arr = tim->ARR;
+
+    tim->CCR1 = (d->a * arr + SVPWM_ONE / 2) >> 15;
+    tim->CCR2 = (d->b * arr + SVPWM_ONE / 2) >> 15;
+    tim->CCR3 = (d->c * arr + SVPWM_ONE / 2) >> 15;
+}
+
+/**
+ * @brief       End of the injected sequence: runs the control loop and measures its time
+ * @param       hadc : ADC handle
+ * @retval      None
+ */
+void svpwm_injected(ADC_HandleTypeDef *hadc)
+{
+    svpwm_t *s = g_svpwm_dev;
+    TIM_TypeDef *tim;
+    uint32_t t0, cyc, ticks;
+
+    if (s == NULL || s->hadc != hadc)return;
+
+    t0 = SVPWM_CYCLES();
+    tim = s->htim->Instance;
+
+    /* The HAL stops this interrupt after each sequence when the regular group is started by software */
+    __HAL_ADC_ENABLE_IT(hadc, ADC_IT_JEOC);
+
+    s->adc[0] = hadc->Instance->JDR1;
+    s->adc[1] = hadc->Instance->JDR2;
+    s->adc[2] = hadc->Instance->JDR3;
+
+    if (s->loop)s->loop(s, s->adc, s->arg);
+
+    cyc = SVPWM_CYCLES() - t0;
+    ticks = tim->CNT;
+
+    if (tim->CR1 & TIM_CR1_DIR)             /* Still counting down to the valley */
+    {
+        ticks = tim->ARR - ticks;
+    }
+    else
+    {
+        ticks = tim->ARR + ticks;
+        s->overrun++;
+    }
+
+    s->cyc = cyc;
+    s->used = ticks * (tim->PSC + 1);
+
+    if (cyc > s->cyc_max)s->cyc_max = cyc;
+
+    if (s->used > s->used_max)s->used_max = s->used;
+
+    s->runs++;
+}
+
+/**
+ * @brief       Clears the counters and the maximums
+ * @param       s : modulator
+ * @retval      None
+ */
+void svpwm_reset_stat(svpwm_t *s)
+{
+    s->runs = 0;
+    s->overrun = 0;
+    s->cyc = 0;
+    s->cyc_max = 0;
+    s->used = 0;
+    s->used_max = 0;
+}
@@ -0,0 +1,84 @@
+/**
+ ****************************************************************************************************
+ * @file        svpwm.h
+ * @author      ALIENTEK
+ * @brief       Center-aligned three-phase space vector PWM, ADC sampling at the PWM center and control loop
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SVPWM_H
+#define __SVPWM_H
+
+#include "main.h"
+
+
+/* Cycle counter: the DWT of the Cortex-M3. A host build defines both macros with its own clock */
+#ifndef SVPWM_CYCLES
+#define SVPWM_CYCLES_INIT()     do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#define SVPWM_CYCLES()          (DWT->CYCCNT)
+#endif
+
+#define SVPWM_ONE               32768   /* Duty of 1 and length of the vector at the limit of the linear range, Q15 */
+#define SVPWM_M_MAX             37837   /* Length at the corners of the hexagon: 2 / sqrt(3), Q15 */
+#define SVPWM_SIN_BITS          7       /* Sine table of 2^7 points per sector, linear interpolation in between */
+#define SVPWM_ADC_NUM           3       /* Injected ranks, one per phase */
+
+/*
+ * Duties of the high sides, 0 ~ SVPWM_ONE. In center-aligned mode 1 with PWM mode 1, a phase is high
+ * while CNT < CCR, so the three pulses are centered on the valley of the counter and all the low sides
+ * are on around the peak, where the ADC samples the shunts.
+ */
+typedef struct
+{
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+    uint8_t sector;                     /* 1 ~ 6 */
+} svpwm_duty_t;
+
+typedef struct svpwm svpwm_t;
+
+/* Control loop, once per PWM period. adc: the injected ranks, sampled at the peak of the counter */
+typedef void (*svpwm_loop_t)(svpwm_t *s, const uint16_t *adc, void *arg);
+
+struct svpwm
+{
+    TIM_HandleTypeDef *htim;            /* Center-aligned, CH1 ~ CH3 complementary, CH4 TRGO trigger */
+    ADC_HandleTypeDef *hadc;            /* Injected group triggered by the TRGO of htim */
+    svpwm_loop_t loop;
+    void *arg;
+    uint16_t adc[SVPWM_ADC_NUM];        /* Last samples */
+    uint32_t budget;                    /* Half a period, from the sampling point to the valley, in CPU cycles */
+    volatile uint32_t runs;             /* Control loops run */
+    volatile uint32_t overrun;          /* Loops done after the valley: their duties are a period late */
+    volatile uint32_t cyc;              /* Cycles of the last loop function */
+    volatile uint32_t cyc_max;
+    volatile uint32_t used;             /* Cycles from the sampling point to the end of the last loop */
+    volatile uint32_t used_max;
+};
+
+/* Space vector modulation */
+void svpwm_polar(uint16_t angle, uint16_t m, svpwm_duty_t *d);          /* angle: 65536 per turn; m: length, SVPWM_ONE is the linear limit */
+void svpwm_ab(int16_t alpha, int16_t beta, svpwm_duty_t *d);            /* Stationary frame, Q15, 32767 is the linear limit */
+
+/* Timer and ADC */
+void svpwm_init(svpwm_t *s, TIM_HandleTypeDef *htim, ADC_HandleTypeDef *hadc);
+void svpwm_start(svpwm_t *s, svpwm_loop_t loop, void *arg);             /* Starts the PWM and the loop, outputs off */
+void svpwm_output(svpwm_t *s, uint8_t on);                              /* Drives or releases the six outputs (MOE) */
+void svpwm_set(svpwm_t *s, const svpwm_duty_t *d);                      /* New duties, loaded at the next valley */
+void svpwm_injected(ADC_HandleTypeDef *hadc);                           /* Call from HAL_ADCEx_InjectedConvCpltCallback */
+void svpwm_reset_stat(svpwm_t *s);
+
+#endif
@@ -29,13 +29,15 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "adc.h"                                  /* hadc1 and the SVPWM module */
 /* USER CODE END Includes */
 
 extern TIM_HandleTypeDef htim1;
 
 /* USER CODE BEGIN Private defines */
 
+extern svpwm_t g_svpwm;
+
 /* USER CODE END Private defines */
 
 void MX_TIM1_Init(void);
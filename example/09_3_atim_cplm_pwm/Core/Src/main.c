@@ -15,12 +15,14 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     three-phase space vector PWM, ADC sampling at the PWM center, control loop
  *
  ****************************************************************************************************
  */
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "adc.h"
 #include "tim.h"
 #include "usart.h"
 #include "gpio.h"
@@ -34,11 +36,25 @@
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
 
+/* Open-loop V/f drive, run by the control loop */
+typedef struct
+{
+    uint32_t phase;                     /* Electrical angle, 2^32 per turn */
+    volatile uint32_t step;             /* Angle per PWM period */
+    volatile uint16_t m;                /* Length of the voltage vector, SVPWM_ONE is the linear limit */
+    svpwm_duty_t duty;                  /* Last duties */
+} vf_drive_t;
+
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 
+#define PWM_HZ          20000           /* 72MHz / (2 * 1800), center-aligned */
+#define VF_HZ_MAX       50              /* Rated frequency, full voltage */
+#define VF_M_MIN        1638            /* Voltage boost at low speed, 5% */
+#define VF_M_MAX        29491           /* 90% of the linear range leaves time to sample the low sides */
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -50,6 +66,9 @@
 
 /* USER CODE BEGIN PV */
 
+static vf_drive_t g_vf;
+static const uint8_t g_vf_hz[] = {0, 5, 10, 25, 50};
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -61,6 +80,33 @@ void SystemClock_Config(void);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+/**
+ * @brief       Control loop, once per PWM period: turns the voltage vector of the V/f drive
+ * @param       s : modulator
+ * @param       adc : phase currents sampled at the center of the period
+ * @param       arg : V/f drive
+ * @retval      None
+ */
+static void vf_loop(svpwm_t *s, const uint16_t *adc, void *arg)
+{
+    vf_drive_t *vf = arg;
+
+    vf->phase += vf->step;
+    svpwm_polar(vf->phase >> 16, vf->m, &vf->duty);
+    svpwm_set(s, &vf->duty);
+}
+
+/**
+ * @brief       Sets the frequency of the V/f drive, the voltage follows it
+ * @param       hz : electrical frequency, 0 ~ VF_HZ_MAX
+ * @retval      None
+ */
+static void vf_set(uint8_t hz)
+{
+    g_vf.step = (uint32_t)(((uint64_t)hz << 32) / PWM_HZ);
+    g_vf.m = hz ? VF_M_MIN + (VF_M_MAX - VF_M_MIN) * hz / VF_HZ_MAX : 0;
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -70,6 +116,9 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
+    uint8_t key;
+    uint8_t idx = 0;
+    uint8_t on = 0;
     uint8_t t = 0;
   /* USER CODE END 1 */
 
@@ -92,8 +141,11 @@ int main(void)
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_USART1_UART_Init();
+  MX_ADC1_Init();
   MX_TIM1_Init();
   /* USER CODE BEGIN 2 */
+  vf_set(0);
+  svpwm_start(&g_svpwm, vf_loop, &g_vf);          /* PWM, sampling and control loop run, outputs off */
 
   /* USER CODE END 2 */
 
@@ -102,10 +154,30 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-    if (++t == 20)
+    key = key_scan(0);
+
+    if (key == KEY0_PRES)                       /* KEY0: next frequency */
+    {
+      idx = (idx + 1) % sizeof(g_vf_hz);
+      vf_set(g_vf_hz[idx]);
+    }
+    else if (key == WKUP_PRES)                  /* WKUP: outputs on / off */
+    {
+      on = !on;
+      svpwm_output(&g_svpwm, on);
+    }
+
+    if (++t == 20)                              /* Every 200ms */
     {
       t = 0;
       LED0_TOGGLE();
+      printf("\r\nV/f %uHz m %u outputs %s\r\n", g_vf_hz[idx], g_vf.m, on ? "on" : "off");
+      printf("Sector %u duty %u %u %u\r\n", g_vf.duty.sector, g_vf.duty.a, g_vf.duty.b, g_vf.duty.c);
+      printf("ADC    %u %u %u\r\n", g_svpwm.adc[0], g_svpwm.adc[1], g_svpwm.adc[2]);
+      printf("Loop   %lu cycles, max %lu\r\n", g_svpwm.cyc, g_svpwm.cyc_max);
+      printf("Used   %lu of %lu cycles, max %lu, overrun %lu in %lu\r\n",
+             g_svpwm.used, g_svpwm.budget, g_svpwm.used_max, g_svpwm.overrun, g_svpwm.runs);
+      svpwm_reset_stat(&g_svpwm);
     }
 
     HAL_Delay(10);     /* delay 10ms */
@@ -122,6 +194,7 @@ void SystemClock_Config(void)
 {
   RCC_OscInitTypeDef RCC_OscInitStruct = {0};
   RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+  RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
 
   /** Initializes the RCC Oscillators according to the specified parameters
   * in the RCC_OscInitTypeDef structure.
@@ -151,6 +224,12 @@ void SystemClock_Config(void)
   {
     Error_Handler();
   }
+  PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_ADC;
+  PeriphClkInit.AdcClockSelection = RCC_ADCPCLK2_DIV6;
+  if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
+  {
+    Error_Handler();
+  }
 }
 
 /* USER CODE BEGIN 4 */
@@ -0,0 +1,91 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host build (tools/svpwm_check.c): the TIM1 and ADC1 parts of the HAL that
+ *              svpwm.c uses, and the cycle counter of the model
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR = 1
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    volatile uint32_t CR1;
+    volatile uint32_t CCER;
+    volatile uint32_t CNT;
+    volatile uint32_t PSC;
+    volatile uint32_t ARR;
+    volatile uint32_t CCR1;
+    volatile uint32_t CCR2;
+    volatile uint32_t CCR3;
+    volatile uint32_t CCR4;
+    volatile uint32_t BDTR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CR1;
+    volatile uint32_t JDR1;
+    volatile uint32_t JDR2;
+    volatile uint32_t JDR3;
+} ADC_TypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+typedef struct
+{
+    ADC_TypeDef *Instance;
+} ADC_HandleTypeDef;
+
+#define TIM_CR1_CEN         0x0001
+#define TIM_CR1_DIR         0x0010
+#define TIM_CCER_CC1E       0x0001
+#define TIM_CCER_CC1NE      0x0004
+#define TIM_CCER_CC2E       0x0010
+#define TIM_CCER_CC2NE      0x0040
+#define TIM_CCER_CC3E       0x0100
+#define TIM_CCER_CC3NE      0x0400
+#define TIM_CCER_CC4E       0x1000
+#define TIM_BDTR_MOE        0x8000
+#define ADC_IT_JEOC         0x0080
+
+#define __HAL_TIM_ENABLE(h)                         ((h)->Instance->CR1 |= TIM_CR1_CEN)
+#define __HAL_TIM_MOE_ENABLE(h)                     ((h)->Instance->BDTR |= TIM_BDTR_MOE)
+#define __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(h)    ((h)->Instance->BDTR &= ~TIM_BDTR_MOE)
+#define __HAL_ADC_ENABLE_IT(h, it)                  ((h)->Instance->CR1 |= (it))
+
+/* tools/svpwm_check.c: CPU cycles of the model */
+extern uint32_t g_sim_cycles;
+
+#define SVPWM_CYCLES_INIT()     do { } while (0)
+#define SVPWM_CYCLES()          (g_sim_cycles)
+
+HAL_StatusTypeDef HAL_ADCEx_InjectedStart_IT(ADC_HandleTypeDef *hadc);
+
+#endif
@@ -0,0 +1,419 @@
+/**
+ ****************************************************************************************************
+ * @file        svpwm_check.c
+ * @author      ALIENTEK
+ * @brief       Checks ATK_Middlewares/SVPWM/svpwm.c on a Linux host
+ *
+ *              - svpwm_polar over every angle and lengths up to the hexagon, and svpwm_ab over a grid
+ *                of the whole alpha/beta square, against a double precision reference: centered
+ *                space vector duties (phase voltages plus the middle of the largest and smallest
+ *                one), cut to the hexagon with the same angle. The sector is checked as well.
+ *              - A model of TIM1 in center-aligned mode 1 (ARR 1800, RCR 1, CH4 in PWM mode 2 with
+ *                CCR4 = ARR - 1, TRGO = OC4REF) and of the injected conversion of ADC1 (3 ranks of
+ *                7.5 + 12.5 ADC clocks at 12MHz): one trigger per period one tick before the peak,
+ *                one update per period at the valley, where the duties written by the loop are
+ *                loaded if it ended before it.
+ *              - svpwm_injected runs the loop with random cycle counts around the budget. cyc, used
+ *                and their maximums must be exact, overrun must count exactly the loops that end at
+ *                or after the valley, and JEOC must be enabled again.
+ *
+ *              Build, from example/09_3_atim_cplm_pwm:
+ *              gcc -O2 -Wall -Itools/host tools/svpwm_check.c ATK_Middlewares/SVPWM/svpwm.c -lm -o svpwm_check
+ *              Run:
+ *              ./svpwm_check [-s seed]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../ATK_Middlewares/SVPWM/svpwm.h"
+
+#define CHECK_ARR           1800        /* htim1.Init.Period: 20kHz center-aligned at 72MHz */
+#define CHECK_ADC_CYCLES    (3 * 20 * 6)    /* 3 ranks of 7.5 + 12.5 ADC clocks, ADC clock = HCLK / 6 */
+#define CHECK_PERIODS       20000
+#define CHECK_DUTY_MAX      6.0         /* Largest duty error, Q15 of the period */
+
+static const double g_pi = 3.14159265358979323846;
+
+uint32_t g_sim_cycles;
+
+static TIM_TypeDef g_tim;
+static ADC_TypeDef g_adc;
+static TIM_HandleTypeDef g_htim = {&g_tim};
+static ADC_HandleTypeDef g_hadc = {&g_adc};
+static svpwm_t g_svpwm;
+static uint8_t g_adc_started;
+
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+HAL_StatusTypeDef HAL_ADCEx_InjectedStart_IT(ADC_HandleTypeDef *hadc)
+{
+    hadc->Instance->CR1 |= ADC_IT_JEOC;
+    g_adc_started = 1;
+    return HAL_OK;
+}
+
+/******************************************************************************************/
+/* Modulation */
+
+/**
+ * @brief       Centered space vector duties of a vector, in Q15 of the period
+ * @param       theta : angle, radians, 0 on phase a
+ * @param       m : length, 1 is the circle of the linear range (Vdc / sqrt(3))
+ * @param       d : duties of a, b and c
+ * @retval      None
+ */
+static void check_ref(double theta, double m, double *d)
+{
+    double v[3], vmax, vmin, span;
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        v[i] = m / sqrt(3) * cos(theta - i * 2 * g_pi / 3);   /* Phase voltages, in Vdc */
+    }
+
+    vmax = fmax(v[0], fmax(v[1], v[2]));
+    vmin = fmin(v[0], fmin(v[1], v[2]));
+    span = vmax - vmin;
+
+    if (span < 1)span = 1;                                      /* Over the hexagon: cut to its edge */
+
+    for (i = 0; i < 3; i++)
+    {
+        d[i] = (0.5 + (v[i] - (vmax + vmin) / 2) / span) * 32768;
+    }
+}
+
+/**
+ * @brief       Sector of an angle, 0 if it is within eps of an edge
+ */
+static uint8_t check_sector(double theta, double eps)
+{
+    double x = fmod(theta / (g_pi / 3) + 12, 6);
+    double f = x - floor(x);
+
+    if (f < eps || f > 1 - eps)return 0;
+
+    return (uint8_t)floor(x) + 1;
+}
+
+/**
+ * @brief       Largest error of a set of duties, and its sector
+ */
+static double check_duty(const svpwm_duty_t *d, double theta, double m, const char *name, uint8_t *sector_ok)
+{
+    double ref[3], e;
+    uint8_t sector = check_sector(theta, 1e-3);
+
+    check_ref(theta, m, ref);
+    e = fmax(fabs(d->a - ref[0]), fmax(fabs(d->b - ref[1]), fabs(d->c - ref[2])));
+
+    if (sector && d->sector != sector)
+    {
+        if (*sector_ok)printf("%s: sector %u at %.3f degrees, expected %u\n", name, d->sector, theta * 180 / g_pi, sector);
+
+        *sector_ok = 0;
+    }
+
+    return e;
+}
+
+/**
+ * @brief       svpwm_polar over every angle, lengths from 0 to past the hexagon
+ */
+static void check_polar(void)
+{
+    static const uint16_t len[] = {0, 1000, 16384, 30000, SVPWM_ONE, 35000, SVPWM_M_MAX, 50000, 65535};
+    svpwm_duty_t d;
+    double e, emax = 0;
+    uint32_t a, i;
+    uint8_t sector_ok = 1;
+
+    for (i = 0; i < sizeof(len) / sizeof(len[0]); i++)
+    {
+        for (a = 0; a < 65536; a++)
+        {
+            svpwm_polar((uint16_t)a, len[i], &d);
+            e = check_duty(&d, a * 2 * g_pi / 65536, len[i] / 32768.0, "svpwm_polar", &sector_ok);
+
+            if (e > emax)emax = e;
+        }
+    }
+
+    printf("svpwm_polar: max duty error %.2f Q15 (%.1e), %u lengths x 65536 angles\n", emax, emax / 32768, (unsigned)i);
+    CHECK(emax <= CHECK_DUTY_MAX, "svpwm_polar: duty error %.2f > %.1f", emax, CHECK_DUTY_MAX);
+    CHECK(sector_ok, "svpwm_polar: wrong sector");
+}
+
+/**
+ * @brief       svpwm_ab over the alpha/beta square
+ */
+static void check_ab(void)
+{
+    svpwm_duty_t d;
+    double e, emax = 0;
+    int32_t alpha, beta;
+    uint32_t n = 0;
+    uint8_t sector_ok = 1;
+
+    for (alpha = -32767; alpha <= 32767; alpha += 113)
+    {
+        for (beta = -32767; beta <= 32767; beta += 127)
+        {
+            svpwm_ab((int16_t)alpha, (int16_t)beta, &d);
+            e = check_duty(&d, atan2(beta, alpha), hypot(alpha, beta) / 32768.0, "svpwm_ab", &sector_ok);
+
+            if (e > emax)emax = e;
+
+            n++;
+        }
+    }
+
+    for (alpha = -32767; alpha <= 32767; alpha += 32767)        /* On the axes and at the corners */
+    {
+        for (beta = -32767; beta <= 32767; beta += 1)
+        {
+            svpwm_ab((int16_t)alpha, (int16_t)beta, &d);
+            e = check_duty(&d, atan2(beta, alpha), hypot(alpha, beta) / 32768.0, "svpwm_ab", &sector_ok);
+
+            if (e > emax)emax = e;
+
+            svpwm_ab((int16_t)beta, (int16_t)alpha, &d);
+            e = check_duty(&d, atan2(alpha, beta), hypot(alpha, beta) / 32768.0, "svpwm_ab", &sector_ok);
+
+            if (e > emax)emax = e;
+
+            n += 2;
+        }
+    }
+
+    printf("svpwm_ab: max duty error %.2f Q15 (%.1e), %u points\n", emax, emax / 32768, n);
+    CHECK(emax <= CHECK_DUTY_MAX, "svpwm_ab: duty error %.2f > %.1f", emax, CHECK_DUTY_MAX);
+    CHECK(sector_ok, "svpwm_ab: wrong sector");
+}
+
+/******************************************************************************************/
+/* Timer, ADC and loop */
+
+static uint32_t g_cost;                     /* Cycles of the next loop */
+static uint32_t g_seq;                      /* Loops run */
+static uint16_t g_jdr[3];
+
+/**
+ * @brief       Counter and direction of TIM1 at a time, in ticks from the first valley
+ */
+static void check_counter(uint64_t t)
+{
+    uint32_t p = (uint32_t)(t % (2 * CHECK_ARR));
+
+    if (p < CHECK_ARR)
+    {
+        g_tim.CNT = p;
+        g_tim.CR1 &= ~TIM_CR1_DIR;
+    }
+    else
+    {
+        g_tim.CNT = 2 * CHECK_ARR - p;
+        g_tim.CR1 |= TIM_CR1_DIR;
+    }
+}
+
+/**
+ * @brief       Control loop of the check: takes g_cost cycles and writes duties that tell the loop
+ */
+static void check_loop(svpwm_t *s, const uint16_t *adc, void *arg)
+{
+    svpwm_duty_t d;
+
+    (void)arg;
+    CHECK(adc[0] == g_jdr[0] && adc[1] == g_jdr[1] && adc[2] == g_jdr[2], "loop %u: samples %u %u %u", g_seq, adc[0], adc[1], adc[2]);
+
+    d.a = (uint16_t)(g_seq % 30000 + 1000);
+    d.b = (uint16_t)(SVPWM_ONE - d.a);
+    d.c = SVPWM_ONE / 2;
+    d.sector = 1;
+    svpwm_set(s, &d);
+
+    g_sim_cycles += g_cost;
+    check_counter(g_sim_cycles);
+    g_seq++;
+}
+
+/**
+ * @brief       CCR1 that svpwm_set writes for the loop seq
+ */
+static uint32_t check_ccr1(uint32_t seq)
+{
+    return ((seq % 30000 + 1000) * CHECK_ARR + SVPWM_ONE / 2) >> 15;
+}
+
+/**
+ * @brief       Runs the timer model tick by tick and the loop from the end of each injected sequence
+ */
+static void check_timer(void)
+{
+    uint32_t period, p, cnt, rep, trig, upd, oc4, oc4_prev = 0, overrun, ccr_pre, ccr_new, ccr_shadow;
+    uint32_t bad_trig = 0, bad_upd = 0, bad_used = 0, bad_overrun = 0, bad_load = 0, late = 0;
+    uint32_t cyc_max = 0, used_max = 0, loop_seq = 0;
+    uint64_t t, t_end = 0, t_peak = 0;
+    uint8_t in_time = 1, have_loop = 0;
+
+    memset(&g_tim, 0, sizeof(g_tim));
+    memset(&g_adc, 0, sizeof(g_adc));
+    g_tim.ARR = CHECK_ARR;
+    g_tim.PSC = 0;
+    g_tim.CCR4 = 1799;
+    g_sim_cycles = 0;
+    g_seq = 0;
+
+    svpwm_init(&g_svpwm, &g_htim, &g_hadc);
+    CHECK(g_svpwm.budget == CHECK_ARR, "budget %u, half a period is %u", g_svpwm.budget, CHECK_ARR);
+    CHECK(g_tim.CCR4 == CHECK_ARR - 1, "CCR4 %u", g_tim.CCR4);
+    CHECK(g_tim.CCR1 == CHECK_ARR / 2 && g_tim.CCR2 == CHECK_ARR / 2 && g_tim.CCR3 == CHECK_ARR / 2, "svpwm_init: duties not 50%%");
+
+    svpwm_start(&g_svpwm, check_loop, NULL);
+    CHECK(g_adc_started && (g_tim.CR1 & TIM_CR1_CEN), "svpwm_start: timer or ADC not started");
+    CHECK((g_tim.BDTR & TIM_BDTR_MOE) == 0, "svpwm_start: MOE set, the outputs must stay off");
+    CHECK((g_tim.CCER & 0x1555) == 0x1555, "svpwm_start: CCER %04X", g_tim.CCER);
+    svpwm_output(&g_svpwm, 1);
+    CHECK(g_tim.BDTR & TIM_BDTR_MOE, "svpwm_output(1): MOE not set");
+    svpwm_output(&g_svpwm, 0);
+    CHECK((g_tim.BDTR & TIM_BDTR_MOE) == 0, "svpwm_output(0): MOE not cleared");
+
+    /* UG of HAL_TIM_Base_Init: CNT = 0 counting up, repetition counter = RCR = 1, shadows loaded */
+    rep = 1;
+    ccr_pre = ccr_new = ccr_shadow = g_tim.CCR1;
+
+    for (period = 0; period < CHECK_PERIODS; period++)
+    {
+        trig = upd = 0;
+
+        /* From a valley to the tick before the next one, then the next valley */
+        for (p = 0; p <= 2 * CHECK_ARR; p++)
+        {
+            t = (uint64_t)period * 2 * CHECK_ARR + p;
+            cnt = (p <= CHECK_ARR) ? p : 2 * CHECK_ARR - p;
+
+            /* Overflow at the peak, underflow at the valley: the repetition counter */
+            if (t > 0 && (p == CHECK_ARR || p == 2 * CHECK_ARR))
+            {
+                if (rep == 0)
+                {
+                    rep = 1;
+                    upd++;
+
+                    if (p != 2 * CHECK_ARR)bad_upd++;      /* Must be at the valley */
+
+                    ccr_shadow = (t_end < t) ? ccr_new : ccr_pre;
+
+                    if (have_loop && ccr_shadow != check_ccr1(loop_seq) && in_time)bad_load++;
+                }
+                else
+                {
+                    rep--;
+                }
+            }
+
+            if (p == 2 * CHECK_ARR)break;              /* The valley belongs to the next period */
+
+            /* PWM mode 2 on CH4: OC4REF active while CNT >= CCR4 */
+            oc4 = (cnt >= g_tim.CCR4);
+
+            if (oc4 && !oc4_prev)
+            {
+                trig++;
+
+                if (p >= CHECK_ARR || cnt != CHECK_ARR - 1)bad_trig++;  /* One tick before the peak, counting up */
+
+                /* Injected sequence, then the interrupt after 12 to 200 cycles */
+                g_jdr[0] = (uint16_t)(rand() & 0xFFF);
+                g_jdr[1] = (uint16_t)(rand() & 0xFFF);
+                g_jdr[2] = (uint16_t)(rand() & 0xFFF);
+                g_adc.JDR1 = g_jdr[0];
+                g_adc.JDR2 = g_jdr[1];
+                g_adc.JDR3 = g_jdr[2];
+                g_adc.CR1 &= ~ADC_IT_JEOC;              /* The HAL turns JEOC off after each sequence */
+
+                g_sim_cycles = (uint32_t)(t + CHECK_ADC_CYCLES + 12 + rand() % 189);
+                check_counter(g_sim_cycles);
+                t_peak = t + 1;
+
+                /* Cycles of the loop: most within the budget, one in eight around it or over */
+                g_cost = (rand() % 8 == 0) ? 1200 + rand() % 1800 : 50 + rand() % 1000;
+
+                ccr_pre = g_tim.CCR1;
+                overrun = g_svpwm.overrun;
+                loop_seq = g_seq;
+                svpwm_injected(&g_hadc);
+                ccr_new = g_tim.CCR1;
+                t_end = g_sim_cycles;
+                have_loop = 1;
+                in_time = (t_end < t_peak + CHECK_ARR);
+
+                CHECK(ccr_new == check_ccr1(loop_seq), "loop %u: CCR1 %u, expected %u", loop_seq, ccr_new, check_ccr1(loop_seq));
+                CHECK(g_adc.CR1 & ADC_IT_JEOC, "loop %u: JEOC not enabled again", loop_seq);
+                CHECK(g_svpwm.cyc == g_cost, "loop %u: cyc %u, cost %u", loop_seq, g_svpwm.cyc, g_cost);
+
+                if (g_svpwm.used != t_end - t_peak)bad_used++;
+
+                if ((g_svpwm.overrun - overrun) != !in_time)bad_overrun++;   /* Duties late for the valley */
+
+                if (!in_time)late++;
+
+                if (g_cost > cyc_max)cyc_max = g_cost;
+
+                if (t_end - t_peak > used_max)used_max = (uint32_t)(t_end - t_peak);
+            }
+
+            oc4_prev = oc4;
+        }
+
+        if (trig != 1)bad_trig++;
+
+        if (upd != 1 && period > 0)bad_upd++;          /* The first period ends without an update: UG */
+    }
+
+    printf("timer: %u periods, %u loops, %u late, cyc max %u, used max %u of %u\n",
+           CHECK_PERIODS, g_svpwm.runs, late, g_svpwm.cyc_max, g_svpwm.used_max, g_svpwm.budget);
+    CHECK(bad_trig == 0, "timer: %u periods without exactly one trigger one tick before the peak", bad_trig);
+    CHECK(bad_upd == 0, "timer: %u periods without exactly one update at the valley", bad_upd);
+    CHECK(bad_load == 0, "timer: %u valleys did not load the duties of the loop", bad_load);
+    CHECK(bad_used == 0, "timer: used wrong in %u loops", bad_used);
+    CHECK(bad_overrun == 0 && g_svpwm.overrun == late, "timer: overrun %u, %u loops late, %u counted wrong", g_svpwm.overrun, late, bad_overrun);
+    CHECK(g_svpwm.runs == CHECK_PERIODS, "timer: %u loops in %u periods", g_svpwm.runs, CHECK_PERIODS);
+    CHECK(g_svpwm.cyc_max == cyc_max && g_svpwm.used_max == used_max, "timer: cyc_max %u / %u, used_max %u / %u",
+          g_svpwm.cyc_max, cyc_max, g_svpwm.used_max, used_max);
+    CHECK(late > 0 && late < CHECK_PERIODS / 8, "timer: %u loops late, the costs do not cover the budget", late);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned seed = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-s") == 0)seed = strtoul(argv[2], NULL, 0);
+
+    srand(seed);
+    check_polar();
+    check_ab();
+    check_timer();
+
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+    return g_fails ? 1 : 0;
+}
@@ -0,0 +1,562 @@
+/**
+ ****************************************************************************************************
+ * @file        icap.c
+ * @author      ALIENTEK
+ * @brief       Input capture engine: DMA-streamed edges, 32-bit timestamps and batch statistics
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     ICAP_SPAN: drop the pending values at an overflow, process them at half the period
+ *
+ ****************************************************************************************************
+ */
+
+#include <string.h>
+#include "icap.h"
+
+
+/*
+ * Each capture channel requests a DMA transfer of its CCR, so an edge costs no interrupt. The values
+ * are processed in batches: at each half of the DMA ring and twice per counter period, which also
+ * covers slow signals that take long to fill a half.
+ *
+ * The timestamps of ICAP_EDGE streams are extended with two interrupts per counter period: the
+ * compare of a free channel at half the period (icap_half) and the overflow (icap_update). icap_half
+ * processes the values captured so far, so at the overflow the unprocessed values are from the
+ * second half of the ending period (bit 15 set) or from the start of the new one (bit 15 clear).
+ * This holds while both interrupts are served within half a counter period.
+ *
+ * The DMA interrupts must have the same preemption priority as the timer interrupts and a higher
+ * IRQ number (TIM5, TIM8_UP and TIM8_CC come before DMA2), so a half of a ring is never processed
+ * before an overflow that came earlier.
+ *
+ * An overflow of an ICAP_SPAN timer means a whole period without a reset edge. Whether a value the
+ * DMA wrote before the update interrupt was captured before or after the overflow cannot be told
+ * from the values, so icap_update drops all of them, and the next one too (its span started before
+ * the overflow or is unknown). To keep that loss small, icap_half processes the ICAP_SPAN values as
+ * well: the compare at half the period comes only after half a period without a reset edge, so at
+ * the overflow the pending values are from its second half, where the reset channel has none.
+ */
+
+static icap_stream_t *g_icap_list[ICAP_STREAM_NUM];     /* Streams of all the timers */
+
+/**
+ * @brief       Adds an interval to the batch statistics
+ * @param       st : statistics
+ * @param       iv : interval, in ticks
+ * @retval      None
+ */
+static void icap_stat_add(icap_stat_t *st, uint32_t iv)
+{
+    int32_t d;
+
+    if (st->count == 0)
+    {
+        st->min = st->max = st->ref = iv;
+    }
+    else
+    {
+        if (iv < st->min)st->min = iv;
+
+        if (iv > st->max)st->max = iv;
+    }
+
+    d = (int32_t)(iv - st->ref);
+    st->count++;
+    st->sum += iv;
+    st->dsum += d;
+    st->dsum2 += (uint64_t)((int64_t)d * d);
+}
+
+/**
+ * @brief       Queues a result for icap_read
+ * @param       s : stream
+ * @param       v : timestamp or span
+ * @retval      None
+ */
+static void icap_put(icap_stream_t *s, uint32_t v)
+{
+    uint16_t wr = s->res_wr;
+
+    if ((uint16_t)(wr - s->res_rd) >= ICAP_TS_LEN)
+    {
+        s->lost++;                          /* Nobody reads them, the statistics go on */
+        return;
+    }
+
+    s->res[wr & (ICAP_TS_LEN - 1)] = v;
+    __DMB();
+    s->res_wr = wr + 1;
+}
+
+/**
+ * @brief       Processes the next capture values of a stream
+ * @param       s : stream
+ * @param       num : number of values
+ * @param       wrap : 1, the values are from around an overflow (ICAP_EDGE in icap_update)
+ * @retval      None
+ */
+static void icap_process(icap_stream_t *s, uint32_t num, uint8_t wrap)
+{
+    uint32_t t, v;
+
+    while (num--)
+    {
+        v = s->buf[s->done++ & (ICAP_DMA_LEN - 1)];
+
+        if (s->kind == ICAP_SPAN)
+        {
+            if (s->first)                   /* The counter was not reset by an edge before this one */
+            {
+                s->first = 0;
+                continue;
+            }
+
+            t = v + s->corr;
+            icap_stat_add(&s->stat, t);
+        }
+        else
+        {
+            t = ((uint32_t)s->epoch << 16) | v;
+
+            if (wrap && (v & 0x8000) == 0)t += 0x10000;     /* Captured after the overflow */
+
+            if (s->first == 0)icap_stat_add(&s->stat, t - s->last);
+
+            s->first = 0;
+            s->last = t;
+        }
+
+        icap_put(s, t);
+    }
+}
+
+/**
+ * @brief       Capture values written by the DMA and not processed yet
+ * @param       s : stream
+ * @retval      Number of values
+ */
+static uint32_t icap_pending(icap_stream_t *s)
+{
+    uint32_t pos = ICAP_DMA_LEN - __HAL_DMA_GET_COUNTER(s->hdma);
+
+    return (pos - s->done) & (ICAP_DMA_LEN - 1);
+}
+
+/**
+ * @brief       Channel of a timer that interrupts at half the counter period
+ * @param       htim : timer handle
+ * @retval      First channel without a stream; ICAP_NO_CHANNEL, no stream or no free channel
+ */
+static uint32_t icap_half_channel(TIM_HandleTypeDef *htim)
+{
+    icap_stream_t *s;
+    uint8_t used = 0;
+    uint8_t i;
+
+    for (i = 0; i < ICAP_STREAM_NUM; i++)
+    {
+        s = g_icap_list[i];
+
+        if (s == 0 || s->htim != htim)continue;
+
+        used |= 1 << (s->channel >> 2);
+    }
+
+    if (used == 0)return ICAP_NO_CHANNEL;
+
+    for (i = 0; i < 4; i++)
+    {
+        if ((used & (1 << i)) == 0)return (uint32_t)i << 2;
+    }
+
+    return ICAP_NO_CHANNEL;
+}
+
+/**
+ * @brief       DMA callback: a half of a ring has been written
+ * @param       hdma : DMA handle
+ * @retval      None
+ */
+static void icap_dma_half(DMA_HandleTypeDef *hdma)
+{
+    icap_stream_t *s;
+    int32_t n;
+    uint8_t i;
+
+    for (i = 0; i < ICAP_STREAM_NUM; i++)
+    {
+        s = g_icap_list[i];
+
+        if (s == 0 || s->hdma != hdma)continue;
+
+        s->dma += ICAP_DMA_LEN / 2;
+        n = (int32_t)(s->dma - s->done);    /* The update interrupt may have processed some already */
+
+        if (n > ICAP_DMA_LEN / 2)           /* A half was missed, the DMA is writing over it */
+        {
+            s->overrun++;
+            s->done = s->dma - ICAP_DMA_LEN / 2;
+            s->first = 1;
+            n = ICAP_DMA_LEN / 2;
+        }
+
+        if (n > 0)icap_process(s, n, 0);
+    }
+}
+
+/**
+ * @brief       Registers a capture stream
+ * @note        The channel must be configured as input capture (polarity, TI selection, filter).
+ *              hdma is the DMA channel of its CC request (TIM5_CH1: DMA2 channel 5, TIM5_CH2: DMA2
+ *              channel 4, TIM8_CH1: DMA2 channel 3, TIM8_CH2: DMA2 channel 5, ...)
+ * @param       s : stream, kept until icap_stop
+ * @param       htim : timer handle
+ * @param       channel : TIM_CHANNEL_1 ~ TIM_CHANNEL_4
+ * @param       hdma : DMA handle, circular, peripheral to memory, halfword to halfword
+ * @param       kind : ICAP_EDGE or ICAP_SPAN
+ * @retval      0, successful; 1, invalid parameter or no free stream
+ */
+uint8_t icap_init(icap_stream_t *s, TIM_HandleTypeDef *htim, uint32_t channel, DMA_HandleTypeDef *hdma, uint8_t kind)
+{
+    uint8_t i;
+
+    if (channel > TIM_CHANNEL_4 || kind > ICAP_SPAN)return 1;
+
+    for (i = 0; i < ICAP_STREAM_NUM; i++)
+    {
+        if (g_icap_list[i] == 0 || g_icap_list[i] == s)break;
+    }
+
+    if (i == ICAP_STREAM_NUM)return 1;
+
+    memset(s, 0, sizeof(icap_stream_t));
+    s->htim = htim;
+    s->hdma = hdma;
+    s->channel = channel;
+    s->kind = kind;
+    g_icap_list[i] = s;
+    return 0;
+}
+
+/**
+ * @brief       Starts the counter and all the streams of a timer
+ * @note        The timer keeps its prescaler, one tick is (PSC + 1) / ICAP_TIM_CLK. The first channel
+ *              without a stream becomes a timing output compare at half the period, the timer must
+ *              count up to 65535. ICAP_EDGE streams need that channel, ICAP_SPAN streams lose fewer
+ *              values at an overflow with it
+ * @param       htim : timer handle
+ * @retval      0, successful; 1, no stream, no free channel or DMA error
+ */
+uint8_t icap_start(TIM_HandleTypeDef *htim)
+{
+    TIM_OC_InitTypeDef oc = {0};
+    icap_stream_t *s;
+    uint32_t half;
+    uint16_t corr;
+    uint8_t i, n = 0;
+
+    icap_stop(htim);
+
+    half = icap_half_channel(htim);
+
+    if (half != ICAP_NO_CHANNEL)
+    {
+        oc.OCMode = TIM_OCMODE_TIMING;          /* Only the flag, no output */
+        oc.Pulse = 0x8000;
+
+        if (HAL_TIM_OC_ConfigChannel(htim, &oc, half) != HAL_OK)return 1;
+    }
+    else
+    {
+        for (i = 0; i < ICAP_STREAM_NUM; i++)   /* No channel left, only ICAP_SPAN streams can do without */
+        {
+            s = g_icap_list[i];
+
+            if (s && s->htim == htim && s->kind == ICAP_EDGE)return 1;
+        }
+    }
+
+    corr = (htim->Instance->PSC == 0) ? 2 : 1;  /* Reset by the slave mode takes a tick, and one more without prescaler */
+    htim->Instance->SR = 0;                     /* No stale capture request */
+
+    for (i = 0; i < ICAP_STREAM_NUM; i++)
+    {
+        s = g_icap_list[i];
+
+        if (s == 0 || s->htim != htim)continue;
+
+        s->first = 1;
+        s->epoch = 0;
+        s->done = 0;
+        s->dma = 0;
+        s->corr = (s->kind == ICAP_SPAN) ? corr : 0;
+        s->res_wr = s->res_rd = 0;
+        s->lost = s->overrun = s->range = 0;
+        memset(&s->stat, 0, sizeof(icap_stat_t));
+
+        s->hdma->XferHalfCpltCallback = icap_dma_half;
+        s->hdma->XferCpltCallback = icap_dma_half;
+
+        if (HAL_DMA_Start_IT(s->hdma, (uint32_t)&htim->Instance->CCR1 + s->channel, (uint32_t)s->buf, ICAP_DMA_LEN) != HAL_OK)return 1;
+
+        __HAL_TIM_ENABLE_DMA(htim, TIM_DMA_CC1 << (s->channel >> 2));
+        TIM_CCxChannelCmd(htim->Instance, s->channel, TIM_CCx_ENABLE);
+        n++;
+    }
+
+    if (n == 0)return 1;
+
+    __HAL_TIM_URS_ENABLE(htim);                 /* Update interrupt on overflow only, not on slave mode resets */
+    __HAL_TIM_SET_COUNTER(htim, 0);
+    __HAL_TIM_CLEAR_FLAG(htim, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE_IT(htim, TIM_IT_UPDATE);
+
+    if (half != ICAP_NO_CHANNEL)
+    {
+        __HAL_TIM_CLEAR_FLAG(htim, TIM_FLAG_CC1 << (half >> 2));
+        __HAL_TIM_ENABLE_IT(htim, TIM_IT_CC1 << (half >> 2));
+    }
+
+    __HAL_TIM_ENABLE(htim);
+    return 0;
+}
+
+/**
+ * @brief       Stops the counter and all the streams of a timer
+ * @param       htim : timer handle
+ * @retval      None
+ */
+void icap_stop(TIM_HandleTypeDef *htim)
+{
+    icap_stream_t *s;
+    uint32_t half = icap_half_channel(htim);
+    uint8_t i;
+
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_UPDATE);
+
+    if (half != ICAP_NO_CHANNEL)__HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1 << (half >> 2));
+
+    for (i = 0; i < ICAP_STREAM_NUM; i++)
+    {
+        s = g_icap_list[i];
+
+        if (s == 0 || s->htim != htim)continue;
+
+        TIM_CCxChannelCmd(htim->Instance, s->channel, TIM_CCx_DISABLE);
+        __HAL_TIM_DISABLE_DMA(htim, TIM_DMA_CC1 << (s->channel >> 2));
+        HAL_DMA_Abort(s->hdma);
+    }
+
+    __HAL_TIM_DISABLE(htim);
+}
+
+/**
+ * @brief       Half of the counter period of a timer
+ * @note        Called in the compare interrupt, from HAL_TIM_OC_DelayElapsedCallback. Other compare
+ *              interrupts of the timer are harmless, values are only processed in the second half.
+ *              With ICAP_SPAN streams the counter is past half the period since the last reset edge
+ * @param       htim : timer handle
+ * @retval      None
+ */
+void icap_half(TIM_HandleTypeDef *htim)
+{
+    icap_stream_t *s;
+    uint8_t i;
+
+    if ((__HAL_TIM_GET_COUNTER(htim) & 0x8000) == 0)return;        /* The overflow is due, icap_update will do it */
+
+    for (i = 0; i < ICAP_STREAM_NUM; i++)
+    {
+        s = g_icap_list[i];
+
+        if (s == 0 || s->htim != htim)continue;
+
+        icap_process(s, icap_pending(s), 0);
+    }
+}
+
+/**
+ * @brief       Counter overflow of a timer
+ * @note        Called in the update interrupt, from HAL_TIM_PeriodElapsedCallback
+ * @param       htim : timer handle
+ * @retval      None
+ */
+void icap_update(TIM_HandleTypeDef *htim)
+{
+    icap_stream_t *s;
+    uint32_t num;
+    uint8_t i;
+
+    for (i = 0; i < ICAP_STREAM_NUM; i++)
+    {
+        s = g_icap_list[i];
+
+        if (s == 0 || s->htim != htim)continue;
+
+        num = icap_pending(s);
+
+        if (s->kind == ICAP_EDGE)
+        {
+            icap_process(s, num, 1);
+            s->epoch++;
+            continue;
+        }
+
+        /* ICAP_SPAN: no reset edge for a whole period, the pending values may be from either side of it */
+        s->done += num;
+        s->range++;
+        s->first = 1;
+    }
+}
+
+/**
+ * @brief       Reads the results of a stream
+ * @param       s : stream
+ * @param       buf : timestamps (ICAP_EDGE) or spans (ICAP_SPAN), in ticks
+ * @param       num : size of buf
+ * @retval      Number of results read
+ */
+uint16_t icap_read(icap_stream_t *s, uint32_t *buf, uint16_t num)
+{
+    uint16_t rd = s->res_rd;
+    uint16_t n = 0;
+
+    while (n < num && rd != s->res_wr)
+    {
+        buf[n++] = s->res[rd & (ICAP_TS_LEN - 1)];
+        rd++;
+    }
+
+    s->res_rd = rd;
+    return n;
+}
+
+/**
+ * @brief       Takes the batch statistics of a stream and starts a new batch
+ * @param       s : stream
+ * @param       st : statistics of the intervals since the last call
+ * @retval      None
+ */
+void icap_stat(icap_stream_t *s, icap_stat_t *st)
+{
+    __disable_irq();
+    *st = s->stat;
+    memset(&s->stat, 0, sizeof(icap_stat_t));
+    __enable_irq();
+}
+
+/**
+ * @brief       Tick frequency of a timer
+ * @param       htim : timer handle
+ * @retval      Ticks per second
+ */
+uint32_t icap_tick_hz(TIM_HandleTypeDef *htim)
+{
+    return ICAP_TIM_CLK / (htim->Instance->PSC + 1);
+}
+
+/**
+ * @brief       Mean frequency of the intervals
+ * @param       st : statistics
+ * @param       tick_hz : ticks per second
+ * @retval      Frequency, in mHz; 0, no interval
+ */
+uint32_t icap_freq(const icap_stat_t *st, uint32_t tick_hz)
+{
+    if (st->sum == 0)return 0;
+
+    return (uint32_t)((uint64_t)tick_hz * 1000 * st->count / st->sum);
+}
+
+/**
+ * @brief       Mean interval
+ * @param       st : statistics
+ * @param       tick_hz : ticks per second
+ * @retval      Interval, in ns; 0, no interval
+ */
+uint32_t icap_mean(const icap_stat_t *st, uint32_t tick_hz)
+{
+    uint64_t q, r;
+
+    if (st->count == 0)return 0;
+
+    q = st->sum / st->count;
+    r = st->sum % st->count;
+    return (uint32_t)((q * 1000000000ULL + r * 1000000000ULL / st->count) / tick_hz);
+}
+
+/**
+ * @brief       Integer square root
+ * @param       x : value
+ * @retval      floor(sqrt(x))
+ */
+static uint32_t icap_sqrt(uint64_t x)
+{
+    uint64_t r = 0;
+    uint64_t b = 1ULL << 62;
+
+    while (b > x)b >>= 2;
+
+    while (b)
+    {
+        if (x >= r + b)
+        {
+            x -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+        {
+            r >>= 1;
+        }
+
+        b >>= 2;
+    }
+
+    return (uint32_t)r;
+}
+
+/**
+ * @brief       Jitter of the intervals
+ * @param       st : statistics
+ * @param       tick_hz : ticks per second
+ * @retval      RMS deviation from the mean interval, in ns
+ */
+uint32_t icap_jitter(const icap_stat_t *st, uint32_t tick_hz)
+{
+    uint8_t sh = 4;                             /* In 1/16 tick, below the resolution of one edge */
+    int64_t m;
+    uint64_t m2;
+
+    if (st->count < 2)return 0;
+
+    if (st->dsum2 >> 55)sh = 0;                 /* Deviations of millions of ticks, whole ticks are enough */
+
+    m = (st->dsum * (1 << sh)) / (int64_t)st->count;
+    m2 = (st->dsum2 << (2 * sh)) / st->count;
+
+    if (m2 <= (uint64_t)(m * m))return 0;
+
+    return (uint32_t)(((uint64_t)icap_sqrt(m2 - (uint64_t)(m * m)) * 1000000000ULL >> sh) / tick_hz);
+}
+
+/**
+ * @brief       Duty cycle from the high spans and the periods of a PWM input
+ * @param       high : statistics of the high spans
+ * @param       period : statistics of the periods
+ * @retval      Duty cycle, in 0.1%
+ */
+uint16_t icap_duty(const icap_stat_t *high, const icap_stat_t *period)
+{
+    if (high->count == 0 || period->sum == 0)return 0;
+
+    return (uint16_t)(high->sum * 1000 / high->count * period->count / period->sum);
+}
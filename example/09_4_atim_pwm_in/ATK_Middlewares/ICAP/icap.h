@@ -0,0 +1,100 @@
+/**
+ ****************************************************************************************************
+ * @file        icap.h
+ * @author      ALIENTEK
+ * @brief       Input capture engine: DMA-streamed edges, 32-bit timestamps and batch statistics
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     ICAP_SPAN: the half period channel, the values dropped at an overflow
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __ICAP_H
+#define __ICAP_H
+
+#include "main.h"
+
+
+#define ICAP_TIM_CLK        72000000    /* Clock of the timers (APB1 and APB2 timer clocks) */
+#define ICAP_STREAM_NUM     4           /* Streams of all the timers */
+#define ICAP_DMA_LEN        256         /* Capture values per DMA ring, two halves, power of 2 */
+#define ICAP_TS_LEN         64          /* Results kept for icap_read, power of 2 */
+
+/*
+ * Kinds of stream
+ * ICAP_EDGE : the counter runs freely, a capture value is the time of an edge. The update and half
+ *             period interrupts extend them to 32 bits, consecutive edges may be any number of
+ *             counter periods apart. A channel of the timer must be left free for the half period.
+ * ICAP_SPAN : the counter is reset by the slave mode (PWM input), a capture value is the time since
+ *             the reset edge. Spans longer than a counter period are counted in range and dropped,
+ *             with the values not processed yet at that overflow and the first one after it. A free
+ *             channel of the timer is optional, it gets the values processed at half the period.
+ *
+ * The F1 timers cannot capture both edges on one channel. Both edges of a pin are two streams: one
+ * channel on TIx rising and its pair (CH1/CH2 or CH3/CH4) on the same TIx (INDIRECTTI) falling.
+ */
+#define ICAP_EDGE           0
+#define ICAP_SPAN           1
+
+#define ICAP_NO_CHANNEL     0xFFFFFFFF
+
+/* Batch statistics of the intervals of a stream (edge to edge, or the spans) */
+typedef struct
+{
+    uint32_t count;                     /* Intervals */
+    uint32_t min;                       /* Shortest interval, in ticks */
+    uint32_t max;                       /* Longest interval, in ticks */
+    uint64_t sum;                       /* Sum of the intervals */
+    uint32_t ref;                       /* First interval, the deviations are taken from it */
+    int64_t dsum;                       /* Sum of the deviations */
+    uint64_t dsum2;                     /* Sum of the squares of the deviations */
+} icap_stat_t;
+
+typedef struct
+{
+    TIM_HandleTypeDef *htim;
+    DMA_HandleTypeDef *hdma;            /* Circular, peripheral to memory, halfword */
+    uint32_t channel;                   /* TIM_CHANNEL_1 ~ TIM_CHANNEL_4 */
+    uint8_t kind;                       /* ICAP_EDGE / ICAP_SPAN */
+    uint8_t first;                      /* No edge since the start, no interval yet */
+    uint16_t epoch;                     /* Counter periods, the high half of the timestamps */
+    uint16_t corr;                      /* ICAP_SPAN: ticks added to a capture value */
+    uint32_t done;                      /* Capture values processed */
+    uint32_t dma;                       /* Capture values written by the DMA, at the last half */
+    uint32_t last;                      /* Timestamp of the last edge */
+    uint16_t buf[ICAP_DMA_LEN];
+    uint32_t res[ICAP_TS_LEN];          /* Timestamps (ICAP_EDGE) or spans (ICAP_SPAN) */
+    volatile uint16_t res_wr;
+    volatile uint16_t res_rd;
+    icap_stat_t stat;
+    volatile uint32_t lost;             /* Results dropped because res was full */
+    volatile uint32_t overrun;          /* Halves overwritten by the DMA before they were processed */
+    volatile uint32_t range;            /* ICAP_SPAN: counter periods without a reset edge */
+} icap_stream_t;
+
+uint8_t icap_init(icap_stream_t *s, TIM_HandleTypeDef *htim, uint32_t channel, DMA_HandleTypeDef *hdma, uint8_t kind);
+uint8_t icap_start(TIM_HandleTypeDef *htim);                            /* Starts all the streams of a timer */
+void icap_stop(TIM_HandleTypeDef *htim);
+void icap_half(TIM_HandleTypeDef *htim);                                /* Call from HAL_TIM_OC_DelayElapsedCallback */
+void icap_update(TIM_HandleTypeDef *htim);                              /* Call from HAL_TIM_PeriodElapsedCallback */
+
+uint16_t icap_read(icap_stream_t *s, uint32_t *buf, uint16_t num);      /* Oldest results first */
+void icap_stat(icap_stream_t *s, icap_stat_t *st);                      /* Takes the batch and starts a new one */
+
+uint32_t icap_tick_hz(TIM_HandleTypeDef *htim);
+uint32_t icap_freq(const icap_stat_t *st, uint32_t tick_hz);            /* Mean frequency, in mHz */
+uint32_t icap_mean(const icap_stat_t *st, uint32_t tick_hz);            /* Mean interval, in ns */
+uint32_t icap_jitter(const icap_stat_t *st, uint32_t tick_hz);          /* RMS deviation of the intervals, in ns */
+uint16_t icap_duty(const icap_stat_t *high, const icap_stat_t *period); /* Duty cycle, in 0.1% */
+
+#endif
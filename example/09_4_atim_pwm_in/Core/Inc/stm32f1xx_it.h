@@ -58,6 +58,8 @@ void SysTick_Handler(void);
 void USART1_IRQHandler(void);
 void TIM8_UP_IRQHandler(void);
 void TIM8_CC_IRQHandler(void);
+void DMA2_Channel3_IRQHandler(void);
+void DMA2_Channel4_5_IRQHandler(void);
 /* USER CODE BEGIN EFP */
 
 /* USER CODE END EFP */
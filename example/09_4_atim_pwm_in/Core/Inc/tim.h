@@ -29,7 +29,7 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "../../ATK_Middlewares/ICAP/icap.h"
 /* USER CODE END Includes */
 
 extern TIM_HandleTypeDef htim3;
@@ -38,6 +38,9 @@ extern TIM_HandleTypeDef htim8;
 
 /* USER CODE BEGIN Private defines */
 
+extern icap_stream_t g_icap_period;
+extern icap_stream_t g_icap_high;
+
 /* USER CODE END Private defines */
 
 void MX_TIM3_Init(void);
@@ -47,9 +50,6 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
 /* USER CODE BEGIN Prototypes */
 
-void atim_timx_pwmin_chy_process(void);
-void atim_timx_pwmin_chy_restart(void);
-
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
@@ -15,12 +15,14 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     PWM input through the DMA capture engine, batch statistics
  *
  ****************************************************************************************************
  */
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "dma.h"
 #include "tim.h"
 #include "usart.h"
 #include "gpio.h"
@@ -57,11 +59,6 @@
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
 
-extern uint8_t g_timxchy_pwmin_sta;    /* PWM input status. */
-extern uint16_t g_timxchy_pwmin_psc;   /* PWM input frequency division coefficient. */
-extern uint32_t g_timxchy_pwmin_hval;  /* High level pulse width of PWM. */
-extern uint32_t g_timxchy_pwmin_cval;  /* PWM cycle width. */
-
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -78,8 +75,11 @@ extern uint32_t g_timxchy_pwmin_cval;  /* PWM cycle width. */
 int main(void)
 {
   /* USER CODE BEGIN 1 */
+  icap_stat_t period, high;
+  uint32_t tick_hz, freq;
+  uint16_t duty;
+  uint16_t psc = 0;
   uint8_t t = 0;
-  float ht, ct, f, tpsc;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -100,6 +100,7 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_TIM3_Init();
   MX_TIM8_Init();
@@ -117,20 +118,39 @@ int main(void)
 
     if (t >= 20)                  /* The results are output every 200ms, and the LED0 is blinked to prompt the program to run. */
     {
-      if (g_timxchy_pwmin_sta)    /* The data is captured once */
+      icap_stat(&g_icap_period, &period);                   /* All the cycles of the last 200ms */
+      icap_stat(&g_icap_high, &high);
+      tick_hz = icap_tick_hz(&htim8);
+
+      if (period.count)
       {
+        freq = icap_freq(&period, tick_hz);
+        duty = icap_duty(&high, &period);
         printf("\r\n");                                     /* The output is blank, and another line begins */
-        printf("PWM PSC  :%u\r\n", g_timxchy_pwmin_psc);    /* Print the frequency division coefficients */
-        printf("PWM Hight:%lu\r\n", g_timxchy_pwmin_hval);  /* Print high level pulse width */
-        printf("PWM Cycle:%lu\r\n", g_timxchy_pwmin_cval);  /* Print cycle */
-        tpsc = ((double)g_timxchy_pwmin_psc + 1) / 72;      /* The PWM sampling clock cycle time is obtained */
-        ht = g_timxchy_pwmin_hval * tpsc;                   /* Calculate the high level time */
-        ct = g_timxchy_pwmin_cval * tpsc;                   /* Calculating cycle length */
-        f = (1 / ct) * 1000000;                             /* Calculated rate */
-        printf("PWM Hight time:%.3fus\r\n", ht);            /* Print high level pulse width length */
-        printf("PWM Cycle time:%.3fus\r\n", ct);            /* Print cycle time length */
-        printf("PWM Frequency :%.3fHz\r\n", f);             /* Print frequency */
-        atim_timx_pwmin_chy_restart();                      /* Restart PWM input detection */
+        printf("PWM PSC  :%u\r\n", psc);                   /* Print the frequency division coefficients */
+        printf("PWM Cycles     :%lu\r\n", period.count);   /* Cycles measured */
+        printf("PWM Hight time :%luns\r\n", icap_mean(&high, tick_hz));
+        printf("PWM Cycle time :%luns\r\n", icap_mean(&period, tick_hz));
+        printf("PWM Frequency  :%lu.%03luHz\r\n", freq / 1000, freq % 1000);
+        printf("PWM Duty       :%u.%u%%\r\n", duty / 10, duty % 10);
+        printf("PWM Jitter     :%luns\r\n", icap_jitter(&period, tick_hz));
+      }
+
+      /* Ranging: a larger prescaler when the counter overflows without an edge, a smaller one for resolution */
+      if (period.count == 0 && g_icap_period.range)
+      {
+        psc = (psc == 65535) ? 0 : psc * 2 + 1;             /* At the maximum, probably no input: restore the frequency */
+      }
+      else if (period.count && psc && period.max < 0x4000)
+      {
+        psc >>= 1;
+      }
+
+      if (psc != htim8.Instance->PSC)
+      {
+        __HAL_TIM_SET_PRESCALER(&htim8, psc);
+        HAL_TIM_GenerateEvent(&htim8, TIM_EVENTSOURCE_UPDATE);  /* Loads the prescaler now */
+        icap_start(&htim8);
       }
 
       LED0_TOGGLE();                                        /* LED0 state is flipped */
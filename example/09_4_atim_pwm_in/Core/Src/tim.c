@@ -22,20 +22,15 @@
 
 /* USER CODE BEGIN 0 */
 
-/* PWM input state (g_timxchy_cap_sta)
- * 0, no capture.
- * 1, the capture was successful
- */
-uint8_t g_timxchy_pwmin_sta   = 0;  /* PWM input status. */
-uint16_t g_timxchy_pwmin_psc  = 0;  /* PWM input frequency division coefficient. */
-uint32_t g_timxchy_pwmin_hval = 0;  /* High level pulse width of PWM. */
-uint32_t g_timxchy_pwmin_cval = 0;  /* PWM cycle width. */
-
+icap_stream_t g_icap_period;    /* PC6 periods, TIM8 channel 1 */
+icap_stream_t g_icap_high;      /* PC6 high levels, TIM8 channel 2 */
 
 /* USER CODE END 0 */
 
 TIM_HandleTypeDef htim3;
 TIM_HandleTypeDef htim8;
+DMA_HandleTypeDef hdma_tim8_ch1;
+DMA_HandleTypeDef hdma_tim8_ch2;
 
 /* TIM3 init function */
 void MX_TIM3_Init(void)
@@ -109,7 +104,7 @@ void MX_TIM8_Init(void)
 
   /* USER CODE END TIM8_Init 1 */
   htim8.Instance = TIM8;
-  htim8.Init.Prescaler = 72 - 1;
+  htim8.Init.Prescaler = 0;
   htim8.Init.CounterMode = TIM_COUNTERMODE_UP;
   htim8.Init.Period = 65535;
   htim8.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
@@ -156,9 +151,9 @@ void MX_TIM8_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN TIM8_Init 2 */
-  __HAL_TIM_ENABLE_IT(&htim8, TIM_IT_UPDATE);
-  HAL_TIM_IC_Start_IT(&htim8, TIM_CHANNEL_1);
-  HAL_TIM_IC_Start_IT(&htim8, TIM_CHANNEL_2);
+  icap_init(&g_icap_period, &htim8, TIM_CHANNEL_1, &hdma_tim8_ch1, ICAP_SPAN);
+  icap_init(&g_icap_high, &htim8, TIM_CHANNEL_2, &hdma_tim8_ch2, ICAP_SPAN);
+  icap_start(&htim8);
   /* USER CODE END TIM8_Init 2 */
 
 }
@@ -195,6 +190,39 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* tim_baseHandle)
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
 
+    /* TIM8 DMA Init */
+    /* TIM8_CH1 Init */
+    hdma_tim8_ch1.Instance = DMA2_Channel3;
+    hdma_tim8_ch1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_tim8_ch1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim8_ch1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim8_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim8_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim8_ch1.Init.Mode = DMA_CIRCULAR;
+    hdma_tim8_ch1.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_tim8_ch1) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(tim_baseHandle,hdma[TIM_DMA_ID_CC1],hdma_tim8_ch1);
+
+    /* TIM8_CH2 Init */
+    hdma_tim8_ch2.Instance = DMA2_Channel5;
+    hdma_tim8_ch2.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_tim8_ch2.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim8_ch2.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim8_ch2.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim8_ch2.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim8_ch2.Init.Mode = DMA_CIRCULAR;
+    hdma_tim8_ch2.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_tim8_ch2) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(tim_baseHandle,hdma[TIM_DMA_ID_CC2],hdma_tim8_ch2);
+
     /* TIM8 interrupt Init */
     HAL_NVIC_SetPriority(TIM8_UP_IRQn, 2, 1);
     HAL_NVIC_EnableIRQ(TIM8_UP_IRQn);
@@ -260,6 +288,10 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* tim_baseHandle)
     */
     HAL_GPIO_DeInit(GPIOC, GPIO_PIN_6);
 
+    /* TIM8 DMA DeInit */
+    HAL_DMA_DeInit(tim_baseHandle->hdma[TIM_DMA_ID_CC1]);
+    HAL_DMA_DeInit(tim_baseHandle->hdma[TIM_DMA_ID_CC2]);
+
     /* TIM8 interrupt Deinit */
     HAL_NVIC_DisableIRQ(TIM8_UP_IRQn);
     HAL_NVIC_DisableIRQ(TIM8_CC_IRQn);
@@ -271,131 +303,30 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* tim_baseHandle)
 
 /* USER CODE BEGIN 1 */
 
-/*
- * @brief  Timer TIMX PWM input mode restarts capture.
- * @param  None.
- * @retval None.
- */
-void atim_timx_pwmin_chy_restart(void)
-{
-  __ASM volatile("cpsid i");                      /* Turn off interrupt */
-
-  g_timxchy_pwmin_sta = 0;                        /* Reset the state and start the detection again. */
-  g_timxchy_pwmin_psc = 0;                        /* The frequency division coefficient is cleared to zero. */
-
-  __HAL_TIM_SET_PRESCALER(&htim8, 0);             /* It is collected at the maximum counting frequency to get the best accuracy. */
-  __HAL_TIM_SET_COUNTER(&htim8, 0);               /* Clear counter */
-
-  __HAL_TIM_ENABLE_IT(&htim8, TIM_IT_CC1);        /* Enable channel 1 to capture the interrupt */
-  __HAL_TIM_ENABLE_IT(&htim8, TIM_IT_UPDATE);     /* Enable overflow interrupts */
-  __HAL_TIM_ENABLE(&htim8);                       /* Enable TIMX */
-
-  TIM8->SR = 0;                                   /* Clear all interrupt flags. */
-
-  __ASM volatile("cpsie i");                      /* Open interrupts */
-}
-
-/*
- * @brief  Timer TIMX channel Y PWM input mode interrupt handler function
- * @param  None.
- * @retval None.
- */
-void atim_timx_pwmin_chy_process(void)
+/**
+  * @brief  Period elapsed callback in non-blocking mode
+  * @param  htim TIM handle
+  * @retval None
+  */
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
-  static uint8_t sflag = 0;                   /* Start PWMIN input detection flag. */
-
-  if (g_timxchy_pwmin_sta)
+  if (htim->Instance == TIM8)
   {
-    g_timxchy_pwmin_psc = 0;
-    TIM8->SR = 0;                             /* Clear all interrupt flags. */
-    __HAL_TIM_SET_COUNTER(&htim8, 0);         /* Clear counter */
-    return ;
-  }
-
-  if (__HAL_TIM_GET_FLAG(&htim8, TIM_FLAG_UPDATE))        /* An overflow interrupt has occurred. */
-  {
-    __HAL_TIM_CLEAR_FLAG(&htim8, TIM_FLAG_UPDATE);        /* Clear the overflow interrupt mark. */
-
-    if (__HAL_TIM_GET_FLAG(&htim8, TIM_FLAG_CC1) == 0)    /* No cycle capture interruption occurred and the capture was not completed */
-    {
-      sflag = 0;
-      if (g_timxchy_pwmin_psc == 0)
-      {
-        g_timxchy_pwmin_psc ++;
-      }
-      else
-      {
-        if (g_timxchy_pwmin_psc == 65535)                 /* It's already Max. It's probably a no-input state */
-        {
-          g_timxchy_pwmin_psc = 0;                        /* Restore the frequency */
-        }
-        else if (g_timxchy_pwmin_psc > 32767)             /* It's at its maximum. */
-        {
-          g_timxchy_pwmin_psc = 65535;                    /* It is directly equal to the maximum frequency division coefficient. */
-        }
-        else
-        {
-          g_timxchy_pwmin_psc += g_timxchy_pwmin_psc;     /* double */
-        }
-      }
-
-      __HAL_TIM_SET_PRESCALER(&htim8, g_timxchy_pwmin_psc); /* Set the timer predivision coefficient */
-      __HAL_TIM_SET_COUNTER(&htim8, 0);                     /* Clear counter */
-      TIM8->SR = 0;                                         /* Clear all interrupt flags */
-      return ;
-    }
-  }
-
-  if (sflag == 0)                 /* First acquisition to capture interrupt */
-  {
-    if (__HAL_TIM_GET_FLAG(&htim8, TIM_FLAG_CC1))           /* The first cycle capture interruption was detected */
-    {
-      sflag = 1;                  /* Mark that the first cycle has been captured and the second cycle capture can begin */
-    }
-
-    TIM8->SR = 0;                 /* Clear all interrupt flags */
-    return ;                      /* Complete the operation */
+    icap_update(htim);                            /* A whole counter period without a rising edge */
   }
+}
 
-  if (g_timxchy_pwmin_sta == 0)   /* No capture yet */
+/**
+  * @brief  Output Compare callback in non-blocking mode
+  * @param  htim TIM OC handle
+  * @retval None
+  */
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+  if (htim->Instance == TIM8)
   {
-    if (__HAL_TIM_GET_FLAG(&htim8, TIM_FLAG_CC1))         /* A cycle capture interrupt has been detected */
-    {
-      g_timxchy_pwmin_hval = HAL_TIM_ReadCapturedValue(&htim8, TIM_CHANNEL_2) + 1; /* High level pulse width capture value */
-      g_timxchy_pwmin_cval = HAL_TIM_ReadCapturedValue(&htim8, TIM_CHANNEL_1) + 1; /* Periodic capture value */
-
-      if (g_timxchy_pwmin_hval < g_timxchy_pwmin_cval)    /* The high level pulse width must be smaller than the cycle length */
-      {
-        g_timxchy_pwmin_sta = 1;                          /* Mark capture successful */
-
-        g_timxchy_pwmin_psc = TIM8->PSC;                  /* Obtain the PWM input frequency division coefficients */
-
-        if (g_timxchy_pwmin_psc == 0)                     /* When the divider coefficient is 0, correct the read data */
-        {
-          g_timxchy_pwmin_hval++;                         /* The correction factor is 1, plus 1 */
-          g_timxchy_pwmin_cval++;                         /* The correction factor is 1, plus 1 */
-        }
-
-        sflag = 0;
-        /* After each capture PWM input is successful,
-         * the capture is stopped to avoid frequent interrupts
-         * affecting the normal code operation of the system */
-        TIM8->CR1  &= ~(1 << 0);                      /* Turn off TIMX */
-        __HAL_TIM_DISABLE_IT(&htim8, TIM_IT_CC1);     /* Turn off channel 1 to capture the interrupt */
-        __HAL_TIM_DISABLE_IT(&htim8, TIM_IT_CC2);     /* Turn off channel 2 to capture the interrupt */
-        __HAL_TIM_DISABLE_IT(&htim8, TIM_IT_UPDATE);  /* Turn off overflow interrupts. */
-
-         TIM8->SR = 0;                                /* Clear all interrupt flags. */
-      }
-      else
-      {
-        atim_timx_pwmin_chy_restart();
-      }
-    }
+    icap_half(htim);                              /* Half a counter period without a rising edge */
   }
-
-  TIM8->SR = 0;                                                /* Clear all interrupt flags. */
 }
 
-
 /* USER CODE END 1 */
@@ -0,0 +1,737 @@
+/**
+ ****************************************************************************************************
+ * @file        icap_sim.c
+ * @author      ALIENTEK
+ * @brief       Runs ATK_Middlewares/ICAP/icap.c on a Linux host against a model of a timer and its
+ *              two capture DMA channels
+ *
+ *              The model works edge by edge at the tick of the timer:
+ *              - A square wave drives channel 1 (rising edges) and channel 2 (falling edges), each
+ *                capture is written by its DMA channel into the ring of its stream. CNDTR counts down
+ *                and reloads (circular), the half transfer and transfer complete interrupts call
+ *                icap_dma_half.
+ *              - The counter counts up to 65535. ICAP_EDGE: it runs freely, as TIM5 in
+ *                08_3_gtim_capture. ICAP_SPAN: a rising edge resets it (PWM input with the slave
+ *                reset, as TIM8 in 09_4_atim_pwm_in), the reset takes effect 2 ticks later without
+ *                prescaler, 1 tick with it, and URS keeps it from raising the update interrupt.
+ *              - Channel 3 compares at 0x8000 (icap_half), the overflow calls icap_update. One timer
+ *                handler does both, compare first, as HAL_TIM_IRQHandler. The DMA handlers run after
+ *                it (higher IRQ numbers).
+ *              - The CPU is busy for random stretches of up to a latency, the interrupts raised then
+ *                run at the end of it, in the order of their IRQ numbers.
+ *
+ *              ICAP_EDGE: every timestamp must be exact, none left out. The cases put edges close to
+ *              the overflow and the half period on either side, and let up to 400000 ticks pass
+ *              between edges.
+ *              ICAP_SPAN: every period and high time reported must be one that was measured, in
+ *              order, and shorter than a counter period. Spans are only dropped around an overflow:
+ *              at most the captures from half a period before it to its interrupt, plus one. The
+ *              cases put the rising and the falling edges on either side of the overflow, pause the
+ *              signal after bursts and after short high times, and run without and with prescaler.
+ *              range must count the overflows, overrun and lost must stay 0, the batch statistics
+ *              must match the results.
+ *
+ *              Build, from example/08_3_gtim_capture or example/09_4_atim_pwm_in:
+ *              gcc -O2 -Wall -Wno-pointer-to-int-cast -Itools/host tools/icap_sim.c ATK_Middlewares/ICAP/icap.c -o icap_sim
+ *              Run:
+ *              ./icap_sim [-s seed] [-v]               (-v: one line per case)
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "../ATK_Middlewares/ICAP/icap.h"
+
+#define SIM_EDGES           100000      /* Edges per case */
+#define SIM_TRUTH           (SIM_EDGES / 2 + 2)
+#define SIM_GAP             5000        /* Ticks between two busy stretches of the CPU, at most */
+#define SIM_OVF_MAX         4
+
+typedef struct
+{
+    uint64_t t;                         /* Time of the capture */
+    uint32_t v;                         /* Timestamp (ICAP_EDGE) or span (ICAP_SPAN) */
+    uint32_t rep;                       /* ICAP_SPAN: what a capture value gives, right or not */
+    uint8_t valid;                      /* ICAP_SPAN: the span is shorter than a counter period */
+    uint8_t drop;                       /* ICAP_SPAN: may be dropped at an overflow */
+} sim_truth_t;
+
+typedef uint64_t (*sim_gen_t)(uint64_t t, uint8_t rising);
+
+static TIM_TypeDef g_tim;
+static DMA_Channel_TypeDef g_dma_ch[2];
+static TIM_HandleTypeDef g_htim = {&g_tim};
+static DMA_HandleTypeDef g_hdma[2] = {{&g_dma_ch[0], NULL, NULL}, {&g_dma_ch[1], NULL, NULL}};
+static icap_stream_t g_stream[2];       /* 0: rising edges, channel 1; 1: falling edges, channel 2 */
+static uint8_t g_kind;
+
+/* Model state */
+static uint8_t g_dma_on[2];
+static uint8_t g_dma_ht[2], g_dma_tc[2];    /* Flags of the DMA channels */
+static uint32_t g_half = ICAP_NO_CHANNEL;   /* Channel of the half period compare */
+static uint8_t g_tim_irq;               /* Timer interrupt pending */
+static uint64_t g_now;                  /* Ticks */
+static uint64_t g_zero, g_zero_prev;    /* Time of count 0, before and after the last reset */
+static uint64_t g_tev;                  /* Next compare or overflow */
+static uint8_t g_tev_ovf;               /* 1, g_tev is an overflow */
+static uint64_t g_rise;                 /* Last rising edge */
+static uint8_t g_have_rise;
+static uint16_t g_corr;                 /* Ticks from a reset edge to count 0 */
+static uint64_t g_busy_from, g_busy_to; /* The CPU takes no interrupt in [from, to) */
+static uint32_t g_latency;
+static uint64_t g_ovf_at[SIM_OVF_MAX];  /* Overflows not seen by icap_update yet */
+static uint32_t g_ovf_num, g_ovf;
+
+/* Expected and measured results of the streams */
+static sim_truth_t g_truth[2][SIM_TRUTH];
+static uint32_t g_tn[2];                /* Captures */
+static uint32_t g_ptr[2];               /* First capture not matched by a result yet */
+static uint32_t g_nres[2], g_nvalid[2];
+static uint64_t g_sum[2];
+static uint32_t g_miss[2];              /* Valid captures without a result that may not be dropped */
+static uint8_t g_skip[2];               /* ICAP_SPAN: the next capture may be dropped */
+static uint64_t g_half_at;              /* Last compare interrupt in the second half of the period */
+
+static uint32_t g_gen_n;                /* Generators: edges so far */
+static uint64_t g_gen_high;
+
+static int g_verbose = 0;
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+static uint32_t rnd(uint32_t max)
+{
+    return max ? (uint32_t)(rand() % (max + 1)) : 0;
+}
+
+/******************************************************************************************/
+/* HAL of the model */
+
+void TIM_CCxChannelCmd(TIM_TypeDef *TIMx, uint32_t Channel, uint32_t ChannelState)
+{
+    TIMx->CCER = (TIMx->CCER & ~(1u << Channel)) | (ChannelState << Channel);
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel)
+{
+    (void)htim;
+    CHECK(sConfig->Pulse == 0x8000, "half period compare at %u", sConfig->Pulse);
+    g_half = Channel;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+    int i = (int)(hdma - g_hdma);
+
+    (void)SrcAddress;                   /* 32-bit addresses: the model writes the ring of g_stream[i] */
+    (void)DstAddress;
+
+    if (g_dma_on[i])return HAL_ERROR;
+
+    CHECK(DataLength == ICAP_DMA_LEN, "DMA length %u", DataLength);
+    hdma->Instance->CNDTR = DataLength;
+    g_dma_on[i] = 1;
+    g_dma_ht[i] = g_dma_tc[i] = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+    int i = (int)(hdma - g_hdma);
+
+    g_dma_on[i] = 0;
+    g_dma_ht[i] = g_dma_tc[i] = 0;
+    return HAL_OK;
+}
+
+/******************************************************************************************/
+/* Model of the timer, the DMA and the interrupts */
+
+/**
+ * @brief       Counter at a time, the reset of a rising edge takes g_corr ticks
+ */
+static uint16_t sim_cnt(uint64_t t)
+{
+    return (uint16_t)(t - (t < g_zero ? g_zero_prev : g_zero));
+}
+
+/**
+ * @brief       Captures of a stream without a result, up to the capture end
+ */
+static void sim_miss(int i, uint32_t end)
+{
+    uint32_t j;
+
+    for (j = g_ptr[i]; j < end; j++)
+    {
+        g_miss[i] += g_truth[i][j].valid && !g_truth[i][j].drop;
+    }
+}
+
+/**
+ * @brief       Results of the streams, as the main loop reads them
+ */
+static void sim_drain(void)
+{
+    uint32_t buf[ICAP_TS_LEN];
+    uint16_t n, k;
+    uint32_t j, lim, bad;
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        while ((n = icap_read(&g_stream[i], buf, ICAP_TS_LEN)) != 0)
+        {
+            for (k = 0; k < n; k++)
+            {
+                g_nres[i]++;
+                g_sum[i] += buf[k];
+
+                lim = (g_stream[i].done < g_tn[i]) ? g_stream[i].done : g_tn[i];   /* Captures processed so far */
+                bad = lim;
+
+                for (j = g_ptr[i]; j < lim; j++)    /* The capture that gives this result, none skipped */
+                {
+                    if (g_truth[i][j].valid && g_truth[i][j].v == buf[k])break;
+
+                    if (!g_truth[i][j].valid && g_truth[i][j].rep == buf[k] && bad == lim)bad = j;
+
+                    if (g_truth[i][j].valid && !g_truth[i][j].drop)j = lim - 1;
+                }
+
+                if (j == lim && bad == lim)         /* Or with valid captures skipped */
+                {
+                    for (j = g_ptr[i]; j < lim && !(g_truth[i][j].valid && g_truth[i][j].v == buf[k]); j++);
+                }
+
+                if (j == lim && bad < lim)
+                {
+                    CHECK(0, "stream %d: span %u reported, the capture at %llu ended a span of %u ticks",
+                          i, buf[k], (unsigned long long)g_truth[i][bad].t, g_truth[i][bad].v);
+                    j = bad;
+                }
+                else if (j == lim)
+                {
+                    CHECK(0, "stream %d: %s %u (%08x) was never measured", i, g_kind == ICAP_EDGE ? "timestamp" : "span", buf[k], buf[k]);
+                    continue;
+                }
+
+                sim_miss(i, j);
+                g_ptr[i] = j + 1;
+            }
+        }
+    }
+}
+
+/**
+ * @brief       Captures that icap_update may drop: since the compare interrupt at half the period
+ *              before the overflow (or half a period before it), and the next one of each stream
+ */
+static void sim_drop(uint64_t ovf)
+{
+    uint64_t from = (g_half_at > ovf - 0x8000) ? g_half_at : ovf - 0x8000;
+    uint32_t j;
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        for (j = g_tn[i]; j && g_truth[i][j - 1].t >= from; j--)
+        {
+            g_truth[i][j - 1].drop = 1;
+        }
+
+        g_skip[i] = 1;
+    }
+}
+
+/**
+ * @brief       Pending interrupts, in the order of their IRQ numbers: the timer, then the DMA
+ */
+static void sim_irqs(void)
+{
+    uint32_t flag;
+    int i;
+
+    g_tim.CNT = sim_cnt(g_now);
+
+    if (g_tim_irq)                      /* HAL_TIM_IRQHandler: compares first, then the update */
+    {
+        g_tim_irq = 0;
+
+        for (i = 0; i < 4; i++)
+        {
+            flag = TIM_FLAG_CC1 << i;
+
+            if ((g_tim.SR & flag) && (g_tim.DIER & flag))
+            {
+                g_tim.SR &= ~flag;
+
+                if ((uint32_t)i << 2 != g_half)continue;
+
+                if (g_tim.CNT & 0x8000)g_half_at = g_now;
+
+                icap_half(&g_htim);
+            }
+        }
+
+        if ((g_tim.SR & TIM_FLAG_UPDATE) && (g_tim.DIER & TIM_IT_UPDATE))
+        {
+            g_tim.SR &= ~TIM_FLAG_UPDATE;
+            icap_update(&g_htim);
+
+            for (i = 0; i < (int)g_ovf_num; i++)sim_drop(g_ovf_at[i]);
+
+            g_ovf_num = 0;
+        }
+    }
+
+    for (i = 0; i < 2; i++)             /* HAL_DMA_IRQHandler: one flag per call, the half first */
+    {
+        while (g_dma_ht[i] || g_dma_tc[i])
+        {
+            if (g_dma_ht[i])
+            {
+                g_dma_ht[i] = 0;
+                g_hdma[i].XferHalfCpltCallback(&g_hdma[i]);
+            }
+            else
+            {
+                g_dma_tc[i] = 0;
+                g_hdma[i].XferCpltCallback(&g_hdma[i]);
+            }
+        }
+    }
+
+    sim_drain();
+}
+
+/**
+ * @brief       Interrupts pending
+ */
+static uint8_t sim_pending(void)
+{
+    return g_tim_irq || g_dma_ht[0] || g_dma_tc[0] || g_dma_ht[1] || g_dma_tc[1];
+}
+
+/**
+ * @brief       Runs the pending interrupts, unless the CPU is busy
+ */
+static void sim_service(void)
+{
+    if ((g_now < g_busy_from || g_now >= g_busy_to) && sim_pending())sim_irqs();
+
+    if (g_now >= g_busy_to)             /* Next busy stretch */
+    {
+        g_busy_from = g_now + 1 + rnd(SIM_GAP);
+        g_busy_to = g_busy_from + rnd(g_latency);
+    }
+}
+
+/**
+ * @brief       Compare at half the period or overflow
+ */
+static void sim_timer_event(void)
+{
+    uint32_t flag;
+
+    if (g_tev_ovf)
+    {
+        g_tim.SR |= TIM_FLAG_UPDATE;
+        g_tim_irq |= (g_tim.DIER & TIM_IT_UPDATE) != 0;
+
+        if (g_kind == ICAP_SPAN && g_ovf_num < SIM_OVF_MAX)g_ovf_at[g_ovf_num++] = g_now;
+
+        g_ovf++;
+    }
+    else if (g_half != ICAP_NO_CHANNEL)
+    {
+        flag = TIM_FLAG_CC1 << (g_half >> 2);
+        g_tim.SR |= flag;
+        g_tim_irq |= (g_tim.DIER & flag) != 0;
+    }
+
+    if (g_tev < g_zero)                 /* Just before a reset: the count starts over */
+    {
+        g_tev = g_zero + 0x8000;
+        g_tev_ovf = 0;
+    }
+    else
+    {
+        g_tev += 0x8000;
+        g_tev_ovf ^= 1;
+    }
+}
+
+/**
+ * @brief       Edge of the input, captured by channel 1 (rising) or channel 2 (falling)
+ */
+static void sim_edge(uint8_t rising)
+{
+    int i = rising ? 0 : 1;
+    uint32_t ch = rising ? TIM_CHANNEL_1 : TIM_CHANNEL_2;
+    uint16_t v = sim_cnt(g_now);
+    sim_truth_t *tr;
+
+    if ((g_tim.CCER & (1u << ch)) && (g_tim.DIER & (TIM_DMA_CC1 << i)) && g_dma_on[i])
+    {
+        g_stream[i].buf[ICAP_DMA_LEN - g_dma_ch[i].CNDTR] = v;
+
+        if (--g_dma_ch[i].CNDTR == ICAP_DMA_LEN / 2)g_dma_ht[i] = 1;
+
+        if (g_dma_ch[i].CNDTR == 0)
+        {
+            g_dma_ch[i].CNDTR = ICAP_DMA_LEN;
+            g_dma_tc[i] = 1;
+        }
+
+        if (g_tn[i] < SIM_TRUTH)
+        {
+            tr = &g_truth[i][g_tn[i]++];
+            tr->t = g_now;
+
+            if (g_kind == ICAP_EDGE)
+            {
+                tr->v = (uint32_t)g_now;    /* The count started at 0 at time 0 */
+                tr->valid = 1;
+            }
+            else
+            {
+                tr->v = (uint32_t)(g_now - g_rise);
+                tr->rep = v + g_corr;
+                tr->valid = g_have_rise && g_now - g_zero < 0x10000;
+                tr->drop = g_skip[i];
+                g_skip[i] = 0;
+            }
+
+            g_nvalid[i] += tr->valid;
+        }
+    }
+
+    if (rising && g_kind == ICAP_SPAN)  /* Slave mode reset */
+    {
+        g_rise = g_now;
+        g_have_rise = 1;
+        g_zero_prev = g_zero;
+        g_zero = g_now + g_corr;
+
+        if (g_tev >= g_zero)
+        {
+            g_tev = g_zero + 0x8000;
+            g_tev_ovf = 0;
+        }
+    }
+}
+
+/**
+ * @brief       Runs a case
+ * @param       name : name of the case
+ * @param       kind : ICAP_EDGE or ICAP_SPAN
+ * @param       psc : prescaler of the timer
+ * @param       gen : next edge after t, rising or falling
+ */
+static void sim_case(const char *name, uint8_t kind, uint16_t psc, sim_gen_t gen)
+{
+    uint64_t edge, busy, end = UINT64_MAX;
+    uint8_t rising = 1;
+    uint32_t n = 0, dropped[2];
+    icap_stat_t st;
+    uint32_t iv, ivmin, ivmax, j;
+    int i;
+
+    memset(&g_tim, 0, sizeof(g_tim));
+    memset(g_truth, 0, sizeof(g_truth));
+    g_tim.PSC = psc;
+    g_kind = kind;
+    g_half = ICAP_NO_CHANNEL;
+    g_tim_irq = 0;
+    g_now = 0;
+    g_zero = g_zero_prev = 0;
+    g_tev = 0x8000;
+    g_tev_ovf = 0;
+    g_rise = 0;
+    g_have_rise = 0;
+    g_corr = (kind == ICAP_SPAN) ? (psc == 0 ? 2 : 1) : 0;
+    g_busy_from = g_busy_to = 0;
+    g_ovf_num = g_ovf = 0;
+    g_half_at = 0;
+    g_gen_n = 0;
+    g_gen_high = 0;
+
+    for (i = 0; i < 2; i++)
+    {
+        g_tn[i] = g_ptr[i] = g_nres[i] = g_nvalid[i] = 0;
+        g_sum[i] = 0;
+        g_miss[i] = 0;
+        g_skip[i] = 1;                  /* The first capture has no span */
+    }
+
+    CHECK(icap_init(&g_stream[0], &g_htim, TIM_CHANNEL_1, &g_hdma[0], kind) == 0, "icap_init channel 1");
+    CHECK(icap_init(&g_stream[1], &g_htim, TIM_CHANNEL_2, &g_hdma[1], kind) == 0, "icap_init channel 2");
+    CHECK(icap_start(&g_htim) == 0, "icap_start");
+    CHECK(g_half == TIM_CHANNEL_3, "half period compare on channel %u", g_half);
+    CHECK((g_tim.CR1 & TIM_CR1_URS) && g_tim.CNT == 0, "URS and the count at start");
+
+    edge = gen(0, 1);
+
+    while (g_now < end)
+    {
+        busy = sim_pending() && g_now < g_busy_to ? g_busy_to : UINT64_MAX;
+
+        if (g_tev <= edge && g_tev <= busy && g_tev <= end)     /* The timer first, at the same tick */
+        {
+            g_now = g_tev;
+            sim_timer_event();
+        }
+        else if (busy <= edge && busy <= end)
+        {
+            g_now = busy;
+        }
+        else if (edge <= end)
+        {
+            g_now = edge;
+            sim_edge(rising);
+            rising ^= 1;
+
+            if (++n < SIM_EDGES)
+            {
+                g_gen_n++;
+                edge = gen(g_now, rising);
+
+                if (edge < g_now + 3)edge = g_now + 3;
+            }
+            else
+            {
+                edge = UINT64_MAX;
+                end = g_now + 3 * 0x10000;  /* The signal stops, the interrupts take the last values */
+            }
+        }
+        else
+        {
+            g_now = end;
+        }
+
+        sim_service();
+    }
+
+    g_busy_from = g_busy_to = UINT64_MAX;
+    sim_irqs();
+
+    for (i = 0; i < 2; i++)
+    {
+        icap_stat(&g_stream[i], &st);
+        CHECK(g_stream[i].overrun == 0, "%s stream %d: overrun %u", name, i, g_stream[i].overrun);
+
+        dropped[i] = g_nvalid[i] - g_nres[i];       /* Results dropped or lost, the statistics have the lost ones */
+
+        if (kind == ICAP_EDGE)
+        {
+            CHECK(dropped[i] == g_stream[i].lost, "%s stream %d: %u of %u timestamps missing, %u lost", name, i, dropped[i], g_tn[i], g_stream[i].lost);
+            CHECK(g_stream[i].range == 0, "%s stream %d: range %u", name, i, g_stream[i].range);
+
+            ivmin = 0xFFFFFFFF;
+            ivmax = 0;
+
+            for (j = 1; j < g_tn[i]; j++)
+            {
+                iv = g_truth[i][j].v - g_truth[i][j - 1].v;
+
+                if (iv < ivmin)ivmin = iv;
+
+                if (iv > ivmax)ivmax = iv;
+            }
+
+            CHECK(st.count == g_tn[i] - 1 && st.sum == g_truth[i][g_tn[i] - 1].t - g_truth[i][0].t && st.min == ivmin && st.max == ivmax,
+                  "%s stream %d: statistics %u intervals, sum %llu, min %u, max %u", name, i, st.count, (unsigned long long)st.sum, st.min, st.max);
+        }
+        else
+        {
+            sim_miss(i, g_tn[i]);
+            CHECK(g_miss[i] <= g_stream[i].lost, "%s stream %d: %u spans away from an overflow dropped, %u lost", name, i, g_miss[i], g_stream[i].lost);
+            CHECK(g_stream[i].range == g_ovf, "%s stream %d: range %u, %u overflows", name, i, g_stream[i].range, g_ovf);
+            CHECK(st.count == g_nres[i] + g_stream[i].lost && (g_stream[i].lost || st.sum == g_sum[i]), "%s stream %d: statistics %u spans, sum %llu",
+                  name, i, st.count, (unsigned long long)st.sum);
+        }
+    }
+
+    if (g_verbose)
+    {
+        printf("%-18s psc %u latency %5u: %6u/%6u results, %5u/%5u lost, %5u/%5u dropped, %u overflows\n", name, psc, g_latency,
+               g_nres[0], g_nres[1], g_stream[0].lost, g_stream[1].lost, dropped[0] - g_stream[0].lost, dropped[1] - g_stream[1].lost, g_ovf);
+    }
+}
+
+/******************************************************************************************/
+/* Signals: the next edge after t. Edges closer than 3 ticks are moved */
+
+/**
+ * @brief       k-th value of [lo, hi], a value repeats only after hi - lo + 1 of them (hi - lo + 1 prime
+ *              to 7919): a span dropped next to an equal one would be taken for it
+ */
+static uint32_t sim_spread(uint32_t k, uint32_t lo, uint32_t hi)
+{
+    return lo + (uint32_t)((uint64_t)k * 7919 % (hi - lo + 1));
+}
+
+static uint64_t sim_near(uint64_t t, uint64_t step)
+{
+    return (t / step + 1 + rnd(1)) * step - 300 + rnd(600);
+}
+
+static uint64_t gen_fast(uint64_t t, uint8_t rising)
+{
+    (void)rising;
+    return t + 72 + rnd(2);             /* 500kHz at 72MHz */
+}
+
+static uint64_t gen_mid(uint64_t t, uint8_t rising)
+{
+    (void)rising;
+    return t + 3600;
+}
+
+static uint64_t gen_slow(uint64_t t, uint8_t rising)
+{
+    (void)rising;
+    return t + 50000 + rnd(3);
+}
+
+static uint64_t gen_random(uint64_t t, uint8_t rising)
+{
+    (void)rising;
+    return t + 1 + rnd(200000);
+}
+
+static uint64_t gen_wrap(uint64_t t, uint8_t rising)
+{
+    (void)rising;
+    return sim_near(t, 0x10000);        /* Either side of an overflow of the free running counter */
+}
+
+static uint64_t gen_half(uint64_t t, uint8_t rising)
+{
+    (void)rising;
+    return sim_near(t, 0x8000);
+}
+
+static uint64_t gen_burst(uint64_t t, uint8_t rising)
+{
+    (void)rising;
+    return (rand() % 50 == 0) ? t + 1 + rnd(400000) : t + 75 + rnd(50);
+}
+
+static uint64_t gen_pwm(uint64_t t, uint8_t rising)
+{
+    if (rising)return t + 144 - g_gen_high;
+
+    g_gen_high = sim_spread(g_gen_n / 2, 3, 141);
+    return t + g_gen_high;
+}
+
+/**
+ * @brief       PWM with periods of 65537 - lo ~ 65537 + hi ticks
+ */
+static uint64_t sim_pwm_long(uint64_t t, uint8_t rising, uint32_t lo, uint32_t hi)
+{
+    uint32_t period, high;
+
+    if (rising)return t + g_gen_high;   /* The rest of the period */
+
+    period = sim_spread(g_gen_n / 2, 65537 - lo, 65537 + hi);
+    high = sim_spread(g_gen_n / 2 + 12345, 3, 60000);
+    g_gen_high = period - high;
+    return t + high;
+}
+
+static uint64_t gen_limit(uint64_t t, uint8_t rising)
+{
+    return sim_pwm_long(t, rising, 600, 0);     /* The longest periods a counter period holds */
+}
+
+static uint64_t gen_period_wrap(uint64_t t, uint8_t rising)
+{
+    return sim_pwm_long(t, rising, 400, 400);   /* Rising edges on either side of the overflow */
+}
+
+static uint64_t gen_high_wrap(uint64_t t, uint8_t rising)
+{
+    if (rising)return t + sim_spread(g_gen_n / 2, 3, 303);
+
+    return t + sim_spread(g_gen_n / 2, 65537 - 400, 65537 + 400);   /* Falling edges on either side of the overflow */
+}
+
+static uint64_t gen_short_pause(uint64_t t, uint8_t rising)
+{
+    if (rising)return (g_gen_n % 40 == 0) ? t + 70000 + rnd(300000) : t + 200;
+
+    return t + sim_spread(g_gen_n / 2, 3, 53);  /* Short high times, no edge for more than a period after 20 */
+}
+
+static uint64_t gen_stop(uint64_t t, uint8_t rising)
+{
+    if (g_gen_n % 400 == 399)return t + 100000 + rnd(400000);  /* Stuck high or low */
+
+    return t + (rising ? 144 - g_gen_high : (g_gen_high = sim_spread(g_gen_n / 2, 40, 104)));
+}
+
+static uint64_t gen_pwm_random(uint64_t t, uint8_t rising)
+{
+    return t + sim_spread(g_gen_n / 2 + (rising ? 0 : 5000), 3, 150000);
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint32_t latency[] = {0, 300, 3000, 15000};    /* Below half a counter period and a DMA half at 500kHz */
+    unsigned seed = 1;
+    uint16_t psc;
+    int i, l;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-v") == 0)g_verbose = 1;
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)seed = strtoul(argv[++i], NULL, 0);
+    }
+
+    srand(seed);
+
+    for (l = 0; l < 4; l++)
+    {
+        g_latency = latency[l];
+        sim_case("edge 500kHz", ICAP_EDGE, 0, gen_fast);
+        sim_case("edge 10kHz", ICAP_EDGE, 0, gen_mid);
+        sim_case("edge slow", ICAP_EDGE, 0, gen_slow);
+        sim_case("edge random", ICAP_EDGE, 0, gen_random);
+        sim_case("edge near wrap", ICAP_EDGE, 0, gen_wrap);
+        sim_case("edge near half", ICAP_EDGE, 0, gen_half);
+        sim_case("edge bursts", ICAP_EDGE, 0, gen_burst);
+
+        for (psc = 0; psc < 2; psc++)
+        {
+            sim_case("span 500kHz", ICAP_SPAN, psc, gen_pwm);
+            sim_case("span limit", ICAP_SPAN, psc, gen_limit);
+            sim_case("span period wrap", ICAP_SPAN, psc, gen_period_wrap);
+            sim_case("span high wrap", ICAP_SPAN, psc, gen_high_wrap);
+            sim_case("span short, pause", ICAP_SPAN, psc, gen_short_pause);
+            sim_case("span stops", ICAP_SPAN, psc, gen_stop);
+            sim_case("span random", ICAP_SPAN, psc, gen_pwm_random);
+        }
+    }
+
+    printf("seed %u: 7 edge and 7 span cases of %u edges, interrupt latency up to %u ticks\n", seed, SIM_EDGES, latency[3]);
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+    return g_fails ? 1 : 0;
+}
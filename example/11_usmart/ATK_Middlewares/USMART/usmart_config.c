@@ -47,6 +47,9 @@ struct _m_usmart_dev usmart_dev =
     0,      /* The parameter of the function requires PARM LEN initialization */
 };
 
+/* Function descriptors, one for each entry of usmart_nametab, filled in by usmart_fdesc_init */
+struct _m_usmart_fdesc usmart_fdesc[sizeof(usmart_nametab) / sizeof(struct _m_usmart_nametab)];
+
 
 
 
@@ -61,6 +61,53 @@ char *usmart_get_input_string(void)
     return pbuf;
 }
 
+/**
+ * @brief       Start the cycle counter
+ * @note        The DWT cycle counter of the Cortex-M3 is used, you need to modify it based on the MCU you are migrating to
+ * @param       none
+ * @retval      none
+ */
+void usmart_cyc_init(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)      /* The cycle counter is not running yet */
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; /* Enable the DWT unit */
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;            /* Start the cycle counter */
+    }
+}
+
+/**
+ * @brief       Get the cycle counter
+ * @param       none
+ * @retval      Current value of the cycle counter, it wraps around every 2^32 cycles
+ */
+uint32_t usmart_cyc_get(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief       Get the cycle counter frequency
+ * @param       none
+ * @retval      Cycle counter frequency, unit :Hz
+ */
+uint32_t usmart_cyc_freq(void)
+{
+    return SystemCoreClock;
+}
+
+/**
+ * @brief       Get the millisecond tick
+ * @note        Used to schedule the profiling samples (psample command)
+ * @param       none
+ * @retval      Millisecond tick
+ */
+uint32_t usmart_get_ms(void)
+{
+    return HAL_GetTick();
+}
+
 /* If timer scanning is enabled, you need to define the following functions */
 #if USMART_ENTIMX_SCAN == 1
 
@@ -44,6 +44,8 @@
 #define MAX_FNAME_LEN           30      /* The maximum length of the function name, which should be set to not less than the length of the longest function name. */
 #define MAX_PARM                10      /* The value contains a maximum of 10 parameters. To modify this parameter, you must modify usmart_exe. */
 #define PARM_LEN                200     /* The length of the sum of all parameters should not exceed PARM_LEN bytes, and the serial port receiving part should correspond to it (not less than PARM_LEN). */
+#define USMART_HASH_SIZE        32      /* Number of function name hash buckets, must be a power of 2. Set it close to the number of functions in usmart_nametab */
+#define USMART_CMD_SEP          ';'     /* Separator of the commands in a batch, e.g. "led_set(0);led_set(1)" */
 
 
 #define USMART_ENTIMX_SCAN      1       /* Use TIM's timer interrupt to scan the Scan Function, if set to 0, you need to implement your own scan function at regular intervals
@@ -52,6 +54,9 @@
 
 #define USMART_USE_HELP         1       /* With help, this value is set to 0, which saves nearly 700 bytes, but results in no help information being displayed */
 #define USMART_USE_WRFUNS       1       /* Using the read and write function, enable here, can read the value of any address, can also write the value of the register */
+#define USMART_USE_PROF         1       /* Using the profiling commands (prof/psample/pstop), the execution time is measured with the DWT cycle counter */
+#define USMART_PROF_MAX         128     /* Number of samples kept for the percentiles and the histogram, each sample takes 4 bytes of SRAM */
+#define USMART_PROF_HBINS       8       /* Number of histogram bins */
 
 #define USMART_PRINTF           printf  /* Define the printf output */
 
@@ -61,5 +66,9 @@ char * usmart_get_input_string(void); 		/* Gets the input data stream */
 void usmart_timx_reset_time(void);      	/* Reset run time */
 uint32_t usmart_timx_get_time(void);     	/* Get run time */
 void usmart_timx_init(void);   				/* Initialization timer */
+void usmart_cyc_init(void);                 /* Start the cycle counter */
+uint32_t usmart_cyc_get(void);              /* Get the cycle counter */
+uint32_t usmart_cyc_freq(void);             /* Get the cycle counter frequency (Hz) */
+uint32_t usmart_get_ms(void);               /* Get the millisecond tick */
 
 #endif
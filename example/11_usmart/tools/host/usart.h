@@ -0,0 +1,14 @@
+/**
+ * Host build of USMART (tools/usmart_host.c): stands in for Core/Inc/usart.h,
+ * usmart_port.h only needs the standard types and printf from it.
+ */
+
+#ifndef __USART_H
+#define __USART_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+void MX_TIM4_Init(void);        /* Starts the scan timer, in usmart_host.c */
+
+#endif
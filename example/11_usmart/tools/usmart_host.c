@@ -0,0 +1,287 @@
+/**
+ ****************************************************************************************************
+ * @file        usmart_host.c
+ * @author      ALIENTEK
+ * @brief       USMART on a Linux host: the same parser, call path and profiling commands as on the board
+ *
+ *              The commands come from stdin, one line per command line as typed in the serial assistant.
+ *              usmart_scan runs every 10ms from a timerfd thread, like the TIM4 interrupt on the board,
+ *              so psample is scheduled the same way. The cycle counter is CLOCK_MONOTONIC in ns (1000 MHz).
+ *              Lines "#wait N" pause the input N ms (let a psample run), other lines starting with '#' are comments.
+ *              As on the board, a function pointer parameter is its address: "id" prints them.
+ *
+ *              USMART passes every parameter as 32 bits, strings and function pointers included: build
+ *              without PIE so that the globals (usmart_dev.parm, the functions) have 32-bit addresses.
+ *
+ *              Build, from example/11_usmart:
+ *              gcc -O2 -no-pie -Itools/host -IATK_Middlewares/USMART -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast
+ *                  tools/usmart_host.c ATK_Middlewares/USMART/usmart.c ATK_Middlewares/USMART/usmart_str.c
+ *                  ATK_Middlewares/USMART/usmart_prof.c -lpthread -o usmart_host
+ *              Run:
+ *              printf 'prof 1000 isqrt(123456789)\n#wait 1200\npsample 10 100 crc_buf(1024)\n#wait 1200\n' | ./usmart_host
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "usmart.h"
+#include "usmart_str.h"
+
+#define HOST_SCAN_MS        10          /* Scan period, the TIM4 period of the examples */
+
+static pthread_mutex_t g_host_lock = PTHREAD_MUTEX_INITIALIZER;
+static char g_host_rx_buf[PARM_LEN + 64];   /* Received line, g_usart_rx_buf of the board */
+static volatile int g_host_rx_sta = 0;      /* 1: a line is waiting for usmart_scan */
+static uint32_t g_host_t0 = 0;              /* usmart_timx_reset_time, in 0.1ms */
+
+/******************************************************************************************/
+/* Functions registered on the host: the LED ones of the example, and some to profile */
+
+static uint8_t g_host_buf[4096];
+
+void led_set(uint8_t sta)
+{
+    printf("LED0 %s\r\n", sta ? "on" : "off");
+}
+
+void test_fun(void(*ledset)(uint8_t), uint8_t sta)
+{
+    ledset(sta);
+}
+
+uint32_t isqrt(uint32_t x)
+{
+    uint32_t res = 0, bit = 1UL << 30;
+
+    while (bit > x)bit >>= 2;
+
+    while (bit)
+    {
+        if (x >= res + bit)
+        {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else
+        {
+            res >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    return res;
+}
+
+uint32_t crc_buf(uint32_t len)
+{
+    uint32_t crc = 0XFFFFFFFF, i;
+    uint8_t j;
+
+    if (len > sizeof(g_host_buf))len = sizeof(g_host_buf);
+
+    for (i = 0; i < len; i++)
+    {
+        crc ^= g_host_buf[i];
+
+        for (j = 0; j < 8; j++)crc = (crc >> 1) ^ (0XEDB88320 & (0 - (crc & 1)));
+    }
+
+    return ~crc;
+}
+
+uint32_t str_hash(char *str)
+{
+    return usmart_strhash(str);
+}
+
+void spin(uint32_t n)
+{
+    volatile uint32_t i;
+
+    for (i = 0; i < n; i++);
+}
+
+struct _m_usmart_nametab usmart_nametab[] =
+{
+#if USMART_USE_WRFUNS == 1
+    (void *)read_addr, "uint32_t read_addr(uint32_t addr)",
+    (void *)write_addr, "void write_addr(uint32_t addr,uint32_t val)",
+#endif
+    (void *)led_set, "void led_set(uint8_t sta)",
+    (void *)test_fun, "void test_fun(void(*ledset)(uint8_t), uint8_t sta)",
+    (void *)isqrt, "uint32_t isqrt(uint32_t x)",
+    (void *)crc_buf, "uint32_t crc_buf(uint32_t len)",
+    (void *)str_hash, "uint32_t str_hash(char *str)",
+    (void *)spin, "void spin(uint32_t n)",
+};
+
+struct _m_usmart_dev usmart_dev =
+{
+    usmart_nametab,
+    usmart_init,
+    usmart_cmd_rec,
+    usmart_exe,
+    usmart_scan,
+    sizeof(usmart_nametab) / sizeof(struct _m_usmart_nametab),
+    0,
+    0,
+    1,
+    0,
+    0,
+    0,
+};
+
+struct _m_usmart_fdesc usmart_fdesc[sizeof(usmart_nametab) / sizeof(struct _m_usmart_nametab)];
+
+/******************************************************************************************/
+/* usmart_port.c of the host */
+
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+char *usmart_get_input_string(void)
+{
+    static char line[sizeof(g_host_rx_buf)];
+    char *pbuf = 0;
+
+    pthread_mutex_lock(&g_host_lock);
+
+    if (g_host_rx_sta)
+    {
+        memcpy(line, g_host_rx_buf, sizeof(line));
+        g_host_rx_sta = 0;
+        pbuf = line;
+    }
+
+    pthread_mutex_unlock(&g_host_lock);
+    return pbuf;
+}
+
+void usmart_cyc_init(void)
+{
+}
+
+uint32_t usmart_cyc_get(void)
+{
+    return (uint32_t)host_ns();
+}
+
+uint32_t usmart_cyc_freq(void)
+{
+    return 1000000000;
+}
+
+uint32_t usmart_get_ms(void)
+{
+    return (uint32_t)(host_ns() / 1000000);
+}
+
+void usmart_timx_reset_time(void)
+{
+    g_host_t0 = (uint32_t)(host_ns() / 100000);
+    usmart_dev.runtime = 0;
+}
+
+uint32_t usmart_timx_get_time(void)
+{
+    usmart_dev.runtime = (uint32_t)(host_ns() / 100000) - g_host_t0;
+    return usmart_dev.runtime;
+}
+
+/**
+ * @brief   Scan thread: usmart_scan every HOST_SCAN_MS, the TIM4 interrupt of the board
+ * @param   arg : not used
+ * @retval  None
+ */
+static void *host_scan_thread(void *arg)
+{
+    struct itimerspec its = {{0, HOST_SCAN_MS * 1000000}, {0, HOST_SCAN_MS * 1000000}};
+    uint64_t expired;
+    int fd;
+
+    (void)arg;
+    fd = timerfd_create(CLOCK_MONOTONIC, 0);
+    timerfd_settime(fd, 0, &its, NULL);
+
+    while (read(fd, &expired, sizeof(expired)) == sizeof(expired))
+    {
+        usmart_dev.scan();
+        fflush(stdout);
+    }
+
+    return NULL;
+}
+
+void MX_TIM4_Init(void)
+{
+    pthread_t tid;
+
+    pthread_create(&tid, NULL, host_scan_thread, NULL);
+}
+
+/**
+ * @brief   Feeds the lines of stdin to usmart_scan, one at a time
+ * @param   None
+ * @retval  0
+ */
+int main(void)
+{
+    char line[sizeof(g_host_rx_buf)];
+    size_t len;
+    int busy;
+
+    usmart_dev.init(72);
+
+    while (fgets(line, sizeof(line), stdin))
+    {
+        len = strcspn(line, "\r\n");
+        line[len] = '\0';
+
+        if (strncmp(line, "#wait", 5) == 0)
+        {
+            usleep(atoi(line + 5) * 1000);
+            continue;
+        }
+
+        if (line[0] == '#')continue;
+
+        pthread_mutex_lock(&g_host_lock);
+        memcpy(g_host_rx_buf, line, len + 1);
+        g_host_rx_sta = 1;
+        pthread_mutex_unlock(&g_host_lock);
+
+        do      /* Next line once usmart_scan has taken this one, like the single receive buffer of the board */
+        {
+            usleep(1000);
+            pthread_mutex_lock(&g_host_lock);
+            busy = g_host_rx_sta;
+            pthread_mutex_unlock(&g_host_lock);
+        } while (busy);
+    }
+
+    usleep(2 * HOST_SCAN_MS * 1000);    /* The last command finishes */
+    return 0;
+}
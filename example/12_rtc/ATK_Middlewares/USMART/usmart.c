@@ -26,6 +26,9 @@
  * change logs	:
  * version		data		notes
  * V1.0			20240222	the first version
+ * V1.1			20261019	function table is parsed once into descriptors and looked up by name hash,
+ *							several commands separated by USMART_CMD_SEP can be executed in one line
+ * V1.2			20261019	add the profiling commands prof/psample/pstop (see usmart_prof.c)
  *
  ****************************************************************************************************
  */
@@ -36,8 +39,12 @@
 #include "usmart.h"
 #include "usmart_str.h"
 #include "usmart_port.h"
+#include "usmart_prof.h"
 
 
+static uint8_t g_usmart_htab[USMART_HASH_SIZE];    /* Function name hash buckets, the ID of the first function in each bucket */
+static uint8_t g_usmart_fdesc_sta = 0;              /* 0, usmart_fdesc has not been built; 1, built */
+
 /* system command */
 char *sys_cmd_tab[] =
 {
@@ -95,6 +102,12 @@ uint8_t usmart_sys_cmd_exe(char *str)
             USMART_PRINTF("hex:    The parameter is displayed in hexadecimal format, followed by a space + a number to perform a decimal conversion\r\n\n");
             USMART_PRINTF("dec:    The parameter is displayed in decimal, followed by a space + a number to perform a decimal conversion\r\n\n");
             USMART_PRINTF("runtime : 1, start the function runtime; 0, turn off the function runtime;\r\n\n");
+#if USMART_USE_PROF == 1
+            USMART_PRINTF("prof:   prof N func(...), run the function N times and display the cycle statistics and histogram\r\n\n");
+            USMART_PRINTF("psample:psample T N func(...), run the function once every T ms, display the statistics after N runs\r\n\n");
+            USMART_PRINTF("pstop:  Stop psample and display the statistics of the samples taken\r\n\n");
+#endif
+            USMART_PRINTF("Several commands separated by '%c' are executed in order, e.g. led_set(0)%cled_set(1)\r\n\n", USMART_CMD_SEP, USMART_CMD_SEP);
             USMART_PRINTF("Please enter the function name and parameters in the format written by the program and end with the enter key.\r\n");
             USMART_PRINTF("--------------------------ALIENTEK------------------------- \r\n");
 #else
@@ -239,6 +252,44 @@ void usmart_init(uint16_t tclk)
 	MX_TIM4_Init();			/* Initialization of the timer */
 #endif
     usmart_dev.sptype = 1;  /* Display parameters in hexadecimal format */
+    usmart_fdesc_init();    /* Parse the function table */
+}
+
+/**
+* @brief 	Parses the lookup strings of the function table into usmart_fdesc and builds the name hash buckets
+* @note		It is called by usmart_init, or by the first received command if usmart_init is not used.
+* 			After that, the lookup strings only need to be parsed again to confirm a name or to print it.
+* @param 	None
+* @retval 	0, successful; Other, error code.
+*/
+uint8_t usmart_fdesc_init(void)
+{
+    uint8_t i, id, sta;
+    uint8_t bucket;
+    char sfname[MAX_FNAME_LEN];     /* Store local function names */
+
+    g_usmart_fdesc_sta = 0;
+
+    for (i = 0; i < USMART_HASH_SIZE; i++)
+    {
+        g_usmart_htab[i] = USMART_FDESC_END;
+    }
+
+    for (i = usmart_dev.fnum; i > 0; i--)   /* Insert backwards, so that the function registered first is found first */
+    {
+        id = i - 1;
+        sta = usmart_get_fname((char *)usmart_dev.funs[id].name, sfname, &usmart_fdesc[id].pnum, &usmart_fdesc[id].rval);
+
+        if (sta)return sta;         /* Local parsing error */
+
+        usmart_fdesc[id].hash = usmart_strhash(sfname);
+        bucket = usmart_fdesc[id].hash & (USMART_HASH_SIZE - 1);
+        usmart_fdesc[id].next = g_usmart_htab[bucket];
+        g_usmart_htab[bucket] = id;
+    }
+
+    g_usmart_fdesc_sta = 1;
+    return USMART_OK;
 }
 
 /**
@@ -250,28 +301,41 @@ uint8_t usmart_cmd_rec(char *str)
 {
     uint8_t sta, i, rval;   /* status */
     uint8_t rpnum, spnum;
+    uint32_t hash;
     char rfname[MAX_FNAME_LEN];  /* A temporary storage space for the received function names */
     char sfname[MAX_FNAME_LEN];  /* Store local function names */
+
+    if (g_usmart_fdesc_sta == 0)
+    {
+        sta = usmart_fdesc_init();  /* The function table has not been parsed yet */
+
+        if (sta)return sta;     /* Local parsing error */
+    }
+
     sta = usmart_get_fname(str, rfname, &rpnum, &rval); /* Get the function name and number of parameters for the received data */
 
     if (sta)return sta;     /* Error */
 
-    for (i = 0; i < usmart_dev.fnum; i++)
-    {
-        sta = usmart_get_fname((char *)usmart_dev.funs[i].name, sfname, &spnum, &rval); /* Get the local function name and the number of arguments */
-
-        if (sta)return sta; /* Local parsing error */
+    hash = usmart_strhash(rfname);
+    i = g_usmart_htab[hash & (USMART_HASH_SIZE - 1)];
 
-        if (usmart_strcmp(sfname, rfname) == 0) /* Equality */
+    while (i != USMART_FDESC_END)   /* Only the functions in the same bucket are compared */
+    {
+        if (usmart_fdesc[i].hash == hash)
         {
-            if (spnum > rpnum)return USMART_PARMERR;/* Parameter errors (fewer input parameters than source function parameters) */
+            usmart_get_fname((char *)usmart_dev.funs[i].name, sfname, &spnum, &rval);  /* Confirm the name, different names may have the same hash */
 
-            usmart_dev.id = i;  /* Record function ID */
-            break;  /*Jump out */
+            if (usmart_strcmp(sfname, rfname) == 0)break;   /* Equality */
         }
+
+        i = usmart_fdesc[i].next;
     }
 
-    if (i == usmart_dev.fnum)return USMART_NOFUNCFIND;  /* No matching function was found */
+    if (i == USMART_FDESC_END)return USMART_NOFUNCFIND;    /* No matching function was found */
+
+    if (usmart_fdesc[i].pnum > rpnum)return USMART_PARMERR; /* Parameter errors (fewer input parameters than source function parameters) */
+
+    usmart_dev.id = i;      /* Record function ID */
 
     sta = usmart_get_fparam(str, &i);   /* Get the number of function parameters */
 
@@ -281,6 +345,96 @@ uint8_t usmart_cmd_rec(char *str)
     return USMART_OK;
 }
 
+/**
+* @brief 	Calls a function with the given parameters
+* @note		All the parameters are passed as 32-bit values (numbers, or the addresses of the strings).
+* @param 	func: function pointer
+* @param 	pnum: number of parameters, 0 to 10
+* @param 	temp: parameter values
+* @retval 	The return value of the function (meaningless when the function does not return a value)
+*/
+uint32_t usmart_call(void *func, uint8_t pnum, uint32_t *temp)
+{
+    uint32_t res = 0;
+
+    switch (pnum)
+    {
+        case 0: /* NONE */
+            res = (*(uint32_t(*)())func)();
+            break;
+
+        case 1: /* There are 1 parameters */
+            res = (*(uint32_t(*)())func)(temp[0]);
+            break;
+
+        case 2: /* There are 2 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1]);
+            break;
+
+        case 3: /* There are 3 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2]);
+            break;
+
+        case 4: /* There are 4 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2], temp[3]);
+            break;
+
+        case 5: /* There are 5 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2], temp[3], temp[4]);
+            break;
+
+        case 6: /* There are 6 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
+                    temp[5]);
+            break;
+
+        case 7: /* There are 7 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
+                    temp[5], temp[6]);
+            break;
+
+        case 8: /* There are 8 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
+                    temp[5], temp[6], temp[7]);
+            break;
+
+        case 9: /* There are 9 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
+                    temp[5], temp[6], temp[7], temp[8]);
+            break;
+
+        case 10:/* There are 10 parameters */
+            res = (*(uint32_t(*)())func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
+                    temp[5], temp[6], temp[7], temp[8], temp[9]);
+            break;
+    }
+
+    return res;
+}
+
+/**
+* @brief 	Converts the received parameters into 32-bit parameter values
+* @param 	parm: parameter buffer, usmart_dev.parm or a copy of it
+* @param 	temp: parameter values, strings are passed by their address in parm
+* @retval 	None
+*/
+void usmart_load_parm(uint8_t *parm, uint32_t *temp)
+{
+    uint8_t i;
+
+    for (i = 0; i < usmart_dev.pnum; i++)
+    {
+        if (usmart_dev.parmtype & (1 << i)) /* Argument is a string */
+        {
+            temp[i] = (uint32_t)&parm[usmart_get_parmpos(i)];
+        }
+        else    /* Parameters are numbers */
+        {
+            temp[i] = *(uint32_t *)(parm + usmart_get_parmpos(i));
+        }
+    }
+}
+
 /**
 * @brief 	USMART execution function
 * @note
@@ -337,72 +491,84 @@ void usmart_exe(void)
     usmart_timx_reset_time();   /* Timer reset and start counting */
 #endif
 
-    switch (usmart_dev.pnum)
-    {
-        case 0: /* NONE */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)();
-            break;
+    res = usmart_call(usmart_dev.funs[id].func, usmart_dev.pnum, temp);
 
-        case 1: /* There are 1 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0]);
-            break;
+#if USMART_ENTIMX_SCAN==1
+    usmart_timx_get_time(); /*  */
+#endif
 
-        case 2: /* There are 2 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1]);
-            break;
+    if (rval == 1)  /* Required return value */
+    {
+        if (usmart_dev.sptype == SP_TYPE_DEC)USMART_PRINTF("=%lu;\r\n", (unsigned long)res);   /* Output execution result (decimal parameter display) */
+        else USMART_PRINTF("=0X%X;\r\n", res);  /* Output execution result (hexadecimal parameter display) */
+    }
+    else USMART_PRINTF(";\r\n");    /* Do not need to return the value, directly output the end */
 
-        case 3: /* There are 3 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2]);
-            break;
+    if (usmart_dev.runtimeflag)     /* Need to display function execution time */
+    {
+        USMART_PRINTF("Function Run Time:%d.%1dms\r\n", usmart_dev.runtime / 10, usmart_dev.runtime % 10);  /* Print function execution time */
+    }
+}
 
-        case 4: /* There are 4 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2], temp[3]);
+/**
+* @brief 	Prints the error message of a command
+* @param 	sta: error code
+* @retval 	None
+*/
+static void usmart_print_err(uint8_t sta)
+{
+    switch (sta)
+    {
+        case USMART_FUNCERR:
+            USMART_PRINTF("parameter error !\r\n");
             break;
 
-        case 5: /* There are 5 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2], temp[3], temp[4]);
+        case USMART_PARMERR:
+            USMART_PRINTF("parameter error !\r\n");
             break;
 
-        case 6: /* There are 6 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
-                    temp[5]);
+        case USMART_PARMOVER:
+            USMART_PRINTF("parameter number too much !\r\n");
             break;
 
-        case 7: /* There are 7 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
-                    temp[5], temp[6]);
+        case USMART_NOFUNCFIND:
+            USMART_PRINTF("No matching function was found !\r\n");
             break;
+    }
+}
 
-        case 8: /* There are 8 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
-                    temp[5], temp[6], temp[7]);
-            break;
+/**
+* @brief 	Identifies and executes one command (a registered function or a system command)
+* @param 	str: command string
+* @retval 	None
+*/
+static void usmart_cmd_exe(char *str)
+{
+    uint8_t sta, len;
 
-        case 9: /* There are 9 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
-                    temp[5], temp[6], temp[7], temp[8]);
-            break;
+#if USMART_USE_PROF == 1
+    sta = usmart_prof_cmd_exe(str);
 
-        case 10:/* There are 10 parameters */
-            res = (*(uint32_t(*)())usmart_dev.funs[id].func)(temp[0], temp[1], temp[2], temp[3], temp[4], \
-                    temp[5], temp[6], temp[7], temp[8], temp[9]);
-            break;
+    if (sta != USMART_FUNCERR)  /* Profiling command, it has been processed */
+    {
+        usmart_print_err(sta);
+        return;
     }
-
-#if USMART_ENTIMX_SCAN==1
-    usmart_timx_get_time(); /*  */
 #endif
 
-    if (rval == 1)  /* Required return value */
+    sta = usmart_dev.cmd_rec(str);      /* Get the function information */
+
+    if (sta == 0)
     {
-        if (usmart_dev.sptype == SP_TYPE_DEC)USMART_PRINTF("=%lu;\r\n", (unsigned long)res);   /* Output execution result (decimal parameter display) */
-        else USMART_PRINTF("=0X%X;\r\n", res);  /* Output execution result (hexadecimal parameter display) */
+        usmart_dev.exe();  /* Executive function */
     }
-    else USMART_PRINTF(";\r\n");    /* Do not need to return the value, directly output the end */
-
-    if (usmart_dev.runtimeflag)     /* Need to display function execution time */
+    else
     {
-        USMART_PRINTF("Function Run Time:%d.%1dms\r\n", usmart_dev.runtime / 10, usmart_dev.runtime % 10);  /* Print function execution time */
+        len = usmart_sys_cmd_exe(str);
+
+        if (len != USMART_FUNCERR)sta = len;
+
+        usmart_print_err(sta);
     }
 }
 
@@ -413,53 +579,59 @@ void usmart_exe(void)
 * 			Execute the functions sent from the serial port in a timely manner.
 * 			This function can be called inside the interrupt, so as to achieve automatic management.
 * 			If it is not a positive atomic user, USART_RX_STA and USART_RX_BUF[] need to be implemented by the user
+* 			The received line may contain several commands separated by USMART_CMD_SEP, they are executed in order.
+* 			A separator inside a string parameter ("...") does not split the command.
 *
 * @param 	None
 * @retval 	None
 */
 void usmart_scan(void)
 {
-    uint8_t sta, len;
     char *pbuf = 0;
+    char *pcmd;
+    char end;
+    uint8_t string = 0;     /* Mark whether a string parameter is being read */
+    uint8_t cnt = 0;        /* Number of commands executed */
+
+#if USMART_USE_PROF == 1
+    usmart_prof_poll();     /* Take the scheduled profiling sample */
+#endif
 
     pbuf = usmart_get_input_string();   /* Get data data flow */
     if (pbuf == 0) return ; /* The data stream is empty and is returned directly */
-     
-    sta = usmart_dev.cmd_rec(pbuf);     /* Get the function information */
 
-    if (sta == 0)
-    {
-        usmart_dev.exe();  /* Executive function */
-    }
-    else
+    pcmd = pbuf;
+
+    while (1)
     {
-        len = usmart_sys_cmd_exe(pbuf);
+        if (string && *pbuf == '\\' && *(pbuf + 1) != '\0')
+        {
+            pbuf += 2;      /* Skip the escape character and the character after it */
+            continue;
+        }
 
-        if (len != USMART_FUNCERR)sta = len;
+        if (*pbuf == '"')string = !string;
 
-        if (sta)
+        if ((*pbuf == USMART_CMD_SEP && string == 0) || *pbuf == '\0')
         {
-            switch (sta)
-            {
-                case USMART_FUNCERR:
-                    USMART_PRINTF("parameter error !\r\n");
-                    break;
-
-                case USMART_PARMERR:
-                    USMART_PRINTF("parameter error !\r\n");
-                    break;
+            end = *pbuf;
+            *pbuf = '\0';  /* Cut out this command */
 
-                case USMART_PARMOVER:
-                    USMART_PRINTF("parameter number too much !\r\n");
-                    break;
+            while (*pcmd == ' ')pcmd++; /* Skip the leading spaces */
 
-                case USMART_NOFUNCFIND:
-                    USMART_PRINTF("No matching function was found !\r\n");
-                    break;
+            if (*pcmd != '\0' || (end == '\0' && cnt == 0))  /* Empty commands are ignored, unless the whole line is empty */
+            {
+                usmart_cmd_exe(pcmd);
+                cnt++;
             }
+
+            if (end == '\0')break; /* All the commands have been executed */
+
+            pcmd = pbuf + 1;
         }
-    } 
- 
+
+        pbuf++;
+    }
 }
 
 #if USMART_USE_WRFUNS == 1  /* If read and write operations are enabled */
@@ -0,0 +1,361 @@
+/**
+ ****************************************************************************************************
+ * @file        usmart_prof.c
+ * @author      ALIENTEK
+ * @brief       USMART profiling commands
+ *
+ * 				prof    N func(...)     : run a registered function N times and display the cycle statistics
+ * 				psample T N func(...)   : run a registered function once every T ms in the background,
+ * 				                          display the statistics after N runs
+ * 				pstop                   : stop psample and display the statistics of the samples taken
+ *
+ *              The execution time is measured with the DWT cycle counter (see usmart_cyc_get in usmart_port.c),
+ *              min/mean/max are counted over all runs, the percentiles and the histogram over the last USMART_PROF_MAX runs.
+ *              SRAM: USMART_PROF_MAX * 4 + PARM_LEN + 80 bytes
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform  	: ALIENTEK STM32F103 development board
+ * website		: https://www.alientek.com
+ * forum		: http://www.openedv.com/forum.php
+ *
+ * change logs	:
+ * version		data		notes
+ * V1.0			20261019	the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include "usmart.h"
+#include "usmart_str.h"
+#include "usmart_port.h"
+#include "usmart_prof.h"
+
+#if USMART_USE_PROF == 1
+
+static struct _m_usmart_prof g_usmart_prof;         /* Profiling statistics */
+static struct _m_usmart_psample g_usmart_psample;   /* Scheduled sampling */
+static uint32_t g_usmart_prof_ovh = 0;              /* Cost of reading the cycle counter, it is subtracted from each sample */
+
+/* profiling command */
+static char *prof_cmd_tab[] =
+{
+    "prof",
+    "psample",
+    "pstop",
+};
+
+/**
+* @brief 	Clears the profiling statistics and measures the cost of reading the cycle counter
+* @param 	None
+* @retval 	None
+*/
+static void usmart_prof_reset(void)
+{
+    uint32_t t0, t1;
+
+    usmart_cyc_init();
+    t0 = usmart_cyc_get();
+    t1 = usmart_cyc_get();
+    g_usmart_prof_ovh = t1 - t0;
+
+    g_usmart_prof.cnt = 0;
+    g_usmart_prof.min = 0XFFFFFFFF;
+    g_usmart_prof.max = 0;
+    g_usmart_prof.sum = 0;
+    g_usmart_prof.num = 0;
+    g_usmart_prof.pos = 0;
+}
+
+/**
+* @brief 	Runs a function once and records its execution time
+* @param 	func: function pointer
+* @param 	pnum: number of parameters
+* @param 	temp: parameter values
+* @retval 	None
+*/
+static void usmart_prof_run(void *func, uint8_t pnum, uint32_t *temp)
+{
+    uint32_t t0, cyc;
+
+    t0 = usmart_cyc_get();
+    usmart_call(func, pnum, temp);
+    cyc = usmart_cyc_get() - t0;    /* Unsigned subtraction, the counter may have wrapped around once */
+
+    cyc = (cyc > g_usmart_prof_ovh) ? cyc - g_usmart_prof_ovh : 0;
+
+    g_usmart_prof.cnt++;
+    g_usmart_prof.sum += cyc;
+
+    if (cyc < g_usmart_prof.min)g_usmart_prof.min = cyc;
+
+    if (cyc > g_usmart_prof.max)g_usmart_prof.max = cyc;
+
+    g_usmart_prof.buf[g_usmart_prof.pos] = cyc;
+    g_usmart_prof.pos = (g_usmart_prof.pos + 1) % USMART_PROF_MAX;
+
+    if (g_usmart_prof.num < USMART_PROF_MAX)g_usmart_prof.num++;
+}
+
+/**
+* @brief 	Prints a number of cycles and the corresponding time
+* @param 	title: line title
+* @param 	cyc: number of cycles
+* @retval 	None
+*/
+static void usmart_prof_print_cyc(char *title, uint32_t cyc)
+{
+    uint32_t ns;
+
+    ns = (uint32_t)((uint64_t)cyc * 1000000000 / usmart_cyc_freq());
+    USMART_PRINTF("%s%10lu cycles %8lu.%03luus\r\n", title, (unsigned long)cyc, (unsigned long)(ns / 1000), (unsigned long)(ns % 1000));
+}
+
+/**
+* @brief 	Prints the profiling statistics and histogram
+* @note		The kept samples are sorted in place, the statistics are cleared afterwards by the next prof/psample command.
+* @param 	id: function ID
+* @retval 	None
+*/
+static void usmart_prof_report(uint8_t id)
+{
+    uint16_t i, j, n;
+    uint32_t t, lo, width;
+    uint32_t *buf = g_usmart_prof.buf;
+    uint16_t hist[USMART_PROF_HBINS];
+    uint16_t hmax = 0;
+    char sfname[MAX_FNAME_LEN];
+    uint8_t pnum, rval;
+
+    usmart_get_fname((char *)usmart_dev.funs[id].name, sfname, &pnum, &rval);
+    USMART_PRINTF("\r\n%s: %lu runs, %lu MHz\r\n", sfname, (unsigned long)g_usmart_prof.cnt, (unsigned long)(usmart_cyc_freq() / 1000000));
+
+    n = g_usmart_prof.num;
+
+    if (n == 0)return;      /* No sample was taken */
+
+    for (i = 1; i < n; i++) /* Insertion sort, the number of samples is small */
+    {
+        t = buf[i];
+
+        for (j = i; j > 0 && buf[j - 1] > t; j--)
+        {
+            buf[j] = buf[j - 1];
+        }
+
+        buf[j] = t;
+    }
+
+    usmart_prof_print_cyc("min : ", g_usmart_prof.min);
+    usmart_prof_print_cyc("mean: ", (uint32_t)(g_usmart_prof.sum / g_usmart_prof.cnt));
+    usmart_prof_print_cyc("p50 : ", buf[(n - 1) * 50 / 100]);
+    usmart_prof_print_cyc("p90 : ", buf[(n - 1) * 90 / 100]);
+    usmart_prof_print_cyc("p99 : ", buf[(n - 1) * 99 / 100]);
+    usmart_prof_print_cyc("max : ", g_usmart_prof.max);
+
+    lo = buf[0];
+    width = (buf[n - 1] - lo) / USMART_PROF_HBINS + 1;  /* Bin width, unit :cycle */
+
+    for (i = 0; i < USMART_PROF_HBINS; i++)hist[i] = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        hist[(buf[i] - lo) / width]++;
+    }
+
+    for (i = 0; i < USMART_PROF_HBINS; i++)
+    {
+        if (hist[i] > hmax)hmax = hist[i];
+    }
+
+    USMART_PRINTF("Histogram of the last %d runs (cycles):\r\n", n);
+
+    for (i = 0; i < USMART_PROF_HBINS; i++)
+    {
+        USMART_PRINTF("%10lu-%-10lu|", (unsigned long)(lo + i * width), (unsigned long)(lo + (i + 1) * width - 1));
+
+        for (j = 0; j < hist[i] * 32 / hmax; j++)USMART_PRINTF("*");
+
+        USMART_PRINTF(" %d\r\n", hist[i]);
+    }
+
+    USMART_PRINTF("\r\n");
+}
+
+/**
+* @brief 	Gets a number parameter of a profiling command
+* @param 	str: string pointer, it is moved behind the number
+* @param 	num: the number
+* @retval 	0, successful; Other, error code.
+*/
+static uint8_t usmart_prof_get_num(char **str, uint32_t *num)
+{
+    char tstr[12];
+    uint8_t i, len;
+
+    while (**str == ' ')(*str)++;   /* Skip the spaces */
+
+    if (usmart_get_cmdname(*str, tstr, &len, sizeof(tstr)))return USMART_PARMERR;
+
+    *str += len;
+
+    for (i = 0; i < len; i++)       /* usmart_str2num only accepts upper case hexadecimal */
+    {
+        if ((tstr[i] >= 'a' && tstr[i] <= 'f') || tstr[i] == 'x')tstr[i] -= 0X20;
+    }
+
+    if (usmart_str2num(tstr, num))return USMART_PARMERR;
+
+    return USMART_OK;
+}
+
+/**
+* @brief 	Identifies the function of a profiling command
+* @note		The function name and parameters are stored in usmart_dev, like a normal command.
+* @param 	str: function string, e.g. "led_set(1)"
+* @retval 	0, successful; Other, error code.
+*/
+static uint8_t usmart_prof_get_func(char *str)
+{
+    uint8_t sta;
+
+    while (*str == ' ')str++;
+
+    sta = usmart_dev.cmd_rec(str);
+
+    if (sta == USMART_FUNCERR)sta = USMART_PARMERR; /* USMART_FUNCERR means "not a profiling command" to the caller */
+
+    return sta;
+}
+
+/**
+* @brief 	Handles the profiling commands
+* @param 	str: string pointer
+* @retval 	USMART_FUNCERR, not a profiling command; 0, successfully processed; Other, error code.
+*/
+uint8_t usmart_prof_cmd_exe(char *str)
+{
+    char cmd[MAX_FNAME_LEN];
+    uint8_t i, len, sta;
+    uint32_t n, t;
+    uint32_t temp[MAX_PARM];
+
+    if (usmart_get_cmdname(str, cmd, &len, MAX_FNAME_LEN))return USMART_FUNCERR;
+
+    for (i = 0; i < sizeof(prof_cmd_tab) / sizeof(prof_cmd_tab[0]); i++)
+    {
+        if (usmart_strcmp(cmd, prof_cmd_tab[i]) == 0)break;
+    }
+
+    str += len;
+
+    switch (i)
+    {
+        case 0: /* prof N func(...) */
+            if (g_usmart_psample.sta)
+            {
+                USMART_PRINTF("\r\npsample is running, stop it with pstop first !\r\n");
+                break;
+            }
+
+            sta = usmart_prof_get_num(&str, &n);
+
+            if (sta)return sta;
+
+            if (n == 0)return USMART_PARMERR;
+
+            sta = usmart_prof_get_func(str);
+
+            if (sta)return sta;
+
+            usmart_load_parm(usmart_dev.parm, temp);
+            usmart_prof_reset();
+
+            while (n--)
+            {
+                usmart_prof_run(usmart_dev.funs[usmart_dev.id].func, usmart_dev.pnum, temp);
+            }
+
+            usmart_prof_report(usmart_dev.id);
+            break;
+
+        case 1: /* psample T N func(...) */
+            sta = usmart_prof_get_num(&str, &t);
+
+            if (sta)return sta;
+
+            sta = usmart_prof_get_num(&str, &n);
+
+            if (sta)return sta;
+
+            if (t == 0 || n == 0)return USMART_PARMERR;
+
+            sta = usmart_prof_get_func(str);
+
+            if (sta)return sta;
+
+            g_usmart_psample.sta = 0;   /* usmart_prof_poll may run in the timer interrupt, stop it while setting up */
+
+            for (i = 0; i < PARM_LEN; i++)
+            {
+                g_usmart_psample.parm[i] = usmart_dev.parm[i];
+            }
+
+            usmart_load_parm(g_usmart_psample.parm, g_usmart_psample.temp);
+            g_usmart_psample.id = usmart_dev.id;
+            g_usmart_psample.pnum = usmart_dev.pnum;
+            g_usmart_psample.period = t;
+            g_usmart_psample.total = n;
+            g_usmart_psample.last = usmart_get_ms();
+            usmart_prof_reset();
+            g_usmart_psample.sta = 1;
+            USMART_PRINTF("\r\npsample started: %lu runs, every %lums\r\n", (unsigned long)n, (unsigned long)t);
+            break;
+
+        case 2: /* pstop */
+            if (g_usmart_psample.sta == 0)
+            {
+                USMART_PRINTF("\r\npsample is not running\r\n");
+                break;
+            }
+
+            g_usmart_psample.sta = 0;
+            usmart_prof_report(g_usmart_psample.id);
+            break;
+
+        default:
+            return USMART_FUNCERR;  /* Not a profiling command */
+    }
+
+    return USMART_OK;
+}
+
+/**
+* @brief 	Takes the scheduled sample of psample
+* @note		It is called by usmart_scan, so the sampling period can not be shorter than the scan period.
+* @param 	None
+* @retval 	None
+*/
+void usmart_prof_poll(void)
+{
+    uint32_t now;
+
+    if (g_usmart_psample.sta == 0)return;
+
+    now = usmart_get_ms();
+
+    if (now - g_usmart_psample.last < g_usmart_psample.period)return;   /* Not yet */
+
+    g_usmart_psample.last = now;
+    usmart_prof_run(usmart_dev.funs[g_usmart_psample.id].func, g_usmart_psample.pnum, g_usmart_psample.temp);
+
+    if (g_usmart_prof.cnt >= g_usmart_psample.total)    /* All the runs have been taken */
+    {
+        g_usmart_psample.sta = 0;
+        usmart_prof_report(g_usmart_psample.id);
+    }
+}
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ ****************************************************************************************************
+ * @file        usmart_prof.h
+ * @author      ALIENTEK
+ * @brief       USMART profiling commands
+ *
+ * 				prof    N func(...)     : run a registered function N times and display the cycle statistics
+ * 				psample T N func(...)   : run a registered function once every T ms in the background,
+ * 				                          display the statistics after N runs
+ * 				pstop                   : stop psample and display the statistics of the samples taken
+ *
+ *              The execution time is measured with the DWT cycle counter (see usmart_cyc_get in usmart_port.c),
+ *              min/mean/max are counted over all runs, the percentiles and the histogram over the last USMART_PROF_MAX runs.
+ *              SRAM: USMART_PROF_MAX * 4 + PARM_LEN + 80 bytes
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform  	: ALIENTEK STM32F103 development board
+ * website		: https://www.alientek.com
+ * forum		: http://www.openedv.com/forum.php
+ *
+ * change logs	:
+ * version		data		notes
+ * V1.0			20261019	the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __USMART_PROF_H
+#define __USMART_PROF_H
+
+#include "usmart_port.h"
+
+
+/* Profiling statistics */
+struct _m_usmart_prof
+{
+    uint32_t cnt;                       /* Number of runs */
+    uint32_t min;                       /* Minimum execution time, unit :cycle */
+    uint32_t max;                       /* Maximum execution time, unit :cycle */
+    uint64_t sum;                       /* Sum of the execution times, unit :cycle */
+    uint16_t num;                       /* Number of samples kept in buf */
+    uint16_t pos;                       /* Next write position of buf */
+    uint32_t buf[USMART_PROF_MAX];      /* Execution time of the last USMART_PROF_MAX runs */
+};
+
+/* Scheduled sampling (psample command) */
+struct _m_usmart_psample
+{
+    uint8_t  sta;                       /* 0, stopped; 1, running */
+    uint8_t  id;                        /* Function ID */
+    uint8_t  pnum;                      /* Arity */
+    uint32_t period;                    /* Sampling period, unit :ms */
+    uint32_t total;                     /* Number of runs to take */
+    uint32_t last;                      /* Tick of the last run, unit :ms */
+    uint32_t temp[MAX_PARM];            /* Parameter values */
+    uint8_t  parm[PARM_LEN];            /* Copy of usmart_dev.parm, the string parameters point into it */
+};
+
+
+uint8_t usmart_prof_cmd_exe(char *str);     /* Handles the profiling commands */
+void usmart_prof_poll(void);                /* Takes the scheduled sample, called by usmart_scan */
+
+#endif
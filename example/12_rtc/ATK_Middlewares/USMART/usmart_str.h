@@ -48,6 +48,7 @@ uint8_t usmart_get_cmdname(char *str, char *cmdname, uint8_t *nlen, uint8_t maxl
 uint8_t usmart_get_fname(char *str, char *fname, uint8_t *pnum, uint8_t *rval); 		/* Gets the function name from str */
 uint8_t usmart_get_aparm(char *str, char *fparm, uint8_t *ptype); 						/* Takes an argument to a function from str */
 uint8_t usmart_get_fparam(char *str, uint8_t *parn); 									/* Takes function arguments from str. */
+uint32_t usmart_strhash(char *str);                                                     /* Computes the hash value of a string */
 
 #endif
 
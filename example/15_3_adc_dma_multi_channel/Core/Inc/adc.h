@@ -36,11 +36,44 @@ extern ADC_HandleTypeDef hadc1;
 
 /* USER CODE BEGIN Private defines */
 
-#define ADC_ADCX_DMACx_IS_TC()              ( DMA1->ISR & (1 << 1) )    		/* Determine DMA1_Channel1 transfer completion flag,
-																		   	   	   this is a false function form, can not be used as a function,
-																		   	   	   can only be used in if and other statements */
-
-#define ADC_ADCX_DMACx_CLR_TC()             do{ DMA1->IFCR |= 1 << 1; }while(0) /* Clear the DMA1 Channel1 Transfer Completed flag */
+/*
+ * Acquisition: the TIM3 update event starts a scan of the ADC_ACQ_CH_NUM channels every
+ * 1 / ADC_ACQ_RATE s, DMA1 channel 1 writes the results in a circular buffer of two halves.
+ * Each half is decimated by 2^ADC_ACQ_DECIM_BITS in the DMA interrupt and the results are put
+ * in blocks that the main loop takes from a queue.
+ *
+ * Why 20kHz and not the full rate of the ADC: the inputs are pins wired to any source, 55.5 cycles
+ * of sampling (4.6us) accept a source impedance up to about 50kOhm, 1.5 cycles only 0.4kOhm. With
+ * 55.5 cycles a scan of the five channels takes 340 ADC clocks (28.3us at 12MHz), the ADC alone
+ * could scan at 35.3kHz. The timer trigger gives an exact rate instead (625Hz per channel after the
+ * decimation) and leaves 43% of the period free, and the CIC runs on 100000 samples per second in
+ * the DMA interrupt. A faster rate only needs TIM3 and ADC_ACQ_RATE changed, adc.c checks that
+ * the scan fits.
+ */
+#define ADC_ACQ_CH_NUM          5       /* Channels of the scan, ranks 1 ~ 5 of MX_ADC1_Init */
+#define ADC_ACQ_RATE            20000   /* Scans per second, TIM3: 1MHz / 50 */
+#define ADC_ACQ_ADC_CLK         12000000    /* PCLK2 / 6 */
+#define ADC_ACQ_SCAN_CLKS       (ADC_ACQ_CH_NUM * 68)   /* ADC clocks of a scan: 55.5 sampling + 12.5 conversion per channel */
+#define ADC_ACQ_HALF_SCANS      64      /* Scans in a half of the DMA buffer */
+#define ADC_ACQ_DECIM_BITS      5       /* Decimation ratio 2^5 = 32, 625 samples per second and channel */
+#define ADC_ACQ_ORDER_MAX       3       /* Highest CIC order, order 1 is a boxcar average */
+#define ADC_ACQ_BLOCK_LEN       16      /* Decimated samples of each channel in a block */
+#define ADC_ACQ_QUEUE_SIZE      8       /* Blocks, must be a power of 2 */
+
+/* Block of decimated samples */
+typedef struct
+{
+    uint32_t seq;                                       /* Block number, a gap means blocks were lost */
+    uint16_t data[ADC_ACQ_BLOCK_LEN][ADC_ACQ_CH_NUM];   /* Averages of the 12-bit results, multiplied by 16 */
+} adc_block_t;
+
+/* Counters */
+typedef struct
+{
+    uint32_t blocks;                    /* Blocks put in the queue */
+    uint32_t lost;                      /* Blocks dropped because the queue was full */
+    uint32_t overrun;                   /* Halves the DMA started to overwrite before they were decimated */
+} adc_acq_stat_t;
 
 /* USER CODE END Private defines */
 
@@ -49,7 +82,12 @@ void MX_ADC1_Init(void);
 /* USER CODE BEGIN Prototypes */
 
 extern DMA_HandleTypeDef hdma_adc1;
-void adc_dma_enable(uint16_t cndtr);
+extern volatile adc_acq_stat_t g_adc_acq_stat;
+
+uint8_t adc_acq_start(const uint8_t *order);    /* Starts the acquisition, order: CIC order of each channel */
+void adc_acq_stop(void);                        /* Stops the acquisition */
+adc_block_t *adc_acq_get(void);                 /* Oldest block, NULL if the queue is empty */
+void adc_acq_release(void);                     /* Gives back the block returned by adc_acq_get */
 
 /* USER CODE END Prototypes */
 
@@ -22,6 +22,37 @@
 
 /* USER CODE BEGIN 0 */
 
+#include "tim.h"
+#include <string.h>
+
+#define ADC_ACQ_BUF_LEN     (2 * ADC_ACQ_HALF_SCANS * ADC_ACQ_CH_NUM)
+
+#if ADC_ACQ_SCAN_CLKS * ADC_ACQ_RATE > ADC_ACQ_ADC_CLK
+#error "ADC_ACQ_RATE: a scan does not fit in the period of the trigger"
+#endif
+
+/* CIC decimator of a channel */
+typedef struct
+{
+    uint32_t integ[ADC_ACQ_ORDER_MAX];  /* Integrators, they wrap around, only the differences matter */
+    uint32_t comb[ADC_ACQ_ORDER_MAX];   /* Previous inputs of the combs */
+    uint8_t order;
+    uint8_t shift;                      /* Brings the gain 2^(order * ADC_ACQ_DECIM_BITS) down to 16 */
+} adc_cic_t;
+
+static uint16_t g_adc_acq_buf[ADC_ACQ_BUF_LEN];         /* DMA buffer, interleaved channels */
+static adc_cic_t g_adc_cic[ADC_ACQ_CH_NUM];
+static uint16_t g_adc_acq_cnt;                          /* Scans since the last decimated sample */
+static uint16_t g_adc_acq_fill;                         /* Decimated samples in the block being filled */
+static uint32_t g_adc_acq_seq;                          /* Number of the block being filled */
+
+/* Queue of blocks, the DMA interrupt fills the block at head, the main loop reads the one at tail */
+static adc_block_t g_adc_acq_queue[ADC_ACQ_QUEUE_SIZE];
+static volatile uint32_t g_adc_acq_head;                /* Written by the DMA interrupt only */
+static volatile uint32_t g_adc_acq_tail;                /* Written by the main loop only */
+
+volatile adc_acq_stat_t g_adc_acq_stat;
+
 /* USER CODE END 0 */
 
 ADC_HandleTypeDef hadc1;
@@ -45,9 +76,9 @@ void MX_ADC1_Init(void)
   */
   hadc1.Instance = ADC1;
   hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
-  hadc1.Init.ContinuousConvMode = ENABLE;
+  hadc1.Init.ContinuousConvMode = DISABLE;
   hadc1.Init.DiscontinuousConvMode = DISABLE;
-  hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+  hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T3_TRGO;
   hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
   hadc1.Init.NbrOfConversion = 5;
   if (HAL_ADC_Init(&hadc1) != HAL_OK)
@@ -59,7 +90,7 @@ void MX_ADC1_Init(void)
   */
   sConfig.Channel = ADC_CHANNEL_1;
   sConfig.Rank = ADC_REGULAR_RANK_1;
-  sConfig.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
+  sConfig.SamplingTime = ADC_SAMPLETIME_55CYCLES_5;
   if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK)
   {
     Error_Handler();
@@ -139,8 +170,8 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* adcHandle)
     hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
     hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
     hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
-    hdma_adc1.Init.Mode = DMA_NORMAL;
-    hdma_adc1.Init.Priority = DMA_PRIORITY_MEDIUM;
+    hdma_adc1.Init.Mode = DMA_CIRCULAR;
+    hdma_adc1.Init.Priority = DMA_PRIORITY_HIGH;
     if (HAL_DMA_Init(&hdma_adc1) != HAL_OK)
     {
       Error_Handler();
@@ -186,21 +217,170 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* adcHandle)
 /* USER CODE BEGIN 1 */
 
 /**
-* @brief 	Enables one ADC DMA transfer
-* @note 	This function uses registers to prevent other parameters from being modified by HAL library operations, and for compatibility purposes
-* @param 	ndtr: indicates the number of DMA transfers
-* @retval 	None
-*/
-void adc_dma_enable(uint16_t cndtr)
+ * @brief       Decimates a half of the DMA buffer
+ * @note        Called in the DMA interrupt. The integrators run at the scan rate, the combs at the
+ *              decimated rate, all the channels give a sample at the same scan
+ * @param       buf : first scan of the half
+ * @retval      None
+ */
+static void adc_acq_process(const uint16_t *buf)
+{
+    adc_block_t *blk = &g_adc_acq_queue[g_adc_acq_head & (ADC_ACQ_QUEUE_SIZE - 1)];
+    adc_cic_t *cic;
+    uint32_t x, t;
+    uint16_t i;
+    uint8_t ch, k;
+
+    for (i = 0; i < ADC_ACQ_HALF_SCANS; i++, buf += ADC_ACQ_CH_NUM)
+    {
+        for (ch = 0; ch < ADC_ACQ_CH_NUM; ch++)
+        {
+            cic = &g_adc_cic[ch];
+            x = buf[ch];
+
+            for (k = 0; k < cic->order; k++)
+            {
+                x = cic->integ[k] += x;
+            }
+        }
+
+        if (++g_adc_acq_cnt < (1 << ADC_ACQ_DECIM_BITS))continue;
+
+        g_adc_acq_cnt = 0;
+
+        for (ch = 0; ch < ADC_ACQ_CH_NUM; ch++)
+        {
+            cic = &g_adc_cic[ch];
+            x = cic->integ[cic->order - 1];
+
+            for (k = 0; k < cic->order; k++)
+            {
+                t = x;
+                x -= cic->comb[k];
+                cic->comb[k] = t;
+            }
+
+            blk->data[g_adc_acq_fill][ch] = x >> cic->shift;
+        }
+
+        if (++g_adc_acq_fill < ADC_ACQ_BLOCK_LEN)continue;
+
+        g_adc_acq_fill = 0;
+        blk->seq = g_adc_acq_seq++;
+
+        if (g_adc_acq_head + 1 - g_adc_acq_tail < ADC_ACQ_QUEUE_SIZE)
+        {
+            __DMB();                    /* The block is complete before the main loop can see it */
+            g_adc_acq_head++;
+            g_adc_acq_stat.blocks++;
+            blk = &g_adc_acq_queue[g_adc_acq_head & (ADC_ACQ_QUEUE_SIZE - 1)];
+        }
+        else
+        {
+            g_adc_acq_stat.lost++;      /* The queue is full, the block is filled again */
+        }
+    }
+}
+
+/**
+ * @brief       The DMA filled the first half of the buffer
+ * @param       hadc : ADC handle
+ * @retval      None
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
 {
-    ADC1->CR2 &= ~(1 << 0);                 /* Turn off ADC first */
+    adc_acq_process(&g_adc_acq_buf[0]);
 
-    DMA1_Channel1->CCR &= ~(1 << 0);      	/* Turn off DMA transfer */
-    while (DMA1_Channel1->CCR & (1 << 0)); 	/* Ensure that DMA can be set */
-    DMA1_Channel1->CNDTR = cndtr;       	/* The amount of data transferred by DMA */
-    DMA1_Channel1->CCR |= 1 << 0;         	/* Enable DMA transfer */
+    if (__HAL_DMA_GET_COUNTER(&hdma_adc1) > ADC_ACQ_BUF_LEN / 2)
+    {
+        g_adc_acq_stat.overrun++;       /* The DMA is back in the first half */
+    }
+}
 
-    ADC1->CR2 |= 1 << 0;                    /* Restart ADC */
-    ADC1->CR2 |= 1 << 22;                   /* Enable the rule conversion channel */
+/**
+ * @brief       The DMA filled the second half of the buffer
+ * @param       hadc : ADC handle
+ * @retval      None
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    adc_acq_process(&g_adc_acq_buf[ADC_ACQ_BUF_LEN / 2]);
+
+    if (__HAL_DMA_GET_COUNTER(&hdma_adc1) <= ADC_ACQ_BUF_LEN / 2)
+    {
+        g_adc_acq_stat.overrun++;       /* The DMA is already in the second half */
+    }
 }
+
+/**
+ * @brief       Starts the acquisition
+ * @param       order : CIC order of each channel (1 ~ ADC_ACQ_ORDER_MAX, 1 is a boxcar average),
+ *                      NULL for ADC_ACQ_ORDER_MAX on all the channels
+ * @retval      0, successful; 1, invalid order or HAL error
+ */
+uint8_t adc_acq_start(const uint8_t *order)
+{
+    uint8_t ch;
+
+    adc_acq_stop();
+
+    memset(g_adc_cic, 0, sizeof(g_adc_cic));
+    memset((void *)&g_adc_acq_stat, 0, sizeof(g_adc_acq_stat));
+    g_adc_acq_cnt = 0;
+    g_adc_acq_fill = 0;
+    g_adc_acq_seq = 0;
+    g_adc_acq_head = g_adc_acq_tail = 0;
+
+    for (ch = 0; ch < ADC_ACQ_CH_NUM; ch++)
+    {
+        g_adc_cic[ch].order = order ? order[ch] : ADC_ACQ_ORDER_MAX;
+
+        if (g_adc_cic[ch].order == 0 || g_adc_cic[ch].order > ADC_ACQ_ORDER_MAX)return 1;
+
+        g_adc_cic[ch].shift = g_adc_cic[ch].order * ADC_ACQ_DECIM_BITS - 4;
+    }
+
+    if (HAL_ADC_Start_DMA(&hadc1, (uint32_t *)g_adc_acq_buf, ADC_ACQ_BUF_LEN) != HAL_OK)return 1;
+
+    return (HAL_TIM_Base_Start(&htim3) == HAL_OK) ? 0 : 1;     /* The first scan starts at the first update */
+}
+
+/**
+ * @brief       Stops the acquisition
+ * @param       None
+ * @retval      None
+ */
+void adc_acq_stop(void)
+{
+    HAL_TIM_Base_Stop(&htim3);
+    HAL_ADC_Stop_DMA(&hadc1);
+}
+
+/**
+ * @brief       Oldest block of the queue
+ * @note        The block stays valid until adc_acq_release
+ * @param       None
+ * @retval      Block, NULL if the queue is empty
+ */
+adc_block_t *adc_acq_get(void)
+{
+    if (g_adc_acq_tail == g_adc_acq_head)return NULL;
+
+    __DMB();
+    return &g_adc_acq_queue[g_adc_acq_tail & (ADC_ACQ_QUEUE_SIZE - 1)];
+}
+
+/**
+ * @brief       Gives back the block returned by adc_acq_get
+ * @param       None
+ * @retval      None
+ */
+void adc_acq_release(void)
+{
+    if (g_adc_acq_tail == g_adc_acq_head)return;
+
+    __DMB();                            /* The block is read before the DMA interrupt can fill it again */
+    g_adc_acq_tail++;
+}
+
 /* USER CODE END 1 */
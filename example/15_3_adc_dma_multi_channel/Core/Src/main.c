@@ -15,6 +15,8 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     continuous acquisition: TIM3 triggered scans, circular DMA, CIC/boxcar
+ *                           decimation in the DMA interrupt, blocks taken from a queue
  *
  ****************************************************************************************************
  */
@@ -23,6 +25,7 @@
 #include "main.h"
 #include "adc.h"
 #include "dma.h"
+#include "tim.h"
 #include "usart.h"
 #include "gpio.h"
 #include "fsmc.h"
@@ -59,9 +62,10 @@
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
 
-#define ADC_DMA_BUF_SIZE    50 * 5                          /* ADC DMA buffer size */
-static uint16_t g_adc_dma_buf[ADC_DMA_BUF_SIZE];            /* ADC DMA buffer */
-extern uint8_t g_adc_dma_sta;                               /* DMA transfer complete flag */
+/* CIC order of each channel: CH1 ~ CH3 third order, CH4 and CH5 boxcar average */
+static const uint8_t g_adc_order[ADC_ACQ_CH_NUM] = {3, 3, 3, 1, 1};
+static uint32_t g_adc_sum[ADC_ACQ_CH_NUM];                  /* Sum of the decimated samples since the last display */
+static uint32_t g_adc_num;                                  /* Number of decimated samples in g_adc_sum */
 
 /* USER CODE END PFP */
 
@@ -79,9 +83,9 @@ int main(void)
   /* USER CODE BEGIN 1 */
 
   uint16_t i, j;
-  uint16_t adcx;
-  uint32_t sum;
-  float temp;
+  uint32_t adcx;
+  uint32_t tick;
+  adc_block_t *blk;
 
   /* USER CODE END 1 */
 
@@ -107,11 +111,9 @@ int main(void)
   MX_USART1_UART_Init();
   MX_FSMC_Init();
   MX_ADC1_Init();
+  MX_TIM3_Init();
   /* USER CODE BEGIN 2 */
 
-  HAL_DMA_Start_IT(&hdma_adc1, (uint32_t)&ADC1->DR, (uint32_t)&g_adc_dma_buf, 0);  /* Start DMA and enable interrupt */
-  HAL_ADC_Start_DMA(&hadc1, (uint32_t*)&g_adc_dma_buf, 0);                         /* Turn on the ADC and transmit the result via DMA */
-
   lcd_init();
 
   lcd_show_string(30, 50, 200, 16, 16, "STM32", RED);
@@ -128,7 +130,11 @@ int main(void)
   lcd_show_string(30, 230, 200, 12, 12, "ADC1_CH5_VAL:", BLUE);
   lcd_show_string(30, 242, 200, 12, 12, "ADC1_CH5_VOL:0.000V", BLUE);
 
-  adc_dma_enable(ADC_DMA_BUF_SIZE);   /* Turn on the ADC and transmit the result by DMA */
+  lcd_show_string(30, 260, 200, 12, 12, "BLOCKS:", BLUE);
+  lcd_show_string(30, 272, 200, 12, 12, "LOST:        OVERRUN:", BLUE);
+
+  adc_acq_start(g_adc_order);         /* Sampling runs from now on, without gaps */
+  tick = HAL_GetTick();
 
   /* USER CODE END 2 */
 
@@ -138,39 +144,43 @@ int main(void)
   {
     /* USER CODE END WHILE */
 
-      if (g_adc_dma_sta == 1)
+      while ((blk = adc_acq_get()) != NULL)
       {
-        /* Loop through and display the results from Channel 4 to Channel 5. */
-
-        for(j = 0; j < 5; j++)        /* Traverse five channels */
+        for (i = 0; i < ADC_ACQ_BLOCK_LEN; i++)
         {
-          sum = 0;                    /* Reset to zero */
-
-          /* Each channel collected data 10 times and performed 10 accumulations */
-          for (i = 0; i < ADC_DMA_BUF_SIZE / 5; i++)
+          for (j = 0; j < ADC_ACQ_CH_NUM; j++)
           {
-            sum += g_adc_dma_buf[(5 * i) + j];    /* Accumulate conversion data from the same channel. */
+            g_adc_sum[j] += blk->data[i][j];
           }
+        }
+
+        g_adc_num += ADC_ACQ_BLOCK_LEN;
+        adc_acq_release();
+      }
+
+      if (HAL_GetTick() - tick >= 200 && g_adc_num)
+      {
+        tick = HAL_GetTick();
 
-          adcx = sum / (ADC_DMA_BUF_SIZE / 5);    /* Calculate the average. */
+        for (j = 0; j < ADC_ACQ_CH_NUM; j++)    /* Traverse five channels */
+        {
+          adcx = g_adc_sum[j] / g_adc_num;        /* Average of the decimated samples, 12-bit result * 16 */
+          g_adc_sum[j] = 0;
 
           /* Display the results */
-          lcd_show_xnum(108, 110 + (j * 30), adcx, 4, 12, 0, BLUE);
-          temp = (float)adcx * (3.3 / 4096);      /* Calculated actual voltage values with decimals */
-          adcx = temp;                            /* Assign the integer part to the variable 'adcx' */
-          lcd_show_xnum(108, 122 + (j * 30), adcx, 1, 12, 0, BLUE);
-
-          temp -= adcx;
-          temp *= 1000;
-          lcd_show_xnum(120, 122 + (j * 30), temp, 3, 12, 0X80, BLUE);
+          lcd_show_xnum(108, 110 + (j * 30), adcx >> 4, 4, 12, 0, BLUE);
+          adcx = adcx * 3300 / 65536;             /* Voltage in mV */
+          lcd_show_xnum(108, 122 + (j * 30), adcx / 1000, 1, 12, 0, BLUE);
+          lcd_show_xnum(120, 122 + (j * 30), adcx % 1000, 3, 12, 0X80, BLUE);
         }
 
-        g_adc_dma_sta = 0;                        /* Clear the DMA completion status flag. */
-        adc_dma_enable(ADC_DMA_BUF_SIZE);         /* Start the next ADC DMA acquisition. */
-      }
+        g_adc_num = 0;
 
-      LED0_TOGGLE();                              /* LED0 state is flipped */
-      HAL_Delay(100);
+        lcd_show_xnum(72, 260, g_adc_acq_stat.blocks, 8, 12, 0, BLUE);
+        lcd_show_xnum(60, 272, g_adc_acq_stat.lost, 5, 12, 0, BLUE);
+        lcd_show_xnum(162, 272, g_adc_acq_stat.overrun, 5, 12, 0, BLUE);
+        LED0_TOGGLE();                            /* LED0 state is flipped */
+      }
 
     /* USER CODE BEGIN 3 */
   }
@@ -30,8 +30,6 @@
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN TD */
 
-uint8_t g_adc_dma_sta = 0;
-
 /* USER CODE END TD */
 
 /* Private define ------------------------------------------------------------*/
@@ -211,12 +209,6 @@ void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
 
-	if (ADC_ADCX_DMACx_IS_TC())
-	{
-		g_adc_dma_sta = 1;          /* Mark the DMA transfer complete */
-	    ADC_ADCX_DMACx_CLR_TC();    /* Clear DMA1 data flow 7 transmission complete interrupt */
-	}
-
   /* USER CODE END DMA1_Channel1_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_adc1);
   /* USER CODE BEGIN DMA1_Channel1_IRQn 1 */
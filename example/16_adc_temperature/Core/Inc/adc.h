@@ -34,18 +34,46 @@ extern "C" {
 
 extern ADC_HandleTypeDef hadc1;
 
+extern ADC_HandleTypeDef hadc2;
+
 /* USER CODE BEGIN Private defines */
 
+/*
+ * Dual mode: ADC1 (master) and ADC2 (slave) convert continuously, DMA1 channel 1 moves the 32-bit
+ * data register of ADC1 (ADC2 result in the high half) into a circular buffer of two halves. Each
+ * half is oversampled in the DMA interrupt, the caller only reads the latest averages.
+ */
+#define ADC_DUAL_SIMULT         0       /* Regular simultaneous: ADC1 temperature sensor + ADC2 PA1, 47.6k pairs/s */
+#define ADC_DUAL_INTERL         1       /* Fast interleaved: ADC1 + ADC2 on PA1, 1.71M samples/s */
+
+#define ADC_DUAL_BUF_LEN        512     /* Pairs of the DMA buffer, two halves */
+#define ADC_DUAL_OVS_MAX        16      /* Highest oversampling ratio 2^16, the sums stay below 2^28 */
+
+/* State of the dual mode */
+typedef struct
+{
+    uint32_t res;                       /* Latest averages multiplied by 16: ADC2 << 16 | ADC1 */
+    uint32_t seq;                       /* Averages published */
+    uint32_t pairs;                     /* Conversion pairs processed */
+    uint32_t overrun;                   /* Halves the DMA started to overwrite before they were processed */
+    uint8_t mode;                       /* ADC_DUAL_SIMULT or ADC_DUAL_INTERL */
+} adc_dual_t;
+
 /* USER CODE END Private defines */
 
 void adc_channel_set(ADC_HandleTypeDef *adc_handle, uint32_t ch, uint32_t rank, uint32_t stime);
-uint32_t adc_get_result(uint32_t ch);
-uint32_t adc_get_result_average(uint32_t ch, uint8_t times);
 void MX_ADC1_Init(void);
+void MX_ADC2_Init(void);
 
 /* USER CODE BEGIN Prototypes */
 
-short adc_get_temperature(void);
+extern DMA_HandleTypeDef hdma_adc1;
+extern volatile adc_dual_t g_adc_dual;
+
+uint8_t adc_dual_start(uint8_t mode, uint8_t ovs_bits);     /* Starts the dual mode, oversampling ratio 2^ovs_bits */
+void adc_dual_stop(void);                                   /* Stops both ADCs */
+uint32_t adc_dual_read(uint16_t *adc1, uint16_t *adc2);     /* Latest averages, returns the number published */
+short adc_get_temperature(void);                            /* Latest temperature of ADC_DUAL_SIMULT, does not wait */
 
 /* USER CODE END Prototypes */
 
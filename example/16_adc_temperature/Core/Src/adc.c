@@ -22,9 +22,18 @@
 
 /* USER CODE BEGIN 0 */
 
+static uint32_t g_adc_dual_buf[ADC_DUAL_BUF_LEN];       /* DMA buffer, ADC2 result << 16 | ADC1 result */
+static uint32_t g_adc_dual_sum[2];                      /* Oversampling sums of ADC1 and ADC2 */
+static uint32_t g_adc_dual_cnt;                         /* Pairs in the sums */
+static uint8_t g_adc_dual_bits;                         /* Oversampling ratio 2^bits */
+
+volatile adc_dual_t g_adc_dual;
+
 /* USER CODE END 0 */
 
 ADC_HandleTypeDef hadc1;
+ADC_HandleTypeDef hadc2;
+DMA_HandleTypeDef hdma_adc1;
 
 /* ADC1 init function */
 void MX_ADC1_Init(void)
@@ -34,6 +43,7 @@ void MX_ADC1_Init(void)
 
   /* USER CODE END ADC1_Init 0 */
 
+  ADC_MultiModeTypeDef multimode = {0};
   ADC_ChannelConfTypeDef sConfig = {0};
 
   /* USER CODE BEGIN ADC1_Init 1 */
@@ -44,7 +54,7 @@ void MX_ADC1_Init(void)
   */
   hadc1.Instance = ADC1;
   hadc1.Init.ScanConvMode = ADC_SCAN_DISABLE;
-  hadc1.Init.ContinuousConvMode = DISABLE;
+  hadc1.Init.ContinuousConvMode = ENABLE;
   hadc1.Init.DiscontinuousConvMode = DISABLE;
   hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
   hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
@@ -54,6 +64,14 @@ void MX_ADC1_Init(void)
     Error_Handler();
   }
 
+  /** Configure the ADC multi-mode
+  */
+  multimode.Mode = ADC_DUALMODE_REGSIMULT;
+  if (HAL_ADCEx_MultiModeConfigChannel(&hadc1, &multimode) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
   /** Configure Regular Channel
   */
   sConfig.Channel = ADC_CHANNEL_TEMPSENSOR;
@@ -67,11 +85,54 @@ void MX_ADC1_Init(void)
   HAL_ADCEx_Calibration_Start(&hadc1);              /* Calibrating ADC */
   /* USER CODE END ADC1_Init 2 */
 
+}
+/* ADC2 init function */
+void MX_ADC2_Init(void)
+{
+
+  /* USER CODE BEGIN ADC2_Init 0 */
+
+  /* USER CODE END ADC2_Init 0 */
+
+  ADC_ChannelConfTypeDef sConfig = {0};
+
+  /* USER CODE BEGIN ADC2_Init 1 */
+
+  /* USER CODE END ADC2_Init 1 */
+
+  /** Common config
+  */
+  hadc2.Instance = ADC2;
+  hadc2.Init.ScanConvMode = ADC_SCAN_DISABLE;
+  hadc2.Init.ContinuousConvMode = ENABLE;
+  hadc2.Init.DiscontinuousConvMode = DISABLE;
+  hadc2.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+  hadc2.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+  hadc2.Init.NbrOfConversion = 1;
+  if (HAL_ADC_Init(&hadc2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  /** Configure Regular Channel
+  */
+  sConfig.Channel = ADC_CHANNEL_1;
+  sConfig.Rank = ADC_REGULAR_RANK_1;
+  sConfig.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
+  if (HAL_ADC_ConfigChannel(&hadc2, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN ADC2_Init 2 */
+  HAL_ADCEx_Calibration_Start(&hadc2);              /* Calibrating ADC */
+  /* USER CODE END ADC2_Init 2 */
+
 }
 
 void HAL_ADC_MspInit(ADC_HandleTypeDef* adcHandle)
 {
 
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
   if(adcHandle->Instance==ADC1)
   {
   /* USER CODE BEGIN ADC1_MspInit 0 */
@@ -79,10 +140,48 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* adcHandle)
   /* USER CODE END ADC1_MspInit 0 */
     /* ADC1 clock enable */
     __HAL_RCC_ADC1_CLK_ENABLE();
+
+    /* ADC1 DMA Init */
+    /* ADC1 Init */
+    hdma_adc1.Instance = DMA1_Channel1;
+    hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma_adc1.Init.Mode = DMA_CIRCULAR;
+    hdma_adc1.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_adc1) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(adcHandle,DMA_Handle,hdma_adc1);
+
   /* USER CODE BEGIN ADC1_MspInit 1 */
 
   /* USER CODE END ADC1_MspInit 1 */
   }
+  else if(adcHandle->Instance==ADC2)
+  {
+  /* USER CODE BEGIN ADC2_MspInit 0 */
+
+  /* USER CODE END ADC2_MspInit 0 */
+    /* ADC2 clock enable */
+    __HAL_RCC_ADC2_CLK_ENABLE();
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    /**ADC2 GPIO Configuration
+    PA1     ------> ADC2_IN1
+    */
+    GPIO_InitStruct.Pin = GPIO_PIN_1;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+  /* USER CODE BEGIN ADC2_MspInit 1 */
+
+  /* USER CODE END ADC2_MspInit 1 */
+  }
 }
 
 void HAL_ADC_MspDeInit(ADC_HandleTypeDef* adcHandle)
@@ -95,10 +194,30 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* adcHandle)
   /* USER CODE END ADC1_MspDeInit 0 */
     /* Peripheral clock disable */
     __HAL_RCC_ADC1_CLK_DISABLE();
+
+    /* ADC1 DMA DeInit */
+    HAL_DMA_DeInit(adcHandle->DMA_Handle);
   /* USER CODE BEGIN ADC1_MspDeInit 1 */
 
   /* USER CODE END ADC1_MspDeInit 1 */
   }
+  else if(adcHandle->Instance==ADC2)
+  {
+  /* USER CODE BEGIN ADC2_MspDeInit 0 */
+
+  /* USER CODE END ADC2_MspDeInit 0 */
+    /* Peripheral clock disable */
+    __HAL_RCC_ADC2_CLK_DISABLE();
+
+    /**ADC2 GPIO Configuration
+    PA1     ------> ADC2_IN1
+    */
+    HAL_GPIO_DeInit(GPIOA, GPIO_PIN_1);
+
+  /* USER CODE BEGIN ADC2_MspDeInit 1 */
+
+  /* USER CODE END ADC2_MspDeInit 1 */
+  }
 }
 
 /* USER CODE BEGIN 1 */
@@ -130,55 +249,181 @@ void adc_channel_set(ADC_HandleTypeDef *adc_handle, uint32_t ch, uint32_t rank,
 }
 
 /**
-* @brief 	Gets the result of ADC conversion
-* @param 	ch: The channel value ranges from 0 to 17. The value ranges from ADC_CHANNEL_0 to ADC_CHANNEL_17
-* @retval 	None
-*/
-uint32_t adc_get_result(uint32_t ch)
+ * @brief       Brings an oversampling sum to a 16-bit average
+ * @param       sum : sum of 2^g_adc_dual_bits 12-bit results
+ * @retval      Average multiplied by 16
+ */
+static uint32_t adc_dual_scale(uint32_t sum)
 {
-    adc_channel_set(&hadc1 , ch, ADC_REGULAR_RANK_1, ADC_SAMPLETIME_239CYCLES_5);    /* Set the channel, sequence, and sampling time */
+    return (g_adc_dual_bits >= 4) ? (sum >> (g_adc_dual_bits - 4)) : (sum << (4 - g_adc_dual_bits));
+}
 
-    HAL_ADC_Start(&hadc1);                            /* Start ADC */
-    HAL_ADC_PollForConversion(&hadc1, 10);            /* Polling conversion */
-    return (uint16_t)HAL_ADC_GetValue(&hadc1);        /* Returns the result of the last conversion of the ADC1 rule group */
+/**
+ * @brief       Oversamples a half of the DMA buffer
+ * @note        Called in the DMA interrupt. An average is published each time 2^g_adc_dual_bits
+ *              pairs are summed, a sum can span several halves
+ * @param       buf : first pair of the half
+ * @retval      None
+ */
+static void adc_dual_process(const uint32_t *buf)
+{
+    uint32_t s1 = g_adc_dual_sum[0];
+    uint32_t s2 = g_adc_dual_sum[1];
+    uint32_t ratio = 1UL << g_adc_dual_bits;
+    uint32_t left = ADC_DUAL_BUF_LEN / 2;
+    uint32_t n, w;
+
+    while (left)
+    {
+        n = ratio - g_adc_dual_cnt;
+
+        if (n > left)n = left;
+
+        left -= n;
+        g_adc_dual_cnt += n;
+
+        while (n--)
+        {
+            w = *buf++;
+            s1 += w & 0xFFFF;               /* ADC1 */
+            s2 += w >> 16;                  /* ADC2 */
+        }
+
+        if (g_adc_dual_cnt < ratio)break;
+
+        g_adc_dual.res = (adc_dual_scale(s2) << 16) | adc_dual_scale(s1);   /* One store, read whole by the main loop */
+        __DMB();
+        g_adc_dual.seq++;
+        s1 = s2 = 0;
+        g_adc_dual_cnt = 0;
+    }
+
+    g_adc_dual_sum[0] = s1;
+    g_adc_dual_sum[1] = s2;
+    g_adc_dual.pairs += ADC_DUAL_BUF_LEN / 2;
 }
 
 /**
-* @brief 	Obtains the conversion value of channel ch, takes times, and averages
-* @param 	ch		: Channel number, 0 to 17
-* @param 	times	: Indicates the number of times obtained
-* @retval 	Indicates the average value of The times conversion result of channel ch
-*/
-uint32_t adc_get_result_average(uint32_t ch, uint8_t times)
+ * @brief       The DMA filled the first half of the buffer
+ * @param       hadc : ADC handle
+ * @retval      None
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
 {
-    uint32_t temp_val = 0;
-    uint8_t t;
+    adc_dual_process(&g_adc_dual_buf[0]);
 
-    for (t = 0; t < times; t++)     /* takes times */
+    if (__HAL_DMA_GET_COUNTER(&hdma_adc1) > ADC_DUAL_BUF_LEN / 2)
     {
-        temp_val += adc_get_result(ch);
-        HAL_Delay(5);
+        g_adc_dual.overrun++;               /* The DMA is back in the first half */
     }
+}
+
+/**
+ * @brief       The DMA filled the second half of the buffer
+ * @param       hadc : ADC handle
+ * @retval      None
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    adc_dual_process(&g_adc_dual_buf[ADC_DUAL_BUF_LEN / 2]);
 
-    return temp_val / times;        /* Return average */
+    if (__HAL_DMA_GET_COUNTER(&hdma_adc1) <= ADC_DUAL_BUF_LEN / 2)
+    {
+        g_adc_dual.overrun++;               /* The DMA is already in the second half */
+    }
+}
+
+/**
+ * @brief       Starts ADC1 and ADC2 in dual mode
+ * @param       mode : ADC_DUAL_SIMULT, ADC1 on the temperature sensor and ADC2 on PA1 at the same time
+ *                     ADC_DUAL_INTERL, ADC1 and ADC2 alternately on PA1
+ * @param       ovs_bits : oversampling ratio 2^ovs_bits (0 ~ ADC_DUAL_OVS_MAX)
+ * @retval      0, successful; 1, invalid parameter or HAL error
+ */
+uint8_t adc_dual_start(uint8_t mode, uint8_t ovs_bits)
+{
+    ADC_MultiModeTypeDef multimode = {0};
+    uint32_t ch1, stime;
+
+    if (mode > ADC_DUAL_INTERL || ovs_bits > ADC_DUAL_OVS_MAX)return 1;
+
+    adc_dual_stop();                        /* The dual mode can only be changed with both ADCs off */
+
+    if (mode == ADC_DUAL_SIMULT)
+    {
+        ch1 = ADC_CHANNEL_TEMPSENSOR;       /* The sensor needs 17.1us of sampling, the pair has the same timing */
+        stime = ADC_SAMPLETIME_239CYCLES_5;
+        multimode.Mode = ADC_DUALMODE_REGSIMULT;
+    }
+    else
+    {
+        ch1 = ADC_CHANNEL_1;                /* ADC1 starts 7 ADC clocks after ADC2, sampling must be shorter */
+        stime = ADC_SAMPLETIME_1CYCLE_5;
+        multimode.Mode = ADC_DUALMODE_INTERLFAST;
+    }
+
+    adc_channel_set(&hadc1, ch1, ADC_REGULAR_RANK_1, stime);
+    adc_channel_set(&hadc2, ADC_CHANNEL_1, ADC_REGULAR_RANK_1, stime);
+
+    if (HAL_ADCEx_MultiModeConfigChannel(&hadc1, &multimode) != HAL_OK)return 1;
+
+    g_adc_dual_sum[0] = g_adc_dual_sum[1] = 0;
+    g_adc_dual_cnt = 0;
+    g_adc_dual_bits = ovs_bits;
+    g_adc_dual.res = 0;
+    g_adc_dual.seq = 0;
+    g_adc_dual.pairs = 0;
+    g_adc_dual.overrun = 0;
+    g_adc_dual.mode = mode;
+
+    return (HAL_ADCEx_MultiModeStart_DMA(&hadc1, g_adc_dual_buf, ADC_DUAL_BUF_LEN) == HAL_OK) ? 0 : 1;
+}
+
+/**
+ * @brief       Stops ADC1, ADC2 and the DMA
+ * @param       None
+ * @retval      None
+ */
+void adc_dual_stop(void)
+{
+    HAL_ADCEx_MultiModeStop_DMA(&hadc1);    /* Also fine when not started, the ADCs are disabled anyway */
+}
+
+/**
+ * @brief       Latest averages
+ * @param       adc1 : ADC1 average multiplied by 16, can be NULL
+ * @param       adc2 : ADC2 average multiplied by 16, can be NULL
+ * @retval      Averages published since adc_dual_start, 0: none yet
+ */
+uint32_t adc_dual_read(uint16_t *adc1, uint16_t *adc2)
+{
+    uint32_t seq = g_adc_dual.seq;
+    uint32_t res;
+
+    __DMB();
+    res = g_adc_dual.res;
+
+    if (adc1)*adc1 = res & 0xFFFF;
+
+    if (adc2)*adc2 = res >> 16;
+
+    return seq;
 }
 
 /**
 * @brief 	Obtains the temperature of the internal temperature sensor
+* @note 	Does not wait: returns the latest average of the ADC_DUAL_SIMULT mode
 * @param 	None
 * @retval 	Temperature value (expanded by 100 times, unit: 掳 C)
 */
 short adc_get_temperature(void)
 {
-    uint32_t adcx;
-    short result;
-    double temperature;
-
-    adcx = adc_get_result_average(ADC_CHANNEL_TEMPSENSOR, 20);  /* Read the internal temperature sensor channel and average it 10 times */
-    temperature = (float)adcx * (3.3 / 4096);               	/* Convert to a voltage value */
-    temperature = (1.43 - temperature) / 0.0043 + 25;       	/* Calculating temperature */
-    result = temperature *= 100;    							/* 100 times larger */
-    return result;
+    uint16_t adcx;
+    int32_t vol;
+
+    adc_dual_read(&adcx, NULL);
+    vol = (uint32_t)adcx * 33000 >> 16;                   	/* Voltage in 0.1mV, adcx is 16-bit */
+    return (short)((14300 - vol) * 100 / 43 + 2500);     	/* (1.43 - V) / 0.0043 + 25, 100 times larger */
 }
 
 /* USER CODE END 1 */
@@ -15,6 +15,8 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     ADC1 + ADC2 dual mode with DMA and oversampling, KEY0 switches the mode
+ * V1.2         20261019     the sample rate is measured over a HAL_GetTick interval
  *
  ****************************************************************************************************
  */
@@ -22,6 +24,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "adc.h"
+#include "dma.h"
 #include "usart.h"
 #include "gpio.h"
 #include "fsmc.h"
@@ -41,6 +44,9 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 
+#define OVS_BITS_SIMULT     12      /* 4096 pairs per average, 11.6 averages per second */
+#define OVS_BITS_INTERL     16      /* 65536 pairs per average, 13 averages per second */
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -63,6 +69,25 @@ void SystemClock_Config(void);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+/**
+ * @brief       Starts a dual mode and shows its name
+ * @param       mode : ADC_DUAL_SIMULT or ADC_DUAL_INTERL
+ * @retval      None
+ */
+static void dual_mode_set(uint8_t mode)
+{
+    if (mode == ADC_DUAL_SIMULT)
+    {
+        adc_dual_start(ADC_DUAL_SIMULT, OVS_BITS_SIMULT);
+        lcd_show_string(30, 140, 200, 16, 16, "MODE: SIMULTANEOUS", BLUE);
+    }
+    else
+    {
+        adc_dual_start(ADC_DUAL_INTERL, OVS_BITS_INTERL);
+        lcd_show_string(30, 140, 200, 16, 16, "MODE: INTERLEAVED ", BLUE);
+    }
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -73,7 +98,11 @@ int main(void)
 {
   /* USER CODE BEGIN 1 */
 
-	short temp;
+  short temp;
+  uint16_t adc1, adc2, vol;
+  uint32_t pairs, last_pairs = 0;
+  uint8_t mode = ADC_DUAL_SIMULT;
+  uint32_t tick, last_tick = 0, ms, rate;
 
   /* USER CODE END 1 */
 
@@ -95,9 +124,11 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_FSMC_Init();
   MX_ADC1_Init();
+  MX_ADC2_Init();
   /* USER CODE BEGIN 2 */
 
   lcd_init();
@@ -105,6 +136,12 @@ int main(void)
   lcd_show_string(30,  70, 200, 16, 16, "Temperature TEST", RED);
   lcd_show_string(30,  90, 200, 16, 16, "ATOM@ALIENTEK", RED);
   lcd_show_string(30, 120, 200, 16, 16, "TEMPERATE: 00.00C", BLUE);
+  lcd_show_string(30, 160, 200, 16, 16, "PA1: 0000mV", BLUE);
+  lcd_show_string(30, 180, 200, 16, 16, "RATE:       0S/s", BLUE);
+  lcd_show_string(30, 200, 200, 16, 16, "KEY0: switch mode", RED);
+
+  dual_mode_set(mode);
+  last_tick = HAL_GetTick();
 
   /* USER CODE END 2 */
 
@@ -113,21 +150,58 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  temp = adc_get_temperature();
+	  if (key_scan(0) == KEY0_PRES)
+	  {
+		  mode = (mode == ADC_DUAL_SIMULT) ? ADC_DUAL_INTERL : ADC_DUAL_SIMULT;
+		  dual_mode_set(mode);
+		  last_pairs = g_adc_dual.pairs;
+		  last_tick = HAL_GetTick();
+	  }
 
-	  if (temp < 0)
+	  if (adc_dual_read(&adc1, &adc2))
 	  {
-		  temp = -temp;
-		  lcd_show_string(30 + 10 * 8, 120, 16, 16, 16, "-", BLUE);   /* Display negative sign */
+		  if (mode == ADC_DUAL_SIMULT)
+		  {
+			  temp = adc_get_temperature();                               /* Latest average, no waiting */
+
+			  if (temp < 0)
+			  {
+				  temp = -temp;
+				  lcd_show_string(30 + 10 * 8, 120, 16, 16, 16, "-", BLUE);   /* Display negative sign */
+			  }
+			  else
+			  {
+				  lcd_show_string(30 + 10 * 8, 120, 16, 16, 16, " ", BLUE);   /* Unsigned */
+			  }
+			  lcd_show_xnum(30 + 11 * 8, 120, temp / 100, 2, 16, 0, BLUE);    /* Display integer part */
+			  lcd_show_xnum(30 + 14 * 8, 120, temp % 100, 2, 16, 0X80, BLUE); /* Display decimal part */
+		  }
+		  else
+		  {
+			  adc2 = (adc1 + adc2) / 2;                                   /* Both ADCs sample PA1 */
+		  }
+
+		  vol = (uint32_t)adc2 * 3300 >> 16;                              /* 16-bit average to mV */
+		  lcd_show_xnum(30 + 5 * 8, 160, vol, 4, 16, 0X80, BLUE);
 	  }
-	  else
+
+	  tick = HAL_GetTick();
+	  ms = tick - last_tick;
+
+	  if (ms >= 1000)                                                     /* Every second, measured by the SysTick */
 	  {
-		  lcd_show_string(30 + 10 * 8, 120, 16, 16, 16, " ", BLUE);   /* Unsigned */
+		  pairs = g_adc_dual.pairs;
+		  rate = (uint64_t)(pairs - last_pairs) * 1000 / ms;              /* Pairs per second of the measured interval */
+
+		  /* Samples of PA1 per second, twice the pairs when interleaved */
+		  lcd_show_num(30 + 6 * 8, 180, (mode == ADC_DUAL_SIMULT) ? rate : 2 * rate, 7, 16, BLUE);
+
+		  last_pairs = pairs;
+		  last_tick = tick;
+		  LED0_TOGGLE();												  /* LED state is flipped */
 	  }
-	  lcd_show_xnum(30 + 11 * 8, 120, temp / 100, 2, 16, 0, BLUE);    /* Display integer part */
-	  lcd_show_xnum(30 + 14 * 8, 120, temp % 100, 2, 16, 0X80, BLUE); /* Display integer part */
 
-	  LED0_TOGGLE();												  /* LED state is flipped */
+	  HAL_Delay(10);
     /* USER CODE BEGIN 3 */
   }
   /* USER CODE END 3 */
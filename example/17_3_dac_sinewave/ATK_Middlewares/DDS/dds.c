@@ -0,0 +1,205 @@
+/**
+ ****************************************************************************************************
+ * @file        dds.c
+ * @author      ALIENTEK
+ * @brief       Direct digital synthesis of two phase-locked waveforms
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     accuracy of the sine table corrected in its comment (tools/dds_check.c)
+ *
+ ****************************************************************************************************
+ */
+
+#include "dds.h"
+
+
+/*
+ * One turn of sine in Q15, the last point repeats the first one for the interpolation.
+ * 256 points with linear interpolation stay within 4 Q15 steps (1.2e-4 of full scale), a quarter of a
+ * 12-bit DAC step
+ */
+static const int16_t g_dds_sine[(1 << DDS_SINE_BITS) + 1] =
+{
+         0,    804,   1608,   2410,   3212,   4011,   4808,   5602,   6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+     12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,  18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+     23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,  27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+     30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,  32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+     32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,  32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+     30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,  27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+     23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,  18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+     12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,   6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+         0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,  -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790, -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683, -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,  -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804,
+         0
+};
+
+/**
+ * @brief       Initializes a generator, both channels off at mid-scale
+ * @param       dds : generator
+ * @retval      None
+ */
+void dds_init(dds_t *dds)
+{
+    uint8_t i, ch;
+
+    for (i = 0; i < 2; i++)
+    {
+        for (ch = 0; ch < DDS_CH_NUM; ch++)
+        {
+            dds->cfg[i].ch[ch].step = 0;
+            dds->cfg[i].ch[ch].phase = 0;
+            dds->cfg[i].ch[ch].amp = 0;
+            dds->cfg[i].ch[ch].offset = 2048;
+            dds->cfg[i].ch[ch].wave = DDS_WAVE_SINE;
+        }
+
+        dds->cfg[i].sync = 0;
+    }
+
+    dds->cur = dds->cfg[0];
+
+    for (ch = 0; ch < DDS_CH_NUM; ch++)
+    {
+        dds->acc[ch] = 0;
+    }
+
+    dds->wr = 0;
+    dds->rd = 0;
+}
+
+/**
+ * @brief       Phase increment of a frequency
+ * @note        The resolution is fs / 2^32, 23uHz at 100k samples/s
+ * @param       freq_mhz : frequency in mHz, below fs / 2
+ * @param       fs : samples per second
+ * @retval      Phase increment per sample
+ */
+uint32_t dds_step(uint32_t freq_mhz, uint32_t fs)
+{
+    uint64_t div = (uint64_t)fs * 1000;
+
+    return (uint32_t)((((uint64_t)freq_mhz << 32) + div / 2) / div);
+}
+
+/**
+ * @brief       Setting to change
+ * @note        Returns a copy of the latest setting with sync cleared. The generator keeps the
+ *              previous one until dds_commit, so the fields can be written in any order
+ * @param       dds : generator
+ * @retval      Setting to fill, valid until dds_commit
+ */
+dds_cfg_t *dds_edit(dds_t *dds)
+{
+    uint32_t wr = dds->wr;
+    dds_cfg_t *cfg = &dds->cfg[(wr + 1) & 1];
+
+    *cfg = dds->cfg[wr & 1];
+    cfg->sync = 0;
+    return cfg;
+}
+
+/**
+ * @brief       Publishes the setting returned by dds_edit
+ * @note        dds_fill takes it at the start of its next block. The accumulators keep running,
+ *              so the waveform changes without a phase jump
+ * @param       dds : generator
+ * @retval      None
+ */
+void dds_commit(dds_t *dds)
+{
+    DDS_DMB();                          /* The setting is complete before dds_fill can see it */
+    dds->wr++;
+}
+
+/**
+ * @brief       Sample of a waveform
+ * @param       wave : DDS_WAVE_xxx
+ * @param       phase : 2^32 is one turn, all the waveforms rise through 0 at phase 0
+ * @retval      Sample, Q15
+ */
+int16_t dds_wave(uint8_t wave, uint32_t phase)
+{
+    uint32_t i, x;
+    int32_t a;
+
+    switch (wave)
+    {
+        case DDS_WAVE_TRIANGLE:
+            x = (phase + 0x40000000) >> 16;                         /* 0 at the minimum, a quarter turn before phase 0 */
+            return (x < 0x8000) ? (int16_t)(2 * x - 0x8000) : (int16_t)(0x17FFF - 2 * x);
+
+        case DDS_WAVE_SAW:
+            return (int16_t)(phase >> 16);
+
+        default:
+            i = phase >> (32 - DDS_SINE_BITS);
+            x = (phase >> (16 - DDS_SINE_BITS)) & 0xFFFF;           /* Next 16 bits of the phase */
+            a = g_dds_sine[i];
+            return (int16_t)(a + (((g_dds_sine[i + 1] - a) * (int32_t)x) >> 16));
+    }
+}
+
+/**
+ * @brief       Generates a block of samples
+ * @note        Called in the DMA interrupt for the half of the buffer that was just sent
+ * @param       dds : generator
+ * @param       buf : output words, channel 2 code << 16 | channel 1 code (DAC DHR12RD)
+ * @param       num : words
+ * @retval      None
+ */
+void dds_fill(dds_t *dds, uint32_t *buf, uint16_t num)
+{
+    uint32_t wr = dds->wr;
+    uint32_t out;
+    int32_t v;
+    uint16_t i;
+    uint8_t ch;
+    dds_ch_t *c;
+
+    if (wr != dds->rd)
+    {
+        DDS_DMB();
+        dds->cur = dds->cfg[wr & 1];
+        dds->rd = wr;
+
+        if (dds->cur.sync)
+        {
+            dds->acc[1] = dds->acc[0] + dds->cur.ch[1].phase;
+        }
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        out = 0;
+
+        for (ch = 0; ch < DDS_CH_NUM; ch++)
+        {
+            c = &dds->cur.ch[ch];
+            v = c->offset + ((dds_wave(c->wave, dds->acc[ch]) * (int32_t)c->amp + 0x4000) >> 15);  /* Rounded */
+            dds->acc[ch] += c->step;
+
+            if (v < 0)v = 0;
+
+            if (v > 4095)v = 4095;
+
+            out |= (uint32_t)v << (16 * ch);
+        }
+
+        buf[i] = out;
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ ****************************************************************************************************
+ * @file        dds.h
+ * @author      ALIENTEK
+ * @brief       Direct digital synthesis of two phase-locked waveforms
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __DDS_H
+#define __DDS_H
+
+#include "main.h"
+
+
+/* Barrier between writing a setting and publishing it. A host build defines it */
+#ifndef DDS_DMB
+#define DDS_DMB()               __DMB()
+#endif
+
+#define DDS_CH_NUM              2       /* Channel 1 in the low half of an output word, channel 2 in the high half */
+#define DDS_SINE_BITS           8       /* Sine table of 2^8 points per turn, linear interpolation in between */
+
+/* Waveforms */
+#define DDS_WAVE_SINE           0
+#define DDS_WAVE_TRIANGLE       1
+#define DDS_WAVE_SAW            2
+#define DDS_WAVE_NUM            3
+
+/* Setting of a channel */
+typedef struct
+{
+    uint32_t step;                      /* Phase increment per sample, 2^32 is one turn: dds_step() */
+    uint32_t phase;                     /* Channel 2: phase after channel 1 when resynced, 2^32 is one turn */
+    uint16_t amp;                       /* Peak amplitude in DAC codes, 0 ~ 2047 */
+    uint16_t offset;                    /* Middle of the waveform in DAC codes */
+    uint8_t wave;                       /* DDS_WAVE_xxx */
+} dds_ch_t;
+
+/* Setting of both channels, taken as a whole at the start of a block */
+typedef struct
+{
+    dds_ch_t ch[DDS_CH_NUM];
+    uint8_t sync;                       /* 1: channel 2 restarts at channel 1 phase + ch[1].phase */
+} dds_cfg_t;
+
+/* Generator */
+typedef struct
+{
+    dds_cfg_t cfg[2];                   /* Published setting and the one being edited */
+    dds_cfg_t cur;                      /* Setting of the block being generated */
+    uint32_t acc[DDS_CH_NUM];           /* Phase accumulators */
+    volatile uint32_t wr;               /* Settings published, cfg[wr & 1] is the latest */
+    uint32_t rd;                        /* Settings taken */
+} dds_t;
+
+void dds_init(dds_t *dds);                                  /* Both channels off at mid-scale */
+uint32_t dds_step(uint32_t freq_mhz, uint32_t fs);          /* Phase increment of freq_mhz (mHz) at fs samples/s */
+dds_cfg_t *dds_edit(dds_t *dds);                            /* Copy of the latest setting to change */
+void dds_commit(dds_t *dds);                                /* Publishes the edited setting */
+int16_t dds_wave(uint8_t wave, uint32_t phase);             /* Sample of a waveform, Q15 */
+void dds_fill(dds_t *dds, uint32_t *buf, uint16_t num);     /* Generates num output words */
+
+#endif
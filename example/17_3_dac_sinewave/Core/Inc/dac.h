@@ -29,6 +29,7 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
+#include "../../ATK_Middlewares/DDS/dds.h"
 
 /* USER CODE END Includes */
 
@@ -36,14 +37,19 @@ extern DAC_HandleTypeDef hdac;
 
 /* USER CODE BEGIN Private defines */
 
+#define DAC_DDS_FS              100000  /* Samples per second of both channels, TIM7: 1MHz / 10 */
+#define DAC_DDS_BUF_LEN         512     /* Words of the DMA buffer, each half is generated while the other is sent */
+
 /* USER CODE END Private defines */
 
 void MX_DAC_Init(void);
 
 /* USER CODE BEGIN Prototypes */
 
-void dac_creat_sin_buf(uint16_t maxval, uint16_t samples);
-void dac_dma_wave_enable(uint16_t cndtr, uint16_t arr, uint16_t psc);
+extern dds_t g_dds;
+
+uint8_t dac_dds_start(void);        /* Starts the DDS output on PA4 and PA5 */
+void dac_dds_stop(void);            /* Stops the DDS output */
 
 /* USER CODE END Prototypes */
 
@@ -22,10 +22,11 @@
 
 /* USER CODE BEGIN 0 */
 
-#include "math.h"
 #include "tim.h"
 
-uint16_t g_dac_sin_buf[4096];           /* Send data buffer */
+static uint32_t g_dac_dds_buf[DAC_DDS_BUF_LEN];     /* DMA buffer, channel 2 code << 16 | channel 1 code */
+
+dds_t g_dds;                                        /* Generator of both channels */
 /* USER CODE END 0 */
 
 DAC_HandleTypeDef hdac;
@@ -61,6 +62,13 @@ void MX_DAC_Init(void)
   {
     Error_Handler();
   }
+
+  /** DAC channel OUT2 config
+  */
+  if (HAL_DAC_ConfigChannel(&hdac, &sConfig, DAC_CHANNEL_2) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE BEGIN DAC_Init 2 */
 
   /* USER CODE END DAC_Init 2 */
@@ -82,8 +90,9 @@ void HAL_DAC_MspInit(DAC_HandleTypeDef* dacHandle)
     __HAL_RCC_GPIOA_CLK_ENABLE();
     /**DAC GPIO Configuration
     PA4     ------> DAC_OUT1
+    PA5     ------> DAC_OUT2
     */
-    GPIO_InitStruct.Pin = GPIO_PIN_4;
+    GPIO_InitStruct.Pin = GPIO_PIN_4|GPIO_PIN_5;
     GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
@@ -93,10 +102,10 @@ void HAL_DAC_MspInit(DAC_HandleTypeDef* dacHandle)
     hdma_dac_ch1.Init.Direction = DMA_MEMORY_TO_PERIPH;
     hdma_dac_ch1.Init.PeriphInc = DMA_PINC_DISABLE;
     hdma_dac_ch1.Init.MemInc = DMA_MINC_ENABLE;
-    hdma_dac_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
-    hdma_dac_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_dac_ch1.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma_dac_ch1.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
     hdma_dac_ch1.Init.Mode = DMA_CIRCULAR;
-    hdma_dac_ch1.Init.Priority = DMA_PRIORITY_MEDIUM;
+    hdma_dac_ch1.Init.Priority = DMA_PRIORITY_HIGH;
     if (HAL_DMA_Init(&hdma_dac_ch1) != HAL_OK)
     {
       Error_Handler();
@@ -123,8 +132,9 @@ void HAL_DAC_MspDeInit(DAC_HandleTypeDef* dacHandle)
 
     /**DAC GPIO Configuration
     PA4     ------> DAC_OUT1
+    PA5     ------> DAC_OUT2
     */
-    HAL_GPIO_DeInit(GPIOA, GPIO_PIN_4);
+    HAL_GPIO_DeInit(GPIOA, GPIO_PIN_4|GPIO_PIN_5);
 
     /* DAC DMA DeInit */
     HAL_DMA_DeInit(dacHandle->DMA_Handle1);
@@ -136,53 +146,69 @@ void HAL_DAC_MspDeInit(DAC_HandleTypeDef* dacHandle)
 
 /* USER CODE BEGIN 1 */
 
-/***************************************DAC Output Triangle Wave Experiment Code*****************************************/
+/***************************************DAC DDS Sine Wave Experiment Code*****************************************/
+
+/**
+ * @brief       The DMA sent the first half of the buffer
+ * @param       hdma : DMA handle
+ * @retval      None
+ */
+static void dac_dds_half(DMA_HandleTypeDef *hdma)
+{
+    dds_fill(&g_dds, &g_dac_dds_buf[0], DAC_DDS_BUF_LEN / 2);
+}
+
+/**
+ * @brief       The DMA sent the second half of the buffer
+ * @param       hdma : DMA handle
+ * @retval      None
+ */
+static void dac_dds_cplt(DMA_HandleTypeDef *hdma)
+{
+    dds_fill(&g_dds, &g_dac_dds_buf[DAC_DDS_BUF_LEN / 2], DAC_DDS_BUF_LEN / 2);
+}
 
 /**
- * @brief   Generate sine wave data
- * @param   maxval: Amplitude of the sine wave
- * @param   samples: Number of sampling points per sine wave cycle
- * @retval  None
+ * @brief       Starts the DDS output on both channels
+ * @note        The TIM7 update triggers both channels together, so they change at the same instant.
+ *              The DMA request of channel 1 writes one word per update to the dual register
+ *              DHR12RD: channel 1 in the low half, channel 2 in the high half.
+ *              The input clock frequency (f) of TIM7 comes from APB1, f = 36M * 2 = 72Mhz,
+ *              DAC_DDS_FS = f / ((psc + 1) * (arr + 1))
+ * @param       None
+ * @retval      0, successful; 1, HAL error
  */
-void dac_creat_sin_buf(uint16_t maxval, uint16_t samples)
+uint8_t dac_dds_start(void)
 {
-    uint16_t i;
-    double w;
-    uint16_t outdata;
+    dac_dds_stop();
 
-    w = (2 * 3.1415926) / samples;                  /* ω=2π/T */
+    dds_fill(&g_dds, &g_dac_dds_buf[0], DAC_DDS_BUF_LEN);         /* Whole buffer ready before the first trigger */
 
-    for (i = 0; i < samples; i++)
-    {
-        outdata = maxval * sin(w * i + 0) + maxval; /* y=Asin(ωx+φ)+b */
-        if (outdata > 4095)                         /* Limit upper bound */
-        {
-            outdata = 4095;
-        }
-        g_dac_sin_buf[i] = outdata;
-    }
+    hdma_dac_ch1.XferHalfCpltCallback = dac_dds_half;
+    hdma_dac_ch1.XferCpltCallback = dac_dds_cplt;
+    hdma_dac_ch1.XferErrorCallback = NULL;
+
+    if (HAL_DMA_Start_IT(&hdma_dac_ch1, (uint32_t)g_dac_dds_buf, (uint32_t)&DAC->DHR12RD, DAC_DDS_BUF_LEN) != HAL_OK)return 1;
+
+    SET_BIT(DAC->CR, DAC_CR_DMAEN1);
+    __HAL_DAC_ENABLE(&hdac, DAC_CHANNEL_1);
+    __HAL_DAC_ENABLE(&hdac, DAC_CHANNEL_2);
+
+    return (HAL_TIM_Base_Start(&htim7) == HAL_OK) ? 0 : 1;
 }
 
 /**
- * @brief       Enable DAC DMA for waveform output
- * @note        The input clock frequency (f) of TIM7 comes from APB1, f = 36M * 2 = 72Mhz.
- *              DAC trigger frequency ftrgo = f / ((psc + 1) * (arr + 1))
- *              Waveform frequency = ftrgo / ndtr;
- *
- * @param       cndtr   : DMA channel single transfer data volume
- * @param       arr     : TIM7 auto-reload value
- * @param       psc     : TIM7 prescaler value
+ * @brief       Stops the DDS output
+ * @param       None
  * @retval      None
  */
-void dac_dma_wave_enable(uint16_t cndtr, uint16_t arr, uint16_t psc)
+void dac_dds_stop(void)
 {
-    __HAL_TIM_SET_PRESCALER(&htim7, psc);
-    __HAL_TIM_SET_AUTORELOAD(&htim7, arr);
-    HAL_TIM_Base_Init(&htim7);
-    HAL_TIM_Base_Start(&htim7);                                    /* Start Timer 7 */
-
-    HAL_DAC_Stop_DMA(&hdac, DAC_CHANNEL_1);                        /* Stop previous transfer first */
-    HAL_DAC_Start_DMA(&hdac, DAC_CHANNEL_1, (uint32_t *)g_dac_sin_buf, cndtr, DAC_ALIGN_12B_R);
+    HAL_TIM_Base_Stop(&htim7);
+    CLEAR_BIT(DAC->CR, DAC_CR_DMAEN1);
+    HAL_DMA_Abort(&hdma_dac_ch1);                                   /* Error when not started, nothing to do then */
+    __HAL_DAC_DISABLE(&hdac, DAC_CHANNEL_1);
+    __HAL_DAC_DISABLE(&hdac, DAC_CHANNEL_2);
 }
 
 /* USER CODE END 1 */
@@ -15,6 +15,7 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     DDS output: phase accumulator, two phase-locked channels
  *
  ****************************************************************************************************
  */
@@ -43,6 +44,8 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 
+#define DDS_AMP             2000        /* Peak amplitude in DAC codes */
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -54,6 +57,9 @@
 
 /* USER CODE BEGIN PV */
 
+static const uint32_t g_freq_tbl[] = {10000, 100000, 1000000, 1234567, 10000000};  /* Frequencies in mHz */
+static const char *const g_wave_name[DDS_WAVE_NUM] = {"SINE    ", "TRIANGLE", "SAW     "};
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -65,6 +71,29 @@ void SystemClock_Config(void);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+/**
+ * @brief       Sets both channels: same frequency, channel 2 a quarter turn after channel 1
+ * @param       freq_mhz : frequency in mHz
+ * @param       wave : waveform of channel 1, DDS_WAVE_xxx
+ * @retval      None
+ */
+static void dds_show_set(uint32_t freq_mhz, uint8_t wave)
+{
+    dds_cfg_t *cfg = dds_edit(&g_dds);
+
+    cfg->ch[0].step = cfg->ch[1].step = dds_step(freq_mhz, DAC_DDS_FS);
+    cfg->ch[0].amp = cfg->ch[1].amp = DDS_AMP;
+    cfg->ch[0].wave = wave;
+    cfg->ch[1].wave = DDS_WAVE_SINE;
+    cfg->ch[1].phase = 0x40000000;                                  /* 90 degrees */
+    cfg->sync = 1;
+    dds_commit(&g_dds);                                             /* Taken at the next half buffer, no phase jump on channel 1 */
+
+    lcd_show_string(30 + 5 * 8, 130, 200, 16, 16, (char *)g_wave_name[wave], BLUE);
+    lcd_show_num(30 + 14 * 8, 130, freq_mhz / 1000, 5, 16, BLUE);
+    lcd_show_xnum(30 + 20 * 8, 130, freq_mhz % 1000, 3, 16, 0x80, BLUE);
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -76,6 +105,8 @@ int main(void)
   /* USER CODE BEGIN 1 */
     uint8_t t = 0;
     uint8_t key;
+    uint8_t freq = 2;
+    uint8_t wave = DDS_WAVE_SINE;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -109,7 +140,13 @@ int main(void)
   lcd_show_string(30, 70, 200, 16, 16, "DAC DMA Sine Wave TEST", RED);
   lcd_show_string(30, 90, 200, 16, 16, "ATOM@ALIENTEK", RED);
 
-  lcd_show_string(30, 110, 200, 16, 16, "WK_UP:Wave1 KEY0:Wave2", RED);
+  lcd_show_string(30, 110, 200, 16, 16, "WK_UP:Wave KEY0:Freq", RED);
+  lcd_show_string(30, 130, 200, 16, 16, "CH1:               .   Hz", BLUE);
+  lcd_show_string(30, 150, 200, 16, 16, "CH2: SINE     +90deg", BLUE);
+
+  dds_init(&g_dds);
+  dds_show_set(g_freq_tbl[freq], wave);
+  dac_dds_start();                                /* PA4: channel 1, PA5: channel 2 */
 
   /* USER CODE END 2 */
 
@@ -122,13 +159,13 @@ int main(void)
 
 	  if (key == WKUP_PRES)
 	  {
-	      dac_creat_sin_buf(2048 - 1, 100);           /* Generate sine wave data */
-	      dac_dma_wave_enable(100, 10 - 1, 72 - 1);   /* Enable DAC DMA waveform output */
+	      wave = (wave + 1) % DDS_WAVE_NUM;           /* Next waveform of channel 1 */
+	      dds_show_set(g_freq_tbl[freq], wave);
 	  }
 	  else if (key == KEY0_PRES)
 	  {
-	      dac_creat_sin_buf(2048 - 1, 10);            /* Generate sine wave data */
-	      dac_dma_wave_enable(10, 10 - 1, 72 - 1);    /* Enable DAC DMA waveform output */
+	      freq = (freq + 1) % (sizeof(g_freq_tbl) / sizeof(g_freq_tbl[0]));  /* Next frequency */
+	      dds_show_set(g_freq_tbl[freq], wave);
 	  }
 
 	  if (++t == 20)
@@ -0,0 +1,410 @@
+/**
+ ****************************************************************************************************
+ * @file        dds_check.c
+ * @author      ALIENTEK
+ * @brief       Checks ATK_Middlewares/DDS/dds.c on a Linux host
+ *
+ *              dds_fill runs with the settings of main.c (DAC_DDS_FS = 100k samples/s) and its
+ *              12-bit output words are measured:
+ *              - dds_wave against double precision references: the interpolated sine table, and the
+ *                triangle and saw which must be exact
+ *              - dds_step against f * 2^32 / fs
+ *              - full scale sines centred on a bin of a 4096 point DFT: SFDR, THD (harmonics 2 to 10,
+ *                folded) and SINAD of channel 1, against the 74dB of an ideal 12-bit quantizer
+ *              - a 1234.567Hz sine and a quarter turn shifted channel 2 against a double reference
+ *              - frequency and amplitude changes in the middle of a stream: no phase jump, and the
+ *                setting taken at the start of the next block only
+ *
+ *              Build, from example/17_3_dac_sinewave:
+ *              gcc -O2 -Wall -Itools/host tools/dds_check.c ATK_Middlewares/DDS/dds.c -lm -o dds_check
+ *              Run:
+ *              ./dds_check [-v]                        (-v: spectrum figures of every tone)
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../ATK_Middlewares/DDS/dds.h"
+
+#define CHECK_FS            100000      /* DAC_DDS_FS of dac.h */
+#define CHECK_BLOCK         256         /* DAC_DDS_BUF_LEN / 2, words per dds_fill */
+#define CHECK_N             4096        /* DFT points */
+#define CHECK_AMP           2047        /* Full scale */
+
+#define CHECK_SFDR_MIN      85.0        /* dB */
+#define CHECK_THD_MAX       -80.0       /* dB */
+#define CHECK_SINAD_MIN     72.0        /* dB, 74 for an ideal 12-bit quantizer */
+
+static const double g_pi = 3.14159265358979323846;
+
+static uint32_t g_buf[CHECK_N];
+static double g_x[CHECK_N];
+static double g_cos[CHECK_N];
+static double g_sin[CHECK_N];
+static double g_pow[CHECK_N / 2 + 1];
+static int g_verbose = 0;
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+/**
+ * @brief       Generates num words through dds_fill in blocks of CHECK_BLOCK
+ */
+static void check_fill(dds_t *dds, uint32_t *buf, uint32_t num)
+{
+    uint32_t i, n;
+
+    for (i = 0; i < num; i += n)
+    {
+        n = (num - i < CHECK_BLOCK) ? num - i : CHECK_BLOCK;
+        dds_fill(dds, &buf[i], n);
+    }
+}
+
+/**
+ * @brief       Sets both channels
+ */
+static void check_set(dds_t *dds, uint32_t step, uint16_t amp, uint8_t wave, uint32_t phase2, uint8_t sync)
+{
+    dds_cfg_t *cfg = dds_edit(dds);
+    uint8_t ch;
+
+    for (ch = 0; ch < DDS_CH_NUM; ch++)
+    {
+        cfg->ch[ch].step = step;
+        cfg->ch[ch].amp = amp;
+        cfg->ch[ch].offset = 2048;
+        cfg->ch[ch].wave = (ch == 0) ? wave : DDS_WAVE_SINE;
+    }
+
+    cfg->ch[1].phase = phase2;
+    cfg->sync = sync;
+    dds_commit(dds);
+}
+
+/**
+ * @brief       Exact waveform in Q15 units. The triangle and saw take the 16 bits of the phase
+ *              that dds_wave uses, the sine the whole phase
+ */
+static double check_ref(uint8_t wave, uint32_t phase)
+{
+    double turn;
+
+    switch (wave)
+    {
+        case DDS_WAVE_TRIANGLE:
+            turn = ((phase + 0x40000000) >> 16) / 65536.0;      /* 0 at the minimum */
+            return (turn < 0.5) ? (4 * turn - 1) * 32768 : (3 - 4 * turn) * 32768;
+
+        case DDS_WAVE_SAW:
+            turn = (phase >> 16) / 65536.0;
+            return ((turn < 0.5) ? turn : turn - 1) * 65536;
+
+        default:
+            return sin(2 * g_pi * (phase / 4294967296.0)) * 32767;
+    }
+}
+
+/**
+ * @brief       dds_wave against check_ref over one turn
+ */
+static void check_wave(void)
+{
+    static const char *name[DDS_WAVE_NUM] = {"sine", "triangle", "saw"};
+
+    /* Q15 LSB. Sine: table rounding, interpolation and truncation. Triangle: the top is 32767, not 32768 */
+    static const double lim[DDS_WAVE_NUM] = {4.0, 1.0, 0.0};
+    double e, emax;
+    uint32_t i, phase;
+    uint8_t w;
+
+    for (w = 0; w < DDS_WAVE_NUM; w++)
+    {
+        emax = 0;
+
+        for (i = 0; i < (1 << 20); i++)
+        {
+            phase = i << 12 | ((i * 2654435761u) >> 20);        /* Every 2^-20 turn, scrambled low bits */
+            e = fabs(dds_wave(w, phase) - check_ref(w, phase));
+
+            if (e > emax)emax = e;
+        }
+
+        printf("dds_wave %-8s: max error %.3f Q15 LSB\n", name[w], emax);
+        CHECK(emax <= lim[w], "dds_wave %s: error %.3f > %.1f", name[w], emax, lim[w]);
+    }
+}
+
+/**
+ * @brief       dds_step against the exact increment
+ */
+static void check_step(void)
+{
+    static const uint32_t mhz[] = {1, 1000, 1234567, 10000000, 49999999};
+    double exact;
+    uint32_t i, step;
+
+    for (i = 0; i < sizeof(mhz) / sizeof(mhz[0]); i++)
+    {
+        exact = mhz[i] / 1000.0 * 4294967296.0 / CHECK_FS;
+        step = dds_step(mhz[i], CHECK_FS);
+        CHECK(fabs(step - exact) <= 0.5, "dds_step(%u) = %u, exact %.3f", mhz[i], step, exact);
+    }
+
+    printf("dds_step: resolution %.2f uHz\n", CHECK_FS / 4294967296.0 * 1e6);
+}
+
+/**
+ * @brief       Power spectrum of channel 1 of g_buf into g_pow, bins 0 ~ N/2, DC removed
+ */
+static void check_dft(void)
+{
+    uint32_t i, k, n;
+    double re, im, mean = 0;
+
+    for (i = 0; i < CHECK_N; i++)
+    {
+        g_x[i] = g_buf[i] & 0xFFF;
+        mean += g_x[i];
+    }
+
+    mean /= CHECK_N;
+
+    for (i = 0; i < CHECK_N; i++)
+    {
+        g_x[i] -= mean;
+    }
+
+    for (k = 0; k <= CHECK_N / 2; k++)
+    {
+        re = im = 0;
+
+        for (i = 0, n = 0; i < CHECK_N; i++, n = (n + k) & (CHECK_N - 1))
+        {
+            re += g_x[i] * g_cos[n];
+            im -= g_x[i] * g_sin[n];
+        }
+
+        g_pow[k] = re * re + im * im;
+    }
+}
+
+/**
+ * @brief       SFDR, THD and SINAD of a full scale sine on bin k, in dB
+ */
+static void check_tone(dds_t *dds, uint32_t k, double *sfdr, double *thd, double *sinad)
+{
+    double fund, spur = 0, harm = 0, rest = 0;
+    uint32_t i, h, b;
+
+    dds_init(dds);
+    check_set(dds, (uint32_t)(((uint64_t)k << 32) / CHECK_N), CHECK_AMP, DDS_WAVE_SINE, 0, 0);
+    check_fill(dds, g_buf, CHECK_N);
+    check_dft();
+
+    fund = g_pow[k];
+
+    for (i = 1; i <= CHECK_N / 2; i++)
+    {
+        if (i == k)continue;
+
+        rest += g_pow[i];
+
+        if (g_pow[i] > spur)spur = g_pow[i];
+    }
+
+    for (h = 2; h <= 10; h++)
+    {
+        b = (h * k) % CHECK_N;                                  /* Folded into 0 ~ N/2 */
+
+        if (b > CHECK_N / 2)b = CHECK_N - b;
+
+        if (b != 0 && b != k)harm += g_pow[b];
+    }
+
+    *sfdr = 10 * log10(fund / spur);
+    *thd = (harm > 0) ? 10 * log10(harm / fund) : -200;
+    *sinad = 10 * log10(fund / rest);
+}
+
+/**
+ * @brief       Spectrum of bin-centred tones from 73Hz to 49.8kHz
+ */
+static void check_spectrum(dds_t *dds)
+{
+    static const uint32_t bins[] = {3, 41, 101, 409, 1031, 1601, 2039};  /* Odd: the quantization error spreads */
+    double sfdr, thd, sinad, min_sfdr = 1e9, max_thd = -1e9, min_sinad = 1e9;
+    uint32_t i, k;
+
+    for (i = 0; i < CHECK_N; i++)
+    {
+        g_cos[i] = cos(2 * g_pi * i / CHECK_N);
+        g_sin[i] = sin(2 * g_pi * i / CHECK_N);
+    }
+
+    for (i = 0; i < sizeof(bins) / sizeof(bins[0]); i++)
+    {
+        k = bins[i];
+        check_tone(dds, k, &sfdr, &thd, &sinad);
+
+        if (g_verbose)
+        {
+            printf("  %9.3fHz: SFDR %5.1fdB, THD %6.1fdB, SINAD %4.1fdB\n", (double)k * CHECK_FS / CHECK_N, sfdr, thd, sinad);
+        }
+
+        CHECK(sfdr >= CHECK_SFDR_MIN, "bin %u: SFDR %.1fdB < %.0f", k, sfdr, CHECK_SFDR_MIN);
+        CHECK(thd <= CHECK_THD_MAX, "bin %u: THD %.1fdB > %.0f", k, thd, CHECK_THD_MAX);
+        CHECK(sinad >= CHECK_SINAD_MIN, "bin %u: SINAD %.1fdB < %.0f", k, sinad, CHECK_SINAD_MIN);
+
+        if (sfdr < min_sfdr)min_sfdr = sfdr;
+
+        if (thd > max_thd)max_thd = thd;
+
+        if (sinad < min_sinad)min_sinad = sinad;
+    }
+
+    printf("full scale sines, %u tones: SFDR >= %.1fdB, THD <= %.1fdB, SINAD >= %.1fdB\n",
+           (unsigned)(sizeof(bins) / sizeof(bins[0])), min_sfdr, max_thd, min_sinad);
+}
+
+/**
+ * @brief       1234.567Hz sine on channel 1 and a quarter turn behind on channel 2, against a double
+ *              reference of the same phase
+ */
+static void check_locked(dds_t *dds)
+{
+    uint32_t i, step = dds_step(1234567, CHECK_FS);
+    double t, e, emax[2] = {0, 0};
+    uint8_t ch;
+
+    dds_init(dds);
+    check_set(dds, step, 2000, DDS_WAVE_SINE, 0xC0000000, 1);  /* main.c: channel 2 a quarter turn behind */
+    check_fill(dds, g_buf, CHECK_N);
+
+    for (i = 0; i < CHECK_N; i++)
+    {
+        for (ch = 0; ch < DDS_CH_NUM; ch++)
+        {
+            t = 1234.567 * i / CHECK_FS - ((ch == 1) ? 0.25 : 0);
+            t -= floor(t);
+            e = fabs(((g_buf[i] >> (16 * ch)) & 0xFFF) - (2048 + 2000 * sin(2 * g_pi * t)));
+
+            if (e > emax[ch])emax[ch] = e;
+        }
+    }
+
+    printf("1234.567Hz: max error channel 1 %.3f LSB, channel 2 %.3f LSB\n", emax[0], emax[1]);
+    CHECK(emax[0] <= 0.75 && emax[1] <= 0.75, "1234.567Hz: error %.3f / %.3f LSB > 0.75", emax[0], emax[1]);
+}
+
+/**
+ * @brief       Output word of a setting, the dds_fill formula on dds_wave
+ */
+static uint32_t check_word(const dds_cfg_t *cfg, const uint32_t *acc)
+{
+    uint32_t out = 0;
+    int32_t v;
+    uint8_t ch;
+
+    for (ch = 0; ch < DDS_CH_NUM; ch++)
+    {
+        v = cfg->ch[ch].offset + ((dds_wave(cfg->ch[ch].wave, acc[ch]) * (int32_t)cfg->ch[ch].amp + 0x4000) >> 15);
+        v = (v < 0) ? 0 : (v > 4095) ? 4095 : v;
+        out |= (uint32_t)v << (16 * ch);
+    }
+
+    return out;
+}
+
+/**
+ * @brief       Settings changed in the middle of a stream. Each one is taken as a whole at the start
+ *              of the next block, the accumulators run on, a setting edited but not committed is not
+ *              used, and sync restarts channel 2 at channel 1 + ch[1].phase
+ */
+static void check_change(dds_t *dds)
+{
+    static const struct { uint32_t at; uint32_t mhz; uint16_t amp; uint8_t wave; uint32_t phase; uint8_t sync; } set[] = {
+        {   0, 1000000, 2000, DDS_WAVE_SINE,     0xC0000000, 1},
+        { 300, 7777777, 1500, DDS_WAVE_SINE,     0,          0},
+        { 777,  250000, 2047, DDS_WAVE_TRIANGLE, 0,          0},
+        {1500, 2000000,  800, DDS_WAVE_SAW,      0,          0},
+        {1501, 3333333, 2047, DDS_WAVE_SINE,     0x40000000, 1},    /* Same block: only this one is taken */
+        {2600,   12345, 1000, DDS_WAVE_SINE,     0x12345678, 0},    /* Phase without sync: ignored */
+    };
+    dds_cfg_t ref, pend;
+    uint32_t acc[DDS_CH_NUM] = {0, 0}, pos, i, j = 0, bad = 0;
+    dds_cfg_t *cfg;
+    uint8_t ch;
+
+    dds_init(dds);
+    ref = pend = dds->cfg[0];
+
+    for (pos = 0; pos < 3200; pos += CHECK_BLOCK)
+    {
+        /* Settings committed while the previous block was being sent */
+        for (; j < sizeof(set) / sizeof(set[0]) && set[j].at <= pos; j++)
+        {
+            check_set(dds, dds_step(set[j].mhz, CHECK_FS), set[j].amp, set[j].wave, set[j].phase, set[j].sync);
+            pend = dds->cfg[dds->wr & 1];
+        }
+
+        cfg = dds_edit(dds);                                    /* Edited, never committed */
+        cfg->ch[0].amp = cfg->ch[1].amp = 1;
+        cfg->ch[0].step = 0;
+
+        dds_fill(dds, g_buf, CHECK_BLOCK);
+
+        if (memcmp(&pend, &ref, sizeof(ref)) != 0)
+        {
+            ref = pend;
+
+            if (ref.sync)acc[1] = acc[0] + ref.ch[1].phase;
+        }
+
+        for (i = 0; i < CHECK_BLOCK; i++)
+        {
+            if (g_buf[i] != check_word(&ref, acc))bad++;
+
+            for (ch = 0; ch < DDS_CH_NUM; ch++)
+            {
+                acc[ch] += ref.ch[ch].step;
+            }
+        }
+    }
+
+    printf("setting changes: %u samples, %u differ from the reference\n", pos, bad);
+    CHECK(bad == 0, "setting changes: %u samples differ", bad);
+    CHECK(acc[0] == dds->acc[0] && acc[1] == dds->acc[1], "setting changes: accumulators %08X %08X, expected %08X %08X",
+          dds->acc[0], dds->acc[1], acc[0], acc[1]);
+}
+
+int main(int argc, char *argv[])
+{
+    static dds_t dds;
+
+    if (argc > 1 && strcmp(argv[1], "-v") == 0)g_verbose = 1;
+
+    check_wave();
+    check_step();
+    check_spectrum(&dds);
+    check_locked(&dds);
+    check_change(&dds);
+
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+    return g_fails ? 1 : 0;
+}
@@ -14,12 +14,14 @@
  * change logs  :
  * version      data        notes
  * V1.0	        20240222    the first version
+ * V1.1         20261019    debounce with delay_ms sleeps on the stimer service instead of the busy HAL_Delay
  *
  ****************************************************************************************************
  */
 
 
 #include "key.h"
+#include "delay.h"
 
 /**
  * @brief       key scan function
@@ -44,7 +46,7 @@ uint8_t key_scan(uint8_t mode)
 
     if (key_up && (KEY0 == 1 || WK_UP == 1))  /* The key release flag is 1, and any key is pressed */
     {
-        HAL_Delay(10);                        /* delay 10ms */
+        delay_ms(10);                         /* delay 10ms */
         key_up = 0;
 
         if (KEY0 == 1)
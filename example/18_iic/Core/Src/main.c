@@ -15,6 +15,7 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     stimer service on TIM5: LED timer callback, delays sleep instead of spinning
  *
  ****************************************************************************************************
  */
@@ -32,6 +33,7 @@
 #include "../../BSP/LCD/lcd.h"
 #include "../../BSP/24CXX/24cxx.h"
 #include "../../SYSTEM/delay/delay.h"
+#include "../../SYSTEM/delay/stimer.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -55,6 +57,7 @@ static const uint8_t g_text_buf[] = {"STM32 IIC TEST"};
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
+static stimer_t g_led_timer;
 
 /* USER CODE END PV */
 
@@ -67,6 +70,16 @@ void SystemClock_Config(void);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+/**
+ * @brief       LED timer callback, from the TIM5 interrupt
+ * @param       arg : not used
+ * @retval      None
+ */
+static void led_blink(void *arg)
+{
+    LED0_TOGGLE();
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -76,7 +89,6 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-    uint8_t t = 0;
     uint8_t key;
     uint8_t data[TEXT_SIZE];
   /* USER CODE END 1 */
@@ -102,6 +114,7 @@ int main(void)
   MX_USART1_UART_Init();
   MX_FSMC_Init();
   /* USER CODE BEGIN 2 */
+  stimer_init();                            /* 1ms ticks on TIM5, delay_ms sleeps from now on */
 
   lcd_init();
   at24cxx_init();
@@ -122,6 +135,7 @@ int main(void)
       LED0_TOGGLE();
   }
   lcd_show_string(30, 130, 200, 16, 16, "24C02 Ready!       ", RED);
+  stimer_start(&g_led_timer, 200, 200, led_blink, NULL);   /* LED0 flips every 200ms */
 
   /* USER CODE END 2 */
 
@@ -149,13 +163,7 @@ int main(void)
           lcd_show_string(30, 170, 200, 16, 16, (char *)data, BLUE);
       }
 
-      if (++t == 20)
-      {
-          t = 0;
-          LED0_TOGGLE();
-      }
-
-      HAL_Delay(10);
+      delay_ms(10);
 
     /* USER CODE BEGIN 3 */
   }
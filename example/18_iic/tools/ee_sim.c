@@ -0,0 +1,991 @@
+/**
+ ****************************************************************************************************
+ * @file        ee_sim.c
+ * @author      ALIENTEK
+ * @brief       iic_bus.c, myiic.c and 24cxx.c on a Linux host, against simulated AT24Cxx on the SCL/SDA pins
+ *
+ *              The BSRR writes of the IIC transaction engine are replayed in order on the lines of two buses
+ *              (open drain: a line is low if the master or the slave pulls it), each with a bit-level I2C
+ *              slave: START/STOP detection, device address, word address, page writes whose address counter
+ *              wraps inside the page (EE_PAGE_SIZE) as on the real chip, sequential reads. After a STOP ending
+ *              a write the device is busy for tWR and does not acknowledge its address. A slave may hold SCL
+ *              low after a byte (clock stretching), or for a long time (SCL stuck).
+ *              The time is simulated: TIM7 interrupts at the period of its ARR/PSC and the timer clock,
+ *              __WFI sleeps until the next one, HAL_GetTick is the simulated ms.
+ *
+ *              Checks:
+ *              - the timer runs at two interrupts per SCL period and stops when the buses are idle
+ *              - each interrupt moves SCL and SDA of a bus at most once (one edge, no wait in the interrupt)
+ *              - SCL high and low times, SDA setup before SCL rises, SCL high before a START or STOP:
+ *                at least one interrupt period, also after the slave stretched the clock (but for a stretch
+ *                that ends less than one period after the master released SCL: the master can not see it)
+ *              - the number of interrupts, STARTs and STOPs of a transfer, the counters of iic_bus_t
+ *              - queued transfers with callbacks (one queued from a callback), two buses at the same time
+ *              - the page wrap of the model, random writes and reads against a reference copy, with and
+ *                without clock stretching, and that the ACK polling ends less than one poll after tWR
+ *              - a stuck SCL ends the transfer with a NACK after IIC_BUS_STRETCH_MAX interrupts
+ *              - a device that stays busy fails the write after EE_WRITE_TIMEOUT ms whatever the bus speed
+ *
+ *              Build, from example/18_iic:
+ *              gcc -O2 -Wall -DIIC_BUS_ENABLE=1 -Itools/host -I../../libraries/Drivers/SYSTEM/iic tools/ee_sim.c
+ *                  ../../libraries/Drivers/SYSTEM/iic/iic_bus.c BSP/24CXX/24cxx.c BSP/IIC/myiic.c -o ee_sim
+ *              Run:
+ *              ./ee_sim [-w tWR_us] [-n writes] [-s seed]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ * V1.1         20261019    runs the IIC transaction engine: bus timing, stretching, queue, two buses
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "main.h"
+#include "../../BSP/IIC/myiic.h"
+#include "../../BSP/24CXX/24cxx.h"
+
+#define EE_SIZE         (EE_TYPE + 1)
+#define EE_ADDR_BYTES   ((EE_TYPE > AT24C16) ? 2 : 1)
+#define SIM_NEVER       UINT64_MAX
+
+typedef enum
+{
+    EE_IDLE = 0,                /* Not addressed, SDA released */
+    EE_DEV,                     /* Receiving the device address */
+    EE_WORD,                    /* Receiving the word address */
+    EE_WDATA,                   /* Receiving data to write */
+    EE_RDATA,                   /* Sending data */
+} ee_state_t;
+
+typedef struct
+{
+    GPIO_TypeDef *scl_port;
+    uint16_t scl_pin;
+    GPIO_TypeDef *sda_port;
+    uint16_t sda_pin;
+
+    uint8_t mem[EE_SIZE];
+    uint8_t page[EE_PAGE_SIZE]; /* Page buffer, written at the STOP */
+    uint8_t pmask[EE_PAGE_SIZE];
+    ee_state_t state;
+    uint8_t scl, sda, s_sda;    /* Lines, and SDA of the slave */
+    uint8_t bit, shift;
+    uint8_t sending, acked;     /* Read: a byte was sent, the master acknowledged it */
+    uint8_t word_left;
+    uint16_t ptr;               /* Address counter */
+    uint16_t base;              /* Page of the write in progress */
+    uint8_t present;            /* 0: nobody on the bus */
+    uint64_t busy_until;        /* ns */
+    uint64_t ready_at;          /* ns, end of the last write cycle not polled yet, SIM_NEVER if none */
+    uint64_t ready_late;        /* ns, longest time from the end of a write cycle to the ACK of the next poll */
+    uint32_t twr;               /* Write cycle, us */
+    uint32_t writes;            /* Write cycles */
+    uint32_t nacks;             /* Device addresses not acknowledged */
+
+    uint64_t hold_until;        /* ns, SCL held low by the slave until then */
+    uint32_t stretch_pct;       /* Probability to stretch the clock after a byte, % */
+    uint32_t stretch_ns;        /* Longest stretch */
+    uint32_t holds;
+
+    uint64_t t_scl, t_sda;      /* ns, last edge of the lines */
+    uint64_t t_rel;             /* ns, SCL last released by the master */
+    uint8_t unseen;             /* 1, SCL rose less than half a period after the master released it (short stretch) */
+    uint32_t unseens;
+    uint64_t min_scl;           /* ns, shortest SCL high or low time */
+    uint64_t min_setup;         /* ns, shortest SDA setup before SCL rises */
+    uint64_t min_cond;          /* ns, shortest SCL high time before a START or STOP */
+    uint32_t starts, stops;
+    uint8_t w_scl, w_sda;       /* Writes to the pins in the current interrupt */
+} ee_t;
+
+GPIO_TypeDef g_host_gpiob;
+GPIO_TypeDef g_host_gpiof;
+RCC_TypeDef g_host_rcc;
+TIM_TypeDef g_host_tim7;
+uint32_t g_host_bsrr_seq = 0;
+
+void TIM7_IRQHandler(void);
+
+static ee_t g_ee[2];
+static iic_bus_t g_bus2 = {GPIOF, GPIO_PIN_9, GPIOF, GPIO_PIN_10};
+static iic_bus_t g_bus3 = {GPIOF, GPIO_PIN_9, GPIOF, GPIO_PIN_10};     /* One bus too many */
+
+static uint64_t g_sim_ns = 0;       /* Simulated time */
+static uint32_t g_tim_scale = 1;    /* The timer clock is g_tim_scale times slower */
+static uint32_t g_bsrr_done = 0;    /* BSRR writes replayed */
+static uint32_t g_primask = 0;
+static uint8_t g_nvic_en = 0;
+static uint8_t g_irq_pending = 0;
+static uint32_t g_irqs = 0;
+
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+/******************************************************************************************/
+/* The simulated EEPROM */
+
+/**
+ * @brief   A byte was received (after its 8th bit), returns the ACK
+ * @param   ee   : device
+ * @param   byte : byte
+ * @retval  1, ACK; 0, NACK
+ */
+static uint8_t ee_byte_in(ee_t *ee, uint8_t byte)
+{
+    switch (ee->state)
+    {
+        case EE_DEV:
+            if ((byte & 0XF0) != 0XA0 || !ee->present || g_sim_ns < ee->busy_until)
+            {
+                ee->nacks++;
+                ee->state = EE_IDLE;
+                return 0;
+            }
+
+            if (ee->ready_at != SIM_NEVER)      /* First ACK after a write cycle */
+            {
+                if (g_sim_ns - ee->ready_at > ee->ready_late)ee->ready_late = g_sim_ns - ee->ready_at;
+
+                ee->ready_at = SIM_NEVER;
+            }
+
+            if (EE_TYPE <= AT24C16)     /* Block bits a8/a9/a10 in the device address */
+            {
+                ee->ptr = (ee->ptr & 0XFF) | ((((byte >> 1) & 7) << 8) & EE_TYPE);
+            }
+
+            if (byte & 1)
+            {
+                ee->state = EE_RDATA;
+                ee->sending = 0;
+            }
+            else
+            {
+                ee->state = EE_WORD;
+                ee->word_left = EE_ADDR_BYTES;
+            }
+
+            return 1;
+
+        case EE_WORD:
+            if (ee->word_left == 2)
+            {
+                ee->ptr = (byte << 8) & EE_TYPE;
+            }
+            else
+            {
+                ee->ptr = (ee->ptr & 0XFF00) | byte;
+            }
+
+            if (--ee->word_left == 0)
+            {
+                ee->state = EE_WDATA;
+                ee->base = ee->ptr - ee->ptr % EE_PAGE_SIZE;
+                memset(ee->pmask, 0, sizeof(ee->pmask));
+            }
+
+            return 1;
+
+        case EE_WDATA:      /* The counter wraps inside the page */
+            ee->page[ee->ptr % EE_PAGE_SIZE] = byte;
+            ee->pmask[ee->ptr % EE_PAGE_SIZE] = 1;
+            ee->ptr = ee->base + (ee->ptr + 1) % EE_PAGE_SIZE;
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static void ee_start(ee_t *ee)
+{
+    if (ee->state == EE_WDATA)      /* A START instead of a STOP aborts the write */
+    {
+        memset(ee->pmask, 0, sizeof(ee->pmask));
+    }
+
+    ee->state = EE_DEV;
+    ee->bit = 0;
+    ee->shift = 0;
+    ee->s_sda = 1;
+    ee->starts++;
+}
+
+static void ee_stop(ee_t *ee)
+{
+    uint8_t i, n = 0;
+
+    if (ee->state == EE_WDATA)
+    {
+        for (i = 0; i < EE_PAGE_SIZE; i++)
+        {
+            if (ee->pmask[i])
+            {
+                ee->mem[ee->base + i] = ee->page[i];
+                n++;
+            }
+        }
+
+        if (n)
+        {
+            ee->busy_until = g_sim_ns + ee->twr * 1000ULL;
+            ee->ready_at = ee->busy_until;
+            ee->writes++;
+        }
+    }
+
+    ee->state = EE_IDLE;
+    ee->s_sda = 1;
+    ee->stops++;
+}
+
+static void ee_scl_rise(ee_t *ee)
+{
+    if (ee->state == EE_IDLE)return;
+
+    if (ee->bit < 8)
+    {
+        if (ee->state != EE_RDATA)ee->shift = (ee->shift << 1) | ee->sda;
+    }
+    else if (ee->state == EE_RDATA)
+    {
+        ee->acked = !ee->sda;       /* ACK of the master */
+    }
+
+    ee->bit++;                      /* Clocks of the byte, 1 to 9 */
+}
+
+static void ee_scl_fall(ee_t *ee)
+{
+    if (ee->state == EE_IDLE || ee->bit == 0)return;    /* bit 0: the fall after the START */
+
+    if (ee->bit == 8)           /* ACK slot */
+    {
+        if (ee->state == EE_RDATA)
+        {
+            ee->s_sda = 1;
+        }
+        else
+        {
+            ee->s_sda = ee_byte_in(ee, ee->shift) ? 0 : 1;
+        }
+    }
+    else if (ee->bit == 9)      /* Next byte */
+    {
+        ee->bit = 0;
+        ee->s_sda = 1;
+
+        if (ee->stretch_pct && (uint32_t)(rand() % 100) < ee->stretch_pct)
+        {
+            ee->hold_until = g_sim_ns + 1 + rand() % ee->stretch_ns;
+            ee->holds++;
+        }
+
+        if (ee->state == EE_RDATA)
+        {
+            if (ee->sending && !ee->acked)
+            {
+                ee->state = EE_IDLE;    /* NACK after a data byte: the master ends the read */
+                return;
+            }
+
+            ee->sending = 1;
+            ee->s_sda = (ee->mem[ee->ptr] >> 7) & 1;
+        }
+    }
+    else if (ee->state == EE_RDATA)
+    {
+        ee->s_sda = (ee->mem[ee->ptr] >> (7 - ee->bit)) & 1;
+
+        if (ee->bit == 7)ee->ptr = (ee->ptr + 1) & EE_TYPE;
+    }
+}
+
+/******************************************************************************************/
+/* Lines, time and interrupts */
+
+/**
+ * @brief   Interrupt period of TIM7 in ns
+ * @param   None
+ * @retval  ns
+ */
+static uint64_t sim_period(void)
+{
+    uint64_t clk = HAL_RCC_GetPCLK1Freq();
+
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)clk *= 2;
+
+    return (uint64_t)(TIM7->ARR + 1) * (TIM7->PSC + 1) * g_tim_scale * 1000000000ULL / clk;
+}
+
+/**
+ * @brief   Updates the lines of a bus from the pins of the master and the slave, gives the edges to the slave
+ *          (SCL first) and checks the timing
+ * @param   ee : device on the bus
+ * @retval  None
+ */
+static void sim_lines(ee_t *ee)
+{
+    uint8_t scl = (ee->scl_port->ODR & ee->scl_pin) && g_sim_ns >= ee->hold_until;
+    uint8_t sda;
+
+    if (scl != ee->scl)
+    {
+        if (g_sim_ns - ee->t_scl < ee->min_scl && !ee->unseen)ee->min_scl = g_sim_ns - ee->t_scl;
+
+        if (scl && g_sim_ns - ee->t_sda < ee->min_setup)ee->min_setup = g_sim_ns - ee->t_sda;
+
+        ee->unseen = scl && g_sim_ns > ee->t_rel && g_sim_ns - ee->t_rel < sim_period();
+        ee->unseens += ee->unseen;
+        ee->scl = scl;
+        ee->t_scl = g_sim_ns;
+        scl ? ee_scl_rise(ee) : ee_scl_fall(ee);
+    }
+
+    sda = (ee->sda_port->ODR & ee->sda_pin) && ee->s_sda;
+
+    if (sda != ee->sda)
+    {
+        ee->sda = sda;
+        ee->t_sda = g_sim_ns;
+
+        if (ee->scl)
+        {
+            if (g_sim_ns - ee->t_scl < ee->min_cond && !ee->unseen)ee->min_cond = g_sim_ns - ee->t_scl;
+
+            sda ? ee_stop(ee) : ee_start(ee);
+            sda = (ee->sda_port->ODR & ee->sda_pin) && ee->s_sda;
+            CHECK(sda == ee->sda, "the slave moved SDA at a START or STOP");
+        }
+    }
+
+    ee->scl_port->IDR = scl ? (ee->scl_port->IDR | ee->scl_pin) : (ee->scl_port->IDR & ~ee->scl_pin);
+    ee->sda_port->IDR = ee->sda ? (ee->sda_port->IDR | ee->sda_pin) : (ee->sda_port->IDR & ~ee->sda_pin);
+}
+
+/**
+ * @brief   Replays the BSRR writes in program order
+ * @param   None
+ * @retval  None
+ */
+static void sim_replay(void)
+{
+    GPIO_TypeDef *ports[2] = {GPIOB, GPIOF};
+    uint32_t slot, v;
+    uint8_t i, p, n;
+
+    CHECK(g_host_bsrr_seq - g_bsrr_done <= HOST_BSRR_LOG, "%u BSRR writes at once", g_host_bsrr_seq - g_bsrr_done);
+
+    while (g_bsrr_done != g_host_bsrr_seq)
+    {
+        slot = g_bsrr_done++ % HOST_BSRR_LOG;
+
+        for (p = 0, n = 0; p < 2; p++)
+        {
+            v = ports[p]->bsrr[slot];
+
+            if (v == 0)continue;
+
+            ports[p]->bsrr[slot] = 0;
+
+            for (i = 0; i < 2; i++)
+            {
+                if (g_ee[i].scl_port == ports[p] && (v & g_ee[i].scl_pin) && !(ports[p]->ODR & g_ee[i].scl_pin))
+                {
+                    g_ee[i].t_rel = g_sim_ns;
+                }
+            }
+
+            ports[p]->ODR = (ports[p]->ODR | (v & 0XFFFF)) & ~(v >> 16);
+            n++;
+
+            for (i = 0; i < 2; i++)
+            {
+                if (g_ee[i].scl_port == ports[p] && (v & (g_ee[i].scl_pin * 0X10001U)))g_ee[i].w_scl++;
+
+                if (g_ee[i].sda_port == ports[p] && (v & (g_ee[i].sda_pin * 0X10001U)))g_ee[i].w_sda++;
+
+                sim_lines(&g_ee[i]);
+            }
+        }
+
+        CHECK(n == 1, "BSRR slot %u written %u times", slot, n);
+    }
+}
+
+/**
+ * @brief   Advances the time, the lines change when a slave stops holding SCL
+ * @param   ns : time
+ * @retval  None
+ */
+static void sim_advance(uint64_t ns)
+{
+    uint64_t end = g_sim_ns + ns;
+    uint8_t i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (g_ee[i].hold_until > g_sim_ns && g_ee[i].hold_until <= end)
+        {
+            g_sim_ns = g_ee[i].hold_until;
+            sim_lines(&g_ee[i]);
+        }
+    }
+
+    g_sim_ns = end;
+}
+
+/**
+ * @brief   Runs the TIM7 interrupt: each bus moves one edge at most
+ * @param   None
+ * @retval  None
+ */
+static void sim_irq(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < 2; i++)
+    {
+        g_ee[i].w_scl = 0;
+        g_ee[i].w_sda = 0;
+    }
+
+    TIM7->SR |= TIM_SR_UIF;
+    TIM7_IRQHandler();
+    g_irqs++;
+    CHECK((TIM7->SR & TIM_SR_UIF) == 0, "the interrupt flag was not cleared");
+    sim_replay();
+
+    for (i = 0; i < 2; i++)
+    {
+        CHECK(g_ee[i].w_scl <= 1 && g_ee[i].w_sda <= 1, "bus %u: %u SCL and %u SDA writes in one interrupt",
+              i + 1, g_ee[i].w_scl, g_ee[i].w_sda);
+    }
+}
+
+/**
+ * @brief   Runs the timer until it stops (all the buses idle)
+ * @param   None
+ * @retval  Number of interrupts
+ */
+static uint32_t sim_run(void)
+{
+    uint32_t n = 0;
+
+    while (TIM7->CR1 & TIM_CR1_CEN)
+    {
+        sim_advance(sim_period());
+        sim_irq();
+
+        if (++n > 10000000)
+        {
+            printf("FAIL: the timer never stops\n");
+            exit(1);
+        }
+    }
+
+    return n;
+}
+
+/******************************************************************************************/
+/* HAL of the host */
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    CHECK(GPIO_Init->Mode == GPIO_MODE_OUTPUT_OD, "pins 0X%04X are not open drain", GPIO_Init->Pin);
+    sim_replay();
+    (void)GPIOx;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return 36000000;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)IRQn;
+    (void)PreemptPriority;
+    (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+    g_nvic_en = 1;
+
+    if (g_irq_pending && g_primask == 0)
+    {
+        g_irq_pending = 0;
+        sim_irq();
+    }
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+    g_nvic_en = 0;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return g_primask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    g_primask = priMask;
+
+    if (g_primask == 0 && g_irq_pending && g_nvic_en)
+    {
+        g_irq_pending = 0;
+        sim_irq();
+    }
+}
+
+void __disable_irq(void)
+{
+    g_primask = 1;
+}
+
+/* Sleeps until the next timer interrupt, which runs once PRIMASK is cleared */
+void __WFI(void)
+{
+    if (!(TIM7->CR1 & TIM_CR1_CEN) || !g_nvic_en)
+    {
+        printf("FAIL: WFI with the timer stopped, the CPU sleeps forever\n");
+        exit(1);
+    }
+
+    sim_advance(sim_period());
+    g_irq_pending = 1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(g_sim_ns / 1000000);
+}
+
+/******************************************************************************************/
+/* Tests */
+
+/**
+ * @brief   Clears the timing monitor of a bus
+ * @param   ee : device on the bus
+ * @retval  None
+ */
+static void mon_reset(ee_t *ee)
+{
+    ee->min_scl = SIM_NEVER;
+    ee->min_setup = SIM_NEVER;
+    ee->min_cond = SIM_NEVER;
+    ee->starts = 0;
+    ee->stops = 0;
+}
+
+/**
+ * @brief   Checks the timing monitor of a bus: nothing shorter than one interrupt period
+ * @param   ee   : device on the bus
+ * @param   name : test
+ * @retval  None
+ */
+static void mon_check(ee_t *ee, const char *name)
+{
+    uint64_t half = sim_period();
+
+    CHECK(ee->min_scl >= half, "%s: SCL high or low for %llu ns, half a period is %llu ns",
+          name, (unsigned long long)ee->min_scl, (unsigned long long)half);
+    CHECK(ee->min_setup >= half, "%s: SDA set %llu ns before SCL rises", name, (unsigned long long)ee->min_setup);
+    CHECK(ee->min_cond >= half, "%s: SCL high for %llu ns before a START or STOP", name, (unsigned long long)ee->min_cond);
+}
+
+/**
+ * @brief   Timer setup and the cost of single transfers: interrupts, STARTs, STOPs, counters
+ * @param   None
+ * @retval  None
+ */
+static void test_bus(void)
+{
+    ee_t *ee = &g_ee[0];
+    iic_xfer_t xfer = {0};
+    uint32_t irqs, xfers = g_iic_bus.xfers, bytes = g_iic_bus.bytes, nacks = g_iic_bus.nacks;
+    uint8_t buf[4] = {1, 2, 3, 4};
+
+    CHECK(sim_period() == 1000000000ULL / (2 * IIC_BUS_SCL_FREQ), "interrupt period %llu ns, SCL %u Hz",
+          (unsigned long long)sim_period(), IIC_BUS_SCL_FREQ);
+    CHECK((TIM7->CR1 & TIM_CR1_CEN) == 0, "the timer runs with no transfer");
+
+    /* Write 4 bytes at word 0X10: START, 6 bytes of 19 interrupts (9 high, 10 low), STOP */
+    mon_reset(ee);
+    xfer.addr = 0XA0;
+    xfer.reg = 0X10;
+    xfer.reg_len = EE_ADDR_BYTES;
+    xfer.buf = buf;
+    xfer.len = 4;
+    CHECK(iic_bus_submit(&g_iic_bus, &xfer) == 0 && xfer.sta == IIC_XFER_PENDING, "submit failed");
+    irqs = sim_run();
+    CHECK(xfer.sta == IIC_XFER_OK, "write: status %u", xfer.sta);
+    CHECK(irqs == 3 + 19 * (1 + EE_ADDR_BYTES + 4) + 3, "write: %u interrupts", irqs);
+    CHECK(ee->starts == 1 && ee->stops == 1, "write: %u STARTs, %u STOPs", ee->starts, ee->stops);
+    CHECK(g_iic_bus.xfers - xfers == 1 && g_iic_bus.bytes - bytes == 1 + EE_ADDR_BYTES + 4 && g_iic_bus.nacks == nacks,
+          "write: counters %u/%u/%u", g_iic_bus.xfers - xfers, g_iic_bus.bytes - bytes, g_iic_bus.nacks - nacks);
+    mon_check(ee, "write");
+    printf("bus: %llu ns per interrupt, %u interrupts for a %u byte write\n",
+           (unsigned long long)sim_period(), irqs, 1 + EE_ADDR_BYTES + 4);
+
+    /* Address only while the device is busy: NACK after the address byte */
+    mon_reset(ee);
+    xfers = g_iic_bus.xfers;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.addr = 0XA0;
+    iic_bus_submit(&g_iic_bus, &xfer);
+    irqs = sim_run();
+    CHECK(xfer.sta == IIC_XFER_NACK && g_iic_bus.nacks - nacks == 1, "poll of a busy device: status %u", xfer.sta);
+    CHECK(irqs == 3 + 19 + 3, "poll: %u interrupts", irqs);
+    CHECK(ee->starts == 1 && ee->stops == 1, "poll: %u STARTs, %u STOPs", ee->starts, ee->stops);
+
+    /* Read back after tWR: repeated START */
+    sim_advance(ee->twr * 1000ULL);
+    mon_reset(ee);
+    bytes = g_iic_bus.bytes;
+    memset(buf, 0, sizeof(buf));
+    xfer.dir = IIC_XFER_RD;
+    xfer.reg = 0X10;
+    xfer.reg_len = EE_ADDR_BYTES;
+    xfer.buf = buf;
+    xfer.len = 4;
+    iic_bus_submit(&g_iic_bus, &xfer);
+    irqs = sim_run();
+    CHECK(xfer.sta == IIC_XFER_OK && buf[0] == 1 && buf[3] == 4, "read: status %u, %u..%u", xfer.sta, buf[0], buf[3]);
+    CHECK(irqs == 3 + 19 * (1 + EE_ADDR_BYTES) + 3 + 19 * (1 + 4) + 3, "read: %u interrupts", irqs);
+    CHECK(ee->starts == 2 && ee->stops == 1, "read: %u STARTs, %u STOPs", ee->starts, ee->stops);
+    CHECK(g_iic_bus.bytes - bytes == 2 + EE_ADDR_BYTES + 4, "read: %u bytes counted", g_iic_bus.bytes - bytes);
+    mon_check(ee, "read");
+
+    /* Invalid transfers are refused */
+    xfer.reg_len = 3;
+    CHECK(iic_bus_submit(&g_iic_bus, &xfer) == 1 && xfer.sta == IIC_XFER_NACK, "a 3-byte register address was queued");
+    xfer.reg_len = 1;
+    xfer.len = 0;
+    CHECK(iic_bus_submit(&g_iic_bus, &xfer) == 1, "an empty read was queued");
+    CHECK((TIM7->CR1 & TIM_CR1_CEN) == 0, "the timer runs after invalid transfers");
+}
+
+static iic_xfer_t g_chain[4];
+static uint8_t g_chain_buf[4][EE_PAGE_SIZE];
+static uint32_t g_chain_order[8];
+static uint32_t g_chain_n = 0;
+
+/**
+ * @brief   Completion callback: records the order, the first transfer queues the last one
+ * @param   xfer : transfer
+ * @retval  None
+ */
+static void chain_cb(iic_xfer_t *xfer)
+{
+    g_chain_order[g_chain_n++ & 7] = (uint32_t)(uintptr_t)xfer->arg;
+
+    if (xfer == &g_chain[0])
+    {
+        CHECK(iic_bus_submit(&g_iic_bus, &g_chain[3]) == 0, "submit from a callback failed");
+    }
+}
+
+/**
+ * @brief   Queued transfers with callbacks, and two buses at the same time
+ * @param   None
+ * @retval  None
+ */
+static void test_queue(void)
+{
+    iic_xfer_t x2 = {0};
+    uint8_t buf2[EE_PAGE_SIZE];
+    uint32_t i, irqs, one;
+    uint64_t t0;
+
+    sim_advance(g_ee[0].twr * 1000ULL);
+
+    /* Reads of pages 0 to 2 and, queued by the first callback, page 3 */
+    for (i = 0; i < 4; i++)
+    {
+        memset(&g_chain[i], 0, sizeof(g_chain[i]));
+        g_chain[i].addr = 0XA0;
+        g_chain[i].dir = IIC_XFER_RD;
+        g_chain[i].reg = i * EE_PAGE_SIZE;
+        g_chain[i].reg_len = EE_ADDR_BYTES;
+        g_chain[i].buf = g_chain_buf[i];
+        g_chain[i].len = EE_PAGE_SIZE;
+        g_chain[i].cb = chain_cb;
+        g_chain[i].arg = (void *)(uintptr_t)i;
+    }
+
+    for (i = 0; i < 3; i++)iic_bus_submit(&g_iic_bus, &g_chain[i]);
+
+    irqs = sim_run();
+    CHECK(g_chain_n == 4, "%u callbacks for 4 transfers", g_chain_n);
+
+    for (i = 0; i < 4 && i < g_chain_n; i++)
+    {
+        CHECK(g_chain_order[i] == i, "callback %u for transfer %u", i, g_chain_order[i]);
+        CHECK(g_chain[i].sta == IIC_XFER_OK && memcmp(g_chain_buf[i], &g_ee[0].mem[i * EE_PAGE_SIZE], EE_PAGE_SIZE) == 0,
+              "queued read %u: status %u or wrong data", i, g_chain[i].sta);
+    }
+
+    one = irqs / 4;
+    CHECK(irqs == 4 * one, "4 equal reads took %u interrupts", irqs);
+
+    /* The same read on both buses at the same time: both done within the time of one */
+    mon_reset(&g_ee[1]);
+    memset(g_chain_buf[0], 0, EE_PAGE_SIZE);
+    g_chain[0].cb = NULL;
+    x2 = g_chain[0];
+    x2.buf = buf2;
+    t0 = g_sim_ns;
+    iic_bus_submit(&g_iic_bus, &g_chain[0]);
+    iic_bus_submit(&g_bus2, &x2);
+    irqs = sim_run();
+    CHECK(irqs == one, "two buses: %u interrupts, one bus %u", irqs, one);
+    CHECK(g_chain[0].sta == IIC_XFER_OK && memcmp(g_chain_buf[0], g_ee[0].mem, EE_PAGE_SIZE) == 0, "two buses: bus 1 read failed");
+    CHECK(x2.sta == IIC_XFER_OK && memcmp(buf2, g_ee[1].mem, EE_PAGE_SIZE) == 0, "two buses: bus 2 read failed");
+    CHECK(g_ee[1].starts == 2 && g_ee[1].stops == 1, "two buses: bus 2 saw %u STARTs", g_ee[1].starts);
+    mon_check(&g_ee[1], "bus 2");
+    printf("queue: %u interrupts per %u byte read, two buses in %.2f ms\n", one, EE_PAGE_SIZE, (g_sim_ns - t0) / 1e6);
+
+    CHECK(iic_bus_add(&g_bus2) == 0, "adding a bus again failed");
+    CHECK(iic_bus_add(&g_bus3) == 1, "a third bus was accepted");
+}
+
+/**
+ * @brief   The model wraps a page write inside the page: one transfer past the end of the page
+ * @param   None
+ * @retval  None
+ */
+static void test_page_wrap(void)
+{
+    ee_t *ee = &g_ee[0];
+    uint16_t addr = EE_PAGE_SIZE * 3 + 5, i;
+    uint8_t buf[EE_PAGE_SIZE + 2];
+
+    for (i = 0; i < EE_PAGE_SIZE + 2; i++)buf[i] = i + 1;   /* 2 bytes too many: they overwrite the first 2 */
+
+    sim_advance(ee->twr * 1000ULL);
+    memset(&ee->mem[EE_PAGE_SIZE * 3], 0XFF, 2 * EE_PAGE_SIZE);
+    CHECK(iic_bus_write(&g_iic_bus, 0XA0 + ((EE_TYPE <= AT24C16) ? ((addr >> 8) << 1) : 0), addr, EE_ADDR_BYTES,
+                        buf, EE_PAGE_SIZE + 2) == 0, "page wrap: the write failed");
+    sim_advance(ee->twr * 1000ULL);
+
+    for (i = 0; i < EE_PAGE_SIZE; i++)     /* The last byte written to each position stays */
+    {
+        uint16_t off = (5 + i) % EE_PAGE_SIZE;
+        uint8_t want = (i < 2) ? (uint8_t)(EE_PAGE_SIZE + i + 1) : (uint8_t)(i + 1);
+
+        CHECK(ee->mem[EE_PAGE_SIZE * 3 + off] == want, "page wrap: offset %u holds %u, expected %u",
+              off, ee->mem[EE_PAGE_SIZE * 3 + off], want);
+    }
+
+    CHECK(ee->mem[EE_PAGE_SIZE * 4] == 0XFF, "page wrap: the next page was written");
+    ee->ready_at = SIM_NEVER;
+}
+
+/**
+ * @brief   Random writes through at24cxx_write, read back with at24cxx_read
+ * @param   n       : writes
+ * @param   stretch : 1, the EEPROM stretches the clock after a third of the bytes, up to 300us
+ * @retval  None
+ */
+static void test_random(uint32_t n, uint8_t stretch)
+{
+    static uint8_t ref[EE_SIZE];
+    static uint8_t buf[EE_SIZE];
+    ee_t *ee = &g_ee[0];
+    uint32_t i, j, w0, pages = 0, s0 = g_iic_bus.stretches;
+    uint32_t poll = (3 + 19 + 3 + 1) * sim_period();
+    uint16_t addr, len;
+    const char *name = stretch ? "random, stretched" : "random";
+
+    memcpy(ref, ee->mem, sizeof(ref));
+    mon_reset(ee);
+    ee->ready_late = 0;
+    ee->stretch_pct = stretch ? 33 : 0;
+    ee->stretch_ns = 300000;
+    ee->holds = 0;
+    ee->unseens = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        addr = rand() % EE_SIZE;
+        len = 1 + rand() % (3 * EE_PAGE_SIZE);
+
+        if (addr + len > EE_SIZE)len = EE_SIZE - addr;
+
+        for (j = 0; j < len; j++)buf[j] = rand();
+
+        w0 = ee->writes;
+        CHECK(at24cxx_write(addr, buf, len) == 0, "%s: write %u bytes at %u failed", name, len, addr);
+        pages += ee->writes - w0;
+        CHECK(ee->writes - w0 == (addr + len - 1) / EE_PAGE_SIZE - addr / EE_PAGE_SIZE + 1,
+              "%s: write %u bytes at %u: %u write cycles", name, len, addr, ee->writes - w0);
+        memcpy(&ref[addr], buf, len);
+
+        /* Read at once: the device must be ready */
+        memset(buf, 0, len);
+        CHECK(at24cxx_read(addr, buf, len) == 0, "%s: read %u bytes at %u failed", name, len, addr);
+        CHECK(memcmp(buf, &ref[addr], len) == 0, "%s: read %u bytes at %u: wrong data", name, len, addr);
+    }
+
+    CHECK(at24cxx_read(0, buf, EE_SIZE) == 0, "%s: read of the whole EEPROM failed", name);
+    CHECK(memcmp(buf, ref, EE_SIZE) == 0, "%s: the whole EEPROM differs from the reference", name);
+    CHECK(memcmp(ee->mem, ref, EE_SIZE) == 0, "%s: the simulated memory differs from the reference", name);
+    mon_check(ee, name);
+
+    printf("%s: %u writes, %u page writes, ready %.2f ms after tWR at most, %u NACKs while busy, %u/%u stretches seen, %u too short\n",
+           name, n, pages, ee->ready_late / 1e6, ee->nacks, g_iic_bus.stretches - s0, ee->holds, ee->unseens);
+    CHECK(ee->ready_late < poll, "%s: the ACK polling ended %.2f ms after tWR, one poll is %.2f ms",
+          name, ee->ready_late / 1e6, poll / 1e6);
+    CHECK(stretch == 0 || (g_iic_bus.stretches > s0 && g_iic_bus.stretches - s0 <= ee->holds),
+          "%s: %u stretches seen for %u", name, g_iic_bus.stretches - s0, ee->holds);
+    CHECK(ee->unseens <= ee->holds, "%s: SCL rose late %u times without stretching", name, ee->unseens);
+    ee->stretch_pct = 0;
+}
+
+/**
+ * @brief   SCL held low by the slave for 15ms: the transfer ends with a NACK after about 10ms
+ *          (IIC_BUS_STRETCH_MAX), and the bus works again once SCL is released
+ * @param   None
+ * @retval  None
+ */
+static void test_stuck(void)
+{
+    ee_t *ee = &g_ee[0];
+    uint32_t nacks = g_iic_bus.nacks;
+    uint64_t t0, limit = (uint64_t)IIC_BUS_STRETCH_MAX * sim_period();
+    uint8_t data;
+
+    sim_advance(ee->twr * 1000ULL);
+    t0 = g_sim_ns;
+    ee->hold_until = t0 + limit * 3 / 2;
+    sim_lines(ee);
+    CHECK(at24cxx_read(0, &data, 1) == 1, "stuck SCL: the read did not fail");
+    CHECK(g_iic_bus.nacks - nacks == 1, "stuck SCL: %u NACKs counted", g_iic_bus.nacks - nacks);
+    printf("stuck: failed after %.2f ms (SCL released after %.2f ms)\n", (g_sim_ns - t0) / 1e6, limit * 1.5 / 1e6);
+    CHECK(g_sim_ns - t0 >= limit * 3 / 2 && g_sim_ns - t0 < limit * 3 / 2 + 10 * sim_period(),
+          "stuck SCL: the read ended after %.2f ms", (g_sim_ns - t0) / 1e6);
+    CHECK(at24cxx_read(0, &data, 1) == 0 && data == ee->mem[0], "stuck SCL: the bus did not recover");
+}
+
+/**
+ * @brief   A device that stays busy: the write fails after EE_WRITE_TIMEOUT ms at any bus speed
+ * @param   scale : the timer clock, so the bus, is scale times slower
+ * @retval  None
+ */
+static void test_timeout(uint32_t scale)
+{
+    ee_t *ee = &g_ee[0];
+    uint32_t twr = ee->twr, n0;
+    uint64_t t0, poll, write;
+    uint8_t data = 0X5A;
+
+    g_tim_scale = scale;
+    poll = (3 + 19 + 3) * sim_period();
+    write = (3 + 19 * (1 + EE_ADDR_BYTES + 1) + 3) * sim_period();
+    ee->twr = 1000000;          /* 1s, never ready in time */
+    sim_advance(rand() % 1000000);  /* Any phase of the ms tick */
+    n0 = ee->nacks;
+    t0 = g_sim_ns;
+    CHECK(at24cxx_write(EE_PAGE_SIZE, &data, 1) == 1, "bus %ux slower: the write did not time out", scale);
+    t0 = g_sim_ns - t0;
+    printf("timeout, bus %ux slower: failed after %.2f ms, %u polls\n", scale, t0 / 1e6, ee->nacks - n0);
+    CHECK(t0 >= write + EE_WRITE_TIMEOUT * 1000000ULL && t0 < write + (EE_WRITE_TIMEOUT + 1) * 1000000ULL + poll,
+          "bus %ux slower: timeout after %.2f ms, expected %u ms", scale, t0 / 1e6, EE_WRITE_TIMEOUT);
+
+    g_sim_ns = ee->busy_until;
+    ee->ready_at = SIM_NEVER;
+    ee->twr = twr;
+    g_tim_scale = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = 2000, twr = 5000;
+    uint8_t data = 0;
+    int opt, i;
+
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "w:n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'w': twr = atoi(optarg); break;
+            case 'n': n = atoi(optarg); break;
+            case 's': srand(atoi(optarg)); break;
+            default:
+                fprintf(stderr, "usage: %s [-w tWR_us] [-n writes] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    RCC->CFGR = RCC_CFGR_PPRE1_DIV2;    /* PCLK1 36MHz, the APB1 timers at 72MHz */
+    g_host_gpiob.IDR = 0XFFFF;            /* Pulled up */
+    g_host_gpiob.ODR = 0XFFFF;
+    g_host_gpiof.IDR = 0XFFFF;
+    g_host_gpiof.ODR = 0XFFFF;
+
+    for (i = 0; i < 2; i++)
+    {
+        memset(&g_ee[i], 0, sizeof(g_ee[i]));
+        memset(g_ee[i].mem, 0XFF, sizeof(g_ee[i].mem));
+        g_ee[i].scl = 1;
+        g_ee[i].sda = 1;
+        g_ee[i].s_sda = 1;
+        g_ee[i].present = 1;
+        g_ee[i].twr = twr;
+        g_ee[i].ready_at = SIM_NEVER;
+        mon_reset(&g_ee[i]);
+    }
+
+    g_ee[0].scl_port = GPIOB;
+    g_ee[0].scl_pin = IIC_SCL_Pin;
+    g_ee[0].sda_port = GPIOB;
+    g_ee[0].sda_pin = IIC_SDA_Pin;
+    g_ee[1].scl_port = g_bus2.scl_port;
+    g_ee[1].scl_pin = g_bus2.scl_pin;
+    g_ee[1].sda_port = g_bus2.sda_port;
+    g_ee[1].sda_pin = g_bus2.sda_pin;
+
+    for (i = 0; i < EE_SIZE; i++)g_ee[1].mem[i] = rand();
+
+    at24cxx_init();
+    CHECK(iic_bus_add(&g_bus2) == 0, "the second bus was refused");
+    CHECK(at24cxx_check() == 0, "at24cxx_check failed on a blank EEPROM");
+    CHECK(g_ee[0].mem[EE_TYPE] == 0X55, "at24cxx_check did not write its mark");
+    CHECK(g_ee[0].scl && g_ee[0].sda && g_ee[1].scl && g_ee[1].sda, "the lines are not released when idle");
+
+    test_bus();
+    test_queue();
+    test_page_wrap();
+    test_random(n, 0);
+    test_random(n / 4, 1);
+    test_stuck();
+    test_timeout(1);
+    test_timeout(10);
+
+    g_ee[0].present = 0;
+    CHECK(at24cxx_read(0, &data, 1) == 1, "no device: the read did not fail");
+
+    printf("%d interrupts, %.2f s simulated\n", g_irqs, g_sim_ns / 1e9);
+    printf(g_fails ? "%d failures\n" : "all passed\n", g_fails);
+    return g_fails ? 1 : 0;
+}
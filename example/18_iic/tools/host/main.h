@@ -0,0 +1,129 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host builds (tools/ee_sim.c, tools/stimer_sim.c): the GPIO, timer, NVIC and tick
+ *              definitions used by iic_bus.c, myiic.c, 24cxx.c and stimer.c
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ * V1.1         20261019    registers of the IIC transaction engine (BSRR/IDR, TIM7, RCC), NVIC and PRIMASK
+ * V1.2         20261019    also used by tools/stimer_sim.c
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/******************************************************************************************/
+/* GPIO */
+
+#define HOST_BSRR_LOG       16
+
+typedef struct
+{
+    uint32_t IDR;                       /* Line levels, set by the simulation */
+    uint32_t ODR;                       /* Output levels, set by the simulation from the BSRR writes */
+    uint32_t bsrr[HOST_BSRR_LOG];       /* BSRR writes not replayed yet, 0 if free */
+} GPIO_TypeDef;
+
+/* Every write to BSRR lands in its own slot, the slots are numbered across all the ports:
+ * the simulation replays the writes in program order, even two writes to the same port */
+extern uint32_t g_host_bsrr_seq;
+#define BSRR                bsrr[g_host_bsrr_seq++ % HOST_BSRR_LOG]
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_OUTPUT_OD     0x00000011u
+#define GPIO_PULLUP             0x00000001u
+#define GPIO_SPEED_FREQ_HIGH    0x00000003u
+
+extern GPIO_TypeDef g_host_gpiob;
+extern GPIO_TypeDef g_host_gpiof;
+
+#define GPIOB               (&g_host_gpiob)
+#define GPIOF               (&g_host_gpiof)
+#define GPIO_PIN_6          ((uint16_t)0x0040)
+#define GPIO_PIN_7          ((uint16_t)0x0080)
+#define GPIO_PIN_9          ((uint16_t)0x0200)
+#define GPIO_PIN_10         ((uint16_t)0x0400)
+
+#define IIC_SCL_Pin         GPIO_PIN_6
+#define IIC_SCL_GPIO_Port   GPIOB
+#define IIC_SDA_Pin         GPIO_PIN_7
+#define IIC_SDA_GPIO_Port   GPIOB
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+
+/******************************************************************************************/
+/* RCC, TIM7 */
+
+typedef struct
+{
+    uint32_t CFGR;
+} RCC_TypeDef;
+
+typedef struct
+{
+    uint32_t CR1;
+    uint32_t DIER;
+    uint32_t SR;
+    uint32_t EGR;
+    uint32_t PSC;
+    uint32_t ARR;
+} TIM_TypeDef;
+
+extern RCC_TypeDef g_host_rcc;
+extern TIM_TypeDef g_host_tim7;
+
+#define RCC                     (&g_host_rcc)
+#define TIM7                    (&g_host_tim7)
+#define RCC_CFGR_PPRE1          0x00000700u
+#define RCC_CFGR_PPRE1_DIV1     0x00000000u
+#define RCC_CFGR_PPRE1_DIV2     0x00000400u
+#define TIM_CR1_CEN             0x0001u
+#define TIM_DIER_UIE            0x0001u
+#define TIM_SR_UIF              0x0001u
+#define TIM_EGR_UG              0x0001u
+
+#define __HAL_RCC_TIM7_CLK_ENABLE()     ((void)0)
+
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+/******************************************************************************************/
+/* NVIC, PRIMASK, tick */
+
+typedef enum
+{
+    TIM7_IRQn = 55
+} IRQn_Type;
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+void __WFI(void);
+uint32_t HAL_GetTick(void);
+
+#endif
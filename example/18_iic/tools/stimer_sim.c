@@ -0,0 +1,251 @@
+/**
+ ****************************************************************************************************
+ * @file        stimer_sim.c
+ * @author      ALIENTEK
+ * @brief       The timer wheel of stimer.c on a Linux host, against a reference list of due ticks
+ *
+ *              stimer.c is included, so the check sees the slots of the wheel. stimer_tick is called as the
+ *              TIM5 interrupt would, the tick counter starts just before its wrap.
+ *
+ *              Checks:
+ *              - every slot is sorted by due tick and only holds the timers of its own slot, so a tick
+ *                looking at the head of its slot finds all the due timers
+ *              - each timer is called at its due tick, once, periodic timers again every period
+ *              - timers started, restarted and stopped between the ticks and from the callbacks, many of
+ *                them in the same slot (delays a multiple of STIMER_SLOTS apart, in several rounds)
+ *
+ *              Build, from example/18_iic:
+ *              gcc -O2 -Wall -Itools/host -I../../libraries/Drivers/SYSTEM/delay tools/stimer_sim.c -o stimer_sim
+ *              Run:
+ *              ./stimer_sim [-n ticks] [-s seed]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "../../../../libraries/Drivers/SYSTEM/delay/stimer.c"
+
+#define SIM_TIMERS      200
+
+#define CHECK(c, ...) do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+typedef struct
+{
+    stimer_t t;
+    uint8_t active;                     /* Reference: waiting for a call */
+    uint32_t expire;                    /* Reference: due tick */
+    uint32_t period;
+    uint32_t calls;
+} sim_timer_t;
+
+static sim_timer_t g_tm[SIM_TIMERS];
+static uint32_t g_fails = 0;
+static uint32_t g_calls = 0;
+static uint32_t g_primask = 0;
+
+/******************************************************************************************/
+/* Host CPU */
+
+uint32_t __get_PRIMASK(void)
+{
+    return g_primask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    g_primask = priMask;
+}
+
+void __disable_irq(void)
+{
+    g_primask = 1;
+}
+
+/******************************************************************************************/
+/* Timers and reference */
+
+/**
+ * @brief     Delay of a start: short, or a multiple of STIMER_SLOTS away so the timers share slots
+ * @param     None
+ * @retval    Ticks
+ */
+static uint32_t sim_delay(void)
+{
+    switch (rand() % 3)
+    {
+        case 0: return rand() % 8;
+        case 1: return (rand() % 5 + 1) * STIMER_SLOTS + rand() % 2;
+        default: return rand() % (6 * STIMER_SLOTS);
+    }
+}
+
+static void sim_cb(void *arg);
+
+/**
+ * @brief     Starts a timer and its reference
+ * @param     i : timer
+ * @retval    None
+ */
+static void sim_start(int i)
+{
+    uint32_t delay = sim_delay();
+    uint32_t period = (rand() % 2) ? 0 : ((rand() % 2) ? STIMER_SLOTS * (rand() % 3 + 1) : rand() % 100 + 1);
+
+    stimer_start(&g_tm[i].t, delay, period, sim_cb, &g_tm[i]);
+    g_tm[i].active = 1;
+    g_tm[i].expire = g_stimer_now + (delay ? delay : 1);
+    g_tm[i].period = period;
+}
+
+/**
+ * @brief     Stops a timer and its reference
+ * @param     i : timer
+ * @retval    None
+ */
+static void sim_stop(int i)
+{
+    stimer_stop(&g_tm[i].t);
+    g_tm[i].active = 0;
+}
+
+/**
+ * @brief     Callback: checks the call against the reference, sometimes starts or stops another timer
+ * @param     arg : sim_timer_t
+ * @retval    None
+ */
+static void sim_cb(void *arg)
+{
+    sim_timer_t *s = arg;
+
+    CHECK(s->active && s->expire == g_stimer_now, "timer %d called at %u, due %u (active %u)",
+          (int)(s - g_tm), g_stimer_now, s->expire, s->active);
+    CHECK(g_primask == 0, "callback with interrupts disabled");
+
+    s->calls++;
+    g_calls++;
+
+    if (s->period)
+    {
+        s->expire += s->period;
+    }
+    else
+    {
+        s->active = 0;
+        CHECK(!stimer_active(&s->t), "one-shot timer %d still active", (int)(s - g_tm));
+    }
+
+    switch (rand() % 8)
+    {
+        case 0: sim_start(rand() % SIM_TIMERS); break;
+        case 1: sim_stop(rand() % SIM_TIMERS); break;
+        case 2: sim_start(s - g_tm); break;     /* Restarts itself */
+        default: break;
+    }
+}
+
+/**
+ * @brief     Checks the slots: sorted by due tick, linked both ways, the timers of the slot, all active
+ *            timers and only them
+ * @param     None
+ * @retval    None
+ */
+static void sim_check_wheel(void)
+{
+    uint32_t n = 0, i;
+    stimer_t *t;
+
+    for (i = 0; i < STIMER_SLOTS; i++)
+    {
+        for (t = g_stimer_wheel[i]; t != NULL; t = t->next)
+        {
+            n++;
+            CHECK((t->expire & (STIMER_SLOTS - 1)) == i, "due %u in slot %u", t->expire, i);
+            CHECK((int32_t)(t->expire - g_stimer_now) > 0, "due %u not after now %u", t->expire, g_stimer_now);
+            CHECK(t->prev ? t->prev->next == t : g_stimer_wheel[i] == t, "slot %u badly linked", i);
+
+            if (t->next)
+            {
+                CHECK((int32_t)(t->next->expire - t->expire) >= 0, "slot %u not sorted: %u before %u",
+                      i, t->expire, t->next->expire);
+            }
+        }
+    }
+
+    for (i = 0; i < SIM_TIMERS; i++)
+    {
+        CHECK(stimer_active(&g_tm[i].t) == g_tm[i].active, "timer %u active %u, reference %u",
+              i, stimer_active(&g_tm[i].t), g_tm[i].active);
+
+        if (g_tm[i].active)
+        {
+            CHECK(g_tm[i].t.expire == g_tm[i].expire, "timer %u due %u, reference %u", i, g_tm[i].t.expire, g_tm[i].expire);
+            n--;
+        }
+    }
+
+    CHECK(n == 0, "%d timers in the wheel that are not active", (int)n);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = 20000, k;
+    int opt, i;
+
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 's': srand(atoi(optarg)); break;
+            default:
+                fprintf(stderr, "usage: %s [-n ticks] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    g_stimer_now = 0XFFFFFFFF - 3 * STIMER_SLOTS;   /* The due ticks wrap during the run */
+
+    for (i = 0; i < SIM_TIMERS; i++)
+    {
+        if (rand() % 2)sim_start(i);
+    }
+
+    for (k = 0; k < n; k++)
+    {
+        sim_check_wheel();
+
+        for (i = rand() % 4; i > 0; i--)
+        {
+            if (rand() % 3)sim_start(rand() % SIM_TIMERS);
+            else sim_stop(rand() % SIM_TIMERS);
+        }
+
+        stimer_tick();
+
+        for (i = 0; i < SIM_TIMERS; i++)
+        {
+            CHECK(!g_tm[i].active || (int32_t)(g_tm[i].expire - g_stimer_now) > 0,
+                  "timer %d due %u not called at %u", i, g_tm[i].expire, g_stimer_now);
+        }
+    }
+
+    sim_check_wheel();
+    printf("%u ticks, %u calls, %u failures\n", n, g_calls, g_fails);
+
+    return g_fails ? 1 : 0;
+}
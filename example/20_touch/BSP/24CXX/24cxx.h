@@ -13,6 +13,8 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     add EE_PAGE_SIZE and EE_POLL_MAX, at24cxx_read/at24cxx_write return a status
+ * V1.2         20261019     EE_WRITE_TIMEOUT in ms replaces EE_POLL_MAX
  *
  ****************************************************************************************************
  */
@@ -35,12 +37,25 @@
 
 #define EE_TYPE     AT24C02
 
+/* Page size in bytes, a page write must not cross it */
+#if EE_TYPE <= AT24C02
+#define EE_PAGE_SIZE    8
+#elif EE_TYPE <= AT24C16
+#define EE_PAGE_SIZE    16
+#elif EE_TYPE <= AT24C64
+#define EE_PAGE_SIZE    32
+#else
+#define EE_PAGE_SIZE    64
+#endif
+
+#define EE_WRITE_TIMEOUT    10  /* ms of ACK polling before a write is considered failed, the write cycle (tWR) is 5ms at most */
+
 void at24cxx_init(void);
 uint8_t at24cxx_check(void);
 uint8_t at24cxx_read_one_byte(uint16_t addr);
 void at24cxx_write_one_byte(uint16_t addr,uint8_t data);
-void at24cxx_write(uint16_t addr, uint8_t *pbuf, uint16_t datalen);
-void at24cxx_read(uint16_t addr, uint8_t *pbuf, uint16_t datalen);
+uint8_t at24cxx_write(uint16_t addr, uint8_t *pbuf, uint16_t datalen);
+uint8_t at24cxx_read(uint16_t addr, uint8_t *pbuf, uint16_t datalen);
 
 
 #endif /* 24CXX_24CXX_H_ */
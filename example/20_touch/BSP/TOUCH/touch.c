@@ -14,6 +14,9 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     resistive screen: burst sampling without delay_us, trimmed mean without sorting,
+ *                           fixed-point calibration, adaptive smoothing of the strokes
+ * V1.2         20261019     SPI clock timed with the DWT cycle counter, a point outside the screen is 0xFFFF
  *
  ****************************************************************************************************
  */
@@ -43,6 +46,25 @@ _m_tp_dev tp_dev =
     0,
 };
 
+/* The XPT2046 needs 200ns per clock level, twice as much is waited whatever SystemCoreClock is.
+ * With the pin writes the clock is a bit below 1.25MHz
+ */
+#define TP_SPI_HALF_NS  400
+
+static uint32_t g_tp_spi_cycles = 72;   /* TP_SPI_HALF_NS in CPU cycles, set by tp_init */
+
+/**
+ * @brief  Half period of the SPI clock, timed with the DWT cycle counter
+ * @param  None
+ * @retval None
+ */
+static inline void tp_spi_delay(void)
+{
+    uint32_t t = DWT->CYCCNT;
+    
+    while ((DWT->CYCCNT - t) < g_tp_spi_cycles);
+}
+
 /**
  * @brief  SPI write data
  * @param  data: The data to be written
@@ -54,24 +76,18 @@ static void tp_write_byte(uint8_t data)
     
     for (count=0; count<8; count++)
     {
-        if (data & 0x80)    /* Send 1 */
-        {
-            T_MOSI(1);
-        }
-        else                /* Send 0 */
-        {
-            T_MOSI(0);
-        }
-        
+        T_MOSI(data & 0x80);
         data <<= 1;
         T_CLK(0);
-        delay_us(1);
+        tp_spi_delay();
         T_CLK(1);           /* Effective rising edge */
+        tp_spi_delay();
     }
 }
 
 /**
- * @brief  SPI read data
+ * @brief  SPI read data, T_CS must be low
+ * @note   The XPT2046 converts on the clocks that read the result, no waiting is needed
  * @param  cmd: directive
  * @retval the data read
  */
@@ -82,39 +98,35 @@ static uint16_t tp_read_ad(uint8_t cmd)
     
     T_CLK(0);                           /* Let's pull down the clock */
     T_MOSI(0);                          /* Pull down the data line */
-    T_CS(0);                            /* Select touch screen IC */
     tp_write_byte(cmd);                 /* Sending commands */
-    delay_us(6);                        /* The conversion time of ADS7846 is up to 6us */
     T_CLK(0);
-    delay_us(1);
+    tp_spi_delay();
     T_CLK(1);                           /* Give 1 clock, clear BUSY */
-    delay_us(1);
+    tp_spi_delay();
     T_CLK(0);
     
     for (count=0; count<16; count++)    /* Read out 16 bits of data, only the high 12 bits are valid */
     {
         num <<= 1;
         T_CLK(0);                       /* Effective falling edge */
-        delay_us(1);
+        tp_spi_delay();
         T_CLK(1);
-        if (T_MISO)
-        {
-            num++;
-        }
+        tp_spi_delay();
+        num |= T_MISO;
     }
     
     num >>= 4;                          /* Only the high 12 bits are valid */
-    T_CS(1);                            /* Release sheet selection */
     
     return num;
 }
 
 /* Resistance touch drive related parameter definition */
-#define TP_READ_TIMES   5   /* Number of reads */
-#define TP_LOST_VAL     1   /* Discarding values */
+#define TP_READ_TIMES   5   /* Number of reads, the smallest and the largest are discarded */
 
 /**
  * @brief Reads a coordinate value (x or y)
+ * @note  The samples are read in one burst (T_CS stays low). The first conversion after the
+ *        panel is switched to the other axis has not settled yet and is discarded
  * @param cmd: directive
  * @arg    0x90: Read X-axis coordinates (portrait state, landscape state and Y swapped)
  * @arg    0xD0: Read Y-axis coordinates (portrait, landscape and X swapped)
@@ -122,37 +134,27 @@ static uint16_t tp_read_ad(uint8_t cmd)
  */
 static uint16_t tp_read_xoy(uint8_t cmd)
 {
-    uint16_t i, j;
-    uint16_t buf[TP_READ_TIMES];
-    uint16_t sum = 0;
-    uint16_t temp;
-    
-    for (i=0; i<TP_READ_TIMES; i++)                             /* READ the data TP READ TIMES first */
-    {
-        buf[i] = tp_read_ad(cmd);
-    }
+    uint16_t i;
+    uint16_t val;
+    uint16_t min = 0xFFFF;
+    uint16_t max = 0;
+    uint32_t sum = 0;
     
-    for (i=0; i<(TP_READ_TIMES - 1); i++)                       /* Sort the data */
-    {
-        for (j=(i + 1); j<TP_READ_TIMES; j++)
-        {
-            if (buf[i] > buf[j])                                /* ascending sort */
-            {
-                temp = buf[i];
-                buf[i] = buf[j];
-                buf[j] = temp;
-            }
-        }
-    }
+    T_CS(0);                                                    /* Select touch screen IC */
+    tp_read_ad(cmd);                                            /* Settling conversion */
     
-    for (i=TP_LOST_VAL; i<(TP_READ_TIMES - TP_LOST_VAL); i++)   /* Discard values at both ends */
+    for (i=0; i<TP_READ_TIMES; i++)                             /* Sum the samples, keep the smallest and the largest */
     {
-        sum += buf[i];                                          /* Sum up the data after discarding the value */
+        val = tp_read_ad(cmd);
+        sum += val;
+        
+        if (val < min)min = val;
+        if (val > max)max = val;
     }
     
-    temp = sum / (TP_READ_TIMES - 2 * TP_LOST_VAL);             /* averaging */
+    T_CS(1);                                                    /* Release sheet selection */
     
-    return temp;
+    return (sum - min - max) / (TP_READ_TIMES - 2);             /* Average without the values at both ends */
 }
 
 /**
@@ -248,6 +250,86 @@ void tp_draw_big_point(uint16_t x, uint16_t y, uint16_t color)
     lcd_draw_point(x + 1, y + 1, color);
 }
 
+/* Smoothing of the strokes: the filtered point moves towards the read point by a/16 of the
+ * distance, a goes from TP_FILTER_MIN when the pen stands still to 16 (no smoothing) when it moved
+ * TP_FILTER_FAST pixels or more since the last scan. The jitter of a still pen is removed and a
+ * fast stroke does not lag behind
+ */
+#define TP_FILTER_MIN   4   /* a when the pen stands still, in 1/16 */
+#define TP_FILTER_FAST  16  /* Movement in pixels per scan that is followed without smoothing */
+
+static int32_t g_tp_fx;     /* Filtered point, 1/16 pixel */
+static int32_t g_tp_fy;
+static uint8_t g_tp_fvalid; /* 0: the previous point was outside the screen, the filter restarts */
+
+/**
+ * @brief  smooths the screen coordinates of a stroke
+ * @param  x: X, replaced by the filtered value
+ * @param  y: Y, replaced by the filtered value
+ * @param  start: 1, first point of the stroke (no filtering)
+ * @retval None
+ */
+static void tp_filter(uint16_t *x, uint16_t *y, uint8_t start)
+{
+    int32_t dx;
+    int32_t dy;
+    int32_t d;
+    int32_t a;
+    
+    if (start)
+    {
+        g_tp_fx = (int32_t)*x << 4;
+        g_tp_fy = (int32_t)*y << 4;
+        return;
+    }
+    
+    dx = ((int32_t)*x << 4) - g_tp_fx;
+    dy = ((int32_t)*y << 4) - g_tp_fy;
+    d = (abs(dx) > abs(dy) ? abs(dx) : abs(dy)) >> 4;                                                  /* Movement in pixels */
+    
+    if (d >= TP_FILTER_FAST)
+    {
+        a = 16;
+    }
+    else
+    {
+        a = TP_FILTER_MIN + (16 - TP_FILTER_MIN) * d / TP_FILTER_FAST;
+    }
+    
+    g_tp_fx += dx * a / 16;
+    g_tp_fy += dy * a / 16;
+    *x = (g_tp_fx + 8) >> 4;
+    *y = (g_tp_fy + 8) >> 4;
+}
+
+/**
+ * @brief  converts an AD value to a screen coordinate with the fixed-point calibration coefficient
+ * @param  adc: AD value
+ * @param  c: AD value of the center of the screen
+ * @param  k: 65536 / scaling factor
+ * @param  half: half of the screen width or height
+ * @retval screen coordinate, 0xFFFF when the point is outside the screen
+ */
+static uint16_t tp_adc_to_lcd(uint16_t adc, short c, int32_t k, uint16_t half)
+{
+    int32_t v;
+    
+    v = ((((int32_t)adc - c) * k + 0x8000) >> 16) + half;
+    
+    return (v < 0 || v >= 2 * half) ? 0xFFFF : v;
+}
+
+/**
+ * @brief  computes the fixed-point calibration coefficients from xfac/yfac
+ * @param  None
+ * @retval None
+ */
+static void tp_adjust_coef(void)
+{
+    tp_dev.xk = (tp_dev.xfac != 0) ? (int32_t)(65536.0f / tp_dev.xfac) : 0;
+    tp_dev.yk = (tp_dev.yfac != 0) ? (int32_t)(65536.0f / tp_dev.yfac) : 0;
+}
+
 /**
  * @brief  touch screen scanning
  * @param  mode: Coordinate mode
@@ -267,8 +349,20 @@ uint8_t tp_scan(uint8_t mode)
         }
         else if (tp_read_xy2(&tp_dev.x[0], &tp_dev.y[0]))                                               /* To read screen coordinates, conversion is required */
         {
-            tp_dev.x[0] = (signed short)(tp_dev.x[0] - tp_dev.xc) / tp_dev.xfac + lcddev.width / 2;     /* Convert X-axis physical coordinates to logical coordinates (corresponding to the X coordinate value on the LCD screen) */
-            tp_dev.y[0] = (signed short)(tp_dev.y[0] - tp_dev.yc) / tp_dev.yfac + lcddev.height / 2;    /* Convert X-axis physical coordinates to logical coordinates (corresponding to the Y coordinate value on the LCD screen) */
+            tp_dev.x[0] = tp_adc_to_lcd(tp_dev.x[0], tp_dev.xc, tp_dev.xk, lcddev.width / 2);          /* Convert X-axis physical coordinates to logical coordinates (corresponding to the X coordinate value on the LCD screen) */
+            tp_dev.y[0] = tp_adc_to_lcd(tp_dev.y[0], tp_dev.yc, tp_dev.yk, lcddev.height / 2);         /* Convert X-axis physical coordinates to logical coordinates (corresponding to the Y coordinate value on the LCD screen) */
+            
+            if (tp_dev.x[0] == 0xFFFF || tp_dev.y[0] == 0xFFFF)                                         /* Outside the screen (edge of the panel, bad calibration): no point */
+            {
+                tp_dev.x[0] = 0xFFFF;
+                tp_dev.y[0] = 0xFFFF;
+                g_tp_fvalid = 0;
+            }
+            else
+            {
+                tp_filter(&tp_dev.x[0], &tp_dev.y[0], (tp_dev.sta & TP_PRES_DOWN) == 0 || g_tp_fvalid == 0);  /* Smooth the stroke, a new press starts a new stroke */
+                g_tp_fvalid = 1;
+            }
         }
         
         if ((tp_dev.sta & TP_PRES_DOWN) == 0)                                                           /* It was not pressed before */
@@ -333,6 +427,7 @@ static uint8_t tp_get_adjust_data(void)
     temp = at24cxx_read_one_byte(TP_SAVE_ADDR_BASE + 12);   /* Read the calibration status marker */
     if (temp == 0x0A)
     {
+        tp_adjust_coef();
         return 1;
     }
     
@@ -467,6 +562,7 @@ void tp_adjust(void)
                     
                     tp_dev.xc = pxy[4][0];                                                                      /* X-axis, physical center coordinates */
                     tp_dev.yc = pxy[4][1];                                                                      /* Y-axis, physical center coordinates */
+                    tp_adjust_coef();                                                                           /* Fixed-point coefficients used by tp_scan */
                     
                     lcd_clear(WHITE);                                                                           /* Clear screen */
                     lcd_show_string(35, 110, lcddev.width, lcddev.height, 16, "Touch Screen Adjust OK!", BLUE); /* Correction completed */
@@ -567,6 +663,10 @@ uint8_t tp_init(void)
         gpio_init_struct.Speed = GPIO_SPEED_FREQ_HIGH;
         HAL_GPIO_Init(T_CLK_GPIO_PORT, &gpio_init_struct);
         
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;                                 /* The DWT cycle counter times the SPI clock */
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        g_tp_spi_cycles = (SystemCoreClock / 1000 * TP_SPI_HALF_NS + 999999) / 1000000;
+        
         tp_read_xy(&tp_dev.x[0], &tp_dev.y[0]);                                         /* First read initialization */
         at24cxx_init();                                                                 /* Initialize AT24CXX */
         
@@ -14,6 +14,7 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     pin access through BSRR/IDR, fixed-point calibration coefficients
  *
  ****************************************************************************************************
  */
@@ -44,20 +45,12 @@
 #define T_CLK_GPIO_CLK_ENABLE()         do{ __HAL_RCC_GPIOB_CLK_ENABLE(); }while(0)
 
 
-#define T_MOSI(x)                   do { (x) ?                                                                  \
-                                        HAL_GPIO_WritePin(T_MOSI_GPIO_PORT, T_MOSI_GPIO_PIN, GPIO_PIN_SET):     \
-                                        HAL_GPIO_WritePin(T_MOSI_GPIO_PORT, T_MOSI_GPIO_PIN, GPIO_PIN_RESET);   \
-                                    } while (0)
-#define T_CLK(x)                    do { (x) ?                                                                  \
-                                        HAL_GPIO_WritePin(T_CLK_GPIO_PORT, T_CLK_GPIO_PIN, GPIO_PIN_SET):       \
-                                        HAL_GPIO_WritePin(T_CLK_GPIO_PORT, T_CLK_GPIO_PIN, GPIO_PIN_RESET);     \
-                                    } while (0)
-#define T_CS(x)                     do { (x) ?                                                                  \
-                                        HAL_GPIO_WritePin(T_CS_GPIO_PORT, T_CS_GPIO_PIN, GPIO_PIN_SET):         \
-                                        HAL_GPIO_WritePin(T_CS_GPIO_PORT, T_CS_GPIO_PIN, GPIO_PIN_RESET);       \
-                                    } while (0)
-#define T_PEN                       ((HAL_GPIO_ReadPin(T_PEN_GPIO_PORT, T_PEN_GPIO_PIN) == GPIO_PIN_RESET) ? 0 : 1)
-#define T_MISO                      ((HAL_GPIO_ReadPin(T_MISO_GPIO_PORT, T_MISO_GPIO_PIN) == GPIO_PIN_RESET) ? 0 : 1)
+/* The SPI of the resistive touch controller is bit-banged, the pins are written through BSRR directly */
+#define T_MOSI(x)                   do { T_MOSI_GPIO_PORT->BSRR = (x) ? T_MOSI_GPIO_PIN : (uint32_t)T_MOSI_GPIO_PIN << 16; } while (0)
+#define T_CLK(x)                    do { T_CLK_GPIO_PORT->BSRR = (x) ? T_CLK_GPIO_PIN : (uint32_t)T_CLK_GPIO_PIN << 16; } while (0)
+#define T_CS(x)                     do { T_CS_GPIO_PORT->BSRR = (x) ? T_CS_GPIO_PIN : (uint32_t)T_CS_GPIO_PIN << 16; } while (0)
+#define T_PEN                       ((T_PEN_GPIO_PORT->IDR & T_PEN_GPIO_PIN) ? 1 : 0)
+#define T_MISO                      ((T_MISO_GPIO_PORT->IDR & T_MISO_GPIO_PIN) ? 1 : 0)
 
 /* Touch-related Definitions */
 #define TP_PRES_DOWN                0x8000  /* The touch screen is pressed */
@@ -92,6 +85,8 @@ typedef struct
                                  * b7:0: Resistance screen
                                  *    1: Capacitive touch screen
                                  */
+    int32_t xk;                 /* 65536 / xfac, computed from the calibration parameters so that tp_scan needs no float */
+    int32_t yk;                 /* 65536 / yfac */
 } _m_tp_dev;
 extern _m_tp_dev tp_dev;
 
@@ -0,0 +1,509 @@
+/**
+ ****************************************************************************************************
+ * @file        flashkv.c
+ * @author      ALIENTEK
+ * @brief       Key-value store on the internal flash
+ *
+ *              The values are appended as records to a log that spans FLASHKV_PAGE_NUM pages, so
+ *              changing a value programs a few half-words instead of erasing a page. The newest
+ *              record of a key is its value, the index in SRAM holds its address for each key.
+ *              When the active page is full the next page is opened, and the oldest page is
+ *              collected: its values that are still current are copied, then it is marked old and
+ *              will be erased when it is opened again. A page is erased once per turn of the log.
+ *
+ *              Power loss: the commit half-word of a record is programmed last, a record without it
+ *              (or with a wrong CRC) is ignored. A collection that was interrupted is finished by
+ *              flashkv_init, the copies are identical to the values of the oldest page.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include "flashkv.h"
+
+/* Page header: magic(2) | seq(2) | state(2) | reserved(2)
+ * The sequence numbers of the pages of the log follow each other, the highest one is the active page */
+#define FLASHKV_MAGIC           0X564B                      /* "KV" */
+#define FLASHKV_HEAD            8
+#define FLASHKV_STATE_USED      0XFFFF
+#define FLASHKV_STATE_OLD       0X0000                      /* The page was collected, it is free */
+
+/* Record: key(2) | len(2) | data (len bytes, padded to a half-word with 0XFF) | crc(2) | commit(2)
+ * The CRC (CRC-16/CCITT) covers key, len and data. A record with len 0 removes the key */
+#define FLASHKV_REC_SIZE(len)   (8 + (((uint32_t)(len) + 1) & ~1UL))
+#define FLASHKV_COMMIT          0X0000
+#define FLASHKV_ERASED          0XFFFF
+
+/* The current values must fit in one page to be collected, with room left for a record that was interrupted */
+#define FLASHKV_LIVE_MAX        (FLASHKV_PAGE_SIZE - FLASHKV_HEAD - FLASHKV_REC_SIZE(FLASHKV_DATA_MAX))
+
+#define FLASHKV_PAGE_ADDR(p)    (FLASHKV_BASE + (uint32_t)(p) * FLASHKV_PAGE_SIZE)
+#define FLASHKV_ACTIVE()        ((g_flashkv.first + g_flashkv.num - 1) % FLASHKV_PAGE_NUM)
+
+flashkv_t g_flashkv;
+
+/**
+ * @brief   CRC-16/CCITT of a half-word (low byte first)
+ * @param   crc : CRC so far
+ * @param   data: half-word
+ * @retval  new CRC
+ */
+static uint16_t flashkv_crc16(uint16_t crc, uint16_t data)
+{
+    uint8_t i, j;
+
+    for (j = 0; j < 2; j++)
+    {
+        crc ^= (data & 0XFF) << 8;
+        data >>= 8;
+
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0X8000) ? (crc << 1) ^ 0X1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * @brief   CRC of a record in flash
+ * @param   addr: record address
+ * @param   len : data length
+ * @retval  CRC of key, len and data
+ */
+static uint16_t flashkv_rec_crc(uint32_t addr, uint16_t len)
+{
+    uint32_t end = addr + FLASHKV_REC_SIZE(len) - 4;
+    uint16_t crc = 0XFFFF;
+
+    for (; addr < end; addr += 2)
+    {
+        crc = flashkv_crc16(crc, flashkv_port_read(addr));
+    }
+
+    return crc;
+}
+
+/**
+ * @brief   Programs a half-word and checks it
+ * @param   addr: address
+ * @param   data: half-word, 0XFFFF is left erased
+ * @retval  0, OK; 1, failed
+ */
+static uint8_t flashkv_program(uint32_t addr, uint16_t data)
+{
+    if (data != FLASHKV_ERASED && flashkv_port_program(addr, data))
+    {
+        return 1;
+    }
+
+    return flashkv_port_read(addr) != data;
+}
+
+/**
+ * @brief   Checks a page header
+ * @param   page: page number
+ * @retval  1, the page belongs to the log; 0, free
+ */
+static uint8_t flashkv_page_used(uint8_t page)
+{
+    uint32_t addr = FLASHKV_PAGE_ADDR(page);
+
+    return flashkv_port_read(addr) == FLASHKV_MAGIC && flashkv_port_read(addr + 4) == FLASHKV_STATE_USED;
+}
+
+/**
+ * @brief   Erases a page and writes its header
+ * @param   page: page number
+ * @param   seq : sequence number
+ * @retval  0, OK; 1, failed
+ */
+static uint8_t flashkv_page_open(uint8_t page, uint16_t seq)
+{
+    uint32_t addr = FLASHKV_PAGE_ADDR(page);
+
+    if (flashkv_port_erase(addr))return 1;
+
+    if (flashkv_program(addr + 2, seq))return 1;
+
+    return flashkv_program(addr, FLASHKV_MAGIC);    /* Last: a page with its magic has a sequence number */
+}
+
+/**
+ * @brief   Replays the records of a page into the index
+ * @param   page: page number
+ * @retval  None, g_flashkv.wr is set after the last record
+ */
+static void flashkv_page_scan(uint8_t page)
+{
+    uint32_t addr = FLASHKV_PAGE_ADDR(page) + FLASHKV_HEAD;
+    uint32_t end = FLASHKV_PAGE_ADDR(page) + FLASHKV_PAGE_SIZE;
+    uint32_t size;
+    uint16_t key, len;
+
+    while (addr + FLASHKV_REC_SIZE(0) <= end)
+    {
+        key = flashkv_port_read(addr);
+
+        if (key == FLASHKV_ERASED)break;    /* End of the log */
+
+        len = flashkv_port_read(addr + 2);
+        size = FLASHKV_REC_SIZE(len);
+
+        if (len > FLASHKV_DATA_MAX || addr + size > end)
+        {
+            addr += 4;                      /* Interrupted while the length was written, nothing follows it */
+            continue;
+        }
+
+        if (key < FLASHKV_KEY_MAX &&
+            flashkv_port_read(addr + size - 2) == FLASHKV_COMMIT &&
+            flashkv_port_read(addr + size - 4) == flashkv_rec_crc(addr, len))
+        {
+            g_flashkv.index[key] = len ? addr : 0;
+        }
+
+        addr += size;
+    }
+
+    g_flashkv.wr = addr;
+}
+
+/**
+ * @brief   Appends a record to the active page (there must be room for it)
+ * @param   key : key
+ * @param   data: data, NULL to copy it from the record at src
+ * @param   src : record to copy
+ * @param   len : data length, 0 removes the key
+ * @retval  FLASHKV_OK or FLASHKV_ERR_FLASH
+ */
+static uint8_t flashkv_append(uint16_t key, const uint8_t *data, uint32_t src, uint16_t len)
+{
+    uint32_t addr = g_flashkv.wr;
+    uint32_t size = FLASHKV_REC_SIZE(len);
+    uint16_t crc = 0XFFFF;
+    uint16_t hw;
+    uint16_t i;
+
+    g_flashkv.wr += size;   /* Even if it fails, a record that was started is never written again */
+
+    crc = flashkv_crc16(crc, key);
+    crc = flashkv_crc16(crc, len);
+
+    if (flashkv_program(addr, key) || flashkv_program(addr + 2, len))return FLASHKV_ERR_FLASH;
+
+    for (i = 0; i < len; i += 2)
+    {
+        if (data)
+        {
+            hw = data[i] | ((i + 1 < len ? data[i + 1] : 0XFF) << 8);
+        }
+        else
+        {
+            hw = flashkv_port_read(src + 4 + i);
+        }
+
+        crc = flashkv_crc16(crc, hw);
+
+        if (flashkv_program(addr + 4 + i, hw))return FLASHKV_ERR_FLASH;
+    }
+
+    if (flashkv_program(addr + size - 4, crc))return FLASHKV_ERR_FLASH;
+
+    if (flashkv_program(addr + size - 2, FLASHKV_COMMIT))return FLASHKV_ERR_FLASH;  /* The record is valid from here */
+
+    if (g_flashkv.index[key])
+    {
+        g_flashkv.live -= FLASHKV_REC_SIZE(flashkv_port_read(g_flashkv.index[key] + 2));
+    }
+
+    g_flashkv.index[key] = len ? addr : 0;
+
+    if (len)g_flashkv.live += size;
+
+    return FLASHKV_OK;
+}
+
+/**
+ * @brief   Copies the current values of the oldest page to the active page, then frees the oldest page
+ * @param   None
+ * @retval  FLASHKV_OK, FLASHKV_ERR_FULL or FLASHKV_ERR_FLASH
+ */
+static uint8_t flashkv_collect(void)
+{
+    uint32_t start = FLASHKV_PAGE_ADDR(g_flashkv.first);
+    uint32_t end = FLASHKV_PAGE_ADDR(FLASHKV_ACTIVE()) + FLASHKV_PAGE_SIZE;
+    uint32_t src;
+    uint16_t key, len;
+
+    for (key = 0; key < FLASHKV_KEY_MAX; key++)
+    {
+        src = g_flashkv.index[key];
+
+        if (src < start || src >= start + FLASHKV_PAGE_SIZE)continue;
+
+        len = flashkv_port_read(src + 2);
+
+        if (g_flashkv.wr + FLASHKV_REC_SIZE(len) > end)return FLASHKV_ERR_FULL;
+
+        if (flashkv_append(key, NULL, src, len))return FLASHKV_ERR_FLASH;
+    }
+
+    if (flashkv_program(start + 4, FLASHKV_STATE_OLD))return FLASHKV_ERR_FLASH;
+
+    g_flashkv.first = (g_flashkv.first + 1) % FLASHKV_PAGE_NUM;
+    g_flashkv.num--;
+    return FLASHKV_OK;
+}
+
+/**
+ * @brief   Opens the next page, collects the oldest page when no page is free any more
+ * @param   None
+ * @retval  FLASHKV_OK, FLASHKV_ERR_FULL or FLASHKV_ERR_FLASH
+ */
+static uint8_t flashkv_next_page(void)
+{
+    uint8_t page = (g_flashkv.first + g_flashkv.num) % FLASHKV_PAGE_NUM;
+
+    if (g_flashkv.num >= FLASHKV_PAGE_NUM)return FLASHKV_ERR_FULL;  /* A collection failed */
+
+    if (flashkv_page_open(page, g_flashkv.seq + 1))return FLASHKV_ERR_FLASH;
+
+    g_flashkv.seq++;
+    g_flashkv.num++;
+    g_flashkv.wr = FLASHKV_PAGE_ADDR(page) + FLASHKV_HEAD;
+
+    if (g_flashkv.num == FLASHKV_PAGE_NUM)
+    {
+        return flashkv_collect();
+    }
+
+    return FLASHKV_OK;
+}
+
+/**
+ * @brief   Appends a record, opening new pages as needed
+ * @param   key : key
+ * @param   data: data
+ * @param   len : data length, 0 removes the key
+ * @retval  FLASHKV_OK, FLASHKV_ERR_FULL or FLASHKV_ERR_FLASH
+ */
+static uint8_t flashkv_write(uint16_t key, const uint8_t *data, uint16_t len)
+{
+    uint8_t i;
+    uint8_t res;
+
+    for (i = 0; g_flashkv.wr + FLASHKV_REC_SIZE(len) > FLASHKV_PAGE_ADDR(FLASHKV_ACTIVE()) + FLASHKV_PAGE_SIZE; i++)
+    {
+        if (i == FLASHKV_PAGE_NUM)return FLASHKV_ERR_FULL;
+
+        res = flashkv_next_page();
+
+        if (res)return res;
+    }
+
+    return flashkv_append(key, data, 0, len);
+}
+
+/**
+ * @brief   Erases all the values
+ * @param   None
+ * @retval  FLASHKV_OK or FLASHKV_ERR_FLASH
+ */
+uint8_t flashkv_format(void)
+{
+    uint8_t page;
+    uint16_t key;
+
+    for (key = 0; key < FLASHKV_KEY_MAX; key++)
+    {
+        g_flashkv.index[key] = 0;
+    }
+
+    for (page = 1; page < FLASHKV_PAGE_NUM; page++)
+    {
+        if (flashkv_port_erase(FLASHKV_PAGE_ADDR(page)))return FLASHKV_ERR_FLASH;
+    }
+
+    g_flashkv.seq = 0;
+    g_flashkv.first = 0;
+    g_flashkv.num = 1;
+    g_flashkv.live = 0;
+    g_flashkv.wr = FLASHKV_PAGE_ADDR(0) + FLASHKV_HEAD;
+    return flashkv_page_open(0, 0) ? FLASHKV_ERR_FLASH : FLASHKV_OK;
+}
+
+/**
+ * @brief   Rebuilds the index from flash, formats the store if there is none
+ * @param   None
+ * @retval  FLASHKV_OK, FLASHKV_ERR_FULL or FLASHKV_ERR_FLASH
+ */
+uint8_t flashkv_init(void)
+{
+    uint8_t page;
+    uint8_t newest = 0XFF;
+    uint16_t seq;
+    uint16_t key;
+
+    for (page = 0; page < FLASHKV_PAGE_NUM; page++)
+    {
+        if (flashkv_page_used(page) == 0)continue;
+
+        seq = flashkv_port_read(FLASHKV_PAGE_ADDR(page) + 2);
+
+        if (newest == 0XFF || (int16_t)(seq - g_flashkv.seq) > 0)
+        {
+            newest = page;
+            g_flashkv.seq = seq;
+        }
+    }
+
+    if (newest == 0XFF)
+    {
+        return flashkv_format();
+    }
+
+    /* The log: the newest page and the pages before it with the previous sequence numbers */
+    g_flashkv.first = newest;
+    g_flashkv.num = 1;
+    seq = g_flashkv.seq;
+
+    while (g_flashkv.num < FLASHKV_PAGE_NUM)
+    {
+        page = (g_flashkv.first + FLASHKV_PAGE_NUM - 1) % FLASHKV_PAGE_NUM;
+
+        if (flashkv_page_used(page) == 0 || flashkv_port_read(FLASHKV_PAGE_ADDR(page) + 2) != (uint16_t)(seq - 1))break;
+
+        g_flashkv.first = page;
+        g_flashkv.num++;
+        seq--;
+    }
+
+    for (key = 0; key < FLASHKV_KEY_MAX; key++)
+    {
+        g_flashkv.index[key] = 0;
+    }
+
+    for (page = 0; page < g_flashkv.num; page++)    /* Oldest first, the newest record of a key is kept */
+    {
+        flashkv_page_scan((g_flashkv.first + page) % FLASHKV_PAGE_NUM);
+    }
+
+    g_flashkv.live = 0;
+
+    for (key = 0; key < FLASHKV_KEY_MAX; key++)
+    {
+        if (g_flashkv.index[key])
+        {
+            g_flashkv.live += FLASHKV_REC_SIZE(flashkv_port_read(g_flashkv.index[key] + 2));
+        }
+    }
+
+    if (g_flashkv.num == FLASHKV_PAGE_NUM)  /* Power was lost while the oldest page was collected */
+    {
+        return flashkv_collect();
+    }
+
+    return FLASHKV_OK;
+}
+
+/**
+ * @brief   Stores a value
+ * @note    Nothing is written when the value is already stored
+ * @param   key : key, 0 ~ FLASHKV_KEY_MAX - 1
+ * @param   data: data
+ * @param   len : data length, 1 ~ FLASHKV_DATA_MAX
+ * @retval  FLASHKV_OK, FLASHKV_ERR_PARAM, FLASHKV_ERR_FULL or FLASHKV_ERR_FLASH
+ */
+uint8_t flashkv_set(uint16_t key, const void *data, uint16_t len)
+{
+    const uint8_t *p = data;
+    uint32_t old;
+    uint32_t live;
+    uint16_t i;
+
+    if (key >= FLASHKV_KEY_MAX || len == 0 || len > FLASHKV_DATA_MAX)return FLASHKV_ERR_PARAM;
+
+    old = g_flashkv.index[key];
+    live = g_flashkv.live + FLASHKV_REC_SIZE(len);
+
+    if (old)
+    {
+        live -= FLASHKV_REC_SIZE(flashkv_port_read(old + 2));
+
+        if (flashkv_port_read(old + 2) == len)
+        {
+            for (i = 0; i < len; i++)
+            {
+                if (((flashkv_port_read(old + 4 + (i & ~1)) >> ((i & 1) * 8)) & 0XFF) != p[i])break;
+            }
+
+            if (i == len)return FLASHKV_OK;
+        }
+    }
+
+    if (live > FLASHKV_LIVE_MAX)return FLASHKV_ERR_FULL;
+
+    return flashkv_write(key, p, len);
+}
+
+/**
+ * @brief   Reads a value
+ * @param   key : key
+ * @param   buf : buffer
+ * @param   size: buffer size, a longer value is truncated
+ * @param   len : returns the value length, can be NULL
+ * @retval  FLASHKV_OK, FLASHKV_ERR_PARAM or FLASHKV_ERR_NOKEY
+ */
+uint8_t flashkv_get(uint16_t key, void *buf, uint16_t size, uint16_t *len)
+{
+    uint8_t *p = buf;
+    uint32_t addr;
+    uint16_t n;
+    uint16_t i;
+
+    if (key >= FLASHKV_KEY_MAX)return FLASHKV_ERR_PARAM;
+
+    addr = g_flashkv.index[key];
+
+    if (addr == 0)return FLASHKV_ERR_NOKEY;
+
+    n = flashkv_port_read(addr + 2);
+
+    if (len)*len = n;
+
+    if (n > size)n = size;
+
+    for (i = 0; i < n; i++)
+    {
+        p[i] = flashkv_port_read(addr + 4 + (i & ~1)) >> ((i & 1) * 8);
+    }
+
+    return FLASHKV_OK;
+}
+
+/**
+ * @brief   Removes a value
+ * @param   key: key
+ * @retval  FLASHKV_OK, FLASHKV_ERR_PARAM, FLASHKV_ERR_NOKEY, FLASHKV_ERR_FULL or FLASHKV_ERR_FLASH
+ */
+uint8_t flashkv_del(uint16_t key)
+{
+    if (key >= FLASHKV_KEY_MAX)return FLASHKV_ERR_PARAM;
+
+    if (g_flashkv.index[key] == 0)return FLASHKV_ERR_NOKEY;
+
+    return flashkv_write(key, NULL, 0);
+}
@@ -0,0 +1,66 @@
+/**
+ ****************************************************************************************************
+ * @file        flashkv.h
+ * @author      ALIENTEK
+ * @brief       Key-value store on the internal flash
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __FLASHKV_H
+#define __FLASHKV_H
+
+#include "main.h"
+
+
+/* Flash area used by the store: the last FLASHKV_PAGE_NUM pages of bank 1 */
+#define FLASHKV_PAGE_SIZE       FLASH_PAGE_SIZE
+#define FLASHKV_PAGE_NUM        2                           /* At least 2 */
+#define FLASHKV_BASE            (FLASH_BANK1_END + 1 - FLASHKV_PAGE_NUM * FLASHKV_PAGE_SIZE)
+
+#define FLASHKV_KEY_MAX         32                          /* Keys are 0 ~ FLASHKV_KEY_MAX - 1 */
+#define FLASHKV_DATA_MAX        256                         /* Maximum value length in bytes */
+
+/* Return values */
+#define FLASHKV_OK              0
+#define FLASHKV_ERR_PARAM       1                           /* Invalid key or length */
+#define FLASHKV_ERR_FULL        2                           /* The values do not fit in one page any more */
+#define FLASHKV_ERR_FLASH       3                           /* Erase or program failed */
+#define FLASHKV_ERR_NOKEY       4                           /* The key has no value */
+
+/* Store state, kept in SRAM and rebuilt from flash by flashkv_init */
+typedef struct
+{
+    uint32_t index[FLASHKV_KEY_MAX];    /* Address of the latest record of each key, 0: no value */
+    uint32_t wr;                        /* Next free address in the active page */
+    uint32_t live;                      /* Bytes of flash used by the latest records */
+    uint16_t seq;                       /* Sequence number of the active page */
+    uint8_t first;                      /* Oldest page of the log */
+    uint8_t num;                        /* Number of pages in the log, the newest one is active */
+} flashkv_t;
+
+extern flashkv_t g_flashkv;
+
+uint8_t flashkv_init(void);                                             /* Rebuilds the index, formats the store if there is none */
+uint8_t flashkv_format(void);                                           /* Erases all the values */
+uint8_t flashkv_set(uint16_t key, const void *data, uint16_t len);      /* Stores a value */
+uint8_t flashkv_get(uint16_t key, void *buf, uint16_t size, uint16_t *len);   /* Reads a value */
+uint8_t flashkv_del(uint16_t key);                                      /* Removes a value */
+
+/* Flash access, flashkv_port.c (a host build links a simulated flash instead) */
+uint16_t flashkv_port_read(uint32_t addr);                              /* Reads a half-word */
+uint8_t flashkv_port_program(uint32_t addr, uint16_t data);             /* Programs an erased half-word, 0: OK */
+uint8_t flashkv_port_erase(uint32_t addr);                              /* Erases a page, 0: OK */
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ ****************************************************************************************************
+ * @file        flashkv_port.c
+ * @author      ALIENTEK
+ * @brief       Flash access of the key-value store
+ *
+ *              Everything flashkv.c does with the flash goes through these three functions. To run
+ *              the store on a PC, build flashkv.c with a file that implements them on a buffer
+ *              instead (erased to 0XFF, a half-word can only be programmed when it is 0XFFFF).
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include "flashkv.h"
+#include "../../BSP/STMFLASH/stmflash.h"
+
+/**
+ * @brief   Reads a half-word
+ * @param   addr: address
+ * @retval  half-word
+ */
+uint16_t flashkv_port_read(uint32_t addr)
+{
+    return *(volatile uint16_t *)addr;
+}
+
+/**
+ * @brief   Programs an erased half-word
+ * @param   addr: address
+ * @param   data: half-word
+ * @retval  0, OK; 1, failed
+ */
+uint8_t flashkv_port_program(uint32_t addr, uint16_t data)
+{
+    HAL_StatusTypeDef ret;
+
+    HAL_FLASH_Unlock();
+    ret = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, addr, data);
+    HAL_FLASH_Lock();
+    g_stmflash_cnt.program++;
+
+    return ret != HAL_OK;
+}
+
+/**
+ * @brief   Erases a page
+ * @param   addr: page address
+ * @retval  0, OK; 1, failed
+ */
+uint8_t flashkv_port_erase(uint32_t addr)
+{
+    FLASH_EraseInitTypeDef flash_erase_init_struct = {0};
+    HAL_StatusTypeDef ret;
+    uint32_t pageerr;
+
+    flash_erase_init_struct.TypeErase = FLASH_TYPEERASE_PAGES;
+    flash_erase_init_struct.Banks = FLASH_BANK_1;
+    flash_erase_init_struct.PageAddress = addr;
+    flash_erase_init_struct.NbPages = 1;
+
+    HAL_FLASH_Unlock();
+    ret = HAL_FLASHEx_Erase(&flash_erase_init_struct, &pageerr);
+    HAL_FLASH_Lock();
+    g_stmflash_cnt.erase++;
+
+    return ret != HAL_OK;
+}
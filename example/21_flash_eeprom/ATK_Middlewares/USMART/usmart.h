@@ -26,6 +26,9 @@
  * change logs	:
  * version		data		notes
  * V1.0			20240222	the first version
+ * V1.1			20261019	function table is parsed once into descriptors and looked up by name hash,
+ *							several commands separated by USMART_CMD_SEP can be executed in one line
+ * V1.2			20261019	add the profiling commands prof/psample/pstop (see usmart_prof.c)
  *
  ****************************************************************************************************
  */
@@ -49,6 +52,8 @@
 #define SP_TYPE_DEC             0       /* Decimal parameter display */
 #define SP_TYPE_HEX             1       /* Hexadecimal parameter display */
 
+#define USMART_FDESC_END        0XFF    /* End of a hash bucket chain */
+
 
 /* Function name list */
 struct _m_usmart_nametab
@@ -57,6 +62,15 @@ struct _m_usmart_nametab
     const char *name;       /* Function name (lookup string) */
 };
 
+/* Function descriptor, parsed once from the lookup string of usmart_nametab */
+struct _m_usmart_fdesc
+{
+    uint32_t hash;          /* Hash value of the function name */
+    uint8_t pnum;           /* Number of parameters */
+    uint8_t rval;           /* Return value: 0, void; 1, need to display */
+    uint8_t next;           /* Next function in the same hash bucket, USMART_FDESC_END is the end */
+};
+
 /* usmart Control Manager */
 struct _m_usmart_dev
 {
@@ -79,11 +93,15 @@ struct _m_usmart_dev
 
 extern struct _m_usmart_nametab usmart_nametab[];   /* Define in usmart_config.c */
 extern struct _m_usmart_dev usmart_dev;             /* Define in usmart_config.c */
+extern struct _m_usmart_fdesc usmart_fdesc[];       /* Define in usmart_config.c */
 
 
 void usmart_init(uint16_t tclk);        			/* Initialize */
+uint8_t usmart_fdesc_init(void);        			/* Parse the function table into descriptors */
 uint8_t usmart_cmd_rec(char *str);    				/* Identify */
 void usmart_exe(void);                  			/* Execute */
+uint32_t usmart_call(void *func, uint8_t pnum, uint32_t *temp);	/* Call a function with pnum parameters */
+void usmart_load_parm(uint8_t *parm, uint32_t *temp);	/* Convert the received parameters into parameter values */
 void usmart_scan(void);                 			/* Scan */
 uint32_t read_addr(uint32_t addr);      			/* Reads the value of the specified address */
 void write_addr(uint32_t addr,uint32_t val);		/* Writes the specified value to the specified address */
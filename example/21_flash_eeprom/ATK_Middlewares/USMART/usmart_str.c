@@ -96,6 +96,25 @@ uint8_t usmart_strlen(char *str)
     return len;
 }
 
+/**
+* @brief 	Computes the hash value of a string (32 bit FNV-1a)
+* @param 	str: string pointer
+* @retval 	The hash value of the string
+*/
+uint32_t usmart_strhash(char *str)
+{
+    uint32_t hash = 2166136261UL;   /* FNV offset basis */
+
+    while (*str != '\0')
+    {
+        hash ^= (uint8_t)*str;
+        hash *= 16777619UL;         /* FNV prime */
+        str++;
+    }
+
+    return hash;
+}
+
 /**
 * @brief 	Squared function, m^n
 * @param 	m: base number
@@ -14,6 +14,8 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     add g_stmflash_cnt
+ * V1.2         20261019     the write functions return an error, add g_stmflash_cnt.error
  *
  ****************************************************************************************************
  */
@@ -24,10 +26,21 @@
 #include "main.h"
 
 
+/* Erase/program counters, they are never cleared by the driver */
+typedef struct
+{
+    uint32_t erase;         /* Number of pages erased */
+    uint32_t program;       /* Number of half-words programmed */
+    uint32_t skip;          /* Number of page writes skipped, the data was already in flash */
+    uint32_t error;         /* Half-words that did not read back after programming, and failed erases */
+} stmflash_cnt_t;
+
+extern stmflash_cnt_t g_stmflash_cnt;
+
 uint32_t stmflash_read_word(uint32_t addr);
 void stmflash_read(uint32_t addr, uint32_t *buf, uint32_t length);
-void stmflash_write_nocheck(uint32_t addr, uint32_t *buf, uint16_t length);
-void stmflash_write(uint32_t addr, uint32_t *buf, uint16_t length);
+uint8_t stmflash_write_nocheck(uint32_t addr, uint32_t *buf, uint16_t length);
+uint8_t stmflash_write(uint32_t addr, uint32_t *buf, uint16_t length);
 void test_write(uint32_t waddr, uint16_t wdata);
 
 #endif
@@ -32,6 +32,7 @@
 #include "../../BSP/KEY/key.h"
 #include "../../BSP/LCD/lcd.h"
 #include "../../BSP/STMFLASH/stmflash.h"
+#include "../../ATK_Middlewares/FLASHKV/flashkv.h"
 #include "../../ATK_Middlewares/USMART/usmart.h"
 /* USER CODE END Includes */
 
@@ -41,6 +42,10 @@
 static const uint8_t g_text_buf[] = {"STM32 FLASH TEST"};
 #define TEXT_SIZE (((sizeof(g_text_buf) >> 2) << 2) + 4)
 
+/* Keys of the values kept in the flash key-value store */
+#define KV_KEY_TEXT     0
+#define KV_KEY_COUNT    1       /* Number of writes */
+
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
@@ -83,6 +88,7 @@ int main(void)
 	uint8_t data[TEXT_SIZE];
 	uint8_t wdata[TEXT_SIZE] = {0};
     uint8_t index;
+    uint32_t count = 0;
 
   /* USER CODE END 1 */
 
@@ -121,6 +127,13 @@ int main(void)
      wdata[index] = g_text_buf[index];
   }
 
+  if (flashkv_init() != FLASHKV_OK)
+  {
+      lcd_show_string(30, 130, 200, 16, 16, "Flash KV Error!", RED);
+  }
+
+  flashkv_get(KV_KEY_COUNT, &count, sizeof(count), NULL);
+
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -134,16 +147,34 @@ int main(void)
 		    /* Writing data to Flash */
 		    lcd_fill(0, 130, 239, 319, WHITE);
 		    lcd_show_string(30, 130, 200, 16, 16, "Start Write Flash....", BLUE);
-		    stmflash_write(FLASH_BANK1_END + 1 - TEXT_SIZE, (uint32_t *)wdata, TEXT_SIZE / sizeof(uint32_t));
-		    lcd_show_string(30, 130, 200, 16, 16, "Flash Write Finished!", BLUE);
+		    count++;
+		    if (flashkv_set(KV_KEY_TEXT, wdata, sizeof(g_text_buf)) == FLASHKV_OK &&
+		        flashkv_set(KV_KEY_COUNT, &count, sizeof(count)) == FLASHKV_OK)
+		    {
+		        lcd_show_string(30, 130, 200, 16, 16, "Flash Write Finished!", BLUE);
+		    }
+		    else
+		    {
+		        lcd_show_string(30, 130, 200, 16, 16, "Flash Write Failed!  ", RED);
+		    }
+		    /* The values are appended to a log, a page is only erased when the log moves to the next page */
+		    lcd_show_string(30, 170, 200, 16, 16, "Write:      Erase:", BLUE);
+		    lcd_show_num(78, 170, count, 5, 16, BLUE);
+		    lcd_show_num(174, 170, g_stmflash_cnt.erase, 5, 16, BLUE);
 		}
 		else if (key == KEY0_PRES)
 		{
 		    /* Read data from Flash */
 		    lcd_show_string(30, 130, 200, 16, 16, "Start Read Flash.... ", BLUE);
-		    stmflash_read(FLASH_BANK1_END + 1 - TEXT_SIZE, (uint32_t *)data, TEXT_SIZE / sizeof(uint32_t));
-		    lcd_show_string(30, 130, 200, 16, 16, "The Data Readed Is:  ", BLUE);
-		    lcd_show_string(30, 150, 200, 16, 16, (char *)data, BLUE);
+		    if (flashkv_get(KV_KEY_TEXT, data, sizeof(data), NULL) == FLASHKV_OK)
+		    {
+		        lcd_show_string(30, 130, 200, 16, 16, "The Data Readed Is:  ", BLUE);
+		        lcd_show_string(30, 150, 200, 16, 16, (char *)data, BLUE);
+		    }
+		    else
+		    {
+		        lcd_show_string(30, 130, 200, 16, 16, "No Data In Flash!    ", BLUE);
+		    }
 		}
 		if (++t == 20)
 		{
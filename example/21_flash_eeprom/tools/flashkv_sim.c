@@ -0,0 +1,369 @@
+/**
+ ****************************************************************************************************
+ * @file        flashkv_sim.c
+ * @author      ALIENTEK
+ * @brief       flashkv.c on a Linux host, on a simulated flash
+ *
+ *              The three functions of flashkv_port.c work on a buffer with the rules of the STM32F1 flash:
+ *              a page is erased to 0XFFFF, a half-word can only be programmed when it is erased (or to
+ *              0X0000), otherwise the program fails like with PGERR and the violation is counted.
+ *              The erases of each page are counted.
+ *
+ *              A random workload of sets, unchanged sets and deletes runs against a reference copy of the
+ *              values, with a reset (flashkv_init) every 100 operations. Then the power is cut at random
+ *              flash operations: the half-word being programmed keeps part of its bits, the page being
+ *              erased keeps part of its half-words. After each cut flashkv_init must find every value,
+ *              the one being changed either old or new.
+ *              The report gives the erases of each page, the sets per erase and the sets that the store
+ *              lasts with pages rated for 10000 erase cycles.
+ *
+ *              Build, from example/21_flash_eeprom:
+ *              gcc -O2 -Wall -Itools/host tools/flashkv_sim.c ATK_Middlewares/FLASHKV/flashkv.c -o flashkv_sim
+ *              Run:
+ *              ./flashkv_sim [-n operations] [-c power cuts] [-k keys] [-l max length] [-s seed]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../ATK_Middlewares/FLASHKV/flashkv.h"
+
+#define SIM_HW_NUM          (FLASHKV_PAGE_NUM * FLASHKV_PAGE_SIZE / 2)
+#define SIM_CYCLES          10000       /* Erase cycles of a page (STM32F103 datasheet, minimum) */
+
+/* Room for the values, as FLASHKV_LIVE_MAX in flashkv.c: a set past it returns FLASHKV_ERR_FULL */
+#define SIM_REC_SIZE(len)   (8 + (((uint32_t)(len) + 1) & ~1UL))
+#define SIM_LIVE_MAX        (FLASHKV_PAGE_SIZE - 8 - SIM_REC_SIZE(FLASHKV_DATA_MAX))
+
+static uint16_t g_sim_flash[SIM_HW_NUM];
+static uint32_t g_sim_erases[FLASHKV_PAGE_NUM];
+static uint32_t g_sim_programs = 0;
+static uint32_t g_sim_violations = 0;   /* Programs of a half-word that was not erased */
+static uint32_t g_sim_ops = 0;          /* Flash operations (program and erase) */
+static uint32_t g_sim_cut = 0;          /* Operation at which the power is cut, 0: none */
+static jmp_buf g_sim_jmp;
+
+/* Reference copy of the values */
+static int16_t g_ref_len[FLASHKV_KEY_MAX];          /* -1: no value */
+static uint8_t g_ref_data[FLASHKV_KEY_MAX][FLASHKV_DATA_MAX];
+
+/* Operation in progress, for the check after a power cut */
+static int g_op_key = -1;
+static int16_t g_op_len;
+static uint8_t g_op_data[FLASHKV_DATA_MAX];
+
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+/******************************************************************************************/
+/* flashkv_port.c of the host */
+
+/**
+ * @brief   Half-word of the simulated flash at an address of the store
+ * @param   addr: address
+ * @retval  index in g_sim_flash
+ */
+static uint32_t sim_index(uint32_t addr)
+{
+    if (addr < FLASHKV_BASE || addr >= FLASHKV_BASE + FLASHKV_PAGE_NUM * FLASHKV_PAGE_SIZE || (addr & 1))
+    {
+        printf("FAIL: access at 0X%08X, out of the store\n", (unsigned)addr);
+        exit(1);
+    }
+
+    return (addr - FLASHKV_BASE) / 2;
+}
+
+/**
+ * @brief   Counts a flash operation, cuts the power when its turn comes
+ * @param   None
+ * @retval  1, the power is cut during this operation
+ */
+static uint8_t sim_power_cut(void)
+{
+    return ++g_sim_ops == g_sim_cut;
+}
+
+uint16_t flashkv_port_read(uint32_t addr)
+{
+    return g_sim_flash[sim_index(addr)];
+}
+
+uint8_t flashkv_port_program(uint32_t addr, uint16_t data)
+{
+    uint32_t i = sim_index(addr);
+
+    if (sim_power_cut())
+    {
+        g_sim_flash[i] &= data | (uint16_t)rand();  /* Some of the bits to clear are cleared */
+        longjmp(g_sim_jmp, 1);
+    }
+
+    if (g_sim_flash[i] != 0XFFFF && data != 0X0000)
+    {
+        g_sim_violations++;
+        printf("FAIL: program 0X%04X at 0X%08X, not erased (0X%04X)\n", data, (unsigned)addr, g_sim_flash[i]);
+        return 1;
+    }
+
+    g_sim_flash[i] &= data;
+    g_sim_programs++;
+    return 0;
+}
+
+uint8_t flashkv_port_erase(uint32_t addr)
+{
+    uint32_t i = sim_index(addr);
+    uint32_t n;
+
+    CHECK((addr - FLASHKV_BASE) % FLASHKV_PAGE_SIZE == 0, "erase at 0X%08X, not a page", (unsigned)addr);
+    g_sim_erases[i * 2 / FLASHKV_PAGE_SIZE]++;
+
+    if (sim_power_cut())
+    {
+        for (n = 0; n < FLASHKV_PAGE_SIZE / 2; n++)
+        {
+            if (rand() & 1)g_sim_flash[i + n] = 0XFFFF;
+        }
+
+        longjmp(g_sim_jmp, 1);
+    }
+
+    for (n = 0; n < FLASHKV_PAGE_SIZE / 2; n++)
+    {
+        g_sim_flash[i + n] = 0XFFFF;
+    }
+
+    return 0;
+}
+
+/******************************************************************************************/
+
+/**
+ * @brief   Bytes of flash used by the values of the reference copy
+ * @param   None
+ * @retval  bytes
+ */
+static uint32_t ref_live(void)
+{
+    uint32_t live = 0;
+    uint16_t key;
+
+    for (key = 0; key < FLASHKV_KEY_MAX; key++)
+    {
+        if (g_ref_len[key] >= 0)live += SIM_REC_SIZE(g_ref_len[key]);
+    }
+
+    return live;
+}
+
+/**
+ * @brief   Compares a key of the store with a value
+ * @param   key : key
+ * @param   len : value length, -1: no value
+ * @param   data: value
+ * @retval  1, same
+ */
+static int kv_equal(uint16_t key, int16_t len, const uint8_t *data)
+{
+    uint8_t buf[FLASHKV_DATA_MAX];
+    uint16_t n = 0;
+    uint8_t res;
+
+    res = flashkv_get(key, buf, sizeof(buf), &n);
+
+    if (len < 0)return res == FLASHKV_ERR_NOKEY;
+
+    return res == FLASHKV_OK && n == len && memcmp(buf, data, len) == 0;
+}
+
+/**
+ * @brief   Resets the store (flashkv_init) and compares all the keys with the reference copy
+ * @note    After a power cut, the key being changed may hold its old or its new value
+ * @param   where: for the messages
+ * @retval  None
+ */
+static void kv_reset_check(const char *where)
+{
+    uint16_t key;
+    uint8_t res;
+
+    memset(&g_flashkv, 0X5A, sizeof(g_flashkv));
+    res = flashkv_init();
+    CHECK(res == FLASHKV_OK, "%s: flashkv_init returns %u", where, res);
+
+    for (key = 0; key < FLASHKV_KEY_MAX; key++)
+    {
+        if (key == g_op_key && kv_equal(key, g_op_len, g_op_data))
+        {
+            g_ref_len[key] = g_op_len;      /* The change was committed */
+            memcpy(g_ref_data[key], g_op_data, g_op_len > 0 ? g_op_len : 0);
+            continue;
+        }
+
+        CHECK(kv_equal(key, g_ref_len[key], g_ref_data[key]), "%s: key %u differs", where, key);
+    }
+
+    g_op_key = -1;
+}
+
+/**
+ * @brief   One random operation: a set, a set of the same value or a delete
+ * @param   keys  : keys used
+ * @param   maxlen: maximum value length
+ * @param   stat  : sets, unchanged sets, deletes
+ * @retval  None
+ */
+static void kv_random_op(uint16_t keys, uint16_t maxlen, uint32_t stat[3])
+{
+    uint16_t key = rand() % keys;
+    uint32_t programs = g_sim_programs;
+    uint32_t live;
+    uint16_t i;
+    uint8_t res;
+    int r = rand() % 10;
+
+    g_op_key = key;
+
+    if (r == 0)                                 /* Delete */
+    {
+        g_op_len = -1;
+        res = flashkv_del(key);
+        CHECK(res == (g_ref_len[key] < 0 ? FLASHKV_ERR_NOKEY : FLASHKV_OK), "del %u returns %u", key, res);
+        stat[2]++;
+    }
+    else if (r == 1 && g_ref_len[key] > 0)      /* Same value: nothing is written */
+    {
+        g_op_len = g_ref_len[key];
+        memcpy(g_op_data, g_ref_data[key], g_op_len);
+        res = flashkv_set(key, g_op_data, g_op_len);
+        CHECK(res == FLASHKV_OK && g_sim_programs == programs, "set %u to its value: returns %u, %u programs",
+              key, res, g_sim_programs - programs);
+        stat[1]++;
+    }
+    else
+    {
+        g_op_len = 1 + rand() % maxlen;
+
+        for (i = 0; i < g_op_len; i++)g_op_data[i] = rand();
+
+        live = ref_live() + SIM_REC_SIZE(g_op_len) - (g_ref_len[key] >= 0 ? SIM_REC_SIZE(g_ref_len[key]) : 0);
+        res = flashkv_set(key, g_op_data, g_op_len);
+
+        if (live > SIM_LIVE_MAX)
+        {
+            CHECK(res == FLASHKV_ERR_FULL, "set %u (%u bytes) past the room: returns %u", key, g_op_len, res);
+            g_op_key = -1;
+            return;
+        }
+
+        CHECK(res == FLASHKV_OK, "set %u (%u bytes) returns %u", key, g_op_len, res);
+        stat[0]++;
+    }
+
+    g_ref_len[key] = g_op_len;
+    memcpy(g_ref_data[key], g_op_data, g_op_len > 0 ? g_op_len : 0);
+    CHECK(kv_equal(key, g_ref_len[key], g_ref_data[key]), "key %u differs after the operation", key);
+    g_op_key = -1;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = 100000, cuts = 2000, stat[3] = {0}, i, total = 0, max = 0;
+    uint16_t keys = 16, maxlen = 32;
+    static uint32_t c;
+    int opt;
+
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "n:c:k:l:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 'c': cuts = atoi(optarg); break;
+            case 'k': keys = atoi(optarg); break;
+            case 'l': maxlen = atoi(optarg); break;
+            case 's': srand(atoi(optarg)); break;
+            default:
+                fprintf(stderr, "usage: %s [-n operations] [-c power cuts] [-k keys] [-l max length] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (keys < 1 || keys > FLASHKV_KEY_MAX || maxlen < 1 || maxlen > FLASHKV_DATA_MAX)
+    {
+        fprintf(stderr, "keys 1 ~ %u, max length 1 ~ %u\n", FLASHKV_KEY_MAX, FLASHKV_DATA_MAX);
+        return 2;
+    }
+
+    for (i = 0; i < SIM_HW_NUM; i++)g_sim_flash[i] = rand();    /* Never erased: flashkv_init formats it */
+
+    for (i = 0; i < FLASHKV_KEY_MAX; i++)g_ref_len[i] = -1;
+
+    kv_reset_check("first power-up");
+
+    for (i = 0; i < n; i++)
+    {
+        kv_random_op(keys, maxlen, stat);
+
+        if (i % 100 == 99)kv_reset_check("reset");
+    }
+
+    for (i = 0; i < FLASHKV_PAGE_NUM; i++)
+    {
+        total += g_sim_erases[i];
+
+        if (g_sim_erases[i] > max)max = g_sim_erases[i];
+    }
+
+    printf("%u operations (%u sets, %u unchanged sets, %u deletes), %u keys of 1 ~ %u bytes\n",
+           n, stat[0], stat[1], stat[2], keys, maxlen);
+    printf("%u half-words programmed, %.1f per set\n", g_sim_programs, stat[0] ? (double)g_sim_programs / stat[0] : 0.0);
+    printf("erases:");
+
+    for (i = 0; i < FLASHKV_PAGE_NUM; i++)printf(" page %u: %u", i, g_sim_erases[i]);
+
+    printf(", %.1f sets per erase\n", total ? (double)(stat[0] + stat[2]) / total : 0.0);
+
+    if (max)
+    {
+        printf("with %u erase cycles per page: about %.0f sets\n", SIM_CYCLES,
+               (double)(stat[0] + stat[2]) * SIM_CYCLES / max);
+    }
+
+    /* Power cuts, each one at a random flash operation of the next operations */
+    for (c = 0; c < cuts; c++)
+    {
+        g_sim_cut = g_sim_ops + 1 + rand() % 200;
+
+        if (setjmp(g_sim_jmp) == 0)
+        {
+            while (1)kv_random_op(keys, maxlen, stat);
+        }
+
+        g_sim_cut = 0;
+        kv_reset_check("power cut");
+    }
+
+    printf("%u power cuts\n", cuts);
+    CHECK(g_sim_violations == 0, "%u programs of a half-word that was not erased", g_sim_violations);
+    printf(g_fails ? "%d failures\n" : "all passed\n", g_fails);
+    return g_fails ? 1 : 0;
+}
@@ -0,0 +1,537 @@
+/**
+ ****************************************************************************************************
+ * @file        dsp_bench.c
+ * @author      ALIENTEK
+ * @brief       Speed and accuracy of the float, Q31 and Q15 DSP kernels
+ *
+ *              Each kernel runs in its three variants on the same test signal (two sines and some
+ *              noise, 0.47 of full scale), the cycles of the fastest of DSP_BENCH_REPEAT runs are
+ *              kept. The output is compared with the same computation done in double, the largest
+ *              error is kept. The Q15 variants get the signal rounded to 16 bits, as they would in
+ *              an application, so their error includes it.
+ *
+ *              The Cortex-M3 has no FPU: float32_t is emulated in software and the double reference
+ *              takes a few hundred ms.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     the references use a double pi
+ *
+ ****************************************************************************************************
+ */
+
+#include "dsp_bench.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#define DSP_BENCH_FIR_FC        0.1     /* Cut-off frequencies, in units of the sampling frequency */
+#define DSP_BENCH_BIQUAD_FC     0.05
+#define DSP_BENCH_PI            3.14159265358979323846  /* The PI of arm_math.h is a float, 22 bits are not enough for the references */
+
+dsp_bench_res_t g_dsp_bench[DSP_KERNEL_NUM][DSP_TYPE_NUM];
+
+const char *const g_dsp_kernel_name[DSP_KERNEL_NUM] = {"SIN", "FIR", "BIQUAD", "FFT", "MAG", "RMS"};
+const char *const g_dsp_type_name[DSP_TYPE_NUM] = {"F32", "Q31", "Q15"};
+
+static q31_t g_bench_sig[DSP_BENCH_LEN];                /* Test signal */
+static double g_bench_ref[DSP_BENCH_LEN];               /* Reference output */
+static double g_bench_cos[DSP_BENCH_LEN];               /* cos(2 * pi * i / DSP_BENCH_LEN) for the reference DFT */
+static double g_bench_fir[DSP_BENCH_FIR_TAPS];          /* FIR coefficients */
+static double g_bench_biquad[DSP_BENCH_BIQUAD_STAGES][5];   /* b0, b1, b2, a1, a2 of each stage, a1/a2 with the sign of CMSIS */
+
+/* Buffers of the kernels, in the format of the variant under test */
+static uint32_t g_bench_in[DSP_BENCH_LEN];                  /* Input, the kernels may overwrite it */
+static uint32_t g_bench_out[DSP_BENCH_LEN * 2];             /* Output, the Q15/Q31 real FFTs give 2 * DSP_BENCH_LEN values */
+static uint32_t g_bench_state[DSP_BENCH_FIR_TAPS + DSP_BENCH_LEN];
+static uint32_t g_bench_coef[DSP_BENCH_FIR_TAPS];
+
+static union
+{
+    arm_fir_instance_f32 fir_f32;
+    arm_fir_instance_q31 fir_q31;
+    arm_fir_instance_q15 fir_q15;
+    arm_biquad_casd_df1_inst_f32 biquad_f32;
+    arm_biquad_casd_df1_inst_q31 biquad_q31;
+    arm_biquad_casd_df1_inst_q15 biquad_q15;
+    arm_rfft_fast_instance_f32 fft_f32;
+    arm_rfft_instance_q31 fft_q31;
+    arm_rfft_instance_q15 fft_q15;
+} g_bench_inst;
+
+static uint32_t g_bench_ovh;                            /* Cycles of reading the counter twice */
+static uint8_t g_bench_ready = 0;                       /* dsp_bench_init was called */
+
+/**
+ * @brief   Rounds a value to Q31 with saturation
+ * @param   x: value, -1 ~ 1
+ * @retval  Q31 value
+ */
+static q31_t dsp_bench_q31(double x)
+{
+    x = x * 2147483648.0;
+    x += (x < 0) ? -0.5 : 0.5;
+
+    if (x >= 2147483647.0)return 0x7FFFFFFF;
+    if (x <= -2147483648.0)return (q31_t)0x80000000;
+
+    return (q31_t)x;
+}
+
+/**
+ * @brief   Rounds a value to Q15 with saturation
+ * @param   x: value, -1 ~ 1
+ * @retval  Q15 value
+ */
+static q15_t dsp_bench_q15(double x)
+{
+    x = x * 32768.0;
+    x += (x < 0) ? -0.5 : 0.5;
+
+    if (x >= 32767.0)return 0x7FFF;
+    if (x <= -32768.0)return (q15_t)0x8000;
+
+    return (q15_t)x;
+}
+
+/**
+ * @brief   Copies the test signal to the input buffer in the format of a variant
+ * @param   type: DSP_TYPE_F32 / DSP_TYPE_Q31 / DSP_TYPE_Q15
+ * @retval  None
+ */
+static void dsp_bench_load(uint8_t type)
+{
+    if (type == DSP_TYPE_F32)
+    {
+        arm_q31_to_float(g_bench_sig, (float32_t *)g_bench_in, DSP_BENCH_LEN);
+    }
+    else if (type == DSP_TYPE_Q31)
+    {
+        memcpy(g_bench_in, g_bench_sig, sizeof(g_bench_sig));
+    }
+    else
+    {
+        for (uint32_t i = 0; i < DSP_BENCH_LEN; i++)   /* Rounded, arm_q31_to_q15 truncates */
+        {
+            ((q15_t *)g_bench_in)[i] = dsp_bench_q15(g_bench_sig[i] / 2147483648.0);
+        }
+    }
+}
+
+/**
+ * @brief   Computes the reference output of a kernel
+ * @param   kernel: DSP_KERNEL_xxx
+ * @retval  None
+ */
+static void dsp_bench_ref(uint8_t kernel)
+{
+    double x[DSP_BENCH_BIQUAD_STAGES + 1][3] = {0};     /* x[s]: input of stage s, x[s + 1]: its output */
+    double re, im, acc;
+    uint32_t i, k, s;
+
+    switch (kernel)
+    {
+        case DSP_KERNEL_SIN:
+            for (i = 0; i < DSP_BENCH_LEN; i++)
+            {
+                g_bench_ref[i] = sin(2 * DSP_BENCH_PI * i / DSP_BENCH_LEN);
+            }
+            break;
+
+        case DSP_KERNEL_FIR:
+            for (i = 0; i < DSP_BENCH_LEN; i++)
+            {
+                acc = 0;
+
+                for (k = 0; k < DSP_BENCH_FIR_TAPS && k <= i; k++)
+                {
+                    acc += g_bench_fir[k] * (g_bench_sig[i - k] / 2147483648.0);
+                }
+
+                g_bench_ref[i] = acc;
+            }
+            break;
+
+        case DSP_KERNEL_BIQUAD:
+            for (i = 0; i < DSP_BENCH_LEN; i++)
+            {
+                x[0][0] = g_bench_sig[i] / 2147483648.0;
+
+                for (s = 0; s < DSP_BENCH_BIQUAD_STAGES; s++)  /* Direct form I, x[s][1..2] and x[s + 1][1..2] are the delays */
+                {
+                    x[s + 1][0] = g_bench_biquad[s][0] * x[s][0] + g_bench_biquad[s][1] * x[s][1] + g_bench_biquad[s][2] * x[s][2]
+                                + g_bench_biquad[s][3] * x[s + 1][1] + g_bench_biquad[s][4] * x[s + 1][2];
+                }
+
+                for (s = 0; s <= DSP_BENCH_BIQUAD_STAGES; s++)
+                {
+                    x[s][2] = x[s][1];
+                    x[s][1] = x[s][0];
+                }
+
+                g_bench_ref[i] = x[DSP_BENCH_BIQUAD_STAGES][0];
+            }
+            break;
+
+        case DSP_KERNEL_FFT:                            /* Bins 0 ~ N/2 - 1, divided by N like the Q15/Q31 outputs */
+            for (k = 0; k < DSP_BENCH_LEN / 2; k++)
+            {
+                re = im = 0;
+
+                for (i = 0; i < DSP_BENCH_LEN; i++)
+                {
+                    re += g_bench_sig[i] * g_bench_cos[(k * i) % DSP_BENCH_LEN];
+                    im -= g_bench_sig[i] * g_bench_cos[(k * i + DSP_BENCH_LEN * 3 / 4) % DSP_BENCH_LEN];    /* sin */
+                }
+
+                g_bench_ref[2 * k] = re / 2147483648.0 / DSP_BENCH_LEN;
+                g_bench_ref[2 * k + 1] = im / 2147483648.0 / DSP_BENCH_LEN;
+            }
+            break;
+
+        case DSP_KERNEL_MAG:                            /* The signal taken as DSP_BENCH_LEN / 2 complex values */
+            for (k = 0; k < DSP_BENCH_LEN / 2; k++)
+            {
+                re = g_bench_sig[2 * k] / 2147483648.0;
+                im = g_bench_sig[2 * k + 1] / 2147483648.0;
+                g_bench_ref[k] = sqrt(re * re + im * im);
+            }
+            break;
+
+        case DSP_KERNEL_RMS:
+            acc = 0;
+
+            for (i = 0; i < DSP_BENCH_LEN; i++)
+            {
+                re = g_bench_sig[i] / 2147483648.0;
+                acc += re * re;
+            }
+
+            g_bench_ref[0] = sqrt(acc / DSP_BENCH_LEN);
+            break;
+    }
+}
+
+/**
+ * @brief   Prepares the input and the instance of a kernel variant
+ * @param   kernel: DSP_KERNEL_xxx
+ * @param   type  : DSP_TYPE_xxx
+ * @retval  None
+ */
+static void dsp_bench_prepare(uint8_t kernel, uint8_t type)
+{
+    uint32_t i, s;
+
+    if (kernel == DSP_KERNEL_SIN)                       /* One turn: 0 ~ 2 * pi for float, 0 ~ 1 for Q31/Q15 */
+    {
+        for (i = 0; i < DSP_BENCH_LEN; i++)
+        {
+            if (type == DSP_TYPE_F32)((float32_t *)g_bench_in)[i] = 2 * PI * i / DSP_BENCH_LEN;
+            else if (type == DSP_TYPE_Q31)((q31_t *)g_bench_in)[i] = i * (0x80000000 / DSP_BENCH_LEN);
+            else ((q15_t *)g_bench_in)[i] = i * (0x8000 / DSP_BENCH_LEN);
+        }
+
+        return;
+    }
+
+    dsp_bench_load(type);
+
+    switch (kernel)
+    {
+        case DSP_KERNEL_FIR:                            /* The coefficients are given in time reversed order */
+            for (i = 0; i < DSP_BENCH_FIR_TAPS; i++)
+            {
+                s = DSP_BENCH_FIR_TAPS - 1 - i;
+
+                if (type == DSP_TYPE_F32)((float32_t *)g_bench_coef)[i] = g_bench_fir[s];
+                else if (type == DSP_TYPE_Q31)((q31_t *)g_bench_coef)[i] = dsp_bench_q31(g_bench_fir[s]);
+                else ((q15_t *)g_bench_coef)[i] = dsp_bench_q15(g_bench_fir[s]);
+            }
+
+            if (type == DSP_TYPE_F32)arm_fir_init_f32(&g_bench_inst.fir_f32, DSP_BENCH_FIR_TAPS, (float32_t *)g_bench_coef, (float32_t *)g_bench_state, DSP_BENCH_LEN);
+            else if (type == DSP_TYPE_Q31)arm_fir_init_q31(&g_bench_inst.fir_q31, DSP_BENCH_FIR_TAPS, (q31_t *)g_bench_coef, (q31_t *)g_bench_state, DSP_BENCH_LEN);
+            else arm_fir_init_q15(&g_bench_inst.fir_q15, DSP_BENCH_FIR_TAPS, (q15_t *)g_bench_coef, (q15_t *)g_bench_state, DSP_BENCH_LEN);
+            break;
+
+        case DSP_KERNEL_BIQUAD:                         /* Q31/Q15 coefficients are halved, postShift 1 */
+            for (s = 0; s < DSP_BENCH_BIQUAD_STAGES; s++)
+            {
+                for (i = 0; i < 5; i++)
+                {
+                    if (type == DSP_TYPE_F32)((float32_t *)g_bench_coef)[s * 5 + i] = g_bench_biquad[s][i];
+                    else if (type == DSP_TYPE_Q31)((q31_t *)g_bench_coef)[s * 5 + i] = dsp_bench_q31(g_bench_biquad[s][i] / 2);
+                    else ((q15_t *)g_bench_coef)[s * 6 + i + (i > 0)] = dsp_bench_q15(g_bench_biquad[s][i] / 2);   /* b0, 0, b1, b2, a1, a2 */
+                }
+
+                if (type == DSP_TYPE_Q15)((q15_t *)g_bench_coef)[s * 6 + 1] = 0;
+            }
+
+            if (type == DSP_TYPE_F32)arm_biquad_cascade_df1_init_f32(&g_bench_inst.biquad_f32, DSP_BENCH_BIQUAD_STAGES, (float32_t *)g_bench_coef, (float32_t *)g_bench_state);
+            else if (type == DSP_TYPE_Q31)arm_biquad_cascade_df1_init_q31(&g_bench_inst.biquad_q31, DSP_BENCH_BIQUAD_STAGES, (q31_t *)g_bench_coef, (q31_t *)g_bench_state, 1);
+            else arm_biquad_cascade_df1_init_q15(&g_bench_inst.biquad_q15, DSP_BENCH_BIQUAD_STAGES, (q15_t *)g_bench_coef, (q15_t *)g_bench_state, 1);
+            break;
+
+        case DSP_KERNEL_FFT:
+            if (type == DSP_TYPE_F32)arm_rfft_fast_init_f32(&g_bench_inst.fft_f32, DSP_BENCH_LEN);
+            else if (type == DSP_TYPE_Q31)arm_rfft_init_q31(&g_bench_inst.fft_q31, DSP_BENCH_LEN, 0, 1);
+            else arm_rfft_init_q15(&g_bench_inst.fft_q15, DSP_BENCH_LEN, 0, 1);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief   The measured call of a kernel variant
+ * @param   kernel: DSP_KERNEL_xxx
+ * @param   type  : DSP_TYPE_xxx
+ * @retval  None
+ */
+static void dsp_bench_call(uint8_t kernel, uint8_t type)
+{
+    uint32_t i;
+
+    switch (kernel)
+    {
+        case DSP_KERNEL_SIN:
+            if (type == DSP_TYPE_F32)
+            {
+                for (i = 0; i < DSP_BENCH_LEN; i++)((float32_t *)g_bench_out)[i] = arm_sin_f32(((float32_t *)g_bench_in)[i]);
+            }
+            else if (type == DSP_TYPE_Q31)
+            {
+                for (i = 0; i < DSP_BENCH_LEN; i++)((q31_t *)g_bench_out)[i] = arm_sin_q31(((q31_t *)g_bench_in)[i]);
+            }
+            else
+            {
+                for (i = 0; i < DSP_BENCH_LEN; i++)((q15_t *)g_bench_out)[i] = arm_sin_q15(((q15_t *)g_bench_in)[i]);
+            }
+            break;
+
+        case DSP_KERNEL_FIR:
+            if (type == DSP_TYPE_F32)arm_fir_f32(&g_bench_inst.fir_f32, (float32_t *)g_bench_in, (float32_t *)g_bench_out, DSP_BENCH_LEN);
+            else if (type == DSP_TYPE_Q31)arm_fir_q31(&g_bench_inst.fir_q31, (q31_t *)g_bench_in, (q31_t *)g_bench_out, DSP_BENCH_LEN);
+            else arm_fir_q15(&g_bench_inst.fir_q15, (q15_t *)g_bench_in, (q15_t *)g_bench_out, DSP_BENCH_LEN);
+            break;
+
+        case DSP_KERNEL_BIQUAD:
+            if (type == DSP_TYPE_F32)arm_biquad_cascade_df1_f32(&g_bench_inst.biquad_f32, (float32_t *)g_bench_in, (float32_t *)g_bench_out, DSP_BENCH_LEN);
+            else if (type == DSP_TYPE_Q31)arm_biquad_cascade_df1_q31(&g_bench_inst.biquad_q31, (q31_t *)g_bench_in, (q31_t *)g_bench_out, DSP_BENCH_LEN);
+            else arm_biquad_cascade_df1_q15(&g_bench_inst.biquad_q15, (q15_t *)g_bench_in, (q15_t *)g_bench_out, DSP_BENCH_LEN);
+            break;
+
+        case DSP_KERNEL_FFT:
+            if (type == DSP_TYPE_F32)arm_rfft_fast_f32(&g_bench_inst.fft_f32, (float32_t *)g_bench_in, (float32_t *)g_bench_out, 0);
+            else if (type == DSP_TYPE_Q31)arm_rfft_q31(&g_bench_inst.fft_q31, (q31_t *)g_bench_in, (q31_t *)g_bench_out);
+            else arm_rfft_q15(&g_bench_inst.fft_q15, (q15_t *)g_bench_in, (q15_t *)g_bench_out);
+            break;
+
+        case DSP_KERNEL_MAG:
+            if (type == DSP_TYPE_F32)arm_cmplx_mag_f32((float32_t *)g_bench_in, (float32_t *)g_bench_out, DSP_BENCH_LEN / 2);
+            else if (type == DSP_TYPE_Q31)arm_cmplx_mag_q31((q31_t *)g_bench_in, (q31_t *)g_bench_out, DSP_BENCH_LEN / 2);
+            else arm_cmplx_mag_q15((q15_t *)g_bench_in, (q15_t *)g_bench_out, DSP_BENCH_LEN / 2);
+            break;
+
+        case DSP_KERNEL_RMS:
+            if (type == DSP_TYPE_F32)arm_rms_f32((float32_t *)g_bench_in, DSP_BENCH_LEN, (float32_t *)g_bench_out);
+            else if (type == DSP_TYPE_Q31)arm_rms_q31((q31_t *)g_bench_in, DSP_BENCH_LEN, (q31_t *)g_bench_out);
+            else arm_rms_q15((q15_t *)g_bench_in, DSP_BENCH_LEN, (q15_t *)g_bench_out);
+            break;
+    }
+}
+
+/**
+ * @brief   Compares the output of a kernel variant with the reference
+ * @param   kernel: DSP_KERNEL_xxx
+ * @param   type  : DSP_TYPE_xxx
+ * @retval  Largest error, in 1/2^31 of full scale (0xFFFFFFFF if it is larger than 2)
+ */
+static uint32_t dsp_bench_check(uint8_t kernel, uint8_t type)
+{
+    uint32_t i, num = DSP_BENCH_LEN;
+    double scale = 1, val, err, max = 0;
+
+    if (kernel == DSP_KERNEL_FFT)
+    {
+        if (type == DSP_TYPE_F32)
+        {
+            ((float32_t *)g_bench_out)[1] = 0;      /* arm_rfft_fast_f32 puts bin N/2 in the imaginary part of bin 0 */
+            scale = 1.0 / DSP_BENCH_LEN;
+        }
+    }
+    else if (kernel == DSP_KERNEL_MAG)
+    {
+        num = DSP_BENCH_LEN / 2;
+        if (type != DSP_TYPE_F32)scale = 2;         /* Q2.30 / Q2.14 */
+    }
+    else if (kernel == DSP_KERNEL_RMS)
+    {
+        num = 1;
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        if (type == DSP_TYPE_F32)val = ((float32_t *)g_bench_out)[i];
+        else if (type == DSP_TYPE_Q31)val = ((q31_t *)g_bench_out)[i] / 2147483648.0;
+        else val = ((q15_t *)g_bench_out)[i] / 32768.0;
+
+        err = fabs(val * scale - g_bench_ref[i]);
+        if (err > max)max = err;
+    }
+
+    max *= 2147483648.0;
+    return (max >= 4294967295.0) ? 0xFFFFFFFF : (uint32_t)max;
+}
+
+/**
+ * @brief   Starts the cycle counter, builds the test signal and the filters
+ * @param   None
+ * @retval  None
+ */
+void dsp_bench_init(void)
+{
+    uint32_t i, seed = 1;
+    double w, x, q[DSP_BENCH_BIQUAD_STAGES], a0, alpha;
+
+    g_bench_ready = 1;
+
+    DSP_BENCH_CYCLES_INIT();
+    g_bench_ovh = DSP_BENCH_CYCLES();
+    g_bench_ovh = DSP_BENCH_CYCLES() - g_bench_ovh;
+
+    for (i = 0; i < DSP_BENCH_LEN; i++)
+    {
+        seed = seed * 1664525 + 1013904223;             /* Noise of +/- 0.02 */
+        x = 0.3 * sin(2 * DSP_BENCH_PI * 0.03 * i) + 0.15 * sin(2 * DSP_BENCH_PI * 0.21 * i + 1) + 0.02 * ((int32_t)seed / 2147483648.0);
+        g_bench_sig[i] = dsp_bench_q31(x);
+        g_bench_cos[i] = cos(2 * DSP_BENCH_PI * i / DSP_BENCH_LEN);
+    }
+
+    x = 0;
+
+    for (i = 0; i < DSP_BENCH_FIR_TAPS; i++)            /* Windowed sinc, Hamming window */
+    {
+        w = i - (DSP_BENCH_FIR_TAPS - 1) / 2.0;
+        g_bench_fir[i] = 2 * DSP_BENCH_FIR_FC * (0.54 - 0.46 * cos(2 * DSP_BENCH_PI * i / (DSP_BENCH_FIR_TAPS - 1)));
+        g_bench_fir[i] *= sin(2 * DSP_BENCH_PI * DSP_BENCH_FIR_FC * w) / (2 * DSP_BENCH_PI * DSP_BENCH_FIR_FC * w);
+        x += g_bench_fir[i];
+    }
+
+    for (i = 0; i < DSP_BENCH_FIR_TAPS; i++)            /* Gain 1 at DC */
+    {
+        g_bench_fir[i] /= x;
+    }
+
+    for (i = 0; i < DSP_BENCH_BIQUAD_STAGES; i++)       /* Butterworth, bilinear transform */
+    {
+        q[i] = 1 / (2 * cos(DSP_BENCH_PI * (2 * i + 1) / (4 * DSP_BENCH_BIQUAD_STAGES)));
+        w = 2 * DSP_BENCH_PI * DSP_BENCH_BIQUAD_FC;
+        alpha = sin(w) / (2 * q[i]);
+        a0 = 1 + alpha;
+        g_bench_biquad[i][0] = (1 - cos(w)) / 2 / a0;
+        g_bench_biquad[i][1] = (1 - cos(w)) / a0;
+        g_bench_biquad[i][2] = g_bench_biquad[i][0];
+        g_bench_biquad[i][3] = 2 * cos(w) / a0;
+        g_bench_biquad[i][4] = -(1 - alpha) / a0;
+    }
+}
+
+/**
+ * @brief   Measures the three variants of a kernel
+ * @note    Calls dsp_bench_init the first time
+ * @param   kernel: DSP_KERNEL_xxx
+ * @retval  None
+ */
+void dsp_bench_kernel(uint8_t kernel)
+{
+    uint32_t t, best;
+    uint8_t type, i;
+
+    if (kernel >= DSP_KERNEL_NUM)return;
+
+    if (g_bench_ready == 0)dsp_bench_init();
+
+    dsp_bench_ref(kernel);
+
+    for (type = 0; type < DSP_TYPE_NUM; type++)
+    {
+        best = 0xFFFFFFFF;
+
+        for (i = 0; i < DSP_BENCH_REPEAT; i++)
+        {
+            dsp_bench_prepare(kernel, type);
+            t = DSP_BENCH_CYCLES();
+            dsp_bench_call(kernel, type);
+            t = DSP_BENCH_CYCLES() - t;
+
+            if (t < best)best = t;
+        }
+
+        g_dsp_bench[kernel][type].cycles = (best > g_bench_ovh) ? best - g_bench_ovh : 1;
+        g_dsp_bench[kernel][type].err = dsp_bench_check(kernel, type);
+    }
+}
+
+/**
+ * @brief   Measures all the kernels
+ * @param   None
+ * @retval  None
+ */
+void dsp_bench_run(void)
+{
+    for (uint8_t kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+    {
+        dsp_bench_kernel(kernel);
+    }
+}
+
+/**
+ * @brief   Accurate bits of an error
+ * @param   err: error in 1/2^31 of full scale
+ * @retval  0 ~ 31
+ */
+uint8_t dsp_bench_bits(uint32_t err)
+{
+    uint8_t len = 0;
+
+    while (len < 32 && (err >> len))len++;      /* Bit length of the error */
+
+    return (len == 0) ? 31 : 32 - len;
+}
+
+/**
+ * @brief   Prints the results
+ * @param   None
+ * @retval  None
+ */
+void dsp_bench_print(void)
+{
+    uint8_t kernel, type;
+    dsp_bench_res_t *res;
+
+    printf("\r\nkernel  type   cycles  cyc/smp  error      bits\r\n");
+
+    for (kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+    {
+        for (type = 0; type < DSP_TYPE_NUM; type++)
+        {
+            res = &g_dsp_bench[kernel][type];
+
+            if (res->cycles == 0)continue;
+
+            printf("%-7s %-4s %8lu %8lu  %.2e  %2d\r\n", g_dsp_kernel_name[kernel], g_dsp_type_name[type],
+                   res->cycles, res->cycles / DSP_BENCH_LEN, res->err / 2147483648.0, dsp_bench_bits(res->err));
+        }
+    }
+}
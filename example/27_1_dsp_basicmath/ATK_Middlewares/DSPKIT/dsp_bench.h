@@ -0,0 +1,71 @@
+/**
+ ****************************************************************************************************
+ * @file        dsp_bench.h
+ * @author      ALIENTEK
+ * @brief       Speed and accuracy of the float, Q31 and Q15 DSP kernels
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __DSP_BENCH_H
+#define __DSP_BENCH_H
+
+#include "main.h"
+#include "arm_math.h"
+
+
+/* Cycle counter: the DWT of the Cortex-M3. A host build defines both macros with its own clock */
+#ifndef DSP_BENCH_CYCLES
+#define DSP_BENCH_CYCLES_INIT() do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#define DSP_BENCH_CYCLES()      (DWT->CYCCNT)
+#endif
+
+#define DSP_BENCH_LEN           256     /* Samples of the test signal, also the FFT length */
+#define DSP_BENCH_FIR_TAPS      32      /* Even, arm_fir_q15 needs it */
+#define DSP_BENCH_BIQUAD_STAGES 2
+#define DSP_BENCH_REPEAT        3       /* Runs of each kernel, the fastest one is kept */
+
+/* Kernels */
+#define DSP_KERNEL_SIN          0       /* DSP_BENCH_LEN sines over one turn */
+#define DSP_KERNEL_FIR          1       /* DSP_BENCH_FIR_TAPS taps lowpass, one block */
+#define DSP_KERNEL_BIQUAD       2       /* Butterworth lowpass of DSP_BENCH_BIQUAD_STAGES stages, one block */
+#define DSP_KERNEL_FFT          3       /* Real FFT of DSP_BENCH_LEN samples */
+#define DSP_KERNEL_MAG          4       /* Magnitude of DSP_BENCH_LEN / 2 complex values */
+#define DSP_KERNEL_RMS          5       /* RMS of one block */
+#define DSP_KERNEL_NUM          6
+
+/* Variants of a kernel */
+#define DSP_TYPE_F32            0       /* float32_t, emulated in software on the Cortex-M3 */
+#define DSP_TYPE_Q31            1
+#define DSP_TYPE_Q15            2
+#define DSP_TYPE_NUM            3
+
+/* Result of a kernel variant */
+typedef struct
+{
+    uint32_t cycles;                    /* Cycles of one call on DSP_BENCH_LEN samples, 0: not measured */
+    uint32_t err;                       /* Largest error against the double reference, in 1/2^31 of full scale */
+} dsp_bench_res_t;
+
+extern dsp_bench_res_t g_dsp_bench[DSP_KERNEL_NUM][DSP_TYPE_NUM];
+extern const char *const g_dsp_kernel_name[DSP_KERNEL_NUM];
+extern const char *const g_dsp_type_name[DSP_TYPE_NUM];
+
+void dsp_bench_init(void);                          /* Starts the cycle counter, builds the test signal */
+void dsp_bench_kernel(uint8_t kernel);              /* Measures the variants of one kernel */
+void dsp_bench_run(void);                           /* Measures all the kernels */
+uint8_t dsp_bench_bits(uint32_t err);               /* Accurate bits of an error */
+void dsp_bench_print(void);                         /* Prints the results */
+
+#endif
@@ -0,0 +1,384 @@
+/**
+ ****************************************************************************************************
+ * @file        dsp_kit.c
+ * @author      ALIENTEK
+ * @brief       DSP kernels that use the fastest variant meeting an accuracy
+ *
+ *              The caller gives the largest error it accepts, dsp_kit_pick takes the variant with
+ *              the fewest cycles among those whose measured error (dsp_bench) is small enough. A
+ *              kernel is measured the first time it is asked for, which takes a few hundred ms.
+ *
+ *              Signals are Q31 whatever the variant: the F32 and Q15 variants convert them in a
+ *              work buffer, this costs a few cycles per sample and is not counted by dsp_bench.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include "dsp_kit.h"
+#include <math.h>
+#include <string.h>
+
+
+/**
+ * @brief   Fastest variant whose error meets max_err
+ * @note    The cycles and the errors of the kernels of the mask are added. If no variant is
+ *          accurate enough, the most accurate one is returned
+ * @param   kernels: DSP_KIT_MASK(DSP_KERNEL_xxx) | ...
+ * @param   max_err: largest error, in 1/2^31 of full scale (see DSP_KIT_ERR)
+ * @retval  DSP_TYPE_xxx
+ */
+uint8_t dsp_kit_pick(uint32_t kernels, uint32_t max_err)
+{
+    uint32_t cycles, err, best_cycles = 0xFFFFFFFF, best_err = 0xFFFFFFFF;
+    uint8_t kernel, type, fast = DSP_TYPE_NUM, exact = DSP_TYPE_Q31;
+
+    for (kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+    {
+        if ((kernels & DSP_KIT_MASK(kernel)) && g_dsp_bench[kernel][0].cycles == 0)
+        {
+            dsp_bench_kernel(kernel);
+        }
+    }
+
+    for (type = 0; type < DSP_TYPE_NUM; type++)
+    {
+        cycles = err = 0;
+
+        for (kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+        {
+            if ((kernels & DSP_KIT_MASK(kernel)) == 0)continue;
+
+            cycles += g_dsp_bench[kernel][type].cycles;
+            err += g_dsp_bench[kernel][type].err;
+
+            if (err < g_dsp_bench[kernel][type].err)err = 0xFFFFFFFF;   /* Overflow */
+        }
+
+        if (err <= max_err && cycles < best_cycles)
+        {
+            best_cycles = cycles;
+            fast = type;
+        }
+
+        if (err < best_err)
+        {
+            best_err = err;
+            exact = type;
+        }
+    }
+
+    return (fast < DSP_TYPE_NUM) ? fast : exact;
+}
+
+/**
+ * @brief   Sine
+ * @param   x   : angle in turns, 0 ~ 0x7FFFFFFF is 0 ~ 2 * pi
+ * @param   type: DSP_TYPE_xxx, from dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_SIN), ...)
+ * @retval  sin(2 * pi * x)
+ */
+q31_t dsp_sin(q31_t x, uint8_t type)
+{
+    float32_t y;
+
+    if (type == DSP_TYPE_Q31)return arm_sin_q31(x);
+
+    if (type == DSP_TYPE_Q15)return (q31_t)arm_sin_q15((q15_t)(x >> 16)) << 16;
+
+    arm_q31_to_float(&x, &y, 1);
+    y = arm_sin_f32(y * 2 * PI);
+    arm_float_to_q31(&y, &x, 1);
+    return x;
+}
+
+/**
+ * @brief   Root mean square
+ * @param   in  : samples
+ * @param   num : number of samples
+ * @param   type: DSP_TYPE_xxx, from dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_RMS), ...)
+ * @retval  RMS value
+ */
+q31_t dsp_rms(const q31_t *in, uint32_t num, uint8_t type)
+{
+    union
+    {
+        q15_t q15[64];
+        float32_t f32[64];
+    } buf;                                  /* The samples are converted 64 at a time */
+    float32_t pwr, sum_f32 = 0;
+    q63_t pwr_q63, sum_q63 = 0;
+    q31_t res;
+    uint32_t i, n;
+
+    if (num == 0)return 0;
+
+    if (type == DSP_TYPE_Q31)
+    {
+        arm_rms_q31((q31_t *)in, num, &res);
+        return res;
+    }
+
+    for (i = 0; i < num; i += n)
+    {
+        n = (num - i > 64) ? 64 : num - i;
+
+        if (type == DSP_TYPE_Q15)
+        {
+            arm_q31_to_q15((q31_t *)in + i, buf.q15, n);
+            arm_power_q15(buf.q15, n, &pwr_q63);     /* Q34.30 */
+            sum_q63 += pwr_q63;
+        }
+        else
+        {
+            arm_q31_to_float((q31_t *)in + i, buf.f32, n);
+            arm_power_f32(buf.f32, n, &pwr);
+            sum_f32 += pwr;
+        }
+    }
+
+    if (type == DSP_TYPE_Q15)
+    {
+        sum_q63 /= num;                             /* Mean square, Q2.30 */
+        res = (sum_q63 >= 0x40000000) ? 0x7FFFFFFF : (q31_t)(sum_q63 << 1);
+        arm_sqrt_q31(res, &res);
+        return res;
+    }
+
+    sum_f32 = sqrtf(sum_f32 / num);
+    arm_float_to_q31(&sum_f32, &res, 1);
+    return res;
+}
+
+/**
+ * @brief   Initialises a FIR filter
+ * @param   fir    : filter
+ * @param   coef   : taps coefficients b[0] ~ b[taps - 1], -1 ~ 1
+ * @param   taps   : number of coefficients, even and at least 4 (Q15 variant)
+ * @param   block  : samples per dsp_fir_run
+ * @param   mem    : DSP_FIR_MEM(taps, block) words, kept while the filter is used
+ * @param   max_err: largest error, see dsp_kit_pick
+ * @retval  0, successful; 1, invalid taps
+ */
+uint8_t dsp_fir_init(dsp_fir_t *fir, const float32_t *coef, uint16_t taps, uint16_t block, uint32_t *mem, uint32_t max_err)
+{
+    uint32_t *state = mem + taps;
+    uint16_t i;
+
+    if (taps < 4 || (taps & 1))return 1;
+
+    fir->type = dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_FIR), max_err);
+    fir->block = block;
+    fir->work = state + taps + block - 1;
+
+    for (i = 0; i < taps; i++)              /* CMSIS takes the coefficients in time reversed order */
+    {
+        if (fir->type == DSP_TYPE_F32)((float32_t *)mem)[i] = coef[taps - 1 - i];
+        else if (fir->type == DSP_TYPE_Q31)arm_float_to_q31((float32_t *)&coef[taps - 1 - i], (q31_t *)mem + i, 1);
+        else arm_float_to_q15((float32_t *)&coef[taps - 1 - i], (q15_t *)mem + i, 1);
+    }
+
+    if (fir->type == DSP_TYPE_F32)arm_fir_init_f32(&fir->inst.f32, taps, (float32_t *)mem, (float32_t *)state, block);
+    else if (fir->type == DSP_TYPE_Q31)arm_fir_init_q31(&fir->inst.q31, taps, (q31_t *)mem, (q31_t *)state, block);
+    else arm_fir_init_q15(&fir->inst.q15, taps, (q15_t *)mem, (q15_t *)state, block);
+
+    return 0;
+}
+
+/**
+ * @brief   Filters a block
+ * @param   fir: filter
+ * @param   in : fir->block samples
+ * @param   out: fir->block samples, can be in
+ * @retval  None
+ */
+void dsp_fir_run(dsp_fir_t *fir, const q31_t *in, q31_t *out)
+{
+    float32_t *f32 = (float32_t *)fir->work;
+    q15_t *q15 = (q15_t *)fir->work;
+
+    if (fir->type == DSP_TYPE_Q31)
+    {
+        arm_fir_q31(&fir->inst.q31, (q31_t *)in, out, fir->block);
+    }
+    else if (fir->type == DSP_TYPE_Q15)
+    {
+        arm_q31_to_q15((q31_t *)in, q15, fir->block);
+        arm_fir_q15(&fir->inst.q15, q15, q15 + fir->block, fir->block);
+        arm_q15_to_q31(q15 + fir->block, out, fir->block);
+    }
+    else
+    {
+        arm_q31_to_float((q31_t *)in, f32, fir->block);
+        arm_fir_f32(&fir->inst.f32, f32, f32 + fir->block, fir->block);
+        arm_float_to_q31(f32 + fir->block, out, fir->block);
+    }
+}
+
+/**
+ * @brief   Initialises a biquad cascade
+ * @param   bq     : filter
+ * @param   coef   : b0, b1, b2, a1, a2 of each stage, with y[n] = b0 * x[n] + ... + a1 * y[n-1] + a2 * y[n-2]
+ *                   (a1/a2 have the opposite sign of the usual denominator)
+ * @param   stages : number of stages
+ * @param   block  : samples per dsp_biquad_run
+ * @param   mem    : DSP_BIQUAD_MEM(stages, block) words, kept while the filter is used
+ * @param   max_err: largest error, see dsp_kit_pick
+ * @retval  0, successful; 1, a coefficient is 4 or more (Q31/Q15 variants)
+ */
+uint8_t dsp_biquad_init(dsp_biquad_t *bq, const float32_t *coef, uint8_t stages, uint16_t block, uint32_t *mem, uint32_t max_err)
+{
+    uint32_t *state = mem + 5 * stages;
+    float32_t max = 0, c;
+    uint16_t i;
+    int8_t shift = 0;
+
+    bq->type = dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_BIQUAD), max_err);
+    bq->block = block;
+    bq->work = state + 4 * stages;
+
+    if (bq->type == DSP_TYPE_F32)
+    {
+        memcpy(mem, coef, 5 * stages * sizeof(float32_t));
+        arm_biquad_cascade_df1_init_f32(&bq->inst.f32, stages, (float32_t *)mem, (float32_t *)state);
+        return 0;
+    }
+
+    for (i = 0; i < 5 * stages; i++)
+    {
+        if (fabsf(coef[i]) > max)max = fabsf(coef[i]);
+    }
+
+    while (max >= 1.0f)                     /* The coefficients are scaled by 2^-shift, the output by 2^shift */
+    {
+        max /= 2;
+        shift++;
+    }
+
+    if (shift > 2)return 1;
+
+    for (i = 0; i < 5 * stages; i++)
+    {
+        c = coef[i] / (1 << shift);
+
+        if (bq->type == DSP_TYPE_Q31)arm_float_to_q31(&c, (q31_t *)mem + i, 1);
+        else arm_float_to_q15(&c, (q15_t *)mem + i / 5 * 6 + i % 5 + (i % 5 > 0), 1);  /* b0, 0, b1, b2, a1, a2 */
+    }
+
+    if (bq->type == DSP_TYPE_Q31)
+    {
+        arm_biquad_cascade_df1_init_q31(&bq->inst.q31, stages, (q31_t *)mem, (q31_t *)state, shift);
+    }
+    else
+    {
+        for (i = 0; i < stages; i++)((q15_t *)mem)[i * 6 + 1] = 0;
+
+        arm_biquad_cascade_df1_init_q15(&bq->inst.q15, stages, (q15_t *)mem, (q15_t *)state, shift);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Filters a block
+ * @param   bq : filter
+ * @param   in : bq->block samples
+ * @param   out: bq->block samples, can be in
+ * @retval  None
+ */
+void dsp_biquad_run(dsp_biquad_t *bq, const q31_t *in, q31_t *out)
+{
+    float32_t *f32 = (float32_t *)bq->work;
+    q15_t *q15 = (q15_t *)bq->work;
+
+    if (bq->type == DSP_TYPE_Q31)
+    {
+        arm_biquad_cascade_df1_q31(&bq->inst.q31, (q31_t *)in, out, bq->block);
+    }
+    else if (bq->type == DSP_TYPE_Q15)
+    {
+        arm_q31_to_q15((q31_t *)in, q15, bq->block);
+        arm_biquad_cascade_df1_q15(&bq->inst.q15, q15, q15 + bq->block, bq->block);
+        arm_q15_to_q31(q15 + bq->block, out, bq->block);
+    }
+    else
+    {
+        arm_q31_to_float((q31_t *)in, f32, bq->block);
+        arm_biquad_cascade_df1_f32(&bq->inst.f32, f32, f32 + bq->block, bq->block);
+        arm_float_to_q31(f32 + bq->block, out, bq->block);
+    }
+}
+
+/**
+ * @brief   Initialises a magnitude spectrum
+ * @note    The errors of dsp_bench are measured at DSP_BENCH_LEN, they grow a little with the length
+ * @param   sp     : spectrum
+ * @param   len    : FFT length, 32 ~ 4096 (power of 2)
+ * @param   mem    : DSP_SPECTRUM_MEM(len) words, kept while the spectrum is used
+ * @param   max_err: largest error of the FFT and the magnitude together, see dsp_kit_pick
+ * @retval  0, successful; 1, invalid length
+ */
+uint8_t dsp_spectrum_init(dsp_spectrum_t *sp, uint16_t len, uint32_t *mem, uint32_t max_err)
+{
+    arm_status res;
+
+    sp->type = dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_FFT) | DSP_KIT_MASK(DSP_KERNEL_MAG), max_err);
+    sp->len = len;
+    sp->work = mem;
+
+    if (sp->type == DSP_TYPE_F32)res = arm_rfft_fast_init_f32(&sp->inst.f32, len);
+    else if (sp->type == DSP_TYPE_Q31)res = arm_rfft_init_q31(&sp->inst.q31, len, 0, 1);
+    else res = arm_rfft_init_q15(&sp->inst.q15, len, 0, 1);
+
+    return (res == ARM_MATH_SUCCESS) ? 0 : 1;
+}
+
+/**
+ * @brief   Magnitude spectrum of a block
+ * @param   sp : spectrum
+ * @param   in : sp->len samples
+ * @param   mag: sp->len / 2 magnitudes |X[k]| / len, k = 0 ~ len / 2 - 1
+ * @retval  None
+ */
+void dsp_spectrum_run(dsp_spectrum_t *sp, const q31_t *in, q31_t *mag)
+{
+    float32_t *f32 = (float32_t *)sp->work;
+    q31_t *q31 = (q31_t *)sp->work;
+    q15_t *q15 = (q15_t *)sp->work;
+    uint16_t len = sp->len;
+
+    if (sp->type == DSP_TYPE_Q31)
+    {
+        memcpy(q31, in, len * sizeof(q31_t));           /* arm_rfft_q31 overwrites its input */
+        arm_rfft_q31(&sp->inst.q31, q31, q31 + len);
+        arm_cmplx_mag_q31(q31 + len, mag, len / 2);     /* Q2.30 */
+        arm_shift_q31(mag, 1, mag, len / 2);
+    }
+    else if (sp->type == DSP_TYPE_Q15)
+    {
+        arm_q31_to_q15((q31_t *)in, q15, len);
+        arm_rfft_q15(&sp->inst.q15, q15, q15 + len);
+        arm_cmplx_mag_q15(q15 + len, q15, len / 2);     /* Q2.14 */
+        arm_shift_q15(q15, 1, q15, len / 2);
+        arm_q15_to_q31(q15, mag, len / 2);
+    }
+    else
+    {
+        arm_q31_to_float((q31_t *)in, f32, len);
+        arm_rfft_fast_f32(&sp->inst.f32, f32, f32 + len, 0);
+        f32[len + 1] = 0;                               /* Bin len / 2 is given in the imaginary part of bin 0 */
+        arm_cmplx_mag_f32(f32 + len, f32, len / 2);
+        arm_scale_f32(f32, 1.0f / len, f32, len / 2);
+        arm_float_to_q31(f32, mag, len / 2);
+    }
+}
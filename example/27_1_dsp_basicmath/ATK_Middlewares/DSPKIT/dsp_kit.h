@@ -0,0 +1,97 @@
+/**
+ ****************************************************************************************************
+ * @file        dsp_kit.h
+ * @author      ALIENTEK
+ * @brief       DSP kernels that use the fastest variant meeting an accuracy
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __DSP_KIT_H
+#define __DSP_KIT_H
+
+#include "dsp_bench.h"
+
+
+#define DSP_KIT_MASK(kernel)        (1UL << (kernel))                   /* Kernel mask for dsp_kit_pick */
+#define DSP_KIT_ERR(x)              ((uint32_t)((x) * 2147483648.0))    /* Error of x (< 2) of full scale */
+
+/*
+ * The signals are Q31 for all the variants, the F32 and Q15 variants convert them. Memory sizes
+ * are in 32-bit words.
+ */
+
+/* FIR filter */
+typedef struct
+{
+    union
+    {
+        arm_fir_instance_f32 f32;
+        arm_fir_instance_q31 q31;
+        arm_fir_instance_q15 q15;
+    } inst;
+    uint32_t *work;                         /* Converted input and output of the F32/Q15 variants */
+    uint16_t block;                         /* Samples per call */
+    uint8_t type;                           /* DSP_TYPE_xxx */
+} dsp_fir_t;
+
+#define DSP_FIR_MEM(taps, block)    (2 * (taps) + 3 * (block) - 1)
+
+/* Biquad cascade, direct form I */
+typedef struct
+{
+    union
+    {
+        arm_biquad_casd_df1_inst_f32 f32;
+        arm_biquad_casd_df1_inst_q31 q31;
+        arm_biquad_casd_df1_inst_q15 q15;
+    } inst;
+    uint32_t *work;
+    uint16_t block;
+    uint8_t type;
+} dsp_biquad_t;
+
+#define DSP_BIQUAD_MEM(stages, block)   (9 * (stages) + 2 * (block))
+
+/* Magnitude spectrum of a real signal (real FFT + magnitude) */
+typedef struct
+{
+    union
+    {
+        arm_rfft_fast_instance_f32 f32;
+        arm_rfft_instance_q31 q31;
+        arm_rfft_instance_q15 q15;
+    } inst;
+    uint32_t *work;
+    uint16_t len;                           /* FFT length */
+    uint8_t type;
+} dsp_spectrum_t;
+
+#define DSP_SPECTRUM_MEM(len)       (3 * (len))
+
+uint8_t dsp_kit_pick(uint32_t kernels, uint32_t max_err);  /* Fastest variant meeting max_err for all the kernels of the mask */
+
+q31_t dsp_sin(q31_t x, uint8_t type);                       /* Sine of x turns (0 ~ 1) */
+q31_t dsp_rms(const q31_t *in, uint32_t num, uint8_t type); /* RMS of num samples */
+
+uint8_t dsp_fir_init(dsp_fir_t *fir, const float32_t *coef, uint16_t taps, uint16_t block, uint32_t *mem, uint32_t max_err);
+void dsp_fir_run(dsp_fir_t *fir, const q31_t *in, q31_t *out);
+
+uint8_t dsp_biquad_init(dsp_biquad_t *bq, const float32_t *coef, uint8_t stages, uint16_t block, uint32_t *mem, uint32_t max_err);
+void dsp_biquad_run(dsp_biquad_t *bq, const q31_t *in, q31_t *out);
+
+uint8_t dsp_spectrum_init(dsp_spectrum_t *sp, uint16_t len, uint32_t *mem, uint32_t max_err);
+void dsp_spectrum_run(dsp_spectrum_t *sp, const q31_t *in, q31_t *mag);
+
+#endif
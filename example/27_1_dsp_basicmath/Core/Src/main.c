@@ -15,6 +15,9 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     1, the float sin/cos test is replaced by the DSPKIT benchmark:
+ *                              float, Q31 and Q15 variants of the same kernels, cycles and error
+ *                           2, shows the variant dsp_kit_pick takes for some accuracies
  *
  ****************************************************************************************************
  */
@@ -31,74 +34,70 @@
 #include "../../BSP/LED/led.h"
 #include "../../BSP/KEY/key.h"
 #include "../../BSP/LCD/lcd.h"
-#include "arm_math.h"
+#include "../../ATK_Middlewares/DSPKIT/dsp_kit.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
 
-#define DELTA   0.0001f                 /* error value */
-uint8_t g_timeout;
+uint8_t g_timeout;                      /* TIM6 overflows, see tim.c */
 
-extern float32_t arm_cos_f32(float32_t x);
-
-/* USER CODE END PTD */
-
-/* Private define ------------------------------------------------------------*/
-/* USER CODE BEGIN PD */
+/* Accuracies shown by dsp_pick_show */
+static const float g_pick_err[] = {1e-2f, 1e-4f, 1e-6f};
 
 /**
- * @brief sin cos test
- * @param angle : the starting Angle
- * @param times : The number of operations
- * @param mode  : Whether DSP libraries are used or not
- * @arg   0, does not use DSP libraries;
- * @arg   1, using the DSP library;
- *
- * @retval none
+ * @brief       Shows the benchmark results
+ * @param       y : first line
+ * @retval      None
  */
-uint8_t sin_cos_test(float angle, uint32_t times, uint8_t mode)
+void dsp_bench_show(uint16_t y)
 {
-    float sinx, cosx;
-    float result;
-    uint32_t i = 0;
+    char buf[32];
+    uint8_t kernel, type;
+    dsp_bench_res_t *res;
 
-    if (mode == 0)
-    {
-        for (i = 0; i < times; i++)
-        {
-            cosx = cosf(angle);                 /* Dsp-optimized sin, cos functions are not used */
-            sinx = sinf(angle);
-            result = sinx * sinx + cosx * cosx; /* It should be equal to 1 */
-            result = fabsf(result - 1.0f);      /* Compare the difference with 1 */
+    lcd_show_string(10, y, 230, 12, 12, "cycles/sample / accurate bits", RED);
+    y += 14;
+    lcd_show_string(10, y, 230, 12, 12, "KERNEL  F32      Q31      Q15", RED);
 
-            if (result > DELTA)
-            	{
-            		return 0XFF;     /* Failure to judge */
-            	}
+    for (kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+    {
+        y += 14;
+        lcd_fill(10, y, 239, y + 11, WHITE);
+        lcd_show_string(10, y, 48, 12, 12, (char *)g_dsp_kernel_name[kernel], BLUE);
 
-            angle += 0.001f;    /* Angle self-increasing */
+        for (type = 0; type < DSP_TYPE_NUM; type++)
+        {
+            res = &g_dsp_bench[kernel][type];
+            sprintf(buf, "%lu/%d", res->cycles / DSP_BENCH_LEN, dsp_bench_bits(res->err));
+            lcd_show_string(58 + type * 54, y, 54, 12, 12, buf, BLUE);
         }
     }
-    else
-    {
-        for (i = 0; i < times; i++)
-        {
-            cosx = arm_cos_f32(angle);          /* Using DSP optimized sin, cos functions */
-            sinx = arm_sin_f32(angle);
-            result = sinx * sinx + cosx * cosx; /* It should be equal to 1 */
-            result = fabsf(result - 1.0f);      /* Compare the difference with 1 */
+}
+
+/**
+ * @brief       Shows the variants dsp_kit_pick takes for some accuracies
+ * @param       y : first line
+ * @retval      None
+ */
+void dsp_pick_show(uint16_t y)
+{
+    char buf[48];
+    uint8_t i;
 
-            if (result > DELTA)
-            	{
-            		return 0XFF;     /* Failure to judge */
-            	}
+    lcd_show_string(10, y, 230, 12, 12, "max error  FIR  BIQUAD  SPECTRUM", RED);
 
-            angle += 0.001f;    /* Angle self-increasing */
-        }
+    for (i = 0; i < sizeof(g_pick_err) / sizeof(g_pick_err[0]); i++)
+    {
+        y += 14;
+        sprintf(buf, "%.0e      %s  %s     %s", g_pick_err[i],
+                g_dsp_type_name[dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_FIR), DSP_KIT_ERR(g_pick_err[i]))],
+                g_dsp_type_name[dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_BIQUAD), DSP_KIT_ERR(g_pick_err[i]))],
+                g_dsp_type_name[dsp_kit_pick(DSP_KIT_MASK(DSP_KERNEL_FFT) | DSP_KIT_MASK(DSP_KERNEL_MAG), DSP_KIT_ERR(g_pick_err[i]))]);
+        lcd_fill(10, y, 239, y + 11, WHITE);
+        lcd_show_string(10, y, 230, 12, 12, buf, BLUE);
+        printf("%s\r\n", buf);
     }
-
-    return 0;   /* completion of task */
 }
 
 /* USER CODE END PD */
@@ -132,9 +131,8 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-    float time;
-    char buf[50];
-    uint8_t res;
+    uint8_t key;
+    uint16_t t = 0;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -165,9 +163,14 @@ int main(void)
   lcd_show_string(30, 50, 200, 16, 16, "STM32", RED);
   lcd_show_string(30, 70, 200, 16, 16, "DSP BasicMath TEST", RED);
   lcd_show_string(30, 90, 200, 16, 16, "ATOM@ALIENTEK", RED);
+  lcd_show_string(30, 110, 200, 16, 16, "KEY0:Run again", RED);
 
-  lcd_show_string(30, 110, 200, 16, 16, "No DSP runtime:", RED);
-  lcd_show_string(30, 130, 200, 16, 16, "Use DSP runtime:", RED);
+  lcd_show_string(10, 140, 200, 12, 12, "Measuring...", BLUE);
+  dsp_bench_run();
+  lcd_fill(10, 140, 239, 151, WHITE);
+  dsp_bench_print();
+  dsp_bench_show(140);
+  dsp_pick_show(260);
 
   /* USER CODE END 2 */
 
@@ -176,34 +179,23 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  /* No DSP optimization is used */
-      __HAL_TIM_SET_COUNTER(&htim6, 0);
-      g_timeout = 0;
-      if (sin_cos_test(PI / 6, 10000, 0) == 0)
-      {
-          time = __HAL_TIM_GET_COUNTER(&htim6) + (uint32_t)g_timeout * 0x10000;
-          sprintf(buf, "%0.1fms\r\n", time / 10);
-          lcd_show_string(150, 110, 200, 16, 16, buf, BLUE);
-      }
-      else
-      {
-          lcd_show_string(150, 110, 200, 16, 16, "Error", BLUE);
-      }
+      key = key_scan(0);
 
-      __HAL_TIM_SET_COUNTER(&htim6, 0);
-      g_timeout = 0;
-      if (sin_cos_test(PI / 6, 10000, 1) == 0)
+      if (key == KEY0_PRES)
       {
-          time = __HAL_TIM_GET_COUNTER(&htim6) + (uint32_t)g_timeout * 0x10000;
-          sprintf(buf, "%0.1fms\r\n", time / 10);
-          lcd_show_string(158, 130, 200, 16, 16, buf, BLUE);
+          dsp_bench_run();
+          dsp_bench_print();
+          dsp_bench_show(140);
+          dsp_pick_show(260);
       }
-      else
+
+      if (++t == 50)
       {
-          lcd_show_string(158, 130, 200, 16, 16, "Error", BLUE);
+          t = 0;
+          LED0_TOGGLE();
       }
 
-      LED0_TOGGLE();
+      HAL_Delay(10);
 
     /* USER CODE BEGIN 3 */
   }
@@ -0,0 +1,349 @@
+/**
+ ****************************************************************************************************
+ * @file        dsp_bench_host.c
+ * @author      ALIENTEK
+ * @brief       Runs dsp_bench.c and dsp_kit.c on a Linux host
+ *
+ *              The DSP functions are the host versions of tools/host/arm_math.c, with the data
+ *              formats of CMSIS-DSP. The run checks the bench itself (test signal, double references,
+ *              formats and scaling of each variant) and the wrappers of dsp_kit, the cycles and the
+ *              errors of the library on the board are printed by the board.
+ *
+ *              1. dsp_bench_run and the table of dsp_bench_print, the "cycles" are nanoseconds of the
+ *                 host. Each variant must have the accuracy of its format: a wrong scale or format in
+ *                 the bench gives an error of the size of the signal.
+ *              2. For 1e-2, 1e-4 and 1e-6, the variant dsp_kit_pick takes must meet the bound if any
+ *                 variant does, and be the fastest of those that do.
+ *              3. Each wrapper (sine, RMS, FIR, biquad, spectrum) with each variant forced, on another
+ *                 signal and in several blocks, against a double reference: the error must be within
+ *                 4 times the error dsp_bench measured for the variant, plus 2 LSB of Q15 for the Q15
+ *                 conversions.
+ *
+ *              Build, from example/27_1_dsp_basicmath:
+ *              gcc -O2 -Wall -Wno-format -Itools/host tools/dsp_bench_host.c tools/host/arm_math.c \
+ *                  ATK_Middlewares/DSPKIT/dsp_bench.c ATK_Middlewares/DSPKIT/dsp_kit.c -lm -o dsp_bench_host
+ *              Run:
+ *              ./dsp_bench_host
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../ATK_Middlewares/DSPKIT/dsp_kit.h"
+
+#define HOST_BLOCK          64              /* Samples per call of the filters */
+#define HOST_BLOCKS         4
+#define HOST_LEN            (HOST_BLOCK * HOST_BLOCKS)
+#define HOST_TAPS           16
+#define HOST_STAGES         2
+#define HOST_FFT_LEN        512
+#define HOST_Q15_LSB        (2.0 / 32768)   /* Two LSB of Q15, the conversions of the Q15 wrappers */
+
+/* Bits each format must reach on the bench (the test signal is 0.47 of full scale) */
+static const uint8_t g_min_bits[DSP_KERNEL_NUM][DSP_TYPE_NUM] = {
+    /* F32  Q31  Q15 */
+    {  20,  28,  13 },      /* SIN */
+    {  20,  28,  12 },      /* FIR */
+    {  18,  26,  10 },      /* BIQUAD */
+    {  20,  28,  13 },      /* FFT */
+    {  20,  28,  13 },      /* MAG */
+    {  20,  28,  13 },      /* RMS */
+};
+
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+/**
+ * @brief   Host clock for DSP_BENCH_CYCLES (main.h)
+ * @param   None
+ * @retval  nanoseconds
+ */
+uint32_t host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+/**
+ * @brief   Error bound of a wrapper
+ * @param   kernels: kernels the wrapper uses, DSP_KIT_MASK(...)
+ * @param   type   : DSP_TYPE_xxx
+ * @retval  bound, fraction of full scale
+ */
+static double host_bound(uint32_t kernels, uint8_t type)
+{
+    double err = 0;
+    uint8_t kernel;
+
+    for (kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+    {
+        if (kernels & DSP_KIT_MASK(kernel))err += g_dsp_bench[kernel][type].err / 2147483648.0;
+    }
+
+    return 4 * err + ((type == DSP_TYPE_Q15) ? HOST_Q15_LSB : 1.0 / 2147483648.0 * 4);
+}
+
+/**
+ * @brief   Makes every kernel measured pick one variant: the others get the largest error
+ * @param   type: DSP_TYPE_xxx to force
+ * @param   save: copy of the results, restored by host_unforce
+ * @retval  None
+ */
+static void host_force(uint8_t type, dsp_bench_res_t save[DSP_KERNEL_NUM][DSP_TYPE_NUM])
+{
+    uint8_t kernel, t;
+
+    memcpy(save, g_dsp_bench, sizeof(g_dsp_bench));
+
+    for (kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+    {
+        for (t = 0; t < DSP_TYPE_NUM; t++)
+        {
+            if (t != type)g_dsp_bench[kernel][t].err = 0x7FFFFFFF;
+        }
+    }
+}
+
+/**
+ * @brief   Restores the results after host_force
+ * @param   save: copy of the results
+ * @retval  None
+ */
+static void host_unforce(dsp_bench_res_t save[DSP_KERNEL_NUM][DSP_TYPE_NUM])
+{
+    memcpy(g_dsp_bench, save, sizeof(g_dsp_bench));
+}
+
+/**
+ * @brief   Checks the wrappers of one variant against double references
+ * @param   type: DSP_TYPE_xxx
+ * @retval  None
+ */
+static void host_wrappers(uint8_t type)
+{
+    static q31_t sig[HOST_FFT_LEN], out[HOST_FFT_LEN];
+    static uint32_t mem[DSP_SPECTRUM_MEM(HOST_FFT_LEN) + DSP_FIR_MEM(HOST_TAPS, HOST_BLOCK) + DSP_BIQUAD_MEM(HOST_STAGES, HOST_BLOCK)];
+    static double ref[HOST_FFT_LEN];
+    dsp_bench_res_t save[DSP_KERNEL_NUM][DSP_TYPE_NUM];
+    float32_t fir[HOST_TAPS], bq[HOST_STAGES * 5];
+    double x[HOST_STAGES + 1][3] = {0};
+    double err, max, re, im, w, acc;
+    dsp_fir_t f;
+    dsp_biquad_t b;
+    dsp_spectrum_t sp;
+    uint32_t i, k, s;
+    q31_t v;
+
+    host_force(type, save);
+
+    for (i = 0; i < HOST_FFT_LEN; i++)                  /* Another signal than the bench: 0.4 of full scale */
+    {
+        sig[i] = (q31_t)((0.25 * sin(2 * M_PI * 0.011 * i) + 0.15 * cos(2 * M_PI * 0.13 * i + 0.3)) * 2147483648.0);
+    }
+
+    /* Sine */
+    for (i = 0, max = 0; i < 1024; i++)
+    {
+        v = dsp_sin((q31_t)(i * (0x80000000UL / 1024)), type);
+        err = fabs(v / 2147483648.0 - sin(2 * M_PI * i / 1024));
+        if (err > max)max = err;
+    }
+
+    CHECK(max <= host_bound(DSP_KIT_MASK(DSP_KERNEL_SIN), type), "%s dsp_sin: error %.2e", g_dsp_type_name[type], max);
+
+    /* RMS */
+    for (i = 0, acc = 0; i < HOST_LEN; i++)acc += (sig[i] / 2147483648.0) * (sig[i] / 2147483648.0);
+
+    err = fabs(dsp_rms(sig, HOST_LEN, type) / 2147483648.0 - sqrt(acc / HOST_LEN));
+    CHECK(err <= host_bound(DSP_KIT_MASK(DSP_KERNEL_RMS), type), "%s dsp_rms: error %.2e", g_dsp_type_name[type], err);
+
+    /* FIR: lowpass 0.15, in HOST_BLOCKS blocks */
+    for (i = 0, acc = 0; i < HOST_TAPS; i++)
+    {
+        w = i - (HOST_TAPS - 1) / 2.0;
+        fir[i] = 0.3 * (0.54 - 0.46 * cos(2 * M_PI * i / (HOST_TAPS - 1))) * sin(M_PI * 0.3 * w) / (M_PI * 0.3 * w);
+        acc += fir[i];
+    }
+
+    for (i = 0; i < HOST_TAPS; i++)fir[i] /= acc;
+
+    CHECK(dsp_fir_init(&f, fir, HOST_TAPS, HOST_BLOCK, mem, 0) == 0, "dsp_fir_init");
+    CHECK(f.type == type, "%s dsp_fir_init took %s", g_dsp_type_name[type], g_dsp_type_name[f.type]);
+
+    for (k = 0; k < HOST_BLOCKS; k++)dsp_fir_run(&f, sig + k * HOST_BLOCK, out + k * HOST_BLOCK);
+
+    for (i = 0, max = 0; i < HOST_LEN; i++)
+    {
+        for (k = 0, acc = 0; k < HOST_TAPS && k <= i; k++)acc += (double)fir[k] * (sig[i - k] / 2147483648.0);
+
+        err = fabs(out[i] / 2147483648.0 - acc);
+        if (err > max)max = err;
+    }
+
+    CHECK(max <= host_bound(DSP_KIT_MASK(DSP_KERNEL_FIR), type), "%s dsp_fir_run: error %.2e", g_dsp_type_name[type], max);
+
+    /* Biquad: the Butterworth of the bench at 0.08, b1 is 1 or more so the Q31/Q15 coefficients are shifted */
+    for (s = 0; s < HOST_STAGES; s++)
+    {
+        w = 2 * M_PI * 0.08;
+        re = sin(w) / (2 / (2 * cos(M_PI * (2 * s + 1) / (4 * HOST_STAGES))));
+        im = 1 + re;
+        bq[s * 5 + 0] = (1 - cos(w)) / 2 / im;
+        bq[s * 5 + 1] = (1 - cos(w)) / im;
+        bq[s * 5 + 2] = bq[s * 5 + 0];
+        bq[s * 5 + 3] = 2 * cos(w) / im;
+        bq[s * 5 + 4] = -(1 - re) / im;
+    }
+
+    CHECK(dsp_biquad_init(&b, bq, HOST_STAGES, HOST_BLOCK, mem, 0) == 0, "dsp_biquad_init");
+    CHECK(b.type == type, "%s dsp_biquad_init took %s", g_dsp_type_name[type], g_dsp_type_name[b.type]);
+
+    for (k = 0; k < HOST_BLOCKS; k++)dsp_biquad_run(&b, sig + k * HOST_BLOCK, out + k * HOST_BLOCK);
+
+    for (i = 0, max = 0; i < HOST_LEN; i++)
+    {
+        x[0][0] = sig[i] / 2147483648.0;
+
+        for (s = 0; s < HOST_STAGES; s++)
+        {
+            x[s + 1][0] = (double)bq[s * 5] * x[s][0] + (double)bq[s * 5 + 1] * x[s][1] + (double)bq[s * 5 + 2] * x[s][2]
+                        + (double)bq[s * 5 + 3] * x[s + 1][1] + (double)bq[s * 5 + 4] * x[s + 1][2];
+        }
+
+        for (s = 0; s <= HOST_STAGES; s++)
+        {
+            x[s][2] = x[s][1];
+            x[s][1] = x[s][0];
+        }
+
+        err = fabs(out[i] / 2147483648.0 - x[HOST_STAGES][0]);
+        if (err > max)max = err;
+    }
+
+    CHECK(max <= host_bound(DSP_KIT_MASK(DSP_KERNEL_BIQUAD), type), "%s dsp_biquad_run: error %.2e", g_dsp_type_name[type], max);
+
+    /* Magnitude spectrum of another length than the bench */
+    CHECK(dsp_spectrum_init(&sp, HOST_FFT_LEN, mem, 0) == 0, "dsp_spectrum_init");
+    CHECK(sp.type == type, "%s dsp_spectrum_init took %s", g_dsp_type_name[type], g_dsp_type_name[sp.type]);
+    CHECK(dsp_spectrum_init(&sp, 100, mem, 0) == 1, "dsp_spectrum_init accepts a length of 100");
+    dsp_spectrum_init(&sp, HOST_FFT_LEN, mem, 0);
+    dsp_spectrum_run(&sp, sig, out);
+
+    for (k = 0, max = 0; k < HOST_FFT_LEN / 2; k++)
+    {
+        for (i = 0, re = im = 0; i < HOST_FFT_LEN; i++)
+        {
+            re += sig[i] / 2147483648.0 * cos(2 * M_PI * (k * i % HOST_FFT_LEN) / HOST_FFT_LEN);
+            im -= sig[i] / 2147483648.0 * sin(2 * M_PI * (k * i % HOST_FFT_LEN) / HOST_FFT_LEN);
+        }
+
+        ref[k] = sqrt(re * re + im * im) / HOST_FFT_LEN;
+        err = fabs(out[k] / 2147483648.0 - ref[k]);
+        if (err > max)max = err;
+    }
+
+    CHECK(max <= host_bound(DSP_KIT_MASK(DSP_KERNEL_FFT) | DSP_KIT_MASK(DSP_KERNEL_MAG), type),
+          "%s dsp_spectrum_run: error %.2e", g_dsp_type_name[type], max);
+
+    printf("wrappers %s: checked\n", g_dsp_type_name[type]);
+    host_unforce(save);
+}
+
+int main(void)
+{
+    static const double bound[3] = {1e-2, 1e-4, 1e-6};
+    static const uint32_t masks[4] = {
+        DSP_KIT_MASK(DSP_KERNEL_FIR), DSP_KIT_MASK(DSP_KERNEL_BIQUAD), DSP_KIT_MASK(DSP_KERNEL_SIN),
+        DSP_KIT_MASK(DSP_KERNEL_FFT) | DSP_KIT_MASK(DSP_KERNEL_MAG),
+    };
+    uint32_t cycles, err, best;
+    uint8_t kernel, type, pick, i, m, meets;
+
+    dsp_bench_run();
+    dsp_bench_print();
+    printf("(cycles: nanoseconds of the host)\n\n");
+
+    /* 1. Accuracy of each format */
+    for (kernel = 0; kernel < DSP_KERNEL_NUM; kernel++)
+    {
+        for (type = 0; type < DSP_TYPE_NUM; type++)
+        {
+            CHECK(g_dsp_bench[kernel][type].cycles != 0, "%s %s not measured", g_dsp_kernel_name[kernel], g_dsp_type_name[type]);
+            CHECK(dsp_bench_bits(g_dsp_bench[kernel][type].err) >= g_min_bits[kernel][type], "%s %s: %d bits, %d expected",
+                  g_dsp_kernel_name[kernel], g_dsp_type_name[type], dsp_bench_bits(g_dsp_bench[kernel][type].err), g_min_bits[kernel][type]);
+        }
+    }
+
+    CHECK(dsp_bench_bits(0) == 31 && dsp_bench_bits(1) == 31 && dsp_bench_bits(2) == 30 && dsp_bench_bits(0xFFFFFFFF) == 0, "dsp_bench_bits");
+
+    /* 2. dsp_kit_pick */
+    for (m = 0; m < 4; m++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            pick = dsp_kit_pick(masks[m], DSP_KIT_ERR(bound[i]));
+            best = 0xFFFFFFFF;
+            meets = 0;
+
+            for (type = 0; type < DSP_TYPE_NUM; type++)
+            {
+                for (kernel = 0, cycles = 0, err = 0; kernel < DSP_KERNEL_NUM; kernel++)
+                {
+                    if ((masks[m] & DSP_KIT_MASK(kernel)) == 0)continue;
+
+                    cycles += g_dsp_bench[kernel][type].cycles;
+                    err += g_dsp_bench[kernel][type].err;
+                }
+
+                if (err <= DSP_KIT_ERR(bound[i]))
+                {
+                    meets = 1;
+                    if (cycles < best)best = cycles;
+                }
+            }
+
+            for (kernel = 0, cycles = 0, err = 0; kernel < DSP_KERNEL_NUM; kernel++)
+            {
+                if ((masks[m] & DSP_KIT_MASK(kernel)) == 0)continue;
+
+                cycles += g_dsp_bench[kernel][pick].cycles;
+                err += g_dsp_bench[kernel][pick].err;
+            }
+
+            if (meets)
+            {
+                CHECK(err <= DSP_KIT_ERR(bound[i]) && cycles == best, "dsp_kit_pick(0x%02lx, %.0e) took %s, not the fastest that meets it",
+                      (unsigned long)masks[m], bound[i], g_dsp_type_name[pick]);
+            }
+
+            printf("dsp_kit_pick(0x%02lx, %.0e): %s\n", (unsigned long)masks[m], bound[i], g_dsp_type_name[pick]);
+        }
+    }
+
+    /* 3. Wrappers */
+    for (type = 0; type < DSP_TYPE_NUM; type++)
+    {
+        host_wrappers(type);
+    }
+
+    printf(g_fails ? "FAILED\n" : "all passed\n");
+    return g_fails ? 1 : 0;
+}
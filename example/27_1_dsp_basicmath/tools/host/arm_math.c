@@ -0,0 +1,550 @@
+/**
+ ****************************************************************************************************
+ * @file        arm_math.c
+ * @author      ALIENTEK
+ * @brief       DSP functions of the host build (tools/dsp_bench_host.c)
+ *
+ *              Same interfaces and data formats as CMSIS-DSP: the Q31 FIR and biquad accumulate in
+ *              64 bits and truncate, the Q15 ones saturate, the Q15/Q31 real FFTs give the full
+ *              spectrum divided by the length, arm_rfft_fast_f32 the packed half spectrum, the
+ *              magnitudes are Q2.30/Q2.14. The FFTs are computed as a DFT in double and the sines with
+ *              the C library: the errors of the library on the board (tables, rounding of each FFT
+ *              stage) are larger, the host run checks the bench and the wrappers, not the library.
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include "arm_math.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief   Saturates to 32 bits
+ * @param   x: value
+ * @retval  Q31
+ */
+static q31_t host_sat31(q63_t x)
+{
+    if (x > 0x7FFFFFFF)return 0x7FFFFFFF;
+    if (x < -(q63_t)0x80000000)return (q31_t)0x80000000;
+
+    return (q31_t)x;
+}
+
+/**
+ * @brief   Saturates to 16 bits
+ * @param   x: value
+ * @retval  Q15
+ */
+static q15_t host_sat15(q63_t x)
+{
+    if (x > 0x7FFF)return 0x7FFF;
+    if (x < -0x8000)return (q15_t)0x8000;
+
+    return (q15_t)x;
+}
+
+/**
+ * @brief   Checks an FFT length
+ * @param   len: length
+ * @param   max: largest length
+ * @retval  1: power of 2 from 32 to max
+ */
+static int host_fft_len(uint32_t len, uint32_t max)
+{
+    return len >= 32 && len <= max && (len & (len - 1)) == 0;
+}
+
+/**
+ * @brief   Real DFT in double
+ * @param   x  : samples
+ * @param   len: length
+ * @param   k  : bin
+ * @param   re : real part
+ * @param   im : imaginary part
+ * @retval  None
+ */
+static void host_dft(const double *x, uint32_t len, uint32_t k, double *re, double *im)
+{
+    uint32_t i;
+
+    *re = *im = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        *re += x[i] * cos(2 * M_PI * ((uint64_t)k * i % len) / len);
+        *im -= x[i] * sin(2 * M_PI * ((uint64_t)k * i % len) / len);
+    }
+}
+
+/******************************************************************************************/
+/* Sines: x in turns for Q31/Q15 (0 ~ 1), in radians for float */
+
+float32_t arm_sin_f32(float32_t x)
+{
+    return sinf(x);
+}
+
+q31_t arm_sin_q31(q31_t x)
+{
+    return host_sat31((q63_t)floor(sin(2 * M_PI * x / 2147483648.0) * 2147483648.0 + 0.5));
+}
+
+q15_t arm_sin_q15(q15_t x)
+{
+    return host_sat15((q63_t)floor(sin(2 * M_PI * x / 32768.0) * 32768.0 + 0.5));
+}
+
+/******************************************************************************************/
+/* FIR: the coefficients in time reversed order, the state holds the last numTaps - 1 inputs */
+
+void arm_fir_init_f32(arm_fir_instance_f32 *S, uint16_t numTaps, float32_t *pCoeffs, float32_t *pState, uint32_t blockSize)
+{
+    S->numTaps = numTaps;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    memset(pState, 0, (numTaps + blockSize - 1) * sizeof(float32_t));
+}
+
+void arm_fir_init_q31(arm_fir_instance_q31 *S, uint16_t numTaps, q31_t *pCoeffs, q31_t *pState, uint32_t blockSize)
+{
+    S->numTaps = numTaps;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    memset(pState, 0, (numTaps + blockSize - 1) * sizeof(q31_t));
+}
+
+arm_status arm_fir_init_q15(arm_fir_instance_q15 *S, uint16_t numTaps, q15_t *pCoeffs, q15_t *pState, uint32_t blockSize)
+{
+    if (numTaps < 4 || (numTaps & 1))return ARM_MATH_ARGUMENT_ERROR;
+
+    S->numTaps = numTaps;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    memset(pState, 0, (numTaps + blockSize) * sizeof(q15_t));
+    return ARM_MATH_SUCCESS;
+}
+
+void arm_fir_f32(const arm_fir_instance_f32 *S, float32_t *pSrc, float32_t *pDst, uint32_t blockSize)
+{
+    float32_t *st = S->pState;
+    float32_t acc;
+    uint32_t i, k, n = S->numTaps;
+
+    memcpy(st + n - 1, pSrc, blockSize * sizeof(float32_t));
+
+    for (i = 0; i < blockSize; i++)
+    {
+        acc = 0;
+
+        for (k = 0; k < n; k++)acc += st[i + k] * S->pCoeffs[k];
+
+        pDst[i] = acc;
+    }
+
+    memmove(st, st + blockSize, (n - 1) * sizeof(float32_t));
+}
+
+void arm_fir_q31(const arm_fir_instance_q31 *S, q31_t *pSrc, q31_t *pDst, uint32_t blockSize)
+{
+    q31_t *st = S->pState;
+    q63_t acc;
+    uint32_t i, k, n = S->numTaps;
+
+    memcpy(st + n - 1, pSrc, blockSize * sizeof(q31_t));
+
+    for (i = 0; i < blockSize; i++)
+    {
+        acc = 0;
+
+        for (k = 0; k < n; k++)acc += (q63_t)st[i + k] * S->pCoeffs[k];
+
+        pDst[i] = (q31_t)(acc >> 31);
+    }
+
+    memmove(st, st + blockSize, (n - 1) * sizeof(q31_t));
+}
+
+void arm_fir_q15(const arm_fir_instance_q15 *S, q15_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+    q15_t *st = S->pState;
+    q63_t acc;
+    uint32_t i, k, n = S->numTaps;
+
+    memcpy(st + n - 1, pSrc, blockSize * sizeof(q15_t));
+
+    for (i = 0; i < blockSize; i++)
+    {
+        acc = 0;
+
+        for (k = 0; k < n; k++)acc += (q31_t)st[i + k] * S->pCoeffs[k];
+
+        pDst[i] = host_sat15(acc >> 15);
+    }
+
+    memmove(st, st + blockSize, (n - 1) * sizeof(q15_t));
+}
+
+/******************************************************************************************/
+/* Biquads, direct form I: b0, b1, b2, a1, a2 per stage (Q15: b0, 0, b1, b2, a1, a2), state x1 x2 y1 y2 */
+
+void arm_biquad_cascade_df1_init_f32(arm_biquad_casd_df1_inst_f32 *S, uint8_t numStages, float32_t *pCoeffs, float32_t *pState)
+{
+    S->numStages = numStages;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    memset(pState, 0, 4 * numStages * sizeof(float32_t));
+}
+
+void arm_biquad_cascade_df1_init_q31(arm_biquad_casd_df1_inst_q31 *S, uint8_t numStages, q31_t *pCoeffs, q31_t *pState, int8_t postShift)
+{
+    S->numStages = numStages;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    S->postShift = postShift;
+    memset(pState, 0, 4 * numStages * sizeof(q31_t));
+}
+
+void arm_biquad_cascade_df1_init_q15(arm_biquad_casd_df1_inst_q15 *S, uint8_t numStages, q15_t *pCoeffs, q15_t *pState, int8_t postShift)
+{
+    S->numStages = numStages;
+    S->pCoeffs = pCoeffs;
+    S->pState = pState;
+    S->postShift = postShift;
+    memset(pState, 0, 4 * numStages * sizeof(q15_t));
+}
+
+void arm_biquad_cascade_df1_f32(const arm_biquad_casd_df1_inst_f32 *S, float32_t *pSrc, float32_t *pDst, uint32_t blockSize)
+{
+    float32_t *c, *st, x, y;
+    uint32_t i, s;
+
+    for (s = 0; s < S->numStages; s++)
+    {
+        c = S->pCoeffs + 5 * s;
+        st = S->pState + 4 * s;
+
+        for (i = 0; i < blockSize; i++)
+        {
+            x = (s == 0) ? pSrc[i] : pDst[i];
+            y = c[0] * x + c[1] * st[0] + c[2] * st[1] + c[3] * st[2] + c[4] * st[3];
+            st[1] = st[0];
+            st[0] = x;
+            st[3] = st[2];
+            st[2] = y;
+            pDst[i] = y;
+        }
+    }
+}
+
+void arm_biquad_cascade_df1_q31(const arm_biquad_casd_df1_inst_q31 *S, q31_t *pSrc, q31_t *pDst, uint32_t blockSize)
+{
+    q31_t *c, *st, x, y;
+    q63_t acc;
+    uint32_t i, s;
+
+    for (s = 0; s < S->numStages; s++)
+    {
+        c = S->pCoeffs + 5 * s;
+        st = S->pState + 4 * s;
+
+        for (i = 0; i < blockSize; i++)
+        {
+            x = (s == 0) ? pSrc[i] : pDst[i];
+            acc = (q63_t)c[0] * x + (q63_t)c[1] * st[0] + (q63_t)c[2] * st[1] + (q63_t)c[3] * st[2] + (q63_t)c[4] * st[3];
+            y = (q31_t)(acc >> (31 - S->postShift));
+            st[1] = st[0];
+            st[0] = x;
+            st[3] = st[2];
+            st[2] = y;
+            pDst[i] = y;
+        }
+    }
+}
+
+void arm_biquad_cascade_df1_q15(const arm_biquad_casd_df1_inst_q15 *S, q15_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+    q15_t *c, *st, x, y;
+    q63_t acc;
+    uint32_t i, s;
+
+    for (s = 0; s < (uint32_t)S->numStages; s++)
+    {
+        c = S->pCoeffs + 6 * s;
+        st = S->pState + 4 * s;
+
+        for (i = 0; i < blockSize; i++)
+        {
+            x = (s == 0) ? pSrc[i] : pDst[i];
+            acc = (q31_t)c[0] * x + (q31_t)c[2] * st[0] + (q31_t)c[3] * st[1] + (q31_t)c[4] * st[2] + (q31_t)c[5] * st[3];
+            y = host_sat15(acc >> (15 - S->postShift));
+            st[1] = st[0];
+            st[0] = x;
+            st[3] = st[2];
+            st[2] = y;
+            pDst[i] = y;
+        }
+    }
+}
+
+/******************************************************************************************/
+/* Real FFTs */
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen)
+{
+    if (!host_fft_len(fftLen, 4096))return ARM_MATH_ARGUMENT_ERROR;
+
+    S->fftLenRFFT = fftLen;
+    return ARM_MATH_SUCCESS;
+}
+
+arm_status arm_rfft_init_q31(arm_rfft_instance_q31 *S, uint32_t fftLenReal, uint32_t ifftFlagR, uint32_t bitReverseFlag)
+{
+    if (!host_fft_len(fftLenReal, 8192))return ARM_MATH_ARGUMENT_ERROR;
+
+    S->fftLenReal = fftLenReal;
+    S->ifftFlagR = ifftFlagR;
+    S->bitReverseFlagR = bitReverseFlag;
+    return ARM_MATH_SUCCESS;
+}
+
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15 *S, uint32_t fftLenReal, uint32_t ifftFlagR, uint32_t bitReverseFlag)
+{
+    if (!host_fft_len(fftLenReal, 8192))return ARM_MATH_ARGUMENT_ERROR;
+
+    S->fftLenReal = fftLenReal;
+    S->ifftFlagR = ifftFlagR;
+    S->bitReverseFlagR = bitReverseFlag;
+    return ARM_MATH_SUCCESS;
+}
+
+/* Packed output: X[0].re, X[N/2].re, X[1].re, X[1].im ... X[N/2-1].im, not scaled. The input is overwritten */
+void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut, uint8_t ifftFlag)
+{
+    static double x[4096];
+    double re, im;
+    uint32_t i, n = S->fftLenRFFT;
+
+    for (i = 0; i < n; i++)x[i] = p[i];
+
+    for (i = 0; i < n / 2; i++)
+    {
+        host_dft(x, n, i, &re, &im);
+        pOut[2 * i] = re;
+        pOut[2 * i + 1] = im;
+    }
+
+    host_dft(x, n, n / 2, &re, &im);
+    pOut[1] = re;
+    memset(p, 0, n * sizeof(float32_t));
+}
+
+/* Full spectrum X[0] ~ X[N-1], re/im, divided by N */
+void arm_rfft_q31(const arm_rfft_instance_q31 *S, q31_t *pSrc, q31_t *pDst)
+{
+    static double x[8192];
+    double re, im;
+    uint32_t i, n = S->fftLenReal;
+
+    for (i = 0; i < n; i++)x[i] = pSrc[i];
+
+    for (i = 0; i < n; i++)
+    {
+        host_dft(x, n, i, &re, &im);
+        pDst[2 * i] = host_sat31((q63_t)floor(re / n));
+        pDst[2 * i + 1] = host_sat31((q63_t)floor(im / n));
+    }
+}
+
+void arm_rfft_q15(const arm_rfft_instance_q15 *S, q15_t *pSrc, q15_t *pDst)
+{
+    static double x[8192];
+    double re, im;
+    uint32_t i, n = S->fftLenReal;
+
+    for (i = 0; i < n; i++)x[i] = pSrc[i];
+
+    for (i = 0; i < n; i++)
+    {
+        host_dft(x, n, i, &re, &im);
+        pDst[2 * i] = host_sat15((q63_t)floor(re / n));
+        pDst[2 * i + 1] = host_sat15((q63_t)floor(im / n));
+    }
+}
+
+/******************************************************************************************/
+/* Magnitude, RMS, power */
+
+void arm_cmplx_mag_f32(float32_t *pSrc, float32_t *pDst, uint32_t numSamples)
+{
+    uint32_t i;
+
+    for (i = 0; i < numSamples; i++)pDst[i] = sqrtf(pSrc[2 * i] * pSrc[2 * i] + pSrc[2 * i + 1] * pSrc[2 * i + 1]);
+}
+
+void arm_cmplx_mag_q31(q31_t *pSrc, q31_t *pDst, uint32_t numSamples)
+{
+    double re, im;
+    uint32_t i;
+
+    for (i = 0; i < numSamples; i++)                    /* Q2.30 */
+    {
+        re = pSrc[2 * i] / 2147483648.0;
+        im = pSrc[2 * i + 1] / 2147483648.0;
+        pDst[i] = host_sat31((q63_t)(sqrt(re * re + im * im) * 1073741824.0));
+    }
+}
+
+void arm_cmplx_mag_q15(q15_t *pSrc, q15_t *pDst, uint32_t numSamples)
+{
+    double re, im;
+    uint32_t i;
+
+    for (i = 0; i < numSamples; i++)                    /* Q2.14 */
+    {
+        re = pSrc[2 * i] / 32768.0;
+        im = pSrc[2 * i + 1] / 32768.0;
+        pDst[i] = host_sat15((q63_t)(sqrt(re * re + im * im) * 16384.0));
+    }
+}
+
+void arm_rms_f32(float32_t *pSrc, uint32_t blockSize, float32_t *pResult)
+{
+    float32_t sum = 0;
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)sum += pSrc[i] * pSrc[i];
+
+    *pResult = sqrtf(sum / blockSize);
+}
+
+void arm_rms_q31(q31_t *pSrc, uint32_t blockSize, q31_t *pResult)
+{
+    q63_t sum = 0;
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)sum += ((q63_t)pSrc[i] * pSrc[i]) >> 14;      /* Q2.48 as the library */
+
+    arm_sqrt_q31(host_sat31((sum / blockSize) >> 17), pResult);
+}
+
+void arm_rms_q15(q15_t *pSrc, uint32_t blockSize, q15_t *pResult)
+{
+    q63_t sum = 0;
+    q31_t res;
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)sum += (q31_t)pSrc[i] * pSrc[i];              /* Q34.30 */
+
+    arm_sqrt_q31(host_sat31((sum / blockSize) << 1), &res);
+    *pResult = res >> 16;
+}
+
+void arm_power_f32(float32_t *pSrc, uint32_t blockSize, float32_t *pResult)
+{
+    float32_t sum = 0;
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)sum += pSrc[i] * pSrc[i];
+
+    *pResult = sum;
+}
+
+void arm_power_q15(q15_t *pSrc, uint32_t blockSize, q63_t *pResult)
+{
+    q63_t sum = 0;
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)sum += (q31_t)pSrc[i] * pSrc[i];
+
+    *pResult = sum;
+}
+
+arm_status arm_sqrt_q31(q31_t in, q31_t *pOut)
+{
+    if (in <= 0)
+    {
+        *pOut = 0;
+        return (in == 0) ? ARM_MATH_SUCCESS : ARM_MATH_ARGUMENT_ERROR;
+    }
+
+    *pOut = host_sat31((q63_t)(sqrt(in / 2147483648.0) * 2147483648.0));
+    return ARM_MATH_SUCCESS;
+}
+
+/******************************************************************************************/
+/* Conversions, shifts: truncated and saturated (ARM_MATH_ROUNDING not defined) */
+
+void arm_q31_to_float(q31_t *pSrc, float32_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)pDst[i] = (float32_t)pSrc[i] / 2147483648.0f;
+}
+
+void arm_q31_to_q15(q31_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)pDst[i] = (q15_t)(pSrc[i] >> 16);
+}
+
+void arm_q15_to_q31(q15_t *pSrc, q31_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)pDst[i] = (q31_t)pSrc[i] << 16;
+}
+
+void arm_float_to_q31(float32_t *pSrc, q31_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)pDst[i] = host_sat31((q63_t)(pSrc[i] * 2147483648.0f));
+}
+
+void arm_float_to_q15(float32_t *pSrc, q15_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)pDst[i] = host_sat15((q31_t)(pSrc[i] * 32768.0f));
+}
+
+void arm_shift_q31(q31_t *pSrc, int8_t shiftBits, q31_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)
+    {
+        pDst[i] = (shiftBits >= 0) ? host_sat31((q63_t)pSrc[i] << shiftBits) : pSrc[i] >> -shiftBits;
+    }
+}
+
+void arm_shift_q15(q15_t *pSrc, int8_t shiftBits, q15_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)
+    {
+        pDst[i] = (shiftBits >= 0) ? host_sat15((q31_t)pSrc[i] << shiftBits) : pSrc[i] >> -shiftBits;
+    }
+}
+
+void arm_scale_f32(float32_t *pSrc, float32_t scale, float32_t *pDst, uint32_t blockSize)
+{
+    uint32_t i;
+
+    for (i = 0; i < blockSize; i++)pDst[i] = pSrc[i] * scale;
+}
@@ -0,0 +1,158 @@
+/**
+ ****************************************************************************************************
+ * @file        arm_math.h
+ * @author      ALIENTEK
+ * @brief       arm_math.h of the host build (tools/dsp_bench_host.c)
+ *
+ *              The DSP library of the board is a Cortex-M3 binary. The host build has the types and
+ *              the functions used by DSPKIT only, implemented in arm_math.c with the same data
+ *              formats, scaling, truncation and saturation as the CMSIS-DSP sources.
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __ARM_MATH_H
+#define __ARM_MATH_H
+
+#include <stdint.h>
+
+#define PI                  3.14159265358979f
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float float32_t;
+
+typedef enum
+{
+    ARM_MATH_SUCCESS = 0,
+    ARM_MATH_ARGUMENT_ERROR = -1,
+    ARM_MATH_LENGTH_ERROR = -2,
+    ARM_MATH_SIZE_MISMATCH = -3,
+    ARM_MATH_NANINF = -4,
+    ARM_MATH_SINGULAR = -5,
+    ARM_MATH_TEST_FAILURE = -6
+} arm_status;
+
+typedef struct
+{
+    uint16_t numTaps;
+    q15_t *pState;
+    q15_t *pCoeffs;
+} arm_fir_instance_q15;
+
+typedef struct
+{
+    uint16_t numTaps;
+    q31_t *pState;
+    q31_t *pCoeffs;
+} arm_fir_instance_q31;
+
+typedef struct
+{
+    uint16_t numTaps;
+    float32_t *pState;
+    float32_t *pCoeffs;
+} arm_fir_instance_f32;
+
+typedef struct
+{
+    int8_t numStages;
+    q15_t *pState;
+    q15_t *pCoeffs;
+    int8_t postShift;
+} arm_biquad_casd_df1_inst_q15;
+
+typedef struct
+{
+    uint32_t numStages;
+    q31_t *pState;
+    q31_t *pCoeffs;
+    uint8_t postShift;
+} arm_biquad_casd_df1_inst_q31;
+
+typedef struct
+{
+    uint32_t numStages;
+    float32_t *pState;
+    float32_t *pCoeffs;
+} arm_biquad_casd_df1_inst_f32;
+
+typedef struct
+{
+    uint32_t fftLenReal;
+    uint8_t ifftFlagR;
+    uint8_t bitReverseFlagR;
+} arm_rfft_instance_q15;
+
+typedef struct
+{
+    uint32_t fftLenReal;
+    uint8_t ifftFlagR;
+    uint8_t bitReverseFlagR;
+} arm_rfft_instance_q31;
+
+typedef struct
+{
+    uint16_t fftLenRFFT;
+} arm_rfft_fast_instance_f32;
+
+float32_t arm_sin_f32(float32_t x);
+q31_t arm_sin_q31(q31_t x);
+q15_t arm_sin_q15(q15_t x);
+
+void arm_fir_init_f32(arm_fir_instance_f32 *S, uint16_t numTaps, float32_t *pCoeffs, float32_t *pState, uint32_t blockSize);
+void arm_fir_init_q31(arm_fir_instance_q31 *S, uint16_t numTaps, q31_t *pCoeffs, q31_t *pState, uint32_t blockSize);
+arm_status arm_fir_init_q15(arm_fir_instance_q15 *S, uint16_t numTaps, q15_t *pCoeffs, q15_t *pState, uint32_t blockSize);
+void arm_fir_f32(const arm_fir_instance_f32 *S, float32_t *pSrc, float32_t *pDst, uint32_t blockSize);
+void arm_fir_q31(const arm_fir_instance_q31 *S, q31_t *pSrc, q31_t *pDst, uint32_t blockSize);
+void arm_fir_q15(const arm_fir_instance_q15 *S, q15_t *pSrc, q15_t *pDst, uint32_t blockSize);
+
+void arm_biquad_cascade_df1_init_f32(arm_biquad_casd_df1_inst_f32 *S, uint8_t numStages, float32_t *pCoeffs, float32_t *pState);
+void arm_biquad_cascade_df1_init_q31(arm_biquad_casd_df1_inst_q31 *S, uint8_t numStages, q31_t *pCoeffs, q31_t *pState, int8_t postShift);
+void arm_biquad_cascade_df1_init_q15(arm_biquad_casd_df1_inst_q15 *S, uint8_t numStages, q15_t *pCoeffs, q15_t *pState, int8_t postShift);
+void arm_biquad_cascade_df1_f32(const arm_biquad_casd_df1_inst_f32 *S, float32_t *pSrc, float32_t *pDst, uint32_t blockSize);
+void arm_biquad_cascade_df1_q31(const arm_biquad_casd_df1_inst_q31 *S, q31_t *pSrc, q31_t *pDst, uint32_t blockSize);
+void arm_biquad_cascade_df1_q15(const arm_biquad_casd_df1_inst_q15 *S, q15_t *pSrc, q15_t *pDst, uint32_t blockSize);
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen);
+arm_status arm_rfft_init_q31(arm_rfft_instance_q31 *S, uint32_t fftLenReal, uint32_t ifftFlagR, uint32_t bitReverseFlag);
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15 *S, uint32_t fftLenReal, uint32_t ifftFlagR, uint32_t bitReverseFlag);
+void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut, uint8_t ifftFlag);
+void arm_rfft_q31(const arm_rfft_instance_q31 *S, q31_t *pSrc, q31_t *pDst);
+void arm_rfft_q15(const arm_rfft_instance_q15 *S, q15_t *pSrc, q15_t *pDst);
+
+void arm_cmplx_mag_f32(float32_t *pSrc, float32_t *pDst, uint32_t numSamples);
+void arm_cmplx_mag_q31(q31_t *pSrc, q31_t *pDst, uint32_t numSamples);
+void arm_cmplx_mag_q15(q15_t *pSrc, q15_t *pDst, uint32_t numSamples);
+
+void arm_rms_f32(float32_t *pSrc, uint32_t blockSize, float32_t *pResult);
+void arm_rms_q31(q31_t *pSrc, uint32_t blockSize, q31_t *pResult);
+void arm_rms_q15(q15_t *pSrc, uint32_t blockSize, q15_t *pResult);
+void arm_power_f32(float32_t *pSrc, uint32_t blockSize, float32_t *pResult);
+void arm_power_q15(q15_t *pSrc, uint32_t blockSize, q63_t *pResult);
+arm_status arm_sqrt_q31(q31_t in, q31_t *pOut);
+
+void arm_q31_to_float(q31_t *pSrc, float32_t *pDst, uint32_t blockSize);
+void arm_q31_to_q15(q31_t *pSrc, q15_t *pDst, uint32_t blockSize);
+void arm_q15_to_q31(q15_t *pSrc, q31_t *pDst, uint32_t blockSize);
+void arm_float_to_q31(float32_t *pSrc, q31_t *pDst, uint32_t blockSize);
+void arm_float_to_q15(float32_t *pSrc, q15_t *pDst, uint32_t blockSize);
+
+void arm_shift_q31(q31_t *pSrc, int8_t shiftBits, q31_t *pDst, uint32_t blockSize);
+void arm_shift_q15(q15_t *pSrc, int8_t shiftBits, q15_t *pDst, uint32_t blockSize);
+void arm_scale_f32(float32_t *pSrc, float32_t scale, float32_t *pDst, uint32_t blockSize);
+
+#endif
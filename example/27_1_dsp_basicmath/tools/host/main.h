@@ -0,0 +1,33 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host build (tools/dsp_bench_host.c): the cycle counter of dsp_bench.h
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* The "cycles" of dsp_bench are nanoseconds of the host */
+uint32_t host_ns(void);
+
+#define DSP_BENCH_CYCLES_INIT() do { } while (0)
+#define DSP_BENCH_CYCLES()      host_ns()
+
+#endif
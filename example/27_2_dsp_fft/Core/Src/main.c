@@ -15,12 +15,16 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     continuous spectrum of ADC1_IN1: circular DMA, Q15 real FFT, bar display
+ * V1.2         20261019     the frame is taken with the interrupts off, KEY0 prints the cycles of the real FFTs
  *
  ****************************************************************************************************
  */
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "adc.h"
+#include "dma.h"
 #include "tim.h"
 #include "usart.h"
 #include "gpio.h"
@@ -37,12 +41,30 @@
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
 
-/* FFT length, default is 1024-point FFT
- * The possible ranges are: 16, 64, 256, 1024.
+/* FFT length (real samples), default is 1024-point FFT
+ * The possible ranges are: 32, 64, 128, 256, 512, 1024, 2048.
  */
 #define FFT_LENGTH      1024
-float fft_inputbuf[FFT_LENGTH * 2];     /* FFT input array */
-float fft_outputbuf[FFT_LENGTH];        /* FFT output array */
+#define FFT_FS          10000                   /* Sample rate in Hz, TIM3 update (1MHz / 100) triggers ADC1 */
+#define FFT_BAR_NUM     64                      /* Bars of the spectrum, FFT_LENGTH / 2 must be a multiple */
+#define FFT_BAR_BINS    (FFT_LENGTH / 2 / FFT_BAR_NUM)
+
+static uint16_t g_adc_buf[FFT_LENGTH * 2];              /* ADC circular DMA buffer: two frames */
+static uint16_t * volatile g_adc_frame = NULL;          /* Frame ready for the FFT, set by the DMA callbacks */
+static volatile uint32_t g_adc_overrun = 0;             /* Frames dropped because the FFT was too slow */
+
+static q15_t g_fft_window[FFT_LENGTH];                  /* Hann window, Q15 */
+static q15_t fft_inputbuf[FFT_LENGTH];                  /* FFT input array (modified by arm_rfft_q15) */
+static q15_t fft_outputbuf[FFT_LENGTH * 2];             /* FFT output array, complex */
+static uint16_t g_fft_bar[FFT_BAR_NUM];                 /* Height of the bars on the LCD */
+
+/* Cycles of the real FFTs of each length and data type (KEY0) */
+#define FFT_BENCH_MIN       64
+#define FFT_BENCH_MAX       1024
+#define FFT_BENCH_REPEAT    3                           /* Runs of each FFT, the fastest one is kept */
+
+static uint32_t g_bench_in[FFT_BENCH_MAX];              /* Input in the format of the FFT under test */
+static uint32_t g_bench_out[FFT_BENCH_MAX * 2];         /* Output, the Q15/Q31 real FFTs give 2 * length values */
 
 uint8_t g_timeout;
 
@@ -73,6 +95,237 @@ void SystemClock_Config(void);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+/**
+ * @brief   ADC DMA half transfer: the first frame is complete
+ * @param   hadc: ADC handle
+ * @retval  None
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (g_adc_frame != NULL)g_adc_overrun++;
+
+    g_adc_frame = &g_adc_buf[0];
+}
+
+/**
+ * @brief   ADC DMA transfer complete: the second frame is complete
+ * @param   hadc: ADC handle
+ * @retval  None
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (g_adc_frame != NULL)g_adc_overrun++;
+
+    g_adc_frame = &g_adc_buf[FFT_LENGTH];
+}
+
+/**
+ * @brief   Fills a rectangle in one burst (a single window, no cursor per line)
+ * @param   x    : left
+ * @param   y    : top
+ * @param   w    : width
+ * @param   h    : height
+ * @param   color: color
+ * @retval  None
+ */
+static void fft_fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    uint32_t n = (uint32_t)w * h;
+
+    if (n == 0)return;
+
+    lcd_set_window(x, y, w, h);
+    lcd_write_ram_prepare();
+
+    while (n--)
+    {
+        LCD->LCD_RAM = color;
+    }
+
+    lcd_set_window(0, 0, lcddev.width, lcddev.height);  /* lcd_set_cursor only moves the start of the window */
+}
+
+/**
+ * @brief   Magnitude to bar height: log2 in 1/16 steps (0 ~ 255)
+ * @param   mag: magnitude, Q14
+ * @retval  height, 0 ~ 255
+ */
+static uint16_t fft_log2(uint32_t mag)
+{
+    uint32_t n;
+
+    if (mag == 0)return 0;
+
+    n = 31 - __CLZ(mag);                                /* Integer part */
+
+    return (n << 4) | (((mag << (31 - n)) >> 27) & 0x0F);   /* Four bits of the mantissa */
+}
+
+/**
+ * @brief   Windows a frame into fft_inputbuf
+ * @param   frame: ADC samples (12 bit)
+ * @retval  None
+ */
+static void fft_load(const uint16_t *frame)
+{
+    uint16_t i;
+
+    for (i = 0; i < FFT_LENGTH; i++)
+    {
+        fft_inputbuf[i] = ((q31_t)((int16_t)frame[i] - 2048) * 16 * g_fft_window[i]) >> 15;    /* 12 bit to Q15 */
+    }
+}
+
+/**
+ * @brief   Bar heights and peak of the spectrum in fft_outputbuf
+ * @note    The magnitudes are computed FFT_BAR_BINS at a time and only the maximum of each bar is
+ *          kept, no magnitude array is needed
+ * @param   bar : height of each bar, 0 ~ 255
+ * @param   peak: bin with the largest magnitude (DC excluded)
+ * @retval  None
+ */
+static void fft_spectrum(uint16_t *bar, uint16_t *peak)
+{
+    q15_t mag[FFT_BAR_BINS];
+    q15_t maxval, peakval = 0;
+    uint32_t idx;
+    uint16_t i;
+
+    *peak = 0;
+
+    for (i = 0; i < FFT_BAR_NUM; i++)
+    {
+        arm_cmplx_mag_q15(&fft_outputbuf[2 * FFT_BAR_BINS * i], mag, FFT_BAR_BINS);
+
+        if (i == 0)mag[0] = 0;                          /* DC */
+
+        arm_max_q15(mag, FFT_BAR_BINS, &maxval, &idx);
+        bar[i] = fft_log2(maxval);
+
+        if (maxval > peakval)
+        {
+            peakval = maxval;
+            *peak = FFT_BAR_BINS * i + idx;
+        }
+    }
+}
+
+/**
+ * @brief   Draws the bars that changed, only the pixels between the old and the new height
+ * @param   bar: height of each bar, 0 ~ 255
+ * @retval  None
+ */
+static void fft_draw(const uint16_t *bar)
+{
+    uint16_t w = (lcddev.width - 20) / FFT_BAR_NUM;
+    uint16_t bottom = lcddev.height - 10;
+    uint16_t area = lcddev.height - 180;
+    uint16_t x, h, i;
+
+    if (w < 2)w = 2;
+
+    for (i = 0; i < FFT_BAR_NUM; i++)
+    {
+        x = 10 + i * w;
+        h = (uint32_t)bar[i] * area / 256;
+
+        if (h > g_fft_bar[i])
+        {
+            fft_fill(x, bottom - h, w - 1, h - g_fft_bar[i], BLUE);
+        }
+        else if (h < g_fft_bar[i])
+        {
+            fft_fill(x, bottom - g_fft_bar[i], w - 1, g_fft_bar[i] - h, WHITE);
+        }
+
+        g_fft_bar[i] = h;
+    }
+}
+
+/**
+ * @brief   Cycles of one real FFT, the fastest of FFT_BENCH_REPEAT runs
+ * @note    The input is rebuilt before each run (the FFTs overwrite it): two sines and a DC offset
+ *          at 0.4 of full scale
+ * @param   len : FFT length
+ * @param   type: 0: Q15 (arm_rfft_q15), 1: Q31 (arm_rfft_q31), 2: F32 (arm_rfft_fast_f32)
+ * @retval  cycles
+ */
+static uint32_t fft_bench_one(uint16_t len, uint8_t type)
+{
+    static union
+    {
+        arm_rfft_instance_q15 q15;
+        arm_rfft_instance_q31 q31;
+        arm_rfft_fast_instance_f32 f32;
+    } inst;
+    uint32_t best = 0xFFFFFFFF, t;
+    q31_t v;
+    uint16_t i;
+    uint8_t r;
+
+    if (type == 0)arm_rfft_init_q15(&inst.q15, len, 0, 1);
+    else if (type == 1)arm_rfft_init_q31(&inst.q31, len, 0, 1);
+    else arm_rfft_fast_init_f32(&inst.f32, len);
+
+    for (r = 0; r < FFT_BENCH_REPEAT; r++)
+    {
+        for (i = 0; i < len; i++)
+        {
+            v = (arm_sin_q31((i * (0x80000000 / len) * 5) & 0x7FFFFFFF) >> 2) +      /* Phase 0 ~ 1 for one turn */
+                (arm_sin_q31((i * (0x80000000 / len) * 37) & 0x7FFFFFFF) >> 3) + 0x04000000;
+
+            if (type == 0)((q15_t *)g_bench_in)[i] = v >> 16;
+            else if (type == 1)((q31_t *)g_bench_in)[i] = v;
+            else ((float32_t *)g_bench_in)[i] = v / 2147483648.0f;
+        }
+
+        t = DWT->CYCCNT;
+
+        if (type == 0)arm_rfft_q15(&inst.q15, (q15_t *)g_bench_in, (q15_t *)g_bench_out);
+        else if (type == 1)arm_rfft_q31(&inst.q31, (q31_t *)g_bench_in, (q31_t *)g_bench_out);
+        else arm_rfft_fast_f32(&inst.f32, (float32_t *)g_bench_in, (float32_t *)g_bench_out, 0);
+
+        t = DWT->CYCCNT - t;
+
+        if (t < best)best = t;
+    }
+
+    return best;
+}
+
+/**
+ * @brief   Prints the cycles of the real FFT for each length and data type
+ * @note    The load is the share of the CPU that the FFT takes when a frame of that length comes
+ *          every length / FFT_FS seconds. The sampling is stopped during the measurement
+ * @param   None
+ * @retval  None
+ */
+static void fft_bench(void)
+{
+    uint32_t cyc[3], frame;
+    uint16_t len;
+    uint8_t type;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;    /* DWT cycle counter */
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    printf("\r\nReal FFT, cycles per frame (fastest of %d), load at %dHz and %luMHz\r\n", FFT_BENCH_REPEAT, FFT_FS, SystemCoreClock / 1000000);
+    printf("  len       Q15       Q31       F32   Q15 load  Q31 load  F32 load\r\n");
+
+    for (len = FFT_BENCH_MIN; len <= FFT_BENCH_MAX; len <<= 1)
+    {
+        for (type = 0; type < 3; type++)
+        {
+            cyc[type] = fft_bench_one(len, type);
+        }
+
+        frame = (uint32_t)((uint64_t)SystemCoreClock * len / FFT_FS);   /* Cycles between two frames */
+
+        printf("%5d %9lu %9lu %9lu %9.2f%% %8.2f%% %8.2f%%\r\n", len, cyc[0], cyc[1], cyc[2],
+               100.0f * cyc[0] / frame, 100.0f * cyc[1] / frame, 100.0f * cyc[2] / frame);
+    }
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -86,8 +339,13 @@ int main(void)
     uint8_t key;
     float time;
     char buf[50];
-    arm_cfft_radix4_instance_f32 scfft;
+    arm_rfft_instance_q15 srfft;
+    uint16_t bar[FFT_BAR_NUM];
+    uint16_t peak;
+    uint16_t *frame;
+    uint8_t print = 0;
     uint16_t i;
+    uint32_t primask;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -110,7 +368,10 @@ int main(void)
   MX_GPIO_Init();
   MX_USART1_UART_Init();
   MX_FSMC_Init();
+  MX_DMA_Init();
   MX_TIM6_Init();
+  MX_TIM3_Init();
+  MX_ADC1_Init();
   /* USER CODE BEGIN 2 */
 
   lcd_init();
@@ -119,10 +380,19 @@ int main(void)
   lcd_show_string(30, 70, 200, 16, 16, "DSP FFT TEST", RED);
   lcd_show_string(30, 90, 200, 16, 16, "ATOM@ALIENTEK", RED);
 
-  lcd_show_string(30, 110, 200, 16, 16, "WKUP:Run FFT", RED);
+  lcd_show_string(30, 110, 200, 16, 16, "WKUP:Spectrum KEY0:Cycles", RED);
   lcd_show_string(30, 130, 200, 16, 16, "FFT runtime:", RED);
+  lcd_show_string(30, 150, 200, 16, 16, "Peak:", RED);
+
+  arm_rfft_init_q15(&srfft, FFT_LENGTH, 0, 1);
 
-  arm_cfft_radix4_init_f32(&scfft, FFT_LENGTH, 0, 1);
+  for (i = 0; i < FFT_LENGTH; i++)                  /* Hann window: (1 - cos(2 * PI * i / N)) / 2 */
+  {
+      g_fft_window[i] = (32767 - arm_cos_q15(i * (32768 / FFT_LENGTH))) / 2;
+  }
+
+  HAL_ADC_Start_DMA(&hadc1, (uint32_t *)g_adc_buf, FFT_LENGTH * 2);  /* Circular, a callback for each half */
+  HAL_TIM_Base_Start(&htim3);                                       /* Sampling starts */
 
   /* USER CODE END 2 */
 
@@ -133,34 +403,55 @@ int main(void)
     /* USER CODE END WHILE */
 	  key = key_scan(0);
 
-      if (key == WKUP_PRES)
+	  if (key == WKUP_PRES)
 	  {
-	  	for (i = 0; i < FFT_LENGTH; i++)	/* Generating signal sequences */
-	  	{
-	  		fft_inputbuf[2 * i] = 100 +
-	  							  10 * arm_sin_f32(2 * PI * i / FFT_LENGTH) +
-	  							  30 * arm_sin_f32(2 * PI * i * 4 / FFT_LENGTH) +
-	  							 50 * arm_cos_f32(2 * PI * i * 8 / FFT_LENGTH);    /* Generate the real part of the input signal */
-	  		fft_inputbuf[2 * i + 1] = 0; 	/* The imaginary part is all 0 */
-	  	}
+	  	print = 1;                                                      /* Print the next spectrum */
+	  }
+	  else if (key == KEY0_PRES)
+	  {
+	  	HAL_TIM_Base_Stop(&htim3);                                      /* No frame is dropped during the measurement */
+	  	fft_bench();
+	  	g_adc_frame = NULL;
+	  	HAL_TIM_Base_Start(&htim3);
+	  }
+
+	  primask = __get_PRIMASK();                                        /* Take the frame and clear it at once, a callback in */
+	  __disable_irq();                                                  /* between would be lost without being counted */
+	  frame = g_adc_frame;
+	  g_adc_frame = NULL;
+	  __set_PRIMASK(primask);
 
+	  if (frame != NULL)
+	  {
 	  	TIM6->CNT = 0; 			/* Resets the counter value of the TIM6 timer */
 	  	g_timeout = 0;
+	  	fft_load(frame);                                                /* Window the frame, DMA may overwrite it afterwards */
 
-	  	arm_cfft_radix4_f32(&scfft, fft_inputbuf);                      /* FFT calculation (radix 4) */
+	  	if (g_adc_frame != NULL)                                        /* The other half completed during the copy: */
+	  	{
+	  		g_adc_overrun++;                                            /* the DMA was already writing this frame */
+	  	}
 
+	  	arm_rfft_q15(&srfft, fft_inputbuf, fft_outputbuf);              /* Real FFT calculation */
+	  	fft_spectrum(bar, &peak);
 	  	time = TIM6->CNT + (uint32_t)g_timeout * 65536;        	        /* Time taken to calculate */
-	  	sprintf((char *)buf, "%0.3fms\r\n", time / 10);
-	  	lcd_show_string(126, 130, 200, 16, 16, buf, BLUE);      		/* Displaying the running time */
-
-	  	arm_cmplx_mag_f32(fft_inputbuf, fft_outputbuf, FFT_LENGTH);     /* The magnitude is obtained modulo the complex number of the operation result */
+	  	fft_draw(bar);
 
-	  	printf("\r\n%d point FFT runtime:%0.3fms\r\n", FFT_LENGTH, time / 1000);
-	  	printf("FFT Result:\r\n");
+	  	sprintf((char *)buf, "%0.3fms  ", time / 10);
+	  	lcd_show_string(126, 130, 200, 16, 16, buf, BLUE);      		/* Displaying the running time */
+	  	sprintf((char *)buf, "%luHz  ", (uint32_t)peak * FFT_FS / FFT_LENGTH);
+	  	lcd_show_string(126, 150, 200, 16, 16, buf, BLUE);      		/* Frequency of the peak */
 
-	  	for (i = 0; i < FFT_LENGTH; i++)
+	  	if (print)
 	  	{
-	  		printf("fft_outputbuf[%d]:%f\r\n", i, fft_outputbuf[i]);
+	  		print = 0;
+	  		printf("\r\n%d point real FFT runtime:%0.3fms, dropped frames:%lu\r\n", FFT_LENGTH, time / 10, g_adc_overrun);
+	  		printf("Spectrum (log2 x16 of each %dHz band):\r\n", FFT_FS / 2 / FFT_BAR_NUM);
+
+	  		for (i = 0; i < FFT_BAR_NUM; i++)
+	  		{
+	  			printf("bar[%d]:%d\r\n", i, bar[i]);
+	  		}
 	  	}
 	  }
 	  else
@@ -188,6 +479,7 @@ void SystemClock_Config(void)
 {
   RCC_OscInitTypeDef RCC_OscInitStruct = {0};
   RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+  RCC_PeriphCLKInitTypeDef PeriphClkInit = {0};
 
   /** Initializes the RCC Oscillators according to the specified parameters
   * in the RCC_OscInitTypeDef structure.
@@ -217,6 +509,12 @@ void SystemClock_Config(void)
   {
     Error_Handler();
   }
+  PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_ADC;
+  PeriphClkInit.AdcClockSelection = RCC_ADCPCLK2_DIV6;
+  if (HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit) != HAL_OK)
+  {
+    Error_Handler();
+  }
 }
 
 /* USER CODE BEGIN 4 */
@@ -0,0 +1,402 @@
+/**
+ ****************************************************************************************************
+ * @file        ncr_prep.c
+ * @author      ALIENTEK
+ * @brief       Stroke preprocessing for ATKNCR
+ *
+ *              The recognition time of alientek_ncr grows with the number of points, and a touch
+ *              screen gives many points where the pen moves slowly and few where it moves fast.
+ *              Before the recognition the character is:
+ *              1. recorded stroke by stroke, points closer than g_ncr_prep.dist are not kept. When
+ *                 the buffer is full every other point is dropped and the distance doubled, so a
+ *                 long character is never cut;
+ *              2. scaled into a NCR_PREP_BOX box, keeping its proportions;
+ *              3. resampled at a constant distance along each stroke;
+ *              4. simplified with Douglas-Peucker, the tolerance is doubled until the points fit.
+ *              Everything is integer, the coordinates are kept in 1/16 unit (Q4) during 3 and 4.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     past NCR_PREP_STROKE_MAX strokes the points are really joined to the last stroke
+ *
+ ****************************************************************************************************
+ */
+
+#include "ncr_prep.h"
+
+#define NCR_PREP_WORK_MAX       NCR_PREP_RAW_MAX
+
+ncr_prep_t g_ncr_prep = {.dist = NCR_PREP_DIST};
+
+/* Resampled points, Q4 box coordinates */
+static int16_t g_ncr_wx[NCR_PREP_WORK_MAX];
+static int16_t g_ncr_wy[NCR_PREP_WORK_MAX];
+static uint8_t g_ncr_keep[NCR_PREP_WORK_MAX];           /* Point kept by Douglas-Peucker */
+static uint16_t g_ncr_wend[NCR_PREP_STROKE_MAX];        /* Index after the last point of each stroke */
+
+/**
+ * @brief   Integer square root
+ * @param   v: value
+ * @retval  floor(sqrt(v))
+ */
+static uint32_t ncr_prep_sqrt(uint32_t v)
+{
+    uint32_t r = 0;
+    uint32_t b = 1UL << 30;
+
+    while (b > v)b >>= 2;
+
+    while (b)
+    {
+        if (v >= r + b)
+        {
+            v -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+        {
+            r >>= 1;
+        }
+
+        b >>= 2;
+    }
+
+    return r;
+}
+
+/**
+ * @brief   First point of a stroke
+ * @param   s: stroke
+ * @retval  index
+ */
+static uint16_t ncr_prep_start(uint8_t s)
+{
+    return s ? g_ncr_prep.end[s - 1] : 0;
+}
+
+/**
+ * @brief   Drops every other point of each stroke, the first and the last points are kept
+ * @param   None
+ * @retval  None
+ */
+static void ncr_prep_compact(void)
+{
+    uint16_t i, start, end;
+    uint16_t n = 0;
+    uint8_t s;
+
+    for (s = 0; s <= g_ncr_prep.stroke; s++)            /* The finished strokes and the current one */
+    {
+        start = ncr_prep_start(s);
+        end = (s < g_ncr_prep.stroke) ? g_ncr_prep.end[s] : g_ncr_prep.num;
+
+        for (i = start; i < end; i++)
+        {
+            if (((i - start) & 1) == 0 || i == end - 1)
+            {
+                g_ncr_prep.pt[n++] = g_ncr_prep.pt[i];
+            }
+        }
+
+        if (s < g_ncr_prep.stroke)g_ncr_prep.end[s] = n;
+    }
+
+    g_ncr_prep.num = n;
+}
+
+/**
+ * @brief   Starts a new character
+ * @param   None
+ * @retval  None
+ */
+void ncr_prep_reset(void)
+{
+    g_ncr_prep.num = 0;
+    g_ncr_prep.stroke = 0;
+    g_ncr_prep.dist = NCR_PREP_DIST;
+}
+
+/**
+ * @brief   Records a point of the current stroke
+ * @param   x: X (screen)
+ * @param   y: Y (screen)
+ * @retval  None
+ */
+void ncr_prep_add(uint16_t x, uint16_t y)
+{
+    atk_ncr_point *last;
+    int32_t dx, dy;
+
+    if (g_ncr_prep.num > ncr_prep_start(g_ncr_prep.stroke))     /* The stroke has points */
+    {
+        last = &g_ncr_prep.pt[g_ncr_prep.num - 1];
+        dx = (int32_t)x - last->x;
+        dy = (int32_t)y - last->y;
+
+        if (dx * dx + dy * dy < (int32_t)g_ncr_prep.dist * g_ncr_prep.dist)return;
+    }
+
+    if (g_ncr_prep.num == NCR_PREP_RAW_MAX)
+    {
+        ncr_prep_compact();
+
+        if (g_ncr_prep.dist < 128)g_ncr_prep.dist <<= 1;
+
+        if (g_ncr_prep.num == NCR_PREP_RAW_MAX)return;
+    }
+
+    g_ncr_prep.pt[g_ncr_prep.num].x = x;
+    g_ncr_prep.pt[g_ncr_prep.num].y = y;
+    g_ncr_prep.num++;
+}
+
+/**
+ * @brief   The pen left the screen, finishes the current stroke
+ * @param   None
+ * @retval  None
+ */
+void ncr_prep_end(void)
+{
+    if (g_ncr_prep.stroke == NCR_PREP_STROKE_MAX)                      /* The points since go to the last stroke */
+    {
+        g_ncr_prep.end[NCR_PREP_STROKE_MAX - 1] = g_ncr_prep.num;
+        return;
+    }
+
+    if (g_ncr_prep.num > ncr_prep_start(g_ncr_prep.stroke))
+    {
+        g_ncr_prep.end[g_ncr_prep.stroke++] = g_ncr_prep.num;
+    }
+}
+
+/**
+ * @brief   Resamples the strokes at a constant distance, in Q4 box coordinates
+ * @param   k   : scale, Q16
+ * @param   ox  : X offset of the box, Q4
+ * @param   oy  : Y offset of the box, Q4
+ * @param   minx: left of the character (screen)
+ * @param   miny: top of the character (screen)
+ * @retval  number of points
+ */
+static uint16_t ncr_prep_resample(int32_t k, int32_t ox, int32_t oy, int16_t minx, int16_t miny)
+{
+    int32_t px, py, cx, cy, dx, dy;
+    uint32_t len = 0;
+    uint32_t step, d, acc;
+    uint16_t i, start, end;
+    uint16_t n = 0;
+    uint8_t s;
+
+    /* Total length, so that the step can be made longer when the points would not fit */
+    for (s = 0; s < g_ncr_prep.stroke; s++)
+    {
+        start = ncr_prep_start(s);
+
+        for (i = start + 1; i < g_ncr_prep.end[s]; i++)
+        {
+            dx = ((g_ncr_prep.pt[i].x - g_ncr_prep.pt[i - 1].x) * k) >> 12;
+            dy = ((g_ncr_prep.pt[i].y - g_ncr_prep.pt[i - 1].y) * k) >> 12;
+            len += ncr_prep_sqrt(dx * dx + dy * dy);
+        }
+    }
+
+    step = NCR_PREP_STEP << 4;
+
+    if (len / step > (uint32_t)(NCR_PREP_WORK_MAX - 2 * g_ncr_prep.stroke))
+    {
+        step = len / (NCR_PREP_WORK_MAX - 2 * g_ncr_prep.stroke) + 1;
+    }
+
+    for (s = 0; s < g_ncr_prep.stroke; s++)
+    {
+        start = ncr_prep_start(s);
+        end = g_ncr_prep.end[s];
+
+        px = (((g_ncr_prep.pt[start].x - minx) * k) >> 12) + ox;
+        py = (((g_ncr_prep.pt[start].y - miny) * k) >> 12) + oy;
+        g_ncr_wx[n] = px;
+        g_ncr_wy[n] = py;
+        n++;
+        acc = 0;
+
+        for (i = start + 1; i < end; i++)
+        {
+            cx = (((g_ncr_prep.pt[i].x - minx) * k) >> 12) + ox;
+            cy = (((g_ncr_prep.pt[i].y - miny) * k) >> 12) + oy;
+            d = ncr_prep_sqrt((cx - px) * (cx - px) + (cy - py) * (cy - py));
+
+            /* Points on the segment every step, room is left for the ends of the strokes */
+            while (d && acc + d >= step && n + 2 * (g_ncr_prep.stroke - s) <= NCR_PREP_WORK_MAX)
+            {
+                px += (int32_t)(cx - px) * (int32_t)(step - acc) / (int32_t)d;
+                py += (int32_t)(cy - py) * (int32_t)(step - acc) / (int32_t)d;
+                g_ncr_wx[n] = px;
+                g_ncr_wy[n] = py;
+                n++;
+                d = ncr_prep_sqrt((cx - px) * (cx - px) + (cy - py) * (cy - py));
+                acc = 0;
+            }
+
+            acc += d;
+            px = cx;
+            py = cy;
+        }
+
+        if (acc)                                                        /* The end of the stroke */
+        {
+            g_ncr_wx[n] = px;
+            g_ncr_wy[n] = py;
+            n++;
+        }
+
+        g_ncr_wend[s] = n;
+    }
+
+    return n;
+}
+
+/**
+ * @brief   Douglas-Peucker on each stroke of the resampled points
+ * @param   num: number of resampled points
+ * @param   eps: tolerance, Q4
+ * @retval  number of points kept
+ */
+static uint16_t ncr_prep_simplify(uint16_t num, int32_t eps)
+{
+    int64_t far, v, l2;
+    int32_t dx, dy;
+    uint16_t i, j, m, idx = 0;
+    uint16_t kept = 0;
+    uint16_t start;
+    uint8_t s, more;
+
+    for (i = 0; i < num; i++)
+    {
+        g_ncr_keep[i] = 0;
+    }
+
+    for (s = 0; s < g_ncr_prep.stroke; s++)
+    {
+        start = s ? g_ncr_wend[s - 1] : 0;
+        g_ncr_keep[start] = 1;
+        g_ncr_keep[g_ncr_wend[s] - 1] = 1;
+    }
+
+    /* Every pass splits each segment between two kept points at its farthest point, until all
+     * the points are within eps of their segment. No recursion, the stack stays small */
+    do
+    {
+        more = 0;
+        i = 0;
+
+        while (i < num - 1)
+        {
+            for (j = i + 1; g_ncr_keep[j] == 0; j++);
+
+            dx = g_ncr_wx[j] - g_ncr_wx[i];
+            dy = g_ncr_wy[j] - g_ncr_wy[i];
+            l2 = (int64_t)dx * dx + (int64_t)dy * dy;
+
+            for (m = 0, far = 0; i + 1 + m < j; m++)                    /* Distance to the line, squared and multiplied by l2 */
+            {
+                if (l2)
+                {
+                    v = (int64_t)dx * (g_ncr_wy[i + 1 + m] - g_ncr_wy[i]) - (int64_t)dy * (g_ncr_wx[i + 1 + m] - g_ncr_wx[i]);
+                    v = v * v;
+                }
+                else
+                {
+                    v = (int64_t)(g_ncr_wx[i + 1 + m] - g_ncr_wx[i]) * (g_ncr_wx[i + 1 + m] - g_ncr_wx[i]) +
+                        (int64_t)(g_ncr_wy[i + 1 + m] - g_ncr_wy[i]) * (g_ncr_wy[i + 1 + m] - g_ncr_wy[i]);
+                }
+
+                if (v > far)
+                {
+                    far = v;
+                    idx = i + 1 + m;
+                }
+            }
+
+            if (far > (int64_t)eps * eps * (l2 ? l2 : 1))
+            {
+                g_ncr_keep[idx] = 1;
+                more = 1;
+            }
+
+            i = j;
+        }
+    } while (more);
+
+    for (i = 0; i < num; i++)
+    {
+        kept += g_ncr_keep[i];
+    }
+
+    return kept;
+}
+
+/**
+ * @brief   Builds the input of alientek_ncr from the recorded character
+ * @note    The current stroke is finished. The recorded points are not changed, the function can be
+ *          called again with another max
+ * @param   out: points for alientek_ncr
+ * @param   max: size of out, at least 2 * NCR_PREP_STROKE_MAX
+ * @retval  number of points in out, 0: nothing was written
+ */
+uint16_t ncr_prep_run(atk_ncr_point *out, uint16_t max)
+{
+    int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = 0, maxy = 0;
+    int32_t w, h, k, ox, oy, eps;
+    uint16_t i, n, num;
+
+    ncr_prep_end();
+
+    if (g_ncr_prep.stroke == 0)return 0;
+
+    for (i = 0; i < g_ncr_prep.end[g_ncr_prep.stroke - 1]; i++)
+    {
+        if (g_ncr_prep.pt[i].x < minx)minx = g_ncr_prep.pt[i].x;
+        if (g_ncr_prep.pt[i].x > maxx)maxx = g_ncr_prep.pt[i].x;
+        if (g_ncr_prep.pt[i].y < miny)miny = g_ncr_prep.pt[i].y;
+        if (g_ncr_prep.pt[i].y > maxy)maxy = g_ncr_prep.pt[i].y;
+    }
+
+    /* Scale the longer side to the box, the shorter one is centered */
+    w = maxx - minx;
+    h = maxy - miny;
+    k = ((int32_t)(NCR_PREP_BOX - 1) << 16) / ((w > h ? w : h) + 1);
+
+    if (k > (NCR_PREP_ZOOM_MAX << 16))k = NCR_PREP_ZOOM_MAX << 16;
+
+    ox = (((NCR_PREP_BOX - 1) << 4) - ((w * k) >> 12)) / 2;
+    oy = (((NCR_PREP_BOX - 1) << 4) - ((h * k) >> 12)) / 2;
+
+    num = ncr_prep_resample(k, ox, oy, minx, miny);
+
+    eps = NCR_PREP_EPS << 4;
+
+    while (ncr_prep_simplify(num, eps) > max && eps < (NCR_PREP_BOX << 4))
+    {
+        eps <<= 1;
+    }
+
+    for (i = 0, n = 0; i < num && n < max; i++)
+    {
+        if (g_ncr_keep[i] == 0)continue;
+
+        out[n].x = (g_ncr_wx[i] + 8) >> 4;
+        out[n].y = (g_ncr_wy[i] + 8) >> 4;
+        n++;
+    }
+
+    return n;
+}
@@ -0,0 +1,55 @@
+/**
+ ****************************************************************************************************
+ * @file        ncr_prep.h
+ * @author      ALIENTEK
+ * @brief       Stroke preprocessing for ATKNCR
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     more strokes than NCR_PREP_STROKE_MAX: all the points are joined to the last one
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __NCR_PREP_H
+#define __NCR_PREP_H
+
+#include "main.h"
+#include "atk_ncr.h"
+
+
+#define NCR_PREP_RAW_MAX        400     /* Points recorded for one character */
+#define NCR_PREP_STROKE_MAX     16      /* Strokes of one character, more strokes are joined to the last one */
+#define NCR_PREP_DIST           2       /* Minimum distance in pixels between two recorded points, doubled each time the buffer is full */
+
+#define NCR_PREP_BOX            200     /* The character is scaled to fit 0 ~ NCR_PREP_BOX - 1 */
+#define NCR_PREP_ZOOM_MAX       4       /* Largest magnification of a small character */
+#define NCR_PREP_STEP           4       /* Resampling distance in box units */
+#define NCR_PREP_EPS            1       /* Douglas-Peucker tolerance in box units, doubled until the points fit */
+
+/* Points of the character being written, in screen coordinates */
+typedef struct
+{
+    atk_ncr_point pt[NCR_PREP_RAW_MAX];
+    uint16_t end[NCR_PREP_STROKE_MAX];  /* Index after the last point of each finished stroke */
+    uint16_t num;                       /* Recorded points */
+    uint8_t stroke;                     /* Finished strokes */
+    uint8_t dist;                       /* Current minimum distance between two points */
+} ncr_prep_t;
+
+extern ncr_prep_t g_ncr_prep;
+
+void ncr_prep_reset(void);                                  /* Starts a new character */
+void ncr_prep_add(uint16_t x, uint16_t y);                  /* Records a point of the current stroke */
+void ncr_prep_end(void);                                    /* The pen left the screen, finishes the current stroke */
+uint16_t ncr_prep_run(atk_ncr_point *out, uint16_t max);    /* Builds the input of alientek_ncr, returns the number of points */
+
+#endif
@@ -14,6 +14,7 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     the bus is run by the IIC transaction engine (iic_bus.c)
  *
  ****************************************************************************************************
  */
@@ -22,6 +23,7 @@
 #define __CTIIC_H
 
 #include "main.h"
+#include "iic_bus.h"
 
 #define CT_IIC_SCL_GPIO_PORT            GPIOB
 #define CT_IIC_SCL_GPIO_PIN             GPIO_PIN_1
@@ -32,26 +34,9 @@
 #define CT_IIC_SDA_GPIO_CLK_ENABLE()    do{ __HAL_RCC_GPIOF_CLK_ENABLE(); }while(0)
 
 
-#define CT_IIC_SCL(x)                   do { (x) ?                                                                          \
-                                            HAL_GPIO_WritePin(CT_IIC_SCL_GPIO_PORT, CT_IIC_SCL_GPIO_PIN, GPIO_PIN_SET):     \
-                                            HAL_GPIO_WritePin(CT_IIC_SCL_GPIO_PORT, CT_IIC_SCL_GPIO_PIN, GPIO_PIN_RESET);   \
-                                        } while (0)
-
-#define CT_IIC_SDA(x)                   do { (x) ?                                                                          \
-                                            HAL_GPIO_WritePin(CT_IIC_SDA_GPIO_PORT, CT_IIC_SDA_GPIO_PIN, GPIO_PIN_SET):     \
-                                            HAL_GPIO_WritePin(CT_IIC_SDA_GPIO_PORT, CT_IIC_SDA_GPIO_PIN, GPIO_PIN_RESET);   \
-                                        } while (0)
-
-#define CT_IIC_SDA_READ                 ((HAL_GPIO_ReadPin(CT_IIC_SDA_GPIO_PORT, CT_IIC_SDA_GPIO_PIN) == GPIO_PIN_RESET) ? 0 : 1)
-
+/* The bus of the capacitive touch screen */
+extern iic_bus_t g_ct_iic_bus;
 
 void ct_iic_init(void);
-void ct_iic_start(void);
-void ct_iic_stop(void);
-uint8_t ct_iic_wait_ack(void);
-void ct_iic_ack(void);
-void ct_iic_nack(void);
-void ct_iic_send_byte(uint8_t data);
-uint8_t ct_iic_read_byte(uint8_t ack);
 
 #endif
@@ -14,6 +14,8 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     register access through the IIC transaction engine
+ * V1.2         20261019     ft5206_read_start, non-blocking read of a report for tp_event
  *
  ****************************************************************************************************
  */
@@ -22,6 +24,7 @@
 #include "../../SYSTEM/delay/delay.h"
 #include "ctiic.h"
 #include "touch.h"
+#include "tp_event.h"
 #include "lcd.h"
 
 /**
@@ -33,23 +36,7 @@
  */
 static void ft5206_rd_reg(uint16_t reg, uint8_t *buf, uint8_t len)
 {
-    uint8_t i;
-    
-    ct_iic_start();
-    ct_iic_send_byte(FT5206_CMD_WR);                        /* Send write command */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg & 0xFF);                           /* Send the lower 8 bit address of the register */
-    ct_iic_wait_ack();
-    
-    ct_iic_start();
-    ct_iic_send_byte(FT5206_CMD_RD);                        /* Send read command */
-    ct_iic_wait_ack();
-    for (i = 0; i < len; i++)                               /* Loop out the data */
-    {
-        buf[i] = ct_iic_read_byte(i == (len - 1) ? 0 : 1);
-    }
-    
-    ct_iic_stop();
+    iic_bus_read(&g_ct_iic_bus, FT5206_CMD_WR, reg, 1, buf, len);   /* Register address, repeated START, then the data */
 }
 
 /**
@@ -63,26 +50,7 @@ static void ft5206_rd_reg(uint16_t reg, uint8_t *buf, uint8_t len)
  */
 static uint8_t ft5206_wr_reg(uint16_t reg, uint8_t *buf, uint8_t len)
 {
-    uint8_t i;
-    uint8_t ret = 0;
-    
-    ct_iic_start();
-    ct_iic_send_byte(FT5206_CMD_WR);    /* Send write command */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg & 0xFF);       /* Send the lower 8 bit address of the register */
-    ct_iic_wait_ack();
-    for (i = 0; i < len; i++)           /* Cyclic writing of data */
-    {
-        ct_iic_send_byte(buf[i]);
-        ret = ct_iic_wait_ack();
-        if (ret)
-        {
-            break;
-        }
-    }
-    ct_iic_stop();
-    
-    return ret;
+    return iic_bus_write(&g_ct_iic_bus, FT5206_CMD_WR, reg, 1, buf, len);
 }
 
 /**
@@ -152,6 +120,27 @@ static const uint16_t FT5206_TPX_TBL[5] = {
     FT5206_TP5_REG,
 };
 
+/**
+ * @brief  converts the coordinates of a point to the screen coordinates
+ * @param  buf: XH, XL, YH, YL as read from the point registers
+ * @param  x  : X
+ * @param  y  : Y
+ * @retval None
+ */
+static void ft5206_xy(const uint8_t *buf, uint16_t *x, uint16_t *y)
+{
+    if (tp_dev.touchtype & 0x01)                                    /* landscape */
+    {
+        *y = ((uint16_t)(buf[0] & 0x0F) << 8) + buf[1];
+        *x = ((uint16_t)(buf[2] & 0x0F) << 8) + buf[3];
+    }
+    else                                                            /* portrait screen */
+    {
+        *x = lcddev.width - (((uint16_t)(buf[0] & 0x0F) << 8) + buf[1]);
+        *y = ((uint16_t)(buf[2] & 0x0F) << 8) + buf[3];
+    }
+}
+
 /**
  * @brief  scan FT5206 read touch screen
  * @param  mode: Capacitor screen is not used, compatible with resistive screen
@@ -183,16 +172,7 @@ uint8_t ft5206_scan(uint8_t mode)
                 {
                     ft5206_rd_reg(FT5206_TPX_TBL[i], buf, 4);                                       /* Read the XY coordinates */
                     
-                    if (tp_dev.touchtype & 0x01)                                                    /* landscape */
-                    {
-                        tp_dev.y[i] = ((uint16_t)(buf[0] & 0x0F) << 8) + buf[1];
-                        tp_dev.x[i] = ((uint16_t)(buf[2] & 0x0F) << 8) + buf[3];
-                    }
-                    else                                                                            /* portrait screen */
-                    {
-                        tp_dev.x[i] = lcddev.width - (((uint16_t)(buf[0] & 0x0F) << 8) + buf[1]);
-                        tp_dev.y[i] = ((uint16_t)(buf[2] & 0x0F) << 8) + buf[3];
-                    }
+                    ft5206_xy(buf, &tp_dev.x[i], &tp_dev.y[i]);
                     
                     if ((buf[0] & 0xF0) != 0x80)
                     {
@@ -232,3 +212,79 @@ uint8_t ft5206_scan(uint8_t mode)
     
     return res;
 }
+
+/**
+ * @brief  switches INT to trigger mode: one pulse for each report, also while a point does not move
+ * @param  None
+ * @retval None
+ */
+void ft5206_int_mode(void)
+{
+    uint8_t temp = 1;
+
+    ft5206_wr_reg(FT5206_ID_G_MODE, &temp, 1);
+}
+
+/* Non-blocking read of a report: status, then the points */
+static iic_xfer_t g_ft_xfer;
+static uint8_t g_ft_buf[1 + 6 * 5];                                                                 /* Status, then 6 bytes for each point */
+
+/**
+ * @brief  completion of a transfer of ft5206_read_start (IIC interrupt)
+ * @param  xfer: transfer
+ * @retval None
+ */
+static void ft5206_read_cb(iic_xfer_t *xfer)
+{
+    tp_point_t pt[5];
+    uint8_t num = g_ft_buf[0] & 0x0F;
+    uint8_t n = 0;
+    uint8_t *p;
+    uint8_t i;
+
+    if (xfer->sta != IIC_XFER_OK || num > 5)
+    {
+        tp_event_done();
+        return;
+    }
+
+    if (xfer->buf == g_ft_buf && num)                                                               /* Status read, then the points */
+    {
+        xfer->reg = FT5206_TP1_REG;
+        xfer->buf = &g_ft_buf[1];
+        xfer->len = 6 * num;
+        iic_bus_submit(&g_ct_iic_bus, xfer);
+        return;
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        p = &g_ft_buf[1 + 6 * i];
+
+        if ((p[0] >> 6) == 1 || (p[0] >> 6) == 3)continue;                                          /* Event flag: lift up or no event */
+
+        pt[n].id = p[2] >> 4;
+        ft5206_xy(p, &pt[n].x, &pt[n].y);
+        n++;
+    }
+
+    tp_event_report(pt, n);
+    tp_event_done();
+}
+
+/**
+ * @brief  starts reading a report without waiting, the points are passed to tp_event_report
+ * @param  None
+ * @retval 0, started; 1, failed
+ */
+uint8_t ft5206_read_start(void)
+{
+    g_ft_xfer.addr = FT5206_CMD_WR;
+    g_ft_xfer.dir = IIC_XFER_RD;
+    g_ft_xfer.reg = FT5206_REG_NUM_FINGER;
+    g_ft_xfer.reg_len = 1;
+    g_ft_xfer.buf = g_ft_buf;
+    g_ft_xfer.len = 1;
+    g_ft_xfer.cb = ft5206_read_cb;
+    return iic_bus_submit(&g_ct_iic_bus, &g_ft_xfer);
+}
@@ -14,6 +14,7 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     add ft5206_int_mode, ft5206_read_start
  *
  ****************************************************************************************************
  */
@@ -58,5 +59,7 @@
 
 uint8_t ft5206_init(void);
 uint8_t ft5206_scan(uint8_t mode);
+void ft5206_int_mode(void);
+uint8_t ft5206_read_start(void);
 
 #endif
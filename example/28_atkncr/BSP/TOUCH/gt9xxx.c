@@ -14,6 +14,9 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     register access through the IIC transaction engine
+ * V1.2         20261019     gt9xxx_read_start, non-blocking read of a report for tp_event
+ * V1.3         20261019     gt9xxx_int_falling, INT polarity from the config
  *
  ****************************************************************************************************
  */
@@ -22,6 +25,7 @@
 #include "../../SYSTEM/delay/delay.h"
 #include "ctiic.h"
 #include "touch.h"
+#include "tp_event.h"
 #include "lcd.h"
 #include <string.h>
 
@@ -39,25 +43,7 @@ static uint8_t g_gt_tnum = 5;
  */
 static void gt9xxx_rd_reg(uint16_t reg, uint8_t *buf, uint8_t len)
 {
-    uint8_t i;
-    
-    ct_iic_start();
-    ct_iic_send_byte(GT9XXX_CMD_WR);                        /* Send write command */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg >> 8);                             /* Send the high 8-bit address of the register */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg & 0xFF);                           /* Send the lower 8 bit address of the register */
-    ct_iic_wait_ack();
-    
-    ct_iic_start();
-    ct_iic_send_byte(GT9XXX_CMD_RD);                        /* Send read command */
-    ct_iic_wait_ack();
-    for (i = 0; i < len; i++)                               /* Loop out the data */
-    {
-        buf[i] = ct_iic_read_byte(i == (len - 1) ? 0 : 1);
-    }
-    
-    ct_iic_stop();
+    iic_bus_read(&g_ct_iic_bus, GT9XXX_CMD_WR, reg, 2, buf, len);   /* Register address, repeated START, then the data */
 }
 
 /**
@@ -71,28 +57,7 @@ static void gt9xxx_rd_reg(uint16_t reg, uint8_t *buf, uint8_t len)
  */
 static uint8_t gt9xxx_wr_reg(uint16_t reg, uint8_t *buf, uint8_t len)
 {
-    uint8_t i;
-    uint8_t ret = 0;
-    
-    ct_iic_start();
-    ct_iic_send_byte(GT9XXX_CMD_WR);    /* Send write command */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg >> 8);         /* Send the high 8-bit address of the register */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg & 0xFF);       /* Send the lower 8 bit address of the register */
-    ct_iic_wait_ack();
-    for (i = 0; i < len; i++)           /* Cyclic writing of data */
-    {
-        ct_iic_send_byte(buf[i]);
-        ret = ct_iic_wait_ack();
-        if (ret)
-        {
-            break;
-        }
-    }
-    ct_iic_stop();
-    
-    return ret;
+    return iic_bus_write(&g_ct_iic_bus, GT9XXX_CMD_WR, reg, 2, buf, len);
 }
 
 /**
@@ -178,6 +143,45 @@ static const uint16_t GT9XXX_TPX_TBL[10] = {
     GT9XXX_TP10_REG,
 };
 
+/**
+ * @brief  converts the coordinates of a point to the screen coordinates
+ * @param  buf: X low, X high, Y low, Y high as read from the point registers
+ * @param  x  : X
+ * @param  y  : Y
+ * @retval None
+ */
+static void gt9xxx_xy(const uint8_t *buf, uint16_t *x, uint16_t *y)
+{
+    if ((lcddev.id == 0x5510) ||                                    /* 4.3 inch 800*480 MCU screen */
+        (lcddev.id == 0x9806) ||
+        (lcddev.id == 0x7796))
+    {
+        if (tp_dev.touchtype & 0x01)                                /* landscape */
+        {
+            *x = lcddev.width - (((uint16_t)buf[3] << 8) + buf[2]);
+            *y = ((uint16_t)buf[1] << 8) + buf[0];
+        }
+        else                                                        /* portrait screen */
+        {
+            *x = ((uint16_t)buf[1] << 8) + buf[0];
+            *y = ((uint16_t)buf[3] << 8) + buf[2];
+        }
+    }
+    else                                                            /* Other models */
+    {
+        if (tp_dev.touchtype & 0x01)                                /* landscape */
+        {
+            *x = ((uint16_t)buf[1] << 8) + buf[0];
+            *y = ((uint16_t)buf[3] << 8) + buf[2];
+        }
+        else                                                        /* portrait screen */
+        {
+            *x = lcddev.width - (((uint16_t)buf[3] << 8) + buf[2]);
+            *y = ((uint16_t)buf[1] << 8) + buf[0];
+        }
+    }
+}
+
 /**
  * @brief  scan GT9XXX touch screen
  * @param  mode: Capacitor screen is not used, compatible with resistive screen
@@ -218,34 +222,7 @@ uint8_t gt9xxx_scan(uint8_t mode)
                 {
                     gt9xxx_rd_reg(GT9XXX_TPX_TBL[i], buf, 4);                       /* Read the XY coordinates */
                     
-                    if ((lcddev.id == 0x5510) ||                                    /* 4.3 inch 800*480 MCU screen */
-                        (lcddev.id == 0x9806) ||
-                        (lcddev.id == 0x7796))
-                    {
-                        if (tp_dev.touchtype & 0x01)                                /* landscape */
-                        {
-                            tp_dev.x[i] = lcddev.width - (((uint16_t)buf[3] << 8) + buf[2]);
-                            tp_dev.y[i] = ((uint16_t)buf[1] << 8) + buf[0];
-                        }
-                        else                                                        /* portrait screen */
-                        {
-                            tp_dev.x[i] = ((uint16_t)buf[1] << 8) + buf[0];
-                            tp_dev.y[i] = ((uint16_t)buf[3] << 8) + buf[2];
-                        }
-                    }
-                    else                                                            /* Other models */
-                    {
-                        if (tp_dev.touchtype & 0x01)                                /* landscape */
-                        {
-                            tp_dev.x[i] = ((uint16_t)buf[1] << 8) + buf[0];
-                            tp_dev.y[i] = ((uint16_t)buf[3] << 8) + buf[2];
-                        }
-                        else                                                        /* portrait screen */
-                        {
-                            tp_dev.x[i] = lcddev.width - (((uint16_t)buf[3] << 8) + buf[2]);
-                            tp_dev.y[i] = ((uint16_t)buf[1] << 8) + buf[0];
-                        }
-                    }
+                    gt9xxx_xy(buf, &tp_dev.x[i], &tp_dev.y[i]);
                 }
             }
             res = 1;
@@ -294,3 +271,103 @@ uint8_t gt9xxx_scan(uint8_t mode)
     
     return res;
 }
+
+/* Non-blocking read of a report: status, then the points, then the status is cleared */
+static iic_xfer_t g_gt_xfer;
+static uint8_t g_gt_buf[1 + 8 * 10];                                                /* Status, then 8 bytes for each point */
+static uint8_t g_gt_step;
+
+/**
+ * @brief  completion of a transfer of gt9xxx_read_start (IIC interrupt)
+ * @param  xfer: transfer
+ * @retval None
+ */
+static void gt9xxx_read_cb(iic_xfer_t *xfer)
+{
+    tp_point_t pt[10];
+    uint8_t num = g_gt_buf[0] & 0x0F;
+    uint8_t i;
+
+    if (xfer->sta != IIC_XFER_OK)
+    {
+        tp_event_done();
+        return;
+    }
+
+    switch (g_gt_step++)
+    {
+        case 0:                                                                     /* Status read */
+            if ((g_gt_buf[0] & 0x80) == 0 || num > g_gt_tnum)                       /* No new report */
+            {
+                tp_event_done();
+                return;
+            }
+
+            if (num)
+            {
+                xfer->dir = IIC_XFER_RD;
+                xfer->reg = GT9XXX_TPID_REG;
+                xfer->buf = &g_gt_buf[1];
+                xfer->len = 8 * num;
+                break;
+            }
+
+            g_gt_step++;                                                            /* No point: released */
+            /* fall through */
+
+        case 1:                                                                     /* Points read */
+            for (i = 0; i < num; i++)
+            {
+                pt[i].id = g_gt_buf[1 + 8 * i];
+                gt9xxx_xy(&g_gt_buf[2 + 8 * i], &pt[i].x, &pt[i].y);
+            }
+
+            tp_event_report(pt, num);
+
+            g_gt_buf[0] = 0;
+            xfer->dir = IIC_XFER_WR;                                                /* Clear the status */
+            xfer->reg = GT9XXX_GSTID_REG;
+            xfer->buf = g_gt_buf;
+            xfer->len = 1;
+            break;
+
+        default:                                                                    /* Status cleared */
+            tp_event_done();
+            return;
+    }
+
+    iic_bus_submit(&g_ct_iic_bus, xfer);
+}
+
+/**
+ * @brief  starts reading a report without waiting, the points are passed to tp_event_report
+ * @param  None
+ * @retval 0, started; 1, failed
+ */
+uint8_t gt9xxx_read_start(void)
+{
+    g_gt_step = 0;
+    g_gt_xfer.addr = GT9XXX_CMD_WR;
+    g_gt_xfer.dir = IIC_XFER_RD;
+    g_gt_xfer.reg = GT9XXX_GSTID_REG;
+    g_gt_xfer.reg_len = 2;
+    g_gt_xfer.buf = g_gt_buf;
+    g_gt_xfer.len = 1;
+    g_gt_xfer.cb = gt9xxx_read_cb;
+    return iic_bus_submit(&g_ct_iic_bus, &g_gt_xfer);
+}
+
+/**
+ * @brief  reads the INT polarity from the config (Module_Switch1)
+ * @param  None
+ * @retval 1, INT is active low (falling edge or low level); 0, active high
+ */
+uint8_t gt9xxx_int_falling(void)
+{
+    uint8_t msw1 = 0;
+
+    gt9xxx_rd_reg(GT9XXX_MSW1_REG, &msw1, 1);
+    msw1 &= 0x03;
+
+    return msw1 == 0x01 || msw1 == 0x02;
+}
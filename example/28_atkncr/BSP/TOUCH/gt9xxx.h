@@ -14,6 +14,8 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     add gt9xxx_read_start
+ * V1.2         20261019     add gt9xxx_int_falling
  *
  ****************************************************************************************************
  */
@@ -44,9 +46,11 @@
 /* GT9XXX partial register address definition */
 #define GT9XXX_CTRL_REG                 0x8040  /* GT9XXX control register */
 #define GT9XXX_CFGS_REG                 0x8047  /* GT9XXX config the start address register */
+#define GT9XXX_MSW1_REG                 0x804D  /* Module_Switch1 of the config, bits 1:0 INT: 0 rising, 1 falling, 2 low level, 3 high level */
 #define GT9XXX_CHECK_REG                0x80FF  /* GT9XXX checksum register */
 #define GT9XXX_PID_REG                  0x8140  /* GT9XXX product ID register */
 #define GT9XXX_GSTID_REG                0x814E  /* GT9XXX The currently detected touch */
+#define GT9XXX_TPID_REG                 0x814F  /* Track ID of the first point, each point has 8 bytes: ID, X, Y, size, reserved */
 #define GT9XXX_TP1_REG                  0x8150  /* The first touch point data address */
 #define GT9XXX_TP2_REG                  0x8158  /* The second touch point data address */
 #define GT9XXX_TP3_REG                  0x8160  /* The third touch point data address */
@@ -60,5 +64,7 @@
 
 uint8_t gt9xxx_init(void);
 uint8_t gt9xxx_scan(uint8_t mode);
+uint8_t gt9xxx_read_start(void);
+uint8_t gt9xxx_int_falling(void);
 
 #endif
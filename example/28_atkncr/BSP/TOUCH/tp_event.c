@@ -0,0 +1,247 @@
+/**
+ ****************************************************************************************************
+ * @file        tp_event.c
+ * @author      ALIENTEK
+ * @brief       Interrupt driven capacitive touch events
+ *
+ *              The touch controller pulls its INT pin when it has a new report. The EXTI interrupt
+ *              starts the read of the report on the IIC transaction engine and returns, the driver
+ *              chains the register reads in the completion callbacks (TIM7 interrupt) and passes the
+ *              points to tp_event_report. The points are compared with the previous report and
+ *              DOWN/MOVE/UP events are put in a queue that the main loop empties with tp_event_get.
+ *              Nothing runs while the screen is not touched.
+ *
+ *              The queue has one producer (the IIC interrupt) and one consumer (the main loop), each
+ *              side only writes its own index, so no interrupt has to be disabled.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     INT interrupt on the active edge of the controller only
+ *
+ ****************************************************************************************************
+ */
+
+#include "tp_event.h"
+#include "gt9xxx.h"
+#include "ft5206.h"
+#include "iic_bus.h"
+
+static tp_event_t g_tp_evt_queue[TP_EVT_QUEUE_SIZE];
+static volatile uint16_t g_tp_evt_head = 0;     /* Written by the producer only */
+static volatile uint16_t g_tp_evt_tail = 0;     /* Written by the consumer only */
+volatile uint32_t g_tp_evt_lost = 0;
+
+static uint8_t (*g_tp_read)(void) = NULL;       /* Starts the read of a report, 0: started */
+static volatile uint8_t g_tp_busy = 0;          /* A read is in progress */
+static volatile uint8_t g_tp_again = 0;         /* INT came during the read, read again */
+static uint32_t g_tp_time;                      /* Time of the INT of the read in progress */
+static volatile uint32_t g_tp_last;             /* Time of the last read */
+
+static tp_point_t g_tp_down[CT_MAX_TOUCH];      /* Points of the last report */
+static volatile uint8_t g_tp_down_num = 0;
+
+/**
+ * @brief   Puts an event in the queue
+ * @param   pt  : point
+ * @param   type: event type
+ * @retval  None
+ */
+static void tp_event_push(const tp_point_t *pt, uint8_t type)
+{
+    uint16_t head = g_tp_evt_head;
+    tp_event_t *evt;
+
+    if ((uint16_t)(head - g_tp_evt_tail) >= TP_EVT_QUEUE_SIZE)
+    {
+        g_tp_evt_lost++;
+        return;
+    }
+
+    evt = &g_tp_evt_queue[head & (TP_EVT_QUEUE_SIZE - 1)];
+    evt->time = g_tp_time;
+    evt->x = pt->x;
+    evt->y = pt->y;
+    evt->id = pt->id;
+    evt->type = type;
+
+    __DMB();                        /* The event is complete before the consumer can see it */
+    g_tp_evt_head = head + 1;
+}
+
+/**
+ * @brief   Starts the read of a report
+ * @param   None
+ * @retval  None
+ */
+static void tp_event_start(void)
+{
+    g_tp_busy = 1;
+    g_tp_again = 0;
+    g_tp_time = HAL_GetTick();
+
+    if (g_tp_read())
+    {
+        g_tp_busy = 0;              /* The transfer could not be queued */
+    }
+}
+
+/**
+ * @brief   INT interrupt
+ * @note    Same priority as the IIC interrupt, so it never interrupts a driver callback
+ * @param   None
+ * @retval  None
+ */
+void TP_INT_IRQHandler(void)
+{
+    __HAL_GPIO_EXTI_CLEAR_IT(TP_INT_GPIO_PIN);
+
+    if (g_tp_read == NULL)return;
+
+    if (g_tp_busy)
+    {
+        g_tp_again = 1;             /* Read again when the current read is done */
+        return;
+    }
+
+    tp_event_start();
+}
+
+/**
+ * @brief   Called by the driver when the read started by g_tp_read is finished (successful or not)
+ * @param   None
+ * @retval  None
+ */
+void tp_event_done(void)
+{
+    g_tp_busy = 0;
+    g_tp_last = HAL_GetTick();
+
+    if (g_tp_again)
+    {
+        tp_event_start();
+    }
+}
+
+/**
+ * @brief   Turns a report into events
+ * @param   pt : points of the report
+ * @param   num: number of points, 0 when nothing touches the screen
+ * @retval  None
+ */
+void tp_event_report(const tp_point_t *pt, uint8_t num)
+{
+    uint8_t i, j;
+
+    if (num > CT_MAX_TOUCH)num = CT_MAX_TOUCH;
+
+    for (i = 0; i < g_tp_down_num; i++)         /* The points that are gone */
+    {
+        for (j = 0; j < num; j++)
+        {
+            if (pt[j].id == g_tp_down[i].id)break;
+        }
+
+        if (j == num)tp_event_push(&g_tp_down[i], TP_EVT_UP);
+    }
+
+    for (j = 0; j < num; j++)                   /* New and moved points */
+    {
+        for (i = 0; i < g_tp_down_num; i++)
+        {
+            if (pt[j].id == g_tp_down[i].id)break;
+        }
+
+        if (i == g_tp_down_num)
+        {
+            tp_event_push(&pt[j], TP_EVT_DOWN);
+        }
+        else if (pt[j].x != g_tp_down[i].x || pt[j].y != g_tp_down[i].y)
+        {
+            tp_event_push(&pt[j], TP_EVT_MOVE);
+        }
+    }
+
+    for (j = 0; j < num; j++)
+    {
+        g_tp_down[j] = pt[j];
+    }
+
+    g_tp_down_num = num;
+}
+
+/**
+ * @brief   Switches the capacitive touch screen to interrupts
+ * @note    Call it after tp_dev.init(). tp_dev.scan must not be called afterwards, the events
+ *          are taken with tp_event_get
+ * @param   None
+ * @retval  0, successful; 1, resistive touch screen (use tp_dev.scan)
+ */
+uint8_t tp_event_init(void)
+{
+    GPIO_InitTypeDef gpio_init_struct = {0};
+    uint8_t falling;
+
+    if ((tp_dev.touchtype & 0x80) == 0)return 1;
+
+    if (tp_dev.scan == gt9xxx_scan)
+    {
+        g_tp_read = gt9xxx_read_start;
+        falling = gt9xxx_int_falling();                     /* The polarity is in the config of the GT9XXX */
+    }
+    else if (tp_dev.scan == ft5206_scan)
+    {
+        ft5206_int_mode();
+        g_tp_read = ft5206_read_start;
+        falling = 1;                                        /* Trigger mode: a low pulse for each report */
+    }
+    else
+    {
+        return 1;
+    }
+
+    gpio_init_struct.Pin = TP_INT_GPIO_PIN;
+    gpio_init_struct.Mode = falling ? GPIO_MODE_IT_FALLING : GPIO_MODE_IT_RISING;  /* One interrupt per report: the active edge only */
+    gpio_init_struct.Pull = falling ? GPIO_PULLUP : GPIO_PULLDOWN;
+    HAL_GPIO_Init(TP_INT_GPIO_PORT, &gpio_init_struct);
+
+    HAL_NVIC_SetPriority(TP_INT_IRQn, IIC_BUS_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(TP_INT_IRQn);
+
+    EXTI->SWIER = TP_INT_GPIO_PIN;                          /* Read the first report now */
+    return 0;
+}
+
+/**
+ * @brief   Takes the oldest event
+ * @note    While a point is down and no report came for TP_EVT_TIMEOUT ms, the controller is read
+ *          again, so that a lost release still gives an UP event
+ * @param   evt: event
+ * @retval  0, an event was taken; 1, the queue is empty
+ */
+uint8_t tp_event_get(tp_event_t *evt)
+{
+    uint16_t tail = g_tp_evt_tail;
+
+    if (g_tp_down_num && g_tp_busy == 0 && HAL_GetTick() - g_tp_last > TP_EVT_TIMEOUT)
+    {
+        g_tp_last = HAL_GetTick();
+        EXTI->SWIER = TP_INT_GPIO_PIN;                      /* The read is started by the INT interrupt */
+    }
+
+    if (tail == g_tp_evt_head)return 1;
+
+    __DMB();
+    *evt = g_tp_evt_queue[tail & (TP_EVT_QUEUE_SIZE - 1)];
+    __DMB();                        /* The event is copied before its slot is given back */
+    g_tp_evt_tail = tail + 1;
+    return 0;
+}
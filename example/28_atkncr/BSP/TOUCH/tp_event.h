@@ -0,0 +1,68 @@
+/**
+ ****************************************************************************************************
+ * @file        tp_event.h
+ * @author      ALIENTEK
+ * @brief       Interrupt driven capacitive touch events
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __TP_EVENT_H
+#define __TP_EVENT_H
+
+#include "main.h"
+#include "touch.h"
+
+
+/* INT pin of the touch controller (GT9XXX_INT / FT5206_INT), EXTI line 10 */
+#define TP_INT_GPIO_PORT                GPIOF
+#define TP_INT_GPIO_PIN                 GPIO_PIN_10
+#define TP_INT_IRQn                     EXTI15_10_IRQn
+#define TP_INT_IRQHandler               EXTI15_10_IRQHandler
+
+#define TP_EVT_QUEUE_SIZE               32      /* Events, must be a power of 2 */
+#define TP_EVT_TIMEOUT                  100     /* ms without a report while a point is down before the controller is read again */
+
+/* Event types */
+#define TP_EVT_DOWN                     0       /* A point touches the screen */
+#define TP_EVT_MOVE                     1       /* A point moved */
+#define TP_EVT_UP                       2       /* A point left the screen, x/y are its last position */
+
+typedef struct
+{
+    uint32_t time;                      /* HAL_GetTick() when the controller signalled the report */
+    uint16_t x;
+    uint16_t y;
+    uint8_t id;                         /* Point ID given by the controller, the same from DOWN to UP */
+    uint8_t type;                       /* TP_EVT_DOWN, TP_EVT_MOVE or TP_EVT_UP */
+} tp_event_t;
+
+/* A point of a report */
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint8_t id;
+} tp_point_t;
+
+extern volatile uint32_t g_tp_evt_lost;                 /* Events dropped because the queue was full */
+
+uint8_t tp_event_init(void);                            /* Switches the capacitive touch screen to interrupts */
+uint8_t tp_event_get(tp_event_t *evt);                  /* Takes the oldest event */
+
+/* Used by the controller drivers */
+void tp_event_report(const tp_point_t *pt, uint8_t num);    /* All the points of a report, num can be 0 */
+void tp_event_done(void);                                   /* The read started by the read function is finished */
+
+#endif
@@ -15,6 +15,9 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     capacitive screens: strokes from the touch event queue (tp_event)
+ * V1.2         20261019     strokes are preprocessed (ncr_prep) before the recognition
+ * V1.3         20261019     NCR_RECORD prints the strokes for tools/ncr_replay.c
  *
  ****************************************************************************************************
  */
@@ -36,8 +39,10 @@
 #include "../../SYSTEM/delay/delay.h"
 #include "../../BSP/NORFLASH/norflash.h"
 #include "../../BSP/TOUCH/touch.h"
+#include "../../BSP/TOUCH/tp_event.h"
 #include "../../ATK_Middlewares/MALLOC/malloc.h"
 #include "../../ATK_Middlewares/ATKNCR/atk_ncr.h"
+#include "../../ATK_Middlewares/ATKNCR/ncr_prep.h"
 #include "../../FatFs/exfuns/exfuns.h"
 #include "ff.h"
 /* USER CODE END Includes */
@@ -50,7 +55,7 @@ atk_ncr_point ncr_input_buf[200];
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-
+#define NCR_RECORD      0       /* 1: the serial port prints the strokes ("x y" points, "-" pen up, "= result"), see tools/ncr_record.py */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -169,6 +174,47 @@ static void lcd_draw_bline(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, u
     }
 }
 
+/**
+ * @brief   Draws and records a point of the stroke
+ * @param   x      : X
+ * @param   y      : Y
+ * @param   lastpos: last drawn point, 0xFFFF when the stroke starts
+ * @retval  None
+ */
+static void ncr_stroke_point(uint16_t x, uint16_t y, uint16_t *lastpos)
+{
+    if (((x < (lcddev.width - 20 - 2)) && (x >= (20 + 2))) &&
+         ((y < (lcddev.height - 5 - 2)) && (y >= (115 + 2))))
+    {
+        if (lastpos[0] == 0xFFFF)
+        {
+            lastpos[0] = x;
+            lastpos[1] = y;
+        }
+
+        lcd_draw_bline(lastpos[0], lastpos[1], x, y, 2, BLUE);
+        lastpos[0] = x;
+        lastpos[1] = y;
+        ncr_prep_add(x, y);
+#if NCR_RECORD
+        printf("%d %d\r\n", x, y);
+#endif
+    }
+}
+
+/**
+ * @brief   The pen left the screen, finishes the stroke
+ * @param   None
+ * @retval  None
+ */
+static void ncr_stroke_end(void)
+{
+    ncr_prep_end();
+#if NCR_RECORD
+    printf("-\r\n");
+#endif
+}
+
 /* USER CODE END 0 */
 
 /**
@@ -183,8 +229,14 @@ int main(void)
 	uint8_t key;
 	uint8_t mode = 4;
 	uint16_t lastpos[2];
-	uint16_t pcnt = 0;
+	uint16_t pcnt;
+	uint32_t t0, t1, t2;
 	char sbuf[10];
+	tp_event_t evt;
+	uint8_t tp_evt;
+	uint8_t stroke_id = 0xFF;
+	uint8_t down;
+	uint8_t lastdown = 0;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -214,6 +266,7 @@ int main(void)
 
   lcd_init();                         /* Initialize LCD */
   tp_dev.init();                      /* Initialize Touch */
+  tp_evt = tp_event_init();           /* Capacitive screen: touch events from the INT interrupt */
   my_mem_init(SRAMIN);                /* Initialize the internal SRAM memory pool */
   exfuns_init();                      /* Request memory for exfuns */
   f_mount(fs[0], "0:", 1);            /* Mount SD card */
@@ -276,44 +329,53 @@ RESTART:
 	      }
 	  }
 
-	  tp_dev.scan(0);
-	  if (tp_dev.sta & TP_PRES_DOWN)
+	  if (tp_evt == 0)
 	  {
-	      /* There are touches, and the touch trace is displayed and recorded */
-	      tcnt = 0;
-
-	      if (((tp_dev.x[0] < (lcddev.width - 20 - 2)) && (tp_dev.x[0] >= (20 + 2))) &&
-	           ((tp_dev.y[0] < (lcddev.height - 5 - 2)) && (tp_dev.y[0] >= (115 + 2))))
+	      /* Capacitive screen: the points of one finger make the stroke, the others are ignored */
+	      while (tp_event_get(&evt) == 0)
 	      {
-	          if (lastpos[0] == 0xFFFF)
+	          if (evt.type == TP_EVT_DOWN && stroke_id == 0xFF)
 	          {
-	              lastpos[0] = tp_dev.x[0];
-	              lastpos[1] = tp_dev.y[0];
+	              stroke_id = evt.id;
+	              lastpos[0] = 0xFFFF;
 	          }
 
-	          lcd_draw_bline(lastpos[0], lastpos[1], tp_dev.x[0], tp_dev.y[0], 2, BLUE);
-	          lastpos[0] = tp_dev.x[0];
-	          lastpos[1] = tp_dev.y[0];
-	          if (pcnt < 200)
+	          if (evt.id != stroke_id)continue;
+
+	          if (evt.type == TP_EVT_UP)
+	          {
+	              stroke_id = 0xFF;
+	              ncr_stroke_end();
+	          }
+	          else
 	          {
-	              if (pcnt != 0)
-	              {
-	                  if ((ncr_input_buf[pcnt - 1].y != tp_dev.y[0]) &&
-	                      (ncr_input_buf[pcnt - 1].x != tp_dev.x[0]))
-	                  {
-	                      ncr_input_buf[pcnt].x = tp_dev.x[0];
-	                      ncr_input_buf[pcnt].y = tp_dev.y[0];
-	                      pcnt++;
-	                  }
-	              }
-	              else
-	              {
-	                  ncr_input_buf[pcnt].x = tp_dev.x[0];
-	                  ncr_input_buf[pcnt].y = tp_dev.y[0];
-	                  pcnt++;
-	              }
+	              ncr_stroke_point(evt.x, evt.y, lastpos);
 	          }
 	      }
+
+	      down = (stroke_id != 0xFF);
+	  }
+	  else
+	  {
+	      tp_dev.scan(0);
+	      down = (tp_dev.sta & TP_PRES_DOWN) ? 1 : 0;
+
+	      if (down)
+	      {
+	          ncr_stroke_point(tp_dev.x[0], tp_dev.y[0], lastpos);
+	      }
+	      else if (lastdown)
+	      {
+	          ncr_stroke_end();                               /* The pen left the screen, next stroke */
+	      }
+
+	      lastdown = down;
+	  }
+
+	  if (down)
+	  {
+	      /* There are touches, and the touch trace is displayed and recorded */
+	      tcnt = 0;
 	   }
 	   else
 	   {
@@ -322,12 +384,20 @@ RESTART:
 	       tcnt++;
 	       if (tcnt == 40)
 	       {
-	          if (pcnt != 0)
+	          if (g_ncr_prep.num != 0)
 	          {
-	              printf("Total points:%d\r\n", pcnt);
+	              t0 = HAL_GetTick();
+	              pcnt = ncr_prep_run(ncr_input_buf, 200);        /* Resample and simplify the strokes */
+	              t1 = HAL_GetTick();
 	              alientek_ncr(ncr_input_buf, pcnt, 6, mode, sbuf);
+	              t2 = HAL_GetTick();
+	              printf("Total points:%d, strokes:%d, recorded:%d\r\n", pcnt, g_ncr_prep.stroke, g_ncr_prep.num);
+	              printf("Preprocessing:%lums, recognition:%lums\r\n", t1 - t0, t2 - t1);
 	              printf("identify the result:%s\r\n", sbuf);
-	              pcnt = 0;
+#if NCR_RECORD
+	              printf("= %s\r\n", sbuf);
+#endif
+	              ncr_prep_reset();
 	               lcd_show_string(60 + 72, 90, 200, 16, 16, sbuf, BLUE);
 	           }
 	           lcd_fill(20, 115, lcddev.width - 20 - 1, lcddev.height - 5 - 1, WHITE);
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+"""
+ncr_record.py - save the strokes written on the 28_atkncr board to a stroke file
+
+Usage: python ncr_record.py COM3 strokes.txt [--baud 115200]
+
+Build the example with NCR_RECORD set to 1 (Core/Src/main.c), then write characters
+on the screen. The board prints every recorded point as "x y", "-" when the pen
+leaves the screen and "= result" after the recognition. The lines are saved as they
+come, with the timing printed by the board, until Ctrl+C. Replay the file with
+tools/ncr_replay.c. Requires pyserial (pip install pyserial).
+"""
+
+import argparse
+
+import serial
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port")
+    ap.add_argument("file")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    chars = 0
+    with serial.Serial(args.port, args.baud, timeout=0.5) as ser, open(args.file, "a") as out:
+        try:
+            while True:
+                line = ser.readline().decode("ascii", "replace").strip()
+                if not line:
+                    continue
+                out.write(line + "\n")
+                if line.startswith("="):
+                    chars += 1
+                    out.flush()
+                    print("%d: %s" % (chars, line[1:].strip()))
+        except KeyboardInterrupt:
+            pass
+    print("%d characters saved to %s" % (chars, args.file))
+
+
+if __name__ == "__main__":
+    main()
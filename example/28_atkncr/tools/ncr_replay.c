@@ -0,0 +1,346 @@
+/**
+ ****************************************************************************************************
+ * @file        ncr_replay.c
+ * @author      ALIENTEK
+ * @brief       Replays stroke files through ncr_prep.c on a Linux host
+ *
+ *              A stroke file holds "x y" screen points, "-" when the pen leaves the screen and
+ *              "= result" at the end of each character, as printed by the board with NCR_RECORD
+ *              (tools/ncr_record.py saves it). The other lines are ignored, except the
+ *              "Preprocessing:..ms, recognition:..ms" timing of the board which is reported with
+ *              the character. The recognizer itself is a Cortex-M3 library and does not run here.
+ *
+ *              Each character goes through ncr_prep_add/ncr_prep_end/ncr_prep_run as in main.c. The
+ *              report gives the strokes, the points from the screen, the points recorded, the points
+ *              passed to the recognizer and the reduction, and the preprocessing time on the host.
+ *              Checks: 1 to 200 points in the 200x200 box, and every recorded point in a stroke, also
+ *              past NCR_PREP_STROKE_MAX strokes.
+ *
+ *              -g writes synthetic characters in the same format: digits written at random sizes and
+ *              pen speeds with jitter, a character of 20 strokes and a scribble longer than
+ *              NCR_PREP_RAW_MAX points.
+ *
+ *              Build, from example/28_atkncr:
+ *              gcc -O2 -Wall -Itools/host tools/ncr_replay.c ATK_Middlewares/ATKNCR/ncr_prep.c -lm -o ncr_replay
+ *              Run:
+ *              ./ncr_replay strokes.txt [-v]           (-v: one line per character)
+ *              ./ncr_replay -g 50 [-s seed] > synth.txt
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../ATK_Middlewares/ATKNCR/ncr_prep.h"
+
+#define REPLAY_OUT_MAX      200         /* ncr_input_buf of main.c */
+#define REPLAY_REPEAT       200         /* ncr_prep_run calls timed for each character */
+
+/* Drawing area of main.c on a 240x320 screen */
+#define AREA_X0             22
+#define AREA_X1             217
+#define AREA_Y0             117
+#define AREA_Y1             312
+
+static atk_ncr_point g_out[REPLAY_OUT_MAX];
+static int g_fails = 0;
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+/******************************************************************************************/
+/* Synthetic characters */
+
+/* Digits in a 0~100 square: x,y points, -1 ends a stroke, -2 the digit */
+static const int8_t g_digit[10][32] = {
+    {50,0, 15,15, 5,50, 15,85, 50,100, 85,85, 95,50, 85,15, 50,0, -1, -2},
+    {30,20, 55,0, 55,100, -1, 30,100, 80,100, -1, -2},
+    {10,20, 35,0, 70,0, 90,20, 85,45, 10,100, 95,100, -1, -2},
+    {10,10, 50,0, 85,15, 80,40, 45,50, 85,60, 90,85, 50,100, 10,90, -1, -2},
+    {70,100, 70,0, 5,70, 95,70, -1, -2},
+    {85,0, 20,0, 15,45, 55,35, 90,55, 85,90, 50,100, 10,90, -1, -2},
+    {80,5, 45,0, 15,30, 10,70, 35,100, 75,95, 90,70, 70,45, 35,45, 12,65, -1, -2},
+    {5,0, 95,0, 40,100, -1, -2},
+    {50,50, 15,30, 25,5, 50,0, 75,5, 85,30, 50,50, 10,70, 20,95, 50,100, 80,95, 90,70, 50,50, -1, -2},
+    {88,35, 65,55, 30,55, 10,30, 30,5, 65,0, 88,35, 85,70, 60,100, 20,95, -1, -2},
+};
+
+/**
+ * @brief   Random number
+ * @param   lo: lowest value
+ * @param   hi: highest value
+ * @retval  lo ~ hi
+ */
+static double synth_rand(double lo, double hi)
+{
+    return lo + (hi - lo) * rand() / (double)RAND_MAX;
+}
+
+/**
+ * @brief   Writes the touch samples of a segment, as the screen would report them
+ * @param   x0, y0: start
+ * @param   x1, y1: end
+ * @param   step  : pen speed, pixels between two samples
+ * @param   first : 1: the start is a sample too
+ * @retval  number of points
+ */
+static int synth_segment(double x0, double y0, double x1, double y1, double step, int first)
+{
+    double len = hypot(x1 - x0, y1 - y0);
+    int n = (int)(len / step) + 1;
+    int i, x, y, cnt = 0;
+
+    for (i = first ? 0 : 1; i <= n; i++)
+    {
+        x = (int)(x0 + (x1 - x0) * i / n + synth_rand(-1, 1) + 0.5);
+        y = (int)(y0 + (y1 - y0) * i / n + synth_rand(-1, 1) + 0.5);
+
+        if (x < AREA_X0 || x > AREA_X1 || y < AREA_Y0 || y > AREA_Y1)continue;     /* Not recorded by main.c */
+
+        printf("%d %d\n", x, y);
+        cnt++;
+    }
+
+    return cnt;
+}
+
+/**
+ * @brief   Writes synthetic characters
+ * @param   num: number of characters
+ * @retval  None
+ */
+static void synth(int num)
+{
+    double size, ox, oy, step, a;
+    int c, i, k, first;
+
+    printf("# synthetic characters, ncr_replay -g %d\n", num);
+
+    for (c = 0; c < num; c++)
+    {
+        size = synth_rand(50, AREA_X1 - AREA_X0 - 10);
+        ox = synth_rand(AREA_X0 + 2, AREA_X1 - size - 2);
+        oy = synth_rand(AREA_Y0 + 2, AREA_Y1 - size - 2);
+        step = synth_rand(1, 8);
+
+        if (c % 12 == 10)                                       /* Hatching: 20 strokes */
+        {
+            for (k = 0; k < 20; k++)
+            {
+                synth_segment(ox, oy + k * size / 20, ox + size, oy + k * size / 20, step, 1);
+                printf("-\n");
+            }
+
+            printf("= hatch\n");
+            continue;
+        }
+
+        if (c % 12 == 11)                                       /* Scribble, slow pen: more than NCR_PREP_RAW_MAX points */
+        {
+            for (k = 0; k < 600; k++)
+            {
+                a = k * 0.15;
+                synth_segment(ox + size / 2 + size / 2 * sin(a) * (k % 100) / 100, oy + size / 2 + size / 2 * cos(a * 1.3),
+                              ox + size / 2 + size / 2 * sin(a + 0.15) * ((k + 1) % 100) / 100, oy + size / 2 + size / 2 * cos((a + 0.15) * 1.3),
+                              1, k == 0);
+            }
+
+            printf("-\n= scribble\n");
+            continue;
+        }
+
+        k = c % 10;
+        first = 1;
+        i = 0;
+
+        while (g_digit[k][i] != -2)
+        {
+            if (g_digit[k][i] == -1)                            /* The pen leaves the screen */
+            {
+                printf("-\n");
+                first = 1;
+                i++;
+            }
+            else if (g_digit[k][i + 2] < 0)                     /* Last point of the stroke */
+            {
+                i += 2;
+            }
+            else
+            {
+                synth_segment(ox + g_digit[k][i] * size / 100, oy + g_digit[k][i + 1] * size / 100,
+                              ox + g_digit[k][i + 2] * size / 100, oy + g_digit[k][i + 3] * size / 100, step, first);
+                first = 0;
+                i += 2;
+            }
+        }
+
+        printf("= %d\n", k);
+    }
+}
+
+/******************************************************************************************/
+/* Replay */
+
+/**
+ * @brief   Time
+ * @param   None
+ * @retval  microseconds
+ */
+static double replay_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    char line[128], label[64];
+    FILE *f;
+    double t, us, us_sum = 0, us_max = 0;
+    long raw = 0, raw_sum = 0, rec_sum = 0, out_sum = 0;
+    int board_pre = -1, board_ncr = -1, board_chars = 0;
+    long board_pre_sum = 0, board_ncr_sum = 0;
+    int x, y, n, i, r, opt, chars = 0, verbose = 0;
+    int recorded, strokes;
+    unsigned int seed = 1;
+    int gen = 0;
+
+    while ((opt = getopt(argc, argv, "g:s:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'g': gen = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, 0, 0); break;
+            case 'v': verbose = 1; break;
+            default:
+                printf("usage: %s strokes.txt [-v] | -g characters [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (gen)
+    {
+        srand(seed);
+        synth(gen);
+        return 0;
+    }
+
+    if (optind >= argc || (f = fopen(argv[optind], "r")) == NULL)
+    {
+        printf("usage: %s strokes.txt [-v] | -g characters [-s seed]\n", argv[0]);
+        return 2;
+    }
+
+    if (verbose)printf("%-10s %7s %6s %8s %6s %9s %9s %9s\n", "char", "strokes", "raw", "recorded", "out", "reduction", "host us", "board ms");
+
+    ncr_prep_reset();
+
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, "%d %d", &x, &y) == 2)
+        {
+            ncr_prep_add(x, y);
+            raw++;
+        }
+        else if (line[0] == '-')
+        {
+            ncr_prep_end();
+        }
+        else if (sscanf(line, "Preprocessing:%dms, recognition:%dms", &board_pre, &board_ncr) == 2)
+        {
+        }
+        else if (line[0] == '=')
+        {
+            if (sscanf(line + 1, " %63s", label) != 1)strcpy(label, "?");
+
+            /* As main.c: the last stroke is finished by ncr_prep_run. The recorded points are not
+             * changed by it, the next calls give the same result */
+            t = replay_us();
+
+            for (r = 0; r < REPLAY_REPEAT; r++)
+            {
+                n = ncr_prep_run(g_out, REPLAY_OUT_MAX);
+            }
+
+            us = (replay_us() - t) / REPLAY_REPEAT;
+            recorded = g_ncr_prep.num;
+            strokes = g_ncr_prep.stroke;
+
+            if (raw)
+            {
+                chars++;
+                CHECK(n > 0 && n <= REPLAY_OUT_MAX, "character %d (%s): %d points", chars, label, n);
+                CHECK(g_ncr_prep.end[strokes - 1] == recorded, "character %d (%s): %d of %d recorded points are in the strokes",
+                      chars, label, g_ncr_prep.end[strokes - 1], recorded);
+
+                for (i = 0; i < n; i++)
+                {
+                    CHECK(g_out[i].x >= 0 && g_out[i].x < NCR_PREP_BOX && g_out[i].y >= 0 && g_out[i].y < NCR_PREP_BOX,
+                          "character %d (%s): point %d (%d,%d) out of the box", chars, label, i, g_out[i].x, g_out[i].y);
+                }
+
+                raw_sum += raw;
+                rec_sum += recorded;
+                out_sum += n;
+                us_sum += us;
+                if (us > us_max)us_max = us;
+
+                if (board_pre >= 0)
+                {
+                    board_chars++;
+                    board_pre_sum += board_pre;
+                    board_ncr_sum += board_ncr;
+                }
+
+                if (verbose)
+                {
+                    printf("%-10s %7d %6ld %8d %6d %8.1f%% %9.1f ", label, strokes, raw, recorded, n, 100.0 * (raw - n) / raw, us);
+
+                    if (board_pre >= 0)printf("%4d+%-4d\n", board_pre, board_ncr);
+                    else printf("%9s\n", "-");
+                }
+            }
+
+            ncr_prep_reset();
+            raw = 0;
+            board_pre = -1;
+        }
+    }
+
+    fclose(f);
+
+    if (chars == 0)
+    {
+        printf("no character in %s\n", argv[optind]);
+        return 2;
+    }
+
+    printf("%d characters: %.1f points from the screen, %.1f recorded, %.1f to the recognizer (%.1f%% fewer)\n", chars,
+           (double)raw_sum / chars, (double)rec_sum / chars, (double)out_sum / chars, 100.0 * (raw_sum - out_sum) / raw_sum);
+    printf("preprocessing on the host: %.1fus per character, %.1fus at most\n", us_sum / chars, us_max);
+
+    if (board_chars)
+    {
+        printf("on the board (%d characters): preprocessing %.1fms, recognition %.1fms\n", board_chars,
+               (double)board_pre_sum / board_chars, (double)board_ncr_sum / board_chars);
+    }
+
+    printf(g_fails ? "FAILED\n" : "all passed\n");
+    return g_fails ? 1 : 0;
+}
@@ -14,6 +14,7 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     remove iap_write_appbin, the image is written by iap_stream.c
  *
  ****************************************************************************************************
  */
@@ -30,7 +31,6 @@ typedef void (*iapfun)(void);                   /* Define an argument of type fu
 #define FLASH_APP1_ADDR         0x08010000
 
 void iap_load_app(uint32_t appxaddr);                                         /* Jump to APP program execution */
-void iap_write_appbin(uint32_t appxaddr, uint8_t *appbuf, uint32_t applen);   /* At the specified address, write to bin */
 
 #endif
 
@@ -0,0 +1,492 @@
+/**
+ ****************************************************************************************************
+ * @file        iap_delta.c
+ * @author      ALIENTEK
+ * @brief       IAP delta update code
+ *
+ *              A delta patch (see iap_delta.h) is applied in place to the installed application while it
+ *              is received. Each changed page is built in SRAM from the old image and the literal bytes,
+ *              copied to the journal page (IAP_JRNL_ADDR), then the application page is rewritten.
+ *              The pages that do not change are neither sent nor erased.
+ *              If the update is interrupted, the same patch is sent again: the pages already rewritten
+ *              are skipped and the page being rewritten is finished from its journal copy.
+ *              A journal CRC torn by a power loss does not match the journal: the application page was
+ *              not erased yet, so the page is journaled again and its CRC goes to a spare slot.
+ *              The patch is made by tools/iap_delta.py and sent by tools/iap_send.py --delta.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     a torn journal CRC no longer blocks the update, the page is journaled again
+ * V1.2         20261019     the pages are verified by the read-back of stmflash_write
+ *
+ ****************************************************************************************************
+ */
+
+#include "iap_delta.h"
+#include "iap_stream.h"
+#include "iap.h"
+#include "../../BSP/STMFLASH/stmflash.h"
+
+
+/* Patch parser state, g_iap_delta_need gives the size of the field received in each state */
+#define IAP_DELTA_HEADER        0                           /* Patch header */
+#define IAP_DELTA_PAGE          1                           /* page + number of ops */
+#define IAP_DELTA_OP            2                           /* op code */
+#define IAP_DELTA_COPY          3                           /* src + len of IAP_DELTA_OP_COPY */
+#define IAP_DELTA_ADDLEN        4                           /* len of IAP_DELTA_OP_ADD */
+#define IAP_DELTA_ADD           5                           /* Literal bytes of IAP_DELTA_OP_ADD */
+
+static const uint8_t g_iap_delta_need[] = {IAP_DELTA_HEAD, 4, 1, 6, 2, 0};
+
+static uint32_t g_iap_delta_page[FLASH_PAGE_SIZE / 4];      /* Page being built */
+
+static struct
+{
+    uint8_t  sta;                                           /* Parser state */
+    uint8_t  field[IAP_DELTA_HEAD];                         /* Field being received */
+    uint8_t  pos;                                           /* Number of bytes in field */
+    uint8_t  skip;                                          /* 1, the page was already rewritten by an interrupted update */
+    uint32_t old_size;                                      /* Size of the installed image */
+    uint32_t new_size;                                      /* Size of the patched image */
+    uint32_t new_crc;                                       /* CRC-32 of the patched image */
+    uint16_t page;                                          /* Page being built */
+    uint16_t nops;                                          /* Number of ops left in the page record */
+    uint16_t plen;                                          /* Number of image bytes in the page */
+    uint16_t fill;                                          /* Number of bytes built */
+    uint16_t left;                                          /* Literal bytes left in IAP_DELTA_OP_ADD */
+} g_iap_delta;
+
+/**
+ * @brief   Erases one flash page
+ * @param   addr : page address
+ * @retval  None
+ */
+static void iap_delta_erase(uint32_t addr)
+{
+    FLASH_EraseInitTypeDef flash_erase_init_struct = {0};
+    uint32_t pageerr;
+
+    flash_erase_init_struct.TypeErase = FLASH_TYPEERASE_PAGES;
+    flash_erase_init_struct.Banks = FLASH_BANK_1;
+    flash_erase_init_struct.PageAddress = addr;
+    flash_erase_init_struct.NbPages = 1;
+    HAL_FLASH_Unlock();
+    HAL_FLASHEx_Erase(&flash_erase_init_struct, &pageerr);
+    HAL_FLASH_Lock();
+}
+
+/**
+ * @brief   Gets the number of image bytes in a page of the patched image
+ * @param   page : page index
+ * @retval  1 ~ FLASH_PAGE_SIZE
+ */
+static uint16_t iap_delta_plen(uint16_t page)
+{
+    uint32_t rest = g_iap_delta.new_size - page * FLASH_PAGE_SIZE;
+
+    return (rest > FLASH_PAGE_SIZE) ? FLASH_PAGE_SIZE : rest;
+}
+
+/**
+ * @brief   Programs g_iap_delta_page into an application page and records it
+ * @param   page : page index
+ * @param   plen : number of image bytes in the page
+ * @retval  IAP_OK or IAP_ERR_FLASH
+ */
+static uint8_t iap_delta_program(uint16_t page, uint16_t plen)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint32_t addr = FLASH_APP1_ADDR + page * FLASH_PAGE_SIZE;
+    uint16_t words = (plen + 3) / 4;
+
+    if (stmflash_write(addr, g_iap_delta_page, words))return IAP_ERR_FLASH;    /* Each half-word is read back */
+
+    iap_info_clear((uint32_t)&info->page[page]);
+    return IAP_OK;
+}
+
+/**
+ * @brief   Checks that the journal page holds the copy of a page
+ * @note    jcrc (or a spare slot) is only recorded once the journal copy has been verified, and the
+ *          application page is erased after that. A page without a matching CRC still holds its old content:
+ *          no CRC was recorded, or the power was lost while it was being programmed.
+ * @param   page : page index
+ * @retval  0, not journaled; 1, the journal holds the page
+ */
+static uint8_t iap_delta_journaled(uint16_t page)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint32_t tag = page | ((uint32_t)(uint16_t)~page << 16);
+    uint32_t crc;
+    uint8_t i;
+
+    for (i = 0; i < IAP_JRNL_SPARE; i++)
+    {
+        if (info->jspare[i].page == tag)break;
+    }
+
+    if (info->jcrc[page] == 0xFFFFFFFF && i == IAP_JRNL_SPARE)return 0;    /* No CRC recorded, do not compute it */
+
+    crc = iap_crc32(0, (uint8_t *)IAP_JRNL_ADDR, iap_delta_plen(page));
+
+    if (info->jcrc[page] == crc)return 1;
+
+    for (i = 0; i < IAP_JRNL_SPARE; i++)
+    {
+        if (info->jspare[i].page == tag && info->jspare[i].crc == crc)return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Records the CRC of the journal copy of a page
+ * @note    In jcrc if it was never written, otherwise (torn by a power loss) in the first free spare slot
+ * @param   page : page index
+ * @param   crc  : CRC-32 of the journal copy
+ * @retval  IAP_OK or IAP_ERR_FLASH (no free slot)
+ */
+static uint8_t iap_delta_jcrc(uint16_t page, uint32_t crc)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint32_t slot[2];
+    uint8_t i;
+
+    if (info->jcrc[page] == 0xFFFFFFFF)
+    {
+        stmflash_write_nocheck((uint32_t)&info->jcrc[page], &crc, 1);
+        return IAP_OK;
+    }
+
+    for (i = 0; i < IAP_JRNL_SPARE; i++)
+    {
+        if (info->jspare[i].page == 0xFFFFFFFF && info->jspare[i].crc == 0xFFFFFFFF)break;
+    }
+
+    if (i == IAP_JRNL_SPARE)return IAP_ERR_FLASH;
+
+    slot[0] = page | ((uint32_t)(uint16_t)~page << 16);
+    slot[1] = crc;
+    stmflash_write_nocheck((uint32_t)&info->jspare[i], slot, 2);    /* The tag first, the CRC last */
+    return IAP_OK;
+}
+
+/**
+ * @brief   Finishes a page from its journal copy
+ * @param   page : page index, iap_delta_journaled has returned 1
+ * @retval  IAP_OK or IAP_ERR_FLASH
+ */
+static uint8_t iap_delta_restore(uint16_t page)
+{
+    uint16_t i;
+
+    for (i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+    {
+        g_iap_delta_page[i] = stmflash_read_word(IAP_JRNL_ADDR + i * 4);
+    }
+
+    return iap_delta_program(page, iap_delta_plen(page));
+}
+
+/**
+ * @brief   Writes the page that has been built
+ * @param   None
+ * @retval  IAP_OK or IAP_ERR_FLASH
+ */
+static uint8_t iap_delta_write_page(void)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint16_t page = g_iap_delta.page;
+    uint16_t plen = g_iap_delta.plen;
+    uint32_t addr = FLASH_APP1_ADDR + page * FLASH_PAGE_SIZE;
+    uint16_t words = (plen + 3) / 4;
+    uint16_t i;
+    uint32_t crc;
+
+    if (g_iap_delta.skip)return IAP_OK;
+
+    for (i = 0; i < words; i++)
+    {
+        if (stmflash_read_word(addr + i * 4) != g_iap_delta_page[i])break;
+    }
+
+    if (i == words)     /* Same content, nothing to erase */
+    {
+        iap_info_clear((uint32_t)&info->page[page]);
+        return IAP_OK;
+    }
+
+    /* Not journaled, or its CRC was torn (iap_delta_head restored the journaled pages): the page is intact */
+    iap_delta_erase(IAP_JRNL_ADDR);
+
+    if (stmflash_write_nocheck(IAP_JRNL_ADDR, g_iap_delta_page, words))return IAP_ERR_FLASH;
+
+    crc = iap_crc32(0, (uint8_t *)g_iap_delta_page, plen);
+
+    if (iap_delta_jcrc(page, crc))return IAP_ERR_FLASH;     /* From now on the page can be finished from the journal */
+
+    return iap_delta_program(page, plen);
+}
+
+/**
+ * @brief   Handles the patch header
+ * @param   None
+ * @retval  IAP_OK or error code
+ */
+static uint8_t iap_delta_head(void)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint8_t *f = g_iap_delta.field;
+    uint32_t old_crc = iap_get_u32(f + 8);
+    uint16_t i, pages;
+    uint8_t res;
+
+    g_iap_delta.old_size = iap_get_u32(f + 4);
+    g_iap_delta.new_size = iap_get_u32(f + 12);
+    g_iap_delta.new_crc = iap_get_u32(f + 16);
+
+    if (iap_get_u32(f) != IAP_DELTA_MAGIC)return IAP_ERR_PATCH;
+
+    if (g_iap_delta.old_size == 0 || g_iap_delta.old_size > IAP_APP_MAX_SIZE)return IAP_ERR_SIZE;
+
+    if (g_iap_delta.new_size == 0 || g_iap_delta.new_size > IAP_APP_MAX_SIZE)return IAP_ERR_SIZE;
+
+    if (info->magic == IAP_INFO_MAGIC && info->size == g_iap_delta.new_size &&
+        info->crc == g_iap_delta.new_crc && info->base == old_crc)
+    {
+        /* Same patch as the interrupted update, finish the page that was being rewritten */
+        pages = (g_iap_delta.new_size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+
+        for (i = 0; i < pages; i++)
+        {
+            if (info->page[i] != 0 && iap_delta_journaled(i))
+            {
+                res = iap_delta_restore(i);
+
+                if (res)return res;
+            }
+        }
+    }
+    else
+    {
+        if (iap_crc32(0, (uint8_t *)FLASH_APP1_ADDR, g_iap_delta.old_size) != old_crc)return IAP_ERR_BASE;
+
+        iap_info_begin(g_iap_delta.new_size, g_iap_delta.new_crc, old_crc);
+    }
+
+    return IAP_OK;
+}
+
+/**
+ * @brief   Handles IAP_DELTA_OP_COPY
+ * @param   None
+ * @retval  IAP_OK or IAP_ERR_PATCH
+ */
+static uint8_t iap_delta_copy(void)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint8_t *page = (uint8_t *)g_iap_delta_page;
+    uint8_t *f = g_iap_delta.field;
+    uint32_t src = iap_get_u32(f);
+    uint16_t len = f[4] | ((uint16_t)f[5] << 8);
+    uint16_t i;
+
+    if (len == 0 || g_iap_delta.fill + len > g_iap_delta.plen)return IAP_ERR_PATCH;
+
+    if (g_iap_delta.skip == 0)
+    {
+        if (src >= g_iap_delta.old_size || len > g_iap_delta.old_size - src)return IAP_ERR_PATCH;
+
+        for (i = src / FLASH_PAGE_SIZE; i <= (src + len - 1) / FLASH_PAGE_SIZE; i++)
+        {
+            if (i != g_iap_delta.page && info->page[i] == 0)return IAP_ERR_PATCH;  /* The old content is gone */
+        }
+
+        for (i = 0; i < len; i++)
+        {
+            page[g_iap_delta.fill + i] = *(uint8_t *)(FLASH_APP1_ADDR + src + i);
+        }
+    }
+
+    g_iap_delta.fill += len;
+    return IAP_OK;
+}
+
+/**
+ * @brief   Moves to the next op after an op has been completed
+ * @param   None
+ * @retval  IAP_OK or error code
+ */
+static uint8_t iap_delta_op_done(void)
+{
+    g_iap_delta.sta = IAP_DELTA_OP;
+
+    if (--g_iap_delta.nops)return IAP_OK;
+
+    g_iap_delta.sta = IAP_DELTA_PAGE;
+
+    if (g_iap_delta.fill != g_iap_delta.plen)return IAP_ERR_PATCH;
+
+    return iap_delta_write_page();
+}
+
+/**
+ * @brief   Handles a field that has been received
+ * @param   None
+ * @retval  IAP_OK or error code
+ */
+static uint8_t iap_delta_field(void)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint8_t *f = g_iap_delta.field;
+    uint16_t i, len;
+    uint8_t res;
+
+    switch (g_iap_delta.sta)
+    {
+        case IAP_DELTA_HEADER:
+            res = iap_delta_head();
+
+            if (res)return res;
+
+            g_iap_delta.sta = IAP_DELTA_PAGE;
+            break;
+
+        case IAP_DELTA_PAGE:
+            g_iap_delta.page = f[0] | ((uint16_t)f[1] << 8);
+            g_iap_delta.nops = f[2] | ((uint16_t)f[3] << 8);
+
+            if ((uint32_t)g_iap_delta.page * FLASH_PAGE_SIZE >= g_iap_delta.new_size || g_iap_delta.nops == 0)return IAP_ERR_PATCH;
+
+            g_iap_delta.plen = iap_delta_plen(g_iap_delta.page);
+            g_iap_delta.fill = 0;
+            g_iap_delta.skip = (info->page[g_iap_delta.page] == 0);
+
+            for (i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+            {
+                g_iap_delta_page[i] = 0xFFFFFFFF;
+            }
+
+            g_iap_delta.sta = IAP_DELTA_OP;
+            break;
+
+        case IAP_DELTA_OP:
+            if (f[0] == IAP_DELTA_OP_COPY)g_iap_delta.sta = IAP_DELTA_COPY;
+            else if (f[0] == IAP_DELTA_OP_ADD)g_iap_delta.sta = IAP_DELTA_ADDLEN;
+            else return IAP_ERR_PATCH;
+
+            break;
+
+        case IAP_DELTA_COPY:
+            res = iap_delta_copy();
+
+            if (res)return res;
+
+            return iap_delta_op_done();
+
+        case IAP_DELTA_ADDLEN:
+            len = f[0] | ((uint16_t)f[1] << 8);
+
+            if (len == 0 || g_iap_delta.fill + len > g_iap_delta.plen)return IAP_ERR_PATCH;
+
+            g_iap_delta.left = len;
+            g_iap_delta.sta = IAP_DELTA_ADD;
+            break;
+    }
+
+    return IAP_OK;
+}
+
+/**
+ * @brief   A patch is going to be received
+ * @param   None
+ * @retval  None
+ */
+void iap_delta_begin(void)
+{
+    g_iap_delta.sta = IAP_DELTA_HEADER;
+    g_iap_delta.pos = 0;
+}
+
+/**
+ * @brief   Applies the next bytes of the patch
+ * @note    A page is rewritten as soon as its record is complete
+ * @param   buf : patch data
+ * @param   len : length in bytes
+ * @retval  IAP_OK or error code, the patch has to be sent again after an error
+ */
+uint8_t iap_delta_data(const uint8_t *buf, uint16_t len)
+{
+    uint8_t *page = (uint8_t *)g_iap_delta_page;
+    uint8_t res;
+
+    while (len)
+    {
+        if (g_iap_delta.sta == IAP_DELTA_ADD)   /* Literal bytes go straight to the page */
+        {
+            while (len && g_iap_delta.left)
+            {
+                page[g_iap_delta.fill++] = *buf++;
+                g_iap_delta.left--;
+                len--;
+            }
+
+            if (g_iap_delta.left == 0)
+            {
+                res = iap_delta_op_done();
+
+                if (res)return res;
+            }
+
+            continue;
+        }
+
+        g_iap_delta.field[g_iap_delta.pos++] = *buf++;
+        len--;
+
+        if (g_iap_delta.pos < g_iap_delta_need[g_iap_delta.sta])continue;
+
+        g_iap_delta.pos = 0;
+        res = iap_delta_field();
+
+        if (res)return res;
+    }
+
+    return IAP_OK;
+}
+
+/**
+ * @brief   Verifies the patched image
+ * @param   None
+ * @retval  IAP_OK or error code
+ */
+uint8_t iap_delta_end(void)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+
+    if (g_iap_delta.sta != IAP_DELTA_PAGE || g_iap_delta.pos != 0)return IAP_ERR_PATCH;    /* Truncated patch */
+
+    if (iap_crc32(0, (uint8_t *)FLASH_APP1_ADDR, g_iap_delta.new_size) != g_iap_delta.new_crc)
+    {
+        /* The old image is lost, only a full image can be sent now */
+        iap_info_begin(g_iap_delta.new_size, g_iap_delta.new_crc, 0xFFFFFFFF);
+        return IAP_ERR_VERIFY;
+    }
+
+    if (info->valid != 0)
+    {
+        iap_info_clear((uint32_t)&info->valid);
+        iap_info_clear((uint32_t)&info->valid + 2);
+    }
+
+    return IAP_OK;
+}
@@ -0,0 +1,46 @@
+/**
+ ****************************************************************************************************
+ * @file        iap_delta.h
+ * @author      ALIENTEK
+ * @brief       IAP delta update code
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __IAP_DELTA_H
+#define __IAP_DELTA_H
+
+#include "main.h"
+
+
+/* Patch format (all the fields are little endian), made by tools/iap_delta.py:
+ * header  : magic(4) | old size(4) | old CRC-32(4) | new size(4) | new CRC-32(4)
+ * records : page(2) | number of ops(2) | ops, one record for each page of the new image that changes
+ * ops     : IAP_DELTA_OP_COPY src(4) len(2) : copy len bytes of the installed image from offset src
+ *           IAP_DELTA_OP_ADD  len(2) data   : literal bytes
+ * The ops of a record fill the page from its first byte, up to the end of the new image.
+ * A page that is not listed keeps its content and is never erased.
+ * A copy may only read a page that has not been rewritten yet, or the page being built
+ * (it is built in SRAM before its old content is erased), the generator orders the records so.
+ */
+#define IAP_DELTA_MAGIC         0x44504149                  /* "IAPD" */
+#define IAP_DELTA_HEAD          20
+#define IAP_DELTA_OP_COPY       0x01
+#define IAP_DELTA_OP_ADD        0x02
+
+void iap_delta_begin(void);                                 /* A patch is going to be received */
+uint8_t iap_delta_data(const uint8_t *buf, uint16_t len);   /* Applies the next bytes of the patch */
+uint8_t iap_delta_end(void);                                /* Verifies the patched image */
+
+#endif
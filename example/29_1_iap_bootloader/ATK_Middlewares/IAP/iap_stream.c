@@ -0,0 +1,619 @@
+/**
+ ****************************************************************************************************
+ * @file        iap_stream.c
+ * @author      ALIENTEK
+ * @brief       IAP streaming update code
+ *
+ *              The application is received in framed chunks (see iap_stream.h) and each 2KB flash page
+ *              is programmed as soon as it is complete. USART1 receives by circular DMA, so the next
+ *              frames keep arriving while the CPU is stalled by the flash erase/program.
+ *              The progress is recorded in the last flash page, an interrupted update is resumed from
+ *              the first page that was not programmed, and the image CRC-32 is checked before it is run.
+ *              A delta patch (IAP_CMD_DELTA) is handed over to iap_delta.c instead of being programmed.
+ *              The host side sender is tools/iap_send.py.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     add IAP_CMD_DELTA
+ * V1.2         20261019     resynchronize after a receive error, detect the DMA lapping the reader
+ * V1.3         20261019     the pages are verified by the read-back of stmflash_write
+ *
+ ****************************************************************************************************
+ */
+
+#include "iap_stream.h"
+#include "iap_delta.h"
+#include "iap.h"
+#include "usart.h"
+#include "../../BSP/STMFLASH/stmflash.h"
+
+
+#define IAP_FRAME_HEAD          4                           /* cmd + seq + len */
+#define IAP_FRAME_MAX           (IAP_FRAME_HEAD + 4 + IAP_DATA_MAX + 2)
+
+/* Frame parser state */
+#define IAP_PARSE_SOF1          0
+#define IAP_PARSE_SOF2          1
+#define IAP_PARSE_HEAD          2
+#define IAP_PARSE_BODY          3
+
+static uint8_t g_iap_frame[IAP_FRAME_MAX];                  /* Frame being received, starting from cmd */
+static uint16_t g_iap_frame_pos;                            /* Number of bytes in g_iap_frame */
+static uint16_t g_iap_frame_len;                            /* Payload length of the frame */
+static uint8_t g_iap_parse_sta = IAP_PARSE_SOF1;
+static uint32_t g_iap_rx_tick;                              /* Tick of the last received byte */
+static uint16_t g_iap_rx_rd;                                /* Read position of the DMA ring buffer */
+static uint32_t g_iap_rx_cnt;                               /* Bytes read since the DMA (re)started, compared with the bytes written */
+
+static uint32_t g_iap_page[FLASH_PAGE_SIZE / 4];            /* Page being received */
+
+/* Update state */
+static struct
+{
+    uint8_t  started;                                       /* 0, no update; 1, IAP_CMD_START or IAP_CMD_DELTA received */
+    uint8_t  delta;                                         /* 0, the data is the image; 1, the data is a delta patch */
+    uint32_t size;                                          /* Image (patch) size */
+    uint32_t crc;                                           /* Image (patch) CRC-32 */
+    uint32_t offset;                                        /* Next expected image (patch) offset */
+    uint32_t pcrc;                                          /* CRC-32 of the patch data received so far */
+} g_iap_sta;
+
+/* CRC-32 nibble table (IEEE 802.3, reflected polynomial 0xEDB88320) */
+static const uint32_t g_crc32_tab[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+/**
+ * @brief   Computes the CRC-32 (same as zlib crc32)
+ * @param   crc : CRC of the previous data, 0 for the first block
+ * @param   buf : data
+ * @param   len : length in bytes
+ * @retval  CRC-32
+ */
+uint32_t iap_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+
+    while (len--)
+    {
+        crc ^= *buf++;
+        crc = (crc >> 4) ^ g_crc32_tab[crc & 0x0F];
+        crc = (crc >> 4) ^ g_crc32_tab[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+/**
+ * @brief   Computes the CRC-16/CCITT-FALSE of a frame
+ * @param   buf : data
+ * @param   len : length in bytes
+ * @retval  CRC-16
+ */
+static uint16_t iap_crc16(const uint8_t *buf, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+    uint8_t i;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)(*buf++) << 8;
+
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * @brief   Reads a little endian 32-bit value
+ * @param   buf : data
+ * @retval  value
+ */
+uint32_t iap_get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/**
+ * @brief   Sends the answer of a frame
+ * @param   cmd    : command of the request
+ * @param   seq    : sequence number of the request
+ * @param   status : IAP_OK or error code
+ * @retval  None
+ */
+static void iap_send_ack(uint8_t cmd, uint8_t seq, uint8_t status)
+{
+    uint8_t buf[13];
+    uint16_t crc;
+    uint32_t offset = g_iap_sta.offset;
+
+    buf[0] = IAP_FRAME_SOF1;
+    buf[1] = IAP_FRAME_SOF2;
+    buf[2] = cmd | IAP_CMD_ACK;
+    buf[3] = seq;
+    buf[4] = 5;
+    buf[5] = 0;
+    buf[6] = status;
+    buf[7] = offset;
+    buf[8] = offset >> 8;
+    buf[9] = offset >> 16;
+    buf[10] = offset >> 24;
+    crc = iap_crc16(&buf[2], 9);
+    buf[11] = crc;
+    buf[12] = crc >> 8;
+    HAL_UART_Transmit(&huart1, buf, sizeof(buf), 100);
+}
+
+/**
+ * @brief   Starts a new update record in the last flash page
+ * @param   size : image size
+ * @param   crc  : image CRC-32
+ * @param   base : CRC-32 of the image a delta patch applies to, 0XFFFFFFFF for a full image
+ * @retval  None
+ */
+void iap_info_begin(uint32_t size, uint32_t crc, uint32_t base)
+{
+    FLASH_EraseInitTypeDef flash_erase_init_struct = {0};
+    uint32_t pageerr;
+    uint32_t head[5];
+
+    flash_erase_init_struct.TypeErase = FLASH_TYPEERASE_PAGES;
+    flash_erase_init_struct.Banks = FLASH_BANK_1;
+    flash_erase_init_struct.PageAddress = IAP_INFO_ADDR;
+    flash_erase_init_struct.NbPages = 1;
+    HAL_FLASH_Unlock();
+    HAL_FLASHEx_Erase(&flash_erase_init_struct, &pageerr);
+    HAL_FLASH_Lock();
+
+    head[0] = IAP_INFO_MAGIC;
+    head[1] = size;
+    head[2] = crc;
+    head[3] = 0xFFFFFFFF;                                   /* valid */
+    head[4] = base;
+    stmflash_write_nocheck(IAP_INFO_ADDR, head, 5);
+}
+
+/**
+ * @brief   Clears a half-word of the update record (1 -> 0, no erase is needed)
+ * @param   addr : address of the half-word
+ * @retval  None
+ */
+void iap_info_clear(uint32_t addr)
+{
+    HAL_FLASH_Unlock();
+    HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, addr, 0);
+    HAL_FLASH_Lock();
+}
+
+/**
+ * @brief   Programs the received page and records it
+ * @param   page  : page index in the image
+ * @param   bytes : number of valid bytes in g_iap_page
+ * @retval  0, successful; 1, verify error
+ */
+static uint8_t iap_write_page(uint16_t page, uint32_t bytes)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint32_t addr = FLASH_APP1_ADDR + page * FLASH_PAGE_SIZE;
+    uint16_t words = (bytes + 3) / 4;
+    uint16_t i;
+
+    if (stmflash_write(addr, g_iap_page, words))return 1;   /* Each half-word is read back */
+
+    iap_info_clear((uint32_t)&info->page[page]);
+
+    for (i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+    {
+        g_iap_page[i] = 0xFFFFFFFF;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Handles IAP_CMD_START
+ * @param   payload : image size + image CRC-32
+ * @retval  IAP_OK or error code
+ */
+static uint8_t iap_cmd_start(uint8_t *payload)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+    uint32_t size = iap_get_u32(payload);
+    uint32_t crc = iap_get_u32(payload + 4);
+    uint16_t i;
+
+    g_iap_sta.started = 0;
+    g_iap_sta.delta = 0;
+    g_iap_sta.offset = 0;
+
+    if (size == 0 || size > IAP_APP_MAX_SIZE)return IAP_ERR_SIZE;
+
+    if (info->magic == IAP_INFO_MAGIC && info->size == size && info->crc == crc)
+    {
+        /* Same image as the interrupted update, continue from the first page not programmed */
+        for (i = 0; i < (size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE; i++)
+        {
+            if (info->page[i] != 0)break;
+        }
+
+        g_iap_sta.offset = i * FLASH_PAGE_SIZE;
+
+        if (g_iap_sta.offset > size)g_iap_sta.offset = size;
+    }
+    else
+    {
+        iap_info_begin(size, crc, 0xFFFFFFFF);
+    }
+
+    for (i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+    {
+        g_iap_page[i] = 0xFFFFFFFF;
+    }
+
+    g_iap_sta.size = size;
+    g_iap_sta.crc = crc;
+    g_iap_sta.started = 1;
+    return IAP_OK;
+}
+
+/**
+ * @brief   Handles IAP_CMD_DELTA
+ * @note    The patch is always sent from the beginning, iap_delta.c skips the pages already applied
+ * @param   payload : patch size + patch CRC-32
+ * @retval  IAP_OK or error code
+ */
+static uint8_t iap_cmd_delta(uint8_t *payload)
+{
+    g_iap_sta.started = 0;
+    g_iap_sta.offset = 0;
+    g_iap_sta.size = iap_get_u32(payload);
+    g_iap_sta.crc = iap_get_u32(payload + 4);
+
+    if (g_iap_sta.size == 0)return IAP_ERR_SIZE;
+
+    iap_delta_begin();
+    g_iap_sta.pcrc = 0;
+    g_iap_sta.delta = 1;
+    g_iap_sta.started = 1;
+    return IAP_OK;
+}
+
+/**
+ * @brief   Handles IAP_CMD_DATA
+ * @param   payload : offset + data
+ * @param   len     : payload length
+ * @retval  IAP_OK or error code
+ */
+static uint8_t iap_cmd_data(uint8_t *payload, uint16_t len)
+{
+    uint8_t *page = (uint8_t *)g_iap_page;
+    uint32_t offset = iap_get_u32(payload);
+    uint32_t pos;
+    uint8_t status;
+
+    if (g_iap_sta.started == 0)return IAP_ERR_STATE;
+
+    if (len <= 4)return IAP_ERR_SIZE;
+
+    if (offset != g_iap_sta.offset)return IAP_ERR_OFFSET;   /* A frame was lost, the host continues from g_iap_sta.offset */
+
+    len -= 4;
+    payload += 4;
+
+    if (offset + len > g_iap_sta.size)return IAP_ERR_SIZE;
+
+    if (g_iap_sta.delta)
+    {
+        g_iap_sta.pcrc = iap_crc32(g_iap_sta.pcrc, payload, len);
+        status = iap_delta_data(payload, len);
+
+        if (status != IAP_OK)
+        {
+            g_iap_sta.started = 0;  /* The patch has to be sent again, the applied pages are skipped */
+            return status;
+        }
+
+        g_iap_sta.offset += len;
+        return IAP_OK;
+    }
+
+    while (len--)
+    {
+        pos = g_iap_sta.offset % FLASH_PAGE_SIZE;
+        page[pos] = *payload++;
+        g_iap_sta.offset++;
+
+        if (pos == FLASH_PAGE_SIZE - 1 || g_iap_sta.offset == g_iap_sta.size) /* The page is complete */
+        {
+            if (iap_write_page((g_iap_sta.offset - 1) / FLASH_PAGE_SIZE, pos + 1))
+            {
+                g_iap_sta.offset -= pos + 1;    /* The whole page has to be sent again */
+                return IAP_ERR_FLASH;
+            }
+        }
+    }
+
+    return IAP_OK;
+}
+
+/**
+ * @brief   Handles IAP_CMD_END
+ * @param   None
+ * @retval  IAP_OK or error code
+ */
+static uint8_t iap_cmd_end(void)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+
+    if (g_iap_sta.started == 0)return IAP_ERR_STATE;
+
+    if (g_iap_sta.offset != g_iap_sta.size)return IAP_ERR_OFFSET;
+
+    g_iap_sta.started = 0;
+
+    if (g_iap_sta.delta)
+    {
+        if (g_iap_sta.pcrc != g_iap_sta.crc)return IAP_ERR_PATCH;
+
+        return iap_delta_end();
+    }
+
+    if (iap_crc32(0, (uint8_t *)FLASH_APP1_ADDR, g_iap_sta.size) != g_iap_sta.crc)
+    {
+        iap_info_begin(g_iap_sta.size, g_iap_sta.crc, 0xFFFFFFFF);      /* Forget the progress, the next update starts from the beginning */
+        g_iap_sta.offset = 0;
+        return IAP_ERR_VERIFY;
+    }
+
+    if (info->valid != 0)
+    {
+        iap_info_clear((uint32_t)&info->valid);
+        iap_info_clear((uint32_t)&info->valid + 2);
+    }
+
+    return IAP_OK;
+}
+
+/**
+ * @brief   Executes a received frame
+ * @param   None
+ * @retval  IAP_STREAM_BUSY, IAP_STREAM_DONE or IAP_STREAM_ERROR
+ */
+static uint8_t iap_frame_exe(void)
+{
+    uint8_t cmd = g_iap_frame[0];
+    uint8_t seq = g_iap_frame[1];
+    uint8_t *payload = &g_iap_frame[IAP_FRAME_HEAD];
+    uint16_t crc;
+    uint8_t status;
+
+    crc = g_iap_frame[IAP_FRAME_HEAD + g_iap_frame_len] | ((uint16_t)g_iap_frame[IAP_FRAME_HEAD + g_iap_frame_len + 1] << 8);
+
+    if (iap_crc16(g_iap_frame, IAP_FRAME_HEAD + g_iap_frame_len) != crc)
+    {
+        status = IAP_ERR_CRC;
+    }
+    else
+    {
+        switch (cmd)
+        {
+            case IAP_CMD_START:
+                status = (g_iap_frame_len == 8) ? iap_cmd_start(payload) : IAP_ERR_SIZE;
+                break;
+
+            case IAP_CMD_DELTA:
+                status = (g_iap_frame_len == 8) ? iap_cmd_delta(payload) : IAP_ERR_SIZE;
+                break;
+
+            case IAP_CMD_DATA:
+                status = iap_cmd_data(payload, g_iap_frame_len);
+                break;
+
+            case IAP_CMD_END:
+                status = iap_cmd_end();
+                break;
+
+            default:
+                status = IAP_ERR_CMD;
+                break;
+        }
+    }
+
+    iap_send_ack(cmd, seq, status);
+
+    if (status != IAP_OK)return IAP_STREAM_ERROR;
+
+    return (cmd == IAP_CMD_END) ? IAP_STREAM_DONE : IAP_STREAM_BUSY;
+}
+
+/**
+ * @brief   Feeds one received byte to the frame parser
+ * @param   ch : received byte
+ * @retval  0, frame not complete; 1, a frame has been received
+ */
+static uint8_t iap_parse_byte(uint8_t ch)
+{
+    switch (g_iap_parse_sta)
+    {
+        case IAP_PARSE_SOF1:
+            if (ch == IAP_FRAME_SOF1)g_iap_parse_sta = IAP_PARSE_SOF2;
+
+            break;
+
+        case IAP_PARSE_SOF2:
+            if (ch == IAP_FRAME_SOF2)
+            {
+                g_iap_frame_pos = 0;
+                g_iap_parse_sta = IAP_PARSE_HEAD;
+            }
+            else if (ch != IAP_FRAME_SOF1)
+            {
+                g_iap_parse_sta = IAP_PARSE_SOF1;
+            }
+
+            break;
+
+        case IAP_PARSE_HEAD:
+            g_iap_frame[g_iap_frame_pos++] = ch;
+
+            if (g_iap_frame_pos == IAP_FRAME_HEAD)
+            {
+                g_iap_frame_len = g_iap_frame[2] | ((uint16_t)g_iap_frame[3] << 8);
+
+                if (g_iap_frame_len > IAP_FRAME_MAX - IAP_FRAME_HEAD - 2)
+                {
+                    g_iap_parse_sta = IAP_PARSE_SOF1;   /* Not a valid frame, search the next start of frame */
+                }
+                else
+                {
+                    g_iap_parse_sta = IAP_PARSE_BODY;
+                }
+            }
+
+            break;
+
+        case IAP_PARSE_BODY:
+            g_iap_frame[g_iap_frame_pos++] = ch;
+
+            if (g_iap_frame_pos == IAP_FRAME_HEAD + g_iap_frame_len + 2)
+            {
+                g_iap_parse_sta = IAP_PARSE_SOF1;
+                return 1;
+            }
+
+            break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   Initializes the streaming update
+ * @note    USART1 must already be receiving into g_usart_rx_buf by circular DMA
+ * @param   None
+ * @retval  None
+ */
+void iap_stream_init(void)
+{
+    uint16_t i;
+
+    g_usart_rx_restart = 0;
+    g_iap_parse_sta = IAP_PARSE_SOF1;
+    g_iap_rx_rd = (USART_REC_LEN - __HAL_DMA_GET_COUNTER(&hdma_usart1_rx)) % USART_REC_LEN;
+    g_iap_rx_cnt = g_usart_rx_laps * USART_REC_LEN + g_iap_rx_rd;
+    g_iap_sta.started = 0;
+
+    for (i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+    {
+        g_iap_page[i] = 0xFFFFFFFF;
+    }
+}
+
+/**
+ * @brief   Handles the received frames
+ * @note    It needs to be called regularly, the data received since the last call must fit in g_usart_rx_buf.
+ *          The host keeps at most 2 frames unacknowledged, so this is guaranteed by the ring buffer size.
+ *          If the DMA still laps the reader, or restarts after a receive error, the unread data and the
+ *          frame being parsed are dropped: the host sends them again when their acknowledgement is missing.
+ * @param   None
+ * @retval  IAP_STREAM_IDLE, IAP_STREAM_BUSY, IAP_STREAM_DONE or IAP_STREAM_ERROR
+ */
+uint8_t iap_stream_poll(void)
+{
+    uint32_t laps, wr_cnt, n;
+    uint16_t wr;
+    uint8_t res = g_iap_sta.started ? IAP_STREAM_BUSY : IAP_STREAM_IDLE;
+    uint8_t sta;
+
+    do                                          /* Lap count and position of the same instant */
+    {
+        laps = g_usart_rx_laps;
+        wr = (USART_REC_LEN - __HAL_DMA_GET_COUNTER(&hdma_usart1_rx)) % USART_REC_LEN;
+    } while (laps != g_usart_rx_laps);
+
+    if (g_usart_rx_restart)                     /* HAL_UART_ErrorCallback restarted the DMA at index 0, maybe after the reads above */
+    {
+        g_usart_rx_restart = 0;
+        g_iap_parse_sta = IAP_PARSE_SOF1;
+        g_iap_rx_rd = 0;
+        g_iap_rx_cnt = 0;
+        return res;
+    }
+
+    wr_cnt = laps * USART_REC_LEN + wr;
+
+    if (wr_cnt < g_iap_rx_cnt)wr_cnt += USART_REC_LEN;  /* Wrapped, the transfer complete interrupt is still pending */
+
+    n = wr_cnt - g_iap_rx_cnt;
+
+    if (n > USART_REC_LEN)                      /* The DMA lapped the reader: unread data was overwritten */
+    {
+        g_iap_parse_sta = IAP_PARSE_SOF1;
+        g_iap_rx_rd = wr;
+        g_iap_rx_cnt = wr_cnt;
+        return IAP_STREAM_ERROR;
+    }
+
+    if (n == 0)
+    {
+        if (g_iap_parse_sta != IAP_PARSE_SOF1 && HAL_GetTick() - g_iap_rx_tick > IAP_FRAME_TIMEOUT)
+        {
+            g_iap_parse_sta = IAP_PARSE_SOF1;   /* The link was interrupted in the middle of a frame */
+        }
+
+        return res;
+    }
+
+    g_iap_rx_tick = HAL_GetTick();
+
+    while (n--)
+    {
+        sta = iap_parse_byte(g_usart_rx_buf[g_iap_rx_rd]);
+        g_iap_rx_rd = (g_iap_rx_rd + 1) % USART_REC_LEN;
+        g_iap_rx_cnt++;
+
+        if (sta)
+        {
+            sta = iap_frame_exe();
+
+            if (res != IAP_STREAM_DONE)res = sta;   /* A completed update is always reported */
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief   Verifies the application before it is run
+ * @param   appxaddr : The start address of the application
+ * @retval  0, the image is complete and its CRC-32 matches;
+ *          1, no update record (the application was not written by the streaming update);
+ *          2, the update is incomplete or the image is corrupted
+ */
+uint8_t iap_stream_check(uint32_t appxaddr)
+{
+    iap_info_t *info = (iap_info_t *)IAP_INFO_ADDR;
+
+    if (info->magic != IAP_INFO_MAGIC)return 1;
+
+    if (info->valid != 0 || info->size > IAP_APP_MAX_SIZE)return 2;
+
+    if (iap_crc32(0, (uint8_t *)appxaddr, info->size) != info->crc)return 2;
+
+    return 0;
+}
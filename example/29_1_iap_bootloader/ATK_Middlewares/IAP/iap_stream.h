@@ -0,0 +1,110 @@
+/**
+ ****************************************************************************************************
+ * @file        iap_stream.h
+ * @author      ALIENTEK
+ * @brief       IAP streaming update code
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     add IAP_CMD_DELTA (see iap_delta.h) and the page journal
+ * V1.2         20261019     spare journal CRC slots, used when a power loss tore jcrc
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __IAP_STREAM_H
+#define __IAP_STREAM_H
+
+#include "main.h"
+#include "iap.h"
+
+
+/* Frame format (all the fields are little endian):
+ * SOF1 SOF2 | cmd(1) | seq(1) | len(2) | payload(len) | crc16(2)
+ * crc16 is CRC-16/CCITT-FALSE over cmd, seq, len and payload.
+ *
+ * Host -> device:
+ * IAP_CMD_START : payload = image size(4) + image CRC-32(4), answered with the offset to continue from
+ * IAP_CMD_DATA  : payload = offset(4) + data(1 ~ IAP_DATA_MAX bytes), the offset must be the expected one
+ * IAP_CMD_DELTA : payload = patch size(4) + patch CRC-32(4), the following IAP_CMD_DATA frames carry a
+ *                 delta patch (see iap_delta.h) instead of the image, always answered with offset 0
+ * IAP_CMD_END   : no payload, the image in flash is verified
+ *
+ * Device -> host: cmd = request cmd | IAP_CMD_ACK, same seq, payload = status(1) + next offset(4)
+ */
+#define IAP_FRAME_SOF1          0xA5
+#define IAP_FRAME_SOF2          0x5A
+
+#define IAP_CMD_START           0x01
+#define IAP_CMD_DATA            0x02
+#define IAP_CMD_END             0x03
+#define IAP_CMD_DELTA           0x04
+#define IAP_CMD_ACK             0x80
+
+#define IAP_DATA_MAX            1024                        /* Maximum number of image bytes per IAP_CMD_DATA frame */
+#define IAP_FRAME_TIMEOUT       500                         /* A frame is dropped when no byte is received for this time (ms) */
+
+/* Status returned to the host */
+#define IAP_OK                  0
+#define IAP_ERR_CRC             1                           /* Frame CRC error */
+#define IAP_ERR_OFFSET          2                           /* Unexpected offset, the host must continue from the returned offset */
+#define IAP_ERR_SIZE            3                           /* Image too large, or data out of the image */
+#define IAP_ERR_FLASH           4                           /* Flash program/verify error */
+#define IAP_ERR_VERIFY          5                           /* Image CRC-32 mismatch */
+#define IAP_ERR_STATE           6                           /* No IAP_CMD_START received yet */
+#define IAP_ERR_CMD             7                           /* Unknown command */
+#define IAP_ERR_BASE            8                           /* The installed application is not the one the patch was made from */
+#define IAP_ERR_PATCH           9                           /* Malformed patch */
+
+/* Update record, stored in the last flash page. The page is erased once per update, a half-word flag
+ * is cleared to 0 each time an image page is programmed, so an interrupted update can be resumed.
+ * A delta update copies each new page to the journal page before the application page is erased. */
+#define IAP_INFO_ADDR           (FLASH_BANK1_END + 1 - FLASH_PAGE_SIZE)
+#define IAP_JRNL_ADDR           (IAP_INFO_ADDR - FLASH_PAGE_SIZE)
+#define IAP_INFO_MAGIC          0x49415031                  /* "IAP1" */
+#define IAP_APP_MAX_SIZE        (IAP_JRNL_ADDR - FLASH_APP1_ADDR)
+#define IAP_APP_MAX_PAGES       (IAP_APP_MAX_SIZE / FLASH_PAGE_SIZE)
+#define IAP_JRNL_SPARE          16                          /* Spare journal CRC slots */
+
+typedef struct
+{
+    uint32_t page;                                          /* page index | (~page << 16), a torn write does not pass this check */
+    uint32_t crc;                                           /* CRC-32 of the page copy in the journal page */
+} iap_jslot_t;
+
+typedef struct                                              /* 20 + IAP_APP_MAX_PAGES * 6 + IAP_JRNL_SPARE * 8 bytes, must fit in one page */
+{
+    uint32_t magic;                                         /* IAP_INFO_MAGIC */
+    uint32_t size;                                          /* Image size in bytes */
+    uint32_t crc;                                           /* Image CRC-32 */
+    uint32_t valid;                                         /* 0XFFFFFFFF, not verified; 0, image verified */
+    uint32_t base;                                          /* Delta update: CRC-32 of the image the patch applies to; full image: 0XFFFFFFFF */
+    uint32_t jcrc[IAP_APP_MAX_PAGES];                       /* CRC-32 of the page copy in the journal page, 0XFFFFFFFF if not journaled.
+                                                             * A value that does not match the journal was torn by a power loss */
+    uint16_t page[IAP_APP_MAX_PAGES];                       /* 0XFFFF, page not programmed; 0, page programmed */
+    iap_jslot_t jspare[IAP_JRNL_SPARE];                     /* Journal CRCs of the pages whose jcrc slot was torn */
+} iap_info_t;
+
+/* Return value of iap_stream_poll */
+#define IAP_STREAM_IDLE         0                           /* Nothing happened */
+#define IAP_STREAM_BUSY         1                           /* An update is in progress */
+#define IAP_STREAM_DONE         2                           /* The image has been received and verified */
+#define IAP_STREAM_ERROR        3                           /* The last frame was refused */
+
+void iap_stream_init(void);                                 /* Initialize the streaming update */
+uint8_t iap_stream_poll(void);                              /* Handle the received frames */
+uint8_t iap_stream_check(uint32_t appxaddr);                /* Verify the image before running it */
+uint32_t iap_crc32(uint32_t crc, const uint8_t *buf, uint32_t len);   /* CRC-32 (IEEE 802.3) */
+uint32_t iap_get_u32(const uint8_t *buf);                   /* Reads a little endian 32-bit value */
+void iap_info_begin(uint32_t size, uint32_t crc, uint32_t base);      /* Starts a new update record */
+void iap_info_clear(uint32_t addr);                         /* Clears a half-word of the update record */
+
+#endif
@@ -14,12 +14,24 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     stmflash_write skips identical pages, programs only the changed half-words
+ *                           when no erase is needed, and unlocks the flash once; add g_stmflash_cnt
+ * V1.2         20261019     each programmed half-word is read back, the write functions return an error
  *
  ****************************************************************************************************
  */
 
 #include "stmflash.h"
 
+/* Result of stmflash_check */
+#define STMFLASH_SAME       0                   /* The data is already in flash */
+#define STMFLASH_PROGRAM    1                   /* The changed half-words can be programmed without erasing */
+#define STMFLASH_ERASE      2                   /* The page has to be erased */
+
+stmflash_cnt_t g_stmflash_cnt = {0};            /* Erase/program counters */
+
+static uint32_t g_flash_buf[FLASH_PAGE_SIZE / sizeof(uint32_t)];
+
 /**
  * @brief   reads a single word of data from the specified address
  * @param   addr: Specifies the address from which to read the data
@@ -48,48 +60,142 @@ void stmflash_read(uint32_t addr, uint32_t *buf, uint32_t length)
     }
 }
 
+/**
+ * @brief   programs the half-words that differ from the flash content (flash must be unlocked)
+ * @note    A half-word can only be programmed when it is erased (0xFFFF), or to 0x0000,
+ *          so the erased half-words of buf (0xFFFF) never need to be programmed
+ * @param   addr   : Specifies the address to write the data to
+ * @param   buf    : The start address of the store to write data to
+ * @param   length : This specifies the length of the data to be written in words
+ * @retval  0, OK; 1, a half-word does not read back (not erased, or worn out)
+ */
+static uint8_t stmflash_program(uint32_t addr, uint32_t *buf, uint16_t length)
+{
+    uint16_t *data = (uint16_t *)buf;
+    uint16_t index;
+    uint8_t res = 0;
+    
+    for (index=0; index<length * 2; index++)
+    {
+        if (data[index] != *(volatile uint16_t *)(addr + index * 2))
+        {
+            HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, addr + index * 2, data[index]);
+            g_stmflash_cnt.program++;
+            
+            if (data[index] != *(volatile uint16_t *)(addr + index * 2))
+            {
+                g_stmflash_cnt.error++;
+                res = 1;
+            }
+        }
+    }
+    
+    return res;
+}
+
+/**
+ * @brief   erases one page (flash must be unlocked)
+ * @param   addr: page address
+ * @retval  0, OK; 1, erase error
+ */
+static uint8_t stmflash_erase_page(uint32_t addr)
+{
+    FLASH_EraseInitTypeDef flash_erase_init_struct = {0};
+    uint32_t pageerr;
+    
+    flash_erase_init_struct.TypeErase = FLASH_TYPEERASE_PAGES;
+    flash_erase_init_struct.Banks = FLASH_BANK_1;
+    flash_erase_init_struct.PageAddress = addr;
+    flash_erase_init_struct.NbPages = 1;
+    g_stmflash_cnt.erase++;
+    
+    if (HAL_FLASHEx_Erase(&flash_erase_init_struct, &pageerr) != HAL_OK)
+    {
+        g_stmflash_cnt.error++;
+        return 1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief   compares the data with the flash content
+ * @param   addr   : Specifies the address to write the data to
+ * @param   buf    : The start address of the store to write data to
+ * @param   length : This specifies the length of the data to be written in words (within one page)
+ * @retval  STMFLASH_SAME, STMFLASH_PROGRAM or STMFLASH_ERASE
+ */
+static uint8_t stmflash_check(uint32_t addr, uint32_t *buf, uint16_t length)
+{
+    uint16_t *data = (uint16_t *)buf;
+    uint16_t index;
+    uint16_t old;
+    uint8_t sta = STMFLASH_SAME;
+    
+    for (index=0; index<length * 2; index++)
+    {
+        old = *(volatile uint16_t *)(addr + index * 2);
+        
+        if (old == data[index])
+        {
+            continue;
+        }
+        
+        if (old != 0xFFFF && data[index] != 0x0000)
+        {
+            return STMFLASH_ERASE;
+        }
+        
+        sta = STMFLASH_PROGRAM;
+    }
+    
+    return sta;
+}
+
 /**
  * @brief   writes the specified word of data to the specified address without checking
+ * @note    The half-words already holding the data (e.g. 0xFFFF on an erased page) are not programmed
  * @param   addr: Specifies the address to write the data to
  * @param   buf: The start address of the store to write data to
  * @param   length: This specifies the length of the data to be written in words
- * @retval  None
+ * @retval  0, OK; 1, a half-word does not read back
  */
-void stmflash_write_nocheck(uint32_t addr, uint32_t *buf, uint16_t length)
+uint8_t stmflash_write_nocheck(uint32_t addr, uint32_t *buf, uint16_t length)
 {
-    uint16_t index;
+    uint8_t res;
     
     HAL_FLASH_Unlock();
-    for (index=0; index<length; index++)
-    {
-        HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + (index << 2), buf[index]);
-    }
+    res = stmflash_program(addr, buf, length);
     HAL_FLASH_Lock();
+    
+    return res;
 }
 
 /**
  * @brief   writes a specified word of data to a specified address
+ * @note    Each page is compared with the data first: an identical page is skipped, the changed
+ *          half-words are programmed in place when no erase is needed, otherwise the page is erased
+ *          and only its non 0xFFFF half-words are programmed. The flash is unlocked once for all the pages.
+ *          Each programmed half-word is read back, the other pages are still written after an error.
  * @param   addr   : Specifies the address to write the data to
  * @param   buf    : The start address of the store to write data to
  * @param   length : This specifies the length of the data to be written in words
- * @retval  None
+ * @retval  0, OK; 1, address out of the flash, erase error or a half-word does not read back
  */
-static uint32_t g_flash_buf[FLASH_PAGE_SIZE / sizeof(uint32_t)];
-
-void stmflash_write(uint32_t addr, uint32_t *buf, uint16_t length)
+uint8_t stmflash_write(uint32_t addr, uint32_t *buf, uint16_t length)
 {
     uint32_t offaddr;
+    uint32_t pageaddr;
     uint16_t pagepos;
     uint16_t pageoff;
     uint16_t pageremain;
     uint16_t data_index;
-    FLASH_EraseInitTypeDef flash_erase_init_struct = {0};
-    uint32_t pageerr;
+    uint8_t res = 0;
     
     /* Check the validity of writing to the address range */
     if ((!IS_FLASH_PROGRAM_ADDRESS(addr)) || (!IS_FLASH_PROGRAM_ADDRESS(addr + (length * sizeof(uint32_t)) - 1)))
     {
-        return;
+        return 1;
     }
     
     offaddr = addr - FLASH_BASE;
@@ -101,37 +207,32 @@ void stmflash_write(uint32_t addr, uint32_t *buf, uint16_t length)
         pageremain = length;
     }
     
+    HAL_FLASH_Unlock();
+    
     while (1)
     {
-        stmflash_read(FLASH_BASE + pagepos * FLASH_PAGE_SIZE, g_flash_buf, sizeof(g_flash_buf) / sizeof(uint32_t));
-        for (data_index=0; data_index<pageremain; data_index++)
+        pageaddr = FLASH_BASE + pagepos * FLASH_PAGE_SIZE;
+        
+        switch (stmflash_check(addr, buf, pageremain))
         {
-            /* Determine if erasure is required */
-            if (g_flash_buf[data_index + pageoff] != 0xFFFFFFFF)
-            {
+            case STMFLASH_SAME:
+                g_stmflash_cnt.skip++;
                 break;
-            }
-        }
-        if (data_index < pageremain)
-        {
-            /* Erasing pages */
-            flash_erase_init_struct.TypeErase = FLASH_TYPEERASE_PAGES;
-            flash_erase_init_struct.Banks = FLASH_BANK_1;
-            flash_erase_init_struct.PageAddress = FLASH_BASE + pagepos * FLASH_PAGE_SIZE;
-            flash_erase_init_struct.NbPages = 1;
-            HAL_FLASH_Unlock();
-            HAL_FLASHEx_Erase(&flash_erase_init_struct, &pageerr);
-            HAL_FLASH_Lock();
             
-            for (data_index=0; data_index<pageremain; data_index++)
-            {
-                g_flash_buf[pageoff + data_index] = buf[data_index];
-            }
-            stmflash_write_nocheck(FLASH_BASE + pagepos * FLASH_PAGE_SIZE, g_flash_buf, sizeof(g_flash_buf) / sizeof(uint32_t));
-        }
-        else
-        {
-            stmflash_write_nocheck(addr, buf, pageremain);
+            case STMFLASH_PROGRAM:
+                res |= stmflash_program(addr, buf, pageremain);
+                break;
+            
+            default:
+                /* Keep the rest of the page, erase it and program the merged content */
+                stmflash_read(pageaddr, g_flash_buf, sizeof(g_flash_buf) / sizeof(uint32_t));
+                for (data_index=0; data_index<pageremain; data_index++)
+                {
+                    g_flash_buf[pageoff + data_index] = buf[data_index];
+                }
+                res |= stmflash_erase_page(pageaddr);
+                res |= stmflash_program(pageaddr, g_flash_buf, sizeof(g_flash_buf) / sizeof(uint32_t));
+                break;
         }
         
         /* Determines whether the write is complete */
@@ -157,6 +258,10 @@ void stmflash_write(uint32_t addr, uint32_t *buf, uint16_t length)
             }
         }
     }
+    
+    HAL_FLASH_Lock();
+    
+    return res;
 }
 /* Test code */
 
@@ -33,14 +33,14 @@ extern "C" {
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart1;
+extern DMA_HandleTypeDef hdma_usart1_rx;
 
 /* USER CODE BEGIN Private defines */
-#define USART_REC_LEN				50 * 1024	/* The maximum number of bytes received is defined as 200 */
-#define RXBUFFERSIZE   				1        	/* cache size */
+#define USART_REC_LEN				(4 * 1024)	/* Size of the DMA receive ring buffer, it must hold the data received during a flash page erase and program */
 
-extern uint8_t  g_usart_rx_buf[USART_REC_LEN];  /* Receive buffer, maximum USART_REC_LEN bytes. The last byte is a newline character */
-extern uint16_t g_usart_rx_sta;                 /* Receiving status marking */
-extern uint8_t g_rx_buffer[RXBUFFERSIZE];       /* The HAL library USART receives buffers */
+extern uint8_t  g_usart_rx_buf[USART_REC_LEN];  /* Receive ring buffer, written by circular DMA, read by iap_stream_poll */
+extern volatile uint32_t g_usart_rx_laps;       /* Times the DMA wrapped around g_usart_rx_buf */
+extern volatile uint8_t g_usart_rx_restart;     /* 1: the reception was restarted at index 0 after an error */
 /* USER CODE END Private defines */
 
 void MX_USART1_UART_Init(void);
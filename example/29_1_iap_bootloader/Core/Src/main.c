@@ -21,7 +21,7 @@
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
-#include "tim.h"
+#include "dma.h"
 #include "usart.h"
 #include "gpio.h"
 #include "fsmc.h"
@@ -33,7 +33,7 @@
 #include "../../BSP/LCD/lcd.h"
 #include "../../BSP/STMFLASH/stmflash.h"
 #include "../../ATK_Middlewares/IAP/iap.h"
-#include "../../ATK_Middlewares/USMART/usmart.h"
+#include "../../ATK_Middlewares/IAP/iap_stream.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -55,8 +55,6 @@
 
 /* USER CODE BEGIN PV */
 
-extern uint32_t g_usart_rx_cnt;
-
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -64,7 +62,6 @@ void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
 
 extern void iap_load_app(uint32_t appxaddr);
-extern void iap_write_appbin(uint32_t appxaddr,uint8_t *appbuf,uint32_t applen);
 
 /* USER CODE END PFP */
 
@@ -83,8 +80,8 @@ int main(void)
 
 	uint8_t t = 0;
 	uint8_t key;
-	uint32_t lastcount = 0;
-	uint32_t applenth = 0;
+	uint8_t sta;
+	uint8_t busy = 0;
 	uint8_t clearflag = 0;
 
   /* USER CODE END 1 */
@@ -107,9 +104,9 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_FSMC_Init();
-  MX_TIM4_Init();
   /* USER CODE BEGIN 2 */
 
   lcd_init();
@@ -118,9 +115,11 @@ int main(void)
   lcd_show_string(30, 70, 200, 16, 16, "IAP TEST", RED);
   lcd_show_string(30, 90, 200, 16, 16, "ATOM@ALIENTEK", RED);
 
-  lcd_show_string(30, 90, 200, 16, 16, "WKUP: Copy app 2 flash", RED);
+  lcd_show_string(30, 90, 200, 16, 16, "Send app: iap_send.py", RED);
   lcd_show_string(30, 110, 200, 16, 16, "KEY0: Run flash app", RED);
 
+  iap_stream_init();
+
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -128,53 +127,32 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  if (g_usart_rx_cnt != 0)
+	  sta = iap_stream_poll();      /* Pages are programmed as soon as they are received */
+
+	  if (sta == IAP_STREAM_BUSY && busy == 0)
 	  {
-	     /* If no new data is received in the new loop, the data is considered to be received */
-	     if (lastcount == g_usart_rx_cnt)
-	     {
-	         applenth = g_usart_rx_cnt;
-	         lastcount = 0;
-	         g_usart_rx_cnt = 0;
-	         printf("User program reception complete!\r\n");
-	         printf("code length:%dBytes\r\n", applenth);
-	     }
-	     else
-	     {
-	         lastcount = g_usart_rx_cnt;
-	     }
+	      busy = 1;
+	      lcd_show_string(30, 130, 200, 16, 16, "Updating app...       ", BLUE);
+	      clearflag = 0;
+	  }
+	  else if (sta == IAP_STREAM_DONE)
+	  {
+	      busy = 0;
+	      lcd_show_string(30, 130, 200, 16, 16, "Update app succedded! ", BLUE);
+	      clearflag = 7;
 	  }
 
 	  key = key_scan(0);
-	  if (key == WKUP_PRES)
+	  if (key == KEY0_PRES)
 	  {
-	      if (applenth != 0)
+	      sta = iap_stream_check(FLASH_APP1_ADDR);   /* Verify the image written by the streaming update */
+
+	      if (sta == 2)
 	      {
-	          printf("Start updating firmware...\r\n");
-	          lcd_show_string(30, 130, 200, 16, 16, "Copying app 2 flash...", BLUE);
-	          if (((*(volatile uint32_t *)(0x20002000 + 4)) & 0xFF000000) == 0x08000000)
-	          {
-	              iap_write_appbin(FLASH_APP1_ADDR, g_usart_rx_buf, applenth);
-	              lcd_show_string(30, 130, 200, 16, 16, "Copy app succedded!   ", BLUE);
-	              printf("Firmware update complete!\r\n");
-	          }
-	          else
-	          {
-	              lcd_show_string(30, 130, 200, 16, 16, "Illegal flash app!    ", BLUE);
-	              printf("Non-flash apps!\r\n");
-	          }
-	       }
-	       else
-	       {
-	           printf("No firmware to update!\r\n");
-	           lcd_show_string(30, 130, 200, 16, 16, "No app!", BLUE);
-	       }
-	       clearflag = 7;
-	  }
-	  else if (key == KEY0_PRES)
-	  {
-	      printf("flash addr :%x \r\n",(*(volatile uint32_t *)(FLASH_APP1_ADDR + 4)) & 0xFF000000);
-	      if (((*(volatile uint32_t *)(FLASH_APP1_ADDR + 4)) & 0xFF000000) == 0x08000000)
+	          printf("Incomplete or corrupted firmware!\r\n");
+	          lcd_show_string(30, 130, 200, 16, 16, "Bad APP!", BLUE);
+	      }
+	      else if (((*(volatile uint32_t *)(FLASH_APP1_ADDR + 4)) & 0xFF000000) == 0x08000000)
 	      {
 	          printf("Start executing FLASH user code!!\r\n\r\n");
 	          HAL_Delay(10);
@@ -188,7 +166,7 @@ int main(void)
 	      clearflag = 7;
 	  }
 
-	  if (++t == 2)
+	  if (++t == 20)
 	  {
 	      t = 0;
 
@@ -204,7 +182,7 @@ int main(void)
 	      LED0_TOGGLE(); /* flashing LED0 indicates that the system is running */
 	  }
 
-	  HAL_Delay(100);
+	  HAL_Delay(10);
     /* USER CODE BEGIN 3 */
   }
   /* USER CODE END 3 */
@@ -35,20 +35,14 @@ PUTCHAR_PROTOTYPE
 	return ch;
 }
 
-/* Receive buffer, maximum USART REC LEN bytes */
-uint8_t g_usart_rx_buf[USART_REC_LEN] __attribute__((section(".app_addr")));
-
-/* Receive status
- * bit15, receive complete flag
- * bit14, 0x0d received
- * bit13-0, the number of valid bytes received
- */
-uint16_t g_usart_rx_sta = 0;
-uint8_t g_rx_buffer[RXBUFFERSIZE];  /* the serial port used by the HAL library receives buffers */
-uint32_t g_usart_rx_cnt = 0;        /* Number of bytes received */
+/* Receive buffer, maximum USART REC LEN bytes, it is written by DMA as a ring buffer */
+uint8_t g_usart_rx_buf[USART_REC_LEN];
+volatile uint32_t g_usart_rx_laps = 0;     /* Times the DMA wrapped around g_usart_rx_buf, the reader detects being lapped */
+volatile uint8_t g_usart_rx_restart = 0;    /* Set when the DMA restarts at index 0, the reader resynchronizes */
 /* USER CODE END 0 */
 
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx;
 
 /* USART1 init function */
 
@@ -76,9 +70,9 @@ void MX_USART1_UART_Init(void)
   }
   /* USER CODE BEGIN USART1_Init 2 */
 
-  /* This function enables the receive interrupt: flag UART_IT_RXNE and sets
-   * the receive buffer and the maximum amount of data the receive buffer can receive */
-  HAL_UART_Receive_IT(&huart1, (uint8_t *)g_rx_buffer, RXBUFFERSIZE);
+  /* Receive into g_usart_rx_buf by circular DMA, so that no byte is lost while the CPU
+   * is stalled by a flash erase/program (see iap_stream.c) */
+  HAL_UART_Receive_DMA(&huart1, g_usart_rx_buf, USART_REC_LEN);
 
   /* USER CODE END USART1_Init 2 */
 
@@ -111,6 +105,23 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+    /* USART1 DMA Init */
+    /* USART1_RX Init */
+    hdma_usart1_rx.Instance = DMA1_Channel5;
+    hdma_usart1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_usart1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart1_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.Mode = DMA_CIRCULAR;
+    hdma_usart1_rx.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(uartHandle,hdmarx,hdma_usart1_rx);
+
     /* USART1 interrupt Init */
     HAL_NVIC_SetPriority(USART1_IRQn, 2, 2);
     HAL_NVIC_EnableIRQ(USART1_IRQn);
@@ -137,6 +148,9 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
     */
     HAL_GPIO_DeInit(GPIOA, GPIO_PIN_9|GPIO_PIN_10);
 
+    /* USART1 DMA DeInit */
+    HAL_DMA_DeInit(uartHandle->hdmarx);
+
     /* USART1 interrupt Deinit */
     HAL_NVIC_DisableIRQ(USART1_IRQn);
   /* USER CODE BEGIN USART1_MspDeInit 1 */
@@ -148,21 +162,33 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 /* USER CODE BEGIN 1 */
 
 /**
-  * @brief  Rx Transfer completed callback.
+  * @brief  Rx transfer completed callback: in circular mode, the DMA wrapped around the ring buffer.
   * @param  huart UART handle.
   * @retval None
   */
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
-    if (huart->Instance == USART1)       /* If it is serial port 1 */
+    if (huart->Instance == USART1)
     {
-    	if (g_usart_rx_cnt < USART_REC_LEN)
-		{
-			g_usart_rx_buf[g_usart_rx_cnt] = g_rx_buffer[0];
-			g_usart_rx_cnt++;
-		}
+        g_usart_rx_laps++;
+    }
+}
 
-        HAL_UART_Receive_IT(&huart1, (uint8_t *)g_rx_buffer, RXBUFFERSIZE);
+/**
+  * @brief  UART error callback.
+  * @note   The HAL aborts the DMA reception on a receive error (overrun, noise, framing),
+  *         restart it so that the ring buffer keeps being filled. It restarts at index 0,
+  *         g_usart_rx_restart tells the reader (iap_stream_poll) to resynchronize.
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1)       /* If it is serial port 1 */
+    {
+        HAL_UART_Receive_DMA(&huart1, g_usart_rx_buf, USART_REC_LEN);
+        g_usart_rx_laps = 0;
+        g_usart_rx_restart = 1;
     }
 }
 
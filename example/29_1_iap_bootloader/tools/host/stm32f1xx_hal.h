@@ -0,0 +1,67 @@
+/**
+ * Host build of the bootloader (tools/iap_sim.c): stands in for the HAL included by Core/Inc/main.h.
+ * Only what iap_stream.c, iap_delta.c and stmflash.c use, with the STM32F103ZE flash layout.
+ * The flash functions and the USART1 DMA channel are simulated in iap_sim.c.
+ */
+
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY                   0xFFFFFFFFU
+
+/* Flash, 256 pages of 2KB */
+#define FLASH_BASE                      0x08000000UL
+#define FLASH_BANK1_END                 0x0807FFFFUL
+#define FLASH_PAGE_SIZE                 0x800U
+#define IS_FLASH_PROGRAM_ADDRESS(addr)  (((addr) >= FLASH_BASE) && ((addr) <= FLASH_BANK1_END))
+
+#define FLASH_TYPEERASE_PAGES           0x00U
+#define FLASH_BANK_1                    0x01U
+#define FLASH_TYPEPROGRAM_HALFWORD      0x01U
+
+typedef struct
+{
+    uint32_t TypeErase;
+    uint32_t Banks;
+    uint32_t PageAddress;
+    uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
+
+/* USART1 and its receive DMA channel */
+typedef struct
+{
+    volatile uint32_t CNDTR;                /* Transfers left before the circular buffer wraps */
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    DMA_Channel_TypeDef *Instance;
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} UART_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)   ((__HANDLE__)->Instance->CNDTR)
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+uint32_t HAL_GetTick(void);
+
+#endif
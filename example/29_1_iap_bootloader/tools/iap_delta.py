@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+iap_delta.py - make a delta patch for the 29_1_iap_bootloader delta update
+
+Usage: python iap_delta.py old.bin new.bin patch.bin
+
+old.bin is the application installed on the board, new.bin the one to install.
+The patch format is described in ATK_Middlewares/IAP/iap_delta.h. Only the 2KB pages
+that change are listed, each one as copies from old.bin and literal bytes. A copy can
+not read a page that the bootloader has already rewritten, so the pages are processed
+in ascending or descending order, whichever gives the smaller patch.
+Before the patch is written, it is applied to a simulated flash (apply_patch, the same
+rules as iap_delta.c, including an update interrupted after each page) and checked.
+Send it with: python iap_send.py COM3 patch.bin --delta
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+PAGE = 2048             # FLASH_PAGE_SIZE
+MAGIC = 0x44504149      # IAP_DELTA_MAGIC
+OP_COPY = 0x01
+OP_ADD = 0x02
+KEY = 8                 # bytes used to find the candidate copies
+MIN_COPY = 12           # a shorter match costs more than the literal bytes
+MAX_CAND = 32           # candidates kept for each key
+
+
+def crc32(data):
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def npages(size):
+    return (size + PAGE - 1) // PAGE
+
+
+def build_index(old):
+    index = {}
+    for i in range(len(old) - KEY + 1):
+        lst = index.setdefault(old[i:i + KEY], [])
+        if len(lst) < MAX_CAND:
+            lst.append(i)
+    return index
+
+
+def match_len(old, new, src, dst, limit):
+    n = 0
+    while n < limit:
+        step = min(64, limit - n)
+        if old[src + n:src + n + step] == new[dst + n:dst + n + step]:
+            n += step
+            continue
+        while n < limit and old[src + n] == new[dst + n]:
+            n += 1
+        break
+    return n
+
+
+def page_ops(old, new, index, page, done):
+    """Ops that build a page of new.bin, the pages in done can not be read"""
+    base = page * PAGE
+    plen = min(PAGE, len(new) - base)
+    ops = []
+    lit = bytearray()
+    i = 0
+    while i < plen:
+        dst = base + i
+        best, best_src = 0, 0
+        cands = index.get(new[dst:dst + KEY], []) if plen - i >= KEY else []
+        for src in [dst] + cands:   # the same offset first, most code does not move
+            if src >= len(old) or (src // PAGE != page and src // PAGE in done):
+                continue
+            limit = min(plen - i, len(old) - src)
+            end = src // PAGE + 1   # stop at the first page that was already rewritten
+            while end * PAGE < src + limit and (end == page or end not in done):
+                end += 1
+            limit = min(limit, end * PAGE - src)
+            n = match_len(old, new, src, dst, limit)
+            if n > best:
+                best, best_src = n, src
+        if best >= MIN_COPY:
+            if lit:
+                ops.append(struct.pack("<BH", OP_ADD, len(lit)) + bytes(lit))
+                lit = bytearray()
+            ops.append(struct.pack("<BIH", OP_COPY, best_src, best))
+            i += best
+        else:
+            lit.append(new[dst])
+            i += 1
+    if lit:
+        ops.append(struct.pack("<BH", OP_ADD, len(lit)) + bytes(lit))
+    return struct.pack("<HH", page, len(ops)) + b"".join(ops)
+
+
+def make_patch(old, new):
+    index = build_index(old)
+    changed = [p for p in range(npages(len(new)))
+               if new[p * PAGE:(p + 1) * PAGE] != old[p * PAGE:p * PAGE + len(new[p * PAGE:(p + 1) * PAGE])]]
+    head = struct.pack("<IIIII", MAGIC, len(old), crc32(old), len(new), crc32(new))
+    best = None
+    for order in (changed, changed[::-1]):
+        done = set()
+        recs = []
+        for p in order:
+            recs.append(page_ops(old, new, index, p, done))
+            done.add(p)
+        patch = head + b"".join(recs)
+        if best is None or len(patch) < len(best):
+            best = patch
+    return best
+
+
+def apply_patch(flash, patch, done, stop=None):
+    """Apply a patch like iap_delta.c does. flash is the simulated application area (bytearray),
+    done the set of rewritten pages (the page flags of the update record), it is kept across
+    calls to simulate a resumed update. stop interrupts the update after that many pages.
+    Returns the number of pages erased."""
+    magic, old_size, old_crc, new_size, new_crc = struct.unpack_from("<IIIII", patch, 0)
+    assert magic == MAGIC
+    if not done:
+        assert crc32(bytes(flash[:old_size])) == old_crc, "not the patch base"
+    erases = 0
+    pos = 20
+    while pos < len(patch):
+        page, nops = struct.unpack_from("<HH", patch, pos)
+        pos += 4
+        plen = min(PAGE, new_size - page * PAGE)
+        buf = bytearray()
+        for _ in range(nops):
+            if patch[pos] == OP_COPY:
+                src, n = struct.unpack_from("<IH", patch, pos + 1)
+                pos += 7
+                if page not in done:
+                    for q in range(src // PAGE, (src + n - 1) // PAGE + 1):
+                        assert q == page or q not in done, "copy from a rewritten page"
+                    assert src + n <= old_size
+                buf += flash[src:src + n]
+            else:
+                n = struct.unpack_from("<H", patch, pos + 1)[0]
+                buf += patch[pos + 3:pos + 3 + n]
+                pos += 3 + n
+        assert len(buf) == plen
+        if page in done:
+            continue
+        if flash[page * PAGE:page * PAGE + plen] != buf:
+            flash[page * PAGE:page * PAGE + plen] = buf
+            erases += 1
+        done.add(page)
+        if stop is not None and len(done) >= stop:
+            break
+    return erases
+
+
+def check_patch(old, new, patch):
+    """Apply the patch in one go, then interrupted after each page and resumed"""
+    blank = old + b"\xFF" * (max(len(old), len(new)) - len(old))
+    flash = bytearray(blank)
+    done = set()
+    erases = apply_patch(flash, patch, done)
+    if flash[:len(new)] != new:
+        sys.exit("internal error: the patch does not rebuild new.bin")
+
+    for stop in range(1, len(done)):
+        flash = bytearray(blank)
+        resumed = set()
+        apply_patch(flash, patch, resumed, stop)
+        apply_patch(flash, patch, resumed)
+        if flash[:len(new)] != new:
+            sys.exit("internal error: the patch does not resume after %d pages" % stop)
+    return erases
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("old")
+    ap.add_argument("new")
+    ap.add_argument("patch")
+    args = ap.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    patch = make_patch(old, new)
+    erases = check_patch(old, new, patch)
+    with open(args.patch, "wb") as f:
+        f.write(patch)
+    print("%d -> %d bytes, patch %d bytes (%.1f%%), %d of %d pages rewritten"
+          % (len(old), len(new), len(patch), 100.0 * len(patch) / max(len(new), 1), erases, npages(len(new))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+iap_send.py - send an application bin to the 29_1_iap_bootloader streaming update
+
+Usage: python iap_send.py COM3 app.bin [--baud 115200] [--delta]
+
+The frame format is described in ATK_Middlewares/IAP/iap_stream.h. Up to WINDOW data
+frames are sent ahead of the acknowledgements, so the bootloader programs a page while
+the next one is still on the line. An interrupted update is resumed by running the same
+command again: the bootloader answers START with the offset to continue from.
+With --delta the file is a patch made by iap_delta.py, it is always sent from the
+beginning and the bootloader skips the pages it has already rewritten.
+Requires pyserial (pip install pyserial).
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+SOF = b"\xA5\x5A"
+CMD_START = 0x01
+CMD_DATA = 0x02
+CMD_END = 0x03
+CMD_DELTA = 0x04
+CMD_ACK = 0x80
+
+DATA_MAX = 1024     # IAP_DATA_MAX
+WINDOW = 2          # the bootloader ring buffer holds 2 frames during a page erase/program
+
+STATUS = {
+    0: "ok", 1: "frame crc error", 2: "unexpected offset", 3: "size error",
+    4: "flash error", 5: "image crc mismatch", 6: "not started", 7: "unknown command",
+    8: "the installed app is not the patch base, send the full image", 9: "malformed patch",
+}
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def frame(cmd, seq, payload=b""):
+    body = struct.pack("<BBH", cmd, seq, len(payload)) + payload
+    return SOF + body + struct.pack("<H", crc16(body))
+
+
+class Link:
+    def __init__(self, port, baud):
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+        self.rx = bytearray()
+        self.seq = 0
+
+    def send(self, cmd, payload=b""):
+        self.seq = (self.seq + 1) & 0xFF
+        self.ser.write(frame(cmd, self.seq, payload))
+        return self.seq
+
+    def recv_ack(self, timeout):
+        """Return (cmd, seq, status, offset) or None on timeout. Other output (printf) is skipped."""
+        end = time.time() + timeout
+        while time.time() < end:
+            self.rx += self.ser.read(64)
+            while True:
+                i = self.rx.find(SOF)
+                if i < 0:
+                    del self.rx[:-1]
+                    break
+                del self.rx[:i]
+                if len(self.rx) < 13:
+                    break
+                body = bytes(self.rx[2:11])
+                crc = struct.unpack("<H", self.rx[11:13])[0]
+                if body[2:4] != b"\x05\x00" or crc16(body) != crc:
+                    del self.rx[:1]     # not an answer frame, search the next SOF
+                    continue
+                del self.rx[:13]
+                cmd, seq, _, status, offset = struct.unpack("<BBHBI", body)
+                return cmd & ~CMD_ACK, seq, status, offset
+        return None
+
+    def flush(self):
+        time.sleep(0.2)
+        self.ser.reset_input_buffer()
+        self.rx.clear()
+
+
+def request(link, cmd, payload=b"", timeout=3.0, retries=3):
+    for _ in range(retries):
+        seq = link.send(cmd, payload)
+        while True:
+            ack = link.recv_ack(timeout)
+            if ack is None:
+                break
+            if ack[0] == cmd and ack[1] == seq:
+                return ack[2], ack[3]
+    sys.exit("no answer from the bootloader")
+
+
+def send_image(link, image, start=CMD_START):
+    size = len(image)
+    status, offset = request(link, start, struct.pack("<II", size, zlib.crc32(image) & 0xFFFFFFFF), timeout=5.0)
+    if status:
+        sys.exit("START refused: %s" % STATUS.get(status, status))
+    if offset:
+        print("resuming at %d bytes" % offset)
+
+    t0 = time.time()
+    inflight = []       # (seq, offset after the frame)
+    nxt = offset
+    retries = 0
+    while offset < size:
+        while len(inflight) < WINDOW and nxt < size:
+            chunk = image[nxt:nxt + DATA_MAX]
+            seq = link.send(CMD_DATA, struct.pack("<I", nxt) + chunk)
+            nxt += len(chunk)
+            inflight.append((seq, nxt))
+
+        ack = link.recv_ack(2.0)
+        if ack is not None and ack[0] == CMD_DATA and ack[2] == 0 and inflight and ack[1] == inflight[0][0]:
+            offset = inflight.pop(0)[1]
+            retries = 0
+            sys.stdout.write("\r%d / %d bytes" % (offset, size))
+            sys.stdout.flush()
+            continue
+
+        if ack is not None and ack[0] != CMD_DATA:
+            continue
+        retries += 1
+        if retries > 10:
+            sys.exit("\ntoo many errors")
+        if ack is not None:
+            offset = ack[3]     # continue from where the bootloader is
+            print("\n%s, continue at %d" % (STATUS.get(ack[2], ack[2]), offset))
+        link.flush()
+        inflight = []
+        nxt = offset
+
+    status, _ = request(link, CMD_END, timeout=5.0)
+    if status:
+        sys.exit("\nEND refused: %s" % STATUS.get(status, status))
+    dt = time.time() - t0
+    print("\ndone, %d bytes in %.1fs (%.1f KB/s)" % (size, dt, size / 1024 / max(dt, 1e-3)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port")
+    ap.add_argument("bin")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--delta", action="store_true", help="the file is a patch made by iap_delta.py")
+    args = ap.parse_args()
+
+    with open(args.bin, "rb") as f:
+        image = f.read()
+    send_image(Link(args.port, args.baud), image, CMD_DELTA if args.delta else CMD_START)
+
+
+if __name__ == "__main__":
+    main()
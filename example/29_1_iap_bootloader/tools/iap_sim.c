@@ -0,0 +1,542 @@
+/**
+ ****************************************************************************************************
+ * @file        iap_sim.c
+ * @author      ALIENTEK
+ * @brief       The streaming update of the bootloader on a Linux host, with a simulated flash and USART1
+ *
+ *              iap_stream.c, iap_delta.c and stmflash.c run unchanged. The main loop is the one of main.c:
+ *              iap_stream_poll every 10ms. USART1 is a pseudo terminal, tools/iap_send.py sends to it.
+ *
+ *              Flash  : the file FLASH.bin (512KB, created erased) is mapped read only at 0x08000000, so the
+ *                       code reads the flash through pointers as on the board, and a stray write faults.
+ *                       HAL_FLASH_Program follows the STM32F1 rules: the flash must be unlocked, and a half-word
+ *                       that is not erased can only be programmed to 0x0000 (otherwise PGERR, nothing written).
+ *                       Erase and program take their datasheet time (-e, 52us per half-word), the erases of
+ *                       each page are counted. The file keeps the content from one run to the next.
+ *              Power  : -c N cuts the power during the Nth flash operation, -a ADDR when the half-word at ADDR
+ *                       is programmed: a half-word is left partly programmed, or a page partly erased,
+ *                       and the program exits with status 3.
+ *                       Run it again without -c/-a and send the same file: the update resumes.
+ *              USART1 : a thread stands for the circular DMA: the received bytes are written to g_usart_rx_buf
+ *                       at the baud rate (-b), CNDTR counts down, and HAL_UART_RxCpltCallback runs at each wrap.
+ *                       -r N drops every Nth byte with a receive error, HAL_UART_ErrorCallback restarts the DMA
+ *                       at index 0. -l N writes, after N bytes, a burst of noise longer than g_usart_rx_buf
+ *                       that the reader does not see coming: the DMA laps it.
+ *
+ *              Build, from example/29_1_iap_bootloader:
+ *              gcc -O2 -Wall -Itools/host -ICore/Inc -IATK_Middlewares/IAP -Wno-pointer-to-int-cast
+ *                  -Wno-int-to-pointer-cast tools/iap_sim.c ATK_Middlewares/IAP/iap_stream.c
+ *                  ATK_Middlewares/IAP/iap_delta.c BSP/STMFLASH/stmflash.c -lpthread -o iap_sim
+ *              Run (it prints the pseudo terminal to send to):
+ *              ./iap_sim flash.bin -1 &
+ *              python3 tools/iap_send.py /dev/pts/N app.bin
+ *              tools/iap_sim_test.sh builds it and runs the update through power cuts and receive errors.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ *
+ ****************************************************************************************************
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include "usart.h"
+#include "iap_stream.h"
+#include "../../BSP/STMFLASH/stmflash.h"
+
+#define SIM_FLASH_SIZE          (FLASH_BANK1_END + 1 - FLASH_BASE)
+#define SIM_PAGES               (SIM_FLASH_SIZE / FLASH_PAGE_SIZE)
+#define SIM_PROGRAM_NS          52000                       /* Half-word program time (tPROG) */
+
+/* Flash */
+static uint8_t *g_sim_flash;                                /* Writable view of the file */
+static uint8_t g_sim_locked = 1;
+static uint32_t g_sim_erase_ms = 20;                        /* Page erase time (tERASE) */
+static uint32_t g_sim_erase[SIM_PAGES];                     /* Erases of each page in this run */
+static uint32_t g_sim_program;                              /* Half-words programmed */
+static uint32_t g_sim_pgerr;                                /* Programs refused: half-word not erased, or flash locked */
+static uint32_t g_sim_ops;                                  /* Flash operations (erase or half-word program) */
+static uint32_t g_sim_cut;                                  /* Power cut during this operation, 0: none */
+static uint32_t g_sim_cut_addr;                             /* Power cut when this half-word is programmed, 0: none */
+static uint64_t g_sim_busy_ns;                              /* Program time not slept yet */
+
+/* USART1 */
+static int g_sim_pty = -1;
+static uint32_t g_sim_baud = 115200;
+static uint32_t g_sim_rxerr;                                /* A receive error every g_sim_rxerr bytes, 0: none */
+static uint32_t g_sim_lap;                                  /* Noise burst after g_sim_lap bytes, 0: none */
+static uint32_t g_sim_rxcnt;                                /* Bytes received */
+static uint32_t g_sim_rxerrs;                               /* Receive errors injected */
+static uint32_t g_sim_wpos;                                 /* DMA write position in g_usart_rx_buf */
+static DMA_Channel_TypeDef g_sim_dma_ch = {USART_REC_LEN};
+
+/* The variables of Core/Src/usart.c */
+uint8_t g_usart_rx_buf[USART_REC_LEN];
+volatile uint32_t g_usart_rx_laps = 0;
+volatile uint8_t g_usart_rx_restart = 0;
+UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx = {&g_sim_dma_ch};
+
+static uint32_t g_sim_errors;                               /* iap_stream_poll returned IAP_STREAM_ERROR */
+
+/**
+ * @brief   Sleeps
+ * @param   ns : time in ns
+ * @retval  None
+ */
+static void sim_sleep_ns(uint64_t ns)
+{
+    struct timespec ts = {ns / 1000000000, ns % 1000000000};
+
+    while (nanosleep(&ts, &ts) && errno == EINTR);
+}
+
+/**
+ * @brief   Monotonic time
+ * @param   None
+ * @retval  time in ns
+ */
+static uint64_t sim_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(sim_ns() / 1000000);
+}
+
+/**
+ * @brief   Prints the flash and link counters of this run
+ * @param   None
+ * @retval  None
+ */
+static void sim_report(void)
+{
+    uint32_t app = 0, app_pages = 0, app_max = 0;
+    uint32_t i;
+
+    for (i = (FLASH_APP1_ADDR - FLASH_BASE) / FLASH_PAGE_SIZE; i < (IAP_JRNL_ADDR - FLASH_BASE) / FLASH_PAGE_SIZE; i++)
+    {
+        app += g_sim_erase[i];
+        app_pages += (g_sim_erase[i] != 0);
+
+        if (g_sim_erase[i] > app_max)app_max = g_sim_erase[i];
+    }
+
+    fprintf(stderr, "erase : app %u (%u pages, at most %u per page), journal %u, info %u\n",
+            app, app_pages, app_max,
+            g_sim_erase[(IAP_JRNL_ADDR - FLASH_BASE) / FLASH_PAGE_SIZE], g_sim_erase[(IAP_INFO_ADDR - FLASH_BASE) / FLASH_PAGE_SIZE]);
+    fprintf(stderr, "program: %u half-words, %u refused\n", g_sim_program, g_sim_pgerr);
+    fprintf(stderr, "usart : %u bytes, %u receive errors injected, %u frames refused or lapped\n",
+            g_sim_rxcnt, g_sim_rxerrs, g_sim_errors);
+}
+
+/**
+ * @brief   Counts a flash operation, the power is cut during operation g_sim_cut
+ * @param   None
+ * @retval  1, the power is cut now
+ */
+static uint8_t sim_power_fails(void)
+{
+    return (++g_sim_ops == g_sim_cut);
+}
+
+/**
+ * @brief   A half-word partly programmed: some of the bits to clear are cleared, not all when there are several
+ * @param   old  : content
+ * @param   data : value being programmed
+ * @retval  content after the power cut
+ */
+static uint16_t sim_torn(uint16_t old, uint16_t data)
+{
+    uint16_t clear = old & ~data;                           /* Bits the program clears */
+    uint16_t part;
+
+    if ((clear & (clear - 1)) == 0)return old;              /* One bit or none: it was not reached */
+
+    do
+    {
+        part = clear & (uint16_t)rand();
+    } while (part == 0 || part == clear);
+
+    return old & ~part;
+}
+
+/**
+ * @brief   Power cut: the flash keeps what was written so far
+ * @param   what : interrupted operation
+ * @param   addr : its address
+ * @retval  None
+ */
+static void sim_power_cut(const char *what, uint32_t addr)
+{
+    fprintf(stderr, "power cut during flash operation %u (%s 0x%08X)\n", g_sim_ops, what, addr);
+    sim_report();
+    _exit(3);
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    g_sim_locked = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    g_sim_locked = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    uint16_t *hw = (uint16_t *)(g_sim_flash + (Address - FLASH_BASE));
+    uint16_t data = (uint16_t)Data;
+
+    if (TypeProgram != FLASH_TYPEPROGRAM_HALFWORD || (Address & 1) || !IS_FLASH_PROGRAM_ADDRESS(Address))
+    {
+        fprintf(stderr, "HAL_FLASH_Program: bad call 0x%08X\n", Address);
+        abort();
+    }
+
+    if (g_sim_locked || (*hw != 0xFFFF && data != 0x0000))
+    {
+        g_sim_pgerr++;      /* WRPRTERR or PGERR, the half-word is not written */
+        return HAL_ERROR;
+    }
+
+    g_sim_busy_ns += SIM_PROGRAM_NS;
+
+    if (g_sim_busy_ns >= 1000000)
+    {
+        sim_sleep_ns(g_sim_busy_ns);
+        g_sim_busy_ns = 0;
+    }
+
+    if (sim_power_fails() || Address == g_sim_cut_addr)
+    {
+        *hw = sim_torn(*hw, data);
+        sim_power_cut("program", Address);
+    }
+
+    *hw &= data;
+    g_sim_program++;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+    uint32_t addr = pEraseInit->PageAddress;
+    uint32_t i;
+
+    *PageError = 0xFFFFFFFF;
+
+    if (g_sim_locked)return HAL_ERROR;
+
+    for (i = 0; i < pEraseInit->NbPages; i++, addr += FLASH_PAGE_SIZE)
+    {
+        if ((addr & (FLASH_PAGE_SIZE - 1)) || !IS_FLASH_PROGRAM_ADDRESS(addr))
+        {
+            fprintf(stderr, "HAL_FLASHEx_Erase: bad page 0x%08X\n", addr);
+            abort();
+        }
+
+        sim_sleep_ns((uint64_t)g_sim_erase_ms * 1000000);
+
+        if (sim_power_fails())
+        {
+            memset(g_sim_flash + (addr - FLASH_BASE), 0xFF, rand() % FLASH_PAGE_SIZE);   /* Partly erased */
+            sim_power_cut("erase", addr);
+        }
+
+        memset(g_sim_flash + (addr - FLASH_BASE), 0xFF, FLASH_PAGE_SIZE);
+        g_sim_erase[(addr - FLASH_BASE) / FLASH_PAGE_SIZE]++;
+    }
+
+    return HAL_OK;
+}
+
+/**
+ * @brief   Maps the flash file at FLASH_BASE (read only) and a writable view of it
+ * @param   path : flash file, created erased if it does not exist
+ * @retval  0, OK; 1, error
+ */
+static uint8_t sim_flash_open(const char *path)
+{
+    struct stat st;
+    void *ro;
+    int fd;
+
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0 || fstat(fd, &st))return 1;
+
+    if (st.st_size != SIM_FLASH_SIZE)
+    {
+        static uint8_t erased[FLASH_PAGE_SIZE];
+        uint32_t i;
+
+        memset(erased, 0xFF, sizeof(erased));
+
+        if (ftruncate(fd, 0))return 1;
+
+        for (i = 0; i < SIM_PAGES; i++)
+        {
+            if (write(fd, erased, sizeof(erased)) != sizeof(erased))return 1;
+        }
+    }
+
+    ro = mmap((void *)FLASH_BASE, SIM_FLASH_SIZE, PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+    g_sim_flash = mmap(NULL, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (ro != (void *)FLASH_BASE || g_sim_flash == MAP_FAILED)return 1;
+
+    return 0;
+}
+
+/******************************************************************************************/
+/* USART1 */
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)huart;
+    (void)Timeout;
+
+    while (Size)
+    {
+        ssize_t n = write(g_sim_pty, pData, Size);
+
+        if (n <= 0)return HAL_ERROR;
+
+        pData += n;
+        Size -= n;
+    }
+
+    return HAL_OK;
+}
+
+/**
+ * @brief   The DMA stores a received byte
+ * @note    CNDTR reloads at the wrap, HAL_UART_RxCpltCallback (g_usart_rx_laps++) runs after it
+ * @param   ch : received byte
+ * @retval  None
+ */
+static void sim_dma_byte(uint8_t ch)
+{
+    g_usart_rx_buf[g_sim_wpos] = ch;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (++g_sim_wpos == USART_REC_LEN)
+    {
+        g_sim_wpos = 0;
+        g_sim_dma_ch.CNDTR = USART_REC_LEN;
+        g_usart_rx_laps++;
+    }
+    else
+    {
+        g_sim_dma_ch.CNDTR = USART_REC_LEN - g_sim_wpos;
+    }
+}
+
+/**
+ * @brief   Receive error: HAL_UART_ErrorCallback restarts the DMA at index 0
+ * @note    It is an interrupt on the board, the main loop never sees half of it. Here it runs
+ *          beside the main loop, so the flag is raised first: a poll that sees the restarted
+ *          DMA also sees the flag.
+ * @param   None
+ * @retval  None
+ */
+static void sim_rx_error(void)
+{
+    g_usart_rx_restart = 1;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    g_usart_rx_laps = 0;
+    g_sim_wpos = 0;
+    g_sim_dma_ch.CNDTR = USART_REC_LEN;
+    g_sim_rxerrs++;
+}
+
+/**
+ * @brief   Receive thread: the bytes of the pseudo terminal at the baud rate
+ * @param   arg : not used
+ * @retval  None
+ */
+static void *sim_rx_thread(void *arg)
+{
+    uint64_t byte_ns = 10000000000ULL / g_sim_baud;         /* 10 bits per byte */
+    uint64_t next = 0, now;
+    uint8_t buf[16];
+    ssize_t n, i;
+    uint32_t j;
+
+    (void)arg;
+
+    while ((n = read(g_sim_pty, buf, sizeof(buf))) > 0)
+    {
+        now = sim_ns();
+
+        if (next < now)next = now;
+
+        next += n * byte_ns;
+
+        if (next > now)sim_sleep_ns(next - now);
+
+        for (i = 0; i < n; i++)
+        {
+            g_sim_rxcnt++;
+
+            if (g_sim_rxerr && g_sim_rxcnt % g_sim_rxerr == 0)
+            {
+                sim_rx_error();                             /* The byte is lost */
+                continue;
+            }
+
+            sim_dma_byte(buf[i]);
+
+            if (g_sim_rxcnt == g_sim_lap)
+            {
+                for (j = 0; j < USART_REC_LEN + 64; j++)sim_dma_byte(0x00);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Opens the pseudo terminal standing for USART1
+ * @param   None
+ * @retval  0, OK; 1, error
+ */
+static uint8_t sim_pty_open(void)
+{
+    struct termios tio;
+
+    g_sim_pty = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (g_sim_pty < 0 || grantpt(g_sim_pty) || unlockpt(g_sim_pty))return 1;
+
+    if (tcgetattr(g_sim_pty, &tio))return 1;
+
+    cfmakeraw(&tio);
+    tcsetattr(g_sim_pty, TCSANOW, &tio);
+
+    /* Keep the slave open, the master would read EIO each time the sender closes it */
+    if (open(ptsname(g_sim_pty), O_RDWR | O_NOCTTY) < 0)return 1;
+
+    return 0;
+}
+
+static void sim_signal(int sig)
+{
+    (void)sig;
+    sim_report();
+    _exit(1);
+}
+
+static void sim_usage(void)
+{
+    fprintf(stderr, "usage: iap_sim FLASH.bin [-1] [-b baud] [-e erase_ms] [-c flash_op] [-a addr] [-r n] [-l n] [-s seed]\n"
+                    "  -1  exit after the first update: 0 if iap_stream_check accepts the image, 2 otherwise\n"
+                    "  -c  cut the power during this flash operation (erase or half-word program)\n"
+                    "  -a  cut the power when the half-word at this address is programmed\n"
+                    "  -r  a receive error every n bytes\n"
+                    "  -l  after n bytes, a noise burst that laps the reader\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *check_str[] = {"verified", "no update record", "incomplete or corrupted"};
+    pthread_t tid;
+    uint8_t once = 0;
+    uint8_t sta;
+    int opt;
+
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "1b:e:c:a:r:l:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case '1': once = 1; break;
+            case 'b': g_sim_baud = strtoul(optarg, NULL, 0); break;
+            case 'e': g_sim_erase_ms = strtoul(optarg, NULL, 0); break;
+            case 'c': g_sim_cut = strtoul(optarg, NULL, 0); break;
+            case 'a': g_sim_cut_addr = strtoul(optarg, NULL, 0); break;
+            case 'r': g_sim_rxerr = strtoul(optarg, NULL, 0); break;
+            case 'l': g_sim_lap = strtoul(optarg, NULL, 0); break;
+            case 's': srand(strtoul(optarg, NULL, 0)); break;
+            default: sim_usage();
+        }
+    }
+
+    if (optind != argc - 1 || g_sim_baud == 0)sim_usage();
+
+    if (sim_flash_open(argv[optind]))
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (sim_pty_open())
+    {
+        perror("pty");
+        return 1;
+    }
+
+    signal(SIGINT, sim_signal);
+    signal(SIGTERM, sim_signal);
+
+    fprintf(stderr, "app   : %s\n", check_str[iap_stream_check(FLASH_APP1_ADDR)]);
+    printf("pty %s\n", ptsname(g_sim_pty));
+    fflush(stdout);
+
+    iap_stream_init();
+    pthread_create(&tid, NULL, sim_rx_thread, NULL);
+
+    while (1)
+    {
+        sta = iap_stream_poll();
+
+        if (sta == IAP_STREAM_ERROR)g_sim_errors++;
+
+        if (sta == IAP_STREAM_DONE)
+        {
+            sta = iap_stream_check(FLASH_APP1_ADDR);
+            fprintf(stderr, "update done, app %s\n", check_str[sta]);
+
+            if (once)
+            {
+                sim_sleep_ns(100000000);                    /* The acknowledgement of END goes out */
+                sim_report();
+                return sta ? 2 : 0;
+            }
+        }
+
+        sim_sleep_ns(10000000);                             /* HAL_Delay(10) of the main loop */
+    }
+}
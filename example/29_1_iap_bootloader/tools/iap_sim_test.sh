@@ -0,0 +1,131 @@
+#!/bin/sh
+# iap_sim_test.sh - run the streaming update of the bootloader against the simulated board (iap_sim.c)
+#
+# Usage: sh tools/iap_sim_test.sh            (from example/29_1_iap_bootloader, needs gcc and pyserial)
+#
+# Builds tools/iap_sim.c, then sends images with tools/iap_send.py:
+#   a full update, the same update cut by a power loss at several flash operations then resumed,
+#   an update with receive errors, and one where a noise burst makes the DMA lap the reader;
+#   a delta update, cut at several flash operations and while a journal CRC is programmed, then resumed.
+# After each update the application area of the flash file must hold the image.
+
+set -e
+cd "$(dirname "$0")/.."
+
+OUT=${TMPDIR:-/tmp}/iap_sim_test
+BAUD=921600
+mkdir -p "$OUT"
+
+gcc -O2 -Wall -Itools/host -ICore/Inc -IATK_Middlewares/IAP -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast \
+    -Wno-incompatible-pointer-types tools/iap_sim.c ATK_Middlewares/IAP/iap_stream.c ATK_Middlewares/IAP/iap_delta.c \
+    BSP/STMFLASH/stmflash.c -lpthread -o "$OUT/iap_sim"
+
+python3 - "$OUT" <<'EOF'
+import random, sys
+random.seed(1)
+old = bytes(random.getrandbits(8) for _ in range(61 * 1024 + 300))
+new = bytearray(old)
+new[3 * 2048 + 100:3 * 2048 + 160] = bytes(60)                     # pages 3, 10 and 20 change,
+new[10 * 2048:10 * 2048] = b"inserted bytes"                         # the pages after 10 are shifted
+new[20 * 2048 + 7] ^= 0xFF
+open(sys.argv[1] + "/old.bin", "wb").write(old)
+open(sys.argv[1] + "/new.bin", "wb").write(bytes(new))
+EOF
+python3 tools/iap_delta.py "$OUT/old.bin" "$OUT/new.bin" "$OUT/patch.bin"
+
+# run SIM_ARGS... -- SEND_ARGS... : one update, returns the status of iap_sim
+run()
+{
+    sim_args=""
+    while [ "$1" != "--" ]; do sim_args="$sim_args $1"; shift; done
+    shift
+    rm -f "$OUT/sim.out"
+    "$OUT/iap_sim" "$OUT/flash.bin" -1 -b $BAUD $sim_args > "$OUT/sim.out" 2> "$OUT/sim.err" &
+    sim=$!
+    while ! grep -q '^pty ' "$OUT/sim.out" 2>/dev/null; do sleep 0.05; done
+    pty=$(sed -n 's/^pty //p' "$OUT/sim.out")
+    python3 tools/iap_send.py "$pty" "$@" --baud $BAUD > "$OUT/send.out" 2>&1 &
+    send=$!
+    # Until the update is done, the power is cut or the sender gives up
+    while kill -0 $sim 2>/dev/null && kill -0 $send 2>/dev/null; do sleep 0.1; done
+    sleep 0.5
+    kill $sim $send 2>/dev/null || true
+    sta=0
+    wait $sim || sta=$?
+    wait $send 2>/dev/null || true
+    sed 's/^/    /' "$OUT/sim.err"
+    return $sta
+}
+
+# check FILE : the application area holds FILE
+check()
+{
+    size=$(stat -c %s "$1")
+    if ! tail -c +$((0x10000 + 1)) "$OUT/flash.bin" | head -c $size | cmp -s - "$1"; then
+        echo "FAIL: the flash does not hold $1"
+        exit 1
+    fi
+}
+
+echo "full update"
+rm -f "$OUT/flash.bin"
+run -- "$OUT/old.bin"
+check "$OUT/old.bin"
+
+for cut in 40 700 9000 20000 31000; do
+    echo "full update, power cut at flash operation $cut, then resumed"
+    rm -f "$OUT/flash.bin"
+    sta=0
+    run -c $cut -s $cut -- "$OUT/old.bin" || sta=$?
+    [ $sta -eq 3 ] || { echo "FAIL: no power cut ($sta)"; exit 1; }
+    run -- "$OUT/old.bin"
+    # Past the first page, the update continues where it stopped
+    [ $cut -lt 2100 ] || grep -q "resuming" "$OUT/send.out" || { echo "FAIL: not resumed"; exit 1; }
+    check "$OUT/old.bin"
+done
+
+echo "full update, a receive error every 3000 bytes"
+rm -f "$OUT/flash.bin"
+run -r 3000 -- "$OUT/old.bin"
+check "$OUT/old.bin"
+
+echo "full update, the DMA laps the reader after 20000 bytes"
+rm -f "$OUT/flash.bin"
+run -l 20000 -- "$OUT/old.bin"
+check "$OUT/old.bin"
+
+echo "delta update"
+rm -f "$OUT/flash.bin"
+run -- "$OUT/old.bin"
+cp "$OUT/flash.bin" "$OUT/flash_old.bin"
+run -- "$OUT/patch.bin" --delta
+check "$OUT/new.bin"
+
+# IAP_INFO_ADDR + 20: jcrc[0]; past the IAP_APP_MAX_PAGES jcrc and page flags: jspare[0]
+JCRC=$((0x0807F800 + 20))
+JSPARE=$((JCRC + 222 * 6))
+
+for cut in 5 600 1030 1100 2200 3500 5000; do
+    echo "delta update, power cut at flash operation $cut, then resumed"
+    cp "$OUT/flash_old.bin" "$OUT/flash.bin"
+    sta=0
+    run -c $cut -s $cut -- "$OUT/patch.bin" --delta || sta=$?
+    [ $sta -eq 3 ] || { echo "FAIL: no power cut ($sta)"; exit 1; }
+    run -- "$OUT/patch.bin" --delta
+    check "$OUT/new.bin"
+done
+
+for page in 3 10; do
+    echo "delta update, power cut while the journal CRC of page $page is programmed, then again in its spare slot"
+    cp "$OUT/flash_old.bin" "$OUT/flash.bin"
+    sta=0
+    run -a $((JCRC + page * 4 + 2)) -- "$OUT/patch.bin" --delta || sta=$?
+    [ $sta -eq 3 ] || { echo "FAIL: no power cut ($sta)"; exit 1; }
+    sta=0
+    run -a $((JSPARE + 6)) -- "$OUT/patch.bin" --delta || sta=$?
+    [ $sta -eq 3 ] || { echo "FAIL: no power cut ($sta)"; exit 1; }
+    run -- "$OUT/patch.bin" --delta
+    check "$OUT/new.bin"
+done
+
+echo "all passed"
@@ -14,6 +14,9 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     page writes with ACK polling, sequential reads
+ * V1.2         20261019     transfers through the IIC transaction engine
+ * V1.3         20261019     the ACK polling is bounded by HAL_GetTick instead of a number of attempts
  *
  ****************************************************************************************************
  */
@@ -33,6 +36,45 @@ void at24cxx_init(void)
     iic_init();
 }
 
+/**
+ * @brief       Device address and word address length for an address
+ * @param       addr: word address
+ * @param       len : word address length in bytes
+ * @retval      Device address, 8-bit write form
+ */
+static uint8_t at24cxx_dev_addr(uint16_t addr, uint8_t *len)
+{
+    if (EE_TYPE > AT24C16)      /* For models above 24C16, the address is sent in 2 bytes */
+    {
+        *len = 2;
+        return 0XA0;
+    }
+
+    *len = 1;
+    return 0XA0 + ((addr >> 8) << 1);   /* Device 0XA0 + high bit a8/a9/a10 address */
+}
+
+/**
+ * @brief       Waits for the end of the internal write cycle by ACK polling
+ * @note        The EEPROM does not acknowledge its address while it is writing,
+ *              so this returns as soon as the write is done (typically 3~5ms) instead of waiting 10ms.
+ *              The polling lasts at least EE_WRITE_TIMEOUT ms whatever the speed of the bus (HAL_GetTick counts ms,
+ *              so the elapsed time must exceed EE_WRITE_TIMEOUT ticks)
+ * @param       None
+ * @retval      0, ready; 1, timeout
+ */
+static uint8_t at24cxx_wait_ready(void)
+{
+    uint32_t start = HAL_GetTick();
+
+    do
+    {
+        if (iic_bus_write(&g_iic_bus, 0XA0, 0, 0, NULL, 0) == 0)return 0;   /* Address only */
+    } while (HAL_GetTick() - start <= EE_WRITE_TIMEOUT);
+
+    return 1;
+}
+
 /**
  * @brief       Read out a data at the address specified by AT24CXX
  * @param       addr: The address to start reading
@@ -41,28 +83,8 @@ void at24cxx_init(void)
 uint8_t at24cxx_read_one_byte(uint16_t addr)
 {
     uint8_t temp = 0;
-    iic_start();                 /* Send start signal */
 
-    if (EE_TYPE > AT24C16)       /* For models above 24C16, the address is sent in 2 bytes */
-    {
-        iic_send_byte(0XA0);     /* The write command is sent, and the IIC stipulates that the least significant bit is 0, indicating writing */
-        iic_wait_ack();          /* Every time a byte is sent, it waits for an ACK */
-        iic_send_byte(addr >> 8);/* Send high-byte addresses */
-    }
-    else
-    {
-        iic_send_byte(0XA0 + ((addr >> 8) << 1));   /* Send device 0XA0 + high bit a8/a9/a10 address, write data */
-    }
-
-    iic_wait_ack();             /* Every time a byte is sent, it waits for an ACK */
-    iic_send_byte(addr % 256);  /* Send low address */
-    iic_wait_ack();             /* Wait for the ACK, at which point the address is sent */
-
-    iic_start();                /* Retransmit the start signal */
-    iic_send_byte(0XA1);        /* Enter receive mode, the IIC specifies that the least bit is 0, indicating read */
-    iic_wait_ack();             /* Every time a byte is sent, it waits for an ACK */
-    temp = iic_read_byte(0);    /* Receives one byte of data */
-    iic_stop();                 /* Produces a stopping condition */
+    at24cxx_read(addr, &temp, 1);
     return temp;
 }
 
@@ -74,28 +96,7 @@ uint8_t at24cxx_read_one_byte(uint16_t addr)
  */
 void at24cxx_write_one_byte(uint16_t addr, uint8_t data)
 {
-    iic_start();                /* Send start signal */
-
-    if (EE_TYPE > AT24C16)      /* For models above 24C16, the address is sent in 2 bytes */
-    {
-        iic_send_byte(0XA0);    /* The write command is sent, and the IIC stipulates that the least significant bit is 0, indicating writing */
-        iic_wait_ack();         /* Every time a byte is sent, it waits for an ACK */
-        iic_send_byte(addr >> 8);/* Send high-byte addresses */
-    }
-    else
-    {
-        iic_send_byte(0XA0 + ((addr >> 8) << 1));   /* Send device 0XA0 + high bit a8/a9/a10 address, write data */
-    }
-
-    iic_wait_ack();             /* Every time a byte is sent, it waits for an ACK */
-    iic_send_byte(addr % 256);  /* Send low address */
-    iic_wait_ack();             /* Wait for the ACK, at which point the address is sent */
-
-    /* There is no need to re-send the start signal because we no longer need to enter receive mode when writing data */
-    iic_send_byte(data);        /* Send 1 byte */
-    iic_wait_ack();             /* Waiting for ACK */
-    iic_stop();                 /* Produces a stopping condition */
-    HAL_Delay(10);              /* Note: EEPROM writes are slow and must wait until 10ms before writing a word */
+    at24cxx_write(addr, &data, 1);
 }
 
 /**
@@ -128,32 +129,52 @@ uint8_t at24cxx_check(void)
 
 /**
  * @brief   starts reading the specified amount of data at the specified address in AT24CXX
+ * @note    One sequential read: the address is sent once, then the EEPROM increments it after each byte
  * @param   addr    : Start reading out the address pair 24c02 from 0 to 255
  * @param   pbuf    : the address at the beginning of the data array
  * @param   datalen : The number of data to read out
- * @retval  None
+ * @retval  0, successful; 1, the device did not acknowledge
  */
-void at24cxx_read(uint16_t addr, uint8_t *pbuf, uint16_t datalen)
+uint8_t at24cxx_read(uint16_t addr, uint8_t *pbuf, uint16_t datalen)
 {
-    while (datalen--)
-    {
-        *pbuf++ = at24cxx_read_one_byte(addr++);
-    }
+    uint8_t dev, len;
+
+    if (datalen == 0)return 0;
+
+    dev = at24cxx_dev_addr(addr, &len);
+    return iic_bus_read(&g_iic_bus, dev, addr, len, pbuf, datalen);
 }
 
 /**
  * @brief   starts writing the specified amount of data at the specified address in AT24CXX
+ * @note    The data is split at the EEPROM page boundaries (EE_PAGE_SIZE), each page is written in one
+ *          transfer and the end of its write cycle is detected by ACK polling
  * @param   addr    : Start writing at address 0-255 for 24c02
  * @param   pbuf    : the address at the beginning of the data array
  * @param   datalen : The amount of data to write
- * @retval  None
+ * @retval  0, successful; 1, the device did not acknowledge or did not finish writing
  */
-void at24cxx_write(uint16_t addr, uint8_t *pbuf, uint16_t datalen)
+uint8_t at24cxx_write(uint16_t addr, uint8_t *pbuf, uint16_t datalen)
 {
-    while (datalen--)
+    uint8_t dev, len;
+    uint16_t n;
+
+    while (datalen)
     {
-        at24cxx_write_one_byte(addr, *pbuf);
-        addr++;
-        pbuf++;
+        n = EE_PAGE_SIZE - (addr % EE_PAGE_SIZE);   /* Bytes left in the page, the EEPROM would wrap around past them */
+
+        if (n > datalen)n = datalen;
+
+        dev = at24cxx_dev_addr(addr, &len);
+
+        if (iic_bus_write(&g_iic_bus, dev, addr, len, pbuf, n))return 1;   /* The STOP starts the internal write cycle */
+
+        addr += n;
+        pbuf += n;
+        datalen -= n;
+
+        if (at24cxx_wait_ready())return 1;
     }
+
+    return 0;
 }
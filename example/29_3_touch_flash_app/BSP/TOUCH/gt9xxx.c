@@ -14,6 +14,7 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     register access through the IIC transaction engine
  *
  ****************************************************************************************************
  */
@@ -39,25 +40,7 @@ static uint8_t g_gt_tnum = 5;
  */
 static void gt9xxx_rd_reg(uint16_t reg, uint8_t *buf, uint8_t len)
 {
-    uint8_t i;
-    
-    ct_iic_start();
-    ct_iic_send_byte(GT9XXX_CMD_WR);                        /* Send write command */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg >> 8);                             /* Send the high 8-bit address of the register */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg & 0xFF);                           /* Send the lower 8 bit address of the register */
-    ct_iic_wait_ack();
-    
-    ct_iic_start();
-    ct_iic_send_byte(GT9XXX_CMD_RD);                        /* Send read command */
-    ct_iic_wait_ack();
-    for (i = 0; i < len; i++)                               /* Loop out the data */
-    {
-        buf[i] = ct_iic_read_byte(i == (len - 1) ? 0 : 1);
-    }
-    
-    ct_iic_stop();
+    iic_bus_read(&g_ct_iic_bus, GT9XXX_CMD_WR, reg, 2, buf, len);   /* Register address, repeated START, then the data */
 }
 
 /**
@@ -71,28 +54,7 @@ static void gt9xxx_rd_reg(uint16_t reg, uint8_t *buf, uint8_t len)
  */
 static uint8_t gt9xxx_wr_reg(uint16_t reg, uint8_t *buf, uint8_t len)
 {
-    uint8_t i;
-    uint8_t ret = 0;
-    
-    ct_iic_start();
-    ct_iic_send_byte(GT9XXX_CMD_WR);    /* Send write command */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg >> 8);         /* Send the high 8-bit address of the register */
-    ct_iic_wait_ack();
-    ct_iic_send_byte(reg & 0xFF);       /* Send the lower 8 bit address of the register */
-    ct_iic_wait_ack();
-    for (i = 0; i < len; i++)           /* Cyclic writing of data */
-    {
-        ct_iic_send_byte(buf[i]);
-        ret = ct_iic_wait_ack();
-        if (ret)
-        {
-            break;
-        }
-    }
-    ct_iic_stop();
-    
-    return ret;
+    return iic_bus_write(&g_ct_iic_bus, GT9XXX_CMD_WR, reg, 2, buf, len);
 }
 
 /**
@@ -0,0 +1,398 @@
+/**
+ ****************************************************************************************************
+ * @file        lpidle.c
+ * @author      ALIENTEK
+ * @brief       FreeRTOS tickless idle: SLEEP or STOP from the next wake-up, RTC alarm as the STOP timer
+ *
+ *              The idle task calls lpidle_suppress_ticks (portSUPPRESS_TICKS_AND_SLEEP) with the ticks
+ *              until the next task wakes up. A short idle is spent in SLEEP by the port itself, the
+ *              SysTick is reprogrammed to fire at the wake-up. From LPIDLE_STOP_MIN_TICKS on, the CPU
+ *              enters STOP: the SysTick and the HAL timebase (TIM1) stop with HCLK, so the RTC counter
+ *              (LSE, LPIDLE_RTC_HZ) measures the time and its alarm (EXTI line 17) wakes the CPU up
+ *              LPIDLE_WAKE_US early, the time the clocks take to come back. On wake-up the elapsed
+ *              time is added to the tick count (vTaskStepTick) and to the HAL tick, and the SysTick is
+ *              restarted with the rest of the current tick.
+ *
+ *              The RTC counter is read with its prescaler, in LSE periods (30.5us). In whole counts a STOP
+ *              ended by the alarm would be measured from a count edge plus the clock restore time, an
+ *              error of the same sign at every STOP, and the tick count would drift.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     the clocks are restored with bounded register waits, not by SystemClock_Config;
+ *                           the STOP time is measured in LSE periods
+ *
+ ****************************************************************************************************
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "lpidle.h"
+
+
+#define LPIDLE_TICK_US                  (1000000 / configTICK_RATE_HZ)
+#define LPIDLE_RTC_DIV                  (32768 / LPIDLE_RTC_HZ)     /* LSE periods per count */
+#define LPIDLE_CLK_WAIT                 (LPIDLE_CLK_TIMEOUT_US * (HSI_VALUE / 1000000) / 4)  /* A pass of a wait loop takes 4 HSI clocks or more */
+
+extern void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);  /* port.c: SLEEP with the SysTick reprogrammed */
+
+static uint8_t g_lpidle_rtc_ok = 0;
+static volatile uint32_t g_lpidle_locks = 0;
+static lpidle_stat_t g_lpidle_stat;
+
+/**
+ * @brief   Waits until the RTC registers are read again, after a reset or a stop of APB1
+ * @param   None
+ * @retval  None
+ */
+static void lpidle_rtc_sync(void)
+{
+    RTC->CRL &= ~RTC_CRL_RSF;
+
+    while ((RTC->CRL & RTC_CRL_RSF) == 0);
+}
+
+/**
+ * @brief   Reads the RTC counter
+ * @param   None
+ * @retval  Counts, LPIDLE_RTC_HZ per second
+ */
+static uint32_t lpidle_rtc_count(void)
+{
+    uint16_t high, low;
+
+    do
+    {
+        high = RTC->CNTH;
+        low = RTC->CNTL;
+    } while (high != RTC->CNTH);        /* The low half wrapped between the two reads */
+
+    return ((uint32_t)high << 16) | low;
+}
+
+/**
+ * @brief   Reads the RTC counter and its prescaler
+ * @note    The prescaler counts down from LPIDLE_RTC_DIV - 1 and the counter moves on when it reloads
+ * @param   None
+ * @retval  LSE periods, wraps after 2^32 of them (36 hours)
+ */
+static uint32_t lpidle_rtc_lse(void)
+{
+    uint32_t cnt;
+    uint16_t div;
+
+    do
+    {
+        cnt = lpidle_rtc_count();
+        div = RTC->DIVL;
+    } while (cnt != lpidle_rtc_count());    /* The prescaler reloaded between the reads */
+
+    return cnt * LPIDLE_RTC_DIV + (LPIDLE_RTC_DIV - 1 - div);
+}
+
+/**
+ * @brief   Writes the alarm, the RTC is in configuration mode meanwhile
+ * @param   alarm : counter value that raises the alarm
+ * @retval  None
+ */
+static void lpidle_rtc_set_alarm(uint32_t alarm)
+{
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0);
+
+    RTC->CRL |= RTC_CRL_CNF;
+    RTC->ALRH = alarm >> 16;
+    RTC->ALRL = alarm & 0xFFFF;
+    RTC->CRL &= ~RTC_CRL_CNF;
+
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0);    /* Written after about 3 LSE periods */
+}
+
+/**
+ * @brief   Starts the RTC on LSE at LPIDLE_RTC_HZ and its alarm interrupt
+ * @note    Call it before the scheduler starts. The RTC prescaler is changed: a calendar kept by
+ *          another example in the backup domain does not count seconds any more.
+ * @param   None
+ * @retval  0, STOP available; 1, LSE does not start, the idle only uses SLEEP
+ */
+uint8_t lpidle_init(void)
+{
+    RCC_OscInitTypeDef osc = {0};
+    RCC_PeriphCLKInitTypeDef clk = {0};
+
+    lpidle_reset_stat();
+
+    __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_BKP_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    osc.OscillatorType = RCC_OSCILLATORTYPE_LSE;
+    osc.LSEState = RCC_LSE_ON;
+    osc.PLL.PLLState = RCC_PLL_NONE;
+
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK)return 1;
+
+    clk.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+    clk.RTCClockSelection = RCC_RTCCLKSOURCE_LSE;
+
+    if (HAL_RCCEx_PeriphCLKConfig(&clk) != HAL_OK)return 1;
+
+    __HAL_RCC_RTC_ENABLE();
+    lpidle_rtc_sync();
+
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0);
+
+    RTC->CRL |= RTC_CRL_CNF;
+    RTC->PRLH = 0;
+    RTC->PRLL = LPIDLE_RTC_DIV - 1;
+    RTC->ALRH = 0xFFFF;
+    RTC->ALRL = 0xFFFF;
+    RTC->CRL &= ~RTC_CRL_CNF;
+
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0);
+
+    RTC->CRL &= ~RTC_CRL_ALRF;
+    RTC->CRH = RTC_CRH_ALRIE;
+
+    /* The alarm reaches the NVIC through EXTI line 17, the only way out of STOP */
+    EXTI->PR = EXTI_PR_PR17;
+    EXTI->RTSR |= EXTI_RTSR_TR17;
+    EXTI->IMR |= EXTI_IMR_MR17;
+    HAL_NVIC_SetPriority(RTC_Alarm_IRQn, LPIDLE_RTC_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+
+    g_lpidle_rtc_ok = 1;
+    return 0;
+}
+
+/**
+ * @brief   Restores the clocks of SystemClock_Config: STOP is left on HSI, with HSE and the PLL off
+ * @note    The interrupts are disabled and the HAL tick is suspended, HAL_GetTick does not move and the
+ *          timeouts of the HAL RCC functions would never expire: the waits count loop passes instead.
+ *          The PLL source and multiplier, the bus prescalers and the flash latency are kept in STOP.
+ * @param   None
+ * @retval  0, OK; 1, HSE or the PLL did not start within LPIDLE_CLK_TIMEOUT_US
+ */
+static uint8_t lpidle_clock_restore(void)
+{
+    uint32_t n;
+
+    RCC->CR |= RCC_CR_HSEON;
+    n = LPIDLE_CLK_WAIT;
+
+    while ((RCC->CR & RCC_CR_HSERDY) == 0)
+    {
+        if (--n == 0)return 1;
+    }
+
+    RCC->CR |= RCC_CR_PLLON;
+    n = LPIDLE_CLK_WAIT;
+
+    while ((RCC->CR & RCC_CR_PLLRDY) == 0)
+    {
+        if (--n == 0)return 1;
+    }
+
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+    n = LPIDLE_CLK_WAIT;
+
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL)
+    {
+        if (--n == 0)return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   RTC alarm interrupt, it only wakes the CPU up
+ * @param   None
+ * @retval  None
+ */
+void RTC_Alarm_IRQHandler(void)
+{
+    RTC->CRL &= ~RTC_CRL_ALRF;
+    EXTI->PR = EXTI_PR_PR17;
+}
+
+/**
+ * @brief   Short idle: SLEEP, the SysTick wakes the CPU up
+ * @param   expected : ticks until the next task wakes up
+ * @retval  None
+ */
+static void lpidle_sleep(TickType_t expected)
+{
+    TickType_t start = xTaskGetTickCount();
+    uint32_t ticks;
+
+    HAL_SuspendTick();                  /* Otherwise TIM1 wakes the CPU up every ms */
+    vPortSuppressTicksAndSleep(expected);
+    ticks = xTaskGetTickCount() - start;
+    uwTick += ticks * portTICK_PERIOD_MS;
+    HAL_ResumeTick();
+
+    g_lpidle_stat.sleeps++;
+    g_lpidle_stat.sleep_ms += ticks * portTICK_PERIOD_MS;
+}
+
+/**
+ * @brief   Long idle: STOP until the RTC alarm (or any EXTI line)
+ * @param   expected : ticks until the next task wakes up, at least LPIDLE_STOP_MIN_TICKS
+ * @retval  None
+ */
+static void lpidle_stop(TickType_t expected)
+{
+    uint32_t load = SystemCoreClock / configTICK_RATE_HZ;
+    uint32_t part_us, total_us, ticks, start, alarm;
+
+    if (expected > LPIDLE_STOP_MAX_TICKS)expected = LPIDLE_STOP_MAX_TICKS;
+
+    __disable_irq();
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+    /* A task became ready meanwhile, or a tick is due and not counted yet */
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        g_lpidle_stat.aborts++;
+        __enable_irq();
+        return;
+    }
+
+    part_us = (load - 1 - SysTick->VAL) / (SystemCoreClock / 1000000);   /* Since the last tick */
+    start = lpidle_rtc_lse();
+    alarm = lpidle_rtc_count() + (uint32_t)(((uint64_t)(expected * LPIDLE_TICK_US - part_us - LPIDLE_WAKE_US) * LPIDLE_RTC_HZ) / 1000000);
+    lpidle_rtc_set_alarm(alarm);
+
+    if ((int32_t)(alarm - lpidle_rtc_count()) < 2)  /* Too close: it could pass before the CPU stops */
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        g_lpidle_stat.aborts++;
+        __enable_irq();
+        return;
+    }
+
+    HAL_SuspendTick();
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    if (lpidle_clock_restore() != 0)    /* STOP is left on HSI */
+    {
+        Error_Handler();                /* As SystemClock_Config */
+    }
+
+    lpidle_rtc_sync();
+
+    total_us = part_us + (uint32_t)(((uint64_t)(lpidle_rtc_lse() - start) * 1000000) / 32768);
+    ticks = total_us / LPIDLE_TICK_US;
+
+    if (ticks >= expected)
+    {
+        /* The tick count may not go past the wake-up, the SysTick interrupt counts the last tick now */
+        ticks = expected;
+        vTaskStepTick(ticks - 1);
+        SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+        SysTick->LOAD = load - 1;
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    }
+    else
+    {
+        /* The next tick comes after the rest of the current one */
+        vTaskStepTick(ticks);
+        SysTick->LOAD = (LPIDLE_TICK_US - total_us % LPIDLE_TICK_US) * (SystemCoreClock / 1000000) - 1;
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        SysTick->LOAD = load - 1;
+    }
+
+    uwTick += ticks * portTICK_PERIOD_MS;
+    HAL_ResumeTick();
+
+    g_lpidle_stat.stops++;
+    g_lpidle_stat.stop_ms += ticks * portTICK_PERIOD_MS;
+
+    __enable_irq();                     /* The interrupt that woke the CPU up runs now */
+}
+
+/**
+ * @brief   portSUPPRESS_TICKS_AND_SLEEP: sleeps until the next task wakes up
+ * @note    Called by the idle task with the scheduler suspended
+ * @param   expected : ticks until the next task wakes up
+ * @retval  None
+ */
+void lpidle_suppress_ticks(uint32_t expected)
+{
+    if (g_lpidle_rtc_ok && g_lpidle_locks == 0 && expected >= LPIDLE_STOP_MIN_TICKS)
+    {
+        lpidle_stop(expected);
+    }
+    else
+    {
+        lpidle_sleep(expected);
+    }
+}
+
+/**
+ * @brief   Forbids STOP, for a peripheral that needs its clock (transfer in progress, reception...)
+ * @note    Calls nest, each one needs its lpidle_stop_unlock. Also callable from an interrupt.
+ * @param   None
+ * @retval  None
+ */
+void lpidle_stop_lock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    g_lpidle_locks++;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief   Allows STOP again
+ * @param   None
+ * @retval  None
+ */
+void lpidle_stop_unlock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    if (g_lpidle_locks)g_lpidle_locks--;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief   Reads the residency statistics
+ * @note    The idle task updates them with the scheduler suspended, a task never sees half of it
+ * @param   stat : statistics. Running time = tick count - since - sleep_ms - stop_ms
+ * @retval  None
+ */
+void lpidle_get_stat(lpidle_stat_t *stat)
+{
+    *stat = g_lpidle_stat;
+}
+
+/**
+ * @brief   Clears the residency statistics
+ * @param   None
+ * @retval  None
+ */
+void lpidle_reset_stat(void)
+{
+    g_lpidle_stat.sleeps = 0;
+    g_lpidle_stat.stops = 0;
+    g_lpidle_stat.aborts = 0;
+    g_lpidle_stat.sleep_ms = 0;
+    g_lpidle_stat.stop_ms = 0;
+    g_lpidle_stat.since = xTaskGetTickCount();
+}
@@ -0,0 +1,52 @@
+/**
+ ****************************************************************************************************
+ * @file        lpidle.h
+ * @author      ALIENTEK
+ * @brief       FreeRTOS tickless idle: SLEEP or STOP from the next wake-up, RTC alarm as the STOP timer
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     add LPIDLE_CLK_TIMEOUT_US
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __LPIDLE_H
+#define __LPIDLE_H
+
+#include "main.h"
+
+
+#define LPIDLE_RTC_HZ                   1024    /* RTC counter clock: LSE / 32, one count is 0.977ms */
+#define LPIDLE_STOP_MIN_TICKS           10      /* Idle from this many ticks on: STOP, below: SLEEP */
+#define LPIDLE_STOP_MAX_TICKS           60000   /* Longest STOP, a longer idle wakes up once meanwhile */
+#define LPIDLE_WAKE_US                  2000    /* Leaving STOP: HSE start-up and PLL lock, the alarm is set this much earlier */
+#define LPIDLE_RTC_IRQ_PRIO             15      /* The alarm interrupt only wakes the CPU up */
+#define LPIDLE_CLK_TIMEOUT_US           100000  /* Leaving STOP: HSE start-up and PLL lock give up after this, as HSE_STARTUP_TIMEOUT */
+
+typedef struct
+{
+    uint32_t sleeps;                    /* SLEEP entries */
+    uint32_t stops;                     /* STOP entries */
+    uint32_t aborts;                    /* STOP given up: a task became ready, a tick was due or the alarm was too close */
+    uint32_t sleep_ms;                  /* Time in SLEEP */
+    uint32_t stop_ms;                   /* Time in STOP, clock restore included */
+    uint32_t since;                     /* Tick count of lpidle_reset_stat */
+} lpidle_stat_t;
+
+uint8_t lpidle_init(void);                                  /* Starts the RTC on LSE, 0: STOP available; 1: SLEEP only */
+void lpidle_suppress_ticks(uint32_t expected);              /* portSUPPRESS_TICKS_AND_SLEEP */
+void lpidle_stop_lock(void);                                /* STOP not allowed until the matching unlock (a peripheral is busy) */
+void lpidle_stop_unlock(void);
+void lpidle_get_stat(lpidle_stat_t *stat);
+void lpidle_reset_stat(void);
+
+#endif
@@ -14,49 +14,30 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     memory from the FreeRTOS heap, thread safe, per-task usage and fixed-size pools
+ * V1.2         20261019     the entry of a deleted task is released (traceTASK_DELETE)
  *
  ****************************************************************************************************
  */
 
 #include "malloc.h"
 
-#if !(__ARMCC_VERSION >= 6010050)   /* Not the AC6 compiler, that is, when using the AC5 compiler */
+#define MEM_MAGIC       0x4D4D          /* Marks the blocks of mymalloc */
 
-/* Memory pool (64 byte alignment) */
-static __ALIGNED(64) uint8_t mem1base[MEM1_MAX_SIZE]; /* Internal SRAM memory pool */
-
-/* Memory management table */
-static MT_TYPE mem1mapbase[MEM1_ALLOC_TABLE_SIZE];  /* Internal SRAM memory pool MAP */
-
-#else   /* It's the AC6 compiler, and when you use the AC6 compiler */
-
-/* Memory pool (64 byte alignment) */
-static __ALIGNED(64) uint8_t mem1base[MEM1_MAX_SIZE];   /* Internal SRAM memory pool */
-
-/* Memory management table */
-static MT_TYPE mem1mapbase[MEM1_ALLOC_TABLE_SIZE];      /* Internal SRAM memory pool MAP */
-
-#endif
-
-/* Memory management parameters */
-const uint32_t memtblsize[SRAMBANK] = {MEM1_ALLOC_TABLE_SIZE,
-                                       };       /* Memory table size */
-
-const uint32_t memblksize[SRAMBANK] = {MEM1_BLOCK_SIZE
-                                      };        /* Memory chunk size */
-
-const uint32_t memsize[SRAMBANK] = {MEM1_MAX_SIZE,
-                                   };           /* Total memory size */
-
-/* Memory Management controller */
-struct _m_mallco_dev mallco_dev =
+/*
+ * In front of each block of mymalloc, after the header of heap_4. 8 bytes: the block stays aligned
+ * on 8 (portBYTE_ALIGNMENT).
+ */
+typedef struct
 {
-    my_mem_init,    /* Memory initialization */
-    my_mem_perused, /* memory usage */
-    mem1base,       /* memory pool */
-    mem1mapbase,    /* Memory management status table */
-    0,              /* Memory management is not in place */
-};
+    uint32_t size;                      /* Bytes asked */
+    uint8_t slot;                       /* Entry of g_mem_stat charged */
+    uint8_t memx;
+    uint16_t magic;
+} mem_head_t;
+
+/* Usage per task, entry 0: main and the tasks that did not get an entry */
+static my_mem_stat_t g_mem_stat[MEM_MAX_TASKS];
 
 /**
  * @brief   copies memory
@@ -89,157 +70,194 @@ void my_mem_set(void *s, uint8_t c, uint32_t count)
 
 /**
  * @brief   memory management initialization
+ * @note    heap_4 sets its heap up at the first allocation: this only clears the usage,
+ *          before any allocation of the application
  * @param   memx - The memory block it belongs to
  * @retval  None
  */
 void my_mem_init(uint8_t memx)
 {
-    uint8_t mttsize = sizeof(MT_TYPE);  /* Gets the type length of the memmap array (uint16t/uint32t) */
-    my_mem_set(mallco_dev.memmap[memx], 0, memtblsize[memx]*mttsize); /* Memory state table data reset */
-    mallco_dev.memrdy[memx] = 1;        /* Memory management initializes OK */
+    (void)memx;
+    my_mem_set(g_mem_stat, 0, sizeof(g_mem_stat));
 }
 
 /**
  * @brief   gets memory usage
+ * @note    The whole heap: the stacks and objects of the kernel are counted too
  * @param   memx : The memory block it belongs to
  * @retval  usage (10x larger, 0-1000, 0.0%-100.0%)
  */
 uint16_t my_mem_perused(uint8_t memx)
 {
-    uint32_t used = 0;
-    uint32_t i;
+    (void)memx;
+    return (configTOTAL_HEAP_SIZE - xPortGetFreeHeapSize()) * 1000 / configTOTAL_HEAP_SIZE;
+}
 
-    for (i = 0; i < memtblsize[memx]; i++)
+/**
+ * @brief   Entry of g_mem_stat of the running task, taken if it has none (interrupts disabled)
+ * @note    The entries of deleted tasks leave holes: the whole table is searched first
+ * @param   None
+ * @retval  entry, 0 before the scheduler or when the table is full
+ */
+static uint8_t my_mem_slot(void)
+{
+    TaskHandle_t task;
+    uint8_t i, slot = 0;
+
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)return 0;
+
+    task = xTaskGetCurrentTaskHandle();
+
+    for (i = 1; i < MEM_MAX_TASKS; i++)
     {
-        if (mallco_dev.memmap[memx][i])used++;
+        if (g_mem_stat[i].task == task)return i;
+
+        if (slot == 0 && g_mem_stat[i].task == NULL && g_mem_stat[i].deleted == 0)slot = i;
     }
 
-    return (used * 1000) / (memtblsize[memx]);
+    if (slot)g_mem_stat[slot].task = task;
+
+    return slot;
 }
 
 /**
- * @brief  Memory allocation (internal call)
- * @param  memx : The memory block it belongs to
- * @param  size : The size (in bytes) of memory to allocate
- * @retval memory offset address
- * @arg    0 to 0XFFFFFFFE: A valid memory offset
- * @arg    0XFFFFFFFF: Invalid memory offset address
+ * @brief   A task is deleted: releases its entry (traceTASK_DELETE, in a critical section)
+ * @note    With blocks still allocated, the entry is kept as deleted until myfree gives back the
+ *          last one: a new task, maybe with the same TCB address, never gets the old usage
+ * @param   task : handle of the task
+ * @retval  None
  */
-static uint32_t my_mem_malloc(uint8_t memx, uint32_t size)
+void my_mem_task_delete(void *task)
 {
-    signed long offset = 0;
-    uint32_t nmemb;     /* The number of memory blocks required */
-    uint32_t cmemb = 0; /* The number of contiguous empty memory blocks */
-    uint32_t i;
-
-    if (!mallco_dev.memrdy[memx])
-    {
-        mallco_dev.init(memx);          /* Uninitialized, initialized first */
-    }
-    
-    if (size == 0) return 0XFFFFFFFF;   /* No allocation required */
+    my_mem_stat_t *stat;
+    uint32_t primask;
+    uint8_t i;
 
-    nmemb = size / memblksize[memx];    /* Gets the number of contiguous memory blocks to allocate */
+    if (task == NULL)return;
 
-    if (size % memblksize[memx]) nmemb++;
+    primask = __get_PRIMASK();
+    __disable_irq();
 
-    for (offset = memtblsize[memx] - 1; offset >= 0; offset--)  /* Search the entire memory control area */
+    for (i = 1; i < MEM_MAX_TASKS; i++)
     {
-        if (!mallco_dev.memmap[memx][offset])
+        stat = &g_mem_stat[i];
+
+        if (stat->task != task)continue;
+
+        if (stat->used == 0)
         {
-            cmemb++;            /* The number of contiguous empty memory blocks is increased */
+            my_mem_set(stat, 0, sizeof(my_mem_stat_t));
         }
-        else 
+        else
         {
-            cmemb = 0;          /* Contiguous memory blocks are reset */
+            stat->task = NULL;
+            stat->deleted = 1;
         }
-        
-        if (cmemb == nmemb)     /* nmemb consecutive empty memory blocks are found */
-        {
-            for (i = 0; i < nmemb; i++) /* Note that the memory block is not empty */
-            {
-                mallco_dev.memmap[memx][offset + i] = nmemb;
-            }
 
-            return (offset * memblksize[memx]); /* Returns the offset address */
-        }
+        break;
     }
 
-    return 0XFFFFFFFF;  /* No block suitable for allocation was found */
+    __set_PRIMASK(primask);
 }
 
 /**
- * @brief  Frees memory (internal call)
- * @param  memx   : The memory block it belongs to
- * @param  offset : Memory address offset
- * @retval releases the result
- * @arg    0, release was successful;
- * @arg    1, release failed;
- * @arg    2, hyperregion (fail);
+ * @brief   Copies the usage of a task
+ * @param   index : 0 to MEM_MAX_TASKS - 1, entry 0 is main and the tasks past the table
+ * @param   stat  : usage
+ * @retval  0, entry used; 1, no task there (index 0 always used)
  */
-static uint8_t my_mem_free(uint8_t memx, uint32_t offset)
+uint8_t my_mem_get_stat(uint8_t index, my_mem_stat_t *stat)
 {
-    int i;
-
-    if (!mallco_dev.memrdy[memx])   /* Uninitialized, initialized first */
-    {
-        mallco_dev.init(memx);
-        return 1;                   /* Uninitialized */
-    }
+    uint32_t primask;
 
-    if (offset < memsize[memx])     /* The offset is in the memory pool. */
-    {
-        int index = offset / memblksize[memx];      /* The memory block number in which the offset is located */
-        int nmemb = mallco_dev.memmap[memx][index]; /* Number of memory blocks */
+    if (index >= MEM_MAX_TASKS)return 1;
 
-        for (i = 0; i < nmemb; i++)                 /* Memory blocks are reset */
-        {
-            mallco_dev.memmap[memx][index + i] = 0;
-        }
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *stat = g_mem_stat[index];
+    __set_PRIMASK(primask);
 
-        return 0;
-    }
-    else
-    {
-        return 2;   /* The offset is out of range */
-    }
+    return (index != 0 && stat->task == NULL && stat->deleted == 0) ? 1 : 0;
 }
 
 /**
  * @brief   Frees memory (external call)
+ * @note    From a task (heap_4 suspends the scheduler), any task may free the block of another
  * @param   memx : The memory block it belongs to
  * @param   ptr  : Memory head address
  * @retval  none
  */
 void myfree(uint8_t memx, void *ptr)
 {
-    uint32_t offset;
+    mem_head_t *head;
+    my_mem_stat_t *stat;
+    uint32_t primask;
 
     if (ptr == NULL)return;     /* The address is 0. */
 
-    offset = (uint32_t)ptr - (uint32_t)mallco_dev.membase[memx];
-    my_mem_free(memx, offset);  /* free the memory */
+    head = (mem_head_t *)ptr - 1;
+
+    if (head->magic != MEM_MAGIC || head->memx != memx)return;  /* Not a block of mymalloc */
+
+    head->magic = 0;            /* A second free is ignored */
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    stat = &g_mem_stat[head->slot];
+    stat->used -= (head->size <= stat->used) ? head->size : stat->used;
+
+    if (stat->deleted && stat->used == 0)my_mem_set(stat, 0, sizeof(my_mem_stat_t));   /* Last block of a deleted task */
+
+    __set_PRIMASK(primask);
+
+    vPortFree(head);
 }
 
 /**
  * @brief   Allocate memory (external call)
+ * @note    From a task, or before the scheduler starts
  * @param   memx : The memory block it belongs to
  * @param   size : The size (in bytes) of memory to allocate
  * @retval  at the head of the allocated memory.
  */
 void *mymalloc(uint8_t memx, uint32_t size)
 {
-    uint32_t offset;
-    offset = my_mem_malloc(memx, size);
+    mem_head_t *head = NULL;
+    my_mem_stat_t *stat;
+    uint32_t primask;
+    uint8_t slot;
+
+    if (memx >= SRAMBANK || size == 0)return NULL;
+
+    if (size < configTOTAL_HEAP_SIZE)head = pvPortMalloc(sizeof(mem_head_t) + size);
 
-    if (offset == 0XFFFFFFFF)   /* Error in application */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    slot = my_mem_slot();
+    stat = &g_mem_stat[slot];
+
+    if (head)
     {
-        return NULL;            /* Returns empty (0) */
+        stat->allocs++;
+        stat->used += size;
+
+        if (stat->used > stat->peak)stat->peak = stat->used;
     }
-    else    /* No problem with the application. Return to the first address */
+    else
     {
-        return (void *)((uint32_t)mallco_dev.membase[memx] + offset);
+        stat->fails++;
     }
+
+    __set_PRIMASK(primask);
+
+    if (head == NULL)return NULL;
+
+    head->size = size;
+    head->slot = slot;
+    head->memx = memx;
+    head->magic = MEM_MAGIC;
+
+    return head + 1;
 }
 
 /**
@@ -251,29 +269,136 @@ void *mymalloc(uint8_t memx, uint32_t size)
  */
 void *myrealloc(uint8_t memx, void *ptr, uint32_t size)
 {
-    uint32_t offset;
-    offset = my_mem_malloc(memx, size);
+    mem_head_t *head;
+    void *new_ptr;
+
+    if (ptr == NULL)return mymalloc(memx, size);
+
+    head = (mem_head_t *)ptr - 1;
 
-    if (offset == 0XFFFFFFFF)   /* Error in application */
+    if (head->magic != MEM_MAGIC)return NULL;
+
+    new_ptr = mymalloc(memx, size);
+
+    if (new_ptr == NULL)        /* Error in application, the old memory is kept */
     {
-        return NULL;            /* Returns empty (0) */
+        return NULL;
     }
-    else    /* No problem with the application. Return to the first address */
+
+    my_mem_copy(new_ptr, ptr, head->size < size ? head->size : size);   /* Copy old memory contents to new memory */
+    myfree(memx, ptr);          /* Freeing old memory */
+    return new_ptr;
+}
+
+/**
+ * @brief   Creates a pool of fixed-size blocks, its memory is charged to the calling task
+ * @param   pool  : pool
+ * @param   size  : block size in bytes, rounded up to 8
+ * @param   count : blocks
+ * @retval  0, OK; 1, no memory
+ */
+uint8_t my_pool_create(my_pool_t *pool, uint16_t size, uint16_t count)
+{
+    uint16_t i;
+
+    size = (size + 7) & ~7;
+    pool->base = mymalloc(SRAMIN, (uint32_t)size * count);
+
+    if (pool->base == NULL)return 1;
+
+    pool->free = NULL;
+
+    for (i = count; i > 0; i--)         /* Lowest address first in the list */
     {
-        my_mem_copy((void *)((uint32_t)mallco_dev.membase[memx] + offset), ptr, size); /* Copy old memory contents to new memory */
-        myfree(memx, ptr);  /* Freeing old memory */
-        return (void *)((uint32_t)mallco_dev.membase[memx] + offset);   /* Returns the new memory head address */
+        *(void **)&pool->base[(i - 1) * size] = pool->free;
+        pool->free = &pool->base[(i - 1) * size];
     }
+
+    pool->size = size;
+    pool->count = count;
+    pool->used = 0;
+    pool->peak = 0;
+    pool->spills = 0;
+    return 0;
 }
 
+/**
+ * @brief   Gives the memory of a pool back to the heap, all its blocks must be freed
+ * @param   pool : pool
+ * @retval  None
+ */
+void my_pool_delete(my_pool_t *pool)
+{
+    myfree(SRAMIN, pool->base);
+    pool->base = NULL;
+    pool->free = NULL;
+    pool->count = 0;
+}
 
+/**
+ * @brief   Takes a block: interrupts disabled for a few instructions only
+ * @note    From a task or an interrupt. An empty pool takes the block from the heap,
+ *          from a task only (an interrupt gets NULL)
+ * @param   pool : pool
+ * @retval  block, NULL: none
+ */
+void *my_pool_alloc(my_pool_t *pool)
+{
+    void *ptr;
+    uint32_t primask;
 
+    primask = __get_PRIMASK();
+    __disable_irq();
+    ptr = pool->free;
 
+    if (ptr)
+    {
+        pool->free = *(void **)ptr;
 
+        if (++pool->used > pool->peak)pool->peak = pool->used;
+    }
 
+    __set_PRIMASK(primask);
+
+    if (ptr == NULL && __get_IPSR() == 0)
+    {
+        ptr = mymalloc(SRAMIN, pool->size);
 
+        if (ptr)
+        {
+            primask = __get_PRIMASK();
+            __disable_irq();
+            pool->spills++;
+            __set_PRIMASK(primask);
+        }
+    }
 
+    return ptr;
+}
 
+/**
+ * @brief   Gives a block back
+ * @note    From a task or an interrupt, a block that came from the heap from a task only
+ * @param   pool : pool
+ * @param   ptr  : block of my_pool_alloc
+ * @retval  None
+ */
+void my_pool_free(my_pool_t *pool, void *ptr)
+{
+    uint32_t primask;
 
+    if (ptr == NULL)return;
 
+    if ((uint8_t *)ptr < pool->base || (uint8_t *)ptr >= pool->base + (uint32_t)pool->size * pool->count)
+    {
+        myfree(SRAMIN, ptr);            /* Spilled to the heap */
+        return;
+    }
 
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *(void **)ptr = pool->free;
+    pool->free = ptr;
+    pool->used--;
+    __set_PRIMASK(primask);
+}
@@ -3,6 +3,12 @@
  * @file        malloc.h
  * @author      ALIENTEK
  * @brief       malloc code
+ *
+ *              In this example the memory of mymalloc is the FreeRTOS heap (heap_4, configTOTAL_HEAP_SIZE):
+ *              one heap for the kernel and the application, locked against the other tasks. Each block
+ *              records the task that allocated it, and the fixed-size pools take and give back their
+ *              blocks in a few instructions.
+ *
  * @license     Copyright (C) 2012-2024, ALIENTEK
  ****************************************************************************************************
  * @attention
@@ -14,6 +20,8 @@
  * change logs  ：
  * version      data         notes
  * V1.0         20240409     the first version
+ * V1.1         20261019     memory from the FreeRTOS heap, thread safe, per-task usage and fixed-size pools
+ * V1.2         20261019     the entry of a deleted task is released (traceTASK_DELETE)
  *
  ****************************************************************************************************
  */
@@ -22,20 +30,16 @@
 #define __MALLOC_H
 
 #include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
 /* memory pools */
-#define SRAMIN      0       /* Internal SRAM, 64KB in total */
+#define SRAMIN      0       /* Internal SRAM: the FreeRTOS heap */
 
 #define SRAMBANK    1       /* Defines the number of SRAM blocks supported. */
 
 
-#define MT_TYPE     uint16_t
-
- 
-/* mem1 memory parameter setting.mem1 is the SRAM inside F103. */
-#define MEM1_BLOCK_SIZE         32                              /* The memory block size is 32 bytes */
-#define MEM1_MAX_SIZE           40 * 1024                       /* The maximum managed memory is 40K, with a total of 512KB of F103 internal SRAM */
-#define MEM1_ALLOC_TABLE_SIZE   MEM1_MAX_SIZE/MEM1_BLOCK_SIZE   /* Memory table size */
+#define MEM_MAX_TASKS           8       /* Tasks with their own usage, the others count in entry 0 with main */
 
 
 #ifndef NULL
@@ -43,40 +47,44 @@
 #endif
 
 
-
-/* Memory Management controller */
-struct _m_mallco_dev
+/* Usage of a task */
+typedef struct
 {
-    void (*init)(uint8_t);          /* initialize */
-    uint16_t (*perused)(uint8_t);   /* memory usage */
-    uint8_t *membase[SRAMBANK];     /* The memory pool manages the memory of the SRAMBANK regions */
-    MT_TYPE *memmap[SRAMBANK];      /* Memory management status table */
-    uint8_t  memrdy[SRAMBANK];      /* Memory management in place */
-};
-
-extern struct _m_mallco_dev mallco_dev;
+    TaskHandle_t task;      /* NULL in entry 0: before the scheduler and the tasks past MEM_MAX_TASKS */
+    uint8_t deleted;        /* 1: the task was deleted (task NULL), the entry is released with its last block */
+    uint32_t used;          /* Bytes allocated and not freed, pools included */
+    uint32_t peak;          /* Highest used */
+    uint32_t allocs;        /* Successful allocations */
+    uint32_t fails;         /* Allocations the heap could not serve */
+} my_mem_stat_t;
+
+/* Fixed-size pool, created by the task that uses it */
+typedef struct
+{
+    uint8_t *base;          /* Blocks, one allocation of the heap */
+    void *free;             /* Free blocks, linked through their first word */
+    uint16_t size;          /* Block size, multiple of 8 */
+    uint16_t count;         /* Blocks */
+    uint16_t used;          /* Blocks taken */
+    uint16_t peak;          /* Highest used */
+    uint32_t spills;        /* Blocks taken from the heap because the pool was empty */
+} my_pool_t;
 
 
 void my_mem_init(uint8_t memx);
 uint16_t my_mem_perused(uint8_t memx) ;
 void my_mem_set(void *s, uint8_t c, uint32_t count);
 void my_mem_copy(void *des, void *src, uint32_t n);
+uint8_t my_mem_get_stat(uint8_t index, my_mem_stat_t *stat);
+void my_mem_task_delete(void *task);                        /* traceTASK_DELETE, see FreeRTOSConfig.h */
 
 void myfree(uint8_t memx, void *ptr);
 void *mymalloc(uint8_t memx, uint32_t size);
 void *myrealloc(uint8_t memx, void *ptr, uint32_t size);
 
-#endif
-
-
-
-
-
-
-
-
-
-
-
-
+uint8_t my_pool_create(my_pool_t *pool, uint16_t size, uint16_t count);
+void my_pool_delete(my_pool_t *pool);
+void *my_pool_alloc(my_pool_t *pool);
+void my_pool_free(my_pool_t *pool, void *ptr);
 
+#endif
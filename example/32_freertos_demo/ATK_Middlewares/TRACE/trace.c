@@ -0,0 +1,398 @@
+/**
+ ****************************************************************************************************
+ * @file        trace.c
+ * @author      ALIENTEK
+ * @brief       FreeRTOS trace recorder: task switches, queues and interrupts in a RAM ring, streamed on UART
+ *
+ *              The hooks of trace.h write 8-byte records in a ring. Any task or interrupt may write,
+ *              so a record is reserved and filled with the interrupts disabled, about 30 cycles. A
+ *              full ring drops the new records and counts them, a LOST record tells the host later.
+ *
+ *              The trace task (lowest priority above idle) wakes up every TRACE_PERIOD_MS, copies the
+ *              records into a packet and sends it by DMA while it blocks. printf keeps working: a
+ *              character waits for the end of the packet. tools/trace_convert.py turns the capture into
+ *              a timeline (chrome://tracing, Perfetto) and per-task load tables.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     a tick between two packets: a printf waiting for the UART goes first
+ *
+ ****************************************************************************************************
+ */
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "trace.h"
+#include "../LPIDLE/lpidle.h"
+
+
+static uint32_t g_trace_cyc_last = 0;
+static uint32_t g_trace_cyc_high = 0;
+
+/**
+ * @brief   Starts the DWT cycle counter
+ * @param   None
+ * @retval  None
+ */
+void trace_cycles_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief   Run time stats counter (portGET_RUN_TIME_COUNTER_VALUE)
+ * @note    The cycle counter is extended to 64 bits, it must be read once per wrap (60s at 72MHz):
+ *          each task switch does. The time in STOP is not counted.
+ * @param   None
+ * @retval  Cycles / 1024
+ */
+uint32_t trace_runtime(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t cyc;
+
+    __disable_irq();
+    cyc = DWT->CYCCNT;
+
+    if (cyc < g_trace_cyc_last)g_trace_cyc_high++;
+
+    g_trace_cyc_last = cyc;
+    __set_PRIMASK(primask);
+
+    return (g_trace_cyc_high << 22) | (cyc >> 10);
+}
+
+#if TRACE_ENABLE
+
+#define TRACE_HEAD_SIZE                 8
+
+typedef struct
+{
+    uint8_t type;                       /* TRACE_EVT_NAME_TASK or TRACE_EVT_NAME_QUEUE */
+    uint8_t id;
+    char name[TRACE_NAME_LEN];
+} trace_name_t;
+
+static trace_rec_t g_trace_ring[TRACE_BUF_SIZE];
+static volatile uint16_t g_trace_head = 0;      /* Written with the interrupts disabled */
+static volatile uint16_t g_trace_tail = 0;      /* Written by the trace task only */
+static volatile uint32_t g_trace_pending = 0;   /* Dropped, not reported yet */
+volatile uint32_t g_trace_lost = 0;
+
+static uint8_t g_trace_on = 0;
+static trace_name_t g_trace_names[TRACE_MAX_NAMES];
+static uint8_t g_trace_nnames = 0;
+static uint8_t g_trace_queues = 0;
+
+static UART_HandleTypeDef *g_trace_huart;
+static TaskHandle_t g_trace_task;
+static StaticTask_t g_trace_tcb;
+static StackType_t g_trace_stack[TRACE_TASK_STACK];
+static uint8_t g_trace_tx[TRACE_HEAD_SIZE + TRACE_PACKET_MAX * sizeof(trace_rec_t)];
+static uint16_t g_trace_seq = 0;
+
+/**
+ * @brief   Writes one record
+ * @param   type : TRACE_EVT_xxx
+ * @param   id : task, queue or exception number
+ * @param   arg : depends on the type
+ * @param   time : time field
+ * @retval  None
+ */
+static void trace_write(uint8_t type, uint8_t id, uint16_t arg, uint32_t time)
+{
+    uint32_t primask;
+    uint16_t head;
+    uint16_t need;
+    trace_rec_t *r;
+
+    if (g_trace_on == 0)return;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    head = g_trace_head;
+    need = g_trace_pending ? 2 : 1;
+
+    if ((uint16_t)(TRACE_BUF_SIZE - (uint16_t)(head - g_trace_tail)) < need)
+    {
+        g_trace_pending++;
+        g_trace_lost++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    if (g_trace_pending)
+    {
+        r = &g_trace_ring[head++ & (TRACE_BUF_SIZE - 1)];
+        r->time = DWT->CYCCNT;
+        r->type = TRACE_EVT_LOST;
+        r->id = 0;
+        r->arg = g_trace_pending > 0xFFFF ? 0xFFFF : g_trace_pending;
+        g_trace_pending = 0;
+    }
+
+    r = &g_trace_ring[head++ & (TRACE_BUF_SIZE - 1)];
+    r->time = time;
+    r->type = type;
+    r->id = id;
+    r->arg = arg;
+
+    g_trace_head = head;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief   One record, timed with the cycle counter
+ * @param   type : TRACE_EVT_xxx
+ * @param   id : task, queue or exception number
+ * @param   arg : depends on the type
+ * @retval  None
+ */
+void trace_put(uint8_t type, uint8_t id, uint16_t arg)
+{
+    trace_write(type, id, arg, DWT->CYCCNT);
+}
+
+/**
+ * @brief   SYNC record: the tick count at this cycle count
+ * @param   None
+ * @retval  None
+ */
+void trace_sync(void)
+{
+    uint32_t tick = xTaskGetTickCount();
+
+    trace_put(TRACE_EVT_SYNC, (tick >> 16) & 0xFF, tick & 0xFFFF);
+}
+
+/**
+ * @brief   Writes the records of a name, 4 characters in each
+ * @param   n : name
+ * @retval  None
+ */
+static void trace_put_name(const trace_name_t *n)
+{
+    uint32_t chars;
+    uint8_t i;
+
+    for (i = 0; i < TRACE_NAME_LEN; i += 4)
+    {
+        memcpy(&chars, &n->name[i], 4);
+        trace_write(n->type, n->id, i, chars);
+
+        if (memchr(&n->name[i], 0, 4))break;
+    }
+}
+
+/**
+ * @brief   Keeps a name for the periodic resend and writes it
+ * @param   type : TRACE_EVT_NAME_TASK or TRACE_EVT_NAME_QUEUE
+ * @param   id : task or queue number
+ * @param   name : name
+ * @retval  None
+ */
+static void trace_add_name(uint8_t type, uint8_t id, const char *name)
+{
+    trace_name_t *n = NULL;
+    uint8_t i;
+
+    for (i = 0; i < g_trace_nnames; i++)        /* A deleted task may come back with the same number */
+    {
+        if (g_trace_names[i].type == type && g_trace_names[i].id == id)n = &g_trace_names[i];
+    }
+
+    if (n == NULL)
+    {
+        if (g_trace_nnames >= TRACE_MAX_NAMES)return;
+
+        n = &g_trace_names[g_trace_nnames++];
+    }
+
+    memset(n->name, 0, TRACE_NAME_LEN);
+    strncpy(n->name, name, TRACE_NAME_LEN);
+    n->type = type;
+    n->id = id;
+    trace_put_name(n);
+}
+
+/**
+ * @brief   traceTASK_CREATE
+ * @param   id : task number
+ * @param   name : task name
+ * @retval  None
+ */
+void trace_task_create(uint32_t id, const char *name)
+{
+    trace_put(TRACE_EVT_TASK_CREATE, id, 0);
+    trace_add_name(TRACE_EVT_NAME_TASK, id, name);
+}
+
+/**
+ * @brief   traceQUEUE_CREATE: numbers the queue (also semaphores and mutexes)
+ * @param   type : queueQUEUE_TYPE_xxx
+ * @retval  Queue number, 1 ~ 255
+ */
+uint32_t trace_queue_create(uint8_t type)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint8_t id;
+
+    __disable_irq();
+
+    if (++g_trace_queues == 0)g_trace_queues = 1;
+
+    id = g_trace_queues;
+    __set_PRIMASK(primask);
+
+    trace_put(TRACE_EVT_QUEUE_CREATE, id, type);
+    return id;
+}
+
+/**
+ * @brief   traceQUEUE_REGISTRY_ADD: the queue has a name
+ * @param   id : queue number
+ * @param   name : name
+ * @retval  None
+ */
+void trace_queue_name(uint32_t id, const char *name)
+{
+    if (name)trace_add_name(TRACE_EVT_NAME_QUEUE, id, name);
+}
+
+/**
+ * @brief   Copies records into the packet
+ * @param   end : head of the ring when the send started
+ * @retval  Bytes of the packet, 0: nothing to send
+ */
+static uint16_t trace_fill(uint16_t end)
+{
+    uint16_t tail = g_trace_tail;
+    uint16_t n = end - tail;
+    uint16_t sum = 0;
+    uint16_t i, len;
+
+    if (n == 0)return 0;
+
+    if (n > TRACE_PACKET_MAX)n = TRACE_PACKET_MAX;
+
+    for (i = 0; i < n; i++)
+    {
+        memcpy(&g_trace_tx[TRACE_HEAD_SIZE + i * sizeof(trace_rec_t)], &g_trace_ring[(tail + i) & (TRACE_BUF_SIZE - 1)], sizeof(trace_rec_t));
+    }
+
+    __DMB();                            /* Copied before the producers can reuse the slots */
+    g_trace_tail = tail + n;
+
+    len = n * sizeof(trace_rec_t);
+
+    for (i = 0; i < len; i++)sum += g_trace_tx[TRACE_HEAD_SIZE + i];
+
+    g_trace_tx[0] = 0xA5;
+    g_trace_tx[1] = 0x5A;
+    g_trace_tx[2] = n & 0xFF;
+    g_trace_tx[3] = n >> 8;
+    g_trace_tx[4] = g_trace_seq & 0xFF;
+    g_trace_tx[5] = g_trace_seq >> 8;
+    g_trace_tx[6] = sum & 0xFF;
+    g_trace_tx[7] = sum >> 8;
+    g_trace_seq++;
+
+    return TRACE_HEAD_SIZE + len;
+}
+
+/**
+ * @brief   Sends the packet by DMA and waits for its end
+ * @param   len : bytes
+ * @retval  None
+ */
+static void trace_send(uint16_t len)
+{
+    lpidle_stop_lock();                 /* The UART needs its clock until the last byte */
+    ulTaskNotifyTake(pdTRUE, 0);        /* A late end of a packet that timed out */
+
+    while (HAL_UART_Transmit_DMA(g_trace_huart, g_trace_tx, len) != HAL_OK)
+    {
+        vTaskDelay(1);                  /* printf is sending */
+    }
+
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TRACE_PERIOD_MS * 2));
+    lpidle_stop_unlock();
+}
+
+/**
+ * @brief   End of a DMA transmission
+ * @param   huart : UART handle
+ * @retval  None
+ */
+void trace_tx_done(UART_HandleTypeDef *huart)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (huart != g_trace_huart || g_trace_task == NULL)return;
+
+    vTaskNotifyGiveFromISR(g_trace_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/**
+ * @brief   Trace task: sends what the ring holds every TRACE_PERIOD_MS
+ * @param   arg : not used
+ * @retval  None
+ */
+static void trace_task(void *arg)
+{
+    TickType_t names = xTaskGetTickCount();
+    uint16_t end, len;
+    uint8_t i;
+
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(TRACE_PERIOD_MS));
+
+        if (xTaskGetTickCount() - names >= pdMS_TO_TICKS(TRACE_NAMES_MS))
+        {
+            names = xTaskGetTickCount();
+
+            for (i = 0; i < g_trace_nnames; i++)trace_put_name(&g_trace_names[i]);
+        }
+
+        trace_sync();                   /* The cycle counter wraps every minute */
+        end = g_trace_head;             /* Only up to here: sending makes new records */
+
+        while ((len = trace_fill(end)) != 0)
+        {
+            trace_send(len);
+            vTaskDelay(1);              /* A printf waiting for the UART goes first: its polling fills the ring */
+        }
+    }
+}
+
+/**
+ * @brief   Starts recording and creates the trace task
+ * @note    Call it before the tasks are created, to record their names
+ * @param   huart : UART of the stream, with a DMA transmit channel
+ * @retval  None
+ */
+void trace_init(UART_HandleTypeDef *huart)
+{
+    g_trace_huart = huart;
+    trace_cycles_init();
+    g_trace_on = 1;
+    trace_sync();
+
+    g_trace_task = xTaskCreateStatic(trace_task, "trace", TRACE_TASK_STACK, NULL, TRACE_TASK_PRIO, g_trace_stack, &g_trace_tcb);
+}
+
+#endif
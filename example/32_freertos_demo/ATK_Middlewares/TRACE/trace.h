@@ -0,0 +1,146 @@
+/**
+ ****************************************************************************************************
+ * @file        trace.h
+ * @author      ALIENTEK
+ * @brief       FreeRTOS trace recorder: task switches, queues and interrupts in a RAM ring, streamed on UART
+ *
+ *              FreeRTOSConfig.h includes this file, so the trace hooks below replace the empty ones of
+ *              FreeRTOS.h. They expand in tasks.c and queue.c, where the TCB and queue fields are known.
+ *
+ * @license     Copyright (C) 2012-2024, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK M144-STM32F103 board
+ * website      : www.alientek.com
+ * forum        : www.openedv.com/forum.php
+ *
+ * change logs  ：
+ * version      data         notes
+ * V1.0         20261019     the first version
+ * V1.1         20261019     traceTASK_DELETE calls TRACE_TASK_DELETE_HOOK, also without the recorder
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include "main.h"
+
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE                    1       /* 0: no hooks, no task, no RAM used */
+#endif
+
+#define TRACE_BUF_SIZE                  512     /* Records in the ring, must be a power of 2 (8 bytes each) */
+#define TRACE_PACKET_MAX                64      /* Records per packet */
+#define TRACE_PERIOD_MS                 50      /* The trace task sends the ring this often */
+#define TRACE_NAMES_MS                  2000    /* and all the names this often, for a host that connects late */
+#define TRACE_MAX_NAMES                 16      /* Tasks and registered queues */
+#define TRACE_NAME_LEN                  12      /* Characters kept of a name */
+#define TRACE_TASK_PRIO                 1       /* Just above idle: the trace does not delay the application */
+#define TRACE_TASK_STACK                160     /* Words */
+#define TRACE_TICKS                     0       /* 1: one record per tick */
+
+/* Record types */
+#define TRACE_EVT_SYNC                  0x01    /* time: cycles, id: tick bits 23..16, arg: tick bits 15..0 */
+#define TRACE_EVT_LOST                  0x02    /* arg: records dropped on a full ring before this one */
+#define TRACE_EVT_NAME_TASK             0x03    /* time: 4 characters, id: task, arg: offset of the characters */
+#define TRACE_EVT_NAME_QUEUE            0x04    /* time: 4 characters, id: queue, arg: offset of the characters */
+#define TRACE_EVT_TASK_CREATE           0x10    /* id: task number (uxTCBNumber) */
+#define TRACE_EVT_TASK_DELETE           0x11
+#define TRACE_EVT_TASK_IN               0x12    /* The task starts running */
+#define TRACE_EVT_TASK_OUT              0x13    /* The task stops running */
+#define TRACE_EVT_TASK_READY            0x14    /* The task is put in a ready list */
+#define TRACE_EVT_TICK                  0x15    /* arg: tick bits 15..0, TRACE_TICKS only */
+#define TRACE_EVT_IDLE_SLEEP            0x16    /* Tickless idle starts, arg: expected ticks; ends with a SYNC */
+#define TRACE_EVT_QUEUE_CREATE          0x20    /* id: queue number, arg: queueQUEUE_TYPE_xxx */
+#define TRACE_EVT_QUEUE_SEND            0x21    /* Queue types, arg: messages waiting before the operation */
+#define TRACE_EVT_QUEUE_SEND_FAIL       0x22
+#define TRACE_EVT_QUEUE_RECV            0x23
+#define TRACE_EVT_QUEUE_RECV_FAIL       0x24
+#define TRACE_EVT_QUEUE_BLOCK_SEND      0x25    /* The running task blocks on the queue */
+#define TRACE_EVT_QUEUE_BLOCK_RECV      0x26
+#define TRACE_EVT_QUEUE_SEND_ISR        0x27
+#define TRACE_EVT_QUEUE_RECV_ISR        0x28
+#define TRACE_EVT_ISR_ENTER             0x30    /* id: exception number (IRQn + 16) */
+#define TRACE_EVT_ISR_EXIT              0x31
+#define TRACE_EVT_USER                  0x40    /* trace_mark: id and arg chosen by the application */
+
+/*
+ * One record, 8 bytes. time is the DWT cycle counter, which stops in STOP (and maybe in SLEEP): the
+ * SYNC records give the tick count at a cycle count, the host adds up the cycles from the last one.
+ * The packets on the UART: A5 5A, records (2 bytes), sequence (2 bytes), sum of the record bytes
+ * (2 bytes), then the records. The text of printf goes between the packets.
+ */
+typedef struct
+{
+    uint32_t time;
+    uint8_t type;
+    uint8_t id;
+    uint16_t arg;
+} trace_rec_t;
+
+/* Run time stats (configGENERATE_RUN_TIME_STATS), also without the recorder */
+void trace_cycles_init(void);
+uint32_t trace_runtime(void);                               /* Cycles / 1024, wraps after 17 hours awake */
+
+/*
+ * FreeRTOS has one traceTASK_DELETE: another user of it (mymalloc) defines TRACE_TASK_DELETE_HOOK(t)
+ * before this file is included, and the hook below calls it after the record
+ */
+#ifndef TRACE_TASK_DELETE_HOOK
+#define TRACE_TASK_DELETE_HOOK(t)
+#endif
+
+#if TRACE_ENABLE
+
+extern volatile uint32_t g_trace_lost;                      /* Records dropped on a full ring */
+
+void trace_init(UART_HandleTypeDef *huart);                 /* Before the scheduler: starts recording and the trace task */
+void trace_put(uint8_t type, uint8_t id, uint16_t arg);     /* One record, from any context */
+void trace_sync(void);                                      /* SYNC record */
+void trace_task_create(uint32_t id, const char *name);
+uint32_t trace_queue_create(uint8_t type);                  /* Returns the queue number */
+void trace_queue_name(uint32_t id, const char *name);
+void trace_tx_done(UART_HandleTypeDef *huart);              /* From HAL_UART_TxCpltCallback */
+
+#define trace_mark(id, arg)                     trace_put(TRACE_EVT_USER, (id), (arg))
+#define TRACE_ISR_ENTER()                       trace_put(TRACE_EVT_ISR_ENTER, __get_IPSR(), 0)
+#define TRACE_ISR_EXIT()                        trace_put(TRACE_EVT_ISR_EXIT, __get_IPSR(), 0)
+
+/* FreeRTOS hooks */
+#define traceTASK_CREATE(t)                     trace_task_create((t)->uxTCBNumber, (t)->pcTaskName)
+#define traceTASK_DELETE(t)                     do { trace_put(TRACE_EVT_TASK_DELETE, (t)->uxTCBNumber, 0); TRACE_TASK_DELETE_HOOK(t); } while (0)
+#define traceTASK_SWITCHED_IN()                 trace_put(TRACE_EVT_TASK_IN, pxCurrentTCB->uxTCBNumber, 0)
+#define traceTASK_SWITCHED_OUT()                trace_put(TRACE_EVT_TASK_OUT, pxCurrentTCB->uxTCBNumber, 0)
+#define traceMOVED_TASK_TO_READY_STATE(t)       trace_put(TRACE_EVT_TASK_READY, (t)->uxTCBNumber, 0)
+#define traceLOW_POWER_IDLE_BEGIN()             trace_put(TRACE_EVT_IDLE_SLEEP, 0, xExpectedIdleTime > 0xFFFF ? 0xFFFF : xExpectedIdleTime)
+#define traceLOW_POWER_IDLE_END()               trace_sync()
+#if TRACE_TICKS
+#define traceTASK_INCREMENT_TICK(t)             trace_put(TRACE_EVT_TICK, 0, (t) + 1)
+#endif
+
+#define traceQUEUE_CREATE(q)                    (q)->uxQueueNumber = trace_queue_create((q)->ucQueueType)
+#define traceQUEUE_REGISTRY_ADD(q, name)        trace_queue_name(((Queue_t *)(q))->uxQueueNumber, (name))
+#define traceQUEUE_SEND(q)                      trace_put(TRACE_EVT_QUEUE_SEND, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FAILED(q)               trace_put(TRACE_EVT_QUEUE_SEND_FAIL, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE(q)                   trace_put(TRACE_EVT_QUEUE_RECV, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FAILED(q)            trace_put(TRACE_EVT_QUEUE_RECV_FAIL, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_SEND(q)          trace_put(TRACE_EVT_QUEUE_BLOCK_SEND, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+#define traceBLOCKING_ON_QUEUE_RECEIVE(q)       trace_put(TRACE_EVT_QUEUE_BLOCK_RECV, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+#define traceQUEUE_SEND_FROM_ISR(q)             trace_put(TRACE_EVT_QUEUE_SEND_ISR, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+#define traceQUEUE_RECEIVE_FROM_ISR(q)          trace_put(TRACE_EVT_QUEUE_RECV_ISR, (q)->uxQueueNumber, (q)->uxMessagesWaiting)
+
+#else
+
+#define trace_mark(id, arg)
+#define TRACE_ISR_ENTER()
+#define TRACE_ISR_EXIT()
+
+#define traceTASK_DELETE(t)                     TRACE_TASK_DELETE_HOOK(t)
+
+#endif
+
+#endif
@@ -60,15 +60,17 @@
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)3072)
+#define configTOTAL_HEAP_SIZE                    ((size_t)40960)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_TRACE_FACILITY                 1
+#define configGENERATE_RUN_TIME_STATS            1
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
 #define configUSE_RECURSIVE_MUTEXES              1
 #define configUSE_COUNTING_SEMAPHORES            1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
+#define configUSE_TICKLESS_IDLE                  1
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES                    0
@@ -142,8 +144,35 @@ standard names. */
 
 #define xPortSysTickHandler SysTick_Handler
 
+/* USER CODE BEGIN 2 */
+/* Definitions needed when configGENERATE_RUN_TIME_STATS is on */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE getRunTimeCounterValue
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  void configureTimerForRunTimeStats(void);
+  unsigned long getRunTimeCounterValue(void);
+#endif
+/* USER CODE END 2 */
+
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Tickless idle: lpidle.c chooses SLEEP (the port's own tickless sleep) or STOP (RTC alarm) */
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP    2
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  void lpidle_suppress_ticks(uint32_t expected);
+#endif
+#define portSUPPRESS_TICKS_AND_SLEEP(x)          lpidle_suppress_ticks(x)
+
+/* mymalloc releases the usage entry of a deleted task (malloc.c), from traceTASK_DELETE of trace.h */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  void my_mem_task_delete(void *task);
+#endif
+#define TRACE_TASK_DELETE_HOOK(t)                my_mem_task_delete(t)
+
+/* Trace recorder hooks (traceTASK_SWITCHED_IN...), switched by TRACE_ENABLE in trace.h */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  #include "../../ATK_Middlewares/TRACE/trace.h"
+#endif
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
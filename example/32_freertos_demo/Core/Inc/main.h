@@ -41,7 +41,7 @@ extern "C" {
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
-
+#define SYS_SUPPORT_OS  1               /* delay.c (libraries/Drivers/SYSTEM/delay): delay_ms in a task calls vTaskDelay */
 /* USER CODE END EC */
 
 /* Exported macro ------------------------------------------------------------*/
@@ -27,6 +27,9 @@
 /* USER CODE BEGIN Includes */
 #include "led.h"
 #include "usart.h"
+#include "../../ATK_Middlewares/LPIDLE/lpidle.h"
+#include "../../ATK_Middlewares/MALLOC/malloc.h"
+#include "../../ATK_Middlewares/TRACE/trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -73,6 +76,23 @@ void mytask02(void *argument);
 
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
+/* Hook prototypes */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+void configureTimerForRunTimeStats(void)
+{
+  trace_cycles_init();                /* DWT cycle counter */
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return trace_runtime();             /* Cycles / 1024: 70kHz, does not wrap for 17 hours */
+}
+/* USER CODE END 1 */
+
 /**
   * @brief  FreeRTOS initialization
   * @param  None
@@ -127,9 +147,22 @@ void mytask01(void *argument)
 {
   /* USER CODE BEGIN mytask01 */
   /* Infinite loop */
+	my_pool_t pool;
+	uint8_t *blk;
+	uint8_t pool_ok = 1;
+	if (my_pool_create(&pool, 32, 4) != 0)          /* Blocks of this task, charged to it */
+	{
+		pool_ok = 0;                                /* No memory: only the LED */
+		printf("task01: no memory for the pool\r\n");
+	}
 	while(1)
     {
 		LED0_TOGGLE();
+		if (pool_ok)
+		{
+			blk = my_pool_alloc(&pool);             /* No heap search, no scheduler lock */
+			my_pool_free(&pool, blk);
+		}
 	    vTaskDelay(1000);
     }
   /* USER CODE END mytask01 */
@@ -147,10 +180,36 @@ void mytask02(void *argument)
   /* USER CODE BEGIN mytask02 */
   /* Infinite loop */
 	float num_float = 0.0;
+	uint32_t n = 0;
+	lpidle_stat_t stat;
+	my_mem_stat_t mem;
+	uint32_t total;
+	uint8_t i;
 	while(1)
 	{
 		num_float += 0.01;
 		printf("num_float:%.2f\r\n",num_float);
+
+		if (++n % 10 == 0)                          /* Idle residency and memory every 5s */
+		{
+			lpidle_get_stat(&stat);
+			total = xTaskGetTickCount() - stat.since;
+			printf("run:%lums sleep:%lums(%lu) stop:%lums(%lu) abort:%lu, stop %.1f%%\r\n",
+			       total - stat.sleep_ms - stat.stop_ms, stat.sleep_ms, stat.sleeps,
+			       stat.stop_ms, stat.stops, stat.aborts, total ? stat.stop_ms * 100.0f / total : 0.0f);
+			printf("heap:%d.%d%% min free:%uB\r\n", my_mem_perused(SRAMIN) / 10, my_mem_perused(SRAMIN) % 10,
+			       xPortGetMinimumEverFreeHeapSize());
+
+			for (i = 0; i < MEM_MAX_TASKS; i++)     /* mymalloc and pools of each task */
+			{
+				if (my_mem_get_stat(i, &mem) == 0)
+				{
+					printf("  %s: %luB peak:%luB allocs:%lu fails:%lu\r\n", mem.deleted ? "(deleted)" : mem.task ? pcTaskGetName(mem.task) : "main",
+					       mem.used, mem.peak, mem.allocs, mem.fails);
+				}
+			}
+		}
+
 		vTaskDelay(500);
 	}
   /* USER CODE END mytask02 */
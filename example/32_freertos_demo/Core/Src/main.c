@@ -15,6 +15,9 @@
  * change logs  :
  * version      data         notes
  * V1.0         20240410     the first version
+ * V1.1         20261019     tickless idle in SLEEP or STOP (lpidle)
+ * V1.2         20261019     trace recorder streamed on USART1 DMA
+ * V1.3         20261019     mymalloc from the FreeRTOS heap, per-task memory usage
  *
  ****************************************************************************************************
  */
@@ -22,6 +25,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "cmsis_os.h"
+#include "dma.h"
 #include "usart.h"
 #include "gpio.h"
 #include "fsmc.h"
@@ -32,6 +36,8 @@
 #include "../../BSP/KEY/key.h"
 #include "../../BSP/LCD/lcd.h"
 #include "../../ATK_Middlewares/MALLOC/malloc.h"
+#include "../../ATK_Middlewares/LPIDLE/lpidle.h"
+#include "../../ATK_Middlewares/TRACE/trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -95,16 +101,26 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_FSMC_Init();
   /* USER CODE BEGIN 2 */
 
   lcd_init();
-  my_mem_init(SRAMIN);                /* Initialize the internal SRAM memory pool */
+  my_mem_init(SRAMIN);                /* Clears the usage per task, the memory is the FreeRTOS heap */
   lcd_show_string(30, 50, 200, 16, 16, "STM32", RED);
   lcd_show_string(30, 70, 200, 16, 16, "FreeRTOS TEST", RED);
   lcd_show_string(30, 90, 200, 16, 16, "ATOM@ALIENTEK", RED);
 
+  if (lpidle_init() != 0)             /* RTC for the STOP mode of the idle task */
+  {
+    printf("LSE failed, idle in SLEEP only\r\n");
+  }
+
+#if TRACE_ENABLE
+  trace_init(&huart1);                /* Before the tasks are created: their names are recorded */
+#endif
+
   /* USER CODE END 2 */
 
   /* Init scheduler */
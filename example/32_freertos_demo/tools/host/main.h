@@ -0,0 +1,215 @@
+/**
+ ****************************************************************************************************
+ * @file        main.h
+ * @author      ALIENTEK
+ * @brief       main.h of the host builds: PRIMASK and IPSR, the DWT cycle counter and the UART of trace.c
+ *
+ *              tools/mem_stress.c: each thread is a task on one core. __disable_irq takes one lock
+ *              shared by all the threads, so a section with the interrupts disabled runs alone as on
+ *              the board.
+ *              tools/trace_run.c: the real kernel on port.c, the registers below are updated by the
+ *              simulated clock and HAL_UART_Transmit_DMA puts the bytes in the capture.
+ *              tools/lpidle_sim.c: lpidle.c alone, RCC, RTC and SysTick follow the simulated time at
+ *              each access to their marked registers.
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ * V1.1         20261019    DWT, CoreDebug and UART DMA transmit for tools/trace_run.c
+ * V1.2         20261019    RCC, RTC, EXTI, SysTick, SCB, PWR and the HAL tick for tools/lpidle_sim.c
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_IPSR(void);
+
+#define __DMB()                         __sync_synchronize()
+
+/* DWT cycle counter: counts with TRCENA and CYCCNTENA set, not in STOP */
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type g_sim_dwt;
+extern CoreDebug_Type g_sim_coredebug;
+
+#define DWT                             (&g_sim_dwt)
+#define CoreDebug                       (&g_sim_coredebug)
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+typedef enum
+{
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    uint32_t BaudRate;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+
+/******************************************************************************************/
+/* lpidle.c: RCC, RTC, EXTI, SysTick, SCB, PWR, HAL tick */
+
+/* An access to a marked register first brings its peripheral to the simulated time (tools/lpidle_sim.c) */
+uint32_t host_rcc_access(void);
+uint32_t host_rtc_access(void);
+uint32_t host_systick_access(void);
+#define CR                              cr[host_rcc_access()]
+#define CFGR                            cfgr[host_rcc_access()]
+#define CRL                             crl[host_rtc_access()]
+#define CNTH                            cnth[host_rtc_access()]
+#define CNTL                            cntl[host_rtc_access()]
+#define DIVL                            divl[host_rtc_access()]
+#define VAL                             val[host_systick_access()]
+
+typedef struct
+{
+    volatile uint32_t cr[1];
+    volatile uint32_t cfgr[1];
+} RCC_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CRH;
+    volatile uint32_t crl[1];
+    volatile uint32_t PRLH;
+    volatile uint32_t PRLL;
+    volatile uint32_t divl[1];
+    volatile uint32_t cnth[1];
+    volatile uint32_t cntl[1];
+    volatile uint32_t ALRH;
+    volatile uint32_t ALRL;
+} RTC_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t IMR;
+    volatile uint32_t RTSR;
+    volatile uint32_t PR;
+} EXTI_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t LOAD;
+    volatile uint32_t val[1];
+} SysTick_Type;
+
+typedef struct
+{
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+extern RCC_TypeDef g_sim_rcc;
+extern RTC_TypeDef g_sim_rtc;
+extern EXTI_TypeDef g_sim_exti;
+extern SysTick_Type g_sim_systick;
+extern SCB_Type g_sim_scb;
+
+#define RCC                             (&g_sim_rcc)
+#define RTC                             (&g_sim_rtc)
+#define EXTI                            (&g_sim_exti)
+#define SysTick                         (&g_sim_systick)
+#define SCB                             (&g_sim_scb)
+
+#define RCC_CR_HSEON                    (1UL << 16)
+#define RCC_CR_HSERDY                   (1UL << 17)
+#define RCC_CR_PLLON                    (1UL << 24)
+#define RCC_CR_PLLRDY                   (1UL << 25)
+#define RCC_CFGR_SW                     (3UL << 0)
+#define RCC_CFGR_SW_PLL                 (2UL << 0)
+#define RCC_CFGR_SWS                    (3UL << 2)
+#define RCC_CFGR_SWS_PLL                (2UL << 2)
+#define RTC_CRH_ALRIE                   (1UL << 1)
+#define RTC_CRL_ALRF                    (1UL << 1)
+#define RTC_CRL_RSF                     (1UL << 3)
+#define RTC_CRL_CNF                     (1UL << 4)
+#define RTC_CRL_RTOFF                   (1UL << 5)
+#define EXTI_IMR_MR17                   (1UL << 17)
+#define EXTI_RTSR_TR17                  (1UL << 17)
+#define EXTI_PR_PR17                    (1UL << 17)
+#define SysTick_CTRL_ENABLE_Msk         (1UL << 0)
+#define SCB_ICSR_PENDSTSET_Msk          (1UL << 26)
+
+#define HSI_VALUE                       8000000U
+
+typedef struct
+{
+    uint32_t PLLState;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+    uint32_t OscillatorType;
+    uint32_t LSEState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+    uint32_t PeriphClockSelection;
+    uint32_t RTCClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_LSE          0x00000004U
+#define RCC_LSE_ON                      0x00000001U
+#define RCC_PLL_NONE                    0x00000000U
+#define RCC_PERIPHCLK_RTC               0x00000001U
+#define RCC_RTCCLKSOURCE_LSE            0x00000100U
+#define PWR_LOWPOWERREGULATOR_ON        0x00000001U
+#define PWR_STOPENTRY_WFI               0x01U
+
+#define __HAL_RCC_PWR_CLK_ENABLE()      ((void)0)
+#define __HAL_RCC_BKP_CLK_ENABLE()      ((void)0)
+#define __HAL_RCC_RTC_ENABLE()          ((void)0)
+
+typedef enum
+{
+    RTC_Alarm_IRQn = 41
+} IRQn_Type;
+
+extern uint32_t SystemCoreClock;
+extern volatile uint32_t uwTick;
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+void HAL_PWR_EnableBkUpAccess(void);
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_SuspendTick(void);
+void HAL_ResumeTick(void);
+void Error_Handler(void);
+
+#endif
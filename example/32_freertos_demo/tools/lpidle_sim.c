@@ -0,0 +1,446 @@
+/**
+ ****************************************************************************************************
+ * @file        lpidle_sim.c
+ * @author      ALIENTEK
+ * @brief       The STOP idle of ATK_Middlewares/LPIDLE/lpidle.c on a Linux host, against simulated time
+ *
+ *              lpidle.c runs alone, the kernel calls it uses are stubs. The time passes at each access to
+ *              the RCC, RTC and SysTick registers marked in tools/host/main.h, and in STOP: the CPU wakes
+ *              up at the RTC alarm (LSE at 32768Hz, counter at LPIDLE_RTC_HZ), or earlier on another
+ *              EXTI line. STOP is left on HSI, HSE starts in 0.3 ~ 3ms and the PLL locks in 50 ~ 200us.
+ *              Between two idles the SysTick counts 0 ~ 20 ticks, the idle starts anywhere in a tick.
+ *
+ *              Checks, for each STOP:
+ *              - the clocks are back on the PLL, with the interrupts disabled until then; SystemClock_Config
+ *                is not called, its HAL timeouts do not move with PRIMASK set
+ *              - the tick count goes forward by the ticks slept, never past the expected idle time;
+ *                uwTick by as many ms
+ *              - the next SysTick interrupt comes within one LSE period (30.5us, plus the us rounding of
+ *                lpidle.c) of the tick it counts on the tick grid of before the STOP, and with the reload
+ *                of one tick after it
+ *              - over the STOPs the mean error stays within half an LSE period: the tick count does not
+ *                drift, also when the alarm ends each STOP on a count edge and HSE always takes 1.75ms
+ *              At the end, a STOP from which HSE does not start must reach Error_Handler after
+ *              LPIDLE_CLK_TIMEOUT_US, not hang.
+ *
+ *              Build, from example/32_freertos_demo:
+ *              gcc -O2 -Wall -IMiddlewares/Third_Party/FreeRTOS/Source/include -Itools/port -Itools/host
+ *                  -IATK_Middlewares/LPIDLE tools/lpidle_sim.c ATK_Middlewares/LPIDLE/lpidle.c -o lpidle_sim
+ *              Run:
+ *              ./lpidle_sim [-n stops] [-s seed]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <setjmp.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "lpidle.h"
+
+#define SIM_HCLK                72000000ULL         /* Clock on the PLL, SystemClock_Config */
+#define SIM_TICK_NS             (1000000000ULL / configTICK_RATE_HZ)
+#define SIM_LSE_DIV             (32768 / LPIDLE_RTC_HZ)
+#define SIM_ERR_NS              (1000000000ULL / 32768 + 3000)  /* One LSE period and the us rounding */
+
+#define CHECK(c, ...) do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+RCC_TypeDef g_sim_rcc;
+RTC_TypeDef g_sim_rtc;
+EXTI_TypeDef g_sim_exti;
+SysTick_Type g_sim_systick;
+SCB_Type g_sim_scb;
+uint32_t SystemCoreClock = SIM_HCLK;
+volatile uint32_t uwTick = 0;
+
+static uint64_t g_now = 0;              /* Time, in ns */
+static uint64_t g_tick_last;            /* Time of the last SysTick interrupt */
+static TickType_t g_tick = 0;           /* Tick count of the kernel */
+static uint32_t g_rtc0;                 /* RTC counter at time 0 */
+static uint8_t g_on_pll = 1;            /* SYSCLK on the PLL, else on HSI */
+static uint64_t g_hse_on = 0;           /* Time HSEON was seen set, 0: off */
+static uint64_t g_pll_on = 0;           /* Time PLLON was seen set, 0: off */
+static uint64_t g_hse_start, g_pll_lock;
+static uint8_t g_hse_dead = 0;          /* HSE never starts */
+static uint64_t g_hse_fixed = 0;        /* HSE start-up time in ns, 0: random */
+static uint64_t g_val_at;               /* Last access to SysTick->VAL: time and LOAD then */
+static uint32_t g_load_at;
+static uint32_t g_primask = 0;
+static uint8_t g_hal_tick = 1;          /* TIM1 runs */
+static TickType_t g_expected;
+static jmp_buf g_error_jmp;
+static uint32_t g_fails = 0;
+
+/******************************************************************************************/
+/* Host CPU and HAL */
+
+uint32_t __get_PRIMASK(void)
+{
+    return g_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    g_primask = primask;
+}
+
+void __disable_irq(void)
+{
+    g_primask = 1;
+}
+
+void __enable_irq(void)
+{
+    g_primask = 0;
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+    return HAL_OK;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+}
+
+void HAL_SuspendTick(void)
+{
+    g_hal_tick = 0;
+}
+
+void HAL_ResumeTick(void)
+{
+    g_hal_tick = 1;
+}
+
+/**
+ * @brief     The clock restore of lpidle.c V1.0: its HAL_GetTick timeouts do not move with PRIMASK set
+ * @param     None
+ * @retval    None
+ */
+void SystemClock_Config(void)
+{
+    CHECK(g_primask == 0, "SystemClock_Config called with the interrupts disabled and TIM1 suspended");
+
+    RCC->cr[0] |= RCC_CR_HSEON | RCC_CR_HSERDY | RCC_CR_PLLON | RCC_CR_PLLRDY;
+    RCC->cfgr[0] = RCC_CFGR_SW_PLL | RCC_CFGR_SWS_PLL;
+    g_on_pll = 1;
+}
+
+/**
+ * @brief     Error_Handler of main.c, back to main
+ * @param     None
+ * @retval    None
+ */
+void Error_Handler(void)
+{
+    longjmp(g_error_jmp, 1);
+}
+
+/******************************************************************************************/
+/* Kernel */
+
+TickType_t xTaskGetTickCount(void)
+{
+    return g_tick;
+}
+
+eSleepModeStatus eTaskConfirmSleepModeStatus(void)
+{
+    return eStandardSleep;
+}
+
+void vTaskStepTick(TickType_t xTicksToJump)
+{
+    CHECK(g_primask == 1, "vTaskStepTick with the interrupts enabled");
+    CHECK(xTicksToJump < g_expected, "tick count stepped by %u, expected idle time %u", xTicksToJump, g_expected);
+    g_tick += xTicksToJump;
+}
+
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+    CHECK(0, "SLEEP for %u ticks, STOP expected", xExpectedIdleTime);
+}
+
+/******************************************************************************************/
+/* Clocks, RTC, SysTick, STOP */
+
+/**
+ * @brief     An access to RCC: a few clocks of the CPU pass, HSE, the PLL and the switch follow their time
+ * @param     None
+ * @retval    0, index of the register
+ */
+uint32_t host_rcc_access(void)
+{
+    uint32_t cr = RCC->cr[0];
+
+    g_now += (4 + rand() % 3) * (g_on_pll ? 1000000000ULL / SIM_HCLK : 1000000000ULL / HSI_VALUE);
+
+    if ((cr & RCC_CR_HSEON) && g_hse_on == 0)g_hse_on = g_now;
+
+    if ((cr & RCC_CR_PLLON) && g_pll_on == 0)g_pll_on = g_now;
+
+    if (g_hse_on && !g_hse_dead && g_now >= g_hse_on + g_hse_start)cr |= RCC_CR_HSERDY;
+
+    if ((cr & RCC_CR_HSERDY) && g_pll_on && g_now >= g_pll_on + g_pll_lock)cr |= RCC_CR_PLLRDY;
+
+    RCC->cr[0] = cr;
+
+    if ((RCC->cfgr[0] & RCC_CFGR_SW) == RCC_CFGR_SW_PLL && (cr & RCC_CR_PLLRDY))
+    {
+        RCC->cfgr[0] = (RCC->cfgr[0] & ~RCC_CFGR_SWS) | RCC_CFGR_SWS_PLL;
+        g_on_pll = 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief     An access to the RTC: the counter of the time, the registers synchronized and writable
+ * @param     None
+ * @retval    0, index of the register
+ */
+uint32_t host_rtc_access(void)
+{
+    uint64_t lse;
+    uint32_t cnt;
+
+    g_now += 2 * 1000000000ULL / SIM_HCLK;
+    lse = g_now * 32768 / 1000000000ULL;
+    cnt = g_rtc0 + (uint32_t)(lse / SIM_LSE_DIV);
+    RTC->cnth[0] = cnt >> 16;
+    RTC->cntl[0] = cnt & 0xFFFF;
+    RTC->divl[0] = SIM_LSE_DIV - 1 - lse % SIM_LSE_DIV;
+    RTC->crl[0] |= RTC_CRL_RSF | RTC_CRL_RTOFF;
+
+    return 0;
+}
+
+/**
+ * @brief     An access to SysTick->VAL: the current value, LOAD is noted for a write that restarts it
+ * @param     None
+ * @retval    0, index of the register
+ */
+uint32_t host_systick_access(void)
+{
+    uint64_t cycles = (g_now - g_tick_last) * SIM_HCLK / 1000000000ULL;
+
+    SysTick->val[0] = (cycles <= SysTick->LOAD) ? SysTick->LOAD - (uint32_t)cycles : 0;
+    g_val_at = g_now;
+    g_load_at = SysTick->LOAD;
+
+    return 0;
+}
+
+/**
+ * @brief     STOP until the RTC alarm, or earlier on another EXTI line. Left on HSI, HSE and PLL off.
+ * @param     Regulator : unused
+ * @param     STOPEntry : unused
+ * @retval    None
+ */
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+    uint32_t alarm = (RTC->ALRH << 16) | RTC->ALRL;
+    uint64_t wake = ((uint64_t)(alarm - g_rtc0) * SIM_LSE_DIV * 1000000000ULL + 32767) / 32768;
+
+    CHECK(g_primask == 1, "STOP with the interrupts enabled");
+    CHECK(g_hal_tick == 0, "STOP with TIM1 running");
+    CHECK(wake > g_now, "alarm %u already passed", alarm);
+
+    if (rand() % 4 == 0)                /* A key */
+    {
+        wake = g_now + 1 + (uint64_t)rand() * (wake - g_now) / RAND_MAX;
+    }
+
+    g_now = wake;
+    RCC->cr[0] = 0;
+    RCC->cfgr[0] = 0;
+    g_on_pll = 0;
+    g_hse_on = g_pll_on = 0;
+    g_hse_start = g_hse_fixed ? g_hse_fixed : 300000 + rand() % 2700000;
+    g_pll_lock = 50000 + rand() % 150000;
+}
+
+/******************************************************************************************/
+/* Idle */
+
+/**
+ * @brief     One idle of the idle task in STOP, then the checks
+ * @param     expected : ticks until the next task wakes up
+ * @param     err : error of the next tick to the grid, in ns, when the idle ends in the tick
+ * @retval    1, the wake-up was in the tick; 0, at or after the expected idle time
+ */
+static uint8_t sim_stop(TickType_t expected, int64_t *err)
+{
+    lpidle_stat_t st0, st1;
+    TickType_t tick0 = g_tick;
+    uint32_t ms0 = uwTick;
+    uint64_t grid = g_tick_last, next;
+    uint8_t pend;
+
+    g_expected = expected;
+    lpidle_get_stat(&st0);
+    lpidle_suppress_ticks(expected);
+    lpidle_get_stat(&st1);
+
+    CHECK(st1.stops == st0.stops + 1, "STOP of %u ticks not entered", expected);
+    CHECK(g_primask == 0 && g_hal_tick == 1, "interrupts %s, TIM1 %s after STOP",
+          g_primask ? "disabled" : "enabled", g_hal_tick ? "running" : "suspended");
+    CHECK(g_on_pll && (RCC->cr[0] & RCC_CR_PLLRDY), "SYSCLK not back on the PLL");
+    CHECK(SysTick->LOAD == SIM_HCLK / configTICK_RATE_HZ - 1, "SysTick reload %u after STOP", SysTick->LOAD);
+    CHECK(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk, "SysTick stopped after STOP");
+
+    pend = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+    SCB->ICSR = 0;
+
+    if (pend)                           /* The SysTick interrupt counts the last tick at once */
+    {
+        g_tick++;
+        CHECK(g_tick - tick0 == expected, "tick count +%u after a full STOP of %u ticks", g_tick - tick0, expected);
+    }
+
+    CHECK(g_tick - tick0 <= expected, "tick count +%u past the expected %u", g_tick - tick0, expected);
+    CHECK(uwTick - ms0 == (g_tick - tick0) * portTICK_PERIOD_MS, "uwTick +%u, tick count +%u",
+          uwTick - ms0, g_tick - tick0);
+
+    next = g_val_at + ((uint64_t)g_load_at + 1) * 1000000000ULL / SIM_HCLK;
+    *err = (int64_t)(next - (grid + (uint64_t)(g_tick - tick0 + 1) * SIM_TICK_NS));
+
+    if (!pend)
+    {
+        CHECK(*err <= (int64_t)SIM_ERR_NS && *err >= -(int64_t)SIM_ERR_NS,
+              "next tick %lld ns away from the grid", (long long)*err);
+    }
+
+    /* The next tick, then a few more before the next idle, which starts anywhere in its tick */
+    g_tick_last = next;
+    g_tick++;
+    uwTick++;
+    next = rand() % 21;
+    g_tick += next;
+    uwTick += next;
+    g_tick_last += next * SIM_TICK_NS;
+    g_now = g_tick_last + rand() % SIM_TICK_NS;
+
+    return !pend;
+}
+
+/**
+ * @brief     A series of STOPs, then the mean error of those that ended in their tick
+ * @param     n : STOPs
+ * @param     hse : HSE start-up time in ns, 0: random
+ * @retval    None
+ */
+static void sim_series(uint32_t n, uint64_t hse)
+{
+    uint32_t k, in_tick = 0;
+    int64_t err, sum = 0, mean;
+
+    g_hse_fixed = hse;
+
+    for (k = 0; k < n; k++)
+    {
+        if (setjmp(g_error_jmp))
+        {
+            CHECK(0, "Error_Handler with HSE running");
+            exit(1);
+        }
+
+        if (sim_stop(LPIDLE_STOP_MIN_TICKS + rand() % 200, &err))
+        {
+            in_tick++;
+            sum += err;
+        }
+    }
+
+    mean = in_tick ? sum / (int64_t)in_tick : 0;
+    CHECK(in_tick > n / 4, "%u STOPs of %u ended in their tick", in_tick, n);
+    CHECK(llabs(mean) < (int64_t)SIM_ERR_NS / 2, "HSE %s: mean error %lld ns, the tick count drifts",
+          hse ? "fixed" : "random", (long long)mean);
+
+    printf("HSE %s: %u STOPs, %u ended in their tick, mean error %lld ns\n", hse ? "fixed" : "random",
+           n, in_tick, (long long)mean);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n = 20000;
+    uint64_t t0;
+    int opt;
+
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': n = atoi(optarg); break;
+            case 's': srand(atoi(optarg)); break;
+            default:
+                fprintf(stderr, "usage: %s [-n stops] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    g_rtc0 = 0xFFFF0000 + rand() % 0x10000;     /* The counter wraps during the run */
+    SysTick->LOAD = SIM_HCLK / configTICK_RATE_HZ - 1;
+    SysTick->CTRL = SysTick_CTRL_ENABLE_Msk;
+    RCC->cr[0] = RCC_CR_HSEON | RCC_CR_HSERDY | RCC_CR_PLLON | RCC_CR_PLLRDY;
+    RCC->cfgr[0] = RCC_CFGR_SW_PLL | RCC_CFGR_SWS_PLL;
+
+    CHECK(lpidle_init() == 0, "lpidle_init failed");
+
+    g_tick_last = 0;
+    g_now = rand() % SIM_TICK_NS;
+
+    sim_series(n, 0);
+    sim_series(n, 1750000);
+
+    /* HSE does not start: Error_Handler after the timeout */
+    g_hse_dead = 1;
+    g_expected = 100;
+    t0 = 0;
+
+    if (setjmp(g_error_jmp) == 0)
+    {
+        lpidle_suppress_ticks(100);
+        CHECK(0, "STOP left without HSE");
+    }
+    else
+    {
+        t0 = g_now - g_hse_on;
+        CHECK(t0 >= LPIDLE_CLK_TIMEOUT_US * 1000ULL && t0 <= 2 * LPIDLE_CLK_TIMEOUT_US * 1000ULL,
+              "Error_Handler %llu us after HSEON", (unsigned long long)(t0 / 1000));
+    }
+
+    printf("HSE dead: Error_Handler after %llu us\n", (unsigned long long)(t0 / 1000));
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+
+    return g_fails ? 1 : 0;
+}
@@ -0,0 +1,639 @@
+/**
+ ****************************************************************************************************
+ * @file        mem_stress.c
+ * @author      ALIENTEK
+ * @brief       Stress of ATK_Middlewares/MALLOC/malloc.c with threads on a Linux host
+ *
+ *              Each thread is a task (tools/host: __disable_irq is one lock of all the threads). The heap
+ *              is heap_4.c of Middlewares/Third_Party/FreeRTOS, with configTOTAL_HEAP_SIZE bytes of
+ *              tools/port/FreeRTOSConfig.h: vTaskSuspendAll takes another lock shared by all the threads,
+ *              as the suspended scheduler keeps the other tasks out. MEM_STRESS_WORKERS threads run task after
+ *              task with the same TCB, as a new task gets the memory of a deleted one on the board:
+ *              - mymalloc, myfree and myrealloc of random sizes until the heap is full, a pool of
+ *                4 blocks that spills to the heap, blocks given to a collector task that frees them
+ *                later, sometimes after the task is deleted.
+ *              - Before the task is deleted, its entry must hold exactly its allocations, failures
+ *                and the bytes not freed yet (when the table was full at one of its allocations,
+ *                that one went to entry 0 and the task is not checked). Then my_mem_task_delete
+ *                runs as traceTASK_DELETE (interrupts disabled): no entry may keep the task.
+ *              - A thread with IPSR set takes blocks of a pool created before the scheduler: an
+ *                empty pool must give NULL, never a block of the heap.
+ *              - At the end every entry of a task is free again, entry 0 (main) is back to 0 bytes, the
+ *                heap has all its bytes free again in one block, and no block was overwritten.
+ *
+ *              Build, from example/32_freertos_demo:
+ *              gcc -O2 -Wall -pthread -IMiddlewares/Third_Party/FreeRTOS/Source/include -Itools/port -Itools/host
+ *                  tools/mem_stress.c ATK_Middlewares/MALLOC/malloc.c
+ *                  Middlewares/Third_Party/FreeRTOS/Source/portable/MemMang/heap_4.c -o mem_stress
+ *              Run:
+ *              ./mem_stress [-s seed]
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ * V1.1         20261019    runs on heap_4.c of FreeRTOS instead of the malloc of the C library
+ *
+ ****************************************************************************************************
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "../ATK_Middlewares/MALLOC/malloc.h"
+
+#define MEM_STRESS_WORKERS      4       /* Tasks at the same time, plus the collector */
+#define MEM_STRESS_TASKS        250     /* Tasks run by each worker */
+#define MEM_STRESS_OPS          300     /* Operations of a task */
+#define MEM_STRESS_BLOCKS       16      /* Blocks a task holds */
+#define MEM_STRESS_QUEUE        64      /* Blocks waiting for the collector */
+
+#define CHECK(c, ...) do{ if (!(c)){ pthread_mutex_lock(&g_print_lock); printf("FAIL: " __VA_ARGS__); printf("\n"); pthread_mutex_unlock(&g_print_lock); if (__sync_add_and_fetch(&g_fails, 1) > 20)exit(1); } }while(0)
+
+struct tskTaskControlBlock
+{
+    uint32_t number;
+};
+
+/* What a task really did, charged to its entry */
+typedef struct
+{
+    uint32_t allocs;
+    uint32_t fails;
+    uint32_t used;          /* Changed with the interrupts disabled, as the entry */
+    uint8_t in_main;        /* 1: the table was full at an allocation, charged to entry 0 */
+} truth_t;
+
+/* Head of the data of each block, to check it and free it anywhere */
+typedef struct
+{
+    truth_t *owner;
+    uint32_t size;
+    uint32_t fill;
+} blk_t;
+
+static pthread_mutex_t g_print_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread uint32_t t_primask;
+static __thread uint32_t t_ipsr;
+static __thread struct tskTaskControlBlock *t_task;   /* TaskHandle_t of the running task */
+
+static volatile int g_fails;
+static unsigned int g_seed = 1;
+
+static struct tskTaskControlBlock g_tcb[MEM_STRESS_WORKERS + 2];
+static truth_t g_truth[MEM_STRESS_WORKERS][MEM_STRESS_TASKS];  /* Kept: the collector frees blocks of deleted tasks */
+static blk_t *g_queue[MEM_STRESS_QUEUE];
+static uint32_t g_queue_n;
+static int g_workers_done;          /* With g_queue_lock */
+static int g_isr_stop;
+static uint32_t g_own_entry, g_main_entry;
+static my_pool_t g_isr_pool;
+
+/* --- tools/host ------------------------------------------------------------------------------- */
+
+uint32_t __get_PRIMASK(void)
+{
+    return t_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    if (t_primask && !primask)pthread_mutex_unlock(&g_irq_lock);
+
+    if (!t_primask && primask)pthread_mutex_lock(&g_irq_lock);
+
+    t_primask = primask;
+}
+
+void __disable_irq(void)
+{
+    __set_PRIMASK(1);
+}
+
+uint32_t __get_IPSR(void)
+{
+    return t_ipsr;
+}
+
+/* The kernel parts used by heap_4.c and malloc.c */
+
+void vTaskSuspendAll(void)
+{
+    pthread_mutex_lock(&g_sched_lock);
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    pthread_mutex_unlock(&g_sched_lock);
+    return pdFALSE;
+}
+
+void vAssertCalled(const char *file, int line)
+{
+    CHECK(0, "configASSERT at %s:%d", file, line);
+    exit(1);
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return t_task ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return t_task;
+}
+
+/* --- entries --------------------------------------------------------------------------------- */
+
+/**
+ * @brief   Entry of the running task
+ * @param   stat : its usage
+ * @retval  entry, 0: none of its own
+ */
+static uint8_t task_entry(my_mem_stat_t *stat)
+{
+    uint8_t i;
+
+    for (i = 1; i < MEM_MAX_TASKS; i++)
+    {
+        if (my_mem_get_stat(i, stat) == 0 && stat->task == t_task)return i;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   After a call of mymalloc: without an entry, the task was charged to entry 0
+ * @note    Only the task takes its entry, and keeps it until it is deleted
+ * @param   tr : the running task
+ * @retval  None
+ */
+static void task_charged(truth_t *tr)
+{
+    my_mem_stat_t st;
+
+    if (task_entry(&st) == 0)tr->in_main = 1;
+}
+
+/* --- blocks ----------------------------------------------------------------------------------- */
+
+/**
+ * @brief   Allocates a block and counts it like malloc.c
+ * @param   tr   : the running task
+ * @param   size : bytes, at least sizeof(blk_t)
+ * @param   seed : random state
+ * @retval  block, NULL: heap full
+ */
+static blk_t *blk_alloc(truth_t *tr, uint32_t size, unsigned int *seed)
+{
+    blk_t *b = mymalloc(SRAMIN, size);
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (b)
+    {
+        tr->allocs++;
+        tr->used += size;
+    }
+    else
+    {
+        tr->fails++;
+    }
+
+    __set_PRIMASK(primask);
+    task_charged(tr);
+
+    if (b == NULL)return NULL;
+
+    b->owner = tr;
+    b->size = size;
+    b->fill = rand_r(seed) & 0xFF;
+    memset(b + 1, b->fill, size - sizeof(blk_t));
+    return b;
+}
+
+/**
+ * @brief   Checks that nobody wrote in a block
+ * @param   b : block
+ * @retval  None
+ */
+static void blk_check(const blk_t *b)
+{
+    const uint8_t *p = (const uint8_t *)(b + 1);
+    uint32_t i;
+
+    for (i = 0; i < b->size - sizeof(blk_t); i++)
+    {
+        if (p[i] != b->fill)
+        {
+            CHECK(0, "block %p of %u bytes overwritten at %u", (void *)b, b->size, i);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief   Frees a block of any task
+ * @param   b : block
+ * @retval  None
+ */
+static void blk_free(blk_t *b)
+{
+    uint32_t primask;
+
+    blk_check(b);
+    primask = __get_PRIMASK();
+    __disable_irq();
+    b->owner->used -= b->size;      /* With the entry, in the same section */
+    myfree(SRAMIN, b);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief   Gives a block to the collector
+ * @param   b : block
+ * @retval  0, OK; 1, queue full
+ */
+static uint8_t blk_give(blk_t *b)
+{
+    uint8_t ret = 1;
+
+    pthread_mutex_lock(&g_queue_lock);
+
+    if (g_queue_n < MEM_STRESS_QUEUE)
+    {
+        g_queue[g_queue_n++] = b;
+        ret = 0;
+    }
+
+    pthread_mutex_unlock(&g_queue_lock);
+    return ret;
+}
+
+/* --- tasks ------------------------------------------------------------------------------------ */
+
+/**
+ * @brief   One task: random operations, the check of its entry, then its deletion
+ * @param   tr   : what the task does
+ * @param   seed : random state
+ * @retval  None
+ */
+static void task_body(truth_t *tr, unsigned int *seed)
+{
+    blk_t *blk[MEM_STRESS_BLOCKS];
+    void *pblk[8];
+    my_pool_t pool;
+    my_mem_stat_t st;
+    blk_t *b;
+    uint32_t n = 0, np = 0, i, k, size, primask;
+    uint8_t pool_ok, entry;
+
+    pool_ok = (my_pool_create(&pool, 20 + rand_r(seed) % 20, 4) == 0);
+    task_charged(tr);
+
+    if (pool_ok)
+    {
+        tr->allocs++;
+        tr->used += (uint32_t)pool.size * pool.count;
+    }
+    else
+    {
+        tr->fails++;
+    }
+
+    for (i = 0; i < MEM_STRESS_OPS; i++)
+    {
+        k = rand_r(seed) % 100;
+
+        if (k < 35 && n < MEM_STRESS_BLOCKS)
+        {
+            b = blk_alloc(tr, sizeof(blk_t) + rand_r(seed) % 1500, seed);
+
+            if (b)blk[n++] = b;
+        }
+        else if (k < 55 && n)
+        {
+            k = rand_r(seed) % n;
+            blk_free(blk[k]);
+            blk[k] = blk[--n];
+        }
+        else if (k < 65 && n)
+        {
+            k = rand_r(seed) % n;
+            blk_check(blk[k]);
+            size = sizeof(blk_t) + rand_r(seed) % 1500;
+            b = myrealloc(SRAMIN, blk[k], size);
+            primask = __get_PRIMASK();
+            __disable_irq();
+
+            if (b)
+            {
+                tr->allocs++;
+                tr->used += size - b->size;
+
+                if (size < b->size)b->size = size;  /* Content kept up to the smaller size */
+            }
+            else
+            {
+                tr->fails++;
+            }
+
+            __set_PRIMASK(primask);
+            task_charged(tr);
+
+            if (b)
+            {
+                blk_check(b);
+                memset((uint8_t *)b + b->size, b->fill, size - b->size);  /* New bytes, when larger */
+                b->size = size;
+                blk[k] = b;
+            }
+        }
+        else if (k < 85 && pool_ok)
+        {
+            if (np < 8 && (np == 0 || rand_r(seed) % 2))
+            {
+                pblk[np] = my_pool_alloc(&pool);
+                task_charged(tr);
+
+                if (pblk[np] && ((uint8_t *)pblk[np] < pool.base || (uint8_t *)pblk[np] >= pool.base + pool.size * pool.count))
+                {
+                    primask = __get_PRIMASK();
+                    __disable_irq();
+                    tr->allocs++;               /* Spilled to the heap */
+                    tr->used += pool.size;
+                    __set_PRIMASK(primask);
+                }
+                else if (pblk[np] == NULL)
+                {
+                    tr->fails++;
+                }
+
+                if (pblk[np])np++;
+            }
+            else if (np)
+            {
+                np--;
+
+                if ((uint8_t *)pblk[np] < pool.base || (uint8_t *)pblk[np] >= pool.base + pool.size * pool.count)
+                {
+                    primask = __get_PRIMASK();
+                    __disable_irq();
+                    tr->used -= pool.size;
+                    my_pool_free(&pool, pblk[np]);
+                    __set_PRIMASK(primask);
+                }
+                else
+                {
+                    my_pool_free(&pool, pblk[np]);
+                }
+            }
+        }
+        else if (n)
+        {
+            k = rand_r(seed) % n;
+
+            if (blk_give(blk[k]) == 0)blk[k] = blk[--n];
+        }
+
+        if (rand_r(seed) % 16 == 0)sched_yield();
+    }
+
+    /* The entry against what the task did */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    entry = task_entry(&st);
+
+    if (entry && !tr->in_main)
+    {
+        CHECK(st.allocs == tr->allocs, "task %u: %u allocations, %u made", t_task->number, st.allocs, tr->allocs);
+        CHECK(st.fails == tr->fails, "task %u: %u failures, %u made", t_task->number, st.fails, tr->fails);
+        CHECK(st.used == tr->used, "task %u: %u bytes used, %u not freed", t_task->number, st.used, tr->used);
+        CHECK(st.peak >= st.used, "task %u: peak %u under %u bytes used", t_task->number, st.peak, st.used);
+    }
+
+    __set_PRIMASK(primask);
+
+    __sync_add_and_fetch((entry && !tr->in_main) ? &g_own_entry : &g_main_entry, 1);
+
+    /* Some blocks stay with the collector, the rest is freed */
+    while (np)
+    {
+        np--;
+
+        if ((uint8_t *)pblk[np] < pool.base || (uint8_t *)pblk[np] >= pool.base + pool.size * pool.count)
+        {
+            primask = __get_PRIMASK();
+            __disable_irq();
+            tr->used -= pool.size;
+            my_pool_free(&pool, pblk[np]);
+            __set_PRIMASK(primask);
+        }
+        else
+        {
+            my_pool_free(&pool, pblk[np]);
+        }
+    }
+
+    if (pool_ok)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        tr->used -= (uint32_t)pool.size * pool.count;
+        my_pool_delete(&pool);
+        __set_PRIMASK(primask);
+    }
+
+    while (n)
+    {
+        n--;
+
+        if (rand_r(seed) % 2 == 0 || blk_give(blk[n]))blk_free(blk[n]);
+    }
+
+    /* vTaskDelete: traceTASK_DELETE in a critical section */
+    __disable_irq();
+    entry = task_entry(&st);
+    size = st.used;
+    my_mem_task_delete(t_task);
+    CHECK(task_entry(&st) == 0, "task %u still has an entry after its deletion", t_task->number);
+
+    if (entry && size)              /* Blocks at the collector: kept as deleted until the last one */
+    {
+        CHECK(my_mem_get_stat(entry, &st) == 0 && st.deleted && st.task == NULL && st.used == size,
+              "task %u: entry %u with %u bytes not kept as deleted", t_task->number, entry, size);
+    }
+    else if (entry)
+    {
+        CHECK(my_mem_get_stat(entry, &st) == 1, "task %u: entry %u not released", t_task->number, entry);
+    }
+
+    __set_PRIMASK(0);
+}
+
+/**
+ * @brief   Runs MEM_STRESS_TASKS tasks, one after the other with the same TCB
+ * @param   arg : TCB
+ * @retval  NULL
+ */
+static void *worker(void *arg)
+{
+    uint32_t w = (struct tskTaskControlBlock *)arg - g_tcb;
+    unsigned int seed = g_seed * 7919 + w;
+    uint32_t i;
+
+    for (i = 0; i < MEM_STRESS_TASKS; i++)
+    {
+        ((struct tskTaskControlBlock *)arg)->number++;
+        t_task = arg;
+        task_body(&g_truth[w][i], &seed);
+    }
+
+    pthread_mutex_lock(&g_queue_lock);
+    g_workers_done++;
+    pthread_mutex_unlock(&g_queue_lock);
+    return NULL;
+}
+
+/**
+ * @brief   Frees the blocks given by the tasks, in random order and sometimes late
+ * @param   arg : TCB
+ * @retval  NULL
+ */
+static void *collector(void *arg)
+{
+    unsigned int seed = g_seed * 104729;
+    blk_t *b;
+    uint32_t k;
+    uint8_t done;
+
+    t_task = arg;
+
+    while (1)
+    {
+        b = NULL;
+        pthread_mutex_lock(&g_queue_lock);
+        done = (g_workers_done == MEM_STRESS_WORKERS);
+
+        if (g_queue_n && (g_queue_n > MEM_STRESS_QUEUE / 4 || rand_r(&seed) % 2 == 0 || done))
+        {
+            k = rand_r(&seed) % g_queue_n;
+            b = g_queue[k];
+            g_queue[k] = g_queue[--g_queue_n];
+        }
+
+        pthread_mutex_unlock(&g_queue_lock);
+
+        if (b)
+        {
+            blk_free(b);
+        }
+        else if (done)              /* And the queue was empty */
+        {
+            break;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   An interrupt: blocks of a pool of 2, never from the heap
+ * @param   arg : not used
+ * @retval  NULL
+ */
+static void *isr(void *arg)
+{
+    void *p[3];
+    uint8_t i;
+
+    (void)arg;
+    t_ipsr = 53;                    /* USART1 */
+
+    while (!__atomic_load_n(&g_isr_stop, __ATOMIC_RELAXED))
+    {
+        for (i = 0; i < 3; i++)p[i] = my_pool_alloc(&g_isr_pool);
+
+        CHECK(p[0] && p[1] && p[2] == NULL, "interrupt: pool of 2 gave %p %p %p", p[0], p[1], p[2]);
+
+        for (i = 0; i < 3; i++)my_pool_free(&g_isr_pool, p[i]);
+
+        sched_yield();
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t th[MEM_STRESS_WORKERS], th_col, th_isr;
+    my_mem_stat_t st;
+    void *main_blk;
+    size_t heap_free;
+    uint32_t i;
+
+    if (argc == 3 && strcmp(argv[1], "-s") == 0)g_seed = strtoul(argv[2], NULL, 0);
+
+    vPortFree(pvPortMalloc(8));     /* heap_4 sets its free list up at the first allocation */
+    heap_free = xPortGetFreeHeapSize();
+
+    /* Before the scheduler: entry 0 */
+    my_mem_init(SRAMIN);
+    main_blk = mymalloc(SRAMIN, 100);
+    CHECK(main_blk != NULL, "main: no memory");
+    CHECK(my_pool_create(&g_isr_pool, 16, 2) == 0, "main: no memory for the pool");
+    my_mem_get_stat(0, &st);
+    CHECK(st.allocs == 2 && st.used == 100 + 32, "main: entry 0 has %u allocations and %u bytes", st.allocs, st.used);
+
+    for (i = 0; i < MEM_STRESS_WORKERS; i++)pthread_create(&th[i], NULL, worker, &g_tcb[i]);
+
+    pthread_create(&th_col, NULL, collector, &g_tcb[MEM_STRESS_WORKERS]);
+    pthread_create(&th_isr, NULL, isr, NULL);
+
+    for (i = 0; i < MEM_STRESS_WORKERS; i++)pthread_join(th[i], NULL);
+
+    pthread_join(th_col, NULL);
+    __atomic_store_n(&g_isr_stop, 1, __ATOMIC_RELAXED);
+    pthread_join(th_isr, NULL);
+
+    CHECK(g_isr_pool.spills == 0 && g_isr_pool.used == 0, "interrupt pool: %u spills, %u used", g_isr_pool.spills, g_isr_pool.used);
+
+    for (i = 1; i < MEM_MAX_TASKS; i++)
+    {
+        CHECK(my_mem_get_stat(i, &st) == 1, "entry %u still used: deleted %u, %u bytes", i, st.deleted, st.used);
+    }
+
+    CHECK(g_main_entry * 4 < g_own_entry, "%u tasks in entry 0, %u with their own", g_main_entry, g_own_entry);
+
+    my_pool_delete(&g_isr_pool);
+    myfree(SRAMIN, main_blk);
+    my_mem_get_stat(0, &st);
+    CHECK(st.used == 0, "entry 0: %u bytes after the last free", st.used);
+    CHECK(xPortGetFreeHeapSize() == heap_free, "heap: %u bytes free after the last free, %u at the start",
+          (unsigned int)xPortGetFreeHeapSize(), (unsigned int)heap_free);
+    main_blk = pvPortMalloc(heap_free - 16);   /* 16: header of a heap_4 block on a 64-bit host */
+    CHECK(main_blk != NULL, "heap: the %u free bytes are not one block again", (unsigned int)heap_free);
+    vPortFree(main_blk);
+
+    printf("%u tasks, %u in entry 0\n", g_own_entry + g_main_entry, g_main_entry);
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+    return g_fails ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/**
+ ****************************************************************************************************
+ * @file        FreeRTOSConfig.h
+ * @author      ALIENTEK
+ * @brief       FreeRTOSConfig.h of the host build (tools/trace_run.c)
+ *
+ *              The settings of Core/Inc/FreeRTOSConfig.h that trace.c depends on, the trace hooks
+ *              included the same way. The idle hook waits for the next interrupt (WFI), the tickless
+ *              idle of lpidle.c is modelled by tools/trace_run.c.
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <stdint.h>
+
+#define configUSE_PREEMPTION                     1
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         1
+#define configUSE_IDLE_HOOK                      1
+#define configUSE_TICK_HOOK                      0
+#define configCPU_CLOCK_HZ                       72000000
+#define configTICK_RATE_HZ                       ((TickType_t)1000)
+#define configMAX_PRIORITIES                     (56)
+#define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
+#define configTOTAL_HEAP_SIZE                    ((size_t)40960)
+#define configMAX_TASK_NAME_LEN                  (16)
+#define configUSE_TRACE_FACILITY                 1
+#define configGENERATE_RUN_TIME_STATS            1
+#define configUSE_16_BIT_TICKS                   0
+#define configUSE_MUTEXES                        1
+#define configQUEUE_REGISTRY_SIZE                8
+#define configUSE_RECURSIVE_MUTEXES              1
+#define configUSE_COUNTING_SEMAPHORES            1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
+#define configUSE_TICKLESS_IDLE                  1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP    2
+
+#define configUSE_CO_ROUTINES                    0
+#define configMAX_CO_ROUTINE_PRIORITIES          (2)
+
+#define configUSE_TIMERS                         1
+#define configTIMER_TASK_PRIORITY                (2)
+#define configTIMER_QUEUE_LENGTH                 10
+#define configTIMER_TASK_STACK_DEPTH             256
+
+#define INCLUDE_vTaskPrioritySet                 1
+#define INCLUDE_uxTaskPriorityGet                1
+#define INCLUDE_vTaskDelete                      1
+#define INCLUDE_vTaskCleanUpResources            0
+#define INCLUDE_vTaskSuspend                     1
+#define INCLUDE_vTaskDelayUntil                  1
+#define INCLUDE_vTaskDelay                       1
+#define INCLUDE_xTaskGetSchedulerState           1
+#define INCLUDE_xTimerPendFunctionCall           1
+#define INCLUDE_xQueueGetMutexHolder             1
+#define INCLUDE_uxTaskGetStackHighWaterMark      1
+#define INCLUDE_eTaskGetState                    1
+
+void vAssertCalled(const char *file, int line);
+#define configASSERT(x)                          if ((x) == 0) vAssertCalled(__FILE__, __LINE__)
+
+/* Run time stats from the DWT cycle counter, as freertos.c */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS   configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE           getRunTimeCounterValue
+
+/* Tickless idle: SLEEP or STOP, tools/trace_run.c */
+void lpidle_suppress_ticks(uint32_t expected);
+#define portSUPPRESS_TICKS_AND_SLEEP(x)          lpidle_suppress_ticks(x)
+
+/* Trace recorder hooks, as Core/Inc/FreeRTOSConfig.h */
+#include "../../ATK_Middlewares/TRACE/trace.h"
+
+#endif
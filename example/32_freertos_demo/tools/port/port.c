@@ -0,0 +1,552 @@
+/**
+ ****************************************************************************************************
+ * @file        port.c
+ * @author      ALIENTEK
+ * @brief       FreeRTOS port of the host build (tools/trace_run.c): simulated 72MHz core
+ *
+ *              Each task runs on its own ucontext, one at a time in one thread, so the kernel, the
+ *              trace hooks and trace.c run unchanged. The registers of the core are variables:
+ *              PRIMASK, BASEPRI (critical sections), IPSR (the interrupt running) and the DWT cycle
+ *              counter, which follows the simulated clock and stops in STOP.
+ *
+ *              The clock is a cycle count that only moves when a task or an interrupt says it works
+ *              (sim_run), or when the idle task waits (sim_idle, sim_sleep), see sim.h. SysTick is
+ *              interrupt 0, it keeps its phase across a tickless idle as the Cortex-M3 port does.
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sim.h"
+
+
+#define SIM_STACK               (256 * 1024)    /* Host stack of a task: printf needs more than the board */
+#define SIM_THREAD_PRIO         0x100           /* Priority of the task level, below all the interrupts */
+
+typedef struct
+{
+    ucontext_t uc;
+    TaskFunction_t code;
+    void *param;
+} sim_ctx_t;
+
+/* The first field of the TCB, as the Cortex-M3 port sees it */
+typedef struct
+{
+    StackType_t *volatile pxTopOfStack;
+} sim_tcb_t;
+
+extern sim_tcb_t *volatile pxCurrentTCB;
+
+/* pxPortInitialiseStack keeps the context at the top of the stack of the task */
+#define SIM_CTX(tcb)            (*(sim_ctx_t **)(tcb)->pxTopOfStack)
+
+DWT_Type g_sim_dwt;
+CoreDebug_Type g_sim_coredebug;
+sim_irq_t g_sim_irq[SIM_IRQ_MAX];
+sim_task_t g_sim_task[SIM_TASK_MAX];
+uint64_t g_sim_stop = 0;
+uint32_t g_sim_stops = 0;
+
+static uint64_t g_sim_now = 0;
+static uint64_t g_sim_end = SIM_NONE;
+static uint64_t g_sim_tick_next;
+static uint32_t g_sim_primask = 0;
+static uint32_t g_sim_basepri = 0;
+static uint32_t g_sim_nesting = 0;              /* Critical sections */
+static uint16_t g_sim_ipsr = 0;
+static uint16_t g_sim_prio = SIM_THREAD_PRIO;
+static uint8_t g_sim_yield = 0;                 /* PendSV pending */
+static uint8_t g_sim_started = 0;
+static uint8_t g_sim_stopped = 0;               /* STOP: the cycle counter does not count */
+static uint8_t g_sim_traced = 0;                /* Traced interrupts running */
+static uint64_t g_sim_nested = 0;               /* Cycles of the traced interrupts nested in the innermost one */
+static uint64_t g_sim_slice = 0;                /* Cycles of the running task since it was switched in */
+static ucontext_t g_sim_main;
+
+/**
+ * @brief   Moves the clock
+ * @param   cycles : cycles
+ * @retval  None
+ */
+static void sim_advance(uint64_t cycles)
+{
+    g_sim_now += cycles;
+
+    if (g_sim_stopped == 0 && (g_sim_coredebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) && (g_sim_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        g_sim_dwt.CYCCNT += (uint32_t)cycles;
+    }
+
+    if (g_sim_traced == 0)g_sim_slice += cycles;    /* SysTick is not traced: the trace sees task time */
+}
+
+/**
+ * @brief   The interrupt that would be taken first now or later
+ * @param   None
+ * @retval  Interrupt source, NULL: all masked or none requested
+ */
+static sim_irq_t *sim_next(void)
+{
+    sim_irq_t *best = NULL;
+    sim_irq_t *s;
+    uint8_t i;
+
+    if (g_sim_primask || g_sim_basepri)return NULL;    /* All the sources call the FreeRTOS API: BASEPRI masks them */
+
+    for (i = 0; i < SIM_IRQ_MAX; i++)
+    {
+        s = &g_sim_irq[i];
+
+        if (s->isr == NULL || s->at == SIM_NONE || s->prio >= g_sim_prio)continue;
+
+        if (best == NULL || s->at < best->at || (s->at == best->at && s->prio < best->prio))best = s;
+    }
+
+    return best;
+}
+
+/**
+ * @brief   Number of a task as the trace records give it (uxTCBNumber)
+ * @param   tcb : task
+ * @retval  Task number
+ */
+static UBaseType_t sim_task_number(sim_tcb_t *tcb)
+{
+    TaskStatus_t status;
+
+    vTaskGetInfo((TaskHandle_t)tcb, &status, pdFALSE, eRunning);   /* Not eInvalid: no critical section */
+    return status.xTaskNumber;
+}
+
+/**
+ * @brief   Context switch (PendSV)
+ * @param   None
+ * @retval  None
+ */
+static void sim_switch(void)
+{
+    sim_tcb_t *prev = pxCurrentTCB;
+    sim_tcb_t *next;
+    UBaseType_t n;
+    uint8_t run = xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+
+    g_sim_yield = 0;
+    g_sim_basepri = 1;
+    vTaskSwitchContext();
+    g_sim_basepri = 0;
+    next = pxCurrentTCB;
+
+    if (run)                            /* Else only xYieldPending is set, no switch records */
+    {
+        n = sim_task_number(prev);
+
+        if (n < SIM_TASK_MAX)g_sim_task[n].cpu += g_sim_slice;
+
+        g_sim_slice = 0;
+        n = sim_task_number(next);
+
+        if (n < SIM_TASK_MAX)
+        {
+            g_sim_task[n].switches++;
+            strncpy(g_sim_task[n].name, pcTaskGetName((TaskHandle_t)next), configMAX_TASK_NAME_LEN - 1);
+        }
+    }
+
+    if (next != prev)swapcontext(&SIM_CTX(prev)->uc, &SIM_CTX(next)->uc);
+}
+
+/**
+ * @brief   Takes the pending switch if nothing stops it
+ * @param   None
+ * @retval  None
+ */
+static void sim_pendsv(void)
+{
+    if (g_sim_yield && g_sim_started && g_sim_ipsr == 0 && g_sim_primask == 0 && g_sim_basepri == 0)sim_switch();
+}
+
+/**
+ * @brief   Runs an interrupt handler
+ * @param   s : interrupt source
+ * @retval  None
+ */
+static void sim_dispatch(sim_irq_t *s)
+{
+    uint16_t ipsr = g_sim_ipsr;
+    uint16_t prio = g_sim_prio;
+    uint64_t start = g_sim_now;
+    uint64_t nested = 0;
+    uint64_t dur;
+    uint8_t traced = s->flags & SIM_IRQ_TRACED;
+
+    s->at = SIM_NONE;                   /* The handler asks again */
+    g_sim_ipsr = s->exc;
+    g_sim_prio = s->prio;
+
+    if (traced)
+    {
+        nested = g_sim_nested;
+        g_sim_nested = 0;
+        g_sim_traced++;
+    }
+
+    s->isr();
+
+    if (traced)
+    {
+        dur = g_sim_now - start;
+        s->count++;
+        s->total += dur - g_sim_nested;
+
+        if (dur > s->max)s->max = dur;
+
+        g_sim_traced--;
+        g_sim_nested = g_sim_traced ? nested + dur : 0;
+    }
+
+    g_sim_ipsr = ipsr;
+    g_sim_prio = prio;
+}
+
+/**
+ * @brief   Interrupts that came while masked, then the pending switch
+ * @param   None
+ * @retval  None
+ */
+static void sim_unmasked(void)
+{
+    sim_irq_t *s;
+
+    while ((s = sim_next()) != NULL && s->at <= g_sim_now)
+    {
+        sim_dispatch(s);
+    }
+
+    if (g_sim_ipsr == 0)sim_pendsv();
+}
+
+/**
+ * @brief   SysTick: xPortSysTickHandler
+ * @param   None
+ * @retval  None
+ */
+static void sim_systick(void)
+{
+    uint32_t basepri;
+
+    g_sim_tick_next += SIM_TICK;
+    g_sim_irq[0].at = g_sim_tick_next;
+
+    basepri = ulPortRaiseBASEPRI();
+
+    if (xTaskIncrementTick() != pdFALSE)g_sim_yield = 1;
+
+    vPortSetBASEPRI(basepri);
+}
+
+/**
+ * @brief   First code of a task
+ * @param   None
+ * @retval  None
+ */
+static void sim_task_entry(void)
+{
+    sim_ctx_t *c = SIM_CTX(pxCurrentTCB);
+
+    c->code(c->param);
+    configASSERT(0);                    /* A task must not return */
+}
+
+/******************************************************************************************/
+/* sim.h */
+
+uint64_t sim_now(void)
+{
+    return g_sim_now;
+}
+
+/**
+ * @brief   Declares an interrupt source
+ * @param   n : source, 1 ~ SIM_IRQ_MAX - 1
+ * @param   exc : exception number (IRQn + 16)
+ * @param   prio : preemption priority
+ * @param   flags : SIM_IRQ_TRACED, SIM_IRQ_WAKEUP
+ * @param   isr : handler
+ * @retval  None
+ */
+void sim_irq_init(uint8_t n, uint16_t exc, uint8_t prio, uint8_t flags, void (*isr)(void))
+{
+    memset(&g_sim_irq[n], 0, sizeof(sim_irq_t));
+    g_sim_irq[n].exc = exc;
+    g_sim_irq[n].prio = prio;
+    g_sim_irq[n].flags = flags;
+    g_sim_irq[n].isr = isr;
+    g_sim_irq[n].at = SIM_NONE;
+}
+
+/**
+ * @brief   Requests an interrupt
+ * @param   n : source
+ * @param   at : time in cycles, SIM_NONE: cancels the request
+ * @retval  None
+ */
+void sim_irq_at(uint8_t n, uint64_t at)
+{
+    g_sim_irq[n].at = at;
+}
+
+/**
+ * @brief   The caller works this many cycles
+ * @param   cycles : cycles
+ * @retval  None
+ */
+void sim_run(uint32_t cycles)
+{
+    uint64_t left = cycles;
+    uint64_t step;
+    sim_irq_t *s;
+
+    while (1)
+    {
+        s = sim_next();
+
+        if (s && s->at <= g_sim_now)
+        {
+            sim_dispatch(s);
+
+            if (g_sim_ipsr == 0)sim_pendsv();   /* The task may be switched out here, for a while */
+
+            continue;
+        }
+
+        if (left == 0)break;
+
+        step = left;
+
+        if (s && s->at - g_sim_now < step)step = s->at - g_sim_now;
+
+        sim_advance(step);
+        left -= step;
+    }
+}
+
+/**
+ * @brief   WFI of the idle task, ends the run at the time of sim_end
+ * @param   None
+ * @retval  None
+ */
+void sim_idle(void)
+{
+    sim_irq_t *s;
+
+    if (g_sim_now >= g_sim_end)vTaskEndScheduler();
+
+    s = sim_next();
+
+    if (s)sim_run(s->at > g_sim_now ? (uint32_t)(s->at - g_sim_now) : 0);
+}
+
+/**
+ * @brief   Tickless idle: sleeps until the tick of a task or an interrupt, steps the tick count
+ * @param   expected : ticks until a task is due
+ * @param   stop : 1, STOP: the cycle counter stops and only SIM_IRQ_WAKEUP sources end it; 0, SLEEP
+ * @retval  None
+ */
+void sim_sleep(TickType_t expected, uint8_t stop)
+{
+    uint64_t last = g_sim_tick_next - SIM_TICK;
+    uint64_t wake = last + (uint64_t)expected * SIM_TICK;
+    uint64_t ticks;
+    sim_irq_t *s;
+    uint8_t i;
+
+    __disable_irq();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+    {
+        __enable_irq();
+        return;
+    }
+
+    for (i = 1; i < SIM_IRQ_MAX; i++)
+    {
+        s = &g_sim_irq[i];
+
+        if (s->isr == NULL || s->at == SIM_NONE || (stop && (s->flags & SIM_IRQ_WAKEUP) == 0))continue;
+
+        if (s->at < wake)wake = s->at;
+    }
+
+    if (wake <= g_sim_now)
+    {
+        __enable_irq();
+        return;
+    }
+
+    if (stop)
+    {
+        g_sim_stop += wake - g_sim_now;
+        g_sim_stops++;
+    }
+
+    g_sim_stopped = stop;
+    sim_advance(wake - g_sim_now);
+    g_sim_stopped = 0;
+
+    ticks = (wake - last) / SIM_TICK;
+
+    if (ticks >= expected)ticks = expected - 1;     /* The last one by SysTick, at once */
+
+    g_sim_tick_next = last + (ticks + 1) * SIM_TICK;
+    g_sim_irq[0].at = g_sim_tick_next;
+
+    if (ticks)vTaskStepTick((TickType_t)ticks);
+
+    __enable_irq();                     /* The wake-up interrupt runs here */
+}
+
+/**
+ * @brief   Time at which the idle task ends the scheduler
+ * @param   at : cycles
+ * @retval  None
+ */
+void sim_end(uint64_t at)
+{
+    g_sim_end = at;
+}
+
+/******************************************************************************************/
+/* Core registers */
+
+uint32_t __get_PRIMASK(void)
+{
+    return g_sim_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    g_sim_primask = primask;
+
+    if (primask == 0)sim_unmasked();
+}
+
+void __disable_irq(void)
+{
+    g_sim_primask = 1;
+}
+
+void __enable_irq(void)
+{
+    g_sim_primask = 0;
+    sim_unmasked();
+}
+
+uint32_t __get_IPSR(void)
+{
+    return g_sim_ipsr;
+}
+
+/******************************************************************************************/
+/* portable.h, portmacro.h */
+
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
+{
+    sim_ctx_t *c = malloc(sizeof(sim_ctx_t));
+    void *stack = malloc(SIM_STACK);
+
+    configASSERT(c && stack);
+
+    c->code = pxCode;
+    c->param = pvParameters;
+    getcontext(&c->uc);
+    c->uc.uc_stack.ss_sp = stack;
+    c->uc.uc_stack.ss_size = SIM_STACK;
+    c->uc.uc_link = NULL;
+    makecontext(&c->uc, sim_task_entry, 0);
+
+    *pxTopOfStack = (StackType_t)c;
+    return pxTopOfStack;
+}
+
+BaseType_t xPortStartScheduler(void)
+{
+    g_sim_started = 1;
+    g_sim_nesting = 0;
+    g_sim_basepri = 0;
+    g_sim_slice = 0;
+    g_sim_tick_next = g_sim_now + SIM_TICK;
+    sim_irq_init(0, 15, 15, 0, sim_systick);
+    g_sim_irq[0].at = g_sim_tick_next;
+
+    swapcontext(&g_sim_main, &SIM_CTX(pxCurrentTCB)->uc);
+
+    return pdFALSE;                     /* vTaskEndScheduler */
+}
+
+void vPortEndScheduler(void)
+{
+    g_sim_started = 0;
+    setcontext(&g_sim_main);
+}
+
+void vPortYield(void)
+{
+    g_sim_yield = 1;
+    sim_pendsv();                       /* From an interrupt: on the way back to the task */
+}
+
+void vPortEnterCritical(void)
+{
+    g_sim_basepri = 1;
+    g_sim_nesting++;
+}
+
+void vPortExitCritical(void)
+{
+    configASSERT(g_sim_nesting);
+
+    if (--g_sim_nesting == 0)
+    {
+        g_sim_basepri = 0;
+        sim_unmasked();
+    }
+}
+
+uint32_t ulPortRaiseBASEPRI(void)
+{
+    uint32_t basepri = g_sim_basepri;
+
+    g_sim_basepri = 1;
+    return basepri;
+}
+
+void vPortSetBASEPRI(uint32_t basepri)
+{
+    g_sim_basepri = basepri;
+
+    if (basepri == 0)sim_unmasked();
+}
+
+void vAssertCalled(const char *file, int line)
+{
+    printf("ASSERT %s:%d\n", file, line);
+    exit(2);
+}
@@ -0,0 +1,75 @@
+/**
+ ****************************************************************************************************
+ * @file        portmacro.h
+ * @author      ALIENTEK
+ * @brief       FreeRTOS port of the host build (tools/trace_run.c): one thread, tasks on ucontext
+ *
+ *              Same macros as portable/GCC/ARM_CM3: BASEPRI for the critical sections, PendSV for
+ *              the yields. port.c runs them on a simulated 72MHz clock (sim.h).
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+
+#define portCHAR                        char
+#define portFLOAT                       float
+#define portDOUBLE                      double
+#define portLONG                        long
+#define portSHORT                       short
+#define portSTACK_TYPE                  uintptr_t       /* pxPortInitialiseStack keeps a pointer on the stack */
+#define portBASE_TYPE                   long
+#define portPOINTER_SIZE_TYPE           uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY                   ((TickType_t)0xffffffffUL)
+#define portTICK_TYPE_IS_ATOMIC         1
+
+#define portSTACK_GROWTH                (-1)
+#define portTICK_PERIOD_MS              ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT              8
+
+/* Scheduler utilities: the switch is done when no interrupt is running and none is masked */
+void vPortYield(void);
+#define portYIELD()                             vPortYield()
+#define portEND_SWITCHING_ISR(xSwitchRequired)  if ((xSwitchRequired) != pdFALSE) vPortYield()
+#define portYIELD_FROM_ISR(x)                   portEND_SWITCHING_ISR(x)
+
+/* Critical section management */
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+uint32_t ulPortRaiseBASEPRI(void);
+void vPortSetBASEPRI(uint32_t basepri);
+#define portSET_INTERRUPT_MASK_FROM_ISR()       ulPortRaiseBASEPRI()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    vPortSetBASEPRI(x)
+#define portDISABLE_INTERRUPTS()                (void)ulPortRaiseBASEPRI()
+#define portENABLE_INTERRUPTS()                 vPortSetBASEPRI(0)
+#define portENTER_CRITICAL()                    vPortEnterCritical()
+#define portEXIT_CRITICAL()                     vPortExitCritical()
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters)    void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters)          void vFunction(void *pvParameters)
+
+#define portNOP()
+#define portINLINE                      __inline
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ ****************************************************************************************************
+ * @file        sim.h
+ * @author      ALIENTEK
+ * @brief       Simulated clock and interrupts of the host FreeRTOS port (port.c)
+ *
+ *              The time only moves in sim_run (the caller works that many cycles), sim_idle (WFI) and
+ *              sim_sleep (tickless idle). An interrupt comes when its time is reached, if it has a
+ *              higher priority than what runs and nothing masks it; the switch requested by an
+ *              interrupt or a yield is made on the way back to a task, as PendSV does.
+ *
+ *              port.c also keeps what really happened, to compare with the trace: the cycles of each
+ *              task between two switches, and count, time and longest run of each traced interrupt.
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __SIM_H
+#define __SIM_H
+
+#include "FreeRTOS.h"
+
+
+#define SIM_NONE                UINT64_MAX
+#define SIM_TICK                ((uint64_t)configCPU_CLOCK_HZ / configTICK_RATE_HZ)    /* Cycles per tick */
+#define SIM_IRQ_MAX             8       /* Interrupt sources, 0 is SysTick */
+#define SIM_TASK_MAX            64      /* Task numbers kept */
+
+#define SIM_IRQ_TRACED          0x01    /* The handler writes ISR records: its time is not task time */
+#define SIM_IRQ_WAKEUP          0x02    /* Ends a STOP (EXTI line), the others wait for the wake-up */
+
+typedef struct
+{
+    uint16_t exc;                       /* Exception number, IPSR */
+    uint8_t prio;                       /* Lower is more urgent */
+    uint8_t flags;
+    void (*isr)(void);
+    uint64_t at;                        /* Next request, SIM_NONE: none */
+
+    uint32_t count;                     /* SIM_IRQ_TRACED: runs, */
+    uint64_t total;                     /* cycles without the traced interrupts nested in it, */
+    uint64_t max;                       /* longest run */
+} sim_irq_t;
+
+typedef struct
+{
+    char name[configMAX_TASK_NAME_LEN];
+    uint64_t cpu;                       /* Cycles of the runs that ended with a switch, interrupts taken out */
+    uint32_t switches;                  /* Switched in by vTaskSwitchContext */
+} sim_task_t;
+
+extern sim_irq_t g_sim_irq[SIM_IRQ_MAX];
+extern sim_task_t g_sim_task[SIM_TASK_MAX];     /* By task number (uxTaskGetTaskNumber) */
+extern uint64_t g_sim_stop;                     /* Cycles in STOP */
+extern uint32_t g_sim_stops;
+
+uint64_t sim_now(void);
+void sim_irq_init(uint8_t n, uint16_t exc, uint8_t prio, uint8_t flags, void (*isr)(void));
+void sim_irq_at(uint8_t n, uint64_t at);
+void sim_run(uint32_t cycles);                  /* Work of the caller, interrupts and switches happen inside */
+void sim_idle(void);                            /* WFI */
+void sim_sleep(TickType_t expected, uint8_t stop);  /* portSUPPRESS_TICKS_AND_SLEEP: SLEEP or STOP */
+void sim_end(uint64_t at);                      /* vTaskStartScheduler returns when the idle task runs at this time */
+
+#endif
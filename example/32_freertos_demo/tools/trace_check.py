@@ -0,0 +1,427 @@
+#!/usr/bin/env python3
+"""
+trace_check.py - checks trace_convert.py on a synthetic capture
+
+Usage: python trace_check.py [--write]
+       python trace_check.py --run capture.bin truth.json
+
+Builds the byte stream that the board would send for a scripted run, with the records of
+ATK_Middlewares/TRACE/trace.h in packets between printf lines, and keeps what really happened
+in cycles of the 72MHz clock. The converter must find it again:
+- CPU time of each task without the interrupts, switches, ready to running time
+- interrupt count, time (nested interrupts taken out) and longest run
+- queue operations and the levels at the end, names of 4 records
+- the DWT cycle counter wraps, it stops in STOP (tickless idle): the time in STOP comes from
+  the tick count of the SYNC record at the wake-up, so it is only known within a tick
+- a LOST record, a packet with a wrong byte, a printf line that begins with A5 5A
+The stream is also in trace_synth.bin: the check fails if the generator no longer makes the same
+bytes, --write rewrites the file. Then the command line of trace_convert.py runs on the file.
+
+--run checks a capture of tools/trace_run.c (the recorder on the real kernel, on a PC) against the
+truth file of the run: the same figures, from the port and the application instead of the script.
+The time of the idle task is only known within a tick, the low power time within a tick for each
+STOP (the wake-up interrupts are in it for the run). With LOST records
+(trace_run -l) only the lost count, the names and the text are checked.
+"""
+
+import argparse
+import copy
+import json
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import trace_convert as tc                          # noqa: E402
+
+MHZ = 72
+TICK = 72000                # Cycles per tick, configTICK_RATE_HZ 1000
+CAPTURE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "trace_synth.bin")
+
+IDLE, TMR, KEY, LED, TRACE = 1, 2, 3, 4, 5
+TASKS = {IDLE: "IDLE", TMR: "Tmr Svc", KEY: "key_scan_task", LED: "led", TRACE: "trace"}
+KEY_Q, UART_SEM = 1, 2
+QUEUES = {KEY_Q: ("key_q", 0), UART_SEM: ("uart_rx_semaphore", 3)}
+EXC_EXTI0, EXC_DMA_TX, EXC_USART1 = 22, 30, 53
+Q_SEND, Q_RECV, Q_RECV_FAIL, Q_BLOCK_RECV, Q_SEND_ISR = 0x21, 0x23, 0x24, 0x26, 0x27
+
+SLEEP_TICK, WAKE_TICK = 201, 240    # Tickless idle
+LOST_TICK = 350
+BAD_TICK = 450                      # A byte of a packet of this trace run is wrong
+END_TICK = 600
+
+
+class Synth:
+    """Board side: the cycle counter, the ring, the packets, and what really happened"""
+
+    def __init__(self, seed):
+        self.rnd = random.Random(seed)
+        self.t = 0                  # Cycles since reset, never stops
+        self.off = (1 << 32) - 20 * TICK       # Cycle counter = t + off: wraps at 20ms
+        self.ring = []
+        self.seq = 0
+        self.stream = bytearray()
+        self.text = bytearray()
+
+        # What really happened, in cycles
+        self.running = None         # [task, start, isr cycles inside]
+        self.isr_stack = []         # [exception, start, nested]
+        self.ready = {}
+        self.task = {}              # id -> [cpu, switches, latency sum, latency count, latency max]
+        self.isr = {}               # exception -> [count, total, max]
+        self.queue_ops = {}
+        self.queue_level = {KEY_Q: 0, UART_SEM: 0}
+        self.lost = 0
+        self.missing = 0
+        self.low_power = 0
+        self.sent = None            # The above when the last packet was sent
+
+    # --- board -----------------------------------------------------------------------------
+    def run(self, cycles):
+        self.t += cycles
+
+    def put(self, kind, ident=0, arg=0, cyc=None):
+        if cyc is None:
+            cyc = (self.t + self.off) & 0xFFFFFFFF
+        self.ring.append((cyc, kind, ident, arg))
+
+    def sync(self):
+        tick = self.t // TICK
+        self.put(tc.EVT_SYNC, (tick >> 16) & 0xFF, tick & 0xFFFF)
+
+    def name(self, kind, ident, name):
+        raw = name.encode()[:12].ljust(12, b"\0")
+        for i in range(0, 12, 4):
+            self.put(kind, ident, i, struct.unpack("<I", raw[i:i + 4])[0])
+            if 0 in raw[i:i + 4]:
+                break
+
+    def flush(self, bad=False):
+        """trace_fill/trace_send: packets of up to 64 records"""
+        if not bad:
+            self.sent = copy.deepcopy((self.task, self.isr, self.queue_ops, self.queue_level, self.lost, self.low_power))
+        while self.ring:
+            recs, self.ring = self.ring[:tc.PACKET_MAX], self.ring[tc.PACKET_MAX:]
+            body = b"".join(struct.pack("<IBBH", *r) for r in recs)
+            packet = tc.SOF + struct.pack("<HHH", len(recs), self.seq, sum(body) & 0xFFFF) + body
+            if bad:
+                packet = packet[:20] + bytes([packet[20] ^ 0x10]) + packet[21:]
+                self.text += packet         # The converter sees text
+                self.missing += 1
+            self.stream += packet
+            self.seq = (self.seq + 1) & 0xFFFF
+
+    def printf(self, s):
+        self.stream += s
+        self.text += s
+
+    # --- kernel ----------------------------------------------------------------------------
+    def switch_in(self, task):
+        self.put(tc.EVT_TASK_IN, task)
+        st = self.task.setdefault(task, [0, 0, 0, 0, 0])
+        st[1] += 1
+        if task in self.ready:
+            lat = self.t - self.ready.pop(task)
+            st[2] += lat
+            st[3] += 1
+            st[4] = max(st[4], lat)
+        self.running = [task, self.t, 0]
+
+    def switch_out(self):
+        task, start, isr = self.running
+        self.put(tc.EVT_TASK_OUT, task)
+        self.task[task][0] += self.t - start - isr
+        self.running = None
+
+    def make_ready(self, task):
+        self.put(tc.EVT_TASK_READY, task)
+        self.ready.setdefault(task, self.t)
+
+    def queue(self, kind, q):
+        op, delta = tc.QUEUE_OPS[kind]
+        self.put(kind, q, self.queue_level[q])
+        self.queue_ops[(q, op)] = self.queue_ops.get((q, op), 0) + 1
+        self.queue_level[q] = max(0, self.queue_level[q] + delta)
+
+    def isr_enter(self, exc):
+        self.put(tc.EVT_ISR_ENTER, exc)
+        self.isr_stack.append([exc, self.t, 0])
+
+    def isr_exit(self):
+        exc, start, nested = self.isr_stack.pop()
+        self.put(tc.EVT_ISR_EXIT, exc)
+        dur = self.t - start
+        st = self.isr.setdefault(exc, [0, 0, 0])
+        st[0] += 1
+        st[1] += dur - nested
+        st[2] = max(st[2], dur)
+        if self.isr_stack:
+            self.isr_stack[-1][2] += dur
+        else:
+            self.running[2] += dur
+
+    # --- application -----------------------------------------------------------------------
+    def usart_isr(self):
+        self.isr_enter(EXC_USART1)
+        self.run(self.rnd.randint(100, 600))
+        if self.rnd.random() < 0.4:
+            self.isr_enter(EXC_DMA_TX)              # Higher priority
+            self.run(self.rnd.randint(50, 300))
+            self.isr_exit()
+            self.run(self.rnd.randint(20, 200))
+        self.queue(Q_SEND_ISR, UART_SEM)
+        self.run(self.rnd.randint(20, 100))
+        self.isr_exit()
+
+    def task_run(self, task, tick):
+        self.switch_in(task)
+        self.run(self.rnd.randint(200, 1500))
+        if task == KEY:
+            self.queue(Q_SEND, KEY_Q)
+            if tick == LOST_TICK:
+                self.put(tc.EVT_LOST, 0, 17)        # The ring was full for 17 records
+                self.lost += 17
+            self.run(self.rnd.randint(100, 800))
+        elif task == LED:
+            if self.rnd.random() < 0.3:
+                self.usart_isr()
+            self.queue(Q_RECV, KEY_Q)
+            if self.queue_level[UART_SEM]:
+                self.queue(Q_RECV, UART_SEM)
+            else:
+                self.queue(Q_RECV_FAIL, UART_SEM)
+            self.put(tc.EVT_USER, 1, tick)
+            self.run(self.rnd.randint(500, 4000))
+            if self.queue_level[KEY_Q] == 0:
+                self.queue(Q_BLOCK_RECV, KEY_Q)      # Until the next key
+        elif task == TRACE:
+            self.sync()
+            self.flush()
+            if tick == BAD_TICK:
+                for i in range(12):
+                    self.put(tc.EVT_USER, 2, i)
+                self.flush(bad=True)
+            self.run(self.rnd.randint(300, 900))
+            self.isr_enter(EXC_DMA_TX)              # End of the packet
+            self.run(self.rnd.randint(80, 200))
+            self.isr_exit()
+            if tick % 100 == 0:
+                self.printf(b"led: %d keys\r\n" % (tick // 5))
+            if tick == 300:
+                self.printf(b"\xA5Z ok\r\n")
+        self.switch_out()
+        self.run(40)                                # PendSV
+
+    def build(self):
+        self.t = 5 * TICK + 1234
+        self.sync()                                 # trace_init
+        for task, name in TASKS.items():
+            self.put(tc.EVT_TASK_CREATE, task)
+            self.name(tc.EVT_NAME_TASK, task, name)
+        for q, (name, qtype) in QUEUES.items():
+            self.put(tc.EVT_QUEUE_CREATE, q, qtype)
+            self.name(tc.EVT_NAME_QUEUE, q, name)
+        self.run(3000)
+        self.switch_in(IDLE)
+
+        tick = 6
+        while tick <= END_TICK:
+            self.t = tick * TICK + self.rnd.randint(300, 900)      # xTaskIncrementTick
+            due = [task for task, period in ((KEY, 5), (LED, 10), (TRACE, 50), (TMR, 100)) if tick % period == 0]
+            for task in due:
+                self.make_ready(task)
+            if due:
+                self.run(200)
+                self.switch_out()                   # IDLE
+                self.run(40)
+                for task in due:                    # Priorities: KEY > LED > TRACE > TMR here
+                    self.task_run(task, tick)
+                self.switch_in(IDLE)
+            if tick == END_TICK:
+                break                               # The last packet went with the last trace run
+            if tick == SLEEP_TICK:
+                self.run(2000)
+                self.put(tc.EVT_IDLE_SLEEP, 0, WAKE_TICK - SLEEP_TICK)
+                sleep = self.t
+                self.t = WAKE_TICK * TICK           # Wakes up on EXTI0, the cycle counter did not count
+                self.off -= self.t - sleep
+                self.low_power += self.t - sleep
+                self.run(150)
+                self.isr_enter(EXC_EXTI0)
+                self.run(400)
+                self.isr_exit()
+                self.run(600)
+                self.sync()                         # traceLOW_POWER_IDLE_END
+                tick = WAKE_TICK + 1
+                continue
+            tick += 1
+        return bytes(self.stream)
+
+
+def convert(data):
+    tl = tc.Timeline(MHZ, 1000)
+    text = bytearray()
+    for item in tc.split_stream(data):
+        if item[0] == "packet":
+            tl.packet(item[1], item[2])
+        else:
+            text += item[1]
+    return tl, bytes(text)
+
+
+g_fails = 0
+
+
+def check(ok, msg):
+    global g_fails
+    if not ok:
+        print("FAIL: " + msg)
+        g_fails += 1
+
+
+def close(name, got, want, tol):
+    check(abs(got - want) <= tol, "%s %.3f, expected %.3f" % (name, got, want))
+
+
+def check_run(capture, truth):
+    """Capture of tools/trace_run.c against what the run saw"""
+    with open(capture, "rb") as f:
+        data = f.read()
+    with open(truth) as f:
+        want = json.load(f)
+
+    tl, text = convert(data)
+    us = 1.0 / want["mhz"]
+    exact = 0.01
+    tick = 1e6 / want["tick_hz"]    # The last wake-up from STOP is known within a tick
+    stop = want["stops"] * tick     # The wake-up interrupts are low power time for the run, not for the converter
+
+    check(text == want["text"].encode("latin-1"), "text %r" % text[:80])
+    check(tl.lost == want["lost"], "lost %d, expected %d" % (tl.lost, want["lost"]))
+    check(tl.missing == 0, "%d packets missing" % tl.missing)
+
+    for task, st in want["tasks"].items():
+        name = tl.name(tc.EVT_NAME_TASK, int(task))
+        check(name == st["name"][:12] or (want["lost"] and name == "task " + task), "task %s named %s, expected %s" % (task, name, st["name"]))
+    for q, st in want["queues"].items():
+        check(tl.name(tc.EVT_NAME_QUEUE, int(q)) == st["name"], "queue %s named %s" % (q, tl.name(tc.EVT_NAME_QUEUE, int(q))))
+
+    if want["lost"] == 0:
+        close("low power us", tl.low_power, want["low_power"] * us, stop)
+        for task, st in want["tasks"].items():
+            got = tl.task.get(int(task), [0, 0])
+            close("%s cpu us" % st["name"], got[0], st["cpu"] * us, tick if st["name"] == "IDLE" else exact * max(st["switches"], 1))
+            check(got[1] == st["switches"], "%s switches %d, expected %d" % (st["name"], got[1], st["switches"]))
+        check(sorted(tl.isr) == sorted(int(e) for e in want["isr"]), "interrupts %s" % sorted(tl.isr))
+        for exc, st in want["isr"].items():
+            got = tl.isr.get(int(exc), [0, 0.0, 0.0])
+            check(got[0] == st[0], "%s count %d, expected %d" % (tl.isr_name(int(exc)), got[0], st[0]))
+            close("%s total us" % tl.isr_name(int(exc)), got[1], st[1] * us, exact * st[0])
+            close("%s max us" % tl.isr_name(int(exc)), got[2], st[2] * us, exact)
+        for q, st in want["queues"].items():
+            got = {op: n for (i, op), n in tl.queue_ops.items() if i == int(q)}
+            check(got == st["ops"], "%s operations %s, expected %s" % (st["name"], got, st["ops"]))
+            check(tl.queue_level.get(int(q)) == st["level"], "%s level %s, expected %d" % (st["name"], tl.queue_level.get(int(q)), st["level"]))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        res = subprocess.run([sys.executable, os.path.join(os.path.dirname(CAPTURE), "trace_convert.py"), capture,
+                              "--text", os.path.join(tmp, "log.txt")], stdout=subprocess.PIPE)
+    report = res.stdout.decode("latin-1")
+    check(res.returncode == 0, "trace_convert.py returned %d" % res.returncode)
+    check("%d records lost, 0 packets missing" % want["lost"] in report, "report:\n" + report)
+
+    print("%d bytes, %.0f ms, %d tasks, %d records lost" % (len(data), (tl.last_us - tl.first) / 1e3, len(tl.task), tl.lost))
+    print("FAILED" if g_fails else "all passed")
+    return 1 if g_fails else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--write", action="store_true", help="rewrite trace_synth.bin")
+    ap.add_argument("--run", nargs=2, metavar=("CAPTURE", "TRUTH"), help="check a capture of tools/trace_run.c")
+    args = ap.parse_args()
+
+    if args.run:
+        return check_run(*args.run)
+
+    syn = Synth(1)
+    data = syn.build()
+    if args.write:
+        with open(CAPTURE, "wb") as f:
+            f.write(data)
+    with open(CAPTURE, "rb") as f:
+        check(f.read() == data, "trace_synth.bin is not what the generator makes (--write)")
+
+    want_task, want_isr, want_queue_ops, want_queue_level, want_lost, want_low_power = syn.sent
+    tl, text = convert(data)
+    us = 1.0 / MHZ
+    exact = 0.01                # Cycles to us in floating point
+    tick = 1000.0               # The wake-up from STOP is known within a tick
+
+    check(text == bytes(syn.text), "text %r" % text[:80])
+    check(tl.lost == want_lost, "lost %d, expected %d" % (tl.lost, want_lost))
+    check(tl.missing == syn.missing == 1, "missing %d, expected %d" % (tl.missing, syn.missing))
+    close("low power us", tl.low_power, want_low_power * us, tick)
+
+    for task, name in TASKS.items():
+        check(tl.name(tc.EVT_NAME_TASK, task) == name[:12], "task %d named %s" % (task, tl.name(tc.EVT_NAME_TASK, task)))
+        got, want = tl.task.get(task), want_task[task]
+        if got is None:
+            check(False, "no record of %s" % name)
+            continue
+        close("%s cpu us" % name, got[0], want[0] * us, tick if task == IDLE else exact)
+        check(got[1] == want[1], "%s switches %d, expected %d" % (name, got[1], want[1]))
+        check(got[3] == want[3], "%s ready count %d, expected %d" % (name, got[3], want[3]))
+        close("%s ready sum us" % name, got[2], want[2] * us, exact * want[3])
+        close("%s ready max us" % name, got[4], want[4] * us, exact)
+    for q, (name, qtype) in QUEUES.items():
+        check(tl.name(tc.EVT_NAME_QUEUE, q) == name[:12], "queue %d named %s" % (q, tl.name(tc.EVT_NAME_QUEUE, q)))
+        check(tl.queue_type.get(q) == qtype, "%s type %s" % (name, tl.queue_type.get(q)))
+        check(tl.queue_level.get(q) == want_queue_level[q], "%s level %s, expected %d" % (name, tl.queue_level.get(q), want_queue_level[q]))
+    check(tl.queue_ops == want_queue_ops, "queue operations %s, expected %s" % (tl.queue_ops, want_queue_ops))
+
+    check(sorted(tl.isr) == sorted(want_isr), "interrupts %s" % sorted(tl.isr))
+    for exc, want in want_isr.items():
+        got = tl.isr.get(exc, [0, 0.0, 0.0])
+        check(got[0] == want[0], "%s count %d, expected %d" % (tl.isr_name(exc), got[0], want[0]))
+        close("%s total us" % tl.isr_name(exc), got[1], want[1] * us, exact * want[0])
+        close("%s max us" % tl.isr_name(exc), got[2], want[2] * us, exact)
+
+    # Timeline: loads as JSON, no slice goes back in time, the low power slice is there
+    trace = json.loads(json.dumps(tl.trace_json()))
+    slices = [e for e in trace["traceEvents"] if e["ph"] == "X"]
+    check(all(e["dur"] >= 0 for e in slices), "slice of negative duration")
+    power = [e for e in slices if e["tid"] == "power"]
+    check(len(power) == 1, "%d low power slices" % len(power))
+    wake = [e for e in slices if e["tid"] == "irq%d" % EXC_EXTI0]
+    check(power and wake and power[0]["ts"] + power[0]["dur"] <= wake[0]["ts"], "low power ends after the wake-up interrupt")
+    rows = {e["tid"] for e in trace["traceEvents"] if e["name"] == "thread_name"}
+    check(rows >= {"task%d" % t for t in TASKS} | {"irq%d" % e for e in want_isr}, "rows %s" % sorted(rows))
+    ts = [e["ts"] for e in trace["traceEvents"] if "ts" in e]
+    check(min(ts) >= tl.first and max(ts) <= tl.last_us, "event out of the capture")
+
+    # Command line on the committed capture
+    with tempfile.TemporaryDirectory() as tmp:
+        out_json, out_text = os.path.join(tmp, "trace.json"), os.path.join(tmp, "log.txt")
+        res = subprocess.run([sys.executable, os.path.join(os.path.dirname(CAPTURE), "trace_convert.py"), CAPTURE,
+                              "--json", out_json, "--text", out_text], stdout=subprocess.PIPE)
+        report = res.stdout.decode("latin-1")
+        check(res.returncode == 0, "trace_convert.py returned %d" % res.returncode)
+        check("%d records lost, 1 packets missing" % want_lost in report, "report:\n" + report)
+        for name in TASKS.values():
+            check(name[:12] in report, "%s not in the report" % name)
+        with open(out_text, "rb") as f:
+            check(f.read() == bytes(syn.text), "--text")
+        with open(out_json) as f:
+            check(len(json.load(f)["traceEvents"]) == len(trace["traceEvents"]), "--json")
+
+    print("%d bytes, %d packets, %.0f ms" % (len(data), syn.seq, (tl.last_us - tl.first) / 1e3))
+    print("FAILED" if g_fails else "all passed")
+    return 1 if g_fails else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
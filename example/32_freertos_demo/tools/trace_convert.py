@@ -0,0 +1,382 @@
+#!/usr/bin/env python3
+"""
+trace_convert.py - decode the 32_freertos_demo trace stream
+
+Usage: python trace_convert.py capture.bin [--json trace.json] [--text log.txt]
+       python trace_convert.py --port COM3 --seconds 10 [--save capture.bin] [--json trace.json]
+
+The board sends packets of trace records (ATK_Middlewares/TRACE/trace.h) on USART1, between
+the lines of printf. Capture the raw bytes (a terminal that logs binary, or --port), then:
+- the timeline goes to --json in the Trace Event format: open it in chrome://tracing or
+  https://ui.perfetto.dev. One row per task, per interrupt and for the low power idle, queue
+  operations as instant events and the queue levels as counters.
+- the tables are printed: CPU time per task (interrupts taken out), switches and the time
+  from ready to running (what makes a task miss its deadline), interrupts, queues.
+- the printf text goes to --text, or to stderr.
+The times come from the DWT cycle counter, rebased on the tick count of each SYNC record;
+the cycle counter stops in STOP, the time in STOP comes from the tick count. The wake-up is
+put at the start of its tick, the later SYNC records tell how much later it was: that goes to
+the low power time, and what came after the wake-up moves.
+--port requires pyserial (pip install pyserial).
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+SOF = b"\xA5\x5A"
+HEAD = 8
+PACKET_MAX = 64     # TRACE_PACKET_MAX
+
+EVT_SYNC = 0x01
+EVT_LOST = 0x02
+EVT_NAME_TASK = 0x03
+EVT_NAME_QUEUE = 0x04
+EVT_TASK_CREATE = 0x10
+EVT_TASK_DELETE = 0x11
+EVT_TASK_IN = 0x12
+EVT_TASK_OUT = 0x13
+EVT_TASK_READY = 0x14
+EVT_TICK = 0x15
+EVT_IDLE_SLEEP = 0x16
+EVT_QUEUE_CREATE = 0x20
+EVT_ISR_ENTER = 0x30
+EVT_ISR_EXIT = 0x31
+EVT_USER = 0x40
+
+QUEUE_OPS = {
+    0x21: ("send", 1), 0x22: ("send failed", 0), 0x23: ("receive", -1), 0x24: ("receive failed", 0),
+    0x25: ("block on send", 0), 0x26: ("block on receive", 0), 0x27: ("send from ISR", 1),
+    0x28: ("receive from ISR", -1),
+}
+QUEUE_TYPES = {0: "queue", 1: "mutex", 2: "counting semaphore", 3: "binary semaphore", 4: "recursive mutex"}
+
+# Exception numbers of the STM32F103xE (IRQn + 16)
+EXCEPTIONS = {
+    11: "SVCall", 14: "PendSV", 15: "SysTick", 22: "EXTI0", 23: "EXTI1", 24: "EXTI2", 25: "EXTI3",
+    26: "EXTI4", 27: "DMA1_Channel1", 28: "DMA1_Channel2", 29: "DMA1_Channel3", 30: "DMA1_Channel4",
+    31: "DMA1_Channel5", 32: "DMA1_Channel6", 33: "DMA1_Channel7", 34: "ADC1_2", 39: "EXTI9_5",
+    41: "TIM1_UP", 44: "TIM2", 45: "TIM3", 46: "TIM4", 47: "I2C1_EV", 51: "SPI1", 53: "USART1",
+    54: "USART2", 55: "USART3", 56: "EXTI15_10", 57: "RTC_Alarm", 66: "TIM5", 70: "UART5",
+    71: "TIM6", 72: "TIM7",
+}
+
+
+def split_stream(data):
+    """Yields ("packet", seq, records) and ("text", bytes) in the order of the stream"""
+    i = 0
+    text = bytearray()
+    while i < len(data):
+        if data[i:i + 2] == SOF and i + HEAD <= len(data):
+            count, seq, total = struct.unpack_from("<HHH", data, i + 2)
+            end = i + HEAD + count * 8
+            if 0 < count <= PACKET_MAX and end <= len(data) and sum(data[i + HEAD:end]) & 0xFFFF == total:
+                if text:
+                    yield ("text", bytes(text))
+                    text = bytearray()
+                yield ("packet", seq, [struct.unpack_from("<IBBH", data, j) for j in range(i + HEAD, end, 8)])
+                i = end
+                continue
+        text.append(data[i])
+        i += 1
+    if text:
+        yield ("text", bytes(text))
+
+
+class Timeline:
+    def __init__(self, mhz, tick_hz):
+        self.mhz = mhz
+        self.tick_us = 1e6 / tick_hz
+        self.anchor_us = None
+        self.anchor_cyc = 0
+        self.tick_hi = 0
+        self.tick_last = None
+        self.last_us = 0.0
+        self.sleeping = None            # time of the IDLE_SLEEP record
+        self.held = []                  # records after IDLE_SLEEP, timed by the next SYNC
+        self.guessed = False            # The last SYNC came from the tick only
+        self.stop = None                # Last STOP: [wake-up, first event after it, tasks running across it]
+
+        self.names = {}                 # (kind, id) -> bytes
+        self.queue_type = {}
+        self.queue_level = {}
+        self.events = []
+        self.running = None             # (task, start, isr time inside)
+        self.isr_stack = []             # [exception, start, nested isr time]
+        self.ready = {}
+        self.task = {}                  # id -> [cpu, switches, latency sum, latency count, latency max]
+        self.isr = {}                   # exception -> [count, total, max]
+        self.queue_ops = {}
+        self.lost = 0
+        self.low_power = 0.0
+        self.first = None
+        self.seq = None
+        self.missing = 0
+
+    # --- names -----------------------------------------------------------------------------
+    def name(self, kind, ident):
+        raw = self.names.get((kind, ident))
+        if raw:
+            return raw.split(b"\0")[0].decode("latin-1")
+        return ("task %d" if kind == EVT_NAME_TASK else "queue %d") % ident
+
+    def isr_name(self, exc):
+        return EXCEPTIONS.get(exc, "IRQ%d" % (exc - 16))
+
+    # --- time ------------------------------------------------------------------------------
+    def at(self, cyc):
+        return self.anchor_us + ((cyc - self.anchor_cyc) & 0xFFFFFFFF) / self.mhz
+
+    def sync(self, cyc, tick):
+        if self.tick_last is not None and tick < self.tick_last:
+            self.tick_hi += 1 << 24
+        self.tick_last = tick
+        tick_us = (self.tick_hi + tick) * self.tick_us
+        self.guessed = False
+        if self.anchor_us is not None:
+            pred = self.at(cyc)
+            if tick_us <= pred < tick_us + self.tick_us:
+                tick_us = pred          # The cycles ran all along: more precise than the tick
+            elif pred < tick_us and self.stop and self.sleeping is None:
+                self.late(tick_us - pred)
+            else:
+                tick_us = max(tick_us, self.last_us)
+                self.guessed = True
+        self.anchor_us = tick_us
+        self.anchor_cyc = cyc
+        return tick_us
+
+    # --- records ---------------------------------------------------------------------------
+    def packet(self, seq, records):
+        if self.seq is not None:
+            self.missing += (seq - self.seq - 1) & 0xFFFF
+        self.seq = seq
+        for rec in records:
+            self.record(*rec)
+
+    def record(self, cyc, kind, ident, arg):
+        if kind in (EVT_NAME_TASK, EVT_NAME_QUEUE):
+            raw = bytearray(self.names.get((kind, ident), b""))
+            raw += b"\0" * max(0, arg + 4 - len(raw))
+            raw[arg:arg + 4] = struct.pack("<I", cyc)
+            self.names[(kind, ident)] = bytes(raw)
+            return
+        if kind == EVT_SYNC:
+            t = self.sync(cyc, (ident << 16) | arg)
+            if self.sleeping is not None:
+                held, self.held = self.held, []
+                wake = t
+                for r in held:          # Times counted back from this SYNC
+                    wake = min(wake, t - ((self.anchor_cyc - r[0]) & 0xFFFFFFFF) / self.mhz)
+                self.power(self.sleeping, wake)
+                self.sleeping = None
+                if self.guessed:        # STOP: the wake-up is somewhere in this tick
+                    self.stop = [wake, len(self.events) - 1, set()]
+                for r in held:
+                    self.event(t - ((self.anchor_cyc - r[0]) & 0xFFFFFFFF) / self.mhz, *r[1:])
+            return
+        if self.anchor_us is None:
+            return                      # Before the first SYNC
+        if self.sleeping is not None:
+            self.held.append((cyc, kind, ident, arg))
+            return
+        t = self.at(cyc)
+        if kind == EVT_IDLE_SLEEP:
+            self.sleeping = max(t, self.last_us)
+            self.instant(self.sleeping, "power", "tickless idle, %d ticks expected" % arg)
+            return
+        self.event(t, kind, ident, arg)
+
+    def event(self, t, kind, ident, arg):
+        t = max(t, self.last_us)        # The rebasing may step back by less than a tick
+        self.last_us = t
+        if self.first is None:
+            self.first = t
+        if kind == EVT_TASK_IN:
+            self.running = [ident, t, 0.0]
+            st = self.task.setdefault(ident, [0.0, 0, 0.0, 0, 0.0])
+            st[1] += 1
+            if ident in self.ready:
+                lat = t - self.ready.pop(ident)
+                st[2] += lat
+                st[3] += 1
+                st[4] = max(st[4], lat)
+        elif kind == EVT_TASK_OUT:
+            if self.running and self.running[0] == ident:
+                start, isr = self.running[1], self.running[2]
+            else:
+                start, isr = self.first, 0.0        # Running since before the capture
+            self.task.setdefault(ident, [0.0, 0, 0.0, 0, 0.0])[0] += t - start - isr
+            if self.stop and start < self.stop[0] <= t:
+                self.stop[2].add(ident)             # Ran across the wake-up: the low power idle
+            self.slice("task%d" % ident, self.name(EVT_NAME_TASK, ident), start, t)
+            self.running = None
+        elif kind == EVT_TASK_READY:
+            self.ready.setdefault(ident, t)
+        elif kind in (EVT_TASK_CREATE, EVT_TASK_DELETE):
+            self.instant(t, "task%d" % ident, "created" if kind == EVT_TASK_CREATE else "deleted")
+        elif kind == EVT_ISR_ENTER:
+            self.isr_stack.append([ident, t, 0.0])
+        elif kind == EVT_ISR_EXIT:
+            if not self.isr_stack or self.isr_stack[-1][0] != ident:
+                return
+            exc, start, nested = self.isr_stack.pop()
+            dur = t - start
+            st = self.isr.setdefault(exc, [0, 0.0, 0.0])
+            st[0] += 1
+            st[1] += dur - nested
+            st[2] = max(st[2], dur)
+            if self.isr_stack:
+                self.isr_stack[-1][2] += dur
+            elif self.running:
+                self.running[2] += dur
+            self.slice("irq%d" % exc, self.isr_name(exc), start, t)
+        elif kind == EVT_QUEUE_CREATE:
+            self.queue_type[ident] = arg
+            self.queue_level[ident] = 0
+        elif kind in QUEUE_OPS:
+            op, delta = QUEUE_OPS[kind]
+            qname = self.name(EVT_NAME_QUEUE, ident)
+            self.queue_ops.setdefault((ident, op), 0)
+            self.queue_ops[(ident, op)] += 1
+            where = "irq%d" % self.isr_stack[-1][0] if self.isr_stack else \
+                    "task%d" % self.running[0] if self.running else "power"
+            self.instant(t, where, "%s %s" % (op, qname), {"waiting": arg})
+            self.queue_level[ident] = max(0, arg + delta)
+            self.events.append({"name": qname, "ph": "C", "ts": t, "pid": 1, "args": {"waiting": self.queue_level[ident]}})
+        elif kind == EVT_LOST:
+            self.lost += arg
+            self.instant(t, "power", "%d records lost" % arg)
+        elif kind == EVT_USER:
+            self.instant(t, "task%d" % self.running[0] if self.running else "power", "mark %d" % ident, {"arg": arg})
+
+    def late(self, err):
+        """The last wake-up from STOP was err us later than assumed: what came after it moves"""
+        wake, first, tasks = self.stop
+        self.low_power += err
+        for ev in self.events[first:]:
+            if ev["ts"] >= wake:
+                ev["ts"] += err
+            elif ev["ph"] == "X" and ev["ts"] + ev["dur"] >= wake:
+                ev["dur"] += err
+        for ident in tasks:
+            self.task[ident][0] += err
+        if self.running and self.running[1] >= wake:
+            self.running[1] += err
+        for st in self.isr_stack:
+            if st[1] >= wake:
+                st[1] += err
+        for ident, t in self.ready.items():
+            if t >= wake:
+                self.ready[ident] = t + err
+        self.last_us += err
+
+    # --- output ----------------------------------------------------------------------------
+    def slice(self, row, name, start, end):
+        self.events.append({"name": name, "ph": "X", "ts": start, "dur": end - start, "pid": 1, "tid": row})
+
+    def instant(self, t, row, name, args=None):
+        ev = {"name": name, "ph": "i", "s": "t", "ts": t, "pid": 1, "tid": row}
+        if args:
+            ev["args"] = args
+        self.events.append(ev)
+
+    def power(self, start, end):
+        self.low_power += end - start
+        self.slice("power", "low power", start, end)
+
+    def trace_json(self):
+        meta = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "STM32F103 FreeRTOS"}},
+                {"name": "thread_name", "ph": "M", "pid": 1, "tid": "power", "args": {"name": "low power idle"}}]
+        for ident in sorted(self.task):
+            meta.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": "task%d" % ident,
+                         "args": {"name": self.name(EVT_NAME_TASK, ident)}})
+        for exc in sorted(self.isr):
+            meta.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": "irq%d" % exc,
+                         "args": {"name": self.isr_name(exc)}})
+        return {"traceEvents": meta + self.events, "displayTimeUnit": "ms"}
+
+    def report(self, out):
+        span = (self.last_us - self.first) if self.first is not None else 0.0
+        if span <= 0:
+            out.write("no records\n")
+            return
+        out.write("capture %.3f s, %.1f%% in low power idle, %d records lost, %d packets missing\n\n"
+                  % (span / 1e6, self.low_power * 100 / span, self.lost, self.missing))
+        out.write("%-14s %10s %7s %9s %12s %12s\n" % ("task", "cpu ms", "cpu %", "switches", "ready avg us", "ready max us"))
+        for ident, st in sorted(self.task.items(), key=lambda kv: -kv[1][0]):
+            avg = st[2] / st[3] if st[3] else 0.0
+            out.write("%-14s %10.2f %7.2f %9d %12.1f %12.1f\n"
+                      % (self.name(EVT_NAME_TASK, ident), st[0] / 1e3, st[0] * 100 / span, st[1], avg, st[4]))
+        if self.isr:
+            out.write("\n%-14s %10s %7s %9s %12s\n" % ("interrupt", "cpu ms", "cpu %", "count", "max us"))
+            for exc, st in sorted(self.isr.items(), key=lambda kv: -kv[1][1]):
+                out.write("%-14s %10.2f %7.2f %9d %12.1f\n"
+                          % (self.isr_name(exc), st[1] / 1e3, st[1] * 100 / span, st[0], st[2]))
+        if self.queue_ops:
+            out.write("\n%-14s %-20s %-18s %9s\n" % ("queue", "type", "operation", "count"))
+            for (ident, op), n in sorted(self.queue_ops.items()):
+                out.write("%-14s %-20s %-18s %9d\n" % (self.name(EVT_NAME_QUEUE, ident),
+                          QUEUE_TYPES.get(self.queue_type.get(ident), "?"), op, n))
+
+
+def capture(port, baud, seconds):
+    import serial
+    ser = serial.Serial(port, baud, timeout=0.1)
+    data = bytearray()
+    end = time.time() + seconds
+    while time.time() < end:
+        data += ser.read(4096)
+    ser.close()
+    return bytes(data)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("capture", nargs="?", help="raw bytes received from the board")
+    ap.add_argument("--port", help="capture from this serial port instead")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--seconds", type=float, default=10.0)
+    ap.add_argument("--save", help="with --port: write the raw capture here")
+    ap.add_argument("--json", help="timeline in the Trace Event format")
+    ap.add_argument("--text", help="printf text found between the packets")
+    ap.add_argument("--cpu-mhz", type=float, default=72.0, help="DWT cycle counter clock (SystemCoreClock)")
+    ap.add_argument("--tick-hz", type=float, default=1000.0, help="configTICK_RATE_HZ")
+    args = ap.parse_args()
+
+    if args.port:
+        data = capture(args.port, args.baud, args.seconds)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(data)
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        ap.error("give a capture file or --port")
+
+    tl = Timeline(args.cpu_mhz, args.tick_hz)
+    text = bytearray()
+    for item in split_stream(data):
+        if item[0] == "packet":
+            tl.packet(item[1], item[2])
+        else:
+            text += item[1]
+
+    if args.text:
+        with open(args.text, "wb") as f:
+            f.write(text)
+    else:
+        sys.stderr.write(text.decode("latin-1"))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(tl.trace_json(), f)
+
+    tl.report(sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,718 @@
+/**
+ ****************************************************************************************************
+ * @file        trace_run.c
+ * @author      ALIENTEK
+ * @brief       Real run of ATK_Middlewares/TRACE on the FreeRTOS kernel, on a PC
+ *
+ *              The kernel of Middlewares/Third_Party/FreeRTOS runs on the host port of tools/port
+ *              (port.c: tasks on ucontext, a simulated 72MHz clock, the DWT cycle counter, PRIMASK
+ *              and IPSR), with the trace hooks of trace.h and trace.c unchanged. The application is
+ *              built like the demo: periodic tasks, printf on USART1, a key queue fed by EXTI0, a
+ *              semaphore given by the USART1 receive interrupt, a worker task created and deleted,
+ *              the tickless idle of lpidle.c in SLEEP or STOP, and the trace task sending its
+ *              packets by DMA at 115200 baud, whose end comes by the DMA and USART interrupts.
+ *
+ *              The bytes of USART1 (packets and printf text) go to the capture file. The run checks
+ *              the stream itself: checksums and sequence of the packets, the LOST records against
+ *              g_trace_lost, the name records, the order of the switch and interrupt records, the
+ *              printf text. The truth file keeps what the port saw (cycles and switches of each task,
+ *              interrupts, STOP) and what the application did with its queues, for
+ *              tools/trace_check.py --run, which runs trace_convert.py on the capture.
+ *              -l adds a task that writes 700 records at once: the ring overflows.
+ *
+ *              Build, from example/32_freertos_demo:
+ *                  gcc -O2 -Wall -IMiddlewares/Third_Party/FreeRTOS/Source/include -Itools/port -Itools/host
+ *                      -o trace_run tools/trace_run.c tools/port/port.c Middlewares/Third_Party/FreeRTOS/Source/tasks.c
+ *                      Middlewares/Third_Party/FreeRTOS/Source/queue.c Middlewares/Third_Party/FreeRTOS/Source/list.c
+ *                      Middlewares/Third_Party/FreeRTOS/Source/timers.c
+ *                      Middlewares/Third_Party/FreeRTOS/Source/portable/MemMang/heap_4.c
+ *
+ *              Run:
+ *                  ./trace_run [-s seed] [-l] [-v] capture.bin truth.json
+ *                  python tools/trace_check.py --run capture.bin truth.json
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform     : ALIENTEK STM32F103 development board
+ * website      : https://www.alientek.com
+ * forum        : http://www.openedv.com/forum.php
+ *
+ * change logs  :
+ * version      data        notes
+ * V1.0         20261019    the first version
+ *
+ ****************************************************************************************************
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "sim.h"
+#include "../ATK_Middlewares/TRACE/trace.c"
+
+
+#define CHECK(c, ...)   do{ if (!(c)){ printf("FAIL: " __VA_ARGS__); printf("\n"); if (++g_fails > 20)exit(1); } }while(0)
+
+#define RUN_MS                  3000
+#define CTRL_MS                 1000            /* The 20ms control task runs until then */
+#define BURST_MS                1500            /* -l: 700 records at once */
+#define BYTE_CYCLES             (configCPU_CLOCK_HZ / 115200 * 10)
+#define MS(x)                   ((uint64_t)(x) * SIM_TICK)
+
+/* Interrupt sources of port.c, 0 is SysTick */
+#define IRQ_EXTI0               1
+#define IRQ_USART1_RX           2
+#define IRQ_DMA1_CH4            3
+#define IRQ_USART1_TC           4
+
+UART_HandleTypeDef huart1;
+
+static uint8_t g_cap[1 << 20];                  /* Bytes of USART1 */
+static uint32_t g_cap_len = 0;
+static uint8_t g_text[1 << 16];                 /* The printf part */
+static uint32_t g_text_len = 0;
+static uint8_t g_uart_busy = 0;
+static uint32_t g_stop_lock = 0;
+static uint64_t g_low_power = 0;                /* Cycles in the tickless idle, SLEEP or STOP */
+
+static uint32_t g_main_tasks = 0;              /* Task numbers 1 ~ g_main_tasks are there from the start */
+static QueueHandle_t g_key_q;
+static SemaphoreHandle_t g_rx_sem;
+
+/* What the application did with its queues */
+static uint32_t g_key_sent = 0, g_key_recv = 0, g_key_block = 0;
+static uint32_t g_rx_given = 0, g_rx_taken = 0, g_rx_fail = 0, g_rx_block = 0;
+
+static int g_fails = 0;
+static int g_verbose = 0;
+static int g_lossy = 0;
+static uint32_t g_seed = 1;
+
+static StaticTask_t g_idle_tcb;
+static StackType_t g_idle_stack[configMINIMAL_STACK_SIZE];
+static StaticTask_t g_timer_tcb;
+static StackType_t g_timer_stack[configTIMER_TASK_STACK_DEPTH];
+
+static uint32_t sim_rand(void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return g_seed >> 8;
+}
+
+/******************************************************************************************/
+/* USART1, lpidle and the hooks of the demo */
+
+/**
+ * @brief   Bytes out of USART1, in the order they start
+ * @param   buf : bytes
+ * @param   len : length
+ * @retval  None
+ */
+static void uart_out(const uint8_t *buf, uint32_t len)
+{
+    if (g_cap_len + len > sizeof(g_cap))return;
+
+    memcpy(&g_cap[g_cap_len], buf, len);
+    g_cap_len += len;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (g_uart_busy)return HAL_BUSY;
+
+    g_uart_busy = 1;
+    uart_out(pData, Size);
+    sim_irq_at(IRQ_DMA1_CH4, sim_now() + (uint64_t)(Size - 1) * BYTE_CYCLES);  /* Last byte in the data register */
+    return HAL_OK;
+}
+
+/**
+ * @brief   printf of the demo: __io_putchar, one blocking HAL_UART_Transmit per character
+ * @param   fmt : format
+ * @retval  None
+ */
+static void app_printf(const char *fmt, ...)
+{
+    char buf[128];
+    va_list ap;
+    int len, i;
+
+    va_start(ap, fmt);
+    len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    for (i = 0; i < len; i++)
+    {
+        while (g_uart_busy)             /* A trace packet, or another task in the middle of a character */
+        {
+            if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING && __get_IPSR() == 0)vTaskDelay(1);
+        }
+
+        g_uart_busy = 1;
+        uart_out((uint8_t *)&buf[i], 1);
+
+        if (g_text_len < sizeof(g_text))g_text[g_text_len++] = buf[i];
+
+        sim_run(BYTE_CYCLES);           /* Polls TXE */
+        g_uart_busy = 0;
+    }
+}
+
+void lpidle_stop_lock(void)
+{
+    g_stop_lock++;
+}
+
+void lpidle_stop_unlock(void)
+{
+    g_stop_lock--;
+}
+
+/**
+ * @brief   portSUPPRESS_TICKS_AND_SLEEP as lpidle.c: STOP from LPIDLE_STOP_MIN_TICKS on, if no peripheral locks it
+ * @param   expected : ticks
+ * @retval  None
+ */
+void lpidle_suppress_ticks(uint32_t expected)
+{
+    uint64_t start = sim_now();
+
+    sim_sleep(expected, expected >= LPIDLE_STOP_MIN_TICKS && g_stop_lock == 0);
+    g_low_power += sim_now() - start;
+}
+
+void vApplicationIdleHook(void)
+{
+    sim_idle();
+}
+
+void configureTimerForRunTimeStats(void)
+{
+    trace_cycles_init();
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+    return trace_runtime();
+}
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &g_idle_tcb;
+    *ppxIdleTaskStackBuffer = g_idle_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer, uint32_t *pulTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &g_timer_tcb;
+    *ppxTimerTaskStackBuffer = g_timer_stack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+/******************************************************************************************/
+/* interrupts, as stm32f1xx_it.c */
+
+static void EXTI0_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+    uint8_t key = sim_rand() & 1;
+
+    TRACE_ISR_ENTER();
+    sim_run(300 + sim_rand() % 300);
+
+    if (xQueueSendFromISR(g_key_q, &key, &woken) == pdPASS)g_key_sent++;
+
+    sim_irq_at(IRQ_EXTI0, sim_now() + MS(60 + sim_rand() % 400));
+    TRACE_ISR_EXIT();
+    portYIELD_FROM_ISR(woken);
+}
+
+static void USART1_RX_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    TRACE_ISR_ENTER();
+    sim_run(200 + sim_rand() % 400);    /* A DMA or EXTI interrupt may come in the middle */
+
+    if (xSemaphoreGiveFromISR(g_rx_sem, &woken) == pdTRUE)g_rx_given++;
+
+    sim_irq_at(IRQ_USART1_RX, sim_now() + MS(20 + sim_rand() % 200));
+    TRACE_ISR_EXIT();
+    portYIELD_FROM_ISR(woken);
+}
+
+static void DMA1_Channel4_IRQHandler(void)
+{
+    TRACE_ISR_ENTER();
+    sim_run(120);
+    sim_irq_at(IRQ_USART1_TC, sim_now() + BYTE_CYCLES);     /* UART_DMATransmitCplt enables TC */
+    TRACE_ISR_EXIT();
+}
+
+static void USART1_TC_IRQHandler(void)
+{
+    TRACE_ISR_ENTER();
+    sim_run(150);
+    g_uart_busy = 0;
+    trace_tx_done(&huart1);             /* HAL_UART_TxCpltCallback */
+    TRACE_ISR_EXIT();
+}
+
+/******************************************************************************************/
+/* tasks */
+
+static void task01(void *arg)           /* LED */
+{
+    while (1)
+    {
+        sim_run(2000);
+        vTaskDelay(1000);
+    }
+}
+
+static void task02(void *arg)           /* printf */
+{
+    float num_float = 0.0f;
+
+    while (1)
+    {
+        num_float += 0.01f;
+        app_printf("num_float:%.2f\r\n", num_float);
+        vTaskDelay(500);
+    }
+}
+
+static void worker(void *arg)
+{
+    sim_run(20000 + sim_rand() % 20000);
+    app_printf("worker %u\r\n", (unsigned)(uintptr_t)arg);
+    vTaskDelete(NULL);
+}
+
+static void key_task(void *arg)
+{
+    uint8_t key;
+    uint32_t n = 0;
+
+    while (1)
+    {
+        if (uxQueueMessagesWaiting(g_key_q) == 0)g_key_block++;
+
+        if (xQueueReceive(g_key_q, &key, portMAX_DELAY) == pdPASS)g_key_recv++;
+
+        sim_run(1500 + sim_rand() % 3000);
+
+        if (++n % 3 == 0)xTaskCreate(worker, "worker", 256, (void *)(uintptr_t)n, 28, NULL);
+    }
+}
+
+static void cmd_task(void *arg)
+{
+    while (1)
+    {
+        if (uxSemaphoreGetCount(g_rx_sem) == 0)g_rx_block++;
+
+        if (xSemaphoreTake(g_rx_sem, pdMS_TO_TICKS(150)) == pdTRUE)
+        {
+            g_rx_taken++;
+            sim_run(800 + sim_rand() % 800);
+        }
+        else
+        {
+            g_rx_fail++;
+        }
+    }
+}
+
+static void ctrl_task(void *arg)
+{
+    TickType_t last = xTaskGetTickCount();
+    uint16_t n = 0;
+
+    while (xTaskGetTickCount() < pdMS_TO_TICKS(CTRL_MS))
+    {
+        trace_mark(1, n++);
+        sim_run(2000 + sim_rand() % 4000);
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(20));
+    }
+
+    vTaskDelete(NULL);
+}
+
+static void burst_task(void *arg)
+{
+    uint16_t i;
+
+    vTaskDelay(pdMS_TO_TICKS(BURST_MS));
+
+    for (i = 0; i < 700; i++)
+    {
+        trace_mark(2, i);
+    }
+
+    vTaskDelete(NULL);
+}
+
+/******************************************************************************************/
+/* checks */
+
+/**
+ * @brief   Decodes the capture as the host would and checks it against the run
+ * @param   None
+ * @retval  None
+ */
+static void check_stream(void)
+{
+    static uint8_t text[sizeof(g_text)];
+    static char names[2][256][TRACE_NAME_LEN + 1];
+    static uint8_t sent[2][256];        /* Name records at offset 0 */
+    uint8_t isr[16];
+    uint32_t text_len = 0;
+    uint32_t packets = 0, records = 0, lost = 0;
+    uint32_t i = 0, j, n, seq, sum, k;
+    uint8_t depth = 0, bad = 0;
+    int in = -1;
+    trace_rec_t r;
+    const char *want;
+
+    memset(names, 0, sizeof(names));
+    memset(sent, 0, sizeof(sent));
+
+    while (i < g_cap_len)
+    {
+        if (g_cap[i] == 0xA5 && i + TRACE_HEAD_SIZE <= g_cap_len && g_cap[i + 1] == 0x5A)
+        {
+            n = g_cap[i + 2] | g_cap[i + 3] << 8;
+            seq = g_cap[i + 4] | g_cap[i + 5] << 8;
+            sum = g_cap[i + 6] | g_cap[i + 7] << 8;
+
+            if (n > 0 && n <= TRACE_PACKET_MAX && i + TRACE_HEAD_SIZE + n * 8 <= g_cap_len)
+            {
+                for (j = 0, k = 0; j < n * 8; j++)k += g_cap[i + TRACE_HEAD_SIZE + j];
+
+                CHECK((k & 0xFFFF) == sum, "packet %u: sum %04x, expected %04x", packets, k & 0xFFFF, sum);
+                CHECK(seq == (packets & 0xFFFF), "packet %u: sequence %u", packets, seq);
+
+                for (j = 0; j < n; j++)
+                {
+                    memcpy(&r, &g_cap[i + TRACE_HEAD_SIZE + j * 8], 8);
+                    records++;
+
+                    switch (r.type)
+                    {
+                        case TRACE_EVT_LOST:
+                            lost += r.arg;
+                            break;
+
+                        case TRACE_EVT_NAME_TASK:
+                        case TRACE_EVT_NAME_QUEUE:
+                            if (r.arg + 4 <= TRACE_NAME_LEN)memcpy(&names[r.type - TRACE_EVT_NAME_TASK][r.id][r.arg], &r.time, 4);
+
+                            if (r.arg == 0 && sent[r.type - TRACE_EVT_NAME_TASK][r.id] < 255)sent[r.type - TRACE_EVT_NAME_TASK][r.id]++;
+                            break;
+
+                        case TRACE_EVT_ISR_ENTER:
+                            if (depth < sizeof(isr))isr[depth++] = r.id;
+                            break;
+
+                        case TRACE_EVT_ISR_EXIT:
+                            if (depth == 0 || isr[depth - 1] != r.id)bad++;
+                            else depth--;
+                            break;
+
+                        case TRACE_EVT_TASK_IN:
+                            if (in >= 0)bad++;
+                            in = r.id;
+                            break;
+
+                        case TRACE_EVT_TASK_OUT:
+                            if (in >= 0 && in != r.id)bad++;
+                            in = -1;
+                            break;
+                    }
+                }
+
+                packets++;
+                i += TRACE_HEAD_SIZE + n * 8;
+                continue;
+            }
+        }
+
+        if (text_len < sizeof(text))text[text_len++] = g_cap[i];
+
+        i++;
+    }
+
+    CHECK(packets == g_trace_seq, "%u packets, %u sent", packets, g_trace_seq);
+    CHECK(text_len == g_text_len && memcmp(text, g_text, text_len) == 0, "printf text %u bytes, expected %u", text_len, g_text_len);
+    CHECK(lost == g_trace_lost, "LOST records give %u, g_trace_lost %u", lost, (unsigned)g_trace_lost);
+    CHECK(g_trace_pending == 0, "%u lost records not reported", (unsigned)g_trace_pending);
+    CHECK(g_lossy ? g_trace_lost > 0 : g_trace_lost == 0, "%u records lost", (unsigned)g_trace_lost);
+    CHECK(g_lossy || (bad == 0 && depth == 0), "%u switch or interrupt records out of order, %u interrupts open", bad, depth);
+
+    for (k = 0; k < SIM_TASK_MAX; k++)
+    {
+        if (g_sim_task[k].name[0])
+        {
+            CHECK(strncmp(names[0][k], g_sim_task[k].name, TRACE_NAME_LEN) == 0 || (g_lossy && names[0][k][0] == 0),
+                  "task %u named '%s', expected '%s'", k, names[0][k], g_sim_task[k].name);
+        }
+    }
+
+    for (k = 1; k <= g_trace_queues; k++)
+    {
+        want = pcQueueGetName(k == uxQueueGetQueueNumber(g_key_q) ? g_key_q : k == uxQueueGetQueueNumber(g_rx_sem) ? g_rx_sem : NULL);
+
+        if (want)CHECK(strcmp(names[1][k], want) == 0, "queue %u named '%s', expected '%s'", k, names[1][k], want);
+    }
+
+    for (k = 1; k <= g_main_tasks && !g_lossy; k++)     /* At the creation and again after TRACE_NAMES_MS */
+    {
+        CHECK(sent[0][k] >= 2, "name of task %u sent %u times", k, sent[0][k]);
+    }
+
+    for (k = 1; k <= 2 && !g_lossy; k++)
+    {
+        CHECK(sent[1][k] >= 2, "name of queue %u sent %u times", k, sent[1][k]);
+    }
+
+    printf("%u bytes, %u packets, %u records, %u lost, %u STOP (%.1f ms)\n", g_cap_len, packets, records, lost,
+           g_sim_stops, g_sim_stop / (double)MS(1));
+}
+
+/**
+ * @brief   The ring at its limit, after the run: a LOST record needs a slot of its own
+ * @param   None
+ * @retval  None
+ */
+static void check_full(void)
+{
+    uint32_t lost = g_trace_lost, marks = 0, reported = 0;
+    uint16_t i, j, len, end;
+    trace_rec_t r;
+
+    for (i = 0; i <= TRACE_BUF_SIZE; i++)trace_mark(3, i);     /* The last one is dropped */
+
+    len = trace_fill(g_trace_tail + 1);                         /* One slot free */
+    marks += len ? 1 : 0;
+    trace_mark(3, i);                                           /* No room for the LOST record and this one */
+    CHECK((uint16_t)(g_trace_head - g_trace_tail) <= TRACE_BUF_SIZE, "%u records in a ring of %u",
+          (uint16_t)(g_trace_head - g_trace_tail), TRACE_BUF_SIZE);
+    CHECK(g_trace_lost - lost == 2 && g_trace_pending == 2, "%u lost, %u pending, expected 2", (unsigned)(g_trace_lost - lost),
+          (unsigned)g_trace_pending);
+
+    for (i = 0; i < 2; i++)
+    {
+        if (i)trace_sync();             /* Reports the lost records */
+
+        end = g_trace_head;
+
+        while ((len = trace_fill(end)) != 0)
+        {
+            for (j = TRACE_HEAD_SIZE; j < len; j += sizeof(trace_rec_t))
+            {
+                memcpy(&r, &g_trace_tx[j], sizeof(r));
+
+                if (r.type == TRACE_EVT_USER && r.id == 3)marks++;
+                else if (r.type == TRACE_EVT_LOST)reported += r.arg;
+            }
+        }
+    }
+
+    CHECK(marks == TRACE_BUF_SIZE && reported == 2, "full ring: %u records, %u reported lost, expected %u and 2", marks, reported, TRACE_BUF_SIZE);
+}
+
+/**
+ * @brief   Writes a JSON string
+ * @param   f : file
+ * @param   s : bytes
+ * @param   len : length
+ * @retval  None
+ */
+static void json_string(FILE *f, const uint8_t *s, uint32_t len)
+{
+    uint32_t i;
+
+    fputc('"', f);
+
+    for (i = 0; i < len; i++)
+    {
+        if (s[i] == '"' || s[i] == '\\')fprintf(f, "\\%c", s[i]);
+        else if (s[i] < 0x20 || s[i] >= 0x7F)fprintf(f, "\\u%04x", s[i]);
+        else fputc(s[i], f);
+    }
+
+    fputc('"', f);
+}
+
+/**
+ * @brief   What really happened, for tools/trace_check.py --run
+ * @param   f : file
+ * @retval  None
+ */
+static void write_truth(FILE *f)
+{
+    uint64_t count, total, max;
+    const char *sep = "";
+    uint8_t i, j, done[SIM_IRQ_MAX] = {0};
+    uint32_t k;
+
+    fprintf(f, "{\n  \"mhz\": %u, \"tick_hz\": %u, \"lost\": %u, \"stops\": %u, \"low_power\": %llu,\n",
+            configCPU_CLOCK_HZ / 1000000, (unsigned)configTICK_RATE_HZ, (unsigned)g_trace_lost, g_sim_stops, (unsigned long long)g_low_power);
+
+    fprintf(f, "  \"tasks\": {");
+
+    for (k = 0; k < SIM_TASK_MAX; k++)
+    {
+        if (g_sim_task[k].name[0] == 0)continue;
+
+        fprintf(f, "%s\n    \"%u\": {\"name\": \"%s\", \"cpu\": %llu, \"switches\": %u}", sep, k, g_sim_task[k].name,
+                (unsigned long long)g_sim_task[k].cpu, g_sim_task[k].switches);
+        sep = ",";
+    }
+
+    fprintf(f, "\n  },\n  \"isr\": {");
+    sep = "";
+
+    for (i = 1; i < SIM_IRQ_MAX; i++)   /* The sources of one exception together (USART1 RX and TC) */
+    {
+        if (g_sim_irq[i].isr == NULL || (g_sim_irq[i].flags & SIM_IRQ_TRACED) == 0 || done[i])continue;
+
+        count = total = max = 0;
+
+        for (j = i; j < SIM_IRQ_MAX; j++)
+        {
+            if (g_sim_irq[j].isr == NULL || g_sim_irq[j].exc != g_sim_irq[i].exc)continue;
+
+            done[j] = 1;
+            count += g_sim_irq[j].count;
+            total += g_sim_irq[j].total;
+
+            if (g_sim_irq[j].max > max)max = g_sim_irq[j].max;
+        }
+
+        fprintf(f, "%s\n    \"%u\": [%llu, %llu, %llu]", sep, g_sim_irq[i].exc, (unsigned long long)count,
+                (unsigned long long)total, (unsigned long long)max);
+        sep = ",";
+    }
+
+    fprintf(f, "\n  },\n  \"queues\": {\n");
+    fprintf(f, "    \"%u\": {\"name\": \"key_q\", \"level\": %u, \"ops\": {\"send from ISR\": %u, \"receive\": %u, \"block on receive\": %u}},\n",
+            (unsigned)uxQueueGetQueueNumber(g_key_q), (unsigned)uxQueueMessagesWaiting(g_key_q), g_key_sent, g_key_recv, g_key_block);
+    fprintf(f, "    \"%u\": {\"name\": \"rx_sem\", \"level\": %u, \"ops\": {\"send from ISR\": %u, \"receive\": %u, \"receive failed\": %u, \"block on receive\": %u}}\n",
+            (unsigned)uxQueueGetQueueNumber(g_rx_sem), (unsigned)uxQueueMessagesWaiting(g_rx_sem), g_rx_given, g_rx_taken, g_rx_fail, g_rx_block);
+    fprintf(f, "  },\n  \"text\": ");
+    json_string(f, g_text, g_text_len);
+    fprintf(f, "\n}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *cap = NULL, *truth = NULL;
+    uint32_t cyc0 = (uint32_t)(0 - MS(RUN_MS / 3));    /* The cycle counter wraps during the run */
+    uint16_t end, len;
+    FILE *f;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)g_seed = (uint32_t)strtoul(argv[++i], 0, 0);
+        else if (strcmp(argv[i], "-l") == 0)g_lossy = 1;
+        else if (strcmp(argv[i], "-v") == 0)g_verbose = 1;
+        else if (cap == NULL)cap = argv[i];
+        else truth = argv[i];
+    }
+
+    if (cap == NULL || truth == NULL)
+    {
+        printf("usage: trace_run [-s seed] [-l] [-v] capture.bin truth.json\n");
+        return 2;
+    }
+
+    g_sim_dwt.CYCCNT = cyc0;
+
+    /* main.c: trace_init before the tasks, then MX_FREERTOS_Init */
+    trace_init(&huart1);
+
+    g_key_q = xQueueCreate(4, 1);
+    vQueueAddToRegistry(g_key_q, "key_q");
+    g_rx_sem = xSemaphoreCreateBinary();
+    vQueueAddToRegistry(g_rx_sem, "rx_sem");
+
+    xTaskCreate(task01, "task01", 256, NULL, 24, NULL);
+    xTaskCreate(task02, "task02", 256, NULL, 24, NULL);
+    xTaskCreate(key_task, "key", 256, NULL, 30, NULL);
+    xTaskCreate(cmd_task, "cmd", 256, NULL, 26, NULL);
+    xTaskCreate(ctrl_task, "ctrl", 256, NULL, 40, NULL);
+
+    if (g_lossy)xTaskCreate(burst_task, "burst", 256, NULL, 45, NULL);
+
+    g_main_tasks = uxTaskGetNumberOfTasks();
+
+    sim_irq_init(IRQ_EXTI0, 22, 6, SIM_IRQ_TRACED | SIM_IRQ_WAKEUP, EXTI0_IRQHandler);
+    sim_irq_init(IRQ_USART1_RX, 53, 7, SIM_IRQ_TRACED, USART1_RX_IRQHandler);
+    sim_irq_init(IRQ_DMA1_CH4, 30, 5, SIM_IRQ_TRACED, DMA1_Channel4_IRQHandler);
+    sim_irq_init(IRQ_USART1_TC, 53, 7, SIM_IRQ_TRACED, USART1_TC_IRQHandler);
+    sim_irq_at(IRQ_EXTI0, MS(30));
+    sim_irq_at(IRQ_USART1_RX, MS(45));
+    sim_end(MS(RUN_MS));
+
+    vTaskStartScheduler();
+
+    /* Run time stats: the cycle counter extended over its wrap, without STOP */
+    CHECK(trace_runtime() == (uint32_t)((cyc0 + sim_now() - g_sim_stop) >> 10), "run time counter %u, expected %u",
+          (unsigned)trace_runtime(), (unsigned)((cyc0 + sim_now() - g_sim_stop) >> 10));
+
+    /* The host keeps reading: what is left in the ring, then a last SYNC and the lost records */
+    for (i = 0; i < 2; i++)
+    {
+        if (i)trace_sync();
+
+        end = g_trace_head;
+
+        while ((len = trace_fill(end)) != 0)uart_out(g_trace_tx, len);
+    }
+
+    check_stream();
+
+    f = fopen(cap, "wb");
+
+    if (f)
+    {
+        fwrite(g_cap, 1, g_cap_len, f);
+        fclose(f);
+    }
+
+    CHECK(f, "cannot write %s", cap);
+
+    f = fopen(truth, "w");
+
+    if (f)
+    {
+        write_truth(f);
+        fclose(f);
+    }
+
+    CHECK(f, "cannot write %s", truth);
+
+    check_full();
+
+    if (g_verbose)
+    {
+        for (i = 0; i < SIM_TASK_MAX; i++)
+        {
+            if (g_sim_task[i].name[0])printf("  task %2d %-12s %10.3f ms %6u switches\n", i, g_sim_task[i].name,
+                                             g_sim_task[i].cpu / (double)MS(1), g_sim_task[i].switches);
+        }
+    }
+
+    printf("%s\n", g_fails ? "FAILED" : "all passed");
+    return g_fails ? 1 : 0;
+}
@@ -14,170 +14,130 @@
  * change logs	:
  * version		data		notes
  * V1.0			20240410	the first version
+ * V1.1			20261019	DWT cycle counter delays, FreeRTOS support, delay_ms sleeps on the stimer service
+ * V1.2			20261019	delay_ms also initializes the factors when delay_init was not called (g_fac_ms)
  *
  ****************************************************************************************************
  */
 
 #include "delay.h"
+#include "stimer.h"
 
 
-static uint32_t g_fac_us = 0;       /* Multiplication factor for us delay */
+static uint32_t g_fac_us = 0;       /* Multiplication factor for us delay: CPU cycles per us */
 
-/* If SYS_SUPPORT_OS is defined, it means OS support is enabled (not limited to uC/OS) */
+/* If SYS_SUPPORT_OS is defined, it means OS support is enabled */
 #if SYS_SUPPORT_OS
 
-/* Include the common header file (required for uC/OS) */
-#include "os.h"
+/* Include the common header files (required for FreeRTOS) */
+#include "FreeRTOS.h"
+#include "task.h"
 
 /* Define the g_fac_ms variable, representing the multiplication factor for ms delay,
    indicating the number of ms per tick (only required when enabling OS support) */
 static uint16_t g_fac_ms = 0;
 
 /*
- * When delay_us/delay_ms needs to support an OS, three OS-related macros and functions are required:
- * First, three macros:
+ * When delay_ms needs to support an OS, three OS-related macros and a function are required:
  *     delay_osrunning    : Used to indicate whether the OS is currently running, determining whether relevant functions can be used
- *     delay_ostickspersec: Used to indicate the clock ticks set by the OS, delay_init will initialize SysTick based on this parameter
- *     delay_osintnesting : Used to indicate the nesting level of interrupts in the OS, because scheduling is not allowed inside interrupts, delay_ms uses this parameter to determine how to operate
- * Then, three functions:
- *     delay_osschedlock  : Used to lock OS task scheduling, disabling scheduling
- *     delay_osschedunlock: Used to unlock OS task scheduling, re-enabling scheduling
+ *     delay_ostickspersec: Used to indicate the clock ticks set by the OS
+ *     delay_osintnesting : Used to indicate whether the CPU is in an interrupt, because scheduling is not allowed inside interrupts
  *     delay_ostimedly    : Used for OS delay, can cause task scheduling.
  *
- * This example only supports uC/OS-II, for other OSes, please refer to this for porting.
+ * delay_us counts the cycles of the DWT, which go on while other tasks run, so it no longer locks
+ * the scheduler: a task switch only makes the delay longer. The OS owns SysTick (port.c), this file
+ * does not touch it. This port is for FreeRTOS, for other OSes, please refer to this for porting.
  */
 
-/* Support for uC/OS-II */
-#define delay_osrunning     OSRunning           /* OS running flag, 0: not running; 1: running */
-#define delay_ostickspersec OS_TICKS_PER_SEC    /* OS clock ticks, i.e., scheduling frequency per second */
-#define delay_osintnesting  OSIntNesting        /* Interrupt nesting level, i.e., number of interrupt nestings */
-
-
+/* Support for FreeRTOS */
+#define delay_osrunning     (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)    /* OS running flag */
+#define delay_ostickspersec configTICK_RATE_HZ                                      /* OS clock ticks, i.e., scheduling frequency per second */
+#define delay_osintnesting  __get_IPSR()                                            /* Non-zero in an interrupt */
 
 /**
- * @brief     Disable task scheduling during us-level delay (to prevent interruption of us-level delay)
- * @param     None
+ * @brief     OS delay, resume task scheduling
+ * @param     ticks: Number of ticks to delay
  * @retval    None
  */
-void delay_osschedlock(void)
+void delay_ostimedly(uint32_t ticks)
 {
-    OSSchedLock();  /* Disable scheduling in the UCOSII manner to prevent interruption of us-level delay */
+    vTaskDelay(ticks);  /* FreeRTOS delay */
 }
+#endif
 
 /**
- * @brief     Restore task scheduling during us-level delay
- * @param     None
+ * @brief     Initialize delay function
+ * @note      Starts the DWT cycle counter. The delays call it with SystemCoreClock if it was not called.
+ * @param     sysclk: System clock frequency, i.e., CPU frequency (rcc_c_ck), 72MHz
  * @retval    None
  */
-void delay_osschedunlock(void)
+void delay_init(uint16_t sysclk)
 {
-    OSSchedUnlock();  /* Restore scheduling in the UCOSII manner */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;     /* Enable the DWT */
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;                /* Start the cycle counter, it runs with or without a debugger */
+    g_fac_us = sysclk;
+#if SYS_SUPPORT_OS                                      /* If OS support is needed */
+    g_fac_ms = 1000 / delay_ostickspersec;              /* Represents the smallest unit OS can delay */
+#endif
 }
 
 /**
- * @brief     Delay at us-level, resume task scheduling
- * @param     ticks: Number of ticks to delay
+ * @brief     Calls delay_init with SystemCoreClock if it has not been called
+ * @note      Sets g_fac_us and, with an OS, g_fac_ms, which delay_ms divides by
+ * @param     None
  * @retval    None
  */
-void delay_ostimedly(uint32_t ticks)
+static void delay_check_init(void)
 {
-    OSTimeDly(ticks);  /* UCOSII delay */
-}
-
-/**
- * @brief     SysTick interrupt service routine, used when an OS is employed
- * @param     ticks : Number of ticks to delay
- * @retval    None
- */  
-void SysTick_Handler(void)
-{
-    /* Execute normal scheduling processing only when the OS is running */
-    if (delay_osrunning == OS_TRUE)
+    if (g_fac_us == 0)
     {
-        /* Call the SysTick interrupt service function of uC/OS-II */
-        OS_CPU_SysTickHandler();
+        delay_init(SystemCoreClock / 1000000);
     }
-    HAL_IncTick(); /* Increment HAL tick */
 }
-#endif
 
 /**
- * @brief     Initialize delay function
- * @param     sysclk: System clock frequency, i.e., CPU frequency (rcc_c_ck), 168MHz
+ * @brief     Delay in CPU cycles
+ * @note      Polls the DWT cycle counter: interrupts and other tasks keep running, and the time they
+ *            take counts in the delay
+ * @param     cycles: Number of cycles, 0 ~ 2^31
  * @retval    None
- */  
-void delay_init(uint16_t sysclk)
+ */
+void delay_cycles(uint32_t cycles)
 {
-#if SYS_SUPPORT_OS                                      /* If OS support is needed */
-    uint32_t reload;
-#endif
-    g_fac_us = sysclk;                                  /* As SysTick has been configured in HAL_Init, no need to reconfigure here */
-#if SYS_SUPPORT_OS                                      /* If OS support is needed */
-    reload = sysclk;                                    /* Number of counts per second, in Mega */
-    reload *= 1000000 / delay_ostickspersec;            /* Calculate reload value based on delay_ostickspersec, reload is 24-bit
-                                                         * maximum value: 16777216, approximately 0.09986s at 168M
-                                                         */
-    g_fac_ms = 1000 / delay_ostickspersec;              /* Represents the smallest unit OS can delay */
-    SysTick->CTRL |= 1 << 1;                            /* Enable SYSTICK interrupt */
-    SysTick->LOAD = reload;                             /* Interrupt every 1/delay_ostickspersec seconds */
-    SysTick->CTRL |= 1 << 0;                            /* Enable SYSTICK */
-#endif 
+    uint32_t start;
+
+    delay_check_init();
+
+    start = DWT->CYCCNT;
+
+    while (DWT->CYCCNT - start < cycles);
 }
 
 /**
  * @brief     Delay in microseconds (us)
- * @note      Regardless of whether OS is used, clock counting method is used for us delay
+ * @note      Regardless of whether OS is used, the DWT cycle counter is used for us delay
  * @param     nus: Number of microseconds to delay
- * @note      nus range: 0 ~ (2^32 / fac_us) (fac_us is generally equal to system main frequency, calculate accordingly)
+ * @note      nus range: 0 ~ (2^31 / fac_us) (fac_us is generally equal to system main frequency, calculate accordingly)
  * @retval    None
  */
 void delay_us(uint32_t nus)
 {
-    uint32_t ticks;
-    uint32_t told, tnow, tcnt = 0;
-    uint32_t reload = SysTick->LOAD;        /* Value of LOAD */
-    ticks = nus * g_fac_us;                 /* Number of ticks needed */
-    
-#if SYS_SUPPORT_OS                          /* If OS support is needed */
-    delay_osschedlock();                    /* Lock OS task scheduler */
-#endif
-
-    told = SysTick->VAL;                    /* Initial counter value */
-    while (1)
-    {
-        tnow = SysTick->VAL;
-        if (tnow != told)
-        {
-            if (tnow < told)
-            {
-                tcnt += told - tnow;        /* Note: SYSTICK is a decrementing counter */
-            }
-            else
-            {
-                tcnt += reload - tnow + told;
-            }
-            told = tnow;
-            if (tcnt >= ticks) 
-            {
-                break;                      /* Exit if time exceeds or equals the delay time */
-            }
-        }
-    }
-
-#if SYS_SUPPORT_OS                          /* If OS support is needed */
-    delay_osschedunlock();                  /* Restore OS task scheduler */
-#endif 
+    delay_check_init();
 
+    delay_cycles(nus * g_fac_us);
 }
 
 /**
 * @brief Delay nms
-* @param nms: The number of ms to delay (0< nms <= (2^32 / fac_us / 1000))(fac_us is generally equal to the system frequency, self-embedding calculation)
+* @note  In a task, the OS delay is used. With the stimer service running, the CPU sleeps between its
+*        ticks. Otherwise (or in an interrupt) the cycle counter is polled.
+* @param nms: The number of ms to delay (0 ~ 65535)
 * @retval None
 */
 void delay_ms(uint16_t nms)
 {
-    
+    delay_check_init();                                 /* g_fac_ms is used below */
+
 #if SYS_SUPPORT_OS  									/* If OS support is needed, call OS delay accordingly to release CPU */
     if (delay_osrunning && delay_osintnesting == 0)     /* If the OS is running and not in an interrupt (no task scheduling in interrupts) */
     {
@@ -190,5 +150,16 @@ void delay_ms(uint16_t nms)
     }
 #endif
 
-    delay_us((uint32_t)(nms * 1000));                   /* Normal delay method */
+#if STIMER_ENABLE
+    if (stimer_running() && __get_IPSR() == 0 && __get_PRIMASK() == 0)
+    {
+        stimer_sleep_us((uint32_t)nms * 1000);          /* Sleep, the timer interrupt wakes the CPU up */
+        return;
+    }
+#endif
+
+    while (nms--)
+    {
+        delay_us(1000);                                 /* Normal delay method */
+    }
 }
@@ -14,6 +14,7 @@
  * change logs	:
  * version		data		notes
  * V1.0			20240410	the first version
+ * V1.1			20261019	DWT cycle counter delays, FreeRTOS support, delay_ms sleeps on the stimer service
  *
  ****************************************************************************************************
  */
@@ -26,6 +27,7 @@
 void delay_init(uint16_t sysclk);       /* Initialize delay function */
 void delay_ms(uint16_t nms);            /* Delay in milliseconds */
 void delay_us(uint32_t nus);            /* Delay in microseconds */
+void delay_cycles(uint32_t cycles);     /* Delay in CPU cycles */
 
 #if (!SYS_SUPPORT_OS)                   /* If OS is not supported */
     void HAL_Delay(uint32_t Delay);     /* HAL library's delay function, used internally by HAL */
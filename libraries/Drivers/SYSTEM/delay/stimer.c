@@ -0,0 +1,284 @@
+/**
+ ****************************************************************************************************
+ * @file        stimer.c
+ * @author      ALIENTEK
+ * @brief       Timer service: free-running hardware timer, timer wheel of one-shot and periodic callbacks
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform  	: ALIENTEK STM32F103 development board
+ * website		: https://www.alientek.com
+ * forum		: http://www.openedv.com/forum.php
+ *
+ * change logs	:
+ * version		data		notes
+ * V1.0			20261019	the first version
+ * V1.1			20261019	the slots are sorted by due tick, a tick only looks at the heads; the FreeRTOS wait is
+ *                          removed (no FreeRTOS project runs the service)
+ *
+ ****************************************************************************************************
+ */
+
+#include <stddef.h>
+#include "stimer.h"
+
+
+static stimer_t *g_stimer_wheel[STIMER_SLOTS];
+static volatile uint32_t g_stimer_now = 0;
+
+/**
+ * @brief     Puts a timer in the slot of its expire tick, after the timers due before or at the same tick
+ * @note      The timers of a slot are due STIMER_SLOTS ticks apart, the walk only passes the earlier rounds
+ * @param     t : timer, interrupts disabled
+ * @retval    None
+ */
+static void stimer_link(stimer_t *t)
+{
+    stimer_t **slot = &g_stimer_wheel[t->expire & (STIMER_SLOTS - 1)];
+    stimer_t *prev = NULL;
+
+    while (*slot && (int32_t)((*slot)->expire - t->expire) <= 0)
+    {
+        prev = *slot;
+        slot = &prev->next;
+    }
+
+    t->prev = prev;
+    t->next = *slot;
+
+    if (*slot)(*slot)->prev = t;
+
+    *slot = t;
+    t->active = 1;
+}
+
+/**
+ * @brief     Takes a timer out of its slot
+ * @param     t : timer, interrupts disabled
+ * @retval    None
+ */
+static void stimer_unlink(stimer_t *t)
+{
+    if (t->prev)
+    {
+        t->prev->next = t->next;
+    }
+    else
+    {
+        g_stimer_wheel[t->expire & (STIMER_SLOTS - 1)] = t->next;
+    }
+
+    if (t->next)t->next->prev = t->prev;
+
+    t->active = 0;
+}
+
+/**
+ * @brief     Starts (or restarts) a timer
+ * @param     t : timer
+ * @param     delay : ticks to the first call, 0 is taken as 1. The current tick is partly over, so the
+ *                    first call comes after (delay - 1) ~ delay ticks.
+ * @param     period : ticks between the next calls, 0: one-shot
+ * @param     cb : callback, called from the timer interrupt
+ * @param     arg : argument of cb
+ * @retval    None
+ */
+void stimer_start(stimer_t *t, uint32_t delay, uint32_t period, stimer_cb_t cb, void *arg)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    if (t->active)stimer_unlink(t);
+
+    t->expire = g_stimer_now + (delay ? delay : 1);
+    t->period = period;
+    t->cb = cb;
+    t->arg = arg;
+    stimer_link(t);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief     Stops a timer, its callback is not called any more
+ * @param     t : timer
+ * @retval    None
+ */
+void stimer_stop(stimer_t *t)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    if (t->active)stimer_unlink(t);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief     A timer is waiting for a call
+ * @param     t : timer
+ * @retval    1, started; 0, stopped or one-shot done
+ */
+uint8_t stimer_active(stimer_t *t)
+{
+    return t->active;
+}
+
+/**
+ * @brief     Ticks since the start of the service
+ * @param     None
+ * @retval    Ticks, wraps after 2^32
+ */
+uint32_t stimer_now(void)
+{
+    return g_stimer_now;
+}
+
+/**
+ * @brief     One tick: calls the timers of the current slot that are due
+ * @note      The slot is sorted by due tick, so only its head is looked at: the timers of later rounds
+ *            are not walked. The head is read again after each callback, which may start or stop any timer
+ * @param     None
+ * @retval    None
+ */
+void stimer_tick(void)
+{
+    stimer_t *t;
+    uint32_t now = g_stimer_now + 1;
+    uint32_t primask;
+
+    g_stimer_now = now;
+
+    while (1)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        t = g_stimer_wheel[now & (STIMER_SLOTS - 1)];
+
+        if (t == NULL || t->expire != now)
+        {
+            __set_PRIMASK(primask);
+            break;
+        }
+
+        stimer_unlink(t);
+
+        if (t->period)
+        {
+            t->expire += t->period;     /* From the due tick, so a late tick does not shift the period */
+            stimer_link(t);
+        }
+
+        __set_PRIMASK(primask);
+        t->cb(t->arg);
+    }
+}
+
+#if STIMER_ENABLE
+
+/**
+ * @brief     Starts the hardware timer: 1MHz counter, update interrupt every STIMER_TICK_US
+ * @param     None
+ * @retval    None
+ */
+void stimer_init(void)
+{
+    STIMER_TIM_CLK_ENABLE();
+
+    STIMER_TIM->CR1 = 0;
+    STIMER_TIM->PSC = STIMER_TIM_CLK / 1000000 - 1;
+    STIMER_TIM->ARR = STIMER_TICK_US - 1;
+    STIMER_TIM->CNT = 0;
+    STIMER_TIM->EGR = TIM_EGR_UG;           /* Loads PSC */
+    STIMER_TIM->SR = 0;
+    STIMER_TIM->DIER = TIM_DIER_UIE;
+
+    HAL_NVIC_SetPriority(STIMER_TIM_IRQn, STIMER_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(STIMER_TIM_IRQn);
+
+    STIMER_TIM->CR1 = TIM_CR1_CEN;
+}
+
+/**
+ * @brief     The hardware timer is running
+ * @param     None
+ * @retval    1, running; 0, stimer_init not called
+ */
+uint8_t stimer_running(void)
+{
+    return (STIMER_TIM->CR1 & TIM_CR1_CEN) ? 1 : 0;
+}
+
+/**
+ * @brief     Timer interrupt
+ * @param     None
+ * @retval    None
+ */
+void STIMER_TIM_IRQHandler(void)
+{
+    if (STIMER_TIM->SR & TIM_SR_UIF)
+    {
+        STIMER_TIM->SR = ~TIM_SR_UIF;
+        stimer_tick();
+    }
+}
+
+/**
+ * @brief     Free-running time
+ * @note      Also right with the interrupts disabled for less than a tick: an update that has not been
+ *            served yet is counted from its flag
+ * @param     None
+ * @retval    Time in us
+ */
+uint32_t stimer_us(void)
+{
+    uint32_t ticks, cnt, uif;
+
+    do
+    {
+        ticks = g_stimer_now;
+        cnt = STIMER_TIM->CNT;
+        uif = STIMER_TIM->SR & TIM_SR_UIF;
+    } while (ticks != g_stimer_now);
+
+    if (uif && cnt < STIMER_TICK_US / 2)ticks++;
+
+    return ticks * STIMER_TICK_US + cnt;
+}
+
+/**
+ * @brief     Waits until a tick
+ * @note      The CPU sleeps (WFI) and each tick wakes it up
+ * @param     tick : stimer_now() to reach
+ * @retval    None
+ */
+void stimer_wait_until(uint32_t tick)
+{
+    while ((int32_t)(tick - g_stimer_now) > 0)
+    {
+        __WFI();
+    }
+}
+
+/**
+ * @brief     Waits a time, sleeping until the last tick and polling the counter after it
+ * @param     us : time in us
+ * @retval    None
+ */
+void stimer_sleep_us(uint32_t us)
+{
+    uint32_t end = stimer_us() + us;
+
+    while ((int32_t)(end - stimer_us()) > STIMER_TICK_US)
+    {
+        __WFI();                            /* The next update comes before the end */
+    }
+
+    while ((int32_t)(end - stimer_us()) > 0);
+}
+
+#endif
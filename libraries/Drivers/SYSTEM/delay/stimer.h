@@ -0,0 +1,85 @@
+/**
+ ****************************************************************************************************
+ * @file        stimer.h
+ * @author      ALIENTEK
+ * @brief       Timer service: free-running hardware timer, timer wheel of one-shot and periodic callbacks
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform  	: ALIENTEK STM32F103 development board
+ * website		: https://www.alientek.com
+ * forum		: http://www.openedv.com/forum.php
+ *
+ * change logs	:
+ * version		data		notes
+ * V1.0			20261019	the first version
+ * V1.1			20261019	slots sorted by due tick, bare-metal only
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __STIMER_H
+#define __STIMER_H
+#include "main.h"
+
+
+/*
+ * The hardware timer is only used by the projects that define STIMER_ENABLE = 1 (compiler symbols),
+ * the others keep the timer for themselves. It runs at 1MHz and interrupts once per tick.
+ * The service is for the bare-metal examples: under FreeRTOS the tasks wait with vTaskDelay/vTaskDelayUntil,
+ * and a 1ms interrupt would wake a tickless idle up.
+ */
+#ifndef STIMER_ENABLE
+#define STIMER_ENABLE           0
+#endif
+
+#ifndef STIMER_TIM
+#define STIMER_TIM              TIM5
+#define STIMER_TIM_IRQn         TIM5_IRQn
+#define STIMER_TIM_IRQHandler   TIM5_IRQHandler
+#define STIMER_TIM_CLK_ENABLE() __HAL_RCC_TIM5_CLK_ENABLE()
+#define STIMER_TIM_CLK          72000000    /* APB1 timer clock */
+#endif
+
+#ifndef STIMER_IRQ_PRIO
+#define STIMER_IRQ_PRIO         3
+#endif
+
+#define STIMER_TICK_US          1000        /* One tick per ms */
+#define STIMER_SLOTS            64          /* Slots of the wheel, must be a power of 2 */
+
+typedef void (*stimer_cb_t)(void *arg);
+
+/*
+ * A timer waits in the slot (expire % STIMER_SLOTS) of the wheel, each slot is sorted by due tick.
+ * Stopping a timer is an unlink, starting it a link after the timers of its slot due before it, and
+ * each tick only looks at the head of one slot: the timers due more than STIMER_SLOTS ticks later
+ * stay behind it until their turn. The callbacks run in the timer interrupt.
+ */
+typedef struct stimer
+{
+    struct stimer *next;
+    struct stimer *prev;
+    uint32_t expire;                    /* Tick of the next call */
+    uint32_t period;                    /* 0: one-shot */
+    stimer_cb_t cb;
+    void *arg;
+    uint8_t active;
+} stimer_t;
+
+void stimer_start(stimer_t *t, uint32_t delay, uint32_t period, stimer_cb_t cb, void *arg);    /* First call after delay ticks */
+void stimer_stop(stimer_t *t);
+uint8_t stimer_active(stimer_t *t);
+uint32_t stimer_now(void);                                              /* Ticks since stimer_init */
+void stimer_tick(void);                                                 /* One tick: calls the timers due */
+
+#if STIMER_ENABLE
+void stimer_init(void);                                                 /* Starts the hardware timer */
+uint8_t stimer_running(void);
+uint32_t stimer_us(void);                                               /* Free-running time in us, wraps after 71 minutes */
+void stimer_wait_until(uint32_t tick);                                  /* Sleeps until stimer_now() reaches tick */
+void stimer_sleep_us(uint32_t us);                                      /* Sleeps between the ticks, exact to 1us */
+#endif
+
+#endif
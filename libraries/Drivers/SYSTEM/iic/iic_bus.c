@@ -0,0 +1,549 @@
+/**
+ ****************************************************************************************************
+ * @file        iic_bus.c
+ * @author      ALIENTEK
+ * @brief       IIC transaction engine
+ *
+ *              Each bus has a queue of transfers (iic_xfer_t). A timer interrupt at twice IIC_BUS_SCL_FREQ
+ *              moves every busy bus by one edge (half an SCL period), so the interrupt never waits for the
+ *              bus and the CPU is free between the edges. The timer runs only while a transfer is queued.
+ *              The pins are driven open drain through BSRR/IDR. SCL is read back before each bit is sampled
+ *              and before the SDA edge of a START or STOP: while the slave holds it low (clock stretching)
+ *              the bus waits, up to IIC_BUS_STRETCH_MAX interrupts, and SCL is then kept high for one more
+ *              interrupt before the bit is sampled. A stretch that ends before the next interrupt is not seen,
+ *              SCL is then high for less than half a period.
+ *
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform  	: ALIENTEK STM32F103 development board
+ * website		: https://www.alientek.com
+ * forum		: http://www.openedv.com/forum.php
+ *
+ * change logs	:
+ * version		data		notes
+ * V1.0			20261019	the first version
+ * V1.1			20261019	shared by the examples (IIC_BUS_ENABLE), one interrupt per byte, SCL read back at START/STOP,
+ *                          the blocking transfers sleep
+ * V1.2			20261019	one edge per interrupt instead of a DWT wait in the interrupt, SCL 50kHz, SCL kept high
+ *                          for half a period after clock stretching, the status of a failed transfer is only set
+ *                          at its STOP (a blocking caller returned while its transfer was still on the bus)
+ *
+ ****************************************************************************************************
+ */
+
+#include "iic_bus.h"
+
+#if IIC_BUS_ENABLE
+
+/* Bit state */
+#define IIC_STA_IDLE        0
+#define IIC_STA_START1      1       /* SDA high (SCL may be low for a repeated START) */
+#define IIC_STA_START2      2       /* SCL high */
+#define IIC_STA_START3      3       /* SCL read back high, SDA low: START */
+#define IIC_STA_LOW         4       /* Sample the previous bit, SCL low, drive the next bit */
+#define IIC_STA_HIGH        5       /* SCL high */
+#define IIC_STA_STOP1       6       /* SDA low */
+#define IIC_STA_STOP2       7       /* SCL high */
+#define IIC_STA_STOP3       8       /* SCL read back high, SDA high: STOP */
+
+/* Transfer phase */
+#define IIC_PH_ADDR_W       0       /* Slave address, write */
+#define IIC_PH_REG          1       /* Register address */
+#define IIC_PH_WDATA        2       /* Data written */
+#define IIC_PH_ADDR_R       3       /* Slave address, read */
+#define IIC_PH_RDATA        4       /* Data read */
+
+#define IIC_SCL(bus, x)     ((bus)->scl_port->BSRR = (x) ? (bus)->scl_pin : (uint32_t)(bus)->scl_pin << 16)
+#define IIC_SDA(bus, x)     ((bus)->sda_port->BSRR = (x) ? (bus)->sda_pin : (uint32_t)(bus)->sda_pin << 16)
+#define IIC_SCL_READ(bus)   (((bus)->scl_port->IDR & (bus)->scl_pin) ? 1 : 0)
+#define IIC_SDA_READ(bus)   (((bus)->sda_port->IDR & (bus)->sda_pin) ? 1 : 0)
+
+static iic_bus_t *g_iic_bus_tab[IIC_BUS_MAX];   /* Registered buses */
+static uint8_t g_iic_bus_num = 0;
+
+/**
+ * @brief   Initializes the timer that clocks the buses, one interrupt per edge
+ * @param   None
+ * @retval  None
+ */
+static void iic_bus_tim_init(void)
+{
+    uint32_t clk = HAL_RCC_GetPCLK1Freq();
+
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+    {
+        clk *= 2;                   /* The APB1 timers run at twice PCLK1 when APB1 is divided */
+    }
+
+    IIC_BUS_TIMX_CLK_ENABLE();
+    IIC_BUS_TIMX->CR1 = 0;
+    IIC_BUS_TIMX->PSC = 0;
+    IIC_BUS_TIMX->ARR = clk / (2 * IIC_BUS_SCL_FREQ) - 1;
+    IIC_BUS_TIMX->EGR = TIM_EGR_UG;
+    IIC_BUS_TIMX->SR = 0;
+    IIC_BUS_TIMX->DIER = TIM_DIER_UIE;
+
+    HAL_NVIC_SetPriority(IIC_BUS_TIMX_IRQn, IIC_BUS_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(IIC_BUS_TIMX_IRQn);
+}
+
+/**
+ * @brief   Registers a bus
+ * @note    The GPIO clocks must be enabled, the pins are configured as open drain outputs
+ * @param   bus: bus, scl_port/scl_pin/sda_port/sda_pin filled in
+ * @retval  0, successful; 1, too many buses
+ */
+uint8_t iic_bus_add(iic_bus_t *bus)
+{
+    GPIO_InitTypeDef gpio_init_struct = {0};
+    uint8_t i;
+
+    for (i = 0; i < g_iic_bus_num; i++)
+    {
+        if (g_iic_bus_tab[i] == bus)return 0;   /* Already registered */
+    }
+
+    if (g_iic_bus_num >= IIC_BUS_MAX)return 1;
+
+    IIC_SCL(bus, 1);
+    IIC_SDA(bus, 1);
+    gpio_init_struct.Mode = GPIO_MODE_OUTPUT_OD;
+    gpio_init_struct.Pull = GPIO_PULLUP;
+    gpio_init_struct.Speed = GPIO_SPEED_FREQ_HIGH;
+    gpio_init_struct.Pin = bus->scl_pin;
+    HAL_GPIO_Init(bus->scl_port, &gpio_init_struct);
+    gpio_init_struct.Pin = bus->sda_pin;
+    HAL_GPIO_Init(bus->sda_port, &gpio_init_struct);
+
+    bus->head = NULL;
+    bus->tail = NULL;
+    bus->sta = IIC_STA_IDLE;
+    bus->xfers = 0;
+    bus->bytes = 0;
+    bus->nacks = 0;
+    bus->stretches = 0;
+
+    if (g_iic_bus_num == 0)
+    {
+        iic_bus_tim_init();
+    }
+
+    HAL_NVIC_DisableIRQ(IIC_BUS_TIMX_IRQn);
+    g_iic_bus_tab[g_iic_bus_num++] = bus;
+    HAL_NVIC_EnableIRQ(IIC_BUS_TIMX_IRQn);
+    return 0;
+}
+
+/**
+ * @brief   Loads the next byte of the current phase
+ * @param   bus: bus
+ * @retval  None
+ */
+static void iic_bus_load(iic_bus_t *bus)
+{
+    iic_xfer_t *xfer = bus->head;
+
+    bus->clk = 0;
+    bus->rx = 0;
+
+    switch (bus->phase)
+    {
+        case IIC_PH_ADDR_W:
+            bus->data = xfer->addr & 0XFE;
+            break;
+
+        case IIC_PH_REG:
+            bus->data = (xfer->reg_len - bus->idx == 2) ? xfer->reg >> 8 : xfer->reg & 0XFF;
+            break;
+
+        case IIC_PH_WDATA:
+            bus->data = xfer->buf[bus->idx];
+            break;
+
+        case IIC_PH_ADDR_R:
+            bus->data = xfer->addr | 0X01;
+            break;
+
+        default:
+            bus->data = 0;
+            bus->rx = 1;
+            break;
+    }
+}
+
+/**
+ * @brief   Chooses what follows a completed byte (SCL is low)
+ * @param   bus: bus
+ * @param   nack: ACK bit sampled after a sent byte
+ * @retval  None, bus->sta is IIC_STA_LOW for another byte, IIC_STA_START1 or IIC_STA_STOP1
+ */
+static void iic_bus_byte_done(iic_bus_t *bus, uint8_t nack)
+{
+    iic_xfer_t *xfer = bus->head;
+
+    if (bus->rx)
+    {
+        xfer->buf[bus->idx] = bus->data;
+    }
+    else if (nack)
+    {
+        bus->nack = 1;
+        bus->sta = IIC_STA_STOP1;
+        return;
+    }
+
+    bus->bytes++;
+    bus->idx++;
+    bus->sta = IIC_STA_STOP1;
+
+    switch (bus->phase)
+    {
+        case IIC_PH_ADDR_W:
+            bus->idx = 0;
+
+            if (xfer->reg_len)
+            {
+                bus->phase = IIC_PH_REG;
+                bus->sta = IIC_STA_LOW;
+            }
+            else if (xfer->len)
+            {
+                bus->phase = IIC_PH_WDATA;
+                bus->sta = IIC_STA_LOW;
+            }
+
+            break;
+
+        case IIC_PH_REG:
+            if (bus->idx < xfer->reg_len)
+            {
+                bus->sta = IIC_STA_LOW;
+            }
+            else if (xfer->dir == IIC_XFER_RD)
+            {
+                bus->phase = IIC_PH_ADDR_R;     /* Repeated START, then the read address */
+                bus->sta = IIC_STA_START1;
+            }
+            else if (xfer->len)
+            {
+                bus->phase = IIC_PH_WDATA;
+                bus->idx = 0;
+                bus->sta = IIC_STA_LOW;
+            }
+
+            break;
+
+        case IIC_PH_ADDR_R:
+            bus->phase = IIC_PH_RDATA;
+            bus->idx = 0;
+            bus->sta = IIC_STA_LOW;
+            break;
+
+        default:    /* IIC_PH_WDATA, IIC_PH_RDATA */
+            if (bus->idx < xfer->len)bus->sta = IIC_STA_LOW;
+
+            break;
+    }
+
+    if (bus->sta == IIC_STA_LOW)iic_bus_load(bus);
+}
+
+/**
+ * @brief   Ends the current transfer and starts the next one
+ * @param   bus: bus
+ * @retval  None
+ */
+static void iic_bus_finish(iic_bus_t *bus)
+{
+    iic_xfer_t *xfer = bus->head;
+
+    bus->head = xfer->next;
+
+    if (bus->head == NULL)bus->tail = NULL;
+
+    bus->sta = IIC_STA_IDLE;
+    bus->xfers++;
+
+    if (bus->nack)
+    {
+        bus->nacks++;
+    }
+
+    xfer->sta = bus->nack ? IIC_XFER_NACK : IIC_XFER_OK;    /* Only now: a blocking caller returns once it changes */
+
+    if (xfer->cb)xfer->cb(xfer);    /* The callback may queue another transfer */
+}
+
+/**
+ * @brief   SCL is held low by the slave after it was released: counts the interrupts it lasts
+ * @param   bus: bus
+ * @retval  1, wait for the next interrupt (SCL low, or just released by the slave: it stays high for
+ *          half a period first); 0, go on (SCL is high, or held low for too long)
+ */
+static uint8_t iic_bus_stretched(iic_bus_t *bus)
+{
+    if (IIC_SCL_READ(bus))
+    {
+        if (bus->stretch == 0)return 0;
+
+        bus->stretch = 0;
+        return 1;
+    }
+
+    if (bus->stretch == 0)bus->stretches++;
+
+    if (++bus->stretch < IIC_BUS_STRETCH_MAX)return 1;
+
+    bus->stretch = 0;
+    bus->nack = 1;                          /* SCL stuck low */
+    return 0;
+}
+
+/**
+ * @brief   Moves a bus forward by one edge (half an SCL period)
+ * @note    SCL changes at most once, and SDA only after SCL is low or for a START/STOP
+ * @param   bus: bus
+ * @retval  None
+ */
+static void iic_bus_step(iic_bus_t *bus)
+{
+    uint8_t bit = 0;
+
+    switch (bus->sta)
+    {
+        case IIC_STA_IDLE:
+            if (bus->head == NULL)return;
+
+            bus->phase = (bus->head->dir == IIC_XFER_RD && bus->head->reg_len == 0) ? IIC_PH_ADDR_R : IIC_PH_ADDR_W;
+            bus->idx = 0;
+            bus->nack = 0;
+            /* fall through */
+
+        case IIC_STA_START1:
+            IIC_SDA(bus, 1);
+            bus->sta = IIC_STA_START2;
+            break;
+
+        case IIC_STA_START2:
+            IIC_SCL(bus, 1);
+            bus->stretch = 0;
+            bus->sta = IIC_STA_START3;
+            break;
+
+        case IIC_STA_START3:
+            if (iic_bus_stretched(bus))return;
+
+            if (bus->nack)          /* SCL stuck low: no START, end the transfer */
+            {
+                bus->sta = IIC_STA_STOP1;
+                break;
+            }
+
+            IIC_SDA(bus, 0);
+            iic_bus_load(bus);
+            bus->sta = IIC_STA_LOW;
+            break;
+
+        case IIC_STA_LOW:
+            if (bus->clk)
+            {
+                if (iic_bus_stretched(bus))return;
+
+                if (bus->nack)      /* SCL stuck low: end the transfer */
+                {
+                    bus->sta = IIC_STA_STOP1;
+                    break;
+                }
+
+                bit = IIC_SDA_READ(bus);
+
+                if (bus->clk <= 8)
+                {
+                    if (bus->rx)bus->data = (bus->data << 1) | bit;
+                }
+            }
+
+            IIC_SCL(bus, 0);
+
+            if (bus->clk == 9)      /* The byte and its ACK are done, the next one from the next interrupt */
+            {
+                iic_bus_byte_done(bus, bit);
+                break;
+            }
+
+            if (bus->clk < 8)
+            {
+                IIC_SDA(bus, bus->rx ? 1 : (bus->data >> (7 - bus->clk)) & 1);
+            }
+            else        /* ACK slot: release SDA when sending, ACK all the received bytes but the last */
+            {
+                IIC_SDA(bus, bus->rx ? (bus->idx == bus->head->len - 1) : 1);
+            }
+
+            bus->sta = IIC_STA_HIGH;
+            break;
+
+        case IIC_STA_HIGH:
+            IIC_SCL(bus, 1);
+            bus->clk++;
+            bus->sta = IIC_STA_LOW;
+            break;
+
+        case IIC_STA_STOP1:
+            IIC_SDA(bus, 0);
+            bus->sta = IIC_STA_STOP2;
+            break;
+
+        case IIC_STA_STOP2:
+            IIC_SCL(bus, 1);
+            bus->stretch = 0;
+            bus->sta = IIC_STA_STOP3;
+            break;
+
+        case IIC_STA_STOP3:
+            if (iic_bus_stretched(bus))return;
+
+            IIC_SDA(bus, 1);
+            iic_bus_finish(bus);
+            break;
+    }
+}
+
+/**
+ * @brief   Timer interrupt, moves each busy bus by one edge and stops when they are idle
+ * @param   None
+ * @retval  None
+ */
+void IIC_BUS_TIMX_IRQHandler(void)
+{
+    uint8_t i;
+    uint8_t busy = 0;
+
+    IIC_BUS_TIMX->SR = ~TIM_SR_UIF;
+
+    for (i = 0; i < g_iic_bus_num; i++)
+    {
+        iic_bus_step(g_iic_bus_tab[i]);
+
+        if (g_iic_bus_tab[i]->sta != IIC_STA_IDLE || g_iic_bus_tab[i]->head != NULL)busy = 1;
+    }
+
+    if (busy == 0)
+    {
+        IIC_BUS_TIMX->CR1 &= ~TIM_CR1_CEN;
+    }
+}
+
+/**
+ * @brief   Queues a transfer, returns at once
+ * @note    xfer->sta stays IIC_XFER_PENDING until the transfer is done, then xfer->cb is called
+ * @param   bus : bus
+ * @param   xfer: transfer
+ * @retval  0, queued; 1, invalid transfer
+ */
+uint8_t iic_bus_submit(iic_bus_t *bus, iic_xfer_t *xfer)
+{
+    if (xfer->reg_len > 2 || (xfer->dir == IIC_XFER_RD && xfer->len == 0))
+    {
+        xfer->sta = IIC_XFER_NACK;
+        return 1;
+    }
+
+    xfer->sta = IIC_XFER_PENDING;
+    xfer->next = NULL;
+
+    HAL_NVIC_DisableIRQ(IIC_BUS_TIMX_IRQn);
+
+    if (bus->tail)
+    {
+        bus->tail->next = xfer;
+    }
+    else
+    {
+        bus->head = xfer;
+    }
+
+    bus->tail = xfer;
+    IIC_BUS_TIMX->CR1 |= TIM_CR1_CEN;
+    HAL_NVIC_EnableIRQ(IIC_BUS_TIMX_IRQn);
+    return 0;
+}
+
+/**
+ * @brief   Queues a transfer and sleeps until it is done
+ * @note    The CPU sleeps (WFI) between the interrupts, the other interrupts keep running. With interrupts
+ *          disabled around the test, the end of the transfer can not slip in between the test and the WFI:
+ *          a pending interrupt wakes the CPU up even when it is masked, then runs once it is unmasked
+ * @param   bus : bus
+ * @param   xfer: transfer
+ * @retval  IIC_XFER_OK or IIC_XFER_NACK
+ */
+uint8_t iic_bus_xfer(iic_bus_t *bus, iic_xfer_t *xfer)
+{
+    uint32_t primask;
+
+    if (iic_bus_submit(bus, xfer))return IIC_XFER_NACK;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    while (xfer->sta == IIC_XFER_PENDING)
+    {
+        __WFI();
+        __set_PRIMASK(primask);     /* The interrupt that woke the CPU up runs here */
+        __disable_irq();
+    }
+
+    __set_PRIMASK(primask);
+    return xfer->sta;
+}
+
+/**
+ * @brief   Reads registers (blocking)
+ * @param   bus    : bus
+ * @param   addr   : slave address, 8-bit write form
+ * @param   reg    : register address
+ * @param   reg_len: register address length, 0~2 bytes
+ * @param   buf    : data read
+ * @param   len    : number of bytes
+ * @retval  0, successful; 1, NACK
+ */
+uint8_t iic_bus_read(iic_bus_t *bus, uint8_t addr, uint16_t reg, uint8_t reg_len, uint8_t *buf, uint16_t len)
+{
+    iic_xfer_t xfer = {0};
+
+    xfer.addr = addr;
+    xfer.dir = IIC_XFER_RD;
+    xfer.reg = reg;
+    xfer.reg_len = reg_len;
+    xfer.buf = buf;
+    xfer.len = len;
+    return iic_bus_xfer(bus, &xfer);
+}
+
+/**
+ * @brief   Writes registers (blocking)
+ * @param   bus    : bus
+ * @param   addr   : slave address, 8-bit write form
+ * @param   reg    : register address
+ * @param   reg_len: register address length, 0~2 bytes
+ * @param   buf    : data to write
+ * @param   len    : number of bytes, 0 only checks that the slave answers
+ * @retval  0, successful; 1, NACK
+ */
+uint8_t iic_bus_write(iic_bus_t *bus, uint8_t addr, uint16_t reg, uint8_t reg_len, uint8_t *buf, uint16_t len)
+{
+    iic_xfer_t xfer = {0};
+
+    xfer.addr = addr;
+    xfer.dir = IIC_XFER_WR;
+    xfer.reg = reg;
+    xfer.reg_len = reg_len;
+    xfer.buf = buf;
+    xfer.len = len;
+    return iic_bus_xfer(bus, &xfer);
+}
+
+#endif /* IIC_BUS_ENABLE */
@@ -0,0 +1,110 @@
+/**
+ ****************************************************************************************************
+ * @file        iic_bus.h
+ * @author      ALIENTEK
+ * @brief       IIC transaction engine
+ * @license     Copyright (C) 2020-2032, ALIENTEK
+ ****************************************************************************************************
+ * @attention
+ *
+ * platform  	: ALIENTEK STM32F103 development board
+ * website		: https://www.alientek.com
+ * forum		: http://www.openedv.com/forum.php
+ *
+ * change logs	:
+ * version		data		notes
+ * V1.0			20261019	the first version
+ * V1.1			20261019	shared by the examples (IIC_BUS_ENABLE), one interrupt per byte, SCL read back at START/STOP
+ * V1.2			20261019	one interrupt per edge, IIC_BUS_IRQ_FREQ removed, SCL 50kHz
+ *
+ ****************************************************************************************************
+ */
+
+#ifndef __IIC_BUS_H
+#define __IIC_BUS_H
+
+#include "main.h"
+
+/*
+ * The engine and its timer are only used by the projects that define IIC_BUS_ENABLE = 1 (compiler symbols),
+ * the others keep the timer for themselves.
+ */
+#ifndef IIC_BUS_ENABLE
+#define IIC_BUS_ENABLE                  0
+#endif
+
+/******************************************************************************************/
+/* Timer used to clock the buses, one interrupt per edge (half an SCL period) */
+#define IIC_BUS_TIMX                    TIM7
+#define IIC_BUS_TIMX_IRQn               TIM7_IRQn
+#define IIC_BUS_TIMX_IRQHandler         TIM7_IRQHandler
+#define IIC_BUS_TIMX_CLK_ENABLE()       do{ __HAL_RCC_TIM7_CLK_ENABLE(); }while(0)
+
+#define IIC_BUS_SCL_FREQ                50000       /* SCL: 100000 short interrupts/s while a transfer is queued, 5000 bytes/s */
+#define IIC_BUS_IRQ_PRIORITY            3           /* Blocking transfers can not be started from a higher priority interrupt */
+#define IIC_BUS_MAX                     2           /* Maximum number of buses */
+#define IIC_BUS_STRETCH_MAX             (2 * IIC_BUS_SCL_FREQ / 100)    /* Interrupts a slave may hold SCL low (clock stretching), 10ms */
+
+/******************************************************************************************/
+
+/* Transfer direction */
+#define IIC_XFER_WR                     0
+#define IIC_XFER_RD                     1
+
+/* Transfer status */
+#define IIC_XFER_OK                     0
+#define IIC_XFER_NACK                   1           /* The slave did not acknowledge, SCL stayed low, or invalid transfer */
+#define IIC_XFER_PENDING                2           /* Queued or in progress */
+
+typedef struct iic_xfer iic_xfer_t;
+
+/* A transfer: START, addr, reg (reg_len bytes, high byte first), then
+ * write: buf (len bytes, may be 0 to only probe the slave), STOP
+ * read : repeated START (if reg_len is not 0), addr + 1, buf (len bytes), STOP
+ * The structure belongs to the caller and must stay valid until sta is no longer IIC_XFER_PENDING */
+struct iic_xfer
+{
+    uint8_t addr;                               /* Slave address, 8-bit write form (e.g. 0XA0) */
+    uint8_t dir;                                /* IIC_XFER_WR or IIC_XFER_RD */
+    uint8_t reg_len;                            /* Register address length, 0~2 bytes */
+    uint16_t reg;                               /* Register address */
+    uint8_t *buf;                               /* Data */
+    uint16_t len;                               /* Data length */
+    void (*cb)(iic_xfer_t *xfer);               /* Completion callback, called in the timer interrupt, can be NULL */
+    void *arg;                                  /* Free for the callback */
+    volatile uint8_t sta;                       /* IIC_XFER_OK, IIC_XFER_NACK or IIC_XFER_PENDING */
+    iic_xfer_t *next;                           /* Queue link, used by the engine */
+};
+
+/* A bus: the pins are set by the user, the rest is managed by the engine */
+typedef struct
+{
+    GPIO_TypeDef *scl_port;
+    uint16_t scl_pin;
+    GPIO_TypeDef *sda_port;
+    uint16_t sda_pin;
+
+    iic_xfer_t *volatile head;                  /* Transfer in progress, followed by the queued ones */
+    iic_xfer_t *tail;
+    volatile uint8_t sta;                       /* Bit state */
+    uint8_t phase;                              /* Part of the transfer being sent */
+    uint8_t clk;                                /* SCL cycle in the byte, 0~8 (8 is the ACK) */
+    uint8_t data;                               /* Byte being sent or received */
+    uint8_t rx;                                 /* 1, the byte is received */
+    uint16_t idx;                               /* Byte index in the phase */
+    uint16_t stretch;                           /* Interrupts SCL has been held low by the slave */
+    uint8_t nack;                               /* 1, the transfer in progress failed, it ends at the STOP */
+
+    uint32_t xfers;                             /* Number of completed transfers */
+    uint32_t bytes;                             /* Number of bytes acknowledged, including address bytes */
+    uint32_t nacks;                             /* Number of transfers ended by a NACK or a stuck SCL */
+    uint32_t stretches;                         /* Number of bytes, STARTs and STOPs delayed by clock stretching */
+} iic_bus_t;
+
+uint8_t iic_bus_add(iic_bus_t *bus);                                    /* Registers a bus */
+uint8_t iic_bus_submit(iic_bus_t *bus, iic_xfer_t *xfer);               /* Queues a transfer, returns at once */
+uint8_t iic_bus_xfer(iic_bus_t *bus, iic_xfer_t *xfer);                 /* Queues a transfer and sleeps until it is done */
+uint8_t iic_bus_read(iic_bus_t *bus, uint8_t addr, uint16_t reg, uint8_t reg_len, uint8_t *buf, uint16_t len);    /* Blocking register read */
+uint8_t iic_bus_write(iic_bus_t *bus, uint8_t addr, uint16_t reg, uint8_t reg_len, uint8_t *buf, uint16_t len);   /* Blocking register write */
+
+#endif